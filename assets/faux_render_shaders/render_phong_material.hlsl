@@ -7,8 +7,6 @@
 #define DEFINE_AS_PUSH_CONSTANT
 #endif 
 
-#define MAX_INSTANCES         100
-#define MAX_MATERIALS         100
 #define MAX_MATERIAL_SAMPLERS 32
 #define MAX_MATERIAL_IMAGES   1024
 #define MAX_IBL_TEXTURES      1
@@ -88,9 +86,10 @@ struct VSOutput {
     float4 Tangent    : TANGENT;
 };
 
-VSOutput vsmain(float3 PositionOS : POSITION, float2 TexCoord : TEXCOORD, float3 Normal : NORMAL, float4 Tangent : TANGENT)
+VSOutput vsmain(float3 PositionOS : POSITION, float2 TexCoord : TEXCOORD, float3 Normal : NORMAL, float4 Tangent : TANGENT, uint InstanceId : SV_InstanceID)
 {
-    InstanceData instance = Instances[Draw.InstanceIndex];
+    // Draw lists issue instanced draws starting at Draw.InstanceIndex
+    InstanceData instance = Instances[Draw.InstanceIndex + InstanceId];
     
     VSOutput output = (VSOutput)0;
     output.PositionWS = mul(instance.ModelMatrix, float4(PositionOS, 1));
@@ -4,8 +4,6 @@ using namespace metal;
 #define PI 3.1415292
 #define EPSILON 0.00001
 
-#define MAX_INSTANCES         100
-#define MAX_MATERIALS         100
 #define MAX_MATERIAL_SAMPLERS 32
 #define MAX_MATERIAL_IMAGES   1024
 #define MAX_IBL_TEXTURES      1
@@ -96,9 +94,11 @@ VSOutput vertex vsmain(
 	         VertexData    vertexData [[stage_in]],
 	constant DrawData&     Draw       [[buffer(DRAW_REGISTER)]],
 	constant CameraData&   Camera     [[buffer(CAMERA_REGISTER)]],
-	constant InstanceData* Instances  [[buffer(INSTANCE_BUFFER_REGISTER)]])
+	constant InstanceData* Instances  [[buffer(INSTANCE_BUFFER_REGISTER)]],
+	         uint          InstanceId [[instance_id]])
 {
-    InstanceData instance = Instances[Draw.InstanceIndex];
+    // Draw lists issue instanced draws starting at Draw.InstanceIndex
+    InstanceData instance = Instances[Draw.InstanceIndex + InstanceId];
 
     VSOutput output;
     output.PositionWS = (instance.ModelMatrix * float4(vertexData.PositionOS, 1));
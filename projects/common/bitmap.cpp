@@ -215,6 +215,8 @@ bool BitmapRGB32f::Save(const std::filesystem::path& absPath, const BitmapRGB32f
 // =================================================================================================
 bool BitmapRGBA8u::Load(const std::filesystem::path& absPath, BitmapRGBA8u* pBitmap)
 {
+    GREX_PROFILE_SCOPE("BitmapRGBA8u::Load");
+
     if (!std::filesystem::exists(absPath)) {
         return false;
     }
@@ -248,6 +250,8 @@ bool BitmapRGBA8u::Load(const std::filesystem::path& absPath, BitmapRGBA8u* pBit
 
 bool BitmapRGBA8u::Load(const size_t srcDataSize, const void* pSrcData, BitmapRGBA8u* pBitmap)
 {
+    GREX_PROFILE_SCOPE("BitmapRGBA8u::Load");
+
     if ((srcDataSize == 0) || (pSrcData == nullptr)) {
         return false;
     }
@@ -281,6 +285,8 @@ bool BitmapRGBA8u::Load(const size_t srcDataSize, const void* pSrcData, BitmapRG
 
 bool BitmapRGBA8u::Save(const std::filesystem::path& absPath, const BitmapRGBA8u* pBitmap)
 {
+    GREX_PROFILE_SCOPE("BitmapRGBA8u::Save");
+
     bool        success = false;
     std::string ext    = ToLowerCaseCopy(absPath.extension().string());
     if (ext == ".jpg") {
@@ -311,6 +317,8 @@ bool BitmapRGBA8u::Save(const std::filesystem::path& absPath, const BitmapRGBA8u
 // =================================================================================================
 bool BitmapRGBA32f::Load(const std::filesystem::path& absPath, BitmapRGBA32f* pBitmap)
 {
+    GREX_PROFILE_SCOPE("BitmapRGBA32f::Load");
+
     if (!std::filesystem::exists(absPath)) {
         return false;
     }
@@ -386,6 +394,8 @@ bool BitmapRGBA32f::Load(const std::filesystem::path& absPath, BitmapRGBA32f* pB
 
 bool BitmapRGBA32f::Save(const std::filesystem::path& absPath, const BitmapRGBA32f* pBitmap)
 {
+    GREX_PROFILE_SCOPE("BitmapRGBA32f::Save");
+
     if (pBitmap == nullptr) {
         return false;
     }
@@ -475,6 +485,13 @@ bool LoadIBLMaps32f(const std::filesystem::path& subPath, IBLMaps* pMaps)
     is >> pMaps->baseHeight;
     is >> pMaps->numLevels;
 
+    // Optional, only newer bakes write an importance sampling table
+    std::filesystem::path samplingTableFilename;
+    pMaps->samplingTablePath.clear();
+    if (is >> samplingTableFilename) {
+        pMaps->samplingTablePath = absPath.parent_path() / samplingTableFilename;
+    }
+
     // Load irradiance map
     {
         std::filesystem::path absIrrMapPath = absPath.parent_path() / irrMapFilename;
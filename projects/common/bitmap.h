@@ -1,6 +1,7 @@
 #pragma once
 
 #include "config.h"
+#include "profiler.h"
 
 enum BitmapSampleMode
 {
@@ -753,11 +754,12 @@ BitmapRGBA32f LoadImage32f(const std::filesystem::path& subPath);
 // =================================================================================================
 struct IBLMaps
 {
-    BitmapRGBA32f irradianceMap;
-    BitmapRGBA32f environmentMap;
-    uint32_t      baseWidth;
-    uint32_t      baseHeight;
-    uint32_t      numLevels;
+    BitmapRGBA32f         irradianceMap;
+    BitmapRGBA32f         environmentMap;
+    uint32_t              baseWidth;
+    uint32_t              baseHeight;
+    uint32_t              numLevels;
+    std::filesystem::path samplingTablePath; // Empty if the IBL was baked without one, see env_sampling.h
 };
 
 bool LoadIBLMaps32f(const std::filesystem::path& subPath, IBLMaps* pMaps);
@@ -860,6 +862,8 @@ public:
         BitmapSampleMode  modeV      = BITMAP_SAMPLE_MODE_CLAMP,
         BitmapFilterMode  filterMode = BITMAP_FILTER_MODE_NEAREST)
     {
+        GREX_PROFILE_SCOPE("MipmapT::BuildMipmap");
+
         if (mip0.Empty()) {
             return;
         }
@@ -897,6 +901,8 @@ public:
 
         // Build mips
         for (uint32_t level = 1; level < areaInfo.numLevels; ++level) {
+            GREX_PROFILE_SCOPE("MipmapT level");
+
             uint32_t prevLevel = level - 1;
             mMips[prevLevel].ScaleTo(
                 modeU,
@@ -0,0 +1,1105 @@
+#include "bvh.h"
+#include "job_system.h"
+
+#include <chrono>
+#include <cmath>
+#include <deque>
+#include <list>
+#include <mutex>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define BVH_SSE2
+#include <emmintrin.h>
+#endif
+
+// =============================================================================
+// Build helpers
+// =============================================================================
+namespace
+{
+
+const uint32_t kMaxLeafSize      = 4;
+const uint32_t kMaxBins          = 64;
+const uint32_t kMaxStackSize     = 256;
+const uint32_t kMinParallelPrims = 4096; // Smaller subtrees aren't worth a job
+const uint32_t kPacketSize       = 8;
+
+struct Aabb
+{
+    glm::vec3 Min = glm::vec3(FLT_MAX);
+    glm::vec3 Max = glm::vec3(-FLT_MAX);
+
+    void Grow(const glm::vec3& p)
+    {
+        this->Min = glm::min(this->Min, p);
+        this->Max = glm::max(this->Max, p);
+    }
+
+    void Grow(const Aabb& box)
+    {
+        this->Min = glm::min(this->Min, box.Min);
+        this->Max = glm::max(this->Max, box.Max);
+    }
+
+    // Half the surface area, the SAH only needs ratios
+    float HalfArea() const
+    {
+        glm::vec3 e = this->Max - this->Min;
+        return ((e.x < 0) || (e.y < 0) || (e.z < 0)) ? 0.0f : (e.x * e.y + e.y * e.z + e.z * e.x);
+    }
+};
+
+struct BuildPrim
+{
+    Aabb      Bounds;
+    glm::vec3 Centroid;
+    uint32_t  Index;
+};
+
+// Leaves are intersected 4 triangles at a time, so the SAH counts in blocks of 4
+float NumBlocks(uint32_t count)
+{
+    return static_cast<float>((count + kMaxLeafSize - 1) / kMaxLeafSize);
+}
+
+struct Bin
+{
+    Aabb     Bounds;
+    uint32_t Count = 0;
+};
+
+// Ericson, Real-Time Collision Detection, 5.1.5. Returns the closest point's barycentrics in (u, v).
+glm::vec3 ClosestPointOnTriangle(const glm::vec3& p, const glm::vec3& a, const glm::vec3& b, const glm::vec3& c, float* pU, float* pV)
+{
+    glm::vec3 ab = b - a;
+    glm::vec3 ac = c - a;
+    glm::vec3 ap = p - a;
+
+    float d1 = glm::dot(ab, ap);
+    float d2 = glm::dot(ac, ap);
+    if ((d1 <= 0) && (d2 <= 0))
+    {
+        *pU = 0;
+        *pV = 0;
+        return a;
+    }
+
+    glm::vec3 bp = p - b;
+    float     d3 = glm::dot(ab, bp);
+    float     d4 = glm::dot(ac, bp);
+    if ((d3 >= 0) && (d4 <= d3))
+    {
+        *pU = 1;
+        *pV = 0;
+        return b;
+    }
+
+    float vc = d1 * d4 - d3 * d2;
+    if ((vc <= 0) && (d1 >= 0) && (d3 <= 0))
+    {
+        float v = d1 / (d1 - d3);
+        *pU     = v;
+        *pV     = 0;
+        return a + v * ab;
+    }
+
+    glm::vec3 cp = p - c;
+    float     d5 = glm::dot(ab, cp);
+    float     d6 = glm::dot(ac, cp);
+    if ((d6 >= 0) && (d5 <= d6))
+    {
+        *pU = 0;
+        *pV = 1;
+        return c;
+    }
+
+    float vb = d5 * d2 - d1 * d6;
+    if ((vb <= 0) && (d2 >= 0) && (d6 <= 0))
+    {
+        float w = d2 / (d2 - d6);
+        *pU     = 0;
+        *pV     = w;
+        return a + w * ac;
+    }
+
+    float va = d3 * d6 - d5 * d4;
+    if ((va <= 0) && ((d4 - d3) >= 0) && ((d5 - d6) >= 0))
+    {
+        float w = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+        *pU     = 1 - w;
+        *pV     = w;
+        return b + w * (c - b);
+    }
+
+    float denom = 1.0f / (va + vb + vc);
+    float v     = vb * denom;
+    float w     = vc * denom;
+    *pU         = v;
+    *pV         = w;
+    return a + ab * v + ac * w;
+}
+
+} // namespace
+
+// =============================================================================
+// Bvh
+// =============================================================================
+struct Bvh::BuildNode
+{
+    Aabb       Bounds;
+    BuildNode* pChildren[2] = {nullptr, nullptr};
+    uint32_t   First        = 0; // Leaves only, range in BuildContext::Prims
+    uint32_t   Count        = 0;
+};
+
+struct Bvh::BuildContext
+{
+    const BuildOptions*    pOptions      = nullptr;
+    const glm::vec3*       pPositions    = nullptr;
+    const uint32_t*        pIndices      = nullptr;
+    std::vector<BuildPrim> Prims         = {};
+    uint32_t               ParallelDepth = 0;
+
+    // One node arena per build job, deques don't move their elements
+    std::mutex                       ArenaMutex;
+    std::list<std::deque<BuildNode>> Arenas;
+
+    std::deque<BuildNode>* NewArena()
+    {
+        std::lock_guard<std::mutex> lock(this->ArenaMutex);
+        this->Arenas.emplace_back();
+        return &this->Arenas.back();
+    }
+};
+
+//
+// Ray with everything the box and triangle tests need precomputed. Zero
+// direction components are nudged so the slab test never sees 0 * inf.
+//
+struct Bvh::PreparedRay
+{
+    glm::vec3 Origin;
+    glm::vec3 Direction;
+    glm::vec3 InvDir;
+    float     TMin;
+    uint32_t  Near[3]; // 0 when the near slab is BoundsMin, 1 when it's BoundsMax
+
+    PreparedRay() {}
+
+    explicit PreparedRay(const Ray& ray)
+    {
+        this->Origin    = ray.Origin;
+        this->Direction = ray.Direction;
+        this->TMin      = ray.TMin;
+        for (uint32_t axis = 0; axis < 3; ++axis)
+        {
+            float d = ray.Direction[axis];
+            if (fabsf(d) < 1e-20f)
+            {
+                d = (d < 0) ? -1e-20f : 1e-20f;
+            }
+            this->InvDir[axis] = 1.0f / d;
+            this->Near[axis]   = (d < 0) ? 1 : 0;
+        }
+    }
+};
+
+namespace
+{
+
+//
+// Binned SAH split of prims [first, first + count). Subtrees of the top
+// ParallelDepth levels are built as a job system job while the calling
+// thread continues with the left child.
+//
+template <typename BuildNodeT, typename BuildContextT>
+BuildNodeT* BuildSubtree(BuildContextT& ctx, std::deque<BuildNodeT>* pArena, uint32_t first, uint32_t count, uint32_t depth)
+{
+    const auto& options = *ctx.pOptions;
+    auto&       prims   = ctx.Prims;
+
+    pArena->emplace_back();
+    BuildNodeT* pNode = &pArena->back();
+
+    Aabb centroidBounds;
+    for (uint32_t i = first; i < (first + count); ++i)
+    {
+        pNode->Bounds.Grow(prims[i].Bounds);
+        centroidBounds.Grow(prims[i].Centroid);
+    }
+
+    const float leafCost = options.IntersectionCost * NumBlocks(count);
+    if (count == 1)
+    {
+        pNode->First = first;
+        pNode->Count = count;
+        return pNode;
+    }
+
+    // Best split over all axes
+    const uint32_t numBins   = std::min(std::max(options.NumBins, 2u), kMaxBins);
+    const float    nodeArea  = pNode->Bounds.HalfArea();
+    float          bestCost  = FLT_MAX;
+    int            bestAxis  = -1;
+    uint32_t       bestSplit = 0;
+
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        const float cmin   = centroidBounds.Min[axis];
+        const float extent = centroidBounds.Max[axis] - cmin;
+        if (extent <= 0)
+        {
+            continue;
+        }
+        const float scale = numBins / extent;
+
+        Bin bins[kMaxBins] = {};
+        for (uint32_t i = first; i < (first + count); ++i)
+        {
+            uint32_t b = std::min(static_cast<uint32_t>((prims[i].Centroid[axis] - cmin) * scale), numBins - 1);
+            bins[b].Bounds.Grow(prims[i].Bounds);
+            ++bins[b].Count;
+        }
+
+        // Sweep from the right to get the right side areas, then from the left to evaluate
+        float    rightAreas[kMaxBins]  = {};
+        uint32_t rightCounts[kMaxBins] = {};
+        Aabb     accum;
+        uint32_t accumCount = 0;
+        for (uint32_t b = numBins - 1; b > 0; --b)
+        {
+            accum.Grow(bins[b].Bounds);
+            accumCount += bins[b].Count;
+            rightAreas[b]  = accum.HalfArea();
+            rightCounts[b] = accumCount;
+        }
+
+        accum      = Aabb();
+        accumCount = 0;
+        for (uint32_t b = 0; b < (numBins - 1); ++b)
+        {
+            accum.Grow(bins[b].Bounds);
+            accumCount += bins[b].Count;
+            if ((accumCount == 0) || (rightCounts[b + 1] == 0))
+            {
+                continue;
+            }
+
+            float cost = options.TraversalCost + options.IntersectionCost * (accum.HalfArea() * NumBlocks(accumCount) + rightAreas[b + 1] * NumBlocks(rightCounts[b + 1])) / std::max(nodeArea, FLT_MIN);
+            if (cost < bestCost)
+            {
+                bestCost  = cost;
+                bestAxis  = axis;
+                bestSplit = b + 1;
+            }
+        }
+    }
+
+    if ((count <= kMaxLeafSize) && (leafCost <= bestCost))
+    {
+        pNode->First = first;
+        pNode->Count = count;
+        return pNode;
+    }
+
+    uint32_t mid = first + count / 2;
+    if (bestAxis >= 0)
+    {
+        const float cmin  = centroidBounds.Min[bestAxis];
+        const float scale = numBins / (centroidBounds.Max[bestAxis] - cmin);
+
+        auto it = std::partition(
+            prims.begin() + first,
+            prims.begin() + first + count,
+            [=](const BuildPrim& prim) {
+                uint32_t b = std::min(static_cast<uint32_t>((prim.Centroid[bestAxis] - cmin) * scale), numBins - 1);
+                return b < bestSplit;
+            });
+        mid = static_cast<uint32_t>(it - prims.begin());
+    }
+    // Every centroid is in the same spot (or there's no better option), split the list in half
+
+    uint32_t leftCount  = mid - first;
+    uint32_t rightCount = count - leftCount;
+
+    if ((depth < ctx.ParallelDepth) && (count >= kMinParallelPrims))
+    {
+        std::deque<BuildNodeT>* pRightArena = ctx.NewArena();
+
+        // Waiting runs other queued jobs, so nested splits don't tie up threads
+        JobSystem&           jobSystem = JobSystem::Get();
+        JobSystem::JobHandle rightJob  = jobSystem.Run([&ctx, pNode, pRightArena, mid, rightCount, depth]() {
+            pNode->pChildren[1] = BuildSubtree(ctx, pRightArena, mid, rightCount, depth + 1);
+        });
+        pNode->pChildren[0] = BuildSubtree(ctx, pArena, first, leftCount, depth + 1);
+        jobSystem.Wait(rightJob);
+    }
+    else
+    {
+        pNode->pChildren[0] = BuildSubtree(ctx, pArena, first, leftCount, depth + 1);
+        pNode->pChildren[1] = BuildSubtree(ctx, pArena, mid, rightCount, depth + 1);
+    }
+
+    return pNode;
+}
+
+} // namespace
+
+Bvh::Bvh()
+{
+}
+
+Bvh::~Bvh()
+{
+}
+
+bool Bvh::Build(const TriMesh& mesh, const BuildOptions& options, Bvh* pBvh)
+{
+    const auto& positions = mesh.GetPositions();
+    const auto& triangles = mesh.GetTriangles();
+
+    return Build(
+        CountU32(positions),
+        DataPtr(positions),
+        CountU32(triangles),
+        reinterpret_cast<const uint32_t*>(DataPtr(triangles)),
+        options,
+        pBvh);
+}
+
+bool Bvh::Build(
+    uint32_t            numVertices,
+    const glm::vec3*    pPositions,
+    uint32_t            numTriangles,
+    const uint32_t*     pIndices,
+    const BuildOptions& options,
+    Bvh*                pBvh)
+{
+    if (IsNull(pBvh))
+    {
+        return false;
+    }
+    if ((numTriangles > 0) && (IsNull(pPositions) || IsNull(pIndices)))
+    {
+        return false;
+    }
+
+    auto startTime = std::chrono::high_resolution_clock::now();
+
+    pBvh->mNodes.clear();
+    pBvh->mPackets.clear();
+    pBvh->mStats = {};
+
+    BuildContext ctx = {};
+    ctx.pOptions     = &options;
+    ctx.pPositions   = pPositions;
+    ctx.pIndices     = pIndices;
+    ctx.Prims.reserve(numTriangles);
+
+    // Degenerate triangles can still be hit by a ray exactly along them,
+    // only triangles with out of range or non-finite vertices are dropped
+    for (uint32_t i = 0; i < numTriangles; ++i)
+    {
+        const uint32_t* pTri = pIndices + 3 * i;
+        if ((pTri[0] >= numVertices) || (pTri[1] >= numVertices) || (pTri[2] >= numVertices))
+        {
+            assert(false && "triangle vertex index out of range");
+            return false;
+        }
+
+        BuildPrim prim = {};
+        prim.Bounds.Grow(pPositions[pTri[0]]);
+        prim.Bounds.Grow(pPositions[pTri[1]]);
+        prim.Bounds.Grow(pPositions[pTri[2]]);
+        prim.Centroid = 0.5f * (prim.Bounds.Min + prim.Bounds.Max);
+        prim.Index    = i;
+
+        glm::vec3 extent = prim.Bounds.Max - prim.Bounds.Min;
+        if (!std::isfinite(extent.x + extent.y + extent.z))
+        {
+            continue;
+        }
+
+        ctx.Prims.push_back(prim);
+    }
+
+    if (ctx.Prims.empty())
+    {
+        return true;
+    }
+
+    uint32_t numThreads = options.NumThreads;
+    if (numThreads == 0)
+    {
+        numThreads = JobSystem::Get().GetNumThreads();
+    }
+    while ((1u << ctx.ParallelDepth) < numThreads)
+    {
+        ++ctx.ParallelDepth;
+    }
+
+    std::deque<BuildNode>* pArena = ctx.NewArena();
+    BuildNode*             pRoot  = BuildSubtree(ctx, pArena, 0, CountU32(ctx.Prims), 0);
+
+    // Collapse into 4-wide nodes, the packets are filled as leaves are reached
+    pBvh->mNodes.reserve(ctx.Prims.size() / 2 + 1);
+    pBvh->mPackets.reserve(ctx.Prims.size() / 2 + 1);
+    if (pRoot->Count > 0)
+    {
+        // Single leaf, it still needs a node to sit in
+        BuildNode wrapper    = {};
+        wrapper.Bounds       = pRoot->Bounds;
+        wrapper.pChildren[0] = pRoot;
+        pBvh->CollapseNode(&wrapper, ctx, 1);
+    }
+    else
+    {
+        pBvh->CollapseNode(pRoot, ctx, 1);
+    }
+
+    // SAH cost of the final tree, relative to the root's area
+    const float rootArea = std::max(pRoot->Bounds.HalfArea(), FLT_MIN);
+    float       sahCost  = 0;
+    for (const auto& node : pBvh->mNodes)
+    {
+        Aabb nodeBounds;
+        for (uint32_t slot = 0; slot < 4; ++slot)
+        {
+            if ((node.Count[slot] == 0) && (node.Child[slot] == kInvalidChild))
+            {
+                continue;
+            }
+
+            Aabb childBounds;
+            childBounds.Min = glm::vec3(node.BoundsMin[0][slot], node.BoundsMin[1][slot], node.BoundsMin[2][slot]);
+            childBounds.Max = glm::vec3(node.BoundsMax[0][slot], node.BoundsMax[1][slot], node.BoundsMax[2][slot]);
+            nodeBounds.Grow(childBounds);
+
+            if (node.Count[slot] > 0)
+            {
+                sahCost += options.IntersectionCost * childBounds.HalfArea() / rootArea;
+            }
+        }
+        sahCost += options.TraversalCost * nodeBounds.HalfArea() / rootArea;
+    }
+
+    auto endTime = std::chrono::high_resolution_clock::now();
+
+    pBvh->mStats.NumTriangles = CountU32(ctx.Prims);
+    pBvh->mStats.NumNodes     = CountU32(pBvh->mNodes);
+    pBvh->mStats.NumLeaves    = CountU32(pBvh->mPackets);
+    pBvh->mStats.SahCost      = sahCost;
+    pBvh->mStats.BuildTimeMs  = std::chrono::duration<double, std::milli>(endTime - startTime).count();
+
+    if ((3 * pBvh->mStats.MaxDepth) >= kMaxStackSize)
+    {
+        GREX_LOG_ERROR("BVH is " << pBvh->mStats.MaxDepth << " levels deep, too deep for the traversal stack");
+        assert(false && "BVH too deep");
+        pBvh->mNodes.clear();
+        pBvh->mPackets.clear();
+        return false;
+    }
+
+    return true;
+}
+
+uint32_t Bvh::CollapseNode(const BuildNode* pBuildNode, const BuildContext& ctx, uint32_t depth)
+{
+    mStats.MaxDepth = std::max(mStats.MaxDepth, depth);
+
+    // Open the largest interior child until there are 4 children or only leaves left
+    const BuildNode* children[4] = {pBuildNode->pChildren[0], pBuildNode->pChildren[1], nullptr, nullptr};
+    uint32_t         numChildren = IsNull(children[1]) ? 1 : 2;
+    while (numChildren < 4)
+    {
+        int   largest     = -1;
+        float largestArea = -1.0f;
+        for (uint32_t i = 0; i < numChildren; ++i)
+        {
+            if ((children[i]->Count == 0) && (children[i]->Bounds.HalfArea() > largestArea))
+            {
+                largest     = static_cast<int>(i);
+                largestArea = children[i]->Bounds.HalfArea();
+            }
+        }
+        if (largest < 0)
+        {
+            break;
+        }
+
+        const BuildNode* pOpened = children[largest];
+        children[largest]        = pOpened->pChildren[0];
+        children[numChildren++]  = pOpened->pChildren[1];
+    }
+
+    uint32_t nodeIndex = CountU32(mNodes);
+    mNodes.emplace_back();
+
+    for (uint32_t slot = 0; slot < 4; ++slot)
+    {
+        // Empty slot, inverted bounds make the box test fail for every ray
+        float    boundsMin[3] = {FLT_MAX, FLT_MAX, FLT_MAX};
+        float    boundsMax[3] = {-FLT_MAX, -FLT_MAX, -FLT_MAX};
+        uint32_t child        = kInvalidChild;
+        uint32_t count        = 0;
+
+        if (slot < numChildren)
+        {
+            const BuildNode* pChild = children[slot];
+            for (uint32_t axis = 0; axis < 3; ++axis)
+            {
+                boundsMin[axis] = pChild->Bounds.Min[axis];
+                boundsMax[axis] = pChild->Bounds.Max[axis];
+            }
+
+            if (pChild->Count > 0)
+            {
+                TrianglePacket packet = {};
+                for (uint32_t lane = 0; lane < 4; ++lane)
+                {
+                    const BuildPrim& prim = ctx.Prims[pChild->First + ((lane < pChild->Count) ? lane : 0)];
+                    const uint32_t*  pTri = ctx.pIndices + 3 * prim.Index;
+
+                    glm::vec3 P0 = ctx.pPositions[pTri[0]];
+                    glm::vec3 E1 = ctx.pPositions[pTri[1]] - P0;
+                    glm::vec3 E2 = ctx.pPositions[pTri[2]] - P0;
+                    for (uint32_t axis = 0; axis < 3; ++axis)
+                    {
+                        packet.P0[axis][lane]    = P0[axis];
+                        packet.Edge1[axis][lane] = E1[axis];
+                        packet.Edge2[axis][lane] = E2[axis];
+                    }
+                    packet.TriangleIndex[lane] = prim.Index;
+                }
+                child = CountU32(mPackets);
+                count = pChild->Count;
+                mPackets.push_back(packet);
+            }
+            else
+            {
+                child = CollapseNode(pChild, ctx, depth + 1);
+            }
+        }
+
+        // mNodes may have grown, index instead of holding a reference
+        Node& node = mNodes[nodeIndex];
+        for (uint32_t axis = 0; axis < 3; ++axis)
+        {
+            node.BoundsMin[axis][slot] = boundsMin[axis];
+            node.BoundsMax[axis][slot] = boundsMax[axis];
+        }
+        node.Child[slot] = child;
+        node.Count[slot] = count;
+    }
+
+    return nodeIndex;
+}
+
+namespace
+{
+
+//
+// Slab test against all 4 children of a node. Picking the near and far
+// slabs by direction sign, instead of min/max-ing them, keeps the inverted
+// bounds of empty slots a miss. Returns a 4 bit mask of the children the
+// ray enters before tMax, writes every child's entry distance to pEntries.
+//
+template <typename NodeT, typename RayT>
+int IntersectChildren(const NodeT& node, const RayT& ray, float tMax, float* pEntries)
+{
+    const float* pNear[3] = {};
+    const float* pFar[3]  = {};
+    for (uint32_t axis = 0; axis < 3; ++axis)
+    {
+        pNear[axis] = ray.Near[axis] ? node.BoundsMax[axis] : node.BoundsMin[axis];
+        pFar[axis]  = ray.Near[axis] ? node.BoundsMin[axis] : node.BoundsMax[axis];
+    }
+
+#if defined(BVH_SSE2)
+    __m128 entry = _mm_set1_ps(ray.TMin);
+    __m128 exit  = _mm_set1_ps(tMax);
+    for (uint32_t axis = 0; axis < 3; ++axis)
+    {
+        const __m128 o      = _mm_set1_ps(ray.Origin[axis]);
+        const __m128 invDir = _mm_set1_ps(ray.InvDir[axis]);
+
+        entry = _mm_max_ps(entry, _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(pNear[axis]), o), invDir));
+        exit  = _mm_min_ps(exit, _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(pFar[axis]), o), invDir));
+    }
+    _mm_storeu_ps(pEntries, entry);
+
+    return _mm_movemask_ps(_mm_cmple_ps(entry, exit));
+#else
+    int mask = 0;
+    for (uint32_t slot = 0; slot < 4; ++slot)
+    {
+        float entry = ray.TMin;
+        float exit  = tMax;
+        for (uint32_t axis = 0; axis < 3; ++axis)
+        {
+            entry = std::max(entry, (pNear[axis][slot] - ray.Origin[axis]) * ray.InvDir[axis]);
+            exit  = std::min(exit, (pFar[axis][slot] - ray.Origin[axis]) * ray.InvDir[axis]);
+        }
+        pEntries[slot] = entry;
+        mask |= (entry <= exit) ? (1 << slot) : 0;
+    }
+    return mask;
+#endif
+}
+
+// Squared distance from point to each child's box, empty slots come out infinite
+template <typename NodeT>
+void DistanceSqToChildren(const NodeT& node, const glm::vec3& point, float* pDistSq)
+{
+#if defined(BVH_SSE2)
+    __m128 distSq = _mm_setzero_ps();
+    for (uint32_t axis = 0; axis < 3; ++axis)
+    {
+        const __m128 p = _mm_set1_ps(point[axis]);
+
+        __m128 d = _mm_max_ps(_mm_sub_ps(_mm_loadu_ps(node.BoundsMin[axis]), p), _mm_sub_ps(p, _mm_loadu_ps(node.BoundsMax[axis])));
+        d        = _mm_max_ps(d, _mm_setzero_ps());
+        distSq   = _mm_add_ps(distSq, _mm_mul_ps(d, d));
+    }
+    _mm_storeu_ps(pDistSq, distSq);
+#else
+    for (uint32_t slot = 0; slot < 4; ++slot)
+    {
+        float distSq = 0;
+        for (uint32_t axis = 0; axis < 3; ++axis)
+        {
+            float d = std::max(node.BoundsMin[axis][slot] - point[axis], point[axis] - node.BoundsMax[axis][slot]);
+            d       = std::max(d, 0.0f);
+            distSq += d * d;
+        }
+        pDistSq[slot] = distSq;
+    }
+#endif
+}
+
+// Indices of the set slots in mask, farthest first so the nearest ends up on top of the stack
+uint32_t SortSlotsFarToNear(int mask, const float* pKeys, uint32_t* pSlots)
+{
+    uint32_t count = 0;
+    for (uint32_t slot = 0; slot < 4; ++slot)
+    {
+        if ((mask & (1 << slot)) == 0)
+        {
+            continue;
+        }
+
+        uint32_t i = count++;
+        while ((i > 0) && (pKeys[pSlots[i - 1]] < pKeys[slot]))
+        {
+            pSlots[i] = pSlots[i - 1];
+            --i;
+        }
+        pSlots[i] = slot;
+    }
+    return count;
+}
+
+} // namespace
+
+// Moller-Trumbore against the 4 triangles of a leaf, hits must be in (TMin, *pTMax)
+bool Bvh::IntersectLeaf(uint32_t packetIndex, const PreparedRay& ray, float* pTMax, Hit* pHit) const
+{
+    const TrianglePacket& packet   = mPackets[packetIndex];
+    const glm::vec3&      origin   = ray.Origin;
+    const glm::vec3&      dir      = ray.Direction;
+    float                 tClosest = *pTMax;
+
+#if defined(BVH_SSE2)
+    const __m128 dx     = _mm_set1_ps(dir.x);
+    const __m128 dy     = _mm_set1_ps(dir.y);
+    const __m128 dz     = _mm_set1_ps(dir.z);
+    const __m128 zero   = _mm_setzero_ps();
+    const __m128 one    = _mm_set1_ps(1.0f);
+    const __m128 detEps = _mm_set1_ps(1e-12f);
+    const __m128 absMsk = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+
+    const __m128 e1x = _mm_loadu_ps(packet.Edge1[0]);
+    const __m128 e1y = _mm_loadu_ps(packet.Edge1[1]);
+    const __m128 e1z = _mm_loadu_ps(packet.Edge1[2]);
+    const __m128 e2x = _mm_loadu_ps(packet.Edge2[0]);
+    const __m128 e2y = _mm_loadu_ps(packet.Edge2[1]);
+    const __m128 e2z = _mm_loadu_ps(packet.Edge2[2]);
+
+    // pvec = cross(dir, e2)
+    __m128 px  = _mm_sub_ps(_mm_mul_ps(dy, e2z), _mm_mul_ps(dz, e2y));
+    __m128 py  = _mm_sub_ps(_mm_mul_ps(dz, e2x), _mm_mul_ps(dx, e2z));
+    __m128 pz  = _mm_sub_ps(_mm_mul_ps(dx, e2y), _mm_mul_ps(dy, e2x));
+    __m128 det = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e1x, px), _mm_mul_ps(e1y, py)), _mm_mul_ps(e1z, pz));
+    __m128 inv = _mm_div_ps(one, det);
+
+    __m128 tx = _mm_sub_ps(_mm_set1_ps(origin.x), _mm_loadu_ps(packet.P0[0]));
+    __m128 ty = _mm_sub_ps(_mm_set1_ps(origin.y), _mm_loadu_ps(packet.P0[1]));
+    __m128 tz = _mm_sub_ps(_mm_set1_ps(origin.z), _mm_loadu_ps(packet.P0[2]));
+    __m128 u  = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(tx, px), _mm_mul_ps(ty, py)), _mm_mul_ps(tz, pz)), inv);
+
+    // qvec = cross(tvec, e1)
+    __m128 qx = _mm_sub_ps(_mm_mul_ps(ty, e1z), _mm_mul_ps(tz, e1y));
+    __m128 qy = _mm_sub_ps(_mm_mul_ps(tz, e1x), _mm_mul_ps(tx, e1z));
+    __m128 qz = _mm_sub_ps(_mm_mul_ps(tx, e1y), _mm_mul_ps(ty, e1x));
+    __m128 v  = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, qx), _mm_mul_ps(dy, qy)), _mm_mul_ps(dz, qz)), inv);
+    __m128 t  = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(e2x, qx), _mm_mul_ps(e2y, qy)), _mm_mul_ps(e2z, qz)), inv);
+
+    __m128 mask = _mm_cmpgt_ps(_mm_and_ps(det, absMsk), detEps);
+    mask        = _mm_and_ps(mask, _mm_cmpge_ps(u, zero));
+    mask        = _mm_and_ps(mask, _mm_cmpge_ps(v, zero));
+    mask        = _mm_and_ps(mask, _mm_cmple_ps(_mm_add_ps(u, v), one));
+    mask        = _mm_and_ps(mask, _mm_cmpgt_ps(t, _mm_set1_ps(ray.TMin)));
+    mask        = _mm_and_ps(mask, _mm_cmplt_ps(t, _mm_set1_ps(tClosest)));
+
+    int laneMask = _mm_movemask_ps(mask);
+    if (laneMask == 0)
+    {
+        return false;
+    }
+
+    alignas(16) float tLanes[4];
+    alignas(16) float uLanes[4];
+    alignas(16) float vLanes[4];
+    _mm_store_ps(tLanes, t);
+    _mm_store_ps(uLanes, u);
+    _mm_store_ps(vLanes, v);
+
+    for (uint32_t lane = 0; lane < 4; ++lane)
+    {
+        if ((laneMask & (1 << lane)) && (tLanes[lane] < tClosest))
+        {
+            tClosest            = tLanes[lane];
+            pHit->T             = tLanes[lane];
+            pHit->U             = uLanes[lane];
+            pHit->V             = vLanes[lane];
+            pHit->TriangleIndex = packet.TriangleIndex[lane];
+        }
+    }
+#else
+    for (uint32_t lane = 0; lane < 4; ++lane)
+    {
+        glm::vec3 e1 = glm::vec3(packet.Edge1[0][lane], packet.Edge1[1][lane], packet.Edge1[2][lane]);
+        glm::vec3 e2 = glm::vec3(packet.Edge2[0][lane], packet.Edge2[1][lane], packet.Edge2[2][lane]);
+        glm::vec3 p0 = glm::vec3(packet.P0[0][lane], packet.P0[1][lane], packet.P0[2][lane]);
+
+        glm::vec3 pvec = glm::cross(dir, e2);
+        float     det  = glm::dot(e1, pvec);
+        if (fabsf(det) <= 1e-12f)
+        {
+            continue;
+        }
+        float inv = 1.0f / det;
+
+        glm::vec3 tvec = origin - p0;
+        float     u    = glm::dot(tvec, pvec) * inv;
+        glm::vec3 qvec = glm::cross(tvec, e1);
+        float     v    = glm::dot(dir, qvec) * inv;
+        float     t    = glm::dot(e2, qvec) * inv;
+        if ((u >= 0) && (v >= 0) && ((u + v) <= 1) && (t > ray.TMin) && (t < tClosest))
+        {
+            tClosest            = t;
+            pHit->T             = t;
+            pHit->U             = u;
+            pHit->V             = v;
+            pHit->TriangleIndex = packet.TriangleIndex[lane];
+        }
+    }
+#endif
+
+    if (tClosest < *pTMax)
+    {
+        *pTMax = tClosest;
+        return true;
+    }
+    return false;
+}
+
+bool Bvh::Intersect(const Ray& ray, Hit* pHit) const
+{
+    if (mNodes.empty() || IsNull(pHit))
+    {
+        return false;
+    }
+
+    const PreparedRay preparedRay(ray);
+
+    // Count > 0 entries are leaves
+    struct StackEntry
+    {
+        uint32_t Child;
+        uint32_t Count;
+        float    Entry;
+    };
+
+    StackEntry stack[kMaxStackSize];
+    uint32_t   stackSize = 0;
+    float      tMax      = ray.TMax;
+    bool       hit       = false;
+
+    stack[stackSize++] = {0, 0, ray.TMin};
+    while (stackSize > 0)
+    {
+        const StackEntry top = stack[--stackSize];
+        if (top.Entry > tMax)
+        {
+            continue;
+        }
+
+        if (top.Count > 0)
+        {
+            hit |= IntersectLeaf(top.Child, preparedRay, &tMax, pHit);
+            continue;
+        }
+
+        const Node& node = mNodes[top.Child];
+
+        float    entries[4];
+        uint32_t slots[4];
+        int      mask     = IntersectChildren(node, preparedRay, tMax, entries);
+        uint32_t numSlots = SortSlotsFarToNear(mask, entries, slots);
+        for (uint32_t i = 0; i < numSlots; ++i)
+        {
+            uint32_t slot      = slots[i];
+            stack[stackSize++] = {node.Child[slot], node.Count[slot], entries[slot]};
+        }
+    }
+
+    return hit;
+}
+
+bool Bvh::IntersectAny(const Ray& ray) const
+{
+    if (mNodes.empty())
+    {
+        return false;
+    }
+
+    const PreparedRay preparedRay(ray);
+
+    // Any hit ends the search, so there's no point in ordering children
+    struct StackEntry
+    {
+        uint32_t Child;
+        uint32_t Count;
+    };
+
+    StackEntry stack[kMaxStackSize];
+    uint32_t   stackSize = 0;
+    float      tMax      = ray.TMax;
+    Hit        hit       = {};
+
+    stack[stackSize++] = {0, 0};
+    while (stackSize > 0)
+    {
+        const StackEntry top = stack[--stackSize];
+        if (top.Count > 0)
+        {
+            if (IntersectLeaf(top.Child, preparedRay, &tMax, &hit))
+            {
+                return true;
+            }
+            continue;
+        }
+
+        const Node& node = mNodes[top.Child];
+
+        float entries[4];
+        int   mask = IntersectChildren(node, preparedRay, tMax, entries);
+        for (uint32_t slot = 0; slot < 4; ++slot)
+        {
+            if (mask & (1 << slot))
+            {
+                stack[stackSize++] = {node.Child[slot], node.Count[slot]};
+            }
+        }
+    }
+
+    return false;
+}
+
+void Bvh::IntersectPacket(uint32_t numRays, const Ray* pRays, Hit* pHits) const
+{
+    if (IsNull(pRays) || IsNull(pHits))
+    {
+        return;
+    }
+
+    for (uint32_t first = 0; first < numRays; first += kPacketSize)
+    {
+        IntersectPacket8(std::min(numRays - first, kPacketSize), pRays + first, pHits + first);
+    }
+}
+
+//
+// Traverses the tree once for up to 8 rays. Each stack entry carries the
+// mask of rays that entered it, a node is visited if any of them did and
+// is only tested against those. Children are ordered by the first active
+// ray's entry distance, coherent rays mostly agree on the order.
+//
+void Bvh::IntersectPacket8(uint32_t numRays, const Ray* pRays, Hit* pHits) const
+{
+    PreparedRay rays[kPacketSize];
+    float       tMax[kPacketSize];
+    for (uint32_t i = 0; i < numRays; ++i)
+    {
+        rays[i]  = PreparedRay(pRays[i]);
+        tMax[i]  = pRays[i].TMax;
+        pHits[i] = {};
+    }
+
+    if (mNodes.empty())
+    {
+        return;
+    }
+
+    struct StackEntry
+    {
+        uint32_t Child;
+        uint32_t Count;
+        uint32_t RayMask;
+    };
+
+    StackEntry stack[kMaxStackSize];
+    uint32_t   stackSize = 0;
+
+    stack[stackSize++] = {0, 0, (1u << numRays) - 1};
+    while (stackSize > 0)
+    {
+        const StackEntry top = stack[--stackSize];
+
+        if (top.Count > 0)
+        {
+            for (uint32_t i = 0; i < numRays; ++i)
+            {
+                if (top.RayMask & (1u << i))
+                {
+                    IntersectLeaf(top.Child, rays[i], &tMax[i], &pHits[i]);
+                }
+            }
+            continue;
+        }
+
+        const Node& node = mNodes[top.Child];
+
+        uint32_t childRayMasks[4] = {0, 0, 0, 0};
+        float    orderEntries[4]  = {0, 0, 0, 0};
+        bool     firstRay         = true;
+        for (uint32_t i = 0; i < numRays; ++i)
+        {
+            if ((top.RayMask & (1u << i)) == 0)
+            {
+                continue;
+            }
+
+            float entries[4];
+            int   mask = IntersectChildren(node, rays[i], tMax[i], entries);
+            for (uint32_t slot = 0; slot < 4; ++slot)
+            {
+                childRayMasks[slot] |= (mask & (1 << slot)) ? (1u << i) : 0;
+            }
+
+            if (firstRay)
+            {
+                std::copy(entries, entries + 4, orderEntries);
+                firstRay = false;
+            }
+        }
+
+        int mask = 0;
+        for (uint32_t slot = 0; slot < 4; ++slot)
+        {
+            mask |= (childRayMasks[slot] != 0) ? (1 << slot) : 0;
+        }
+
+        uint32_t slots[4];
+        uint32_t numSlots = SortSlotsFarToNear(mask, orderEntries, slots);
+        for (uint32_t i = 0; i < numSlots; ++i)
+        {
+            uint32_t slot      = slots[i];
+            stack[stackSize++] = {node.Child[slot], node.Count[slot], childRayMasks[slot]};
+        }
+    }
+}
+
+bool Bvh::FindClosestPoint(const glm::vec3& point, float maxDistance, ClosestPoint* pResult) const
+{
+    if (mNodes.empty() || IsNull(pResult))
+    {
+        return false;
+    }
+
+    struct StackEntry
+    {
+        uint32_t Child;
+        uint32_t Count;
+        float    DistSq;
+    };
+
+    StackEntry stack[kMaxStackSize];
+    uint32_t   stackSize  = 0;
+    float      bestDistSq = maxDistance * maxDistance;
+    bool       found      = false;
+
+    stack[stackSize++] = {0, 0, 0};
+    while (stackSize > 0)
+    {
+        const StackEntry top = stack[--stackSize];
+        if (top.DistSq >= bestDistSq)
+        {
+            continue;
+        }
+
+        if (top.Count > 0)
+        {
+            const TrianglePacket& packet = mPackets[top.Child];
+            for (uint32_t lane = 0; lane < top.Count; ++lane)
+            {
+                glm::vec3 P0 = glm::vec3(packet.P0[0][lane], packet.P0[1][lane], packet.P0[2][lane]);
+                glm::vec3 P1 = P0 + glm::vec3(packet.Edge1[0][lane], packet.Edge1[1][lane], packet.Edge1[2][lane]);
+                glm::vec3 P2 = P0 + glm::vec3(packet.Edge2[0][lane], packet.Edge2[1][lane], packet.Edge2[2][lane]);
+
+                float     u      = 0;
+                float     v      = 0;
+                glm::vec3 q      = ClosestPointOnTriangle(point, P0, P1, P2, &u, &v);
+                glm::vec3 d      = q - point;
+                float     distSq = glm::dot(d, d);
+                if (distSq < bestDistSq)
+                {
+                    bestDistSq             = distSq;
+                    pResult->Position      = q;
+                    pResult->U             = u;
+                    pResult->V             = v;
+                    pResult->TriangleIndex = packet.TriangleIndex[lane];
+                    found                  = true;
+                }
+            }
+            continue;
+        }
+
+        const Node& node = mNodes[top.Child];
+
+        float distSq[4];
+        DistanceSqToChildren(node, point, distSq);
+
+        int mask = 0;
+        for (uint32_t slot = 0; slot < 4; ++slot)
+        {
+            mask |= (distSq[slot] < bestDistSq) ? (1 << slot) : 0;
+        }
+
+        uint32_t slots[4];
+        uint32_t numSlots = SortSlotsFarToNear(mask, distSq, slots);
+        for (uint32_t i = 0; i < numSlots; ++i)
+        {
+            uint32_t slot      = slots[i];
+            stack[stackSize++] = {node.Child[slot], node.Count[slot], distSq[slot]};
+        }
+    }
+
+    if (found)
+    {
+        pResult->Distance = sqrtf(bestDistSq);
+    }
+
+    return found;
+}
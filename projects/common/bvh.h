@@ -0,0 +1,135 @@
+#pragma once
+
+#include "config.h"
+#include "tri_mesh.h"
+
+#include <glm/glm.hpp>
+
+//
+// Triangle BVH for CPU ray and proximity queries
+//
+// Build() bins centroids (binned SAH) into a binary tree, building the
+// top levels' subtrees as job system jobs, then collapses it into a
+// 4-wide tree. A node holds its 4 children in SoA form, 32 bytes per
+// child, so a single SSE2 pass tests all four boxes. Leaves hold up to 4
+// triangles, also in SoA form, and are intersected 4 at a time.
+//
+// Queries are const and thread safe:
+//   - Intersect()         closest hit, e.g. picking and path tracing
+//   - IntersectAny()      any hit, for occlusion and shadow checks
+//   - IntersectPacket()   closest hits for batches of coherent rays
+//                         (camera rays, picking regions), nodes are
+//                         fetched once for the whole packet
+//   - FindClosestPoint()  closest surface point, for baking and snapping
+//
+// Triangle indices in the results refer to the input triangles.
+//
+class Bvh
+{
+public:
+    struct BuildOptions
+    {
+        uint32_t NumBins          = 16;
+        float    TraversalCost    = 1.0f; // SAH cost of visiting a node, relative to
+        float    IntersectionCost = 1.0f; // the cost of intersecting a triangle
+        uint32_t NumThreads       = 0;    // Cap on job system threads, 0 uses them all
+    };
+
+    struct Stats
+    {
+        uint32_t NumTriangles = 0;
+        uint32_t NumNodes     = 0;
+        uint32_t NumLeaves    = 0;
+        uint32_t MaxDepth     = 0;
+        float    SahCost      = 0;
+        double   BuildTimeMs  = 0;
+    };
+
+    struct Ray
+    {
+        glm::vec3 Origin    = glm::vec3(0);
+        float     TMin      = 0;
+        glm::vec3 Direction = glm::vec3(0, 0, 1);
+        float     TMax      = FLT_MAX;
+    };
+
+    // Barycentrics: P = (1 - U - V) * P0 + U * P1 + V * P2
+    struct Hit
+    {
+        float    T             = 0;
+        float    U             = 0;
+        float    V             = 0;
+        uint32_t TriangleIndex = UINT32_MAX;
+    };
+
+    struct ClosestPoint
+    {
+        glm::vec3 Position      = glm::vec3(0);
+        float     Distance      = 0;
+        float     U             = 0;
+        float     V             = 0;
+        uint32_t  TriangleIndex = UINT32_MAX;
+    };
+
+    Bvh();
+    ~Bvh();
+
+    static bool Build(const TriMesh& mesh, const BuildOptions& options, Bvh* pBvh);
+    // pIndices holds 3 vertex indices per triangle
+    static bool Build(
+        uint32_t            numVertices,
+        const glm::vec3*    pPositions,
+        uint32_t            numTriangles,
+        const uint32_t*     pIndices,
+        const BuildOptions& options,
+        Bvh*                pBvh);
+
+    bool         Empty() const { return mNodes.empty(); }
+    const Stats& GetStats() const { return mStats; }
+
+    // Returns false if nothing was hit in (ray.TMin, ray.TMax)
+    bool Intersect(const Ray& ray, Hit* pHit) const;
+    bool IntersectAny(const Ray& ray) const;
+    // Same results as calling Intersect() for each ray, a hit with TriangleIndex UINT32_MAX is a miss
+    void IntersectPacket(uint32_t numRays, const Ray* pRays, Hit* pHits) const;
+
+    // Returns false if there's no surface within maxDistance of point
+    bool FindClosestPoint(const glm::vec3& point, float maxDistance, ClosestPoint* pResult) const;
+
+private:
+    static const uint32_t kInvalidChild = UINT32_MAX;
+
+    //
+    // Count == 0: Child is a node index, or kInvalidChild for an empty slot.
+    //             Empty slots have inverted bounds so they never pass a test.
+    // Count  > 0: Child is a leaf packet index, Count is its triangle count.
+    //
+    struct Node
+    {
+        float    BoundsMin[3][4];
+        float    BoundsMax[3][4];
+        uint32_t Child[4];
+        uint32_t Count[4];
+    };
+
+    // Unused lanes repeat lane 0, a duplicate hit is harmless
+    struct TrianglePacket
+    {
+        float    P0[3][4];
+        float    Edge1[3][4];
+        float    Edge2[3][4];
+        uint32_t TriangleIndex[4];
+    };
+
+    struct BuildContext;
+    struct BuildNode;
+    struct PreparedRay;
+
+    uint32_t CollapseNode(const BuildNode* pBuildNode, const BuildContext& ctx, uint32_t depth);
+    bool     IntersectLeaf(uint32_t packetIndex, const PreparedRay& ray, float* pTMax, Hit* pHit) const;
+    void     IntersectPacket8(uint32_t numRays, const Ray* pRays, Hit* pHits) const;
+
+    std::vector<Node>           mNodes   = {};
+    std::vector<TrianglePacket> mPackets = {};
+    Stats                       mStats   = {};
+};
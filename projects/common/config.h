@@ -69,6 +69,12 @@ enum GREXFormat
     GREX_FORMAT_BC6H_SFLOAT        = 17,
     GREX_FORMAT_BC6H_UFLOAT        = 18,
     GREX_FORMAT_BC7_RGBA           = 19,
+    GREX_FORMAT_R8G8_SNORM         = 20,
+    GREX_FORMAT_R8G8B8A8_SNORM     = 21,
+    GREX_FORMAT_R16G16_UNORM       = 22,
+    GREX_FORMAT_R16G16_SNORM       = 23,
+    GREX_FORMAT_R16G16B16A16_UNORM = 24,
+    GREX_FORMAT_R16G16B16A16_SNORM = 25,
 };
 
 struct MipOffset
@@ -0,0 +1,1131 @@
+#include "cpu_path_tracer.h"
+#include "job_system.h"
+
+#include <atomic>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define CPU_PATH_TRACER_SSE2
+#include <emmintrin.h>
+#endif
+
+// =============================================================================
+// Shader functions
+// =============================================================================
+//
+// These are straight ports of the functions in
+// assets/projects/031_raytracing_path_trace_pbr/shaders.hlsl and keep
+// their names, constants included, so the two are easy to diff. Keep them
+// in sync when the shaders change.
+//
+namespace
+{
+
+const float kPI      = 3.1415292f; // Not a typo, the shaders use this value
+const float kRayTMin = 0.001f;
+const float kRayTMax = 10000.0f;
+const float kOffset  = 0.001f;
+
+// HLSL's saturate, NaN goes to 0 like it does on the GPU
+float saturate(float x)
+{
+    return (x > 0.0f) ? ((x < 1.0f) ? x : 1.0f) : 0.0f;
+}
+
+glm::vec3 saturate(const glm::vec3& v)
+{
+    return glm::vec3(saturate(v.x), saturate(v.y), saturate(v.z));
+}
+
+uint32_t pcg_hash(uint32_t& rngState)
+{
+    uint32_t state = rngState;
+    rngState       = rngState * 747796405u + 2891336453u;
+    uint32_t word  = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+    return (word >> 22u) ^ word;
+}
+
+float Random01(uint32_t& rngState)
+{
+    return static_cast<float>(pcg_hash(rngState) / 4294967296.0);
+}
+
+float Geometry_SchlickBeckman(float NoV, float k)
+{
+    return NoV / (NoV * (1 - k) + k);
+}
+
+float Geometry_SmithIBL(const glm::vec3& N, const glm::vec3& V, const glm::vec3& L, float roughness)
+{
+    float k   = (roughness * roughness) / 2.0f;
+    float NoL = saturate(glm::dot(N, L));
+    float NoV = saturate(glm::dot(N, V));
+    float G1  = Geometry_SchlickBeckman(NoV, k);
+    float G2  = Geometry_SchlickBeckman(NoL, k);
+    return G1 * G2;
+}
+
+glm::vec3 Fresnel_SchlickRoughness(float cosTheta, const glm::vec3& F0, float roughness)
+{
+    glm::vec3 r = glm::vec3(1 - roughness);
+    return F0 + (glm::max(r, F0) - F0) * powf(1 - cosTheta, 5);
+}
+
+float FresnelSchlickReflectionAmount(const glm::vec3& I, const glm::vec3& N, float n1, float n2)
+{
+    float r0 = (n1 - n2) / (n1 + n2);
+    r0       = r0 * r0;
+
+    float cosX = -glm::dot(I, N);
+    if (n1 > n2)
+    {
+        float n     = n1 / n2;
+        float sinT2 = n * n * (1.0f - cosX * cosX);
+        if (sinT2 > 1.0f)
+        {
+            return 1.0f; // TIR
+        }
+        cosX = sqrtf(1.0f - sinT2);
+    }
+    float x  = 1.0f - cosX;
+    float fr = r0 + (1.0f - r0) * x * x * x * x * x;
+
+    return fr;
+}
+
+float catan2(float y, float x)
+{
+    const float kEps = 0.00001f;
+
+    float absx = fabsf(x);
+    float absy = fabsf(y);
+    if ((absx < kEps) && (absy < kEps))
+    {
+        return NAN;
+    }
+    else if ((absx > 0) && (absy == 0.0f))
+    {
+        return 0.0f;
+    }
+    float s = 1.5f * 3.141592f;
+    if (y >= 0)
+    {
+        s = 3.141592f / 2.0f;
+    }
+    return s - atanf(x / y);
+}
+
+glm::vec2 CartesianToSpherical(const glm::vec3& pos)
+{
+    float absX = fabsf(pos.x);
+    float absZ = fabsf(pos.z);
+    if ((absX < 0.00001f) && (absZ <= 0.00001f))
+    {
+        if (pos.y > 0)
+        {
+            return glm::vec2(0, 0);
+        }
+        else if (pos.y < 0)
+        {
+            return glm::vec2(0, 3.141592f);
+        }
+        else
+        {
+            return glm::vec2(NAN, NAN);
+        }
+    }
+    float theta = catan2(pos.z, pos.x);
+    float phi   = acosf(pos.y);
+    return glm::vec2(theta, phi);
+}
+
+glm::vec2 Hammersley(uint32_t i, uint32_t N)
+{
+    uint32_t bits = (i << 16u) | (i >> 16u);
+    bits          = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
+    bits          = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
+    bits          = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
+    bits          = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
+    float rdi     = static_cast<float>(bits) * 2.3283064365386963e-10f;
+    return glm::vec2(static_cast<float>(i) / static_cast<float>(N), rdi);
+}
+
+glm::vec3 ImportanceSampleGGX(const glm::vec2& Xi, float Roughness, const glm::vec3& N)
+{
+    float a        = Roughness * Roughness;
+    float Phi      = 2 * kPI * Xi.x;
+    float CosTheta = sqrtf((1 - Xi.y) / (1 + (a * a - 1) * Xi.y));
+    float SinTheta = sqrtf(1 - CosTheta * CosTheta);
+
+    glm::vec3 H        = glm::vec3(SinTheta * cosf(Phi), SinTheta * sinf(Phi), CosTheta);
+    glm::vec3 UpVector = fabsf(N.y) < 0.999999f ? glm::vec3(0, 1, 0) : glm::vec3(1, 0, 0);
+    glm::vec3 TangentX = glm::normalize(glm::cross(UpVector, N));
+    glm::vec3 TangentY = glm::cross(N, TangentX);
+
+    // Tangent to world space
+    return TangentX * H.x + TangentY * H.y + N * H.z;
+}
+
+glm::vec3 GenIrradianceSampleDirRNG(uint32_t& rngState, const glm::vec3& N)
+{
+    float u = Random01(rngState);
+    float v = Random01(rngState);
+    return ImportanceSampleGGX(glm::vec2(u, v), 1.0f, N);
+}
+
+glm::vec3 GenSpecularSampleDirRNG(uint32_t& rngState, const glm::vec3& N, float Roughness)
+{
+    float u = Random01(rngState);
+    float v = Random01(rngState);
+    return ImportanceSampleGGX(glm::vec2(u, v), Roughness, N);
+}
+
+glm::vec3 ACESFilm(const glm::vec3& x)
+{
+    return saturate((x * (2.51f * x + 0.03f)) / (x * (2.43f * x + 0.59f) + 0.14f));
+}
+
+} // namespace
+
+// =============================================================================
+// Sphere BVH
+// =============================================================================
+//
+// Triangles go into a Bvh (bvh.h). Scenes only have a handful of spheres,
+// a median split binary tree is plenty for those.
+//
+namespace
+{
+
+const uint32_t kMaxLeafSize   = 4;
+const uint32_t kMaxStackDepth = 64;
+
+struct BuildPrim
+{
+    glm::vec3 Min;
+    glm::vec3 Max;
+    glm::vec3 Centroid;
+    uint32_t  Index;
+};
+
+struct LeafRange
+{
+    uint32_t First;
+    uint32_t Count;
+};
+
+//
+// Median split on the longest centroid axis. The nodes come out depth
+// first, so an interior node's left child always follows it.
+//
+template <typename NodeT>
+void BuildBvhNode(
+    std::vector<BuildPrim>& prims,
+    uint32_t                first,
+    uint32_t                count,
+    std::vector<NodeT>&     nodes,
+    std::vector<LeafRange>& leaves)
+{
+    uint32_t nodeIndex = static_cast<uint32_t>(nodes.size());
+    nodes.push_back({});
+
+    glm::vec3 boundsMin   = glm::vec3(FLT_MAX);
+    glm::vec3 boundsMax   = glm::vec3(-FLT_MAX);
+    glm::vec3 centroidMin = glm::vec3(FLT_MAX);
+    glm::vec3 centroidMax = glm::vec3(-FLT_MAX);
+    for (uint32_t i = first; i < (first + count); ++i)
+    {
+        boundsMin   = glm::min(boundsMin, prims[i].Min);
+        boundsMax   = glm::max(boundsMax, prims[i].Max);
+        centroidMin = glm::min(centroidMin, prims[i].Centroid);
+        centroidMax = glm::max(centroidMax, prims[i].Centroid);
+    }
+
+    nodes[nodeIndex].BoundsMin = boundsMin;
+    nodes[nodeIndex].BoundsMax = boundsMax;
+
+    if (count <= kMaxLeafSize)
+    {
+        nodes[nodeIndex].Offset = static_cast<uint32_t>(leaves.size());
+        nodes[nodeIndex].Count  = count;
+        leaves.push_back({first, count});
+        return;
+    }
+
+    glm::vec3 extent = centroidMax - centroidMin;
+    int       axis   = 0;
+    if (extent.y > extent[axis])
+    {
+        axis = 1;
+    }
+    if (extent.z > extent[axis])
+    {
+        axis = 2;
+    }
+
+    uint32_t mid = first + count / 2;
+    std::nth_element(
+        prims.begin() + first,
+        prims.begin() + mid,
+        prims.begin() + first + count,
+        [axis](const BuildPrim& a, const BuildPrim& b) { return a.Centroid[axis] < b.Centroid[axis]; });
+
+    BuildBvhNode(prims, first, mid - first, nodes, leaves);
+
+    uint32_t rightIndex = static_cast<uint32_t>(nodes.size());
+    BuildBvhNode(prims, mid, first + count - mid, nodes, leaves);
+
+    nodes[nodeIndex].Offset = rightIndex;
+    nodes[nodeIndex].Count  = 0;
+}
+
+bool IntersectAabb(
+    const glm::vec3& boundsMin,
+    const glm::vec3& boundsMax,
+    const glm::vec3& origin,
+    const glm::vec3& invDir,
+    float            tMin,
+    float            tMax,
+    float*           pEntry)
+{
+    glm::vec3 t0    = (boundsMin - origin) * invDir;
+    glm::vec3 t1    = (boundsMax - origin) * invDir;
+    glm::vec3 tNear = glm::min(t0, t1);
+    glm::vec3 tFar  = glm::max(t0, t1);
+
+    float entry = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, tMin));
+    float exit  = std::min(std::min(tFar.x, tFar.y), std::min(tFar.z, tMax));
+
+    *pEntry = entry;
+    return entry <= exit;
+}
+
+//
+// Stack based traversal, nearer child first. intersectLeaf(packetIndex, tMax)
+// returns the closest hit distance in the packet or tMax if there isn't one.
+//
+template <typename NodeT, typename IntersectLeafFn>
+float TraverseBvh(
+    const std::vector<NodeT>& nodes,
+    const glm::vec3&          origin,
+    const glm::vec3&          dir,
+    float                     tMin,
+    float                     tMax,
+    IntersectLeafFn           intersectLeaf)
+{
+    if (nodes.empty())
+    {
+        return tMax;
+    }
+
+    const glm::vec3 invDir = 1.0f / dir;
+
+    struct StackEntry
+    {
+        uint32_t Node;
+        float    Entry;
+    };
+
+    StackEntry stack[kMaxStackDepth];
+    uint32_t   stackSize = 0;
+
+    float entry = 0;
+    if (!IntersectAabb(nodes[0].BoundsMin, nodes[0].BoundsMax, origin, invDir, tMin, tMax, &entry))
+    {
+        return tMax;
+    }
+    stack[stackSize++] = {0, entry};
+
+    while (stackSize > 0)
+    {
+        StackEntry top = stack[--stackSize];
+        if (top.Entry > tMax)
+        {
+            continue;
+        }
+
+        const NodeT& node = nodes[top.Node];
+        if (node.Count > 0)
+        {
+            tMax = intersectLeaf(node.Offset, tMax);
+            continue;
+        }
+
+        uint32_t left       = top.Node + 1;
+        uint32_t right      = node.Offset;
+        float    leftEntry  = 0;
+        float    rightEntry = 0;
+        bool     hitLeft    = IntersectAabb(nodes[left].BoundsMin, nodes[left].BoundsMax, origin, invDir, tMin, tMax, &leftEntry);
+        bool     hitRight   = IntersectAabb(nodes[right].BoundsMin, nodes[right].BoundsMax, origin, invDir, tMin, tMax, &rightEntry);
+
+        // Median splits keep the tree within log2(N / 4) levels, far below the stack size
+        if (hitLeft && hitRight)
+        {
+            if (leftEntry <= rightEntry)
+            {
+                stack[stackSize++] = {right, rightEntry};
+                stack[stackSize++] = {left, leftEntry};
+            }
+            else
+            {
+                stack[stackSize++] = {left, leftEntry};
+                stack[stackSize++] = {right, rightEntry};
+            }
+        }
+        else if (hitLeft)
+        {
+            stack[stackSize++] = {left, leftEntry};
+        }
+        else if (hitRight)
+        {
+            stack[stackSize++] = {right, rightEntry};
+        }
+    }
+
+    return tMax;
+}
+
+} // namespace
+
+// =============================================================================
+// CpuPathTracer::Image
+// =============================================================================
+void CpuPathTracer::Image::Resize(uint32_t width, uint32_t height)
+{
+    this->Width  = width;
+    this->Height = height;
+    this->Accum.assign(static_cast<size_t>(width) * height, glm::vec4(0));
+    this->SampleCounts.assign(static_cast<size_t>(width) * height, 0);
+    this->AlbedoAccum.assign(static_cast<size_t>(width) * height, glm::vec3(0));
+    this->NormalDepthAccum.assign(static_cast<size_t>(width) * height, glm::vec4(0));
+}
+
+void CpuPathTracer::Image::Reset()
+{
+    std::fill(this->Accum.begin(), this->Accum.end(), glm::vec4(0));
+    std::fill(this->SampleCounts.begin(), this->SampleCounts.end(), 0);
+    std::fill(this->AlbedoAccum.begin(), this->AlbedoAccum.end(), glm::vec3(0));
+    std::fill(this->NormalDepthAccum.begin(), this->NormalDepthAccum.end(), glm::vec4(0));
+}
+
+// =============================================================================
+// CpuPathTracer
+// =============================================================================
+struct CpuPathTracer::Hit
+{
+    float    T        = 0;
+    float    U        = 0;
+    float    V        = 0;
+    uint32_t Index    = UINT32_MAX;
+    bool     IsSphere = false;
+};
+
+struct CpuPathTracer::ThreadContext
+{
+    const Options* pOptions = nullptr;
+    uint32_t       RngState = 0;
+    uint64_t       NumRays  = 0;
+
+    // Written by the depth 0 Trace() call
+    glm::vec3 FirstHitAlbedo = glm::vec3(0);
+    glm::vec3 FirstHitNormal = glm::vec3(0);
+    float     FirstHitDepth  = 0;
+};
+
+CpuPathTracer::CpuPathTracer()
+{
+}
+
+CpuPathTracer::~CpuPathTracer()
+{
+}
+
+uint32_t CpuPathTracer::AddMaterial(const Material& material)
+{
+    mMaterials.push_back(material);
+    return static_cast<uint32_t>(mMaterials.size() - 1);
+}
+
+void CpuPathTracer::AddMesh(const TriMesh& mesh, const glm::mat4& transform, uint32_t materialIndex)
+{
+    if (materialIndex >= mMaterials.size())
+    {
+        assert(false && "invalid material index");
+        return;
+    }
+
+    const auto& positions  = mesh.GetPositions();
+    const auto& normals    = mesh.GetNormals();
+    const bool  hasNormals = (normals.size() == positions.size());
+
+    const glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(transform)));
+    // Mirroring transforms flip the winding, which is what decides inside vs outside
+    const bool flipWinding = (glm::determinant(glm::mat3(transform)) < 0);
+
+    for (const auto& tri : mesh.GetTriangles())
+    {
+        uint32_t vIdx[3] = {tri.vIdx0, tri.vIdx1, tri.vIdx2};
+        if (flipWinding)
+        {
+            std::swap(vIdx[1], vIdx[2]);
+        }
+
+        glm::vec3 P[3] = {};
+        for (uint32_t i = 0; i < 3; ++i)
+        {
+            P[i] = glm::vec3(transform * glm::vec4(positions[vIdx[i]], 1));
+        }
+
+        Triangle worldTri      = {};
+        worldTri.P0            = P[0];
+        worldTri.Edge1         = P[1] - P[0];
+        worldTri.Edge2         = P[2] - P[0];
+        worldTri.MaterialIndex = materialIndex;
+
+        if (hasNormals)
+        {
+            worldTri.N0 = glm::normalize(normalMatrix * normals[vIdx[0]]);
+            worldTri.N1 = glm::normalize(normalMatrix * normals[vIdx[1]]);
+            worldTri.N2 = glm::normalize(normalMatrix * normals[vIdx[2]]);
+        }
+        else
+        {
+            glm::vec3 faceNormal = glm::cross(worldTri.Edge1, worldTri.Edge2);
+            float     len        = glm::length(faceNormal);
+            faceNormal           = (len > 0) ? (faceNormal / len) : glm::vec3(0, 1, 0);
+
+            worldTri.N0 = faceNormal;
+            worldTri.N1 = faceNormal;
+            worldTri.N2 = faceNormal;
+        }
+
+        mTriangles.push_back(worldTri);
+    }
+
+    mBuilt = false;
+}
+
+void CpuPathTracer::AddSphere(const glm::vec3& center, float radius, uint32_t materialIndex)
+{
+    if (materialIndex >= mMaterials.size())
+    {
+        assert(false && "invalid material index");
+        return;
+    }
+
+    mSpheres.push_back({center, radius, materialIndex});
+
+    mBuilt = false;
+}
+
+void CpuPathTracer::SetEnvironment(const IBLMaps& ibl)
+{
+    // Mip levels are stacked vertically, the base level is at the top
+    const BitmapRGBA32f& envMap = ibl.environmentMap;
+
+    uint32_t width  = std::min(ibl.baseWidth, envMap.GetWidth());
+    uint32_t height = std::min(ibl.baseHeight, envMap.GetHeight());
+
+    mEnvironment.resize(static_cast<size_t>(width) * height);
+    for (uint32_t y = 0; y < height; ++y)
+    {
+        for (uint32_t x = 0; x < width; ++x)
+        {
+            const PixelRGBA32f* pPixel = envMap.GetPixels(x, y);
+
+            mEnvironment[y * width + x] = glm::vec3(pPixel->r, pPixel->g, pPixel->b);
+        }
+    }
+
+    mEnvironmentWidth  = width;
+    mEnvironmentHeight = height;
+}
+
+void CpuPathTracer::Build()
+{
+    std::vector<LeafRange> leaves;
+
+    // Triangles, vertices aren't shared after flattening
+    {
+        std::vector<glm::vec3> positions(3 * mTriangles.size());
+        std::vector<uint32_t>  indices(3 * mTriangles.size());
+        for (uint32_t i = 0; i < mTriangles.size(); ++i)
+        {
+            const Triangle& tri = mTriangles[i];
+
+            positions[3 * i + 0] = tri.P0;
+            positions[3 * i + 1] = tri.P0 + tri.Edge1;
+            positions[3 * i + 2] = tri.P0 + tri.Edge2;
+            indices[3 * i + 0]   = 3 * i + 0;
+            indices[3 * i + 1]   = 3 * i + 1;
+            indices[3 * i + 2]   = 3 * i + 2;
+        }
+
+        Bvh::Build(CountU32(positions), DataPtr(positions), CountU32(mTriangles), DataPtr(indices), Bvh::BuildOptions(), &mTriangleBvh);
+    }
+
+    // Spheres
+    {
+        std::vector<BuildPrim> prims(mSpheres.size());
+        for (uint32_t i = 0; i < prims.size(); ++i)
+        {
+            const Sphere& sphere = mSpheres[i];
+
+            prims[i].Min      = sphere.Center - glm::vec3(sphere.Radius);
+            prims[i].Max      = sphere.Center + glm::vec3(sphere.Radius);
+            prims[i].Centroid = sphere.Center;
+            prims[i].Index    = i;
+        }
+
+        mSphereNodes.clear();
+        mSpherePackets.clear();
+        leaves.clear();
+        if (!prims.empty())
+        {
+            BuildBvhNode(prims, 0, static_cast<uint32_t>(prims.size()), mSphereNodes, leaves);
+        }
+
+        for (const auto& leaf : leaves)
+        {
+            SpherePacket packet = {};
+            for (uint32_t lane = 0; lane < 4; ++lane)
+            {
+                uint32_t      sphereIndex = prims[leaf.First + ((lane < leaf.Count) ? lane : 0)].Index;
+                const Sphere& sphere      = mSpheres[sphereIndex];
+                for (uint32_t axis = 0; axis < 3; ++axis)
+                {
+                    packet.Center[axis][lane] = sphere.Center[axis];
+                }
+                packet.RadiusSq[lane] = sphere.Radius * sphere.Radius;
+                packet.Index[lane]    = sphereIndex;
+            }
+            mSpherePackets.push_back(packet);
+        }
+    }
+
+    mBuilt = true;
+}
+
+bool CpuPathTracer::Intersect(const glm::vec3& origin, const glm::vec3& dir, float tMin, float tMax, Hit* pHit) const
+{
+    const float tMaxStart = tMax;
+
+#if defined(CPU_PATH_TRACER_SSE2)
+    const __m128 ox       = _mm_set1_ps(origin.x);
+    const __m128 oy       = _mm_set1_ps(origin.y);
+    const __m128 oz       = _mm_set1_ps(origin.z);
+    const __m128 dx       = _mm_set1_ps(dir.x);
+    const __m128 dy       = _mm_set1_ps(dir.y);
+    const __m128 dz       = _mm_set1_ps(dir.z);
+    const __m128 tMinV    = _mm_set1_ps(tMin);
+    const __m128 zero     = _mm_setzero_ps();
+    const float  dirLenSq = glm::dot(dir, dir);
+    const __m128 a        = _mm_set1_ps(dirLenSq);
+#endif
+
+    // Triangles
+    {
+        Bvh::Ray ray  = {};
+        ray.Origin    = origin;
+        ray.TMin      = tMin;
+        ray.Direction = dir;
+        ray.TMax      = tMax;
+
+        Bvh::Hit triHit = {};
+        if (mTriangleBvh.Intersect(ray, &triHit))
+        {
+            tMax           = triHit.T;
+            pHit->T        = triHit.T;
+            pHit->U        = triHit.U;
+            pHit->V        = triHit.V;
+            pHit->Index    = triHit.TriangleIndex;
+            pHit->IsSphere = false;
+        }
+    }
+
+    // Spheres, 4 per packet
+    tMax = TraverseBvh(
+        mSphereNodes,
+        origin,
+        dir,
+        tMin,
+        tMax,
+        [&](uint32_t packetIndex, float tClosest) -> float {
+            const SpherePacket& packet = mSpherePackets[packetIndex];
+
+#if defined(CPU_PATH_TRACER_SSE2)
+            __m128 ocx = _mm_sub_ps(ox, _mm_loadu_ps(packet.Center[0]));
+            __m128 ocy = _mm_sub_ps(oy, _mm_loadu_ps(packet.Center[1]));
+            __m128 ocz = _mm_sub_ps(oz, _mm_loadu_ps(packet.Center[2]));
+
+            __m128 b    = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ocx, dx), _mm_mul_ps(ocy, dy)), _mm_mul_ps(ocz, dz));
+            __m128 c    = _mm_sub_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(ocx, ocx), _mm_mul_ps(ocy, ocy)), _mm_mul_ps(ocz, ocz)), _mm_loadu_ps(packet.RadiusSq));
+            __m128 disc = _mm_sub_ps(_mm_mul_ps(b, b), _mm_mul_ps(a, c));
+
+            __m128 mask = _mm_cmpge_ps(disc, zero);
+            if (_mm_movemask_ps(mask) == 0)
+            {
+                return tClosest;
+            }
+
+            __m128 sq = _mm_sqrt_ps(_mm_max_ps(disc, zero));
+            __m128 t0 = _mm_div_ps(_mm_sub_ps(_mm_sub_ps(zero, b), sq), a);
+            __m128 t1 = _mm_div_ps(_mm_add_ps(_mm_sub_ps(zero, b), sq), a);
+
+            // Near root unless it's behind tMin, which means the origin is inside
+            __m128 useNear = _mm_cmpgt_ps(t0, tMinV);
+            __m128 t       = _mm_or_ps(_mm_and_ps(useNear, t0), _mm_andnot_ps(useNear, t1));
+
+            mask = _mm_and_ps(mask, _mm_cmpgt_ps(t, tMinV));
+            mask = _mm_and_ps(mask, _mm_cmplt_ps(t, _mm_set1_ps(tClosest)));
+
+            int laneMask = _mm_movemask_ps(mask);
+            if (laneMask == 0)
+            {
+                return tClosest;
+            }
+
+            alignas(16) float tLanes[4];
+            _mm_store_ps(tLanes, t);
+
+            for (uint32_t lane = 0; lane < 4; ++lane)
+            {
+                if ((laneMask & (1 << lane)) && (tLanes[lane] < tClosest))
+                {
+                    tClosest       = tLanes[lane];
+                    pHit->T        = tLanes[lane];
+                    pHit->Index    = packet.Index[lane];
+                    pHit->IsSphere = true;
+                }
+            }
+#else
+            const float a = glm::dot(dir, dir);
+            for (uint32_t lane = 0; lane < 4; ++lane)
+            {
+                glm::vec3 center = glm::vec3(packet.Center[0][lane], packet.Center[1][lane], packet.Center[2][lane]);
+                glm::vec3 oc     = origin - center;
+
+                float b    = glm::dot(oc, dir);
+                float c    = glm::dot(oc, oc) - packet.RadiusSq[lane];
+                float disc = b * b - a * c;
+                if (disc < 0)
+                {
+                    continue;
+                }
+
+                float sq = sqrtf(disc);
+                float t  = (-b - sq) / a;
+                if (t <= tMin)
+                {
+                    t = (-b + sq) / a;
+                }
+                if ((t > tMin) && (t < tClosest))
+                {
+                    tClosest       = t;
+                    pHit->T        = t;
+                    pHit->Index    = packet.Index[lane];
+                    pHit->IsSphere = true;
+                }
+            }
+#endif
+            return tClosest;
+        });
+
+    return (tMax < tMaxStart);
+}
+
+glm::vec3 CpuPathTracer::GetEnvironment(const glm::vec3& dir) const
+{
+    if (mEnvironment.empty())
+    {
+        return glm::vec3(0);
+    }
+
+    // Same as GetIBLEnvironment() in the shaders
+    glm::vec2 uv = CartesianToSpherical(glm::normalize(dir));
+    uv.x         = saturate(uv.x / (2.0f * kPI));
+    uv.y         = saturate(uv.y / kPI);
+
+    // Bilinear, U repeats and V clamps like the samples' IBL sampler
+    const int width  = static_cast<int>(mEnvironmentWidth);
+    const int height = static_cast<int>(mEnvironmentHeight);
+
+    float x  = uv.x * width - 0.5f;
+    float y  = uv.y * height - 0.5f;
+    float fx = x - floorf(x);
+    float fy = y - floorf(y);
+    int   x0 = static_cast<int>(floorf(x));
+    int   y0 = static_cast<int>(floorf(y));
+    int   x1 = x0 + 1;
+    int   y1 = y0 + 1;
+
+    x0 = ((x0 % width) + width) % width;
+    x1 = ((x1 % width) + width) % width;
+    y0 = std::clamp(y0, 0, height - 1);
+    y1 = std::clamp(y1, 0, height - 1);
+
+    glm::vec3 c00 = mEnvironment[y0 * width + x0];
+    glm::vec3 c10 = mEnvironment[y0 * width + x1];
+    glm::vec3 c01 = mEnvironment[y1 * width + x0];
+    glm::vec3 c11 = mEnvironment[y1 * width + x1];
+
+    glm::vec3 color = glm::mix(glm::mix(c00, c10, fx), glm::mix(c01, c11, fx), fy);
+    color           = glm::min(color, glm::vec3(100.0f));
+    return color;
+}
+
+//
+// MyMissShader and MyClosestHitShader rolled into one. The recursion and
+// the order RNG values are drawn in match the shader, so a pixel sees the
+// same random sequence on both sides.
+//
+glm::vec3 CpuPathTracer::Trace(const glm::vec3& origin, const glm::vec3& dir, uint32_t depth, ThreadContext& ctx) const
+{
+    ctx.NumRays += 1;
+
+    Hit hit = {};
+    if (!Intersect(origin, dir, kRayTMin, kRayTMax, &hit))
+    {
+        if (depth == 0)
+        {
+            ctx.FirstHitAlbedo = glm::vec3(1);
+            ctx.FirstHitNormal = -dir;
+            ctx.FirstHitDepth  = 0;
+        }
+        return GetEnvironment(dir);
+    }
+
+    glm::vec3 P = origin + hit.T * dir;
+    glm::vec3 I = glm::normalize(dir);
+    glm::vec3 V = -I;
+
+    glm::vec3 N             = glm::vec3(0);
+    glm::vec3 faceNormal    = glm::vec3(0);
+    uint32_t  materialIndex = 0;
+    if (hit.IsSphere)
+    {
+        const Sphere& sphere = mSpheres[hit.Index];
+
+        N             = glm::normalize(P - sphere.Center);
+        faceNormal    = N;
+        materialIndex = sphere.MaterialIndex;
+    }
+    else
+    {
+        const Triangle& tri = mTriangles[hit.Index];
+
+        float w       = 1.0f - hit.U - hit.V;
+        N             = glm::normalize(tri.N0 * w + tri.N1 * hit.U + tri.N2 * hit.V);
+        faceNormal    = glm::cross(tri.Edge1, tri.Edge2);
+        materialIndex = tri.MaterialIndex;
+    }
+
+    //
+    // The shader uses HIT_KIND_TRIANGLE_BACK_FACE. TriMesh triangles are
+    // counter clockwise seen from outside, so a back face hit is one where
+    // the ray travels along the face normal.
+    //
+    bool inside = (glm::dot(faceNormal, dir) > 0);
+
+    const Material& material = mMaterials[materialIndex];
+
+    glm::vec3 baseColor           = material.baseColor;
+    float     roughness           = material.roughness;
+    float     metallic            = material.metallic;
+    float     specularReflectance = material.specularReflectance;
+    float     ior                 = material.ior;
+    glm::vec3 emission            = material.emissionColor;
+
+    // Remap
+    roughness = roughness * roughness;
+
+    // Calculate F0
+    glm::vec3 F0 = glm::vec3(0.16f * specularReflectance * specularReflectance * (1 - metallic)) + baseColor * metallic;
+
+    glm::vec3 reflection = glm::vec3(0);
+    glm::vec3 refraction = glm::vec3(0);
+    float     kr         = 1;
+    float     kt         = 0;
+
+    float eta1 = 1.0f;
+    float eta2 = ior;
+
+    if (inside)
+    {
+        std::swap(eta1, eta2);
+        N = -N;
+    }
+
+    //
+    // Denoiser features. Albedo is what the lighting gets multiplied by:
+    // the base color for diffuse and metal, white for glass, which passes
+    // most of the light through untinted.
+    //
+    if (depth == 0)
+    {
+        ctx.FirstHitAlbedo = (ior > 1.0f) ? glm::vec3(1) : baseColor;
+        ctx.FirstHitNormal = N;
+        ctx.FirstHitDepth  = hit.T;
+    }
+
+    if (ior > 1.0f)
+    {
+        kr = saturate(FresnelSchlickReflectionAmount(I, N, eta1, eta2));
+        kt = 1.0f - kr;
+        // Hack - intended to amp up the specular on glass
+        kr = powf(kr, 0.0001f);
+    }
+
+    if (depth < ctx.pOptions->MaxDepth)
+    {
+        // Naive scheme for picking which type of ray to fire
+        float chanceDiffuse = 0.5f + (-0.5f * roughness) + ((ior > 1.0f) ? 0.49f : 0);
+        bool  isDiffuse     = Random01(ctx.RngState) >= chanceDiffuse;
+
+        if (isDiffuse)
+        {
+            float     NoV = saturate(glm::dot(N, V));
+            glm::vec3 F   = Fresnel_SchlickRoughness(NoV, F0, roughness);
+            glm::vec3 kD  = (1.0f - F) * (1.0f - metallic);
+
+            glm::vec3 L = GenIrradianceSampleDirRNG(ctx.RngState, N);
+
+            glm::vec3 bounceColor = Trace(P + kOffset * L, L, depth + 1, ctx);
+
+            float NoL = saturate(glm::dot(N, L));
+            reflection += kD * bounceColor * baseColor * NoL;
+        }
+        else
+        {
+            glm::vec3 H = glm::normalize(GenSpecularSampleDirRNG(ctx.RngState, N, roughness));
+            glm::vec3 L = 2.0f * glm::dot(V, H) * H - V;
+
+            float NoV = saturate(glm::dot(N, V));
+            float NoL = saturate(glm::dot(N, L));
+            float NoH = saturate(glm::dot(N, H));
+            float VoH = saturate(glm::dot(V, H));
+            if ((NoL > 0) && (NoH > 0) && (NoV > 0) && (VoH > 0))
+            {
+                glm::vec3 bounceColor = Trace(P + kOffset * L, L, depth + 1, ctx);
+
+                glm::vec3 F = Fresnel_SchlickRoughness(VoH, F0, roughness);
+                float     G = Geometry_SmithIBL(N, V, L, roughness);
+
+                reflection += bounceColor * F * G * VoH / (NoH * NoV);
+            }
+        }
+
+        // Refraction
+        if (kt > 0)
+        {
+            glm::vec3 rayDir = glm::refract(I, N, eta1 / eta2);
+
+            // refract() returns zero on TIR, which kt > 0 should already rule out
+            if (glm::dot(rayDir, rayDir) > 0)
+            {
+                refraction += Trace(P + kOffset * rayDir, rayDir, depth + 1, ctx);
+            }
+        }
+    }
+
+    return (reflection * kr) + (refraction * kt) + emission;
+}
+
+CpuPathTracer::Stats CpuPathTracer::Render(const Camera& camera, uint32_t numSamples, const Options& options, Image* pImage) const
+{
+    if (IsNull(pImage) || (pImage->Width == 0) || (pImage->Height == 0))
+    {
+        return {};
+    }
+
+    if (!mBuilt)
+    {
+        assert(false && "Build() must be called before Render()");
+        return {};
+    }
+
+    const size_t numPixels = static_cast<size_t>(pImage->Width) * pImage->Height;
+    if ((pImage->Accum.size() != numPixels) || (pImage->SampleCounts.size() != numPixels) ||
+        (pImage->AlbedoAccum.size() != numPixels) || (pImage->NormalDepthAccum.size() != numPixels))
+    {
+        pImage->Resize(pImage->Width, pImage->Height);
+    }
+
+    Options renderOptions    = options;
+    renderOptions.MaxSamples = std::max(renderOptions.MaxSamples, 1u);
+    renderOptions.TileSize   = std::max(renderOptions.TileSize, 1u);
+
+    const uint32_t width    = pImage->Width;
+    const uint32_t height   = pImage->Height;
+    const uint32_t tileSize = renderOptions.TileSize;
+    const uint32_t tilesX   = (width + tileSize - 1) / tileSize;
+    const uint32_t tilesY   = (height + tileSize - 1) / tileSize;
+    const uint32_t numTiles = tilesX * tilesY;
+
+    uint32_t numThreads = renderOptions.NumThreads;
+    if (numThreads == 0)
+    {
+        numThreads = JobSystem::Get().GetNumThreads();
+    }
+    numThreads = std::min(numThreads, numTiles);
+
+    const glm::vec3 origin = glm::vec3(camera.ViewInverseMatrix * glm::vec4(0, 0, 0, 1));
+
+    std::atomic<uint64_t> totalSamples = 0;
+    std::atomic<uint64_t> totalRays    = 0;
+
+    //
+    // Tiles are handed out in row order as threads free up, so the tiles
+    // in flight are neighbours that touch the same part of the BVH, and an
+    // expensive tile only holds up the thread rendering it.
+    //
+    auto renderTile = [&](uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1) {
+        ThreadContext ctx = {};
+        ctx.pOptions      = &renderOptions;
+
+        uint64_t numSamplesTraced = 0;
+
+        for (uint32_t y = y0; y < y1; ++y)
+        {
+            for (uint32_t x = x0; x < x1; ++x)
+            {
+                const uint32_t rayIndex    = y * width + x;
+                uint32_t       sampleCount = pImage->SampleCounts[rayIndex];
+                glm::vec4      accum       = pImage->Accum[rayIndex];
+                glm::vec3      albedoAccum = pImage->AlbedoAccum[rayIndex];
+                glm::vec4      normalDepth = pImage->NormalDepthAccum[rayIndex];
+
+                // Same as MyRaygenShader
+                for (uint32_t s = 0; (s < numSamples) && (sampleCount < renderOptions.MaxSamples); ++s)
+                {
+                    ctx.RngState = sampleCount + rayIndex * 1943006372u;
+
+                    glm::vec2 Xi          = Hammersley(sampleCount, renderOptions.MaxSamples);
+                    glm::vec2 pixelCenter = glm::vec2(x, y) + glm::vec2(0.5f) + Xi;
+                    glm::vec2 inUV        = pixelCenter / glm::vec2(width, height);
+                    glm::vec2 d           = inUV * 2.0f - 1.0f;
+                    d.y                   = -d.y;
+
+                    glm::vec4 target    = camera.ProjectionInverseMatrix * glm::vec4(d.x, d.y, 1, 1);
+                    glm::vec3 direction = glm::vec3(camera.ViewInverseMatrix * glm::vec4(glm::normalize(glm::vec3(target)), 0));
+
+                    glm::vec3 color = Trace(origin, direction, 0, ctx);
+
+                    accum += glm::vec4(color, 1);
+                    albedoAccum += ctx.FirstHitAlbedo;
+                    normalDepth += glm::vec4(ctx.FirstHitNormal, ctx.FirstHitDepth);
+                    sampleCount += 1;
+                    numSamplesTraced += 1;
+                }
+
+                pImage->Accum[rayIndex]            = accum;
+                pImage->SampleCounts[rayIndex]     = sampleCount;
+                pImage->AlbedoAccum[rayIndex]      = albedoAccum;
+                pImage->NormalDepthAccum[rayIndex] = normalDepth;
+            }
+        }
+
+        totalSamples += numSamplesTraced;
+        totalRays += ctx.NumRays;
+    };
+
+    auto startTime = std::chrono::high_resolution_clock::now();
+
+    JobSystem::Get().ParallelFor2D(width, height, tileSize, tileSize, renderTile, numThreads);
+
+    auto endTime = std::chrono::high_resolution_clock::now();
+
+    Stats stats          = {};
+    stats.NumSamples     = totalSamples;
+    stats.NumRays        = totalRays;
+    stats.NumTiles       = numTiles;
+    stats.NumThreads     = numThreads;
+    stats.ElapsedSeconds = std::chrono::duration<double>(endTime - startTime).count();
+    if (stats.ElapsedSeconds > 0)
+    {
+        stats.SamplesPerSecond = stats.NumSamples / stats.ElapsedSeconds;
+        stats.RaysPerSecond    = stats.NumRays / stats.ElapsedSeconds;
+    }
+
+    return stats;
+}
+
+BitmapRGBA32f CpuPathTracer::ResolveHDR(const Image& image)
+{
+    BitmapRGBA32f bitmap = BitmapRGBA32f(image.Width, image.Height);
+    for (uint32_t y = 0; y < image.Height; ++y)
+    {
+        for (uint32_t x = 0; x < image.Width; ++x)
+        {
+            const uint32_t index = y * image.Width + x;
+            const uint32_t count = image.SampleCounts[index];
+
+            glm::vec3 color = (count > 0) ? (glm::vec3(image.Accum[index]) / static_cast<float>(count)) : glm::vec3(0);
+
+            PixelRGBA32f* pPixel = bitmap.GetPixels(x, y);
+            pPixel->r            = color.r;
+            pPixel->g            = color.g;
+            pPixel->b            = color.b;
+            pPixel->a            = 1.0f;
+        }
+    }
+    return bitmap;
+}
+
+void CpuPathTracer::ResolveAOVs(const Image& image, AOVs* pAOVs)
+{
+    if (IsNull(pAOVs))
+    {
+        return;
+    }
+
+    const size_t numPixels = static_cast<size_t>(image.Width) * image.Height;
+    pAOVs->Color.assign(numPixels, glm::vec3(0));
+    pAOVs->Albedo.assign(numPixels, glm::vec3(0));
+    pAOVs->Normal.assign(numPixels, glm::vec3(0));
+    pAOVs->Depth.assign(numPixels, 0.0f);
+
+    for (size_t i = 0; i < numPixels; ++i)
+    {
+        const uint32_t count = image.SampleCounts[i];
+        if (count == 0)
+        {
+            continue;
+        }
+        const float scale = 1.0f / static_cast<float>(count);
+
+        glm::vec3 normal = glm::vec3(image.NormalDepthAccum[i]);
+        float     length = glm::length(normal);
+
+        pAOVs->Color[i]  = glm::vec3(image.Accum[i]) * scale;
+        pAOVs->Albedo[i] = image.AlbedoAccum[i] * scale;
+        pAOVs->Normal[i] = (length > 0) ? (normal / length) : glm::vec3(0);
+        pAOVs->Depth[i]  = image.NormalDepthAccum[i].w * scale;
+    }
+}
+
+BitmapRGBA8u CpuPathTracer::ResolveLDR(const Image& image)
+{
+    BitmapRGBA8u bitmap = BitmapRGBA8u(image.Width, image.Height);
+    for (uint32_t y = 0; y < image.Height; ++y)
+    {
+        for (uint32_t x = 0; x < image.Width; ++x)
+        {
+            const uint32_t index = y * image.Width + x;
+            const uint32_t count = image.SampleCounts[index];
+
+            glm::vec3 color = (count > 0) ? (glm::vec3(image.Accum[index]) / static_cast<float>(count)) : glm::vec3(0);
+            color           = ACESFilm(color);
+            color           = glm::pow(color, glm::vec3(1.0f / 2.2f));
+
+            PixelRGBA8u* pPixel = bitmap.GetPixels(x, y);
+            pPixel->r           = static_cast<uint8_t>(saturate(color.r) * 255.0f + 0.5f);
+            pPixel->g           = static_cast<uint8_t>(saturate(color.g) * 255.0f + 0.5f);
+            pPixel->b           = static_cast<uint8_t>(saturate(color.b) * 255.0f + 0.5f);
+            pPixel->a           = 255;
+        }
+    }
+    return bitmap;
+}
@@ -0,0 +1,192 @@
+#pragma once
+
+#include "config.h"
+#include "bitmap.h"
+#include "bvh.h"
+#include "tri_mesh.h"
+
+#include <glm/glm.hpp>
+
+//
+// CPU reference path tracer
+//
+// Mirrors the ray generation, miss and closest hit shaders of
+// 031_raytracing_path_trace_pbr: same material model, same RNG seeding,
+// same Hammersley pixel jitter and the same IBL lookup. Given the same
+// scene, camera and IBL it converges to the same image as the GPU samples,
+// so it can be used as ground truth when changing those shaders - and it
+// runs headless.
+//
+// Geometry is TriMesh instances plus analytic spheres. Everything is
+// flattened to world space by Build(). Triangles go into a SAH Bvh, spheres
+// into a small BVH whose leaves hold up to 4 spheres in SoA layout for the
+// 4-wide SSE2 intersector.
+//
+// Images are rendered in tiles, one job system ParallelFor() piece per
+// tile. Idle workers steal pieces, so uneven tiles (glass, deep bounces)
+// don't leave threads idle.
+//
+class CpuPathTracer
+{
+public:
+    // Same layout and meaning as MaterialParameters in the 031 shaders
+    struct Material
+    {
+        glm::vec3 baseColor           = glm::vec3(1);
+        float     roughness           = 1;
+        float     metallic            = 0;
+        float     specularReflectance = 0;
+        float     ior                 = 0;
+        glm::vec3 emissionColor       = glm::vec3(0);
+    };
+
+    struct Camera
+    {
+        glm::mat4 ViewInverseMatrix       = glm::mat4(1);
+        glm::mat4 ProjectionInverseMatrix = glm::mat4(1);
+    };
+
+    struct Options
+    {
+        uint32_t MaxSamples = 4096; // Same as SceneParams.MaxSamples, N for the Hammersley jitter
+        uint32_t MaxDepth   = 10;   // Rays at this depth don't spawn more rays
+        uint32_t TileSize   = 16;
+        uint32_t NumThreads = 0; // Cap on job system threads, 0 uses them all
+    };
+
+    struct Stats
+    {
+        uint64_t NumSamples       = 0; // Camera rays traced
+        uint64_t NumRays          = 0; // All rays traced, including bounces
+        uint32_t NumTiles         = 0;
+        uint32_t NumThreads       = 0;
+        double   ElapsedSeconds   = 0;
+        double   SamplesPerSecond = 0;
+        double   RaysPerSecond    = 0;
+    };
+
+    //
+    // Accumulated radiance and per pixel sample counts, same as the
+    // AccumTarget and RayGenSamples resources of the GPU samples.
+    // Pixels stop accumulating at Options::MaxSamples.
+    //
+    // The first hit's albedo, normal and distance are summed alongside
+    // for the denoiser. Misses have albedo 1, normal -dir and distance 0.
+    //
+    struct Image
+    {
+        uint32_t               Width            = 0;
+        uint32_t               Height           = 0;
+        std::vector<glm::vec4> Accum            = {};
+        std::vector<uint32_t>  SampleCounts     = {};
+        std::vector<glm::vec3> AlbedoAccum      = {};
+        std::vector<glm::vec4> NormalDepthAccum = {};
+
+        Image() {}
+        Image(uint32_t width, uint32_t height) { Resize(width, height); }
+
+        // Also clears the accumulation
+        void Resize(uint32_t width, uint32_t height);
+        void Reset();
+    };
+
+    CpuPathTracer();
+    ~CpuPathTracer();
+
+    // Returns the material's index
+    uint32_t AddMaterial(const Material& material);
+
+    //
+    // Adds an instance of mesh. transform is object to world, the same
+    // transform the GPU samples put in the TLAS instance. Meshes without
+    // normals are shaded with their face normals.
+    //
+    void AddMesh(const TriMesh& mesh, const glm::mat4& transform, uint32_t materialIndex);
+    void AddSphere(const glm::vec3& center, float radius, uint32_t materialIndex);
+
+    // Only the base level of the environment map is used, the shaders sample LOD 0
+    void SetEnvironment(const IBLMaps& ibl);
+
+    // Must be called after the last AddMesh/AddSphere and before Render
+    void Build();
+
+    uint32_t GetNumTriangles() const { return static_cast<uint32_t>(mTriangles.size()); }
+    uint32_t GetNumSpheres() const { return static_cast<uint32_t>(mSpheres.size()); }
+
+    //
+    // Adds up to numSamples samples to each pixel of pImage, stopping
+    // pixels at options.MaxSamples. Calling it repeatedly continues
+    // the same sample sequence the GPU would have produced.
+    //
+    Stats Render(const Camera& camera, uint32_t numSamples, const Options& options, Image* pImage) const;
+
+    // Per pixel averages, Width * Height entries each
+    struct AOVs
+    {
+        std::vector<glm::vec3> Color  = {};
+        std::vector<glm::vec3> Albedo = {};
+        std::vector<glm::vec3> Normal = {}; // Renormalized
+        std::vector<float>     Depth  = {};
+    };
+
+    // Average radiance per pixel
+    static BitmapRGBA32f ResolveHDR(const Image& image);
+    // Average radiance and first hit features, the denoiser's inputs
+    static void          ResolveAOVs(const Image& image, AOVs* pAOVs);
+    // ACES tonemapped and gamma corrected, same as the samples' RenderTarget
+    static BitmapRGBA8u ResolveLDR(const Image& image);
+
+private:
+    struct Triangle
+    {
+        glm::vec3 P0;
+        glm::vec3 Edge1;
+        glm::vec3 Edge2;
+        glm::vec3 N0;
+        glm::vec3 N1;
+        glm::vec3 N2;
+        uint32_t  MaterialIndex;
+    };
+
+    struct Sphere
+    {
+        glm::vec3 Center;
+        float     Radius;
+        uint32_t  MaterialIndex;
+    };
+
+    // Interior nodes: Offset is the right child, the left child follows the node.
+    // Leaves: Count > 0, Offset is the index of the leaf's packet.
+    struct BvhNode
+    {
+        glm::vec3 BoundsMin;
+        uint32_t  Offset;
+        glm::vec3 BoundsMax;
+        uint32_t  Count;
+    };
+
+    struct SpherePacket
+    {
+        float    Center[3][4];
+        float    RadiusSq[4];
+        uint32_t Index[4];
+    };
+
+    struct Hit;
+    struct ThreadContext;
+
+    bool      Intersect(const glm::vec3& origin, const glm::vec3& dir, float tMin, float tMax, Hit* pHit) const;
+    glm::vec3 Trace(const glm::vec3& origin, const glm::vec3& dir, uint32_t depth, ThreadContext& ctx) const;
+    glm::vec3 GetEnvironment(const glm::vec3& dir) const;
+
+    std::vector<Material>     mMaterials         = {};
+    std::vector<Triangle>     mTriangles         = {};
+    std::vector<Sphere>       mSpheres           = {};
+    Bvh                       mTriangleBvh       = {};
+    std::vector<BvhNode>      mSphereNodes       = {};
+    std::vector<SpherePacket> mSpherePackets     = {};
+    std::vector<glm::vec3>    mEnvironment       = {};
+    uint32_t                  mEnvironmentWidth  = 0;
+    uint32_t                  mEnvironmentHeight = 0;
+    bool                      mBuilt             = false;
+};
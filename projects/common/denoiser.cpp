@@ -0,0 +1,759 @@
+#include "denoiser.h"
+#include "job_system.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define DENOISER_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+
+const float kAlbedoEpsilon    = 1e-3f;
+const float kDepthEpsilon     = 1e-2f; // Relative to the center pixel's depth
+const float kLuminanceEpsilon = 1e-6f;
+
+// 3x3 B-spline-ish kernel, (1/4, 1/2, 1/4) per axis
+const float kKernel[3]    = {0.25f, 0.5f, 0.25f};
+const float kCenterWeight = 0.25f;
+
+float Luminance(float r, float g, float b)
+{
+    return 0.2126f * r + 0.7152f * g + 0.0722f * b;
+}
+
+//
+// exp(x) for x <= 0, to about 1e-5 relative. Rounds to the nearest power
+// of 2 and evaluates 2^f for f in [-0.5, 0.5] with a degree 5 Taylor
+// series. The SSE2 version does exactly the same operations.
+//
+float ExpNegative(float x)
+{
+    float t = std::max(x, -80.0f) * 1.44269504f;
+    float i = static_cast<float>(lrintf(t));
+    float f = (t - i) * 0.69314718f;
+    float p = 1.0f + f * (1.0f + f * (0.5f + f * (1.0f / 6.0f + f * (1.0f / 24.0f + f * (1.0f / 120.0f)))));
+
+    int32_t bits = (static_cast<int32_t>(i) + 127) << 23;
+    float   scale;
+    memcpy(&scale, &bits, sizeof(scale));
+    return p * scale;
+}
+
+float PowInt(float x, uint32_t power)
+{
+    float result = 1.0f;
+    for (; power != 0; power >>= 1)
+    {
+        if (power & 1)
+        {
+            result *= x;
+        }
+        x *= x;
+    }
+    return result;
+}
+
+#if defined(DENOISER_SSE2)
+__m128 ExpNegative4(__m128 x)
+{
+    __m128  t = _mm_mul_ps(_mm_max_ps(x, _mm_set1_ps(-80.0f)), _mm_set1_ps(1.44269504f));
+    __m128i n = _mm_cvtps_epi32(t);
+    __m128  i = _mm_cvtepi32_ps(n);
+    __m128  f = _mm_mul_ps(_mm_sub_ps(t, i), _mm_set1_ps(0.69314718f));
+
+    __m128 p = _mm_add_ps(_mm_set1_ps(1.0f / 24.0f), _mm_mul_ps(f, _mm_set1_ps(1.0f / 120.0f)));
+    p        = _mm_add_ps(_mm_set1_ps(1.0f / 6.0f), _mm_mul_ps(f, p));
+    p        = _mm_add_ps(_mm_set1_ps(0.5f), _mm_mul_ps(f, p));
+    p        = _mm_add_ps(_mm_set1_ps(1.0f), _mm_mul_ps(f, p));
+    p        = _mm_add_ps(_mm_set1_ps(1.0f), _mm_mul_ps(f, p));
+
+    __m128 scale = _mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(n, _mm_set1_epi32(127)), 23));
+    return _mm_mul_ps(p, scale);
+}
+
+__m128 PowInt4(__m128 x, uint32_t power)
+{
+    __m128 result = _mm_set1_ps(1.0f);
+    for (; power != 0; power >>= 1)
+    {
+        if (power & 1)
+        {
+            result = _mm_mul_ps(result, x);
+        }
+        x = _mm_mul_ps(x, x);
+    }
+    return result;
+}
+
+__m128 Abs4(__m128 x)
+{
+    return _mm_and_ps(x, _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF)));
+}
+
+__m128 Select4(__m128 mask, __m128 a, __m128 b)
+{
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+#endif
+
+} // namespace
+
+// =============================================================================
+// Denoiser::Planes
+// =============================================================================
+//
+// Everything the passes read, one float per pixel per plane so 4
+// neighboring pixels are one unaligned load. Color, luminance and
+// variance ping-pong between the passes.
+//
+struct Denoiser::Planes
+{
+    uint32_t Width  = 0;
+    uint32_t Height = 0;
+
+    std::vector<float> R[2];
+    std::vector<float> G[2];
+    std::vector<float> B[2];
+    std::vector<float> L[2];
+    std::vector<float> Variance[2];
+    std::vector<float> Nx;
+    std::vector<float> Ny;
+    std::vector<float> Nz;
+    std::vector<float> Depth;
+    std::vector<float> GradX; // |dDepth/dx|, smaller of the two one sided differences
+    std::vector<float> GradY;
+    std::vector<float> InvSigma; // 1 / (ColorSigma * standard deviation), per pass
+
+    void Resize(uint32_t width, uint32_t height)
+    {
+        this->Width  = width;
+        this->Height = height;
+
+        const size_t numPixels = static_cast<size_t>(width) * height;
+        for (uint32_t i = 0; i < 2; ++i)
+        {
+            this->R[i].resize(numPixels);
+            this->G[i].resize(numPixels);
+            this->B[i].resize(numPixels);
+            this->L[i].resize(numPixels);
+            this->Variance[i].resize(numPixels);
+        }
+        this->Nx.resize(numPixels);
+        this->Ny.resize(numPixels);
+        this->Nz.resize(numPixels);
+        this->Depth.resize(numPixels);
+        this->GradX.resize(numPixels);
+        this->GradY.resize(numPixels);
+        this->InvSigma.resize(numPixels);
+    }
+};
+
+namespace
+{
+
+// What one a-trous pass reads and writes
+struct FilterPass
+{
+    const Denoiser::Options* pOptions = nullptr;
+    uint32_t                 Width    = 0;
+    uint32_t                 Height   = 0;
+    uint32_t                 Step     = 1;
+
+    const float* pSrcR        = nullptr;
+    const float* pSrcG        = nullptr;
+    const float* pSrcB        = nullptr;
+    const float* pSrcL        = nullptr;
+    const float* pSrcVariance = nullptr;
+    float*       pDstR        = nullptr;
+    float*       pDstG        = nullptr;
+    float*       pDstB        = nullptr;
+    float*       pDstL        = nullptr;
+    float*       pDstVariance = nullptr;
+
+    const float* pNx       = nullptr;
+    const float* pNy       = nullptr;
+    const float* pNz       = nullptr;
+    const float* pDepth    = nullptr;
+    const float* pGradX    = nullptr;
+    const float* pGradY    = nullptr;
+    const float* pInvSigma = nullptr;
+};
+
+//
+// Edge stopping weight of tap q for center p without the kernel weight.
+// invSigma = 0 drops the luminance term.
+//
+float TapWeight(const FilterPass& pass, uint32_t p, uint32_t q, int dx, int dy, float invSigma)
+{
+    const float zp = pass.pDepth[p];
+    const float zq = pass.pDepth[q];
+    if (zq <= 0)
+    {
+        return 0;
+    }
+
+    float depthScale = pass.pOptions->DepthSigma * pass.Step * (pass.pGradX[p] * abs(dx) + pass.pGradY[p] * abs(dy));
+    float depthTerm  = fabsf(zp - zq) / std::max(depthScale + kDepthEpsilon * zp, FLT_MIN);
+    float lumTerm    = fabsf(pass.pSrcL[p] - pass.pSrcL[q]) * invSigma;
+
+    float cosAngle = pass.pNx[p] * pass.pNx[q] + pass.pNy[p] * pass.pNy[q] + pass.pNz[p] * pass.pNz[q];
+    return ExpNegative(-(depthTerm + lumTerm)) * PowInt(std::max(cosAngle, 0.0f), pass.pOptions->NormalPower);
+}
+
+// =============================================================================
+// Variance estimate: luminance moments over the 3x3 neighborhood
+// =============================================================================
+void EstimateVariance(const FilterPass& pass, uint32_t x, uint32_t y)
+{
+    const uint32_t p = y * pass.Width + x;
+    if (pass.pDepth[p] <= 0)
+    {
+        pass.pDstVariance[p] = 0;
+        return;
+    }
+
+    float sumW  = kCenterWeight;
+    float sumL  = kCenterWeight * pass.pSrcL[p];
+    float sumL2 = kCenterWeight * pass.pSrcL[p] * pass.pSrcL[p];
+    for (int dy = -1; dy <= 1; ++dy)
+    {
+        for (int dx = -1; dx <= 1; ++dx)
+        {
+            int qx = static_cast<int>(x) + dx;
+            int qy = static_cast<int>(y) + dy;
+            if (((dx == 0) && (dy == 0)) || (qx < 0) || (qy < 0) || (qx >= static_cast<int>(pass.Width)) || (qy >= static_cast<int>(pass.Height)))
+            {
+                continue;
+            }
+
+            uint32_t q = static_cast<uint32_t>(qy) * pass.Width + static_cast<uint32_t>(qx);
+            float    w = kKernel[dx + 1] * kKernel[dy + 1] * TapWeight(pass, p, q, dx, dy, 0);
+            sumW += w;
+            sumL += w * pass.pSrcL[q];
+            sumL2 += w * pass.pSrcL[q] * pass.pSrcL[q];
+        }
+    }
+
+    float mean           = sumL / sumW;
+    pass.pDstVariance[p] = std::max(sumL2 / sumW - mean * mean, 0.0f);
+}
+
+// =============================================================================
+// Variance prefilter: 3x3 Gaussian, gives the luminance tolerance of a pass
+// =============================================================================
+void ComputeInvSigma(const FilterPass& pass, uint32_t x, uint32_t y, float* pInvSigma)
+{
+    const uint32_t p = y * pass.Width + x;
+
+    float sumW = 0;
+    float sumV = 0;
+    for (int dy = -1; dy <= 1; ++dy)
+    {
+        for (int dx = -1; dx <= 1; ++dx)
+        {
+            int qx = static_cast<int>(x) + dx;
+            int qy = static_cast<int>(y) + dy;
+            if ((qx < 0) || (qy < 0) || (qx >= static_cast<int>(pass.Width)) || (qy >= static_cast<int>(pass.Height)))
+            {
+                continue;
+            }
+
+            uint32_t q = static_cast<uint32_t>(qy) * pass.Width + static_cast<uint32_t>(qx);
+            float    w = (pass.pDepth[q] > 0) ? (kKernel[dx + 1] * kKernel[dy + 1]) : 0.0f;
+            sumW += w;
+            sumV += w * pass.pSrcVariance[q];
+        }
+    }
+
+    float variance = (sumW > 0) ? (sumV / sumW) : 0.0f;
+    pInvSigma[p]   = 1.0f / (pass.pOptions->ColorSigma * sqrtf(variance) + kLuminanceEpsilon);
+}
+
+// =============================================================================
+// A-trous pass
+// =============================================================================
+void FilterPixel(const FilterPass& pass, uint32_t x, uint32_t y)
+{
+    const uint32_t p = y * pass.Width + x;
+    if (pass.pDepth[p] <= 0)
+    {
+        pass.pDstR[p]        = pass.pSrcR[p];
+        pass.pDstG[p]        = pass.pSrcG[p];
+        pass.pDstB[p]        = pass.pSrcB[p];
+        pass.pDstL[p]        = pass.pSrcL[p];
+        pass.pDstVariance[p] = pass.pSrcVariance[p];
+        return;
+    }
+
+    const float invSigma = pass.pInvSigma[p];
+    const int   step     = static_cast<int>(pass.Step);
+
+    float sumW = kCenterWeight;
+    float sumR = kCenterWeight * pass.pSrcR[p];
+    float sumG = kCenterWeight * pass.pSrcG[p];
+    float sumB = kCenterWeight * pass.pSrcB[p];
+    float sumV = kCenterWeight * kCenterWeight * pass.pSrcVariance[p];
+    for (int dy = -1; dy <= 1; ++dy)
+    {
+        int qy = static_cast<int>(y) + dy * step;
+        if ((qy < 0) || (qy >= static_cast<int>(pass.Height)))
+        {
+            continue;
+        }
+
+        for (int dx = -1; dx <= 1; ++dx)
+        {
+            int qx = static_cast<int>(x) + dx * step;
+            if (((dx == 0) && (dy == 0)) || (qx < 0) || (qx >= static_cast<int>(pass.Width)))
+            {
+                continue;
+            }
+
+            uint32_t q = static_cast<uint32_t>(qy) * pass.Width + static_cast<uint32_t>(qx);
+            float    w = kKernel[dx + 1] * kKernel[dy + 1] * TapWeight(pass, p, q, dx, dy, invSigma);
+            sumW += w;
+            sumR += w * pass.pSrcR[q];
+            sumG += w * pass.pSrcG[q];
+            sumB += w * pass.pSrcB[q];
+            sumV += w * w * pass.pSrcVariance[q];
+        }
+    }
+
+    float invSumW        = 1.0f / sumW;
+    pass.pDstR[p]        = sumR * invSumW;
+    pass.pDstG[p]        = sumG * invSumW;
+    pass.pDstB[p]        = sumB * invSumW;
+    pass.pDstL[p]        = Luminance(pass.pDstR[p], pass.pDstG[p], pass.pDstB[p]);
+    pass.pDstVariance[p] = sumV * invSumW * invSumW;
+}
+
+#if defined(DENOISER_SSE2)
+//
+// 4 pixels starting at x, the caller makes sure every tap column is in
+// bounds. Same math as the scalar functions above, lane by lane.
+//
+struct Center4
+{
+    __m128 Valid;
+    __m128 Z;
+    __m128 GradX;
+    __m128 GradY;
+    __m128 Nx;
+    __m128 Ny;
+    __m128 Nz;
+    __m128 L;
+};
+
+Center4 LoadCenter4(const FilterPass& pass, uint32_t p)
+{
+    Center4 c = {};
+    c.Z       = _mm_loadu_ps(pass.pDepth + p);
+    c.Valid   = _mm_cmpgt_ps(c.Z, _mm_setzero_ps());
+    c.GradX   = _mm_loadu_ps(pass.pGradX + p);
+    c.GradY   = _mm_loadu_ps(pass.pGradY + p);
+    c.Nx      = _mm_loadu_ps(pass.pNx + p);
+    c.Ny      = _mm_loadu_ps(pass.pNy + p);
+    c.Nz      = _mm_loadu_ps(pass.pNz + p);
+    c.L       = _mm_loadu_ps(pass.pSrcL + p);
+    return c;
+}
+
+__m128 TapWeight4(const FilterPass& pass, const Center4& c, uint32_t q, int dx, int dy, __m128 invSigma)
+{
+    __m128 zq     = _mm_loadu_ps(pass.pDepth + q);
+    __m128 validQ = _mm_cmpgt_ps(zq, _mm_setzero_ps());
+
+    __m128 depthScale = _mm_add_ps(_mm_mul_ps(c.GradX, _mm_set1_ps(static_cast<float>(abs(dx)))), _mm_mul_ps(c.GradY, _mm_set1_ps(static_cast<float>(abs(dy)))));
+    depthScale        = _mm_mul_ps(depthScale, _mm_set1_ps(pass.pOptions->DepthSigma * pass.Step));
+    depthScale        = _mm_max_ps(_mm_add_ps(depthScale, _mm_mul_ps(c.Z, _mm_set1_ps(kDepthEpsilon))), _mm_set1_ps(FLT_MIN));
+    __m128 depthTerm  = _mm_div_ps(Abs4(_mm_sub_ps(c.Z, zq)), depthScale);
+    __m128 lumTerm    = _mm_mul_ps(Abs4(_mm_sub_ps(c.L, _mm_loadu_ps(pass.pSrcL + q))), invSigma);
+
+    __m128 cosAngle = _mm_mul_ps(c.Nx, _mm_loadu_ps(pass.pNx + q));
+    cosAngle        = _mm_add_ps(cosAngle, _mm_mul_ps(c.Ny, _mm_loadu_ps(pass.pNy + q)));
+    cosAngle        = _mm_add_ps(cosAngle, _mm_mul_ps(c.Nz, _mm_loadu_ps(pass.pNz + q)));
+
+    __m128 w = ExpNegative4(_mm_sub_ps(_mm_setzero_ps(), _mm_add_ps(depthTerm, lumTerm)));
+    w        = _mm_mul_ps(w, PowInt4(_mm_max_ps(cosAngle, _mm_setzero_ps()), pass.pOptions->NormalPower));
+    return _mm_and_ps(validQ, w);
+}
+
+void EstimateVariance4(const FilterPass& pass, uint32_t x, uint32_t y)
+{
+    const uint32_t p = y * pass.Width + x;
+    const Center4  c = LoadCenter4(pass, p);
+
+    __m128 sumW  = _mm_set1_ps(kCenterWeight);
+    __m128 sumL  = _mm_mul_ps(sumW, c.L);
+    __m128 sumL2 = _mm_mul_ps(sumL, c.L);
+    for (int dy = -1; dy <= 1; ++dy)
+    {
+        int qy = static_cast<int>(y) + dy;
+        if ((qy < 0) || (qy >= static_cast<int>(pass.Height)))
+        {
+            continue;
+        }
+
+        for (int dx = -1; dx <= 1; ++dx)
+        {
+            if ((dx == 0) && (dy == 0))
+            {
+                continue;
+            }
+
+            uint32_t q  = static_cast<uint32_t>(qy) * pass.Width + x + dx;
+            __m128   w  = _mm_mul_ps(_mm_set1_ps(kKernel[dx + 1] * kKernel[dy + 1]), TapWeight4(pass, c, q, dx, dy, _mm_setzero_ps()));
+            __m128   lq = _mm_loadu_ps(pass.pSrcL + q);
+            __m128   wl = _mm_mul_ps(w, lq);
+            sumW        = _mm_add_ps(sumW, w);
+            sumL        = _mm_add_ps(sumL, wl);
+            sumL2       = _mm_add_ps(sumL2, _mm_mul_ps(wl, lq));
+        }
+    }
+
+    __m128 mean     = _mm_div_ps(sumL, sumW);
+    __m128 variance = _mm_max_ps(_mm_sub_ps(_mm_div_ps(sumL2, sumW), _mm_mul_ps(mean, mean)), _mm_setzero_ps());
+    _mm_storeu_ps(pass.pDstVariance + p, _mm_and_ps(c.Valid, variance));
+}
+
+void ComputeInvSigma4(const FilterPass& pass, uint32_t x, uint32_t y, float* pInvSigma)
+{
+    const uint32_t p = y * pass.Width + x;
+
+    __m128 sumW = _mm_setzero_ps();
+    __m128 sumV = _mm_setzero_ps();
+    for (int dy = -1; dy <= 1; ++dy)
+    {
+        int qy = static_cast<int>(y) + dy;
+        if ((qy < 0) || (qy >= static_cast<int>(pass.Height)))
+        {
+            continue;
+        }
+
+        for (int dx = -1; dx <= 1; ++dx)
+        {
+            uint32_t q     = static_cast<uint32_t>(qy) * pass.Width + x + dx;
+            __m128   valid = _mm_cmpgt_ps(_mm_loadu_ps(pass.pDepth + q), _mm_setzero_ps());
+            __m128   w     = _mm_and_ps(valid, _mm_set1_ps(kKernel[dx + 1] * kKernel[dy + 1]));
+            sumW           = _mm_add_ps(sumW, w);
+            sumV           = _mm_add_ps(sumV, _mm_mul_ps(w, _mm_loadu_ps(pass.pSrcVariance + q)));
+        }
+    }
+
+    __m128 hasWeight = _mm_cmpgt_ps(sumW, _mm_setzero_ps());
+    __m128 variance  = _mm_and_ps(hasWeight, _mm_div_ps(sumV, _mm_max_ps(sumW, _mm_set1_ps(FLT_MIN))));
+    __m128 sigma     = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(pass.pOptions->ColorSigma), _mm_sqrt_ps(variance)), _mm_set1_ps(kLuminanceEpsilon));
+    _mm_storeu_ps(pInvSigma + p, _mm_div_ps(_mm_set1_ps(1.0f), sigma));
+}
+
+void FilterPixels4(const FilterPass& pass, uint32_t x, uint32_t y)
+{
+    const uint32_t p        = y * pass.Width + x;
+    const Center4  c        = LoadCenter4(pass, p);
+    const __m128   invSigma = _mm_loadu_ps(pass.pInvSigma + p);
+    const int      step     = static_cast<int>(pass.Step);
+
+    const __m128 srcR = _mm_loadu_ps(pass.pSrcR + p);
+    const __m128 srcG = _mm_loadu_ps(pass.pSrcG + p);
+    const __m128 srcB = _mm_loadu_ps(pass.pSrcB + p);
+    const __m128 srcV = _mm_loadu_ps(pass.pSrcVariance + p);
+
+    __m128 sumW = _mm_set1_ps(kCenterWeight);
+    __m128 sumR = _mm_mul_ps(sumW, srcR);
+    __m128 sumG = _mm_mul_ps(sumW, srcG);
+    __m128 sumB = _mm_mul_ps(sumW, srcB);
+    __m128 sumV = _mm_mul_ps(_mm_mul_ps(sumW, sumW), srcV);
+    for (int dy = -1; dy <= 1; ++dy)
+    {
+        int qy = static_cast<int>(y) + dy * step;
+        if ((qy < 0) || (qy >= static_cast<int>(pass.Height)))
+        {
+            continue;
+        }
+
+        for (int dx = -1; dx <= 1; ++dx)
+        {
+            if ((dx == 0) && (dy == 0))
+            {
+                continue;
+            }
+
+            uint32_t q = static_cast<uint32_t>(static_cast<int>(qy * pass.Width + x) + dx * step);
+            __m128   w = _mm_mul_ps(_mm_set1_ps(kKernel[dx + 1] * kKernel[dy + 1]), TapWeight4(pass, c, q, dx, dy, invSigma));
+            sumW       = _mm_add_ps(sumW, w);
+            sumR       = _mm_add_ps(sumR, _mm_mul_ps(w, _mm_loadu_ps(pass.pSrcR + q)));
+            sumG       = _mm_add_ps(sumG, _mm_mul_ps(w, _mm_loadu_ps(pass.pSrcG + q)));
+            sumB       = _mm_add_ps(sumB, _mm_mul_ps(w, _mm_loadu_ps(pass.pSrcB + q)));
+            sumV       = _mm_add_ps(sumV, _mm_mul_ps(_mm_mul_ps(w, w), _mm_loadu_ps(pass.pSrcVariance + q)));
+        }
+    }
+
+    __m128 invSumW = _mm_div_ps(_mm_set1_ps(1.0f), sumW);
+    __m128 r       = _mm_mul_ps(sumR, invSumW);
+    __m128 g       = _mm_mul_ps(sumG, invSumW);
+    __m128 b       = _mm_mul_ps(sumB, invSumW);
+    __m128 l       = _mm_add_ps(_mm_add_ps(_mm_mul_ps(r, _mm_set1_ps(0.2126f)), _mm_mul_ps(g, _mm_set1_ps(0.7152f))), _mm_mul_ps(b, _mm_set1_ps(0.0722f)));
+    __m128 v       = _mm_mul_ps(_mm_mul_ps(sumV, invSumW), invSumW);
+
+    // Misses pass through
+    _mm_storeu_ps(pass.pDstR + p, Select4(c.Valid, r, srcR));
+    _mm_storeu_ps(pass.pDstG + p, Select4(c.Valid, g, srcG));
+    _mm_storeu_ps(pass.pDstB + p, Select4(c.Valid, b, srcB));
+    _mm_storeu_ps(pass.pDstL + p, Select4(c.Valid, l, c.L));
+    _mm_storeu_ps(pass.pDstVariance + p, Select4(c.Valid, v, srcV));
+}
+#endif
+
+// =============================================================================
+// Rows
+// =============================================================================
+//
+// Pixels whose taps, radius columns away, might fall outside the image go
+// through the scalar functions, the rest 4 at a time.
+//
+void EstimateVarianceRow(const FilterPass& pass, uint32_t y)
+{
+    uint32_t x = 0;
+#if defined(DENOISER_SSE2)
+    for (; (x < pass.Width) && (x < 1); ++x)
+    {
+        EstimateVariance(pass, x, y);
+    }
+    for (; (x + 4) < pass.Width; x += 4)
+    {
+        EstimateVariance4(pass, x, y);
+    }
+#endif
+    for (; x < pass.Width; ++x)
+    {
+        EstimateVariance(pass, x, y);
+    }
+}
+
+void ComputeInvSigmaRow(const FilterPass& pass, uint32_t y, float* pInvSigma)
+{
+    uint32_t x = 0;
+#if defined(DENOISER_SSE2)
+    for (; (x < pass.Width) && (x < 1); ++x)
+    {
+        ComputeInvSigma(pass, x, y, pInvSigma);
+    }
+    for (; (x + 4) < pass.Width; x += 4)
+    {
+        ComputeInvSigma4(pass, x, y, pInvSigma);
+    }
+#endif
+    for (; x < pass.Width; ++x)
+    {
+        ComputeInvSigma(pass, x, y, pInvSigma);
+    }
+}
+
+void FilterRow(const FilterPass& pass, uint32_t y)
+{
+    uint32_t x = 0;
+#if defined(DENOISER_SSE2)
+    for (; (x < pass.Width) && (x < pass.Step); ++x)
+    {
+        FilterPixel(pass, x, y);
+    }
+    for (; (x + 3 + pass.Step) < pass.Width; x += 4)
+    {
+        FilterPixels4(pass, x, y);
+    }
+#endif
+    for (; x < pass.Width; ++x)
+    {
+        FilterPixel(pass, x, y);
+    }
+}
+
+} // namespace
+
+// =============================================================================
+// Denoiser
+// =============================================================================
+Denoiser::Denoiser()
+    : mPlanes(std::make_unique<Planes>())
+{
+}
+
+Denoiser::~Denoiser()
+{
+}
+
+Denoiser::Stats Denoiser::Denoise(const Inputs& inputs, const Options& options, glm::vec3* pOutput)
+{
+    if ((inputs.Width == 0) || (inputs.Height == 0) || IsNull(inputs.pColor) || IsNull(inputs.pNormal) || IsNull(inputs.pDepth) || IsNull(pOutput))
+    {
+        return {};
+    }
+    if (reinterpret_cast<const void*>(pOutput) == reinterpret_cast<const void*>(inputs.pColor))
+    {
+        assert(false && "output may not alias the color input");
+        return {};
+    }
+
+    auto startTime = std::chrono::high_resolution_clock::now();
+
+    const uint32_t width  = inputs.Width;
+    const uint32_t height = inputs.Height;
+
+    Planes& planes = *mPlanes;
+    if ((planes.Width != width) || (planes.Height != height))
+    {
+        planes.Resize(width, height);
+    }
+
+    uint32_t numThreads = options.NumThreads;
+    if (numThreads == 0)
+    {
+        numThreads = JobSystem::Get().GetNumThreads();
+    }
+    numThreads = std::min(numThreads, height);
+
+    //
+    // Each pass reads neighbors the previous pass wrote, so every pass is
+    // its own ParallelFor() over rows, which returns once all rows are done.
+    //
+    auto forEachRows = [&](const JobSystem::RangeFn& fn) { JobSystem::Get().ParallelFor(0, height, 0, fn, numThreads); };
+
+    // Demodulate, copy features
+    forEachRows([&](uint32_t y0, uint32_t y1) {
+        for (uint32_t y = y0; y < y1; ++y)
+        {
+            for (uint32_t x = 0; x < width; ++x)
+            {
+                const uint32_t i     = y * width + x;
+                glm::vec3      color = inputs.pColor[i];
+                if (!IsNull(inputs.pAlbedo) && (inputs.pDepth[i] > 0))
+                {
+                    color /= glm::max(inputs.pAlbedo[i], glm::vec3(kAlbedoEpsilon));
+                }
+
+                planes.R[0][i]     = color.r;
+                planes.G[0][i]     = color.g;
+                planes.B[0][i]     = color.b;
+                planes.L[0][i]     = Luminance(color.r, color.g, color.b);
+                planes.Nx[i]       = inputs.pNormal[i].x;
+                planes.Ny[i]       = inputs.pNormal[i].y;
+                planes.Nz[i]       = inputs.pNormal[i].z;
+                planes.Depth[i]    = inputs.pDepth[i];
+                planes.GradX[i]    = 0;
+                planes.GradY[i]    = 0;
+                const float center = inputs.pDepth[i];
+                if (center <= 0)
+                {
+                    continue;
+                }
+
+                // One sided differences are robust at silhouettes, take the smaller, ignore misses
+                float gradX = FLT_MAX;
+                float gradY = FLT_MAX;
+                if ((x > 0) && (inputs.pDepth[i - 1] > 0))
+                {
+                    gradX = std::min(gradX, fabsf(center - inputs.pDepth[i - 1]));
+                }
+                if (((x + 1) < width) && (inputs.pDepth[i + 1] > 0))
+                {
+                    gradX = std::min(gradX, fabsf(center - inputs.pDepth[i + 1]));
+                }
+                if ((y > 0) && (inputs.pDepth[i - width] > 0))
+                {
+                    gradY = std::min(gradY, fabsf(center - inputs.pDepth[i - width]));
+                }
+                if (((y + 1) < height) && (inputs.pDepth[i + width] > 0))
+                {
+                    gradY = std::min(gradY, fabsf(center - inputs.pDepth[i + width]));
+                }
+                planes.GradX[i] = (gradX < FLT_MAX) ? gradX : 0.0f;
+                planes.GradY[i] = (gradY < FLT_MAX) ? gradY : 0.0f;
+            }
+        }
+    });
+
+    FilterPass pass = {};
+    pass.pOptions   = &options;
+    pass.Width      = width;
+    pass.Height     = height;
+    pass.pNx        = DataPtr(planes.Nx);
+    pass.pNy        = DataPtr(planes.Ny);
+    pass.pNz        = DataPtr(planes.Nz);
+    pass.pDepth     = DataPtr(planes.Depth);
+    pass.pGradX     = DataPtr(planes.GradX);
+    pass.pGradY     = DataPtr(planes.GradY);
+    pass.pInvSigma  = DataPtr(planes.InvSigma);
+
+    // Initial variance
+    pass.pSrcL        = DataPtr(planes.L[0]);
+    pass.pDstVariance = DataPtr(planes.Variance[0]);
+    forEachRows([&](uint32_t y0, uint32_t y1) {
+        for (uint32_t y = y0; y < y1; ++y)
+        {
+            EstimateVarianceRow(pass, y);
+        }
+    });
+
+    for (uint32_t iteration = 0; iteration < options.NumIterations; ++iteration)
+    {
+        const uint32_t src = iteration & 1;
+        const uint32_t dst = src ^ 1;
+
+        pass.Step         = 1u << iteration;
+        pass.pSrcR        = DataPtr(planes.R[src]);
+        pass.pSrcG        = DataPtr(planes.G[src]);
+        pass.pSrcB        = DataPtr(planes.B[src]);
+        pass.pSrcL        = DataPtr(planes.L[src]);
+        pass.pSrcVariance = DataPtr(planes.Variance[src]);
+        pass.pDstR        = DataPtr(planes.R[dst]);
+        pass.pDstG        = DataPtr(planes.G[dst]);
+        pass.pDstB        = DataPtr(planes.B[dst]);
+        pass.pDstL        = DataPtr(planes.L[dst]);
+        pass.pDstVariance = DataPtr(planes.Variance[dst]);
+
+        forEachRows([&](uint32_t y0, uint32_t y1) {
+            for (uint32_t y = y0; y < y1; ++y)
+            {
+                ComputeInvSigmaRow(pass, y, DataPtr(planes.InvSigma));
+            }
+        });
+
+        forEachRows([&](uint32_t y0, uint32_t y1) {
+            for (uint32_t y = y0; y < y1; ++y)
+            {
+                FilterRow(pass, y);
+            }
+        });
+    }
+
+    // Remodulate
+    const uint32_t result = options.NumIterations & 1;
+    forEachRows([&](uint32_t y0, uint32_t y1) {
+        for (uint32_t y = y0; y < y1; ++y)
+        {
+            for (uint32_t x = 0; x < width; ++x)
+            {
+                const uint32_t i     = y * width + x;
+                glm::vec3      color = glm::vec3(planes.R[result][i], planes.G[result][i], planes.B[result][i]);
+                if (!IsNull(inputs.pAlbedo) && (inputs.pDepth[i] > 0))
+                {
+                    color *= glm::max(inputs.pAlbedo[i], glm::vec3(kAlbedoEpsilon));
+                }
+                pOutput[i] = color;
+            }
+        }
+    });
+
+    auto endTime = std::chrono::high_resolution_clock::now();
+
+    Stats stats      = {};
+    stats.ElapsedMs  = std::chrono::duration<double, std::milli>(endTime - startTime).count();
+    stats.NumThreads = numThreads;
+
+    return stats;
+}
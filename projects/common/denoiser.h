@@ -0,0 +1,73 @@
+#pragma once
+
+#include "config.h"
+
+#include <glm/glm.hpp>
+
+//
+// Edge aware a-trous denoiser for path traced images
+//
+// A spatial version of SVGF [Schied et al. 2017] without the temporal
+// part, since the inputs are already accumulated:
+//
+//   1. Divide the color by the first hit albedo, so texture detail isn't
+//      blurred away along with the noise and gets multiplied back at the
+//      end.
+//   2. Estimate each pixel's luminance variance from its neighbors,
+//      weighted by the same normal and depth terms as the filter.
+//   3. Run NumIterations passes of a 3x3 a-trous wavelet filter with the
+//      tap spacing doubling every pass. Taps are weighted by normal
+//      similarity, depth difference relative to the local depth gradient
+//      and luminance difference relative to the standard deviation, so
+//      the filter stops at edges and backs off where the image is clean.
+//      The variance is filtered along with the color.
+//
+// SVGF uses a 5x5 kernel, the 3x3 one costs 9 taps instead of 25 per pass
+// for nearly the same result once the passes add up.
+//
+// Pixels with depth 0, misses, are passed through and never used as taps.
+//
+// Rows are split across the job system, 4 pixels at a time go through SSE2.
+// Scratch buffers are kept between calls, denoising same sized frames
+// doesn't allocate.
+//
+class Denoiser
+{
+public:
+    struct Options
+    {
+        uint32_t NumIterations = 5;    // Footprint is 2^(NumIterations + 1) - 1 pixels wide
+        float    ColorSigma    = 4.0f; // Luminance tolerance in standard deviations
+        uint32_t NormalPower   = 128;  // dot(n0, n1)^NormalPower
+        float    DepthSigma    = 1.0f; // Depth tolerance relative to the depth gradient
+        uint32_t NumThreads    = 0;    // Cap on job system threads, 0 uses them all
+    };
+
+    // Width * Height entries each, row major
+    struct Inputs
+    {
+        uint32_t         Width   = 0;
+        uint32_t         Height  = 0;
+        const glm::vec3* pColor  = nullptr; // Average radiance
+        const glm::vec3* pAlbedo = nullptr; // First hit albedo, null skips demodulation
+        const glm::vec3* pNormal = nullptr; // First hit normal
+        const float*     pDepth  = nullptr; // First hit distance, 0 for misses
+    };
+
+    struct Stats
+    {
+        double   ElapsedMs  = 0;
+        uint32_t NumThreads = 0;
+    };
+
+    Denoiser();
+    ~Denoiser();
+
+    // pOutput has Width * Height entries and may not alias pColor
+    Stats Denoise(const Inputs& inputs, const Options& options, glm::vec3* pOutput);
+
+private:
+    struct Planes;
+
+    std::unique_ptr<Planes> mPlanes;
+};
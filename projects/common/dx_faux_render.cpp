@@ -9,6 +9,12 @@ using namespace glm;
 namespace DxFauxRender
 {
 
+static UINT GetBatchViews(
+    const DxFauxRender::Buffer*       pBuffer,
+    const FauxRender::PrimitiveBatch& batch,
+    D3D12_INDEX_BUFFER_VIEW*          pIndexView,
+    D3D12_VERTEX_BUFFER_VIEW          vertexViews[GREX_MAX_VERTEX_ATTRIBUTES]);
+
 bool Buffer::Map(void** ppData)
 {
     if (!this->Mappable)
@@ -44,6 +50,93 @@ SceneGraph::SceneGraph(DxRenderer* pTheRenderer)
     this->InitializeDefaults();
 }
 
+bool SceneGraph::CreateDrawListCommandSignature(ID3D12RootSignature* pRootSignature)
+{
+    if (IsNull(pRootSignature) || (this->RootParameterIndices.Draw == UINT32_MAX))
+    {
+        return false;
+    }
+
+    // Argument order and sizes match DrawListCommand
+    std::vector<D3D12_INDIRECT_ARGUMENT_DESC> argDescs;
+    {
+        D3D12_INDIRECT_ARGUMENT_DESC argDesc     = {};
+        argDesc.Type                             = D3D12_INDIRECT_ARGUMENT_TYPE_CONSTANT;
+        argDesc.Constant.RootParameterIndex      = this->RootParameterIndices.Draw;
+        argDesc.Constant.DestOffsetIn32BitValues = 0;
+        argDesc.Constant.Num32BitValuesToSet     = sizeof(FauxRender::Shader::DrawParams) / sizeof(uint32_t);
+        argDescs.push_back(argDesc);
+    }
+    {
+        D3D12_INDIRECT_ARGUMENT_DESC argDesc = {};
+        argDesc.Type                         = D3D12_INDIRECT_ARGUMENT_TYPE_INDEX_BUFFER_VIEW;
+        argDescs.push_back(argDesc);
+    }
+    for (UINT slot = 0; slot < GREX_MAX_VERTEX_ATTRIBUTES; ++slot)
+    {
+        D3D12_INDIRECT_ARGUMENT_DESC argDesc = {};
+        argDesc.Type                         = D3D12_INDIRECT_ARGUMENT_TYPE_VERTEX_BUFFER_VIEW;
+        argDesc.VertexBuffer.Slot            = slot;
+        argDescs.push_back(argDesc);
+    }
+    {
+        D3D12_INDIRECT_ARGUMENT_DESC argDesc = {};
+        argDesc.Type                         = D3D12_INDIRECT_ARGUMENT_TYPE_DRAW_INDEXED;
+        argDescs.push_back(argDesc);
+    }
+
+    D3D12_COMMAND_SIGNATURE_DESC desc = {};
+    desc.ByteStride                   = sizeof(DxFauxRender::DrawListCommand);
+    desc.NumArgumentDescs             = CountU32(argDescs);
+    desc.pArgumentDescs               = DataPtr(argDescs);
+    desc.NodeMask                     = 0;
+
+    HRESULT hr = this->pRenderer->Device->CreateCommandSignature(&desc, pRootSignature, IID_PPV_ARGS(&this->DrawListCommandSignature));
+    if (FAILED(hr))
+    {
+        assert(false && "CreateCommandSignature failed");
+        return false;
+    }
+
+    return true;
+}
+
+bool SceneGraph::CreateDrawListArgsBuffer(
+    const FauxRender::DrawList* pDrawList,
+    FauxRender::Buffer**        ppBuffer)
+{
+    std::vector<DxFauxRender::DrawListCommand> commands;
+    for (size_t drawIdx = 0; drawIdx < pDrawList->Draws.size(); ++drawIdx)
+    {
+        const auto& draw  = pDrawList->Draws[drawIdx];
+        const auto& batch = draw.pMesh->DrawBatches[draw.BatchIndex];
+        const auto& args  = pDrawList->IndirectArgs[drawIdx];
+
+        DxFauxRender::DrawListCommand command = {};
+        command.DrawParams.InstanceIndex      = draw.FirstInstance;
+        command.DrawParams.MaterialIndex      = draw.MaterialIndex;
+
+        GetBatchViews(DxFauxRender::Cast(draw.pBuffer), batch, &command.IndexBufferView, command.VertexBufferViews);
+
+        command.DrawArguments.IndexCountPerInstance = args.IndexCount;
+        command.DrawArguments.InstanceCount         = args.InstanceCount;
+        command.DrawArguments.StartIndexLocation    = args.FirstIndex;
+        command.DrawArguments.BaseVertexLocation    = args.BaseVertex;
+        command.DrawArguments.StartInstanceLocation = args.FirstInstance;
+
+        commands.push_back(command);
+    }
+
+    const uint32_t bufferSize = static_cast<uint32_t>(SizeInBytes(commands));
+
+    return this->CreateBuffer(
+        bufferSize,        // bufferSize
+        bufferSize,        // srcSize
+        DataPtr(commands), // pSrcData
+        true,              // mappable
+        ppBuffer);         // ppBuffer
+}
+
 bool SceneGraph::CreateTemporaryBuffer(
     uint32_t             size,
     const void*          pData,
@@ -211,6 +304,12 @@ bool SceneGraph::CreateImage(
         return false;
     }
 
+    // Fail before the resource is created if there's no slot for the image
+    if (this->IsImageTableFull())
+    {
+        return false;
+    }
+
     // Create the buffer resource
     ComPtr<ID3D12Resource> resource;
     //
@@ -244,7 +343,11 @@ bool SceneGraph::CreateImage(
     pImage->Resource  = resource;
 
     // Store image in the graph
-    this->Images.push_back(std::move(std::unique_ptr<FauxRender::Image>(pImage)));
+    if (!this->AddImage(pImage))
+    {
+        delete pImage;
+        return false;
+    }
 
     // Write output pointer
     *ppImage = pImage;
@@ -266,6 +369,12 @@ bool SceneGraph::CreateImage(
         return false;
     }
 
+    // Fail before the resource is created if there's no slot for the image
+    if (this->IsImageTableFull())
+    {
+        return false;
+    }
+
     auto dxFormat = ToDxFormat(format);
     if (dxFormat == DXGI_FORMAT_UNKNOWN)
     {
@@ -306,7 +415,11 @@ bool SceneGraph::CreateImage(
     pImage->Resource  = resource;
 
     // Store image in the graph
-    this->Images.push_back(std::move(std::unique_ptr<FauxRender::Image>(pImage)));
+    if (!this->AddImage(pImage))
+    {
+        delete pImage;
+        return false;
+    }
 
     // Write output pointer
     *ppImage = pImage;
@@ -327,15 +440,114 @@ DxFauxRender::Image* Cast(FauxRender::Image* pImage)
     return static_cast<DxFauxRender::Image*>(pImage);
 }
 
+// Returns the number of vertex buffer views written to pVertexViews
+static UINT GetBatchViews(
+    const DxFauxRender::Buffer*       pBuffer,
+    const FauxRender::PrimitiveBatch& batch,
+    D3D12_INDEX_BUFFER_VIEW*          pIndexView,
+    D3D12_VERTEX_BUFFER_VIEW          vertexViews[GREX_MAX_VERTEX_ATTRIBUTES])
+{
+    // Buffer VA
+    D3D12_GPU_VIRTUAL_ADDRESS bufferStart = pBuffer->Resource->GetGPUVirtualAddress();
+
+    // Index buffer
+    pIndexView->BufferLocation = static_cast<D3D12_GPU_VIRTUAL_ADDRESS>(bufferStart + batch.IndexBufferView.Offset);
+    pIndexView->SizeInBytes    = static_cast<UINT>(batch.IndexBufferView.Size);
+    pIndexView->Format         = ToDxFormat(batch.IndexBufferView.Format);
+
+    // Vertex buffers: position, tex coord, normal, tangent
+    const FauxRender::BufferView* srcViews[] = {
+        &batch.PositionBufferView,
+        &batch.TexCoordBufferView,
+        &batch.NormalBufferView,
+        &batch.TangentBufferView,
+    };
+
+    UINT numVertexViews = 0;
+    for (auto pSrcView : srcViews)
+    {
+        if (pSrcView->Format == GREX_FORMAT_UNKNOWN)
+        {
+            continue;
+        }
+
+        auto& dstView          = vertexViews[numVertexViews];
+        dstView.BufferLocation = static_cast<D3D12_GPU_VIRTUAL_ADDRESS>(bufferStart + pSrcView->Offset);
+        dstView.SizeInBytes    = static_cast<UINT>(pSrcView->Size);
+        dstView.StrideInBytes  = static_cast<UINT>(pSrcView->Stride);
+
+        ++numVertexViews;
+    }
+
+    return numVertexViews;
+}
+
+static void BindBatch(const DxFauxRender::Buffer* pBuffer, const FauxRender::PrimitiveBatch& batch, ID3D12GraphicsCommandList* pCmdList)
+{
+    D3D12_INDEX_BUFFER_VIEW  indexView                               = {};
+    D3D12_VERTEX_BUFFER_VIEW vertexViews[GREX_MAX_VERTEX_ATTRIBUTES] = {};
+
+    UINT numVertexViews = GetBatchViews(pBuffer, batch, &indexView, vertexViews);
+
+    pCmdList->IASetIndexBuffer(&indexView);
+    pCmdList->IASetVertexBuffers(0, numVertexViews, vertexViews);
+}
+
+static void SetDrawParams(const FauxRender::SceneGraph* pGraph, uint32_t instanceIndex, uint32_t materialIndex, ID3D12GraphicsCommandList* pCmdList)
+{
+    FauxRender::Shader::DrawParams drawParams = {};
+    drawParams.InstanceIndex                  = instanceIndex;
+    drawParams.MaterialIndex                  = materialIndex;
+    assert((drawParams.InstanceIndex != UINT32_MAX) && "drawParams.InstanceIndex is invalid");
+    assert((drawParams.MaterialIndex != UINT32_MAX) && "drawParams.MaterialIndex is invalid");
+
+    pCmdList->SetGraphicsRoot32BitConstants(
+        static_cast<const DxFauxRender::SceneGraph*>(pGraph)->RootParameterIndices.Draw,
+        2,
+        &drawParams,
+        0);
+}
+
+static void BindSceneResources(const FauxRender::SceneGraph* pGraph, const FauxRender::Scene* pScene, FauxRender::Buffer* pInstanceBuffer, ID3D12GraphicsCommandList* pCmdList)
+{
+    // Set camera
+    {
+        auto resource = DxFauxRender::Cast(pScene->pCameraArgs)->Resource;
+        pCmdList->SetGraphicsRootConstantBufferView(
+            static_cast<const DxFauxRender::SceneGraph*>(pGraph)->RootParameterIndices.Camera,
+            resource->GetGPUVirtualAddress());
+    }
+
+    // Set instance buffer
+    {
+        auto resource = DxFauxRender::Cast(pInstanceBuffer)->Resource;
+        pCmdList->SetGraphicsRootShaderResourceView(
+            static_cast<const DxFauxRender::SceneGraph*>(pGraph)->RootParameterIndices.InstanceBuffer,
+            resource->GetGPUVirtualAddress());
+    }
+
+    // Set material buffer
+    {
+        auto resource = DxFauxRender::Cast(pGraph->pMaterialBuffer)->Resource;
+        pCmdList->SetGraphicsRootShaderResourceView(
+            static_cast<const DxFauxRender::SceneGraph*>(pGraph)->RootParameterIndices.MaterialBuffer,
+            resource->GetGPUVirtualAddress());
+    }
+}
+
 void Draw(const FauxRender::SceneGraph* pGraph, uint32_t instanceIndex, const FauxRender::Mesh* pMesh, ID3D12GraphicsCommandList* pCmdList)
 {
     assert((pMesh != nullptr) && "pMesh is NULL");
 
-    const DxFauxRender::Buffer* pBuffer = DxFauxRender::Cast(pMesh->pBuffer);
-    assert((pBuffer != nullptr) && "mesh's buffer is NULL");
+    Draw(pGraph, instanceIndex, pMesh, pMesh->pBuffer, pCmdList);
+}
 
-    // Buffer VA
-    D3D12_GPU_VIRTUAL_ADDRESS bufferStart = pBuffer->Resource->GetGPUVirtualAddress();
+void Draw(const FauxRender::SceneGraph* pGraph, uint32_t instanceIndex, const FauxRender::Mesh* pMesh, FauxRender::Buffer* pMeshBuffer, ID3D12GraphicsCommandList* pCmdList)
+{
+    assert((pMesh != nullptr) && "pMesh is NULL");
+
+    const DxFauxRender::Buffer* pBuffer = DxFauxRender::Cast(pMeshBuffer);
+    assert((pBuffer != nullptr) && "mesh's buffer is NULL");
 
     const size_t numBatches = pMesh->DrawBatches.size();
     for (size_t batchIdx = 0; batchIdx < numBatches; ++batchIdx)
@@ -348,83 +560,11 @@ void Draw(const FauxRender::SceneGraph* pGraph, uint32_t instanceIndex, const Fa
             continue;
         }
 
-        // Index buffer
-        {
-            D3D12_INDEX_BUFFER_VIEW view = {};
-            view.BufferLocation          = static_cast<D3D12_GPU_VIRTUAL_ADDRESS>(bufferStart + batch.IndexBufferView.Offset);
-            view.SizeInBytes             = static_cast<UINT>(batch.IndexBufferView.Size);
-            view.Format                  = ToDxFormat(batch.IndexBufferView.Format);
-
-            pCmdList->IASetIndexBuffer(&view);
-        }
-
-        // Vertex buffers
-        {
-            UINT                     numBufferViews                          = 0;
-            D3D12_VERTEX_BUFFER_VIEW bufferViews[GREX_MAX_VERTEX_ATTRIBUTES] = {};
-
-            // Position
-            if (batch.PositionBufferView.Format != GREX_FORMAT_UNKNOWN)
-            {
-                auto& srcView          = batch.PositionBufferView;
-                auto& dstView          = bufferViews[numBufferViews];
-                dstView.BufferLocation = static_cast<D3D12_GPU_VIRTUAL_ADDRESS>(bufferStart + srcView.Offset);
-                dstView.SizeInBytes    = static_cast<UINT>(srcView.Size);
-                dstView.StrideInBytes  = static_cast<UINT>(srcView.Stride);
-
-                ++numBufferViews;
-            }
-            // Tex Coord
-            if (batch.TexCoordBufferView.Format != GREX_FORMAT_UNKNOWN)
-            {
-                auto& srcView          = batch.TexCoordBufferView;
-                auto& dstView          = bufferViews[numBufferViews];
-                dstView.BufferLocation = static_cast<D3D12_GPU_VIRTUAL_ADDRESS>(bufferStart + srcView.Offset);
-                dstView.SizeInBytes    = static_cast<UINT>(srcView.Size);
-                dstView.StrideInBytes  = static_cast<UINT>(srcView.Stride);
-
-                ++numBufferViews;
-            }
-            //  Normal
-            if (batch.NormalBufferView.Format != GREX_FORMAT_UNKNOWN)
-            {
-                auto& srcView          = batch.NormalBufferView;
-                auto& dstView          = bufferViews[numBufferViews];
-                dstView.BufferLocation = static_cast<D3D12_GPU_VIRTUAL_ADDRESS>(bufferStart + srcView.Offset);
-                dstView.SizeInBytes    = static_cast<UINT>(srcView.Size);
-                dstView.StrideInBytes  = static_cast<UINT>(srcView.Stride);
-
-                ++numBufferViews;
-            }
-            //  Tangent
-            if (batch.TangentBufferView.Format != GREX_FORMAT_UNKNOWN)
-            {
-                auto& srcView          = batch.TangentBufferView;
-                auto& dstView          = bufferViews[numBufferViews];
-                dstView.BufferLocation = static_cast<D3D12_GPU_VIRTUAL_ADDRESS>(bufferStart + srcView.Offset);
-                dstView.SizeInBytes    = static_cast<UINT>(srcView.Size);
-                dstView.StrideInBytes  = static_cast<UINT>(srcView.Stride);
-
-                ++numBufferViews;
-            }
-
-            pCmdList->IASetVertexBuffers(0, numBufferViews, bufferViews);
-        }
+        // Index and vertex buffers
+        BindBatch(pBuffer, batch, pCmdList);
 
         // Draw root constants
-        {
-            FauxRender::Shader::DrawParams drawParams = {};
-            drawParams.InstanceIndex                  = instanceIndex;
-            drawParams.MaterialIndex                  = pGraph->GetMaterialIndex(batch.pMaterial);
-            assert((drawParams.InstanceIndex != UINT32_MAX) && "drawParams.InstanceIndex is invalid");
-            assert((drawParams.MaterialIndex != UINT32_MAX) && "drawParams.MaterialIndex is invalid");
-
-            pCmdList->SetGraphicsRoot32BitConstants(
-                static_cast<const DxFauxRender::SceneGraph*>(pGraph)->RootParameterIndices.Draw,
-                2,
-                &drawParams,
-                0);
-        }
+        SetDrawParams(pGraph, instanceIndex, pGraph->GetMaterialIndex(batch.pMaterial), pCmdList);
 
         // Draw
         pCmdList->DrawIndexedInstanced(
@@ -442,49 +582,95 @@ void Draw(const FauxRender::SceneGraph* pGraph, const FauxRender::Scene* pScene,
     assert((pGeometryNode != nullptr) && "pGeometryNode is NULL");
     assert((pGeometryNode->Type == FauxRender::SCENE_NODE_TYPE_GEOMETRY) && "node is not of drawable type");
 
-    // mat4 Rmat     = glm::toMat4(pGeometryNode->Rotation);
-    // mat4 modelMat = glm::translate(pGeometryNode->Translate) * Rmat * glm::scale(pGeometryNode->Scale);
-
-    // pCmdList->SetGraphicsRoot32BitConstants(0, 16, &modelMat, 0);
-    // pCmdList->SetGraphicsRoot32BitConstants(0, 16, &Rmat, 32);
-
     uint32_t instanceIndex = pScene->GetGeometryNodeIndex(pGeometryNode);
     assert((instanceIndex != UINT32_MAX) && "instanceIndex is invalid");
 
-    Draw(pGraph, instanceIndex, pGeometryNode->pMesh, pCmdList);
+    Draw(pGraph, instanceIndex, pGeometryNode->pMesh, pGeometryNode->GetDrawBuffer(), pCmdList);
 }
 
 void Draw(const FauxRender::SceneGraph* pGraph, const FauxRender::Scene* pScene, ID3D12GraphicsCommandList* pCmdList)
 {
     assert((pScene != nullptr) && "pScene is NULL");
 
-    // Set camera
+    BindSceneResources(pGraph, pScene, pScene->pInstanceBuffer, pCmdList);
+
+    for (auto pGeometryNode : pScene->GeometryNodes)
     {
-        auto resource = DxFauxRender::Cast(pScene->pCameraArgs)->Resource;
-        pCmdList->SetGraphicsRootConstantBufferView(
-            static_cast<const DxFauxRender::SceneGraph*>(pGraph)->RootParameterIndices.Camera,
-            resource->GetGPUVirtualAddress());
+        // Freed instance slot
+        if (IsNull(pGeometryNode))
+        {
+            continue;
+        }
+
+        Draw(pGraph, pScene, pGeometryNode, pCmdList);
     }
+}
 
-    // Set instance buffer
+void Draw(const FauxRender::SceneGraph* pGraph, const FauxRender::Scene* pScene, const FauxRender::VisibleList* pVisibleList, ID3D12GraphicsCommandList* pCmdList)
+{
+    assert((pScene != nullptr) && "pScene is NULL");
+    assert((pVisibleList != nullptr) && "pVisibleList is NULL");
+
+    BindSceneResources(pGraph, pScene, pScene->pInstanceBuffer, pCmdList);
+
+    for (auto instanceIndex : pVisibleList->InstanceIndices)
     {
-        auto resource = DxFauxRender::Cast(pScene->pInstanceBuffer)->Resource;
-        pCmdList->SetGraphicsRootShaderResourceView(
-            static_cast<const DxFauxRender::SceneGraph*>(pGraph)->RootParameterIndices.InstanceBuffer,
-            resource->GetGPUVirtualAddress());
+        auto pGeometryNode = pScene->GeometryNodes[instanceIndex];
+        Draw(pGraph, instanceIndex, pGeometryNode->pMesh, pGeometryNode->GetDrawBuffer(), pCmdList);
     }
+}
 
-    // Set material buffer
+void Draw(const FauxRender::SceneGraph* pGraph, const FauxRender::Scene* pScene, const FauxRender::DrawList* pDrawList, ID3D12GraphicsCommandList* pCmdList)
+{
+    assert((pScene != nullptr) && "pScene is NULL");
+    assert((pDrawList != nullptr) && "pDrawList is NULL");
+
+    if (pDrawList->Draws.empty())
     {
-        auto resource = DxFauxRender::Cast(pGraph->pMaterialBuffer)->Resource;
-        pCmdList->SetGraphicsRootShaderResourceView(
-            static_cast<const DxFauxRender::SceneGraph*>(pGraph)->RootParameterIndices.MaterialBuffer,
-            resource->GetGPUVirtualAddress());
+        return;
     }
 
-    for (auto pGeometryNode : pScene->GeometryNodes)
+    BindSceneResources(pGraph, pScene, pDrawList->pInstanceBuffer, pCmdList);
+
+    //
+    // Every draw is one command of the draw list's argument buffer, the
+    // commands set the draw's root constants and buffer views themselves.
+    // The caller binds a single pipeline for the whole list, so the list is
+    // drawn with one ExecuteIndirect.
+    //
+    const DxFauxRender::SceneGraph* pDxGraph = static_cast<const DxFauxRender::SceneGraph*>(pGraph);
+    if (!IsNull(pDrawList->pIndirectArgsBuffer) && pDxGraph->DrawListCommandSignature)
     {
-        Draw(pGraph, pScene, pGeometryNode, pCmdList);
+        pCmdList->ExecuteIndirect(
+            /* pCommandSignature    */ pDxGraph->DrawListCommandSignature.Get(),
+            /* MaxCommandCount      */ CountU32(pDrawList->Draws),
+            /* pArgumentBuffer      */ DxFauxRender::Cast(pDrawList->pIndirectArgsBuffer)->Resource.Get(),
+            /* ArgumentBufferOffset */ 0,
+            /* pCountBuffer         */ nullptr,
+            /* CountBufferOffset    */ 0);
+        return;
+    }
+
+    for (const auto& draw : pDrawList->Draws)
+    {
+        const auto& batch = draw.pMesh->DrawBatches[draw.BatchIndex];
+
+        const DxFauxRender::Buffer* pBuffer = DxFauxRender::Cast(draw.pBuffer);
+        assert((pBuffer != nullptr) && "mesh's buffer is NULL");
+
+        // Index and vertex buffers
+        BindBatch(pBuffer, batch, pCmdList);
+
+        // Instances for this draw start at FirstInstance in the draw list's instance buffer
+        SetDrawParams(pGraph, draw.FirstInstance, draw.MaterialIndex, pCmdList);
+
+        // Draw
+        pCmdList->DrawIndexedInstanced(
+            /* IndexCountPerInstance */ batch.IndexBufferView.Count,
+            /* InstanceCount         */ draw.InstanceCount,
+            /* StartIndexLocation    */ 0,
+            /* BaseVertexLocation    */ 0,
+            /* StartInstanceLocation */ 0);
     }
 }
 
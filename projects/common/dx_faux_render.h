@@ -22,9 +22,23 @@ struct Image
     ComPtr<ID3D12Resource> Resource;
 };
 
+//
+// One ExecuteIndirect command of SceneGraph::DrawListCommandSignature, the
+// draw list's indirect argument buffer holds one per InstancedDraw. Vertex
+// buffer slots the batch doesn't use hold null views.
+//
+struct DrawListCommand
+{
+    FauxRender::Shader::DrawParams DrawParams                                    = {};
+    D3D12_INDEX_BUFFER_VIEW        IndexBufferView                               = {};
+    D3D12_VERTEX_BUFFER_VIEW       VertexBufferViews[GREX_MAX_VERTEX_ATTRIBUTES] = {};
+    D3D12_DRAW_INDEXED_ARGUMENTS   DrawArguments                                 = {};
+};
+
 struct SceneGraph : public FauxRender::SceneGraph
 {
-    DxRenderer* pRenderer = nullptr;
+    DxRenderer*                    pRenderer                = nullptr;
+    ComPtr<ID3D12CommandSignature> DrawListCommandSignature = nullptr;
 
     struct
     {
@@ -44,6 +58,12 @@ struct SceneGraph : public FauxRender::SceneGraph
 
     SceneGraph(DxRenderer* pTheRenderer);
 
+    // The draw list commands set the Draw root constants, so the command
+    // signature belongs to the root signature draw lists are drawn with.
+    // Call once RootParameterIndices.Draw is set. Without it Draw() issues
+    // the draw list's draws one by one.
+    bool CreateDrawListCommandSignature(ID3D12RootSignature* pRootSignature);
+
     virtual bool CreateTemporaryBuffer(
         uint32_t             size,
         const void*          pData,
@@ -77,14 +97,22 @@ struct SceneGraph : public FauxRender::SceneGraph
         size_t                        srcImageDataSize,
         const void*                   pSrcImageData,
         FauxRender::Image**           ppImage) override;
+
+protected:
+    virtual bool CreateDrawListArgsBuffer(
+        const FauxRender::DrawList* pDrawList,
+        FauxRender::Buffer**        ppBuffer) override;
 };
 
 DxFauxRender::Buffer* Cast(FauxRender::Buffer* pBuffer);
 DxFauxRender::Image*  Cast(FauxRender::Image* pImage);
 
 void Draw(const FauxRender::SceneGraph* pGraph, uint32_t instanceIndex, const FauxRender::Mesh* pMesh, ID3D12GraphicsCommandList* pCmdList);
+void Draw(const FauxRender::SceneGraph* pGraph, uint32_t instanceIndex, const FauxRender::Mesh* pMesh, FauxRender::Buffer* pMeshBuffer, ID3D12GraphicsCommandList* pCmdList);
 void Draw(const FauxRender::SceneGraph* pGraph, const FauxRender::Scene* pScene, const FauxRender::SceneNode* pGeometryNode, ID3D12GraphicsCommandList* pCmdList);
 void Draw(const FauxRender::SceneGraph* pGraph, const FauxRender::Scene* pScene, ID3D12GraphicsCommandList* pCmdList);
+void Draw(const FauxRender::SceneGraph* pGraph, const FauxRender::Scene* pScene, const FauxRender::DrawList* pDrawList, ID3D12GraphicsCommandList* pCmdList);
+void Draw(const FauxRender::SceneGraph* pGraph, const FauxRender::Scene* pScene, const FauxRender::VisibleList* pVisibleList, ID3D12GraphicsCommandList* pCmdList);
 
 } // namespace DxFauxRender
 
@@ -1,4 +1,9 @@
 #include "dx_renderer.h"
+#include "shader_cache.h"
+#include "job_system.h"
+
+#include <atomic>
+#include <chrono>
 
 bool     IsCompressed(DXGI_FORMAT fmt);
 bool     IsVideo(DXGI_FORMAT fmt);
@@ -472,6 +477,12 @@ DXGI_FORMAT ToDxFormat(GREXFormat format)
         case GREX_FORMAT_BC6H_SFLOAT        : return DXGI_FORMAT_BC6H_SF16;
         case GREX_FORMAT_BC6H_UFLOAT        : return DXGI_FORMAT_BC6H_UF16;
         case GREX_FORMAT_BC7_RGBA           : return DXGI_FORMAT_BC7_UNORM;
+        case GREX_FORMAT_R8G8_SNORM         : return DXGI_FORMAT_R8G8_SNORM;
+        case GREX_FORMAT_R8G8B8A8_SNORM     : return DXGI_FORMAT_R8G8B8A8_SNORM;
+        case GREX_FORMAT_R16G16_UNORM       : return DXGI_FORMAT_R16G16_UNORM;
+        case GREX_FORMAT_R16G16_SNORM       : return DXGI_FORMAT_R16G16_SNORM;
+        case GREX_FORMAT_R16G16B16A16_UNORM : return DXGI_FORMAT_R16G16B16A16_UNORM;
+        case GREX_FORMAT_R16G16B16A16_SNORM : return DXGI_FORMAT_R16G16B16A16_SNORM;
     }
     // clang-format on
     return DXGI_FORMAT_UNKNOWN;
@@ -865,33 +876,72 @@ HRESULT CreateTexture(
     }
 
     if (!IsNull(pSrcData)) {
-        ComPtr<ID3D12Resource> stagingBuffer;
-        if (IsCompressed(format)) {
-            hr = CreateBuffer(pRenderer, srcSizeBytes, pSrcData, &stagingBuffer);
-            if (FAILED(hr)) {
-                assert(false && "create staging buffer failed");
-                return hr;
+        //
+        // CopyTextureRegion wants every level on a 512 byte boundary and every
+        // row on a 256 byte boundary. The source levels can use any row stride,
+        // so each level is re-pitched into a staging buffer with that layout.
+        // Rows of compressed formats are rows of 4x4 blocks.
+        //
+        const bool     compressed  = IsCompressed(format);
+        const uint32_t elementSize = compressed ? (BitsPerPixel(format) * 2) : PixelStride(format);
+
+        std::vector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> footprints(numMipLevels);
+        std::vector<uint32_t>                           rowSizes(numMipLevels);
+        std::vector<uint32_t>                           numRows(numMipLevels);
+        uint64_t                                        stagingSize = 0;
+        for (UINT level = 0; level < numMipLevels; ++level) {
+            const auto&    mipOffset   = mipOffsets[level];
+            const uint32_t levelWidth  = std::max<uint32_t>(width >> level, 1);
+            const uint32_t levelHeight = std::max<uint32_t>(height >> level, 1);
+
+            rowSizes[level] = (compressed ? ((levelWidth + 3) / 4) : levelWidth) * elementSize;
+            numRows[level]  = compressed ? ((levelHeight + 3) / 4) : levelHeight;
+
+            const uint64_t srcEnd = uint64_t(mipOffset.Offset) + uint64_t(numRows[level] - 1) * mipOffset.RowStride + rowSizes[level];
+            if ((mipOffset.RowStride < rowSizes[level]) || (srcEnd > srcSizeBytes)) {
+                assert(false && "mip level is outside of the source data");
+                return E_INVALIDARG;
             }
+
+            stagingSize = Align<uint64_t>(stagingSize, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT);
+
+            auto& footprint              = footprints[level];
+            footprint.Offset             = stagingSize;
+            footprint.Footprint.Format   = format;
+            footprint.Footprint.Width    = compressed ? Align<uint32_t>(levelWidth, 4) : levelWidth;
+            footprint.Footprint.Height   = compressed ? Align<uint32_t>(levelHeight, 4) : levelHeight;
+            footprint.Footprint.Depth    = 1;
+            footprint.Footprint.RowPitch = Align<uint32_t>(rowSizes[level], D3D12_TEXTURE_DATA_PITCH_ALIGNMENT);
+
+            stagingSize += uint64_t(footprint.Footprint.RowPitch) * numRows[level];
         }
-        else {
-            const uint32_t rowStride = width * PixelStride(format);
-            // Calculate the total number of rows for all mip maps
-            uint32_t numRows = 0;
-            {
-                uint32_t mipHeight = height;
-                for (UINT level = 0; level < numMipLevels; ++level) {
-                    numRows += mipHeight;
-                    mipHeight >>= 1;
-                }
-            }
 
-            hr = CreateBuffer(pRenderer, rowStride, numRows, pSrcData, &stagingBuffer);
-            if (FAILED(hr)) {
-                assert(false && "create staging buffer failed");
-                return hr;
+        ComPtr<ID3D12Resource> stagingBuffer;
+        hr = CreateBuffer(pRenderer, stagingSize, nullptr, &stagingBuffer);
+        if (FAILED(hr)) {
+            assert(false && "create staging buffer failed");
+            return hr;
+        }
+
+        char* pStagingData = nullptr;
+        hr                 = stagingBuffer->Map(0, nullptr, reinterpret_cast<void**>(&pStagingData));
+        if (FAILED(hr)) {
+            assert(false && "map staging buffer failed");
+            return hr;
+        }
+
+        for (UINT level = 0; level < numMipLevels; ++level) {
+            const char* pSrcRow = static_cast<const char*>(pSrcData) + mipOffsets[level].Offset;
+            char*       pDstRow = pStagingData + footprints[level].Offset;
+            for (uint32_t row = 0; row < numRows[level]; ++row) {
+                memcpy(pDstRow, pSrcRow, rowSizes[level]);
+                pSrcRow += mipOffsets[level].RowStride;
+                pDstRow += footprints[level].Footprint.RowPitch;
             }
         }
 
+        stagingBuffer->Unmap(0, nullptr);
+
         ComPtr<ID3D12CommandAllocator> cmdAllocator;
         hr = pRenderer->Device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&cmdAllocator));
         if (FAILED(hr)) {
@@ -919,49 +969,28 @@ HRESULT CreateTexture(
         }
 
         // Build command buffer
-        {
-            uint32_t levelWidth  = width;
-            uint32_t levelHeight = height;
-            for (UINT level = 0; level < numMipLevels; ++level) {
-                const auto&    mipOffset    = mipOffsets[level];
-                uint32_t mipRowStride = Align<uint32_t>(mipOffset.RowStride, D3D12_TEXTURE_DATA_PITCH_ALIGNMENT);
-                if (IsCompressed(format)) {
-                    //
-                    // This is hack based on values returned by GetCopyableFootprints().
-                    //
-                    mipRowStride = levelWidth * 4;
-                }
-
-                D3D12_TEXTURE_COPY_LOCATION dst = {};
-                dst.pResource                   = *ppResource;
-                dst.Type                        = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
-                dst.SubresourceIndex            = level;
-
-                D3D12_TEXTURE_COPY_LOCATION src        = {};
-                src.pResource                          = stagingBuffer.Get();
-                src.Type                               = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT;
-                src.PlacedFootprint.Offset             = mipOffset.Offset;
-                src.PlacedFootprint.Footprint.Format   = format;
-                src.PlacedFootprint.Footprint.Width    = static_cast<UINT>(levelWidth);
-                src.PlacedFootprint.Footprint.Height   = static_cast<UINT>(levelHeight);
-                src.PlacedFootprint.Footprint.Depth    = 1;
-                src.PlacedFootprint.Footprint.RowPitch = static_cast<UINT>(mipRowStride);
-
-                cmdList->CopyTextureRegion(&dst, 0, 0, 0, &src, nullptr);
-
-                D3D12_RESOURCE_BARRIER barrier = {};
-                barrier.Type                   = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
-                barrier.Flags                  = D3D12_RESOURCE_BARRIER_FLAG_NONE;
-                barrier.Transition.pResource   = *ppResource;
-                barrier.Transition.Subresource = level;
-                barrier.Transition.StateBefore = D3D12_RESOURCE_STATE_COPY_DEST;
-                barrier.Transition.StateAfter  = D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE | D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE;
-
-                cmdList->ResourceBarrier(1, &barrier);
-
-                levelWidth >>= 1;
-                levelHeight >>= 1;
-            }
+        for (UINT level = 0; level < numMipLevels; ++level) {
+            D3D12_TEXTURE_COPY_LOCATION dst = {};
+            dst.pResource                   = *ppResource;
+            dst.Type                        = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
+            dst.SubresourceIndex            = level;
+
+            D3D12_TEXTURE_COPY_LOCATION src = {};
+            src.pResource                   = stagingBuffer.Get();
+            src.Type                        = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT;
+            src.PlacedFootprint             = footprints[level];
+
+            cmdList->CopyTextureRegion(&dst, 0, 0, 0, &src, nullptr);
+
+            D3D12_RESOURCE_BARRIER barrier = {};
+            barrier.Type                   = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+            barrier.Flags                  = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+            barrier.Transition.pResource   = *ppResource;
+            barrier.Transition.Subresource = level;
+            barrier.Transition.StateBefore = D3D12_RESOURCE_STATE_COPY_DEST;
+            barrier.Transition.StateAfter  = D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE | D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE;
+
+            cmdList->ResourceBarrier(1, &barrier);
         }
         hr = cmdList->Close();
         if (FAILED(hr)) {
@@ -1839,6 +1868,41 @@ HRESULT CreateMeshShaderPipeline(
 }
 #endif // defined(GREX_USE_D3DX12)
 
+//
+// DXC's version and commit, queried once per process so cache hits still
+// don't create a compiler. Empty if the compiler doesn't report them.
+//
+static const std::string& GetDXCVersion()
+{
+    static const std::string sVersion = []() {
+        std::stringstream ss;
+
+        ComPtr<IDxcVersionInfo> versionInfo;
+        if (FAILED(DxcCreateInstance(CLSID_DxcCompiler, IID_PPV_ARGS(&versionInfo)))) {
+            return ss.str();
+        }
+
+        UINT32 major = 0;
+        UINT32 minor = 0;
+        if (SUCCEEDED(versionInfo->GetVersion(&major, &minor))) {
+            ss << major << "." << minor;
+        }
+
+        ComPtr<IDxcVersionInfo2> versionInfo2;
+        if (SUCCEEDED(versionInfo.As(&versionInfo2))) {
+            UINT32 commitCount = 0;
+            char*  pCommitHash = nullptr;
+            if (SUCCEEDED(versionInfo2->GetCommitInfo(&commitCount, &pCommitHash))) {
+                ss << "." << commitCount << "-" << (IsNull(pCommitHash) ? "" : pCommitHash);
+                CoTaskMemFree(pCommitHash);
+            }
+        }
+
+        return ss.str();
+    }();
+    return sVersion;
+}
+
 static std::wstring AsciiToUTF16(const std::string& ascii)
 {
     std::wstring utf16;
@@ -1876,6 +1940,18 @@ HRESULT CompileHLSL(
         return E_INVALIDARG;
     }
 
+    // Cache lookup - hits don't touch DXC at all
+    ShaderCacheKey cacheKey = {};
+    cacheKey.Add("HLSL-DXIL");
+    cacheKey.Add(GetDXCVersion());
+    cacheKey.Add(entryPoint);
+    cacheKey.Add(profile);
+    cacheKey.Add(shaderSource);
+
+    if (LoadCachedShader(cacheKey, pDXIL)) {
+        return S_OK;
+    }
+
     ComPtr<IDxcLibrary> dxcLibrary;
     HRESULT             hr = DxcCreateInstance(CLSID_DxcLibrary, IID_PPV_ARGS(&dxcLibrary));
 
@@ -1939,9 +2015,61 @@ HRESULT CompileHLSL(
     size_t      bufferSize = static_cast<size_t>(shaderBinary->GetBufferSize());
     *pDXIL                 = std::vector<char>(pBuffer, pBuffer + bufferSize);
 
+    StoreCachedShader(cacheKey, *pDXIL);
+
     return S_OK;
 }
 
+bool CompileShaders(
+    const std::vector<DxShaderCompileJob>& jobs,
+    std::vector<DxShaderCompileResult>*    pResults,
+    uint32_t                               numThreads)
+{
+    if (IsNull(pResults)) {
+        assert(false && "results output arg is null");
+        return false;
+    }
+
+    pResults->clear();
+    pResults->resize(jobs.size());
+    if (jobs.empty()) {
+        return true;
+    }
+
+    // Largest sources first so a long compile doesn't start last
+    std::vector<size_t> order(jobs.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [&jobs](size_t a, size_t b) { return jobs[a].Source.size() > jobs[b].Source.size(); });
+
+    std::atomic<uint32_t> numFailures = 0;
+
+    // Each CompileHLSL() call creates its own DXC compiler, they aren't
+    // shared across threads
+    auto compileShaders = [&](uint32_t begin, uint32_t end) {
+        for (uint32_t orderIdx = begin; orderIdx < end; ++orderIdx) {
+            const auto& job    = jobs[order[orderIdx]];
+            auto&       result = (*pResults)[order[orderIdx]];
+
+            auto start     = std::chrono::high_resolution_clock::now();
+            result.Success = SUCCEEDED(CompileHLSL(job.Source, job.EntryPoint, job.Profile, &result.DXIL, &result.ErrorMsg));
+            auto end       = std::chrono::high_resolution_clock::now();
+
+            result.CompileTime = std::chrono::duration<double, std::milli>(end - start).count();
+
+            if (!result.Success) {
+                ++numFailures;
+            }
+        }
+    };
+
+    // One shader per piece, handed out in order, so the largest start first
+    JobSystem::Get().ParallelFor(0, CountU32(order), 1, compileShaders, numThreads);
+
+    return (numFailures == 0);
+}
+
 //
 // From: https://github.com/microsoft/DirectXTex/blob/main/DirectXTex/DirectXTex.inl#L53
 //
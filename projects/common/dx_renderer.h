@@ -20,6 +20,21 @@ enum DxPipelineFlags
     DX_PIPELINE_FLAGS_INTERLEAVED_ATTRS = 0x00000001
 };
 
+struct DxShaderCompileJob
+{
+    std::string Source     = "";
+    std::string EntryPoint = ""; // Ignored if profile is lib_6_*
+    std::string Profile    = "";
+};
+
+struct DxShaderCompileResult
+{
+    bool              Success     = false;
+    std::vector<char> DXIL        = {};
+    std::string       ErrorMsg    = "";
+    double            CompileTime = 0; // Milliseconds, includes cache lookups
+};
+
 struct DxRenderer
 {
     bool                                     DebugEnabled                  = true;
@@ -221,4 +236,12 @@ HRESULT CompileHLSL(
     std::vector<char>* pDXIL,
     std::string*       pErrorMsg);
 
+// Compiles the jobs concurrently on up to numThreads job system
+// threads, 0 uses them all. Results are in job order. Returns false if any job
+// failed, the failed results have their ErrorMsg set.
+bool CompileShaders(
+    const std::vector<DxShaderCompileJob>& jobs,
+    std::vector<DxShaderCompileResult>*    pResults,
+    uint32_t                               numThreads = 0);
+
 HRESULT CopyDataToBuffer(size_t dataSize, void* pData, ID3D12Resource* pBuffer);
\ No newline at end of file
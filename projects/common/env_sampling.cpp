@@ -0,0 +1,379 @@
+#include "env_sampling.h"
+
+#include <cmath>
+
+namespace
+{
+
+const float kPi = 3.14159265358979f;
+
+// File layout: header, marginal table, conditional table, pdf table
+struct FileHeader
+{
+    char     Magic[4];
+    uint32_t Version;
+    uint32_t Width;
+    uint32_t Height;
+    float    Integral;
+};
+
+const char     kFileMagic[4] = {'G', 'X', 'E', 'S'};
+const uint32_t kFileVersion  = 1;
+
+float Luminance(float r, float g, float b)
+{
+    return 0.2126f * r + 0.7152f * g + 0.0722f * b;
+}
+
+//
+// Vose's alias method. Weights don't need to be normalized, if they're all
+// zero every slot gets the same probability.
+//
+void BuildAliasTable(const float* pWeights, uint32_t count, EnvironmentSampler::AliasEntry* pEntries)
+{
+    double sum = 0;
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        sum += pWeights[i];
+    }
+
+    std::vector<double>   scaled(count);
+    std::vector<uint32_t> small;
+    std::vector<uint32_t> large;
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        scaled[i] = (sum > 0) ? (pWeights[i] * count / sum) : 1.0;
+        if (scaled[i] < 1.0)
+        {
+            small.push_back(i);
+        }
+        else
+        {
+            large.push_back(i);
+        }
+    }
+
+    while (!small.empty() && !large.empty())
+    {
+        uint32_t s = small.back();
+        uint32_t l = large.back();
+        small.pop_back();
+
+        pEntries[s] = {static_cast<float>(scaled[s]), l};
+
+        scaled[l] = (scaled[l] + scaled[s]) - 1.0;
+        if (scaled[l] < 1.0)
+        {
+            large.pop_back();
+            small.push_back(l);
+        }
+    }
+
+    // Whatever is left is 1 up to rounding
+    for (uint32_t i : large)
+    {
+        pEntries[i] = {1.0f, i};
+    }
+    for (uint32_t i : small)
+    {
+        pEntries[i] = {1.0f, i};
+    }
+}
+
+//
+// Picks a slot with a single random number. The part of xi that's left
+// over after picking is uniform in [0, 1) again and is returned in pRemap,
+// so the caller can use it to place the sample inside the slot.
+//
+uint32_t SampleAliasTable(const EnvironmentSampler::AliasEntry* pEntries, uint32_t count, float xi, float* pRemap)
+{
+    float    scaled = xi * count;
+    uint32_t slot   = std::min(static_cast<uint32_t>(scaled), count - 1);
+    float    frac   = std::min(scaled - slot, 0.99999994f);
+
+    const EnvironmentSampler::AliasEntry& entry = pEntries[slot];
+    if (frac < entry.Probability)
+    {
+        *pRemap = frac / entry.Probability;
+        return slot;
+    }
+
+    *pRemap = (frac - entry.Probability) / (1.0f - entry.Probability);
+    return entry.Alias;
+}
+
+} // namespace
+
+// =============================================================================
+// EnvironmentSampler
+// =============================================================================
+EnvironmentSampler::EnvironmentSampler()
+{
+}
+
+EnvironmentSampler::~EnvironmentSampler()
+{
+}
+
+bool EnvironmentSampler::Build(const BitmapRGBA32f& envMap, const Options& options, EnvironmentSampler* pSampler)
+{
+    if (IsNull(pSampler) || envMap.Empty())
+    {
+        return false;
+    }
+
+    const uint32_t mapWidth  = envMap.GetWidth();
+    const uint32_t mapHeight = envMap.GetHeight();
+
+    uint32_t width  = std::min(std::max(options.Width, 1u), mapWidth);
+    uint32_t height = options.Height;
+    if (height == 0)
+    {
+        height = static_cast<uint32_t>(static_cast<uint64_t>(width) * mapHeight / mapWidth);
+    }
+    height = std::min(std::max(height, 1u), mapHeight);
+
+    //
+    // Average luminance of the map texels under each table texel, widened
+    // by one map texel on each side. Bilinear lookups reach that far, so
+    // texels next to a bright spot (the sun's rim) get some of its weight.
+    //
+    std::vector<float> luminance(static_cast<size_t>(width) * height);
+    for (uint32_t y = 0; y < height; ++y)
+    {
+        int y0 = static_cast<int>(static_cast<uint64_t>(y) * mapHeight / height) - 1;
+        int y1 = std::max(static_cast<int>(static_cast<uint64_t>(y + 1) * mapHeight / height), y0 + 2) + 1;
+        for (uint32_t x = 0; x < width; ++x)
+        {
+            int x0 = static_cast<int>(static_cast<uint64_t>(x) * mapWidth / width) - 1;
+            int x1 = std::max(static_cast<int>(static_cast<uint64_t>(x + 1) * mapWidth / width), x0 + 2) + 1;
+
+            double sum = 0;
+            for (int my = y0; my < y1; ++my)
+            {
+                // V clamps and U repeats, same as the IBL sampler
+                uint32_t mapY = static_cast<uint32_t>(std::clamp(my, 0, static_cast<int>(mapHeight) - 1));
+                for (int mx = x0; mx < x1; ++mx)
+                {
+                    uint32_t            mapX   = static_cast<uint32_t>((mx + static_cast<int>(mapWidth)) % static_cast<int>(mapWidth));
+                    const PixelRGBA32f* pPixel = envMap.GetPixels(mapX, mapY);
+
+                    float r = std::min(pPixel->r, options.MaxRadiance);
+                    float g = std::min(pPixel->g, options.MaxRadiance);
+                    float b = std::min(pPixel->b, options.MaxRadiance);
+                    sum += std::max(Luminance(r, g, b), 0.0f);
+                }
+            }
+
+            luminance[y * width + x] = static_cast<float>(sum / ((x1 - x0) * (y1 - y0)));
+        }
+    }
+
+    // A small floor keeps the pdf from being zero anywhere light could come from
+    double meanLuminance = 0;
+    for (float value : luminance)
+    {
+        meanLuminance += value;
+    }
+    meanLuminance /= luminance.size();
+    const float floor = static_cast<float>(1e-3 * meanLuminance);
+
+    // sin(phi) weighting, phi at the row's center
+    std::vector<float> weights(luminance.size());
+    std::vector<float> rowWeights(height);
+    double             integral = 0;
+    for (uint32_t y = 0; y < height; ++y)
+    {
+        const float sinPhi = sinf(kPi * (y + 0.5f) / height);
+
+        double rowSum = 0;
+        for (uint32_t x = 0; x < width; ++x)
+        {
+            float lum              = luminance[y * width + x];
+            weights[y * width + x] = (lum + floor) * sinPhi;
+
+            rowSum += weights[y * width + x];
+            integral += lum * sinPhi;
+        }
+        rowWeights[y] = static_cast<float>(rowSum);
+    }
+    // Each table texel covers (2pi / width) * (pi / height) in (theta, phi)
+    integral *= (2.0 * kPi / width) * (kPi / height);
+
+    pSampler->mWidth    = width;
+    pSampler->mHeight   = height;
+    pSampler->mIntegral = static_cast<float>(integral);
+    pSampler->mMarginal.resize(height);
+    pSampler->mConditional.resize(static_cast<size_t>(width) * height);
+    pSampler->mPdf.resize(static_cast<size_t>(width) * height);
+
+    BuildAliasTable(DataPtr(rowWeights), height, DataPtr(pSampler->mMarginal));
+    for (uint32_t y = 0; y < height; ++y)
+    {
+        BuildAliasTable(&weights[y * width], width, &pSampler->mConditional[y * width]);
+    }
+
+    // UV space density, the weights integrate to 1 over the unit square
+    double totalWeight = 0;
+    for (float weight : rowWeights)
+    {
+        totalWeight += weight;
+    }
+    for (size_t i = 0; i < weights.size(); ++i)
+    {
+        pSampler->mPdf[i] = (totalWeight > 0) ? static_cast<float>(weights[i] * weights.size() / totalWeight) : 1.0f;
+    }
+
+    return true;
+}
+
+bool EnvironmentSampler::Create(const IBLMaps& ibl, const Options& options, EnvironmentSampler* pSampler)
+{
+    if (IsNull(pSampler))
+    {
+        return false;
+    }
+
+    if (!ibl.samplingTablePath.empty())
+    {
+        if (Load(ibl.samplingTablePath, pSampler))
+        {
+            return true;
+        }
+        GREX_LOG_WARN("failed to load " << ibl.samplingTablePath << ", building the sampling table instead");
+    }
+
+    // Mip levels are stacked vertically, the base level is at the top
+    uint32_t      width  = std::min(ibl.baseWidth, ibl.environmentMap.GetWidth());
+    uint32_t      height = std::min(ibl.baseHeight, ibl.environmentMap.GetHeight());
+    BitmapRGBA32f base   = ibl.environmentMap.CopyFrom(0, 0, width, height);
+
+    return Build(base, options, pSampler);
+}
+
+bool EnvironmentSampler::Load(const std::filesystem::path& absPath, EnvironmentSampler* pSampler)
+{
+    if (IsNull(pSampler))
+    {
+        return false;
+    }
+
+    std::ifstream is(absPath, std::ios::binary);
+    if (!is.is_open())
+    {
+        return false;
+    }
+
+    FileHeader header = {};
+    is.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!is || !std::equal(kFileMagic, kFileMagic + 4, header.Magic) || (header.Version != kFileVersion))
+    {
+        return false;
+    }
+    if ((header.Width == 0) || (header.Height == 0))
+    {
+        return false;
+    }
+
+    const size_t numTexels = static_cast<size_t>(header.Width) * header.Height;
+
+    std::vector<AliasEntry> marginal(header.Height);
+    std::vector<AliasEntry> conditional(numTexels);
+    std::vector<float>      pdf(numTexels);
+    is.read(reinterpret_cast<char*>(DataPtr(marginal)), SizeInBytes(marginal));
+    is.read(reinterpret_cast<char*>(DataPtr(conditional)), SizeInBytes(conditional));
+    is.read(reinterpret_cast<char*>(DataPtr(pdf)), SizeInBytes(pdf));
+    if (!is)
+    {
+        return false;
+    }
+
+    pSampler->mWidth       = header.Width;
+    pSampler->mHeight      = header.Height;
+    pSampler->mIntegral    = header.Integral;
+    pSampler->mMarginal    = std::move(marginal);
+    pSampler->mConditional = std::move(conditional);
+    pSampler->mPdf         = std::move(pdf);
+
+    return true;
+}
+
+bool EnvironmentSampler::Save(const std::filesystem::path& absPath, const EnvironmentSampler* pSampler)
+{
+    if (IsNull(pSampler) || pSampler->Empty())
+    {
+        return false;
+    }
+
+    std::ofstream os(absPath, std::ios::binary);
+    if (!os.is_open())
+    {
+        return false;
+    }
+
+    FileHeader header = {};
+    std::copy(kFileMagic, kFileMagic + 4, header.Magic);
+    header.Version  = kFileVersion;
+    header.Width    = pSampler->mWidth;
+    header.Height   = pSampler->mHeight;
+    header.Integral = pSampler->mIntegral;
+
+    os.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    os.write(reinterpret_cast<const char*>(DataPtr(pSampler->mMarginal)), SizeInBytes(pSampler->mMarginal));
+    os.write(reinterpret_cast<const char*>(DataPtr(pSampler->mConditional)), SizeInBytes(pSampler->mConditional));
+    os.write(reinterpret_cast<const char*>(DataPtr(pSampler->mPdf)), SizeInBytes(pSampler->mPdf));
+
+    return static_cast<bool>(os);
+}
+
+glm::vec3 EnvironmentSampler::Sample(const glm::vec2& xi, float* pPdf) const
+{
+    if (Empty())
+    {
+        *pPdf = 0;
+        return glm::vec3(0, 1, 0);
+    }
+
+    float    fy  = 0;
+    float    fx  = 0;
+    uint32_t row = SampleAliasTable(DataPtr(mMarginal), mHeight, xi.y, &fy);
+    uint32_t col = SampleAliasTable(&mConditional[row * mWidth], mWidth, xi.x, &fx);
+
+    float u = (col + fx) / mWidth;
+    float v = (row + fy) / mHeight;
+
+    float theta  = u * 2.0f * kPi;
+    float phi    = v * kPi;
+    float sinPhi = sinf(phi);
+
+    // The Jacobian of the (u, v) to direction mapping is 2pi^2 sin(phi)
+    *pPdf = (sinPhi > 0) ? (mPdf[row * mWidth + col] / (2.0f * kPi * kPi * sinPhi)) : 0.0f;
+
+    return glm::vec3(sinPhi * cosf(theta), cosf(phi), sinPhi * sinf(theta));
+}
+
+float EnvironmentSampler::Pdf(const glm::vec3& dir) const
+{
+    if (Empty())
+    {
+        return 0;
+    }
+
+    glm::vec3 d     = glm::normalize(dir);
+    float     theta = atan2f(d.z, d.x);
+    if (theta < 0)
+    {
+        theta += 2.0f * kPi;
+    }
+    float phi    = acosf(std::clamp(d.y, -1.0f, 1.0f));
+    float sinPhi = sinf(phi);
+    if (sinPhi <= 0)
+    {
+        return 0;
+    }
+
+    uint32_t col = std::min(static_cast<uint32_t>(theta / (2.0f * kPi) * mWidth), mWidth - 1);
+    uint32_t row = std::min(static_cast<uint32_t>(phi / kPi * mHeight), mHeight - 1);
+
+    return mPdf[row * mWidth + col] / (2.0f * kPi * kPi * sinPhi);
+}
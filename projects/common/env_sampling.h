@@ -0,0 +1,83 @@
+#pragma once
+
+#include "config.h"
+#include "bitmap.h"
+
+#include <glm/glm.hpp>
+
+//
+// Environment map importance sampling
+//
+// Builds a 2D distribution over an equirect environment map proportional
+// to luminance * sin(phi), phi being the polar angle, so rows near the
+// poles, which cover less solid angle, get proportionally fewer samples.
+// The distribution is stored as alias tables: a marginal table picks the
+// row and a per row conditional table picks the column. Drawing a sample
+// is two table lookups and no search, the same code works in a shader
+// with the tables in buffers.
+//
+// The table is usually coarser than the environment map, each table
+// texel averages a block of map texels. The pdf is constant over a table
+// texel in UV space.
+//
+// Directions use the same mapping as GetIBLEnvironment() in the shaders:
+//   u = atan2(z, x) / 2pi, wrapped to [0, 1)
+//   v = acos(y) / pi
+//
+class EnvironmentSampler
+{
+public:
+    struct Options
+    {
+        uint32_t Width       = 1024;
+        uint32_t Height      = 0;      // 0 keeps the environment map's aspect ratio
+        float    MaxRadiance = 100.0f; // Same clamp as GetIBLEnvironment()
+    };
+
+    // Upload as is: pick slot i, keep it if the remaining random is below Probability, else take Alias
+    struct AliasEntry
+    {
+        float    Probability;
+        uint32_t Alias;
+    };
+
+    EnvironmentSampler();
+    ~EnvironmentSampler();
+
+    static bool Build(const BitmapRGBA32f& envMap, const Options& options, EnvironmentSampler* pSampler);
+    //
+    // Loads the table baked next to the IBL if there is one and it's
+    // usable, otherwise builds one from the base level of the IBL's
+    // environment map.
+    //
+    static bool Create(const IBLMaps& ibl, const Options& options, EnvironmentSampler* pSampler);
+
+    static bool Load(const std::filesystem::path& absPath, EnvironmentSampler* pSampler);
+    static bool Save(const std::filesystem::path& absPath, const EnvironmentSampler* pSampler);
+
+    bool     Empty() const { return mPdf.empty(); }
+    uint32_t GetWidth() const { return mWidth; }
+    uint32_t GetHeight() const { return mHeight; }
+    // Luminance integrated over the sphere
+    float    GetIntegral() const { return mIntegral; }
+
+    // GetHeight() entries
+    const std::vector<AliasEntry>& GetMarginalTable() const { return mMarginal; }
+    // GetWidth() entries per row
+    const std::vector<AliasEntry>& GetConditionalTable() const { return mConditional; }
+    // UV space pdf per table texel, divide by (2 * pi^2 * sin(phi)) for solid angle
+    const std::vector<float>&      GetPdfTable() const { return mPdf; }
+
+    // xi in [0, 1)^2, returns a unit direction and its solid angle pdf
+    glm::vec3 Sample(const glm::vec2& xi, float* pPdf) const;
+    // Solid angle pdf of Sample() returning dir
+    float     Pdf(const glm::vec3& dir) const;
+
+private:
+    uint32_t                mWidth       = 0;
+    uint32_t                mHeight      = 0;
+    float                   mIntegral    = 0;
+    std::vector<AliasEntry> mMarginal    = {};
+    std::vector<AliasEntry> mConditional = {};
+    std::vector<float>      mPdf         = {};
+};
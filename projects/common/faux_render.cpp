@@ -1,10 +1,28 @@
 #include "faux_render.h"
+#include "faux_render_scene_file.h"
+#include "job_system.h"
+#include "profiler.h"
 #include "cgltf.h"
 
 #include "ktx.h"
-
+#include "meshoptimizer.h"
+#include "mikktspace.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <queue>
+#include <thread>
 #include <unordered_map>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define FAUX_RENDER_SSE2
+#include <emmintrin.h>
+#endif
+
 namespace FauxRender
 {
 
@@ -275,28 +293,58 @@ enum FauxRenderVkFormat
 
 struct BufferCopyRange
 {
-    cgltf_buffer* pGltfBuffer  = nullptr;
-    uint32_t      GltfOffset   = 0;
-    uint32_t      TargetOffset = 0;
-    uint32_t      Size         = 0;
+    const cgltf_buffer_view* pGltfBufferView     = nullptr;
+    uint32_t                 GltfOffset          = 0; // Relative to the buffer view
+    uint32_t                 TargetOffset        = 0;
+    uint32_t                 Size                = 0;
+    const cgltf_accessor*    pDequantizeAccessor = nullptr; // Converts the accessor's elements to float if set
+    const char*              pGeneratedData      = nullptr; // Copied instead of the buffer view if set
+};
+
+// Tangents for a primitive that doesn't have a TANGENT attribute, filled in
+// by GenerateGLTFTangents() once the glTF buffers are loaded.
+struct TangentJob
+{
+    const cgltf_primitive* pGltfPrim      = nullptr;
+    uint32_t               CopyRangeIndex = 0;
+    std::vector<vec4>      Tangents       = {};
 };
 
 struct BufferInfo
 {
-    uint32_t                     BufferSize = 0;
-    std::vector<BufferCopyRange> CopyRanges = {};
+    uint32_t                     BufferSize  = 0;
+    std::vector<BufferCopyRange> CopyRanges  = {};
+    std::vector<TangentJob>      TangentJobs = {};
+
+    // Parallel to Mesh::DeformableBatches
+    std::vector<const cgltf_primitive*> DeformablePrims = {};
+};
+
+struct DeferredInstance
+{
+    FauxRender::Scene*     pScene = nullptr;
+    FauxRender::SceneNode* pNode  = nullptr;
 };
 
 struct LoaderInternals
 {
-    std::filesystem::path                                            gltfPath     = "";
-    FauxRender::SceneGraph*                                          pTargetGraph = nullptr;
+    std::filesystem::path                                            gltfPath         = "";
+    FauxRender::SceneGraph*                                          pTargetGraph     = nullptr;
+    FauxRender::TextureStreamer*                                     pTextureStreamer = nullptr; // LoadOptions::pTextureStreamer
+    bool                                                             OptimizeMeshes   = false;   // LoadOptions::OptimizeMeshes
     std::unordered_map<const cgltf_mesh*, FauxRender::Mesh*>         MeshMap;
     std::unordered_map<const cgltf_material*, FauxRender::Material*> MaterialMap;
     std::unordered_map<FauxRender::Mesh*, BufferInfo>                MeshBufferInfo;
     std::unordered_map<const cgltf_texture*, FauxRender::Texture*>   TextureMap;
     std::unordered_map<const cgltf_image*, FauxRender::Image*>       ImageMap;
     std::unordered_map<const cgltf_sampler*, FauxRender::Sampler*>   SamplerMap;
+
+    // Set by LoadGLTFAsync(). Textures are created without images and
+    // geometry nodes aren't added to their scenes, both are recorded here
+    // so they can be filled in once the data is loaded.
+    bool                                                                       Progressive = false;
+    std::unordered_map<const cgltf_image*, std::vector<FauxRender::Texture*>>  DeferredImageTextures;
+    std::unordered_map<const FauxRender::Mesh*, std::vector<DeferredInstance>> DeferredInstances;
 };
 
 static GREXFormat ToGREXFormat(const cgltf_accessor* pAccessor)
@@ -306,6 +354,40 @@ static GREXFormat ToGREXFormat(const cgltf_accessor* pAccessor)
         return GREX_FORMAT_UNKNOWN;
     }
 
+    // KHR_mesh_quantization - vec3 attributes are padded to 4 byte aligned
+    // elements, so they map to the 4 component formats.
+    if (pAccessor->normalized)
+    {
+        // clang-format off
+        switch (pAccessor->type) {
+            default: return GREX_FORMAT_UNKNOWN;
+
+            case cgltf_type_vec2: {
+                switch (pAccessor->component_type) {
+                    default: return GREX_FORMAT_UNKNOWN;
+                    case cgltf_component_type_r_8   : return GREX_FORMAT_R8G8_SNORM;
+                    case cgltf_component_type_r_8u  : return GREX_FORMAT_R8G8_UNORM;
+                    case cgltf_component_type_r_16  : return GREX_FORMAT_R16G16_SNORM;
+                    case cgltf_component_type_r_16u : return GREX_FORMAT_R16G16_UNORM;
+                }
+            } break;
+
+            case cgltf_type_vec3:
+            case cgltf_type_vec4: {
+                switch (pAccessor->component_type) {
+                    default: return GREX_FORMAT_UNKNOWN;
+                    case cgltf_component_type_r_8   : return GREX_FORMAT_R8G8B8A8_SNORM;
+                    case cgltf_component_type_r_8u  : return GREX_FORMAT_R8G8B8A8_UNORM;
+                    case cgltf_component_type_r_16  : return GREX_FORMAT_R16G16B16A16_SNORM;
+                    case cgltf_component_type_r_16u : return GREX_FORMAT_R16G16B16A16_UNORM;
+                }
+            } break;
+        }
+        // clang-format on
+
+        return GREX_FORMAT_UNKNOWN;
+    }
+
     // clang-format off
     switch (pAccessor->type) {
         default: return GREX_FORMAT_UNKNOWN;
@@ -363,1665 +445,6115 @@ static GREXFormat ToGREXFormat(const cgltf_accessor* pAccessor)
     return GREX_FORMAT_UNKNOWN;
 }
 
-// =============================================================================
-// Scene
-// =============================================================================
-uint32_t Scene::GetGeometryNodeIndex(const FauxRender::SceneNode* pGeometryNode) const
+static GREXFormat ToGREXFloatFormat(const cgltf_accessor* pAccessor)
 {
-    auto it = std::find_if(
-        this->GeometryNodes.begin(),
-        this->GeometryNodes.end(),
-        [pGeometryNode](const auto& elem) -> bool {
-            bool match = (elem == pGeometryNode);
-            return match;
-        });
-    if (it != this->GeometryNodes.end())
-    {
-        auto index = std::distance(this->GeometryNodes.begin(), it);
-        return static_cast<uint32_t>(index);
+    // clang-format off
+    switch (pAccessor->type) {
+        default: return GREX_FORMAT_UNKNOWN;
+        case cgltf_type_scalar : return GREX_FORMAT_R32_FLOAT;
+        case cgltf_type_vec2   : return GREX_FORMAT_R32G32_FLOAT;
+        case cgltf_type_vec3   : return GREX_FORMAT_R32G32B32_FLOAT;
+        case cgltf_type_vec4   : return GREX_FORMAT_R32G32B32A32_FLOAT;
     }
-    return UINT32_MAX;
+    // clang-format on
 }
 
-// =============================================================================
-// SceneGraph
-// =============================================================================
-bool SceneGraph::InitializeDefaults()
+static uint32_t GetGLTFComponentSize(cgltf_component_type componentType)
 {
-    // Defafault base color image
-    {
-        const uint8_t          pixel[4]   = {0xFF, 0x00, 0xFF, 0x00};
-        std::vector<MipOffset> mipOffsets = {
-            MipOffset{0, sizeof(pixel)}
-        };
+    // clang-format off
+    switch (componentType) {
+        default: return 0;
+        case cgltf_component_type_r_8   : return 1;
+        case cgltf_component_type_r_8u  : return 1;
+        case cgltf_component_type_r_16  : return 2;
+        case cgltf_component_type_r_16u : return 2;
+        case cgltf_component_type_r_32u : return 4;
+        case cgltf_component_type_r_32f : return 4;
+    }
+    // clang-format on
+}
 
-        bool res = this->CreateImage(1, 1, GREX_FORMAT_R8G8B8A8_UNORM, mipOffsets, sizeof(pixel), pixel, &this->pDefaultBaseColorImage);
-        if (!res)
-        {
-            assert(false && "failed to create default base color image");
-            return false;
-        }
+// Normalization follows the glTF spec: signed values are clamped to -1
+static float NormalizeGLTFComponent(float value, cgltf_component_type componentType)
+{
+    // clang-format off
+    switch (componentType) {
+        default: return value;
+        case cgltf_component_type_r_8   : return std::max(value / 127.0f, -1.0f);
+        case cgltf_component_type_r_8u  : return value / 255.0f;
+        case cgltf_component_type_r_16  : return std::max(value / 32767.0f, -1.0f);
+        case cgltf_component_type_r_16u : return value / 65535.0f;
     }
+    // clang-format on
+}
 
-    // Default metallic roughness image
+static float ReadGLTFComponent(const char* pSrc, cgltf_component_type componentType, bool normalized)
+{
+    float value = 0;
+    switch (componentType)
     {
-        const uint8_t          pixel[4]   = {0xFF, 0x00, 0x00, 0x00};
-        std::vector<MipOffset> mipOffsets = {
-            MipOffset{0, sizeof(pixel)}
-        };
+        default: break;
+        case cgltf_component_type_r_8: {
+            int8_t component = 0;
+            memcpy(&component, pSrc, sizeof(component));
+            value = static_cast<float>(component);
+        }
+        break;
 
-        bool res = this->CreateImage(1, 1, GREX_FORMAT_R8G8B8A8_UNORM, mipOffsets, sizeof(pixel), pixel, &this->pDefaultMetallicRoughnessImage);
-        if (!res)
-        {
-            assert(false && "failed to create default ARM image");
-            return false;
+        case cgltf_component_type_r_8u: {
+            uint8_t component = 0;
+            memcpy(&component, pSrc, sizeof(component));
+            value = static_cast<float>(component);
         }
-    }
+        break;
 
-    // Default normal image
-    {
-        const uint8_t          pixel[4]   = {0x00, 0x00, 0x00, 0x00};
-        std::vector<MipOffset> mipOffsets = {
-            MipOffset{0, sizeof(pixel)}
-        };
+        case cgltf_component_type_r_16: {
+            int16_t component = 0;
+            memcpy(&component, pSrc, sizeof(component));
+            value = static_cast<float>(component);
+        }
+        break;
 
-        bool res = this->CreateImage(1, 1, GREX_FORMAT_R8G8B8A8_UNORM, mipOffsets, sizeof(pixel), pixel, &this->pDefaultNormalImage);
-        if (!res)
-        {
-            assert(false && "failed to create default normal image");
-            return false;
+        case cgltf_component_type_r_16u: {
+            uint16_t component = 0;
+            memcpy(&component, pSrc, sizeof(component));
+            value = static_cast<float>(component);
         }
-    }
+        break;
 
-    // Default occlusion image
-    {
-        const uint8_t          pixel[4]   = {0xFF, 0xFF, 0xFF, 0x00};
-        std::vector<MipOffset> mipOffsets = {
-            MipOffset{0, sizeof(pixel)}
-        };
+        case cgltf_component_type_r_32u: {
+            uint32_t component = 0;
+            memcpy(&component, pSrc, sizeof(component));
+            value = static_cast<float>(component);
+        }
+        break;
 
-        bool res = this->CreateImage(1, 1, GREX_FORMAT_R8G8B8A8_UNORM, mipOffsets, sizeof(pixel), pixel, &this->pDefaultOcclusionImage);
-        if (!res)
-        {
-            assert(false && "failed to create default normal image");
-            return false;
+        case cgltf_component_type_r_32f: {
+            memcpy(&value, pSrc, sizeof(value));
         }
+        break;
     }
 
-    // Default emissive image
-    {
-        const uint8_t          pixel[4]   = {0x00, 0x00, 0x00, 0x00};
-        std::vector<MipOffset> mipOffsets = {
-            MipOffset{0, sizeof(pixel)}
-        };
+    return normalized ? NormalizeGLTFComponent(value, componentType) : value;
+}
 
-        bool res = this->CreateImage(1, 1, GREX_FORMAT_R8G8B8A8_UNORM, mipOffsets, sizeof(pixel), pixel, &this->pDefaultEmissiveImage);
-        if (!res)
-        {
-            assert(false && "failed to create default emissive image");
-            return false;
-        }
+// Buffer views decoded by DecodeGLTFMeshoptBuffers() have their own data
+static const char* GetGLTFBufferViewData(const cgltf_buffer_view* pGltfBufferView)
+{
+    if (!IsNull(pGltfBufferView->data))
+    {
+        return static_cast<const char*>(pGltfBufferView->data);
     }
+    return static_cast<const char*>(pGltfBufferView->buffer->data) + pGltfBufferView->offset;
+}
 
-    // Default clamped sampler
+static void CopyGLTFRange(const BufferCopyRange& copyRange, char* pDstData)
+{
+    if (!IsNull(copyRange.pGeneratedData))
     {
-        bool res = this->CreateSampler(
-            FauxRender::FILTER_MODE_LINEAR,
-            FauxRender::FILTER_MODE_LINEAR,
-            FauxRender::FILTER_MODE_LINEAR,
-            FauxRender::TEXTURE_ADDRESS_MODE_CLAMP,
-            FauxRender::TEXTURE_ADDRESS_MODE_CLAMP,
-            FauxRender::TEXTURE_ADDRESS_MODE_CLAMP,
-            &this->pDefaultClampedSampler);
-        if (!res)
-        {
-            assert(false && "failed to create default clamped sampler");
-            return false;
-        }
+        memcpy(pDstData + copyRange.TargetOffset, copyRange.pGeneratedData, copyRange.Size);
+        return;
     }
 
-    // Default repeat sampler
+    const char* pSrcAddress = GetGLTFBufferViewData(copyRange.pGltfBufferView) + copyRange.GltfOffset;
+    char*       pDstAddress = pDstData + copyRange.TargetOffset;
+
+    const cgltf_accessor* pAccessor = copyRange.pDequantizeAccessor;
+    if (IsNull(pAccessor))
     {
-        bool res = this->CreateSampler(
-            FauxRender::FILTER_MODE_LINEAR,
-            FauxRender::FILTER_MODE_LINEAR,
-            FauxRender::FILTER_MODE_LINEAR,
-            FauxRender::TEXTURE_ADDRESS_MODE_WRAP,
-            FauxRender::TEXTURE_ADDRESS_MODE_WRAP,
-            FauxRender::TEXTURE_ADDRESS_MODE_WRAP,
-            &this->pDefaultRepeatSampler);
-        if (!res)
-        {
-            assert(false && "failed to create default clamped sampler");
-            return false;
-        }
+        memcpy(pDstAddress, pSrcAddress, copyRange.Size);
+        return;
     }
 
-    return true;
-}
-
-static mat4 CalculateTranformMatrix(const FauxRender::SceneNode* pNode)
-{
-    mat4 T           = glm::translate(pNode->Translate);
-    mat4 R           = glm::toMat4(pNode->Rotation);
-    mat4 S           = glm::scale(pNode->Scale);
-    mat4 xformMatrix = T * R * S;
-    return xformMatrix;
-}
+    const uint32_t numComponents = static_cast<uint32_t>(cgltf_num_components(pAccessor->type));
+    const uint32_t componentSize = GetGLTFComponentSize(pAccessor->component_type);
 
-static mat4 EvaluateTransforMatrix(const FauxRender::SceneNode* pNode, const FauxRender::SceneGraph* pGraph)
-{
-    mat4 parentMatrix = mat4(1);
-    if (pNode->Parent != UINT32_MAX)
+    float* pDstComponent = reinterpret_cast<float*>(pDstAddress);
+    for (size_t i = 0; i < pAccessor->count; ++i)
     {
-        auto pParentNode = pGraph->Nodes[pNode->Parent].get();
-        parentMatrix     = EvaluateTransforMatrix(pParentNode, pGraph);
+        const char* pSrcElement = pSrcAddress + i * pAccessor->stride;
+        for (uint32_t c = 0; c < numComponents; ++c)
+        {
+            *pDstComponent = ReadGLTFComponent(pSrcElement + c * componentSize, pAccessor->component_type, pAccessor->normalized);
+            ++pDstComponent;
+        }
     }
-    auto xformMatrix     = CalculateTranformMatrix(pNode);
-    auto evaluatedMatrix = parentMatrix * xformMatrix;
-    return evaluatedMatrix;
 }
 
-bool SceneGraph::InitializeResources()
+// =============================================================================
+// EXT_meshopt_compression
+// =============================================================================
+static bool DecodeGLTFMeshoptBufferView(const cgltf_data* pGltfData, cgltf_buffer_view* pGltfBufferView)
 {
-    // Camera args
-    for (size_t sceneIdx = 0; sceneIdx < this->Scenes.size(); ++sceneIdx)
+    const auto& compression = pGltfBufferView->meshopt_compression;
+    if (IsNull(compression.buffer) || IsNull(compression.buffer->data))
     {
-        auto pScene = this->Scenes[sceneIdx].get();
-
-        Shader::CameraParams args = {};
-        // Fill out camera args
-        if (!IsNull(pScene->pActiveCamera))
-        {
-            auto pCameraNode = pScene->pActiveCamera;
+        return false;
+    }
 
-            vec3 eyePosition   = pCameraNode->Translate;
-            vec3 lookDirection = glm::toMat4(pCameraNode->Rotation) * vec4(0, 0, -1, 0);
-            vec3 center        = eyePosition + lookDirection;
+    const unsigned char* pSrcData = static_cast<const unsigned char*>(compression.buffer->data) + compression.offset;
+    const size_t         dstSize  = compression.count * compression.stride;
 
-            mat4 viewMat     = glm::lookAt(eyePosition, center, vec3(0, 1, 0));
-            mat4 projMat     = glm::perspective(pCameraNode->Camera.FovY, pCameraNode->Camera.AspectRatio, pCameraNode->Camera.NearClip, pCameraNode->Camera.FarClip);
-            mat4 viewProjMat = projMat * viewMat;
+    // cgltf_free() releases cgltf_buffer_view::data with the same allocator
+    void* pDstData = pGltfData->memory.alloc_func(pGltfData->memory.user_data, dstSize);
+    if (IsNull(pDstData))
+    {
+        return false;
+    }
 
-            args.ViewProjectionMatrix = viewProjMat;
-            args.EyePosition          = eyePosition;
+    int res = -1;
+    switch (compression.mode)
+    {
+        default: break;
+        case cgltf_meshopt_compression_mode_attributes: {
+            res = meshopt_decodeVertexBuffer(pDstData, compression.count, compression.stride, pSrcData, compression.size);
         }
+        break;
 
-        // Buffer size
-        const uint32_t bufferSize = Align<uint32_t>(sizeof(Shader::CameraParams), 256);
+        case cgltf_meshopt_compression_mode_triangles: {
+            res = meshopt_decodeIndexBuffer(pDstData, compression.count, compression.stride, pSrcData, compression.size);
+        }
+        break;
 
-        // Create buffer and populate data
-        bool res = this->CreateBuffer(
-            bufferSize,                   // bufferSize
-            sizeof(Shader::CameraParams), // srcSize
-            &args,                        // pSrcData
-            true,                         // mappable
-            &pScene->pCameraArgs);        // ppBuffer
-        if (!res)
-        {
-            assert(false && "failed to create buffer for camera args");
-            return false;
+        case cgltf_meshopt_compression_mode_indices: {
+            res = meshopt_decodeIndexSequence(pDstData, compression.count, compression.stride, pSrcData, compression.size);
         }
+        break;
     }
 
-    // Instance buffer
-    for (size_t sceneIdx = 0; sceneIdx < this->Scenes.size(); ++sceneIdx)
+    if (res != 0)
     {
-        auto pScene = this->Scenes[sceneIdx].get();
+        pGltfData->memory.free_func(pGltfData->memory.user_data, pDstData);
+        return false;
+    }
 
-        std::vector<Shader::InstanceParams> instanceBufferData;
-        for (size_t nodeIdx = 0; nodeIdx < pScene->GeometryNodes.size(); ++nodeIdx)
-        {
-            auto pNode    = pScene->GeometryNodes[nodeIdx];
-            mat4 modelMat = EvaluateTransforMatrix(pNode, this);
+    switch (compression.filter)
+    {
+        default: break;
+        case cgltf_meshopt_compression_filter_octahedral: meshopt_decodeFilterOct(pDstData, compression.count, compression.stride); break;
+        case cgltf_meshopt_compression_filter_quaternion: meshopt_decodeFilterQuat(pDstData, compression.count, compression.stride); break;
+        case cgltf_meshopt_compression_filter_exponential: meshopt_decodeFilterExp(pDstData, compression.count, compression.stride); break;
+    }
 
-            Shader::InstanceParams params = {};
-            params.ModelMatrix            = modelMat;
-            params.NormalMatrix           = mat4(mat3(modelMat));
+    pGltfBufferView->data = pDstData;
 
-            instanceBufferData.push_back(params);
-        }
+    return true;
+}
 
-        // Buffer size
-        const uint32_t bufferSize = static_cast<uint32_t>(SizeInBytes(instanceBufferData));
+//
+// Decodes every compressed buffer view into cgltf_buffer_view::data, after
+// which the loader reads them like any other buffer view. Buffer views are
+// independent of each other so they're decoded in parallel. Must be called
+// after cgltf_load_buffers().
+//
+static bool DecodeGLTFMeshoptBuffers(cgltf_data* pGltfData)
+{
+    GREX_PROFILE_FUNCTION();
 
-        // Create buffer and populate data
-        bool res = this->CreateBuffer(
-            bufferSize,                  // bufferSize
-            bufferSize,                  // srcSize
-            DataPtr(instanceBufferData), // pSrcData
-            true,                        // mappable
-            &pScene->pInstanceBuffer);   // ppBuffer
-        if (!res)
+    std::vector<cgltf_buffer_view*> gltfBufferViews;
+    for (size_t viewIdx = 0; viewIdx < pGltfData->buffer_views_count; ++viewIdx)
+    {
+        auto& gltfBufferView = pGltfData->buffer_views[viewIdx];
+        if (gltfBufferView.has_meshopt_compression && IsNull(gltfBufferView.data))
         {
-            assert(false && "failed to create buffer for instances");
-            return false;
+            gltfBufferViews.push_back(&gltfBufferView);
         }
     }
 
-    // Material buffer
+    if (gltfBufferViews.empty())
     {
-        std::vector<Shader::MaterialParams> materialBufferData;
-        for (size_t materialIdx = 0; materialIdx < this->Materials.size(); ++materialIdx)
-        {
-            auto pMaterial = this->Materials[materialIdx].get();
-
-            Shader::MaterialParams params   = {};
-            params.MaterialFlags            = 0;
-            params.BaseColor                = pMaterial->BaseColor;
-            params.MetallicFactor           = pMaterial->MetallicFactor;
-            params.RoughnessFactor          = pMaterial->RoughnessFactor;
-            params.BaseColorTexture         = {0, 0};
-            params.MetallicRoughnessTexture = {0, 0};
-            params.NormalTexture            = {0, 0};
-            params.EmissiveTexture          = {0, 0};
-            params.TexCoordTranslate        = {0, 0};
-            params.TexCoordRotate           = 0;
-            params.TexCoordScale            = {1, 1};
-
-            if (!IsNull(pMaterial->pBaseColorTexture))
-            {
-                params.MaterialFlags |= Shader::MATERIAL_FLAG_BASE_COLOR_TEXTURE;
-                params.BaseColorTexture.ImageIndex   = this->GetImageIndex(pMaterial->pBaseColorTexture->pImage);
-                params.BaseColorTexture.SamplerIndex = this->GetSamplerIndex(this->pDefaultRepeatSampler);
-
-                if (params.BaseColorTexture.ImageIndex == UINT32_MAX)
-                {
-                    params.BaseColorTexture.ImageIndex = this->GetImageIndex(this->pDefaultBaseColorImage);
-                }
-            }
-
-            if (!IsNull(pMaterial->pMetallicRoughnessTexture))
-            {
-                params.MaterialFlags |= Shader::MATERIAL_FLAG_METALLIC_ROUGHNESS_TEXTURE;
-                params.MetallicRoughnessTexture.ImageIndex   = this->GetImageIndex(pMaterial->pMetallicRoughnessTexture->pImage);
-                params.MetallicRoughnessTexture.SamplerIndex = this->GetSamplerIndex(this->pDefaultRepeatSampler);
+        return true;
+    }
 
-                if (params.MetallicRoughnessTexture.ImageIndex == UINT32_MAX)
-                {
-                    params.MetallicRoughnessTexture.ImageIndex = this->GetImageIndex(this->pDefaultMetallicRoughnessImage);
-                }
-            }
+    std::atomic<bool> failed = false;
 
-            if (!IsNull(pMaterial->pNormalTexture))
+    JobSystem::Get().ParallelFor(0, CountU32(gltfBufferViews), 1, [&](uint32_t begin, uint32_t end) {
+        for (uint32_t viewIdx = begin; viewIdx < end; ++viewIdx)
+        {
+            if (!DecodeGLTFMeshoptBufferView(pGltfData, gltfBufferViews[viewIdx]))
             {
-                params.MaterialFlags |= Shader::MATERIAL_FLAG_NORMAL_TEXTURE;
-                params.NormalTexture.ImageIndex   = this->GetImageIndex(pMaterial->pNormalTexture->pImage);
-                params.NormalTexture.SamplerIndex = this->GetSamplerIndex(this->pDefaultRepeatSampler);
-
-                if (params.NormalTexture.ImageIndex == UINT32_MAX)
-                {
-                    params.NormalTexture.ImageIndex = this->GetImageIndex(this->pDefaultNormalImage);
-                }
+                failed = true;
             }
+        }
+    });
 
-            // UV transform
-            params.TexCoordTranslate = pMaterial->TexCoordTranslate;
-            params.TexCoordRotate    = pMaterial->TexCoordRotate;
-            params.TexCoordScale     = pMaterial->TexCoordScale;
+    if (failed)
+    {
+        GREX_LOG_ERROR("EXT_meshopt_compression: failed to decode buffer views");
+        return false;
+    }
 
-            materialBufferData.push_back(params);
-        }
+    GREX_LOG_INFO("    Decoded " << gltfBufferViews.size() << " EXT_meshopt_compression buffer views");
 
-        // Buffer size
-        const uint32_t bufferSize = static_cast<uint32_t>(SizeInBytes(materialBufferData));
+    return true;
+}
 
-        // Create buffer and populate data
-        bool res = this->CreateBuffer(
-            bufferSize,                  // bufferSize
-            bufferSize,                  // srcSize
-            DataPtr(materialBufferData), // pSrcData
-            true,                        // mappable
-            &this->pMaterialBuffer);     // ppBuffer
-        if (!res)
+// =============================================================================
+// Tangent generation
+// =============================================================================
+//
+// glTF requires clients to generate MikkTSpace tangents for primitives
+// that have a normal map but no TANGENT attribute. Generation needs
+// positions, normals, the first set of tex coords and indices.
+//
+static const cgltf_accessor* FindGLTFAttribute(const cgltf_primitive* pGltfPrim, cgltf_attribute_type type, int index)
+{
+    for (size_t gltfAttrIdx = 0; gltfAttrIdx < pGltfPrim->attributes_count; ++gltfAttrIdx)
+    {
+        const auto& gltfAttr = pGltfPrim->attributes[gltfAttrIdx];
+        if ((gltfAttr.type == type) && (gltfAttr.index == index))
         {
-            assert(false && "failed to create buffer for instances");
-            return false;
+            return gltfAttr.data;
         }
     }
+    return nullptr;
+}
 
-    return true;
+static bool CanGenerateGLTFTangents(const cgltf_primitive* pGltfPrim)
+{
+    return (pGltfPrim->type == cgltf_primitive_type_triangles) &&
+           !IsNull(pGltfPrim->indices) &&
+           !IsNull(FindGLTFAttribute(pGltfPrim, cgltf_attribute_type_position, 0)) &&
+           !IsNull(FindGLTFAttribute(pGltfPrim, cgltf_attribute_type_normal, 0)) &&
+           !IsNull(FindGLTFAttribute(pGltfPrim, cgltf_attribute_type_texcoord, 0)) &&
+           IsNull(FindGLTFAttribute(pGltfPrim, cgltf_attribute_type_tangent, 0));
 }
 
-uint32_t SceneGraph::GetMaterialIndex(const FauxRender::Material* pMaterial) const
+static void ReadGLTFElement(const cgltf_accessor* pAccessor, uint32_t index, float* pDst, uint32_t dstCount)
 {
-    auto it = std::find_if(
-        this->Materials.begin(),
-        this->Materials.end(),
-        [pMaterial](const auto& elem) -> bool {
-            bool match = (elem.get() == pMaterial);
-            return match;
-        });
-    if (it != this->Materials.end())
+    const uint32_t numComponents = std::min(static_cast<uint32_t>(cgltf_num_components(pAccessor->type)), dstCount);
+    const uint32_t componentSize = GetGLTFComponentSize(pAccessor->component_type);
+    const char*    pSrcElement   = GetGLTFBufferViewData(pAccessor->buffer_view) + pAccessor->offset + index * pAccessor->stride;
+
+    for (uint32_t c = 0; c < numComponents; ++c)
     {
-        auto index = std::distance(this->Materials.begin(), it);
-        return static_cast<uint32_t>(index);
+        pDst[c] = ReadGLTFComponent(pSrcElement + c * componentSize, pAccessor->component_type, pAccessor->normalized);
     }
-    return UINT32_MAX;
 }
 
-uint32_t SceneGraph::GetImageIndex(const FauxRender::Image* pImage) const
+static uint32_t ReadGLTFIndex(const cgltf_accessor* pAccessor, uint32_t index)
 {
-    auto it = std::find_if(
-        this->Images.begin(),
-        this->Images.end(),
-        [pImage](const auto& elem) -> bool {
-            bool match = (elem.get() == pImage);
-            return match;
-        });
-    if (it != this->Images.end())
+    const char* pSrc = GetGLTFBufferViewData(pAccessor->buffer_view) + pAccessor->offset + index * pAccessor->stride;
+
+    // clang-format off
+    switch (pAccessor->component_type)
     {
-        auto index = std::distance(this->Images.begin(), it);
-        return static_cast<uint32_t>(index);
+        default: break;
+        case cgltf_component_type_r_8u  : return *reinterpret_cast<const uint8_t*>(pSrc);
+        case cgltf_component_type_r_16u : return *reinterpret_cast<const uint16_t*>(pSrc);
+        case cgltf_component_type_r_32u : return *reinterpret_cast<const uint32_t*>(pSrc);
     }
-    return UINT32_MAX;
+    // clang-format on
+
+    return 0;
 }
 
-uint32_t SceneGraph::GetSamplerIndex(const FauxRender::Sampler* pSampler) const
+struct GLTFTangentContext
 {
-    auto it = std::find_if(
-        this->Samplers.begin(),
-        this->Samplers.end(),
-        [pSampler](const auto& elem) -> bool {
-            bool match = (elem.get() == pSampler);
-            return match;
-        });
-    if (it != this->Samplers.end())
+    TangentJob*           pJob       = nullptr;
+    const cgltf_accessor* pIndices   = nullptr;
+    const cgltf_accessor* pPositions = nullptr;
+    const cgltf_accessor* pNormals   = nullptr;
+    const cgltf_accessor* pTexCoords = nullptr;
+
+    uint32_t GetVertexIndex(int iFace, int iVert) const
     {
-        auto index = std::distance(this->Samplers.begin(), it);
-        return static_cast<uint32_t>(index);
+        return ReadGLTFIndex(this->pIndices, static_cast<uint32_t>(3 * iFace + iVert));
     }
-    return UINT32_MAX;
-}
 
-bool SceneGraph::CreateSampler(
-    FauxRender::FilterMode         minFilter,
-    FauxRender::FilterMode         magFilter,
-    FauxRender::FilterMode         mipFilter,
-    FauxRender::TextureAddressMode addressU,
-    FauxRender::TextureAddressMode addressV,
-    FauxRender::TextureAddressMode addressW,
-    FauxRender::Sampler**          ppSampler)
-{
-    if (IsNull(ppSampler))
+    static const GLTFTangentContext* Get(const SMikkTSpaceContext* pContext)
     {
-        return false;
+        return static_cast<const GLTFTangentContext*>(pContext->m_pUserData);
     }
 
-    auto object = std::make_unique<FauxRender::Sampler>();
-    if (!object)
+    static int GetNumFaces(const SMikkTSpaceContext* pContext)
     {
-        return false;
+        return static_cast<int>(Get(pContext)->pIndices->count / 3);
     }
 
-    object->MinFilter = minFilter;
-    object->MagFilter = magFilter;
-    object->MipFilter = mipFilter;
-    object->AddressU  = addressU;
-    object->AddressV  = addressV;
-    object->AddressW  = addressW;
+    static int GetNumVerticesOfFace(const SMikkTSpaceContext*, const int)
+    {
+        return 3;
+    }
 
-    *ppSampler = object.get();
+    static void GetPosition(const SMikkTSpaceContext* pContext, float fvPosOut[], const int iFace, const int iVert)
+    {
+        auto pTangentContext = Get(pContext);
+        ReadGLTFElement(pTangentContext->pPositions, pTangentContext->GetVertexIndex(iFace, iVert), fvPosOut, 3);
+    }
 
-    this->Samplers.push_back(std::move(object));
+    static void GetNormal(const SMikkTSpaceContext* pContext, float fvNormOut[], const int iFace, const int iVert)
+    {
+        auto pTangentContext = Get(pContext);
+        ReadGLTFElement(pTangentContext->pNormals, pTangentContext->GetVertexIndex(iFace, iVert), fvNormOut, 3);
+    }
 
-    return true;
+    static void GetTexCoord(const SMikkTSpaceContext* pContext, float fvTexcOut[], const int iFace, const int iVert)
+    {
+        auto pTangentContext = Get(pContext);
+        ReadGLTFElement(pTangentContext->pTexCoords, pTangentContext->GetVertexIndex(iFace, iVert), fvTexcOut, 2);
+    }
+
+    // fSign matches glTF's TANGENT.w: bitangent = cross(normal, tangent.xyz) * w
+    static void SetTSpaceBasic(const SMikkTSpaceContext* pContext, const float fvTangent[], const float fSign, const int iFace, const int iVert)
+    {
+        auto     pTangentContext = Get(pContext);
+        uint32_t vIdx            = pTangentContext->GetVertexIndex(iFace, iVert);
+        if (vIdx < pTangentContext->pJob->Tangents.size())
+        {
+            pTangentContext->pJob->Tangents[vIdx] = vec4(fvTangent[0], fvTangent[1], fvTangent[2], fSign);
+        }
+    }
+};
+
+static bool GenerateGLTFTangents(TangentJob* pJob)
+{
+    const cgltf_primitive* pGltfPrim = pJob->pGltfPrim;
+
+    GLTFTangentContext tangentContext = {};
+    tangentContext.pJob               = pJob;
+    tangentContext.pIndices           = pGltfPrim->indices;
+    tangentContext.pPositions         = FindGLTFAttribute(pGltfPrim, cgltf_attribute_type_position, 0);
+    tangentContext.pNormals           = FindGLTFAttribute(pGltfPrim, cgltf_attribute_type_normal, 0);
+    tangentContext.pTexCoords         = FindGLTFAttribute(pGltfPrim, cgltf_attribute_type_texcoord, 0);
+
+    // Vertices that no triangle references keep the default tangent
+    pJob->Tangents.assign(tangentContext.pPositions->count, vec4(1, 0, 0, 1));
+
+    SMikkTSpaceInterface callbacks   = {};
+    callbacks.m_getNumFaces          = GLTFTangentContext::GetNumFaces;
+    callbacks.m_getNumVerticesOfFace = GLTFTangentContext::GetNumVerticesOfFace;
+    callbacks.m_getPosition          = GLTFTangentContext::GetPosition;
+    callbacks.m_getNormal            = GLTFTangentContext::GetNormal;
+    callbacks.m_getTexCoord          = GLTFTangentContext::GetTexCoord;
+    callbacks.m_setTSpaceBasic       = GLTFTangentContext::SetTSpaceBasic;
+
+    SMikkTSpaceContext context = {};
+    context.m_pInterface       = &callbacks;
+    context.m_pUserData        = &tangentContext;
+
+    return genTangSpaceDefault(&context) != 0;
 }
 
-static bool LoadGLTFMesh(
-    LoaderInternals*               pInternals,
-    const FauxRender::LoadOptions& loadOptions,
-    const cgltf_data*              pGltfData,
-    const cgltf_mesh*              pGltfMesh,
-    FauxRender::Mesh*              pTargetMesh)
+//
+// Primitives are independent of each other so they're processed in
+// parallel. Each job's copy range is pointed at the generated tangents,
+// the jobs must stay alive until the mesh data has been copied. Must be
+// called after DecodeGLTFMeshoptBuffers().
+//
+static void GenerateGLTFTangents(const std::vector<BufferInfo*>& bufferInfos, uint32_t numThreads)
 {
-    if (IsNull(pInternals) || IsNull(pGltfData) || IsNull(pGltfMesh) || IsNull(pTargetMesh))
+    GREX_PROFILE_FUNCTION();
+
+    std::vector<std::pair<BufferInfo*, TangentJob*>> jobs;
+    for (auto pBufferInfo : bufferInfos)
     {
-        return false;
+        for (auto& job : pBufferInfo->TangentJobs)
+        {
+            jobs.push_back({pBufferInfo, &job});
+        }
     }
 
-    auto pTargetGraph = pInternals->pTargetGraph;
+    if (jobs.empty())
+    {
+        return;
+    }
 
-    // Name
-    pTargetMesh->Name = !IsNull(pGltfMesh->name) ? pGltfMesh->name : "";
-    GREX_LOG_INFO("    Loading mesh: " << pTargetMesh->Name);
+    std::atomic<uint32_t> numFailures = 0;
 
-    // Mesh's buffer info
-    auto& targetBufferInfo = pInternals->MeshBufferInfo[pTargetMesh];
+    JobSystem::Get().ParallelFor(
+        0,
+        CountU32(jobs),
+        1,
+        [&](uint32_t begin, uint32_t end) {
+            for (uint32_t jobIdx = begin; jobIdx < end; ++jobIdx)
+            {
+                if (!GenerateGLTFTangents(jobs[jobIdx].second))
+                {
+                    ++numFailures;
+                }
+            }
+        },
+        numThreads);
 
-    // Buffer size
-    uint32_t& targetBufferSize = targetBufferInfo.BufferSize;
-    targetBufferSize           = 0;
+    // Failed jobs still have their default tangents
+    for (auto& job : jobs)
+    {
+        auto& copyRange          = job.first->CopyRanges[job.second->CopyRangeIndex];
+        copyRange.pGeneratedData = reinterpret_cast<const char*>(DataPtr(job.second->Tangents));
+    }
 
-    // Primitives
-    for (size_t gltfPrimIdx = 0; gltfPrimIdx < pGltfMesh->primitives_count; ++gltfPrimIdx)
+    if (numFailures > 0)
     {
-        // GLTF primitive
-        auto& gltfPrim = pGltfMesh->primitives[gltfPrimIdx];
+        GREX_LOG_WARN("    MikkTSpace failed for " << numFailures << " primitives, using default tangents");
+    }
 
-        // GLTF Material
-        auto& pGltfMaterial = gltfPrim.material;
+    GREX_LOG_INFO("    Generated tangents for " << jobs.size() << " primitives");
+}
 
-        // Target batch
-        pTargetMesh->DrawBatches.push_back({});
-        auto& targetBatch = pTargetMesh->DrawBatches.back();
+// =============================================================================
+// Mesh optimization
+// =============================================================================
+//
+// Totals over a mesh's batches, so the ratios are weighted by the size of
+// each batch.
+//
+struct MeshOptimizeStats
+{
+    uint64_t NumTriangles        = 0;
+    uint64_t NumVertices         = 0;
+    uint64_t VerticesTransformed = 0;
+    uint64_t PixelsCovered       = 0;
+    uint64_t PixelsShaded        = 0;
+
+    float GetACMR() const { return (this->NumTriangles > 0) ? static_cast<float>(this->VerticesTransformed) / static_cast<float>(this->NumTriangles) : 0.0f; }
+    float GetATVR() const { return (this->NumVertices > 0) ? static_cast<float>(this->VerticesTransformed) / static_cast<float>(this->NumVertices) : 0.0f; }
+    float GetOverdraw() const { return (this->PixelsCovered > 0) ? static_cast<float>(this->PixelsShaded) / static_cast<float>(this->PixelsCovered) : 0.0f; }
+};
 
-        // Material
-        //
-        // @TODO: Do we neeed a default material for objects
-        //        that don't have a material?
-        //
-        if (!IsNull(pGltfMaterial))
-        {
-            FauxRender::Material* pTargetMaterial = nullptr;
-            auto                  it              = pInternals->MaterialMap.find(gltfPrim.material);
-            if (it != pInternals->MaterialMap.end())
-            {
-                pTargetMaterial = (*it).second;
-            }
-            else
-            {
-                auto targetMaterial = std::make_unique<FauxRender::Material>();
-                if (!targetMaterial)
-                {
-                    assert(false && "allocation failed: FauxRender::Material");
-                    return false;
-                }
+// Same cache size meshopt_optimizeVertexCache() optimizes for
+const uint32_t kVertexCacheSize = 16;
 
-                // Get pointer to target material
-                pTargetMaterial = targetMaterial.get();
+static void AnalyzeBatch(
+    const std::vector<uint32_t>& indices,
+    const float*                 pPositions,
+    uint32_t                     positionStride,
+    uint32_t                     vertexCount,
+    MeshOptimizeStats*           pStats)
+{
+    auto cacheStats = meshopt_analyzeVertexCache(indices.data(), indices.size(), vertexCount, kVertexCacheSize, 0, 0);
 
-                // Update map
-                pInternals->MaterialMap[pGltfMaterial] = pTargetMaterial;
+    pStats->NumTriangles += indices.size() / 3;
+    pStats->NumVertices += vertexCount;
+    pStats->VerticesTransformed += cacheStats.vertices_transformed;
 
-                // Add target material to graph
-                pTargetGraph->Materials.push_back(std::move(targetMaterial));
-            }
+    if (!IsNull(pPositions))
+    {
+        auto overdrawStats = meshopt_analyzeOverdraw(indices.data(), indices.size(), pPositions, vertexCount, positionStride);
 
-            targetBatch.pMaterial = pTargetMaterial;
-        }
+        pStats->PixelsCovered += overdrawStats.pixels_covered;
+        pStats->PixelsShaded += overdrawStats.pixels_shaded;
+    }
+}
 
-        // Index data
+//
+// Reorders the batch's triangles for the vertex cache and then for
+// overdraw, and its vertices for fetch locality. Works in place on the
+// mesh's data after the copy ranges have been applied. Vertex counts and
+// buffer views don't change, unreferenced vertices are moved to the end.
+//
+static void OptimizeBatch(const FauxRender::PrimitiveBatch& batch, char* pMeshData, MeshOptimizeStats* pBefore, MeshOptimizeStats* pAfter)
+{
+    const auto&    indexView   = batch.IndexBufferView;
+    const uint32_t vertexCount = batch.PositionBufferView.Count;
+    if ((indexView.Count == 0) || ((indexView.Count % 3) != 0) || (vertexCount == 0))
+    {
+        return;
+    }
+
+    // Indices
+    std::vector<uint32_t> indices(indexView.Count);
+    {
+        const char* pSrc = pMeshData + indexView.Offset;
+        for (uint32_t i = 0; i < indexView.Count; ++i, pSrc += indexView.Stride)
         {
-            // Data chunks should be on 16 byte alignment
-            targetBufferSize = Align<uint32_t>(targetBufferSize, 16);
+            // clang-format off
+            switch (indexView.Stride)
+            {
+                default: assert(false && "unsupported index stride"); break;
+                case 1 : indices[i] = *reinterpret_cast<const uint8_t*>(pSrc); break;
+                case 2 : indices[i] = *reinterpret_cast<const uint16_t*>(pSrc); break;
+                case 4 : indices[i] = *reinterpret_cast<const uint32_t*>(pSrc); break;
+            }
+            // clang-format on
+        }
+    }
 
-            const auto& pGltfIndexData   = gltfPrim.indices;
-            const auto& pGltfBufferView  = pGltfIndexData->buffer_view;
-            auto&       targetBufferView = targetBatch.IndexBufferView;
+    // Overdraw needs float positions, quantized positions are only cache
+    // and fetch optimized
+    const auto&  positionView = batch.PositionBufferView;
+    const float* pPositions   = nullptr;
+    if ((positionView.Format == GREX_FORMAT_R32G32B32_FLOAT) || (positionView.Format == GREX_FORMAT_R32G32B32A32_FLOAT))
+    {
+        pPositions = reinterpret_cast<const float*>(pMeshData + positionView.Offset);
+    }
 
-            // Target format
-            auto targetFormat = ToGREXFormat(pGltfIndexData);
-            assert((targetFormat != GREX_FORMAT_UNKNOWN) && "invalid position attribute format");
+    AnalyzeBatch(indices, pPositions, positionView.Stride, vertexCount, pBefore);
 
-            // Fill out destination buffer view
-            const uint32_t gltfStride = static_cast<uint32_t>(pGltfIndexData->stride);
-            const uint32_t gltfCount  = static_cast<uint32_t>(pGltfIndexData->count);
-            //
-            targetBufferView.Offset = targetBufferSize;
-            targetBufferView.Size   = gltfCount * gltfStride;
-            targetBufferView.Stride = gltfStride;
-            targetBufferView.Format = targetFormat;
-            targetBufferView.Count  = gltfCount;
+    // Vertex cache, then overdraw
+    std::vector<uint32_t> optimizedIndices(indices.size());
+    meshopt_optimizeVertexCache(optimizedIndices.data(), indices.data(), indices.size(), vertexCount);
+    if (!IsNull(pPositions))
+    {
+        meshopt_optimizeOverdraw(indices.data(), optimizedIndices.data(), optimizedIndices.size(), pPositions, vertexCount, positionView.Stride, 1.05f);
+    }
+    else
+    {
+        indices.swap(optimizedIndices);
+    }
 
-            // Increment destination buffer offset
-            targetBufferSize += targetBufferView.Size;
+    // Vertex fetch - every vertex attribute of the batch is moved the same way
+    std::vector<uint32_t> remap(vertexCount);
+    uint32_t              nextVertex = static_cast<uint32_t>(meshopt_optimizeVertexFetchRemap(remap.data(), indices.data(), indices.size(), vertexCount));
+    for (auto& newIdx : remap)
+    {
+        if (newIdx == UINT32_MAX)
+        {
+            newIdx = nextVertex++;
+        }
+    }
 
-            // Build copy range
-            const uint32_t gltfBufferViewOffset = static_cast<uint32_t>(pGltfBufferView->offset);
-            const uint32_t gltfAccessorOffset   = static_cast<uint32_t>(pGltfIndexData->offset);
-            //
-            BufferCopyRange copyRange = {};
-            copyRange.pGltfBuffer     = pGltfBufferView->buffer;
-            copyRange.GltfOffset      = gltfBufferViewOffset + gltfAccessorOffset;
-            copyRange.TargetOffset    = targetBufferView.Offset;
-            copyRange.Size            = targetBufferView.Size;
+    const FauxRender::BufferView* vertexViews[] = {
+        &batch.PositionBufferView,
+        &batch.VertexColorBufferView,
+        &batch.TexCoordBufferView,
+        &batch.NormalBufferView,
+        &batch.TangentBufferView,
+    };
 
-            // Add copy range
-            targetBufferInfo.CopyRanges.push_back(copyRange);
+    std::vector<char> remapped;
+    for (auto pView : vertexViews)
+    {
+        if ((pView->Format == GREX_FORMAT_UNKNOWN) || (pView->Count != vertexCount))
+        {
+            continue;
         }
 
-        // Vertex data
-        for (size_t gltfAttrIdx = 0; gltfAttrIdx < gltfPrim.attributes_count; ++gltfAttrIdx)
+        char* pData = pMeshData + pView->Offset;
+        remapped.resize(pView->Size);
+        for (uint32_t i = 0; i < vertexCount; ++i)
         {
-            // Data chunks should be on 16 byte alignment
-            targetBufferSize = Align<uint32_t>(targetBufferSize, 16);
+            memcpy(remapped.data() + remap[i] * pView->Stride, pData + i * pView->Stride, pView->Stride);
+        }
+        memcpy(pData, remapped.data(), pView->Size);
+    }
 
-            const auto& gltfAttr          = gltfPrim.attributes[gltfAttrIdx];
-            const auto& pGltfVertexData   = gltfAttr.data;
-            const auto& pGltfBufferView   = pGltfVertexData->buffer_view;
-            BufferView* pTargetBufferView = nullptr;
+    for (auto& index : indices)
+    {
+        index = remap[index];
+    }
 
-            // Target format
-            auto targetFormat = ToGREXFormat(pGltfVertexData);
-            assert((targetFormat != GREX_FORMAT_UNKNOWN) && "invalid position attribute format");
+    AnalyzeBatch(indices, pPositions, positionView.Stride, vertexCount, pAfter);
 
-            // Determine attribute
-            switch (gltfAttr.type)
+    // Write indices back in their original format
+    {
+        char* pDst = pMeshData + indexView.Offset;
+        for (uint32_t i = 0; i < indexView.Count; ++i, pDst += indexView.Stride)
+        {
+            // clang-format off
+            switch (indexView.Stride)
             {
-                default: {
-                    assert(false && "unsupported attribute type");
-                }
-                break;
+                default: break;
+                case 1 : *reinterpret_cast<uint8_t*>(pDst)  = static_cast<uint8_t>(indices[i]); break;
+                case 2 : *reinterpret_cast<uint16_t*>(pDst) = static_cast<uint16_t>(indices[i]); break;
+                case 4 : *reinterpret_cast<uint32_t*>(pDst) = indices[i]; break;
+            }
+            // clang-format on
+        }
+    }
+}
 
-                case cgltf_attribute_type_position: {
-                    pTargetBufferView = &targetBatch.PositionBufferView;
-                    // assert((dstFormat != GREX_FORMAT_UNKNOWN) && "invalid position attribute format");
-                }
-                break;
+static void OptimizeMeshData(const FauxRender::Mesh* pMesh, char* pMeshData)
+{
+    MeshOptimizeStats before = {};
+    MeshOptimizeStats after  = {};
+    for (uint32_t batchIdx = 0; batchIdx < CountU32(pMesh->DrawBatches); ++batchIdx)
+    {
+        // Deformable batches index their joints, weights and morph targets
+        // by the glTF vertex order, leave them alone
+        auto it = std::find_if(
+            pMesh->DeformableBatches.begin(),
+            pMesh->DeformableBatches.end(),
+            [batchIdx](const FauxRender::DeformableBatch& deformable) { return deformable.BatchIndex == batchIdx; });
+        if (it != pMesh->DeformableBatches.end())
+        {
+            continue;
+        }
 
-                case cgltf_attribute_type_normal: {
-                    if (loadOptions.EnableNormals)
-                    {
-                        pTargetBufferView = &targetBatch.NormalBufferView;
-                        // assert((dstFormat != GREX_FORMAT_UNKNOWN) && "invalid normal attribute format");
-                    }
-                }
-                break;
+        OptimizeBatch(pMesh->DrawBatches[batchIdx], pMeshData, &before, &after);
+    }
 
-                case cgltf_attribute_type_tangent: {
-                    if (loadOptions.EnableTangents)
-                    {
-                        pTargetBufferView = &targetBatch.TangentBufferView;
-                        // assert((dstFormat != GREX_FORMAT_UNKNOWN) && "invalid tangent attribute format");
-                    }
-                }
-                break;
+    GREX_LOG_INFO("    Optimized mesh: " << pMesh->Name
+                                         << " ACMR " << before.GetACMR() << " -> " << after.GetACMR()
+                                         << ", ATVR " << before.GetATVR() << " -> " << after.GetATVR()
+                                         << ", overdraw " << before.GetOverdraw() << " -> " << after.GetOverdraw());
+}
 
-                case cgltf_attribute_type_texcoord: {
-                    if (loadOptions.EnableTexCoords)
-                    {
-                        pTargetBufferView = &targetBatch.TexCoordBufferView;
-                        // assert((dstFormat != GREX_FORMAT_UNKNOWN) && "invalid tex coord attribute format");
-                    }
-                }
-                break;
+// =============================================================================
+// AABB
+// =============================================================================
+float AABB::SurfaceArea() const
+{
+    vec3 d = this->Max - this->Min;
+    return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+}
+
+bool AABB::Contains(const FauxRender::AABB& other) const
+{
+    return glm::all(glm::lessThanEqual(this->Min, other.Min)) && glm::all(glm::greaterThanEqual(this->Max, other.Max));
+}
+
+void AABB::Expand(const FauxRender::AABB& other)
+{
+    this->Min = glm::min(this->Min, other.Min);
+    this->Max = glm::max(this->Max, other.Max);
+}
+
+FauxRender::AABB AABB::Transform(const glm::mat4& matrix) const
+{
+    if (!this->IsValid())
+    {
+        return {};
+    }
+
+    // Transform the center and project the extent onto the new axes
+    vec3 center = vec3(matrix * vec4(this->Center(), 1));
+    mat3 absM   = mat3(glm::abs(vec3(matrix[0])), glm::abs(vec3(matrix[1])), glm::abs(vec3(matrix[2])));
+    vec3 extent = absM * this->Extent();
+
+    FauxRender::AABB bounds = {};
+    bounds.Min              = center - extent;
+    bounds.Max              = center + extent;
+    return bounds;
+}
+
+static FauxRender::AABB Union(const FauxRender::AABB& a, const FauxRender::AABB& b)
+{
+    FauxRender::AABB bounds = a;
+    bounds.Expand(b);
+    return bounds;
+}
+
+// =============================================================================
+// PrimitiveBatch
+// =============================================================================
+uint32_t PrimitiveBatch::GetVertexLayout() const
+{
+    uint32_t layout = 0;
+    layout |= (this->PositionBufferView.Format != GREX_FORMAT_UNKNOWN) ? VERTEX_LAYOUT_POSITION : 0;
+    layout |= (this->VertexColorBufferView.Format != GREX_FORMAT_UNKNOWN) ? VERTEX_LAYOUT_VERTEX_COLOR : 0;
+    layout |= (this->TexCoordBufferView.Format != GREX_FORMAT_UNKNOWN) ? VERTEX_LAYOUT_TEX_COORD : 0;
+    layout |= (this->NormalBufferView.Format != GREX_FORMAT_UNKNOWN) ? VERTEX_LAYOUT_NORMAL : 0;
+    layout |= (this->TangentBufferView.Format != GREX_FORMAT_UNKNOWN) ? VERTEX_LAYOUT_TANGENT : 0;
+    return layout;
+}
+
+// =============================================================================
+// SceneNode
+// =============================================================================
+FauxRender::Buffer* SceneNode::GetDrawBuffer() const
+{
+    if (!IsNull(this->pDeformedBuffer))
+    {
+        return this->pDeformedBuffer;
+    }
+    return !IsNull(this->pMesh) ? this->pMesh->pBuffer : nullptr;
+}
+
+// =============================================================================
+// SlotTable
+// =============================================================================
+uint32_t SlotTable::Allocate()
+{
+    uint32_t slot = UINT32_MAX;
+    if (!this->FreeSlots.empty())
+    {
+        slot = this->FreeSlots.back();
+        this->FreeSlots.pop_back();
+    }
+    else
+    {
+        slot = this->NumSlots;
+        ++this->NumSlots;
+        this->Live.push_back(false);
+
+        if (this->NumSlots > this->Capacity)
+        {
+            this->Capacity = std::max(this->MinCapacity, 2 * this->Capacity);
+        }
+    }
+
+    this->Live[slot] = true;
+    ++this->Count;
+
+    this->MarkDirty(slot);
+
+    return slot;
+}
+
+void SlotTable::Free(uint32_t slot)
+{
+    assert(this->IsLive(slot) && "slot is not allocated");
+    if (!this->IsLive(slot))
+    {
+        return;
+    }
+
+    this->Live[slot] = false;
+    --this->Count;
+    this->FreeSlots.push_back(slot);
+
+    // Freed slots are zeroed on upload
+    this->MarkDirty(slot);
+}
+
+bool SlotTable::IsLive(uint32_t slot) const
+{
+    return (slot < this->NumSlots) && this->Live[slot];
+}
+
+void SlotTable::MarkDirty(uint32_t slot)
+{
+    this->DirtyBegin = std::min(this->DirtyBegin, slot);
+    this->DirtyEnd   = std::max(this->DirtyEnd, slot + 1);
+}
+
+void SlotTable::MarkAllDirty()
+{
+    this->DirtyBegin = 0;
+    this->DirtyEnd   = this->NumSlots;
+}
+
+bool SlotTable::IsDirty() const
+{
+    return (this->DirtyBegin < this->DirtyEnd);
+}
+
+void SlotTable::ClearDirty()
+{
+    this->DirtyBegin = UINT32_MAX;
+    this->DirtyEnd   = 0;
+}
+
+// =============================================================================
+// SceneBVH
+// =============================================================================
+void SceneBVH::Update(uint32_t instanceIndex, const FauxRender::AABB& worldBounds)
+{
+    if (instanceIndex >= this->InstanceLeaves.size())
+    {
+        this->InstanceLeaves.resize(instanceIndex + 1, UINT32_MAX);
+        this->UnboundedPositions.resize(instanceIndex + 1, UINT32_MAX);
+    }
+
+    uint32_t leaf = this->InstanceLeaves[instanceIndex];
+
+    // Instances without bounds can't be culled
+    if (!worldBounds.IsValid())
+    {
+        if (leaf != UINT32_MAX)
+        {
+            this->RemoveLeaf(leaf);
+            this->FreeNode(leaf);
+            this->InstanceLeaves[instanceIndex] = UINT32_MAX;
+        }
+
+        if (this->UnboundedPositions[instanceIndex] == UINT32_MAX)
+        {
+            this->UnboundedPositions[instanceIndex] = CountU32(this->UnboundedInstances);
+            this->UnboundedInstances.push_back(instanceIndex);
+        }
+        return;
+    }
+
+    this->RemoveUnbounded(instanceIndex);
+
+    if (leaf != UINT32_MAX)
+    {
+        // Still inside the fat box, nothing to do
+        if (this->Nodes[leaf].Bounds.Contains(worldBounds))
+        {
+            return;
+        }
+        this->RemoveLeaf(leaf);
+    }
+    else
+    {
+        leaf                                = this->AllocateNode();
+        this->InstanceLeaves[instanceIndex] = leaf;
+    }
+
+    vec3 margin = worldBounds.Extent() * (2.0f * this->FatMargin) + vec3(1e-4f);
+
+    auto& node         = this->Nodes[leaf];
+    node.Bounds.Min    = worldBounds.Min - margin;
+    node.Bounds.Max    = worldBounds.Max + margin;
+    node.InstanceIndex = instanceIndex;
+
+    this->InsertLeaf(leaf);
+}
+
+void SceneBVH::Remove(uint32_t instanceIndex)
+{
+    this->RemoveUnbounded(instanceIndex);
+
+    if (instanceIndex >= this->InstanceLeaves.size())
+    {
+        return;
+    }
+
+    uint32_t leaf = this->InstanceLeaves[instanceIndex];
+    if (leaf == UINT32_MAX)
+    {
+        return;
+    }
+
+    this->RemoveLeaf(leaf);
+    this->FreeNode(leaf);
+    this->InstanceLeaves[instanceIndex] = UINT32_MAX;
+}
+
+uint32_t SceneBVH::AllocateNode()
+{
+    uint32_t nodeIndex = UINT32_MAX;
+    if (!this->FreeNodes.empty())
+    {
+        nodeIndex = this->FreeNodes.back();
+        this->FreeNodes.pop_back();
+        this->Nodes[nodeIndex] = {};
+    }
+    else
+    {
+        nodeIndex = CountU32(this->Nodes);
+        this->Nodes.emplace_back();
+    }
+    return nodeIndex;
+}
+
+void SceneBVH::FreeNode(uint32_t nodeIndex)
+{
+    this->Nodes[nodeIndex] = {};
+    this->FreeNodes.push_back(nodeIndex);
+}
+
+void SceneBVH::InsertLeaf(uint32_t leaf)
+{
+    if (this->Root == UINT32_MAX)
+    {
+        this->Root               = leaf;
+        this->Nodes[leaf].Parent = UINT32_MAX;
+        return;
+    }
+
+    // Find the sibling that minimizes the surface area added to the tree
+    const FauxRender::AABB leafBounds = this->Nodes[leaf].Bounds;
+
+    uint32_t index = this->Root;
+    while (!this->Nodes[index].IsLeaf())
+    {
+        const auto& node = this->Nodes[index];
+
+        float area         = node.Bounds.SurfaceArea();
+        float combinedArea = Union(node.Bounds, leafBounds).SurfaceArea();
+
+        // Cost of making a new parent for this node and the leaf
+        float cost = 2.0f * combinedArea;
+
+        // Minimum cost of pushing the leaf further down the tree
+        float inheritanceCost = 2.0f * (combinedArea - area);
+
+        auto childCost = [&](uint32_t child) -> float {
+            const auto& childBounds = this->Nodes[child].Bounds;
+            float       newArea     = Union(childBounds, leafBounds).SurfaceArea();
+            if (this->Nodes[child].IsLeaf())
+            {
+                return newArea + inheritanceCost;
+            }
+            return (newArea - childBounds.SurfaceArea()) + inheritanceCost;
+        };
+
+        float costLeft  = childCost(node.Left);
+        float costRight = childCost(node.Right);
+
+        if ((cost < costLeft) && (cost < costRight))
+        {
+            break;
+        }
+
+        index = (costLeft < costRight) ? node.Left : node.Right;
+    }
+
+    // Create a new parent for the sibling and the leaf
+    uint32_t sibling   = index;
+    uint32_t oldParent = this->Nodes[sibling].Parent;
+    uint32_t newParent = this->AllocateNode();
+
+    this->Nodes[newParent].Parent = oldParent;
+    this->Nodes[newParent].Bounds = Union(this->Nodes[sibling].Bounds, leafBounds);
+    this->Nodes[newParent].Left   = sibling;
+    this->Nodes[newParent].Right  = leaf;
+    this->Nodes[sibling].Parent   = newParent;
+    this->Nodes[leaf].Parent      = newParent;
+
+    if (oldParent != UINT32_MAX)
+    {
+        if (this->Nodes[oldParent].Left == sibling)
+        {
+            this->Nodes[oldParent].Left = newParent;
+        }
+        else
+        {
+            this->Nodes[oldParent].Right = newParent;
+        }
+    }
+    else
+    {
+        this->Root = newParent;
+    }
+
+    // Refit ancestors
+    for (uint32_t i = oldParent; i != UINT32_MAX; i = this->Nodes[i].Parent)
+    {
+        auto& node  = this->Nodes[i];
+        node.Bounds = Union(this->Nodes[node.Left].Bounds, this->Nodes[node.Right].Bounds);
+    }
+}
+
+void SceneBVH::RemoveLeaf(uint32_t leaf)
+{
+    if (leaf == this->Root)
+    {
+        this->Root = UINT32_MAX;
+        return;
+    }
+
+    uint32_t parent      = this->Nodes[leaf].Parent;
+    uint32_t grandParent = this->Nodes[parent].Parent;
+    uint32_t sibling     = (this->Nodes[parent].Left == leaf) ? this->Nodes[parent].Right : this->Nodes[parent].Left;
+
+    if (grandParent != UINT32_MAX)
+    {
+        // Replace the parent with the sibling
+        if (this->Nodes[grandParent].Left == parent)
+        {
+            this->Nodes[grandParent].Left = sibling;
+        }
+        else
+        {
+            this->Nodes[grandParent].Right = sibling;
+        }
+        this->Nodes[sibling].Parent = grandParent;
+
+        // Refit ancestors
+        for (uint32_t i = grandParent; i != UINT32_MAX; i = this->Nodes[i].Parent)
+        {
+            auto& node  = this->Nodes[i];
+            node.Bounds = Union(this->Nodes[node.Left].Bounds, this->Nodes[node.Right].Bounds);
+        }
+    }
+    else
+    {
+        this->Root                  = sibling;
+        this->Nodes[sibling].Parent = UINT32_MAX;
+    }
+
+    this->FreeNode(parent);
+    this->Nodes[leaf].Parent = UINT32_MAX;
+}
+
+void SceneBVH::RemoveUnbounded(uint32_t instanceIndex)
+{
+    if ((instanceIndex >= this->UnboundedPositions.size()) || (this->UnboundedPositions[instanceIndex] == UINT32_MAX))
+    {
+        return;
+    }
+
+    // Move the last entry into the removed one's position
+    const uint32_t position = this->UnboundedPositions[instanceIndex];
+    const uint32_t last     = this->UnboundedInstances.back();
+
+    this->UnboundedInstances[position] = last;
+    this->UnboundedPositions[last]     = position;
+    this->UnboundedInstances.pop_back();
+    this->UnboundedPositions[instanceIndex] = UINT32_MAX;
+}
+
+// =============================================================================
+// Scene
+// =============================================================================
+uint32_t Scene::GetGeometryNodeIndex(const FauxRender::SceneNode* pGeometryNode) const
+{
+    if (IsNull(pGeometryNode) || (pGeometryNode->Index >= this->GeometryNodeIndices.size()))
+    {
+        return UINT32_MAX;
+    }
+    return this->GeometryNodeIndices[pGeometryNode->Index];
+}
+
+uint32_t Scene::AddGeometryNode(FauxRender::SceneNode* pGeometryNode)
+{
+    assert((pGeometryNode != nullptr) && "pGeometryNode is NULL");
+    assert((pGeometryNode->Type == FauxRender::SCENE_NODE_TYPE_GEOMETRY) && "node is not of drawable type");
+    assert((this->GetGeometryNodeIndex(pGeometryNode) == UINT32_MAX) && "node is already in scene");
+
+    uint32_t instanceIndex = this->InstanceSlots.Allocate();
+    if (instanceIndex < this->GeometryNodes.size())
+    {
+        this->GeometryNodes[instanceIndex] = pGeometryNode;
+    }
+    else
+    {
+        this->GeometryNodes.push_back(pGeometryNode);
+    }
+
+    if (pGeometryNode->Index >= this->GeometryNodeIndices.size())
+    {
+        this->GeometryNodeIndices.resize(pGeometryNode->Index + 1, UINT32_MAX);
+    }
+    this->GeometryNodeIndices[pGeometryNode->Index] = instanceIndex;
+
+    return instanceIndex;
+}
+
+void Scene::RemoveGeometryNode(const FauxRender::SceneNode* pGeometryNode)
+{
+    uint32_t instanceIndex = this->GetGeometryNodeIndex(pGeometryNode);
+    if (instanceIndex == UINT32_MAX)
+    {
+        return;
+    }
+
+    this->InstanceSlots.Free(instanceIndex);
+    this->BVH.Remove(instanceIndex);
+    this->GeometryNodes[instanceIndex]              = nullptr;
+    this->GeometryNodeIndices[pGeometryNode->Index] = UINT32_MAX;
+}
+
+void Scene::UpdateGeometryNode(const FauxRender::SceneNode* pGeometryNode)
+{
+    uint32_t instanceIndex = this->GetGeometryNodeIndex(pGeometryNode);
+    if (instanceIndex == UINT32_MAX)
+    {
+        return;
+    }
+
+    this->InstanceSlots.MarkDirty(instanceIndex);
+}
+
+// =============================================================================
+// SceneGraph
+// =============================================================================
+bool SceneGraph::InitializeDefaults()
+{
+    // Defafault base color image
+    {
+        const uint8_t          pixel[4]   = {0xFF, 0x00, 0xFF, 0x00};
+        std::vector<MipOffset> mipOffsets = {
+            MipOffset{0, sizeof(pixel)}
+        };
+
+        bool res = this->CreateImage(1, 1, GREX_FORMAT_R8G8B8A8_UNORM, mipOffsets, sizeof(pixel), pixel, &this->pDefaultBaseColorImage);
+        if (!res)
+        {
+            assert(false && "failed to create default base color image");
+            return false;
+        }
+    }
+
+    // Default metallic roughness image
+    {
+        const uint8_t          pixel[4]   = {0xFF, 0x00, 0x00, 0x00};
+        std::vector<MipOffset> mipOffsets = {
+            MipOffset{0, sizeof(pixel)}
+        };
+
+        bool res = this->CreateImage(1, 1, GREX_FORMAT_R8G8B8A8_UNORM, mipOffsets, sizeof(pixel), pixel, &this->pDefaultMetallicRoughnessImage);
+        if (!res)
+        {
+            assert(false && "failed to create default ARM image");
+            return false;
+        }
+    }
+
+    // Default normal image
+    {
+        const uint8_t          pixel[4]   = {0x00, 0x00, 0x00, 0x00};
+        std::vector<MipOffset> mipOffsets = {
+            MipOffset{0, sizeof(pixel)}
+        };
+
+        bool res = this->CreateImage(1, 1, GREX_FORMAT_R8G8B8A8_UNORM, mipOffsets, sizeof(pixel), pixel, &this->pDefaultNormalImage);
+        if (!res)
+        {
+            assert(false && "failed to create default normal image");
+            return false;
+        }
+    }
+
+    // Default occlusion image
+    {
+        const uint8_t          pixel[4]   = {0xFF, 0xFF, 0xFF, 0x00};
+        std::vector<MipOffset> mipOffsets = {
+            MipOffset{0, sizeof(pixel)}
+        };
+
+        bool res = this->CreateImage(1, 1, GREX_FORMAT_R8G8B8A8_UNORM, mipOffsets, sizeof(pixel), pixel, &this->pDefaultOcclusionImage);
+        if (!res)
+        {
+            assert(false && "failed to create default normal image");
+            return false;
+        }
+    }
+
+    // Default emissive image
+    {
+        const uint8_t          pixel[4]   = {0x00, 0x00, 0x00, 0x00};
+        std::vector<MipOffset> mipOffsets = {
+            MipOffset{0, sizeof(pixel)}
+        };
+
+        bool res = this->CreateImage(1, 1, GREX_FORMAT_R8G8B8A8_UNORM, mipOffsets, sizeof(pixel), pixel, &this->pDefaultEmissiveImage);
+        if (!res)
+        {
+            assert(false && "failed to create default emissive image");
+            return false;
+        }
+    }
+
+    // Default clamped sampler
+    {
+        bool res = this->CreateSampler(
+            FauxRender::FILTER_MODE_LINEAR,
+            FauxRender::FILTER_MODE_LINEAR,
+            FauxRender::FILTER_MODE_LINEAR,
+            FauxRender::TEXTURE_ADDRESS_MODE_CLAMP,
+            FauxRender::TEXTURE_ADDRESS_MODE_CLAMP,
+            FauxRender::TEXTURE_ADDRESS_MODE_CLAMP,
+            &this->pDefaultClampedSampler);
+        if (!res)
+        {
+            assert(false && "failed to create default clamped sampler");
+            return false;
+        }
+    }
+
+    // Default repeat sampler
+    {
+        bool res = this->CreateSampler(
+            FauxRender::FILTER_MODE_LINEAR,
+            FauxRender::FILTER_MODE_LINEAR,
+            FauxRender::FILTER_MODE_LINEAR,
+            FauxRender::TEXTURE_ADDRESS_MODE_WRAP,
+            FauxRender::TEXTURE_ADDRESS_MODE_WRAP,
+            FauxRender::TEXTURE_ADDRESS_MODE_WRAP,
+            &this->pDefaultRepeatSampler);
+        if (!res)
+        {
+            assert(false && "failed to create default clamped sampler");
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static mat4 CalculateTranformMatrix(const FauxRender::SceneNode* pNode)
+{
+    mat4 T           = glm::translate(pNode->Translate);
+    mat4 R           = glm::toMat4(pNode->Rotation);
+    mat4 S           = glm::scale(pNode->Scale);
+    mat4 xformMatrix = T * R * S;
+    return xformMatrix;
+}
+
+static mat4 EvaluateTransforMatrix(const FauxRender::SceneNode* pNode, const FauxRender::SceneGraph* pGraph)
+{
+    mat4 parentMatrix = mat4(1);
+    if (pNode->Parent != UINT32_MAX)
+    {
+        auto pParentNode = &pGraph->Nodes[pNode->Parent];
+        parentMatrix     = EvaluateTransforMatrix(pParentNode, pGraph);
+    }
+    auto xformMatrix     = CalculateTranformMatrix(pNode);
+    auto evaluatedMatrix = parentMatrix * xformMatrix;
+    return evaluatedMatrix;
+}
+
+static Shader::InstanceParams ToInstanceParams(const FauxRender::SceneNode* pNode, const FauxRender::SceneGraph* pGraph)
+{
+    mat4 modelMat = EvaluateTransforMatrix(pNode, pGraph);
+
+    Shader::InstanceParams params = {};
+    params.ModelMatrix            = modelMat;
+    params.NormalMatrix           = mat4(mat3(modelMat));
+
+    return params;
+}
+
+static Shader::MaterialParams ToMaterialParams(const FauxRender::Material* pMaterial, const FauxRender::SceneGraph* pGraph)
+{
+    Shader::MaterialParams params   = {};
+    params.MaterialFlags            = 0;
+    params.BaseColor                = pMaterial->BaseColor;
+    params.MetallicFactor           = pMaterial->MetallicFactor;
+    params.RoughnessFactor          = pMaterial->RoughnessFactor;
+    params.BaseColorTexture         = {0, 0};
+    params.MetallicRoughnessTexture = {0, 0};
+    params.NormalTexture            = {0, 0};
+    params.EmissiveTexture          = {0, 0};
+    params.TexCoordTranslate        = {0, 0};
+    params.TexCoordRotate           = 0;
+    params.TexCoordScale            = {1, 1};
+
+    if (!IsNull(pMaterial->pBaseColorTexture))
+    {
+        params.MaterialFlags |= Shader::MATERIAL_FLAG_BASE_COLOR_TEXTURE;
+        params.BaseColorTexture.ImageIndex   = pGraph->GetImageIndex(pMaterial->pBaseColorTexture->pImage);
+        params.BaseColorTexture.SamplerIndex = pGraph->GetSamplerIndex(pGraph->pDefaultRepeatSampler);
+
+        if (params.BaseColorTexture.ImageIndex == UINT32_MAX)
+        {
+            params.BaseColorTexture.ImageIndex = pGraph->GetImageIndex(pGraph->pDefaultBaseColorImage);
+        }
+    }
+
+    if (!IsNull(pMaterial->pMetallicRoughnessTexture))
+    {
+        params.MaterialFlags |= Shader::MATERIAL_FLAG_METALLIC_ROUGHNESS_TEXTURE;
+        params.MetallicRoughnessTexture.ImageIndex   = pGraph->GetImageIndex(pMaterial->pMetallicRoughnessTexture->pImage);
+        params.MetallicRoughnessTexture.SamplerIndex = pGraph->GetSamplerIndex(pGraph->pDefaultRepeatSampler);
+
+        if (params.MetallicRoughnessTexture.ImageIndex == UINT32_MAX)
+        {
+            params.MetallicRoughnessTexture.ImageIndex = pGraph->GetImageIndex(pGraph->pDefaultMetallicRoughnessImage);
+        }
+    }
+
+    if (!IsNull(pMaterial->pNormalTexture))
+    {
+        params.MaterialFlags |= Shader::MATERIAL_FLAG_NORMAL_TEXTURE;
+        params.NormalTexture.ImageIndex   = pGraph->GetImageIndex(pMaterial->pNormalTexture->pImage);
+        params.NormalTexture.SamplerIndex = pGraph->GetSamplerIndex(pGraph->pDefaultRepeatSampler);
+
+        if (params.NormalTexture.ImageIndex == UINT32_MAX)
+        {
+            params.NormalTexture.ImageIndex = pGraph->GetImageIndex(pGraph->pDefaultNormalImage);
+        }
+    }
+
+    // UV transform
+    params.TexCoordTranslate = pMaterial->TexCoordTranslate;
+    params.TexCoordRotate    = pMaterial->TexCoordRotate;
+    params.TexCoordScale     = pMaterial->TexCoordScale;
+
+    return params;
+}
+
+// Moves a buffer from the graph's Buffers to RetiredBuffers
+static void RetireBuffer(FauxRender::SceneGraph* pGraph, FauxRender::Buffer* pBuffer)
+{
+    auto it = std::find_if(
+        pGraph->Buffers.begin(),
+        pGraph->Buffers.end(),
+        [pBuffer](const std::unique_ptr<FauxRender::Buffer>& elem) -> bool { return elem.get() == pBuffer; });
+    if (it != pGraph->Buffers.end())
+    {
+        pGraph->RetiredBuffers.push_back(std::move(*it));
+        pGraph->Buffers.erase(it);
+    }
+}
+
+//
+// Writes the table's dirty slots to pBuffers->Data and brings the next
+// copy up to date, see SlotTableBuffers. writeFn(slot, pParams) fills in a
+// live slot and is called once per dirty slot. A copy the table outgrew
+// is replaced and moves from the graph's Buffers to RetiredBuffers.
+// *ppBuffer is set to the current copy.
+//
+template <typename ParamsT, typename WriteFn>
+static bool UploadSlotTable(
+    FauxRender::SceneGraph*       pGraph,
+    FauxRender::SlotTable*        pSlots,
+    WriteFn                       writeFn,
+    FauxRender::SlotTableBuffers* pBuffers,
+    FauxRender::Buffer**          ppBuffer)
+{
+    const uint32_t requiredSize = pSlots->Capacity * static_cast<uint32_t>(sizeof(ParamsT));
+
+    // CPU side params, new slots start zeroed
+    if (pBuffers->Data.size() < requiredSize)
+    {
+        pBuffers->Data.resize(requiredSize);
+    }
+
+    if (pSlots->IsDirty())
+    {
+        ParamsT* pParams = reinterpret_cast<ParamsT*>(pBuffers->Data.data());
+        for (uint32_t slot = pSlots->DirtyBegin; slot < pSlots->DirtyEnd; ++slot)
+        {
+            pParams[slot] = {};
+            if (pSlots->IsLive(slot))
+            {
+                writeFn(slot, &pParams[slot]);
+            }
+        }
+
+        for (uint32_t i = 0; i < NUM_BUFFERED_FRAMES; ++i)
+        {
+            const bool clean        = (pBuffers->DirtyBegin[i] >= pBuffers->DirtyEnd[i]);
+            pBuffers->DirtyBegin[i] = clean ? pSlots->DirtyBegin : std::min(pBuffers->DirtyBegin[i], pSlots->DirtyBegin);
+            pBuffers->DirtyEnd[i]   = clean ? pSlots->DirtyEnd : std::max(pBuffers->DirtyEnd[i], pSlots->DirtyEnd);
+        }
+
+        pSlots->ClearDirty();
+    }
+
+    if (requiredSize == 0)
+    {
+        return true;
+    }
+
+    // Nothing to do if the current copy is up to date
+    uint32_t            index   = pBuffers->Current;
+    FauxRender::Buffer* pBuffer = pBuffers->Buffers[index];
+    if (!IsNull(pBuffer) && (pBuffer->Size >= requiredSize) && (pBuffers->DirtyBegin[index] >= pBuffers->DirtyEnd[index]))
+    {
+        *ppBuffer = pBuffer;
+        return true;
+    }
+
+    index   = (index + 1) % NUM_BUFFERED_FRAMES;
+    pBuffer = pBuffers->Buffers[index];
+
+    // Grow: write the whole table into a new buffer
+    if (IsNull(pBuffer) || (pBuffer->Size < requiredSize))
+    {
+        FauxRender::Buffer* pNewBuffer = nullptr;
+
+        bool res = pGraph->CreateBuffer(
+            requiredSize,            // bufferSize
+            requiredSize,            // srcSize
+            DataPtr(pBuffers->Data), // pSrcData
+            true,                    // mappable
+            &pNewBuffer);            // ppBuffer
+        if (!res)
+        {
+            return false;
+        }
+
+        if (!IsNull(pBuffer))
+        {
+            RetireBuffer(pGraph, pBuffer);
+        }
+        pBuffer = pNewBuffer;
+    }
+    // Partial update: only the copy's dirty range is written
+    else
+    {
+        void* pData = nullptr;
+        if (!pBuffer->Map(&pData))
+        {
+            return false;
+        }
+
+        const size_t offset = size_t(pBuffers->DirtyBegin[index]) * sizeof(ParamsT);
+        const size_t size   = size_t(pBuffers->DirtyEnd[index] - pBuffers->DirtyBegin[index]) * sizeof(ParamsT);
+        memcpy(static_cast<char*>(pData) + offset, pBuffers->Data.data() + offset, size);
+
+        pBuffer->Unmap();
+    }
+
+    pBuffers->Buffers[index]    = pBuffer;
+    pBuffers->DirtyBegin[index] = 0;
+    pBuffers->DirtyEnd[index]   = 0;
+    pBuffers->Current           = index;
+
+    *ppBuffer = pBuffer;
+    return true;
+}
+
+bool SceneGraph::InitializeResources()
+{
+    // Camera args
+    for (size_t sceneIdx = 0; sceneIdx < this->Scenes.size(); ++sceneIdx)
+    {
+        auto pScene = this->Scenes[sceneIdx].get();
+
+        Shader::CameraParams args = {};
+        // Fill out camera args
+        if (!IsNull(pScene->pActiveCamera))
+        {
+            auto pCameraNode = pScene->pActiveCamera;
+
+            vec3 eyePosition   = pCameraNode->Translate;
+            vec3 lookDirection = glm::toMat4(pCameraNode->Rotation) * vec4(0, 0, -1, 0);
+            vec3 center        = eyePosition + lookDirection;
+
+            mat4 viewMat     = glm::lookAt(eyePosition, center, vec3(0, 1, 0));
+            mat4 projMat     = glm::perspective(pCameraNode->Camera.FovY, pCameraNode->Camera.AspectRatio, pCameraNode->Camera.NearClip, pCameraNode->Camera.FarClip);
+            mat4 viewProjMat = projMat * viewMat;
+
+            args.ViewProjectionMatrix = viewProjMat;
+            args.EyePosition          = eyePosition;
+        }
+
+        // Buffer size
+        const uint32_t bufferSize = Align<uint32_t>(sizeof(Shader::CameraParams), 256);
+
+        // Create buffer and populate data
+        bool res = this->CreateBuffer(
+            bufferSize,                   // bufferSize
+            sizeof(Shader::CameraParams), // srcSize
+            &args,                        // pSrcData
+            true,                         // mappable
+            &pScene->pCameraArgs);        // ppBuffer
+        if (!res)
+        {
+            assert(false && "failed to create buffer for camera args");
+            return false;
+        }
+    }
+
+    // Instance buffers
+    for (size_t sceneIdx = 0; sceneIdx < this->Scenes.size(); ++sceneIdx)
+    {
+        if (!this->UpdateInstanceBuffer(this->Scenes[sceneIdx].get()))
+        {
+            return false;
+        }
+    }
+
+    // Material buffer
+    if (!this->UpdateMaterialBuffer())
+    {
+        return false;
+    }
+
+    return true;
+}
+
+bool SceneGraph::CreateDeformedBuffers()
+{
+    for (auto& node : this->Nodes)
+    {
+        if (IsNull(node.pMesh) || node.pMesh->DeformableBatches.empty() || !IsNull(node.pDeformedBuffer))
+        {
+            continue;
+        }
+
+        // Meshes that are still streaming in get theirs on a later call
+        if (IsNull(node.pMesh->pBuffer))
+        {
+            continue;
+        }
+
+        // Same layout as the mesh buffer so the batches' views apply to both
+        bool res = this->CreateBuffer(
+            node.pMesh->pBuffer,    // pSrcBuffer
+            true,                   // mappable
+            &node.pDeformedBuffer); // ppBuffer
+        if (!res)
+        {
+            assert(false && "failed to create deformed buffer");
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool SceneGraph::InitializeDrawList(const FauxRender::Scene* pScene, FauxRender::DrawList* pDrawList)
+{
+    if (IsNull(pScene) || IsNull(pDrawList))
+    {
+        return false;
+    }
+
+    // Reinitializing replaces the buffers of the previous list
+    this->DestroyDrawList(pDrawList);
+
+    // Instance buffer in draw order, one slot per instance
+    {
+        const uint32_t numInstances = CountU32(pDrawList->InstanceIndices);
+
+        pDrawList->InstanceSlots             = {};
+        pDrawList->InstanceSlots.MinCapacity = std::max(numInstances, 1u);
+        for (uint32_t i = 0; i < numInstances; ++i)
+        {
+            pDrawList->InstanceSlots.Allocate();
+        }
+
+        if (!this->UpdateDrawList(pScene, pDrawList))
+        {
+            assert(false && "failed to create buffer for draw list instances");
+            return false;
+        }
+    }
+
+    // Indirect arguments
+    if (!pDrawList->Draws.empty())
+    {
+        if (!this->CreateDrawListArgsBuffer(pDrawList, &pDrawList->pIndirectArgsBuffer))
+        {
+            assert(false && "failed to create buffer for draw list indirect args");
+            return false;
+        }
+    }
+
+    GREX_LOG_INFO("Draw list for scene '" << pScene->Name << "': " << pDrawList->NumNodeDraws << " node draws reduced to " << pDrawList->Draws.size() << " instanced draws");
+
+    return true;
+}
+
+bool SceneGraph::UpdateDrawList(const FauxRender::Scene* pScene, FauxRender::DrawList* pDrawList)
+{
+    if (IsNull(pScene) || IsNull(pDrawList))
+    {
+        return false;
+    }
+
+    //
+    // The scene's instance buffer data is already up to date, compare it
+    // against the list's copy so only the instances that changed are
+    // uploaded. Instances the scene's data doesn't cover yet are written
+    // as zeroes.
+    //
+    const size_t                  numSceneInstances = pScene->InstanceBuffers.Data.size() / sizeof(Shader::InstanceParams);
+    const Shader::InstanceParams* pSceneParams      = reinterpret_cast<const Shader::InstanceParams*>(pScene->InstanceBuffers.Data.data());
+    const Shader::InstanceParams* pListParams       = reinterpret_cast<const Shader::InstanceParams*>(pDrawList->InstanceBuffers.Data.data());
+    const size_t                  numListInstances  = pDrawList->InstanceBuffers.Data.size() / sizeof(Shader::InstanceParams);
+
+    const uint32_t numSlots = std::min(pDrawList->InstanceSlots.NumSlots, CountU32(pDrawList->InstanceIndices));
+    for (uint32_t slot = 0; slot < numSlots; ++slot)
+    {
+        const uint32_t instanceIndex = pDrawList->InstanceIndices[slot];
+        if ((instanceIndex >= numSceneInstances) || (slot >= numListInstances))
+        {
+            pDrawList->InstanceSlots.MarkDirty(slot);
+            continue;
+        }
+
+        if (memcmp(&pSceneParams[instanceIndex], &pListParams[slot], sizeof(Shader::InstanceParams)) != 0)
+        {
+            pDrawList->InstanceSlots.MarkDirty(slot);
+        }
+    }
+
+    auto writeFn = [pDrawList, pSceneParams, numSceneInstances](uint32_t slot, Shader::InstanceParams* pParams) {
+        const uint32_t instanceIndex = pDrawList->InstanceIndices[slot];
+        if (instanceIndex < numSceneInstances)
+        {
+            *pParams = pSceneParams[instanceIndex];
+        }
+    };
+
+    bool res = UploadSlotTable<Shader::InstanceParams>(this, &pDrawList->InstanceSlots, writeFn, &pDrawList->InstanceBuffers, &pDrawList->pInstanceBuffer);
+    if (!res)
+    {
+        assert(false && "failed to update draw list instance buffer");
+        return false;
+    }
+
+    return true;
+}
+
+void SceneGraph::DestroyDrawList(FauxRender::DrawList* pDrawList)
+{
+    if (IsNull(pDrawList))
+    {
+        return;
+    }
+
+    for (uint32_t i = 0; i < NUM_BUFFERED_FRAMES; ++i)
+    {
+        if (!IsNull(pDrawList->InstanceBuffers.Buffers[i]))
+        {
+            RetireBuffer(this, pDrawList->InstanceBuffers.Buffers[i]);
+        }
+    }
+
+    if (!IsNull(pDrawList->pIndirectArgsBuffer))
+    {
+        RetireBuffer(this, pDrawList->pIndirectArgsBuffer);
+    }
+
+    pDrawList->InstanceSlots       = {};
+    pDrawList->InstanceBuffers     = {};
+    pDrawList->pInstanceBuffer     = nullptr;
+    pDrawList->pIndirectArgsBuffer = nullptr;
+}
+
+bool SceneGraph::CreateDrawListArgsBuffer(const FauxRender::DrawList* pDrawList, FauxRender::Buffer** ppBuffer)
+{
+    const uint32_t bufferSize = static_cast<uint32_t>(SizeInBytes(pDrawList->IndirectArgs));
+
+    return this->CreateBuffer(
+        bufferSize,                       // bufferSize
+        bufferSize,                       // srcSize
+        DataPtr(pDrawList->IndirectArgs), // pSrcData
+        true,                             // mappable
+        ppBuffer);                        // ppBuffer
+}
+
+uint32_t SceneGraph::GetMaterialIndex(const FauxRender::Material* pMaterial) const
+{
+    if (IsNull(pMaterial) || (pMaterial->Index >= this->Materials.size()))
+    {
+        return UINT32_MAX;
+    }
+    assert((&this->Materials[pMaterial->Index] == pMaterial) && "material does not belong to graph");
+    return pMaterial->Index;
+}
+
+uint32_t SceneGraph::GetImageIndex(const FauxRender::Image* pImage) const
+{
+    if (IsNull(pImage) || (pImage->Index >= this->Images.size()))
+    {
+        return UINT32_MAX;
+    }
+    assert((this->Images[pImage->Index].get() == pImage) && "image does not belong to graph");
+    return pImage->Index;
+}
+
+uint32_t SceneGraph::GetSamplerIndex(const FauxRender::Sampler* pSampler) const
+{
+    if (IsNull(pSampler) || (pSampler->Index >= this->Samplers.size()))
+    {
+        return UINT32_MAX;
+    }
+    assert((this->Samplers[pSampler->Index].get() == pSampler) && "sampler does not belong to graph");
+    return pSampler->Index;
+}
+
+FauxRender::Image* SceneGraph::GetDescriptorImage(uint32_t slot) const
+{
+    if ((slot < this->Images.size()) && this->Images[slot])
+    {
+        return this->Images[slot].get();
+    }
+    return this->pDefaultBaseColorImage;
+}
+
+bool SceneGraph::IsImageTableFull() const
+{
+    // Freed slots are reused before the table grows
+    return this->ImageSlots.FreeSlots.empty() && (this->ImageSlots.NumSlots >= Shader::MAX_IMAGES);
+}
+
+FauxRender::SceneNode* SceneGraph::AddNode()
+{
+    auto& node = this->Nodes.emplace_back();
+    node.Index = static_cast<uint32_t>(this->Nodes.size() - 1);
+    return &node;
+}
+
+FauxRender::Material* SceneGraph::AddMaterial()
+{
+    uint32_t slot = this->MaterialSlots.Allocate();
+    if (slot < this->Materials.size())
+    {
+        this->Materials[slot] = FauxRender::Material{};
+    }
+    else
+    {
+        this->Materials.emplace_back();
+    }
+
+    auto& material = this->Materials[slot];
+    material.Index = slot;
+    return &material;
+}
+
+bool SceneGraph::AddImage(FauxRender::Image* pImage)
+{
+    assert((pImage != nullptr) && "pImage is NULL");
+
+    if (this->IsImageTableFull())
+    {
+        GREX_LOG_ERROR("image table is full, the shader image range holds " << Shader::MAX_IMAGES << " images");
+        return false;
+    }
+
+    uint32_t slot = this->ImageSlots.Allocate();
+    if (slot < this->Images.size())
+    {
+        this->Images[slot].reset(pImage);
+    }
+    else
+    {
+        this->Images.push_back(std::unique_ptr<FauxRender::Image>(pImage));
+    }
+    pImage->Index = slot;
+
+    return true;
+}
+
+void SceneGraph::RemoveMaterial(FauxRender::Material* pMaterial)
+{
+    uint32_t slot = this->GetMaterialIndex(pMaterial);
+    if (slot == UINT32_MAX)
+    {
+        return;
+    }
+
+    this->MaterialSlots.Free(slot);
+    this->Materials[slot] = FauxRender::Material{};
+}
+
+void SceneGraph::RemoveImage(FauxRender::Image* pImage)
+{
+    uint32_t slot = this->GetImageIndex(pImage);
+    if (slot == UINT32_MAX)
+    {
+        return;
+    }
+
+    this->ImageSlots.Free(slot);
+    this->Images[slot].reset();
+}
+
+void SceneGraph::UpdateMaterial(const FauxRender::Material* pMaterial)
+{
+    uint32_t slot = this->GetMaterialIndex(pMaterial);
+    if (slot == UINT32_MAX)
+    {
+        return;
+    }
+
+    this->MaterialSlots.MarkDirty(slot);
+}
+
+bool SceneGraph::UpdateMaterialBuffer()
+{
+    auto writeFn = [this](uint32_t slot, Shader::MaterialParams* pParams) {
+        *pParams = ToMaterialParams(&this->Materials[slot], this);
+    };
+
+    bool res = UploadSlotTable<Shader::MaterialParams>(this, &this->MaterialSlots, writeFn, &this->MaterialBuffers, &this->pMaterialBuffer);
+    if (!res)
+    {
+        assert(false && "failed to update material buffer");
+        return false;
+    }
+
+    this->NumMaterials = this->MaterialSlots.Count;
+
+    return true;
+}
+
+bool SceneGraph::UpdateInstanceBuffer(FauxRender::Scene* pScene)
+{
+    if (IsNull(pScene))
+    {
+        return false;
+    }
+
+    auto writeFn = [this, pScene](uint32_t slot, Shader::InstanceParams* pParams) {
+        auto pNode = pScene->GeometryNodes[slot];
+        *pParams   = ToInstanceParams(pNode, this);
+
+        // World bounds follow the instance transform. Skinning and morph
+        // targets move vertices outside the mesh's bind pose bounds, so
+        // deformable meshes stay unbounded and are never culled.
+        FauxRender::AABB worldBounds = {};
+        if (!IsNull(pNode->pMesh) && pNode->pMesh->DeformableBatches.empty())
+        {
+            worldBounds = pNode->pMesh->Bounds.Transform(pParams->ModelMatrix);
+        }
+        pScene->BVH.Update(slot, worldBounds);
+    };
+
+    bool res = UploadSlotTable<Shader::InstanceParams>(this, &pScene->InstanceSlots, writeFn, &pScene->InstanceBuffers, &pScene->pInstanceBuffer);
+    if (!res)
+    {
+        assert(false && "failed to update instance buffer");
+        return false;
+    }
+
+    pScene->NumInstances = pScene->InstanceSlots.Count;
+
+    return true;
+}
+
+void SceneGraph::ReleaseRetiredBuffers()
+{
+    // Retired buffers aren't in Buffers anymore, the backend destroys them
+    // like temporary buffers
+    for (auto& retiredBuffer : this->RetiredBuffers)
+    {
+        FauxRender::Buffer* pBuffer = retiredBuffer.release();
+        this->DestroyTemporaryBuffer(&pBuffer);
+    }
+    this->RetiredBuffers.clear();
+}
+
+bool SceneGraph::CreateSampler(
+    FauxRender::FilterMode         minFilter,
+    FauxRender::FilterMode         magFilter,
+    FauxRender::FilterMode         mipFilter,
+    FauxRender::TextureAddressMode addressU,
+    FauxRender::TextureAddressMode addressV,
+    FauxRender::TextureAddressMode addressW,
+    FauxRender::Sampler**          ppSampler)
+{
+    if (IsNull(ppSampler))
+    {
+        return false;
+    }
+
+    if (this->Samplers.size() >= Shader::MAX_SAMPLERS)
+    {
+        GREX_LOG_ERROR("sampler table is full, the shader sampler range holds " << Shader::MAX_SAMPLERS << " samplers");
+        return false;
+    }
+
+    auto object = std::make_unique<FauxRender::Sampler>();
+    if (!object)
+    {
+        return false;
+    }
+
+    object->MinFilter = minFilter;
+    object->MagFilter = magFilter;
+    object->MipFilter = mipFilter;
+    object->AddressU  = addressU;
+    object->AddressV  = addressV;
+    object->AddressW  = addressW;
+    object->Index     = CountU32(this->Samplers);
+
+    *ppSampler = object.get();
+
+    this->Samplers.push_back(std::move(object));
+
+    return true;
+}
+
+// =============================================================================
+// Draw lists
+// =============================================================================
+bool BuildDrawList(const FauxRender::SceneGraph* pGraph, const FauxRender::Scene* pScene, FauxRender::DrawList* pDrawList)
+{
+    if (IsNull(pGraph) || IsNull(pScene) || IsNull(pDrawList))
+    {
+        return false;
+    }
+
+    pDrawList->Draws.clear();
+    pDrawList->InstanceIndices.clear();
+    pDrawList->IndirectArgs.clear();
+    pDrawList->NumNodeDraws = 0;
+
+    //
+    // Group geometry nodes by mesh and draw buffer, groups keep the order
+    // they're first seen in. Nodes with a deformed buffer end up in a
+    // group of their own.
+    //
+    using GroupKey = std::pair<const FauxRender::Mesh*, FauxRender::Buffer*>;
+
+    std::map<GroupKey, uint32_t>       groupMap;
+    std::vector<GroupKey>              groupKeys;
+    std::vector<std::vector<uint32_t>> groupInstances;
+    for (size_t nodeIdx = 0; nodeIdx < pScene->GeometryNodes.size(); ++nodeIdx)
+    {
+        auto pNode = pScene->GeometryNodes[nodeIdx];
+        if (IsNull(pNode) || IsNull(pNode->pMesh))
+        {
+            continue;
+        }
+        const GroupKey key = {pNode->pMesh, pNode->GetDrawBuffer()};
+
+        auto it = groupMap.find(key);
+        if (it == groupMap.end())
+        {
+            it = groupMap.insert({key, CountU32(groupKeys)}).first;
+            groupKeys.push_back(key);
+            groupInstances.push_back({});
+        }
+
+        groupInstances[(*it).second].push_back(static_cast<uint32_t>(nodeIdx));
+    }
+
+    // Each group gets one instance range, shared by all of its mesh's batches
+    for (size_t groupIdx = 0; groupIdx < groupKeys.size(); ++groupIdx)
+    {
+        auto        pMesh         = groupKeys[groupIdx].first;
+        auto        pBuffer       = groupKeys[groupIdx].second;
+        const auto& instances     = groupInstances[groupIdx];
+        uint32_t    firstInstance = CountU32(pDrawList->InstanceIndices);
+
+        pDrawList->InstanceIndices.insert(pDrawList->InstanceIndices.end(), instances.begin(), instances.end());
+
+        for (size_t batchIdx = 0; batchIdx < pMesh->DrawBatches.size(); ++batchIdx)
+        {
+            const auto& batch = pMesh->DrawBatches[batchIdx];
+
+            // Backends skip batches without a material, so do the same here
+            if (IsNull(batch.pMaterial))
+            {
+                continue;
+            }
+
+            FauxRender::InstancedDraw draw = {};
+            draw.pMesh                     = pMesh;
+            draw.pBuffer                   = pBuffer;
+            draw.BatchIndex                = static_cast<uint32_t>(batchIdx);
+            draw.MaterialIndex             = pGraph->GetMaterialIndex(batch.pMaterial);
+            draw.VertexLayout              = batch.GetVertexLayout();
+            draw.FirstInstance             = firstInstance;
+            draw.InstanceCount             = CountU32(instances);
+
+            pDrawList->Draws.push_back(draw);
+            pDrawList->NumNodeDraws += draw.InstanceCount;
+        }
+    }
+
+    // Sort by state: vertex layout first, then material
+    std::stable_sort(
+        pDrawList->Draws.begin(),
+        pDrawList->Draws.end(),
+        [](const FauxRender::InstancedDraw& a, const FauxRender::InstancedDraw& b) -> bool {
+            if (a.VertexLayout != b.VertexLayout)
+            {
+                return a.VertexLayout < b.VertexLayout;
+            }
+            return a.MaterialIndex < b.MaterialIndex;
+        });
+
+    // Indirect arguments
+    for (size_t drawIdx = 0; drawIdx < pDrawList->Draws.size(); ++drawIdx)
+    {
+        const auto& draw  = pDrawList->Draws[drawIdx];
+        const auto& batch = draw.pMesh->DrawBatches[draw.BatchIndex];
+
+        FauxRender::Shader::DrawIndexedIndirectArgs args = {};
+        args.IndexCount                                  = batch.IndexBufferView.Count;
+        args.InstanceCount                               = draw.InstanceCount;
+        args.FirstIndex                                  = 0;
+        args.BaseVertex                                  = 0;
+        args.FirstInstance                               = 0;
+
+        pDrawList->IndirectArgs.push_back(args);
+    }
+
+    return true;
+}
+
+// =============================================================================
+// Culling
+// =============================================================================
+void ExtractFrustumPlanes(const glm::mat4& viewProjectionMatrix, FauxRender::FrustumPlanes* pPlanes)
+{
+    assert((pPlanes != nullptr) && "pPlanes is NULL");
+
+    const mat4& m = viewProjectionMatrix;
+
+    vec4 row0 = vec4(m[0][0], m[1][0], m[2][0], m[3][0]);
+    vec4 row1 = vec4(m[0][1], m[1][1], m[2][1], m[3][1]);
+    vec4 row2 = vec4(m[0][2], m[1][2], m[2][2], m[3][2]);
+    vec4 row3 = vec4(m[0][3], m[1][3], m[2][3], m[3][3]);
+
+    // Left, right, bottom, top, near, far. The near plane assumes a -1..1
+    // clip space depth, which is conservative for 0..1 projections.
+    //
+    vec4 planes[6] = {
+        row3 + row0,
+        row3 - row0,
+        row3 + row1,
+        row3 - row1,
+        row3 + row2,
+        row3 - row2,
+    };
+
+    for (uint32_t i = 0; i < 8; ++i)
+    {
+        // Padding planes never reject
+        vec4 plane = vec4(0, 0, 0, 1);
+        if (i < 6)
+        {
+            plane = planes[i] / glm::length(vec3(planes[i]));
+        }
+
+        pPlanes->Nx[i] = plane.x;
+        pPlanes->Ny[i] = plane.y;
+        pPlanes->Nz[i] = plane.z;
+        pPlanes->D[i]  = plane.w;
+    }
+}
+
+FauxRender::FrustumTest TestFrustum(const FauxRender::FrustumPlanes& planes, const FauxRender::AABB& bounds)
+{
+    const vec3 center = bounds.Center();
+    const vec3 extent = bounds.Extent();
+
+    // For each plane: the box is outside if dist + radius < 0, and it
+    // straddles the plane if dist - radius < 0.
+    //
+#if defined(FAUX_RENDER_SSE2)
+    const __m128 cx       = _mm_set1_ps(center.x);
+    const __m128 cy       = _mm_set1_ps(center.y);
+    const __m128 cz       = _mm_set1_ps(center.z);
+    const __m128 ex       = _mm_set1_ps(extent.x);
+    const __m128 ey       = _mm_set1_ps(extent.y);
+    const __m128 ez       = _mm_set1_ps(extent.z);
+    const __m128 signMask = _mm_set1_ps(-0.0f);
+    const __m128 zero     = _mm_setzero_ps();
+
+    int outsideMask   = 0;
+    int intersectMask = 0;
+    for (uint32_t i = 0; i < 8; i += 4)
+    {
+        __m128 nx = _mm_load_ps(&planes.Nx[i]);
+        __m128 ny = _mm_load_ps(&planes.Ny[i]);
+        __m128 nz = _mm_load_ps(&planes.Nz[i]);
+        __m128 d  = _mm_load_ps(&planes.D[i]);
+
+        __m128 dist = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, cx), _mm_mul_ps(ny, cy)), _mm_add_ps(_mm_mul_ps(nz, cz), d));
+
+        __m128 radius = _mm_add_ps(
+            _mm_add_ps(_mm_mul_ps(_mm_andnot_ps(signMask, nx), ex), _mm_mul_ps(_mm_andnot_ps(signMask, ny), ey)),
+            _mm_mul_ps(_mm_andnot_ps(signMask, nz), ez));
+
+        outsideMask |= _mm_movemask_ps(_mm_cmplt_ps(_mm_add_ps(dist, radius), zero));
+        intersectMask |= _mm_movemask_ps(_mm_cmplt_ps(_mm_sub_ps(dist, radius), zero));
+    }
+#else
+    int outsideMask   = 0;
+    int intersectMask = 0;
+    for (uint32_t i = 0; i < 8; ++i)
+    {
+        float dist   = planes.Nx[i] * center.x + planes.Ny[i] * center.y + planes.Nz[i] * center.z + planes.D[i];
+        float radius = fabs(planes.Nx[i]) * extent.x + fabs(planes.Ny[i]) * extent.y + fabs(planes.Nz[i]) * extent.z;
+
+        outsideMask |= ((dist + radius) < 0) ? 1 : 0;
+        intersectMask |= ((dist - radius) < 0) ? 1 : 0;
+    }
+#endif
+
+    if (outsideMask != 0)
+    {
+        return FRUSTUM_TEST_OUTSIDE;
+    }
+    return (intersectMask != 0) ? FRUSTUM_TEST_INTERSECT : FRUSTUM_TEST_INSIDE;
+}
+
+bool CullScene(const FauxRender::Scene* pScene, const glm::mat4& viewProjectionMatrix, FauxRender::VisibleList* pVisibleList)
+{
+    if (IsNull(pScene) || IsNull(pVisibleList))
+    {
+        return false;
+    }
+
+    auto startTime = std::chrono::high_resolution_clock::now();
+
+    pVisibleList->InstanceIndices.clear();
+    pVisibleList->Stats = {};
+
+    FauxRender::FrustumPlanes planes = {};
+    ExtractFrustumPlanes(viewProjectionMatrix, &planes);
+
+    const auto& bvh = pScene->BVH;
+
+    // Instances without bounds are always drawn
+    for (auto instanceIndex : bvh.UnboundedInstances)
+    {
+        pVisibleList->InstanceIndices.push_back(instanceIndex);
+    }
+
+    struct StackEntry
+    {
+        uint32_t NodeIndex;
+        bool     Inside; // Ancestor is fully inside the frustum
+    };
+
+    std::vector<StackEntry> stack;
+    stack.reserve(64);
+    if (bvh.Root != UINT32_MAX)
+    {
+        stack.push_back({bvh.Root, false});
+    }
+
+    while (!stack.empty())
+    {
+        StackEntry entry = stack.back();
+        stack.pop_back();
+
+        const auto& node = bvh.Nodes[entry.NodeIndex];
+
+        bool inside = entry.Inside;
+        if (!inside)
+        {
+            FrustumTest result = TestFrustum(planes, node.Bounds);
+            ++pVisibleList->Stats.NumNodesTested;
+
+            if (result == FRUSTUM_TEST_OUTSIDE)
+            {
+                continue;
+            }
+            inside = (result == FRUSTUM_TEST_INSIDE);
+        }
+
+        if (node.IsLeaf())
+        {
+            pVisibleList->InstanceIndices.push_back(node.InstanceIndex);
+        }
+        else
+        {
+            stack.push_back({node.Right, inside});
+            stack.push_back({node.Left, inside});
+        }
+    }
+
+    auto endTime = std::chrono::high_resolution_clock::now();
+
+    pVisibleList->Stats.NumVisible   = CountU32(pVisibleList->InstanceIndices);
+    pVisibleList->Stats.NumCulled    = pScene->InstanceSlots.Count - pVisibleList->Stats.NumVisible;
+    pVisibleList->Stats.Microseconds = std::chrono::duration<float, std::micro>(endTime - startTime).count();
+
+    return true;
+}
+
+// =============================================================================
+// Texture streaming
+// =============================================================================
+static bool IsBlockCompressed(GREXFormat format)
+{
+    // clang-format off
+    switch (format) {
+        default: return false;
+        case GREX_FORMAT_BC1_RGB     : return true;
+        case GREX_FORMAT_BC3_RGBA    : return true;
+        case GREX_FORMAT_BC4_R       : return true;
+        case GREX_FORMAT_BC5_RG      : return true;
+        case GREX_FORMAT_BC6H_SFLOAT : return true;
+        case GREX_FORMAT_BC6H_UFLOAT : return true;
+        case GREX_FORMAT_BC7_RGBA    : return true;
+    }
+    // clang-format on
+}
+
+static bool UsesImage(const FauxRender::Material& material, const FauxRender::Image* pImage)
+{
+    const FauxRender::Texture* textures[] = {
+        material.pBaseColorTexture,
+        material.pMetallicRoughnessTexture,
+        material.pNormalTexture,
+        material.pOcclusionTexture,
+        material.pEmissiveTexture,
+    };
+
+    for (auto pTexture : textures)
+    {
+        if (!IsNull(pTexture) && (pTexture->pImage == pImage))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool MakeStreamingImageSource(const BitmapRGBA8u& bitmap, FauxRender::StreamingImageSource* pSource)
+{
+    if (bitmap.Empty() || IsNull(pSource))
+    {
+        return false;
+    }
+
+    MipmapRGBA8u mipmap(bitmap, BITMAP_SAMPLE_MODE_WRAP, BITMAP_SAMPLE_MODE_WRAP, BITMAP_FILTER_MODE_LINEAR);
+
+    *pSource        = {};
+    pSource->Width  = bitmap.GetWidth();
+    pSource->Height = bitmap.GetHeight();
+    pSource->Format = GREX_FORMAT_R8G8B8A8_UNORM;
+
+    // The mipmap's levels share the base level's row stride, store them
+    // tightly packed instead
+    for (uint32_t level = 0; level < mipmap.GetNumLevels(); ++level)
+    {
+        const BitmapRGBA8u& mip = mipmap.GetMip(level);
+
+        MipOffset mipOffset = {};
+        mipOffset.Offset    = static_cast<uint32_t>(pSource->Data.size());
+        mipOffset.RowStride = mip.GetWidth() * mip.GetPixelStride();
+        pSource->MipOffsets.push_back(mipOffset);
+
+        pSource->Data.resize(pSource->Data.size() + mipOffset.RowStride * mip.GetHeight());
+        for (uint32_t y = 0; y < mip.GetHeight(); ++y)
+        {
+            memcpy(pSource->Data.data() + mipOffset.Offset + y * mipOffset.RowStride, mip.GetPixels(0, y), mipOffset.RowStride);
+        }
+    }
+
+    return true;
+}
+
+bool GetStreamingView(const FauxRender::Scene* pScene, float viewportHeight, FauxRender::StreamingView* pView)
+{
+    if (IsNull(pScene) || IsNull(pScene->pActiveCamera) || IsNull(pView))
+    {
+        return false;
+    }
+
+    // Same camera setup as SceneGraph::InitializeResources()
+    auto pCameraNode = pScene->pActiveCamera;
+
+    vec3 eyePosition   = pCameraNode->Translate;
+    vec3 lookDirection = glm::toMat4(pCameraNode->Rotation) * vec4(0, 0, -1, 0);
+    vec3 center        = eyePosition + lookDirection;
+
+    mat4 viewMat = glm::lookAt(eyePosition, center, vec3(0, 1, 0));
+    mat4 projMat = glm::perspective(pCameraNode->Camera.FovY, pCameraNode->Camera.AspectRatio, pCameraNode->Camera.NearClip, pCameraNode->Camera.FarClip);
+
+    pView->EyePosition          = eyePosition;
+    pView->ViewProjectionMatrix = projMat * viewMat;
+    pView->FovY                 = pCameraNode->Camera.FovY;
+    pView->ViewportHeight       = viewportHeight;
+
+    return true;
+}
+
+bool TextureStreamer::AddImage(FauxRender::SceneGraph* pGraph, FauxRender::StreamingImageSource&& source, FauxRender::Image** ppImage)
+{
+    if (IsNull(pGraph) || IsNull(ppImage))
+    {
+        return false;
+    }
+
+    const uint32_t numLevels = CountU32(source.MipOffsets);
+    if ((numLevels == 0) || source.Data.empty())
+    {
+        assert(false && "streaming image source has no levels");
+        return false;
+    }
+
+    Entry entry  = {};
+    entry.Source = std::move(source);
+
+    // Level sizes from the offsets so that any padding between levels moves
+    // with them. Levels can be stored in any order.
+    entry.LevelSizes.resize(numLevels);
+    for (uint32_t level = 0; level < numLevels; ++level)
+    {
+        const size_t offset = entry.Source.MipOffsets[level].Offset;
+
+        size_t end = entry.Source.Data.size();
+        for (const auto& mipOffset : entry.Source.MipOffsets)
+        {
+            if (mipOffset.Offset > offset)
+            {
+                end = std::min<size_t>(end, mipOffset.Offset);
+            }
+        }
+        entry.LevelSizes[level] = static_cast<uint32_t>(end - offset);
+    }
+
+    // The tail is the finest level that's no larger than MinTailSize. Block
+    // compressed images can only start on a level that's a multiple of
+    // the block size.
+    const bool blockCompressed = IsBlockCompressed(entry.Source.Format);
+    while ((entry.TailLevel + 1) < numLevels)
+    {
+        const uint32_t nextWidth  = std::max<uint32_t>(entry.Source.Width >> (entry.TailLevel + 1), 1);
+        const uint32_t nextHeight = std::max<uint32_t>(entry.Source.Height >> (entry.TailLevel + 1), 1);
+        if (blockCompressed && (((nextWidth % 4) != 0) || ((nextHeight % 4) != 0)))
+        {
+            break;
+        }
+        if (std::max(entry.Source.Width >> entry.TailLevel, entry.Source.Height >> entry.TailLevel) <= this->MinTailSize)
+        {
+            break;
+        }
+        ++entry.TailLevel;
+    }
+    entry.ResidentLevel = UINT32_MAX;
+    entry.RequiredLevel = entry.TailLevel;
+    entry.TargetLevel   = entry.TailLevel;
+
+    const uint32_t entryIndex = CountU32(this->Entries);
+    this->Entries.push_back(std::move(entry));
+
+    if (!this->SetResidentLevel(pGraph, entryIndex, this->Entries[entryIndex].TailLevel))
+    {
+        this->Entries.pop_back();
+        return false;
+    }
+
+    this->UpdateStats();
+
+    *ppImage = this->Entries[entryIndex].pImage;
+
+    return true;
+}
+
+void TextureStreamer::ComputeRequiredLevels(const FauxRender::SceneGraph* pGraph, const FauxRender::Scene* pScene, const FauxRender::StreamingView& view)
+{
+    // Images that aren't used by a visible node only need their tail
+    for (auto& entry : this->Entries)
+    {
+        entry.RequiredLevel = entry.TailLevel;
+    }
+
+    if (IsNull(pGraph) || IsNull(pScene))
+    {
+        return;
+    }
+
+    FauxRender::FrustumPlanes planes = {};
+    ExtractFrustumPlanes(view.ViewProjectionMatrix, &planes);
+
+    // Screen pixels per world unit at a distance of 1
+    const float pixelsPerUnit = view.ViewportHeight / (2.0f * tan(0.5f * view.FovY));
+
+    const auto& bvh = pScene->BVH;
+
+    for (uint32_t instanceIndex = 0; instanceIndex < CountU32(pScene->GeometryNodes); ++instanceIndex)
+    {
+        const FauxRender::SceneNode* pNode = pScene->GeometryNodes[instanceIndex];
+        if (IsNull(pNode) || IsNull(pNode->pMesh))
+        {
+            continue;
+        }
+
+        // Nodes without bounds, and nodes the eye is inside of, get the
+        // finest level. The leaf bounds are fattened, which errs on the
+        // side of keeping images resident.
+        //
+        float    distance   = 0;
+        float    objectSize = 0;
+        uint32_t leaf       = (instanceIndex < bvh.InstanceLeaves.size()) ? bvh.InstanceLeaves[instanceIndex] : UINT32_MAX;
+        if (leaf != UINT32_MAX)
+        {
+            const FauxRender::AABB& bounds = bvh.Nodes[leaf].Bounds;
+            if (TestFrustum(planes, bounds) == FRUSTUM_TEST_OUTSIDE)
+            {
+                continue;
+            }
+
+            const vec3 nearest = glm::clamp(view.EyePosition, bounds.Min, bounds.Max);
+            const vec3 size    = bounds.Max - bounds.Min;
+
+            distance   = glm::length(nearest - view.EyePosition);
+            objectSize = std::max(size.x, std::max(size.y, size.z));
+        }
+        const bool finest = (distance <= 0) || (objectSize <= 0);
+
+        for (const auto& batch : pNode->pMesh->DrawBatches)
+        {
+            const FauxRender::Material* pMaterial = batch.pMaterial;
+            if (IsNull(pMaterial))
+            {
+                continue;
+            }
+
+            const float uvScale = std::max(fabs(pMaterial->TexCoordScale.x), fabs(pMaterial->TexCoordScale.y));
+
+            const FauxRender::Texture* textures[] = {
+                pMaterial->pBaseColorTexture,
+                pMaterial->pMetallicRoughnessTexture,
+                pMaterial->pNormalTexture,
+                pMaterial->pOcclusionTexture,
+                pMaterial->pEmissiveTexture,
+            };
+
+            for (auto pTexture : textures)
+            {
+                if (IsNull(pTexture) || IsNull(pTexture->pImage))
+                {
+                    continue;
+                }
+
+                auto it = this->ImageEntries.find(pTexture->pImage);
+                if (it == this->ImageEntries.end())
+                {
+                    continue;
+                }
+
+                Entry& entry = this->Entries[it->second];
+
+                // Texels per screen pixel at the nearest point of the bounds
+                float lod = 0;
+                if (!finest)
+                {
+                    const float texelsPerUnit  = static_cast<float>(std::max(entry.Source.Width, entry.Source.Height)) * uvScale / objectSize;
+                    const float texelsPerPixel = texelsPerUnit * distance / pixelsPerUnit;
+
+                    lod = log2(std::max(texelsPerPixel, FLT_MIN));
+                }
+                lod += this->LodBias;
+
+                const float    maxLevel = static_cast<float>(entry.TailLevel);
+                const uint32_t level    = static_cast<uint32_t>(std::clamp(std::floor(lod), 0.0f, maxLevel));
+
+                entry.RequiredLevel = std::min(entry.RequiredLevel, level);
+            }
+        }
+    }
+}
+
+void TextureStreamer::ComputeTargetLevels()
+{
+    uint64_t totalSize = 0;
+    for (auto& entry : this->Entries)
+    {
+        entry.TargetLevel = entry.RequiredLevel;
+        totalSize += this->GetResidentSize(entry, entry.TargetLevel);
+    }
+
+    // Drop the largest finest level first. Each level is about a quarter
+    // of the one above it, so this coarsens big images before it takes
+    // more than a level off small ones.
+    //
+    auto compare = [this](uint32_t a, uint32_t b) {
+        const Entry& entryA = this->Entries[a];
+        const Entry& entryB = this->Entries[b];
+        return entryA.LevelSizes[entryA.TargetLevel] < entryB.LevelSizes[entryB.TargetLevel];
+    };
+
+    std::priority_queue<uint32_t, std::vector<uint32_t>, decltype(compare)> candidates(compare);
+    for (uint32_t entryIndex = 0; entryIndex < CountU32(this->Entries); ++entryIndex)
+    {
+        if (this->Entries[entryIndex].TargetLevel < this->Entries[entryIndex].TailLevel)
+        {
+            candidates.push(entryIndex);
+        }
+    }
+
+    while ((totalSize > this->BudgetBytes) && !candidates.empty())
+    {
+        const uint32_t entryIndex = candidates.top();
+        candidates.pop();
+
+        Entry& entry = this->Entries[entryIndex];
+        totalSize -= entry.LevelSizes[entry.TargetLevel];
+        ++entry.TargetLevel;
+
+        if (entry.TargetLevel < entry.TailLevel)
+        {
+            candidates.push(entryIndex);
+        }
+    }
+
+    if (totalSize > this->BudgetBytes)
+    {
+        GREX_LOG_WARN("texture streaming budget of " << this->BudgetBytes << " bytes is smaller than the mip tails (" << totalSize << " bytes)");
+    }
+
+    this->UpdateStats();
+}
+
+bool TextureStreamer::ApplyTargetLevels(FauxRender::SceneGraph* pGraph)
+{
+    if (IsNull(pGraph))
+    {
+        return false;
+    }
+
+    ++this->UpdateIndex;
+
+    // Remove replaced images once frames in flight are done with them
+    auto itRetired = std::remove_if(
+        this->RetiredImages.begin(),
+        this->RetiredImages.end(),
+        [this, pGraph](const RetiredImage& retired) {
+            if ((this->UpdateIndex - retired.UpdateIndex) < this->RetireLatency)
+            {
+                return false;
+            }
+            pGraph->RemoveImage(retired.pImage);
+            this->ImagesChanged = true;
+            return true;
+        });
+    this->RetiredImages.erase(itRetired, this->RetiredImages.end());
+
+    // Evictions first, they make room for the loads
+    std::vector<uint32_t> loads;
+    for (uint32_t entryIndex = 0; entryIndex < CountU32(this->Entries); ++entryIndex)
+    {
+        const Entry& entry = this->Entries[entryIndex];
+        if (entry.TargetLevel < entry.ResidentLevel)
+        {
+            loads.push_back(entryIndex);
+            continue;
+        }
+        if (entry.TargetLevel == entry.ResidentLevel)
+        {
+            continue;
+        }
+
+        const uint64_t evictedSize = this->GetResidentSize(entry, entry.ResidentLevel) - this->GetResidentSize(entry, entry.TargetLevel);
+        if (!this->SetResidentLevel(pGraph, entryIndex, entry.TargetLevel))
+        {
+            return false;
+        }
+
+        ++this->Stats.NumEvictions;
+        this->Stats.BytesEvicted += evictedSize;
+    }
+
+    // Images that are the most levels short of their target go first
+    std::stable_sort(
+        loads.begin(),
+        loads.end(),
+        [this](uint32_t a, uint32_t b) {
+            const Entry& entryA = this->Entries[a];
+            const Entry& entryB = this->Entries[b];
+            return (entryA.ResidentLevel - entryA.TargetLevel) > (entryB.ResidentLevel - entryB.TargetLevel);
+        });
+
+    if (loads.size() > this->MaxLoadsPerUpdate)
+    {
+        loads.resize(this->MaxLoadsPerUpdate);
+    }
+
+    for (auto entryIndex : loads)
+    {
+        const Entry&   entry      = this->Entries[entryIndex];
+        const uint64_t loadedSize = this->GetResidentSize(entry, entry.TargetLevel) - this->GetResidentSize(entry, entry.ResidentLevel);
+        if (!this->SetResidentLevel(pGraph, entryIndex, entry.TargetLevel))
+        {
+            return false;
+        }
+
+        ++this->Stats.NumLoads;
+        this->Stats.BytesLoaded += loadedSize;
+    }
+
+    this->UpdateStats();
+
+    return true;
+}
+
+bool TextureStreamer::Update(FauxRender::SceneGraph* pGraph, const FauxRender::Scene* pScene, const FauxRender::StreamingView& view)
+{
+    this->ComputeRequiredLevels(pGraph, pScene, view);
+    this->ComputeTargetLevels();
+    return this->ApplyTargetLevels(pGraph);
+}
+
+void TextureStreamer::ReleaseRetiredImages(FauxRender::SceneGraph* pGraph)
+{
+    if (IsNull(pGraph))
+    {
+        return;
+    }
+
+    for (auto& retired : this->RetiredImages)
+    {
+        pGraph->RemoveImage(retired.pImage);
+        this->ImagesChanged = true;
+    }
+    this->RetiredImages.clear();
+}
+
+bool TextureStreamer::SetResidentLevel(FauxRender::SceneGraph* pGraph, uint32_t entryIndex, uint32_t level)
+{
+    Entry&      entry     = this->Entries[entryIndex];
+    const auto& source    = entry.Source;
+    uint32_t    numLevels = CountU32(source.MipOffsets);
+
+    // Pack the resident levels so the new base level is at offset 0
+    std::vector<MipOffset> mipOffsets;
+    std::vector<char>      data;
+    for (uint32_t srcLevel = level; srcLevel < numLevels; ++srcLevel)
+    {
+        const MipOffset& srcMipOffset = source.MipOffsets[srcLevel];
+
+        MipOffset mipOffset = {};
+        mipOffset.Offset    = static_cast<uint32_t>(data.size());
+        mipOffset.RowStride = srcMipOffset.RowStride;
+        mipOffsets.push_back(mipOffset);
+
+        const char* pSrcData = source.Data.data() + srcMipOffset.Offset;
+        data.insert(data.end(), pSrcData, pSrcData + entry.LevelSizes[srcLevel]);
+    }
+
+    FauxRender::Image* pImage = nullptr;
+    //
+    bool res = pGraph->CreateImage(
+        std::max<uint32_t>(source.Width >> level, 1),
+        std::max<uint32_t>(source.Height >> level, 1),
+        source.Format,
+        mipOffsets,
+        data.size(),
+        DataPtr(data),
+        &pImage);
+    if (!res)
+    {
+        assert(false && "create streamed image failed");
+        return false;
+    }
+
+    FauxRender::Image* pPrevImage = entry.pImage;
+    if (!IsNull(pPrevImage))
+    {
+        pImage->Name = pPrevImage->Name;
+
+        for (auto& texture : pGraph->Textures)
+        {
+            if (texture->pImage == pPrevImage)
+            {
+                texture->pImage = pImage;
+            }
+        }
+
+        // Materials store image indices, so the ones using the image have to
+        // be uploaded again
+        for (auto& material : pGraph->Materials)
+        {
+            if ((material.Index != UINT32_MAX) && UsesImage(material, pImage))
+            {
+                pGraph->UpdateMaterial(&material);
+            }
+        }
+
+        this->ImageEntries.erase(pPrevImage);
+        this->RetiredImages.push_back({pPrevImage, this->UpdateIndex});
+    }
+
+    entry.pImage        = pImage;
+    entry.ResidentLevel = level;
+
+    this->ImageEntries[pImage] = entryIndex;
+    this->ImagesChanged        = true;
+
+    return true;
+}
+
+uint64_t TextureStreamer::GetResidentSize(const Entry& entry, uint32_t level) const
+{
+    uint64_t size = 0;
+    for (uint32_t i = level; i < CountU32(entry.LevelSizes); ++i)
+    {
+        size += entry.LevelSizes[i];
+    }
+    return size;
+}
+
+void TextureStreamer::UpdateStats()
+{
+    this->Stats.NumImages              = CountU32(this->Entries);
+    this->Stats.NumImagesBelowRequired = 0;
+    this->Stats.ResidentBytes          = 0;
+    this->Stats.RequiredBytes          = 0;
+    this->Stats.TargetBytes            = 0;
+    this->Stats.BudgetBytes            = this->BudgetBytes;
+
+    for (const auto& entry : this->Entries)
+    {
+        if (entry.ResidentLevel > entry.RequiredLevel)
+        {
+            ++this->Stats.NumImagesBelowRequired;
+        }
+
+        this->Stats.ResidentBytes += this->GetResidentSize(entry, entry.ResidentLevel);
+        this->Stats.RequiredBytes += this->GetResidentSize(entry, entry.RequiredLevel);
+        this->Stats.TargetBytes += this->GetResidentSize(entry, entry.TargetLevel);
+    }
+}
+
+// =============================================================================
+// Animation and skinning
+// =============================================================================
+static void SampleAnimationSampler(const FauxRender::AnimationSampler& sampler, FauxRender::AnimationPath path, float time, float* pValue)
+{
+    const uint32_t numComponents = sampler.NumComponents;
+    const uint32_t numKeys       = CountU32(sampler.Times);
+    const bool     cubic         = (sampler.Interpolation == ANIMATION_INTERPOLATION_CUBIC_SPLINE);
+    const uint32_t keyStride     = cubic ? 3 * numComponents : numComponents;
+    const uint32_t valueOffset   = cubic ? numComponents : 0; // Skips the in-tangent
+    if ((numKeys == 0) || (sampler.Values.size() < static_cast<size_t>(numKeys) * keyStride))
+    {
+        return;
+    }
+
+    // Clamp to the key range
+    if ((numKeys == 1) || (time <= sampler.Times.front()))
+    {
+        const float* pKey = &sampler.Values[valueOffset];
+        std::copy(pKey, pKey + numComponents, pValue);
+        return;
+    }
+    if (time >= sampler.Times.back())
+    {
+        const float* pKey = &sampler.Values[(numKeys - 1) * keyStride + valueOffset];
+        std::copy(pKey, pKey + numComponents, pValue);
+        return;
+    }
+
+    // Key before time
+    const uint32_t k  = static_cast<uint32_t>(std::upper_bound(sampler.Times.begin(), sampler.Times.end(), time) - sampler.Times.begin()) - 1;
+    const float    dt = sampler.Times[k + 1] - sampler.Times[k];
+    const float    u  = (dt > 0) ? (time - sampler.Times[k]) / dt : 0.0f;
+
+    const float* pValue0 = &sampler.Values[k * keyStride + valueOffset];
+    const float* pValue1 = &sampler.Values[(k + 1) * keyStride + valueOffset];
+
+    switch (sampler.Interpolation)
+    {
+        case ANIMATION_INTERPOLATION_STEP: {
+            std::copy(pValue0, pValue0 + numComponents, pValue);
+        }
+        break;
+
+        case ANIMATION_INTERPOLATION_LINEAR: {
+            if (path == ANIMATION_PATH_ROTATION)
+            {
+                quat q0 = quat(pValue0[0], pValue0[1], pValue0[2], pValue0[3]);
+                quat q1 = quat(pValue1[0], pValue1[1], pValue1[2], pValue1[3]);
+                quat q  = glm::slerp(q0, q1, u);
+                for (uint32_t i = 0; i < 4; ++i)
+                {
+                    pValue[i] = q[i];
+                }
+            }
+            else
+            {
+                for (uint32_t i = 0; i < numComponents; ++i)
+                {
+                    pValue[i] = pValue0[i] + u * (pValue1[i] - pValue0[i]);
+                }
+            }
+        }
+        break;
+
+        // Hermite spline, from the glTF spec's appendix C
+        case ANIMATION_INTERPOLATION_CUBIC_SPLINE: {
+            const float* pOutTangent0 = &sampler.Values[k * keyStride + 2 * numComponents];
+            const float* pInTangent1  = &sampler.Values[(k + 1) * keyStride];
+
+            const float u2  = u * u;
+            const float u3  = u2 * u;
+            const float h00 = 2 * u3 - 3 * u2 + 1;
+            const float h10 = u3 - 2 * u2 + u;
+            const float h01 = -2 * u3 + 3 * u2;
+            const float h11 = u3 - u2;
+            for (uint32_t i = 0; i < numComponents; ++i)
+            {
+                pValue[i] = h00 * pValue0[i] + h10 * dt * pOutTangent0[i] + h01 * pValue1[i] + h11 * dt * pInTangent1[i];
+            }
+
+            if (path == ANIMATION_PATH_ROTATION)
+            {
+                quat q = glm::normalize(quat(pValue[0], pValue[1], pValue[2], pValue[3]));
+                for (uint32_t i = 0; i < 4; ++i)
+                {
+                    pValue[i] = q[i];
+                }
+            }
+        }
+        break;
+    }
+}
+
+void ApplyAnimation(const FauxRender::Animation& animation, float time, FauxRender::SceneGraph* pGraph, FauxRender::Scene* pScene)
+{
+    if (IsNull(pGraph))
+    {
+        return;
+    }
+
+    const uint32_t numNodes = static_cast<uint32_t>(pGraph->Nodes.size());
+
+    std::vector<float> value;
+    std::vector<bool>  animated(numNodes, false);
+    for (const auto& channel : animation.Channels)
+    {
+        if ((channel.Node >= numNodes) || (channel.Sampler >= CountU32(animation.Samplers)))
+        {
+            continue;
+        }
+
+        const auto& sampler = animation.Samplers[channel.Sampler];
+        value.assign(std::max(sampler.NumComponents, 4u), 0.0f);
+        SampleAnimationSampler(sampler, channel.Path, time, value.data());
+
+        auto& node = pGraph->Nodes[channel.Node];
+        switch (channel.Path)
+        {
+            case ANIMATION_PATH_TRANSLATION: node.Translate = vec3(value[0], value[1], value[2]); break;
+            case ANIMATION_PATH_ROTATION: node.Rotation = quat(value[0], value[1], value[2], value[3]); break;
+            case ANIMATION_PATH_SCALE: node.Scale = vec3(value[0], value[1], value[2]); break;
+            case ANIMATION_PATH_WEIGHTS: node.MorphWeights.assign(value.begin(), value.begin() + sampler.NumComponents); break;
+        }
+
+        animated[channel.Node] = true;
+    }
+
+    if (IsNull(pScene))
+    {
+        return;
+    }
+
+    // Instances move with any of their ancestors
+    for (auto pGeometryNode : pScene->GeometryNodes)
+    {
+        if (IsNull(pGeometryNode))
+        {
+            continue;
+        }
+
+        for (uint32_t nodeIndex = pGeometryNode->Index; nodeIndex < numNodes; nodeIndex = pGraph->Nodes[nodeIndex].Parent)
+        {
+            if (animated[nodeIndex])
+            {
+                pScene->UpdateGeometryNode(pGeometryNode);
+                break;
+            }
+        }
+    }
+}
+
+void ComputeWorldMatrices(const FauxRender::SceneGraph* pGraph, std::vector<glm::mat4>* pWorldMatrices)
+{
+    if (IsNull(pGraph) || IsNull(pWorldMatrices))
+    {
+        return;
+    }
+
+    const uint32_t numNodes = static_cast<uint32_t>(pGraph->Nodes.size());
+    pWorldMatrices->resize(numNodes);
+
+    //
+    // Nodes aren't sorted parents first. Each node walks up to the first
+    // ancestor that's done and then works its way back down, so every
+    // matrix is computed once.
+    //
+    std::vector<bool>     done(numNodes, false);
+    std::vector<uint32_t> chain;
+    for (uint32_t nodeIndex = 0; nodeIndex < numNodes; ++nodeIndex)
+    {
+        chain.clear();
+        for (uint32_t i = nodeIndex; (i < numNodes) && !done[i]; i = pGraph->Nodes[i].Parent)
+        {
+            chain.push_back(i);
+        }
+
+        for (auto it = chain.rbegin(); it != chain.rend(); ++it)
+        {
+            const auto& node         = pGraph->Nodes[*it];
+            mat4        parentMatrix = (node.Parent < numNodes) ? (*pWorldMatrices)[node.Parent] : mat4(1);
+
+            (*pWorldMatrices)[*it] = parentMatrix * CalculateTranformMatrix(&node);
+            done[*it]              = true;
+        }
+    }
+}
+
+bool ComputeJointMatrices(
+    const FauxRender::SceneGraph* pGraph,
+    const std::vector<glm::mat4>& worldMatrices,
+    const FauxRender::SceneNode*  pNode,
+    std::vector<glm::mat4>*       pJointMatrices)
+{
+    if (IsNull(pGraph) || IsNull(pNode) || IsNull(pNode->pSkin) || IsNull(pJointMatrices) || (pNode->Index >= worldMatrices.size()))
+    {
+        return false;
+    }
+
+    const auto& skin = *pNode->pSkin;
+
+    // glTF ignores the skinned node's own transform, joints are placed in
+    // world space. Going back to the node's space lets the instance
+    // transform apply as usual.
+    const mat4 inverseNodeMatrix = glm::inverse(worldMatrices[pNode->Index]);
+
+    pJointMatrices->resize(skin.Joints.size());
+    for (size_t i = 0; i < skin.Joints.size(); ++i)
+    {
+        if (skin.Joints[i] >= worldMatrices.size())
+        {
+            return false;
+        }
+
+        const mat4 inverseBindMatrix = (i < skin.InverseBindMatrices.size()) ? skin.InverseBindMatrices[i] : mat4(1);
+        (*pJointMatrices)[i]         = inverseNodeMatrix * worldMatrices[skin.Joints[i]] * inverseBindMatrix;
+    }
+
+    return true;
+}
+
+static void ApplyMorphTargets(const FauxRender::DeformableBatch& batch, const float* pMorphWeights, uint32_t numMorphWeights, FauxRender::DeformedVertices* pVertices)
+{
+    const uint32_t numTargets = std::min(numMorphWeights, CountU32(batch.Targets));
+    for (uint32_t targetIdx = 0; targetIdx < numTargets; ++targetIdx)
+    {
+        const float weight = pMorphWeights[targetIdx];
+        if (weight == 0)
+        {
+            continue;
+        }
+
+        const auto& target = batch.Targets[targetIdx];
+        if (target.PositionDeltas.size() == pVertices->Positions.size())
+        {
+            for (size_t i = 0; i < pVertices->Positions.size(); ++i)
+            {
+                pVertices->Positions[i] += weight * target.PositionDeltas[i];
+            }
+        }
+        if (target.NormalDeltas.size() == pVertices->Normals.size())
+        {
+            for (size_t i = 0; i < pVertices->Normals.size(); ++i)
+            {
+                pVertices->Normals[i] += weight * target.NormalDeltas[i];
+            }
+        }
+        if (target.TangentDeltas.size() == pVertices->Tangents.size())
+        {
+            for (size_t i = 0; i < pVertices->Tangents.size(); ++i)
+            {
+                pVertices->Tangents[i] += vec4(weight * target.TangentDeltas[i], 0);
+            }
+        }
+    }
+}
+
+#if defined(FAUX_RENDER_SSE2)
+static inline __m128 TransformSSE2(const __m128 (&columns)[4], float x, float y, float z, __m128 w)
+{
+    __m128 r = _mm_mul_ps(columns[0], _mm_set1_ps(x));
+    r        = _mm_add_ps(r, _mm_mul_ps(columns[1], _mm_set1_ps(y)));
+    r        = _mm_add_ps(r, _mm_mul_ps(columns[2], _mm_set1_ps(z)));
+    return _mm_add_ps(r, _mm_mul_ps(columns[3], w));
+}
+#endif
+
+static void SkinVertices(const FauxRender::DeformableBatch& batch, const glm::mat4* pJointMatrices, uint32_t numJoints, FauxRender::DeformedVertices* pVertices)
+{
+    const uint32_t numVertices = CountU32(pVertices->Positions);
+    const bool     hasNormals  = (pVertices->Normals.size() == numVertices);
+    const bool     hasTangents = (pVertices->Tangents.size() == numVertices);
+    const uint32_t maxJoint    = numJoints - 1;
+
+    for (uint32_t i = 0; i < numVertices; ++i)
+    {
+        const u16vec4& joints  = batch.Joints[i];
+        const vec4&    weights = batch.Weights[i];
+
+        const float* pJoint0 = &pJointMatrices[std::min<uint32_t>(joints.x, maxJoint)][0][0];
+        const float* pJoint1 = &pJointMatrices[std::min<uint32_t>(joints.y, maxJoint)][0][0];
+        const float* pJoint2 = &pJointMatrices[std::min<uint32_t>(joints.z, maxJoint)][0][0];
+        const float* pJoint3 = &pJointMatrices[std::min<uint32_t>(joints.w, maxJoint)][0][0];
+
+#if defined(FAUX_RENDER_SSE2)
+        // Blend the four joint matrices a column at a time
+        const __m128 w0 = _mm_set1_ps(weights.x);
+        const __m128 w1 = _mm_set1_ps(weights.y);
+        const __m128 w2 = _mm_set1_ps(weights.z);
+        const __m128 w3 = _mm_set1_ps(weights.w);
+
+        __m128 columns[4];
+        for (uint32_t c = 0; c < 4; ++c)
+        {
+            __m128 column = _mm_mul_ps(_mm_loadu_ps(pJoint0 + 4 * c), w0);
+            column        = _mm_add_ps(column, _mm_mul_ps(_mm_loadu_ps(pJoint1 + 4 * c), w1));
+            column        = _mm_add_ps(column, _mm_mul_ps(_mm_loadu_ps(pJoint2 + 4 * c), w2));
+            columns[c]    = _mm_add_ps(column, _mm_mul_ps(_mm_loadu_ps(pJoint3 + 4 * c), w3));
+        }
+
+        alignas(16) float result[4];
+
+        vec3& position = pVertices->Positions[i];
+        _mm_store_ps(result, TransformSSE2(columns, position.x, position.y, position.z, _mm_set1_ps(1.0f)));
+        position = vec3(result[0], result[1], result[2]);
+
+        if (hasNormals)
+        {
+            vec3& normal = pVertices->Normals[i];
+            _mm_store_ps(result, TransformSSE2(columns, normal.x, normal.y, normal.z, _mm_setzero_ps()));
+            normal = glm::normalize(vec3(result[0], result[1], result[2]));
+        }
+
+        if (hasTangents)
+        {
+            vec4& tangent = pVertices->Tangents[i];
+            _mm_store_ps(result, TransformSSE2(columns, tangent.x, tangent.y, tangent.z, _mm_setzero_ps()));
+            tangent = vec4(glm::normalize(vec3(result[0], result[1], result[2])), tangent.w);
+        }
+#else
+        const mat4 skinMatrix = weights.x * mat4(pJointMatrices[std::min<uint32_t>(joints.x, maxJoint)]) +
+                                weights.y * mat4(pJointMatrices[std::min<uint32_t>(joints.y, maxJoint)]) +
+                                weights.z * mat4(pJointMatrices[std::min<uint32_t>(joints.z, maxJoint)]) +
+                                weights.w * mat4(pJointMatrices[std::min<uint32_t>(joints.w, maxJoint)]);
+        (void)pJoint0;
+        (void)pJoint1;
+        (void)pJoint2;
+        (void)pJoint3;
+
+        vec3& position = pVertices->Positions[i];
+        position       = vec3(skinMatrix * vec4(position, 1));
+
+        if (hasNormals)
+        {
+            vec3& normal = pVertices->Normals[i];
+            normal       = glm::normalize(vec3(skinMatrix * vec4(normal, 0)));
+        }
+
+        if (hasTangents)
+        {
+            vec4& tangent = pVertices->Tangents[i];
+            tangent       = vec4(glm::normalize(vec3(skinMatrix * vec4(vec3(tangent), 0))), tangent.w);
+        }
+#endif
+    }
+}
+
+void DeformBatch(
+    const FauxRender::DeformableBatch& batch,
+    const float*                       pMorphWeights,
+    uint32_t                           numMorphWeights,
+    const glm::mat4*                   pJointMatrices,
+    uint32_t                           numJoints,
+    FauxRender::DeformedVertices*      pVertices)
+{
+    if (IsNull(pVertices))
+    {
+        return;
+    }
+
+    pVertices->Positions = batch.Positions;
+    pVertices->Normals   = batch.Normals;
+    pVertices->Tangents  = batch.Tangents;
+
+    if (!IsNull(pMorphWeights) && (numMorphWeights > 0))
+    {
+        ApplyMorphTargets(batch, pMorphWeights, numMorphWeights, pVertices);
+    }
+
+    const bool skinned = !batch.Joints.empty() && (batch.Joints.size() == batch.Positions.size()) && (batch.Weights.size() == batch.Positions.size());
+    if (skinned && !IsNull(pJointMatrices) && (numJoints > 0))
+    {
+        SkinVertices(batch, pJointMatrices, numJoints, pVertices);
+    }
+    else if (!batch.Targets.empty())
+    {
+        // Morphed normals and tangents need to be renormalized
+        for (auto& normal : pVertices->Normals)
+        {
+            normal = glm::normalize(normal);
+        }
+        for (auto& tangent : pVertices->Tangents)
+        {
+            tangent = vec4(glm::normalize(vec3(tangent)), tangent.w);
+        }
+    }
+}
+
+static void WriteDeformedAttribute(const FauxRender::BufferView& view, const float* pSrc, uint32_t srcComponents, size_t count, char* pMeshData)
+{
+    // clang-format off
+    uint32_t dstComponents = 0;
+    switch (view.Format)
+    {
+        default: break;
+        case GREX_FORMAT_R32G32B32_FLOAT    : dstComponents = 3; break;
+        case GREX_FORMAT_R32G32B32A32_FLOAT : dstComponents = 4; break;
+    }
+    // clang-format on
+
+    if (dstComponents == 0)
+    {
+        return;
+    }
+
+    const size_t elementSize = std::min(srcComponents, dstComponents) * sizeof(float);
+    const size_t n           = std::min<size_t>(count, view.Count);
+    for (size_t i = 0; i < n; ++i)
+    {
+        memcpy(pMeshData + view.Offset + i * view.Stride, pSrc + i * srcComponents, elementSize);
+    }
+}
+
+void WriteDeformedVertices(const FauxRender::PrimitiveBatch& batch, const FauxRender::DeformedVertices& vertices, char* pMeshData)
+{
+    if (IsNull(pMeshData))
+    {
+        return;
+    }
+
+    WriteDeformedAttribute(batch.PositionBufferView, reinterpret_cast<const float*>(DataPtr(vertices.Positions)), 3, vertices.Positions.size(), pMeshData);
+    WriteDeformedAttribute(batch.NormalBufferView, reinterpret_cast<const float*>(DataPtr(vertices.Normals)), 3, vertices.Normals.size(), pMeshData);
+    WriteDeformedAttribute(batch.TangentBufferView, reinterpret_cast<const float*>(DataPtr(vertices.Tangents)), 4, vertices.Tangents.size(), pMeshData);
+}
+
+bool UpdateDeformedMesh(
+    const FauxRender::SceneGraph* pGraph,
+    const std::vector<glm::mat4>& worldMatrices,
+    const FauxRender::SceneNode*  pNode,
+    FauxRender::DeformedVertices* pScratch)
+{
+    if (IsNull(pGraph) || IsNull(pNode) || IsNull(pNode->pMesh) || IsNull(pScratch))
+    {
+        return false;
+    }
+
+    auto pMesh = pNode->pMesh;
+    if (pMesh->DeformableBatches.empty())
+    {
+        return true;
+    }
+    if (IsNull(pNode->pDeformedBuffer))
+    {
+        assert(false && "node has no deformed buffer, see SceneGraph::CreateDeformedBuffers()");
+        return false;
+    }
+
+    std::vector<mat4> jointMatrices;
+    if (!IsNull(pNode->pSkin) && !ComputeJointMatrices(pGraph, worldMatrices, pNode, &jointMatrices))
+    {
+        return false;
+    }
+
+    const auto& morphWeights = !pNode->MorphWeights.empty() ? pNode->MorphWeights : pMesh->MorphWeights;
+
+    char* pMeshData = nullptr;
+    if (!pNode->pDeformedBuffer->Map(reinterpret_cast<void**>(&pMeshData)))
+    {
+        assert(false && "map deformed buffer failed!");
+        return false;
+    }
+
+    for (const auto& batch : pMesh->DeformableBatches)
+    {
+        DeformBatch(batch, DataPtr(morphWeights), CountU32(morphWeights), DataPtr(jointMatrices), CountU32(jointMatrices), pScratch);
+        WriteDeformedVertices(pMesh->DrawBatches[batch.BatchIndex], *pScratch, pMeshData);
+    }
+
+    pNode->pDeformedBuffer->Unmap();
+
+    return true;
+}
+
+static bool LoadGLTFMesh(
+    LoaderInternals*               pInternals,
+    const FauxRender::LoadOptions& loadOptions,
+    const cgltf_data*              pGltfData,
+    const cgltf_mesh*              pGltfMesh,
+    FauxRender::Mesh*              pTargetMesh)
+{
+    if (IsNull(pInternals) || IsNull(pGltfData) || IsNull(pGltfMesh) || IsNull(pTargetMesh))
+    {
+        return false;
+    }
+
+    auto pTargetGraph = pInternals->pTargetGraph;
+
+    // Name
+    pTargetMesh->Name = !IsNull(pGltfMesh->name) ? pGltfMesh->name : "";
+    GREX_LOG_INFO("    Loading mesh: " << pTargetMesh->Name);
+
+    // Mesh's buffer info
+    auto& targetBufferInfo = pInternals->MeshBufferInfo[pTargetMesh];
+
+    // Buffer size
+    uint32_t& targetBufferSize = targetBufferInfo.BufferSize;
+    targetBufferSize           = 0;
+
+    // Default morph target weights
+    if (!IsNull(pGltfMesh->weights))
+    {
+        pTargetMesh->MorphWeights.assign(pGltfMesh->weights, pGltfMesh->weights + pGltfMesh->weights_count);
+    }
+
+    // Primitives
+    for (size_t gltfPrimIdx = 0; gltfPrimIdx < pGltfMesh->primitives_count; ++gltfPrimIdx)
+    {
+        // GLTF primitive
+        auto& gltfPrim = pGltfMesh->primitives[gltfPrimIdx];
+
+        // GLTF Material
+        auto& pGltfMaterial = gltfPrim.material;
+
+        // Target batch
+        pTargetMesh->DrawBatches.push_back({});
+        auto& targetBatch = pTargetMesh->DrawBatches.back();
+
+        // Material
+        //
+        // @TODO: Do we neeed a default material for objects
+        //        that don't have a material?
+        //
+        if (!IsNull(pGltfMaterial))
+        {
+            FauxRender::Material* pTargetMaterial = nullptr;
+            auto                  it              = pInternals->MaterialMap.find(gltfPrim.material);
+            if (it != pInternals->MaterialMap.end())
+            {
+                pTargetMaterial = (*it).second;
+            }
+            else
+            {
+                // Add target material to graph
+                pTargetMaterial = pTargetGraph->AddMaterial();
+
+                // Update map
+                pInternals->MaterialMap[pGltfMaterial] = pTargetMaterial;
+            }
+
+            targetBatch.pMaterial = pTargetMaterial;
+        }
+
+        // Skinned and morphed primitives are deformed on the CPU, their
+        // positions, normals and tangents have to be float
+        const bool skinned = !IsNull(FindGLTFAttribute(&gltfPrim, cgltf_attribute_type_joints, 0)) &&
+                             !IsNull(FindGLTFAttribute(&gltfPrim, cgltf_attribute_type_weights, 0));
+        const bool deformable = skinned || (gltfPrim.targets_count > 0);
+
+        // Index data
+        {
+            // Data chunks should be on 16 byte alignment
+            targetBufferSize = Align<uint32_t>(targetBufferSize, 16);
+
+            const auto& pGltfIndexData   = gltfPrim.indices;
+            const auto& pGltfBufferView  = pGltfIndexData->buffer_view;
+            auto&       targetBufferView = targetBatch.IndexBufferView;
+
+            // Target format
+            auto targetFormat = ToGREXFormat(pGltfIndexData);
+            assert((targetFormat != GREX_FORMAT_UNKNOWN) && "invalid position attribute format");
+
+            // Fill out destination buffer view
+            const uint32_t gltfStride = static_cast<uint32_t>(pGltfIndexData->stride);
+            const uint32_t gltfCount  = static_cast<uint32_t>(pGltfIndexData->count);
+            //
+            targetBufferView.Offset = targetBufferSize;
+            targetBufferView.Size   = gltfCount * gltfStride;
+            targetBufferView.Stride = gltfStride;
+            targetBufferView.Format = targetFormat;
+            targetBufferView.Count  = gltfCount;
+
+            // Increment destination buffer offset
+            targetBufferSize += targetBufferView.Size;
+
+            // Build copy range
+            BufferCopyRange copyRange = {};
+            copyRange.pGltfBufferView = pGltfBufferView;
+            copyRange.GltfOffset      = static_cast<uint32_t>(pGltfIndexData->offset);
+            copyRange.TargetOffset    = targetBufferView.Offset;
+            copyRange.Size            = targetBufferView.Size;
+
+            // Add copy range
+            targetBufferInfo.CopyRanges.push_back(copyRange);
+        }
+
+        // Vertex data
+        for (size_t gltfAttrIdx = 0; gltfAttrIdx < gltfPrim.attributes_count; ++gltfAttrIdx)
+        {
+            // Data chunks should be on 16 byte alignment
+            targetBufferSize = Align<uint32_t>(targetBufferSize, 16);
+
+            const auto& gltfAttr          = gltfPrim.attributes[gltfAttrIdx];
+            const auto& pGltfVertexData   = gltfAttr.data;
+            const auto& pGltfBufferView   = pGltfVertexData->buffer_view;
+            BufferView* pTargetBufferView = nullptr;
+
+            // Target format
+            //
+            // KHR_mesh_quantization: normalized attributes keep their integer
+            // format only if the caller turns off dequantizing. Attributes
+            // that aren't normalized - D3D12 has no scaled formats - and vec3
+            // attributes whose elements aren't padded to 4 components are
+            // always converted.
+            //
+            auto       targetFormat = ToGREXFormat(pGltfVertexData);
+            const bool quantized    = (pGltfVertexData->component_type != cgltf_component_type_r_32f);
+            bool       dequantize   = false;
+            if (quantized)
+            {
+                const uint32_t numComponents = static_cast<uint32_t>(cgltf_num_components(pGltfVertexData->type));
+                const uint32_t elementSize   = ((numComponents == 3) ? 4 : numComponents) * GetGLTFComponentSize(pGltfVertexData->component_type);
+
+                dequantize = loadOptions.DequantizeVertexAttributes ||
+                             (targetFormat == GREX_FORMAT_UNKNOWN) ||
+                             !pGltfVertexData->normalized ||
+                             (pGltfVertexData->stride < elementSize);
+            }
+            if (quantized && deformable)
+            {
+                dequantize = dequantize ||
+                             (gltfAttr.type == cgltf_attribute_type_position) ||
+                             (gltfAttr.type == cgltf_attribute_type_normal) ||
+                             (gltfAttr.type == cgltf_attribute_type_tangent);
+            }
+            if (dequantize)
+            {
+                targetFormat = ToGREXFloatFormat(pGltfVertexData);
+            }
+            assert((targetFormat != GREX_FORMAT_UNKNOWN) && "invalid position attribute format");
+
+            // Determine attribute
+            switch (gltfAttr.type)
+            {
+                default: {
+                    assert(false && "unsupported attribute type");
+                }
+                break;
+
+                case cgltf_attribute_type_position: {
+                    pTargetBufferView = &targetBatch.PositionBufferView;
+                    // assert((dstFormat != GREX_FORMAT_UNKNOWN) && "invalid position attribute format");
+
+                    // Bounds - min/max are required for POSITION accessors
+                    if (pGltfVertexData->has_min && pGltfVertexData->has_max)
+                    {
+                        targetBatch.Bounds.Min = vec3(pGltfVertexData->min[0], pGltfVertexData->min[1], pGltfVertexData->min[2]);
+                        targetBatch.Bounds.Max = vec3(pGltfVertexData->max[0], pGltfVertexData->max[1], pGltfVertexData->max[2]);
+
+                        // min/max hold the stored values, not the normalized ones
+                        if (pGltfVertexData->normalized)
+                        {
+                            for (uint32_t i = 0; i < 3; ++i)
+                            {
+                                targetBatch.Bounds.Min[i] = NormalizeGLTFComponent(targetBatch.Bounds.Min[i], pGltfVertexData->component_type);
+                                targetBatch.Bounds.Max[i] = NormalizeGLTFComponent(targetBatch.Bounds.Max[i], pGltfVertexData->component_type);
+                            }
+                        }
+                    }
+                    else
+                    {
+                        GREX_LOG_WARN("      POSITION accessor has no min/max, primitive " << gltfPrimIdx << " will not be culled");
+                    }
+                }
+                break;
+
+                case cgltf_attribute_type_normal: {
+                    if (loadOptions.EnableNormals)
+                    {
+                        pTargetBufferView = &targetBatch.NormalBufferView;
+                        // assert((dstFormat != GREX_FORMAT_UNKNOWN) && "invalid normal attribute format");
+                    }
+                }
+                break;
+
+                case cgltf_attribute_type_tangent: {
+                    if (loadOptions.EnableTangents)
+                    {
+                        pTargetBufferView = &targetBatch.TangentBufferView;
+                        // assert((dstFormat != GREX_FORMAT_UNKNOWN) && "invalid tangent attribute format");
+                    }
+                }
+                break;
+
+                case cgltf_attribute_type_texcoord: {
+                    if (loadOptions.EnableTexCoords)
+                    {
+                        pTargetBufferView = &targetBatch.TexCoordBufferView;
+                        // assert((dstFormat != GREX_FORMAT_UNKNOWN) && "invalid tex coord attribute format");
+                    }
+                }
+                break;
+
+                case cgltf_attribute_type_color: {
+                    if (loadOptions.EnableVertexColors)
+                    {
+                        pTargetBufferView = &targetBatch.VertexColorBufferView;
+                        // assert((dstFormat != GREX_FORMAT_UNKNOWN) && "invalid vertex color attribute format");
+                    }
+                }
+                break;
+
+                // Read from the glTF data for deformable batches
+                case cgltf_attribute_type_joints:
+                case cgltf_attribute_type_weights: {
+                }
+                break;
+            }
+
+            // Attributes that aren'te enabled by calling code will get get skipped.
+            if (!IsNull(pTargetBufferView))
+            {
+                // Fill out destination buffer view - dequantized attributes
+                // are written tightly packed
+                const uint32_t gltfStride   = static_cast<uint32_t>(pGltfVertexData->stride);
+                const uint32_t gltfCount    = static_cast<uint32_t>(pGltfVertexData->count);
+                const uint32_t targetStride = dequantize ? static_cast<uint32_t>(cgltf_num_components(pGltfVertexData->type) * sizeof(float)) : gltfStride;
+                //
+                pTargetBufferView->Offset = targetBufferSize;
+                pTargetBufferView->Size   = gltfCount * targetStride;
+                pTargetBufferView->Stride = targetStride;
+                pTargetBufferView->Format = targetFormat;
+                pTargetBufferView->Count  = gltfCount;
+
+                // Increment destination buffer offset
+                targetBufferSize += pTargetBufferView->Size;
+
+                // Build copy range
+                BufferCopyRange copyRange     = {};
+                copyRange.pGltfBufferView     = pGltfBufferView;
+                copyRange.GltfOffset          = static_cast<uint32_t>(pGltfVertexData->offset);
+                copyRange.TargetOffset        = pTargetBufferView->Offset;
+                copyRange.Size                = pTargetBufferView->Size;
+                copyRange.pDequantizeAccessor = dequantize ? pGltfVertexData : nullptr;
+
+                // Add copy range
+                targetBufferInfo.CopyRanges.push_back(copyRange);
+            }
+        }
+
+        // Missing tangents - the copy range's data is generated once the
+        // glTF buffers are loaded
+        if (loadOptions.EnableTangents && loadOptions.GenerateMissingTangents && CanGenerateGLTFTangents(&gltfPrim))
+        {
+            // Data chunks should be on 16 byte alignment
+            targetBufferSize = Align<uint32_t>(targetBufferSize, 16);
+
+            auto&          targetBufferView = targetBatch.TangentBufferView;
+            const uint32_t count            = static_cast<uint32_t>(FindGLTFAttribute(&gltfPrim, cgltf_attribute_type_position, 0)->count);
+            //
+            targetBufferView.Offset = targetBufferSize;
+            targetBufferView.Size   = count * sizeof(vec4);
+            targetBufferView.Stride = sizeof(vec4);
+            targetBufferView.Format = GREX_FORMAT_R32G32B32A32_FLOAT;
+            targetBufferView.Count  = count;
+
+            // Increment destination buffer offset
+            targetBufferSize += targetBufferView.Size;
+
+            // Build copy range
+            BufferCopyRange copyRange = {};
+            copyRange.TargetOffset    = targetBufferView.Offset;
+            copyRange.Size            = targetBufferView.Size;
+
+            // Add copy range and job
+            TangentJob tangentJob     = {};
+            tangentJob.pGltfPrim      = &gltfPrim;
+            tangentJob.CopyRangeIndex = CountU32(targetBufferInfo.CopyRanges);
+            targetBufferInfo.TangentJobs.push_back(tangentJob);
+
+            targetBufferInfo.CopyRanges.push_back(copyRange);
+        }
+
+        // Deformable batch - the vertex data is filled in once the glTF
+        // buffers are loaded. Bounds change with the pose, so the batch
+        // isn't culled.
+        if (deformable)
+        {
+            FauxRender::DeformableBatch deformableBatch = {};
+            deformableBatch.BatchIndex                  = CountU32(pTargetMesh->DrawBatches) - 1;
+            pTargetMesh->DeformableBatches.push_back(deformableBatch);
+
+            targetBufferInfo.DeformablePrims.push_back(&gltfPrim);
+
+            targetBatch.Bounds = {};
+        }
+    }
+
+    // Mesh bounds - if any batch has no bounds the mesh can't be culled
+    pTargetMesh->Bounds = {};
+    for (auto& batch : pTargetMesh->DrawBatches)
+    {
+        if (!batch.Bounds.IsValid())
+        {
+            pTargetMesh->Bounds = {};
+            break;
+        }
+        pTargetMesh->Bounds.Expand(batch.Bounds);
+    }
+
+    return true;
+}
+
+static bool IsReadableGLTFAccessor(const cgltf_accessor* pAccessor)
+{
+    // Sparse accessors without a buffer view aren't supported
+    return !IsNull(pAccessor) && !IsNull(pAccessor->buffer_view) && !IsNull(GetGLTFBufferViewData(pAccessor->buffer_view));
+}
+
+static void ReadDeformedAttribute(const FauxRender::BufferView& view, const char* pMeshData, uint32_t numComponents, float* pDst)
+{
+    if (view.Count == 0)
+    {
+        return;
+    }
+
+    const size_t elementSize = numComponents * sizeof(float);
+    for (uint32_t i = 0; i < view.Count; ++i)
+    {
+        memcpy(pDst + i * numComponents, pMeshData + view.Offset + i * view.Stride, elementSize);
+    }
+}
+
+static void ReadGLTFMorphDeltas(const cgltf_accessor* pAccessor, uint32_t count, std::vector<vec3>* pDeltas)
+{
+    if (!IsReadableGLTFAccessor(pAccessor) || (pAccessor->count != count))
+    {
+        return;
+    }
+
+    pDeltas->resize(count);
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        ReadGLTFElement(pAccessor, i, &(*pDeltas)[i][0], 3);
+    }
+}
+
+//
+// Fills in the mesh's deformable batches. Positions, normals and tangents
+// are read back from the mesh data since they're already converted to
+// float there - and include generated tangents. Joints, weights and morph
+// targets come from the glTF accessors.
+//
+static void LoadGLTFDeformableData(const BufferInfo& targetBufferInfo, FauxRender::Mesh* pTargetMesh, const char* pMeshData)
+{
+    for (size_t i = 0; i < pTargetMesh->DeformableBatches.size(); ++i)
+    {
+        auto&       deformable = pTargetMesh->DeformableBatches[i];
+        const auto& batch      = pTargetMesh->DrawBatches[deformable.BatchIndex];
+        const auto  pGltfPrim  = targetBufferInfo.DeformablePrims[i];
+
+        const uint32_t numVertices = batch.PositionBufferView.Count;
+
+        deformable.Positions.resize(numVertices);
+        ReadDeformedAttribute(batch.PositionBufferView, pMeshData, 3, &deformable.Positions[0][0]);
+
+        if (batch.NormalBufferView.Count == numVertices)
+        {
+            deformable.Normals.resize(numVertices);
+            ReadDeformedAttribute(batch.NormalBufferView, pMeshData, 3, &deformable.Normals[0][0]);
+        }
+
+        if (batch.TangentBufferView.Count == numVertices)
+        {
+            deformable.Tangents.resize(numVertices);
+            ReadDeformedAttribute(batch.TangentBufferView, pMeshData, 4, &deformable.Tangents[0][0]);
+        }
+
+        // Joints and weights
+        auto pGltfJoints  = FindGLTFAttribute(pGltfPrim, cgltf_attribute_type_joints, 0);
+        auto pGltfWeights = FindGLTFAttribute(pGltfPrim, cgltf_attribute_type_weights, 0);
+        if (IsReadableGLTFAccessor(pGltfJoints) && IsReadableGLTFAccessor(pGltfWeights) &&
+            (pGltfJoints->count == numVertices) && (pGltfWeights->count == numVertices))
+        {
+            deformable.Joints.resize(numVertices);
+            deformable.Weights.resize(numVertices);
+            for (uint32_t vtxIdx = 0; vtxIdx < numVertices; ++vtxIdx)
+            {
+                vec4 joints = vec4(0);
+                ReadGLTFElement(pGltfJoints, vtxIdx, &joints[0], 4);
+
+                vec4 weights = vec4(0);
+                ReadGLTFElement(pGltfWeights, vtxIdx, &weights[0], 4);
+
+                // Quantized weights don't always sum to exactly one
+                const float sum = weights.x + weights.y + weights.z + weights.w;
+                weights         = (sum > 0) ? (weights / sum) : vec4(1, 0, 0, 0);
+
+                deformable.Joints[vtxIdx] = u16vec4(
+                    static_cast<uint16_t>(joints.x),
+                    static_cast<uint16_t>(joints.y),
+                    static_cast<uint16_t>(joints.z),
+                    static_cast<uint16_t>(joints.w));
+                deformable.Weights[vtxIdx] = weights;
+            }
+        }
+
+        // Morph targets
+        deformable.Targets.resize(pGltfPrim->targets_count);
+        for (size_t targetIdx = 0; targetIdx < pGltfPrim->targets_count; ++targetIdx)
+        {
+            const auto& gltfTarget = pGltfPrim->targets[targetIdx];
+            auto&       target     = deformable.Targets[targetIdx];
+            for (size_t attrIdx = 0; attrIdx < gltfTarget.attributes_count; ++attrIdx)
+            {
+                const auto& gltfAttr = gltfTarget.attributes[attrIdx];
+
+                // clang-format off
+                switch (gltfAttr.type)
+                {
+                    default: break;
+                    case cgltf_attribute_type_position : ReadGLTFMorphDeltas(gltfAttr.data, numVertices, &target.PositionDeltas); break;
+                    case cgltf_attribute_type_normal   : ReadGLTFMorphDeltas(gltfAttr.data, numVertices, &target.NormalDeltas); break;
+                    case cgltf_attribute_type_tangent  : ReadGLTFMorphDeltas(gltfAttr.data, numVertices, &target.TangentDeltas); break;
+                }
+                // clang-format on
+            }
+        }
+    }
+}
+
+static bool LoadGLTFMeshGeometryData(
+    LoaderInternals*    pInternals,
+    FauxRender::Buffer* pStagingBuffer,
+    const cgltf_data*   pGltfData,
+    const BufferInfo&   targetBufferInfo,
+    FauxRender::Mesh*   pTargetMesh)
+{
+    if (IsNull(pStagingBuffer) || IsNull(pGltfData) || IsNull(pTargetMesh))
+    {
+        return false;
+    }
+
+    auto pTargetGraph = pInternals->pTargetGraph;
+
+    // Map staging buffer
+    char* pDstData = nullptr;
+    bool  res      = pStagingBuffer->Map(reinterpret_cast<void**>(&pDstData));
+    if (!res)
+    {
+        assert(false && "create staging buffer failed!");
+        return false;
+    }
+
+    // Copy geometry data to staging buffer - optimization and deformable
+    // batches read the data back, so it's gathered in host memory first
+    const bool deformable = !pTargetMesh->DeformableBatches.empty();
+    if (pInternals->OptimizeMeshes || deformable)
+    {
+        std::vector<char> meshData(targetBufferInfo.BufferSize);
+        for (const auto& copyRange : targetBufferInfo.CopyRanges)
+        {
+            CopyGLTFRange(copyRange, meshData.data());
+        }
+
+        if (pInternals->OptimizeMeshes)
+        {
+            OptimizeMeshData(pTargetMesh, meshData.data());
+        }
+
+        LoadGLTFDeformableData(targetBufferInfo, pTargetMesh, meshData.data());
+
+        memcpy(pDstData, meshData.data(), meshData.size());
+    }
+    else
+    {
+        for (size_t rangeIdx = 0; rangeIdx < targetBufferInfo.CopyRanges.size(); ++rangeIdx)
+        {
+            CopyGLTFRange(targetBufferInfo.CopyRanges[rangeIdx], pDstData);
+        }
+    }
+
+    // Unmap staging buffer
+    pStagingBuffer->Unmap();
+
+    // Create and copy data to buffer for target mesh
+    FauxRender::Buffer* pTargetBuffer = nullptr;
+    //
+    res = pTargetGraph->CreateBuffer(pStagingBuffer, deformable, &pTargetBuffer);
+    if (!res)
+    {
+        return false;
+    }
+
+    // Update target mesh's buffer
+    pTargetMesh->pBuffer = pTargetBuffer;
+
+    return true;
+}
+
+static bool LoadGLTFGeometryData(LoaderInternals* pInternals, const cgltf_data* pGltfData)
+{
+    if (IsNull(pInternals) || IsNull(pGltfData))
+    {
+        return false;
+    }
+
+    auto pTargetGraph = pInternals->pTargetGraph;
+
+    // Try to reduce possible fragmentation
+    //
+    // Create a staging buffer that's 128MB. This should handle
+    // the majority of the cases. If not it will get reallocated.
+    //
+    const uint32_t      kStagingBufferSize = 128 * 1024 * 1024;
+    FauxRender::Buffer* pStagingBuffer     = nullptr;
+    bool                res                = pTargetGraph->CreateTemporaryBuffer(kStagingBufferSize, nullptr, true, &pStagingBuffer);
+    if (!res)
+    {
+        assert(false && "create staging buffer failed!");
+        return false;
+    }
+
+    // Create target mesh buffers
+    for (auto& iter : pInternals->MeshBufferInfo)
+    {
+        auto        pTargetMesh      = iter.first;
+        const auto& targetBufferInfo = iter.second;
+
+        // Reallocate staging buffer if buffer size is too large.
+        //
+        // This is hacky and can potentially exhaust GPU memory.
+        //
+        // TODO: Change to handle copies use chunks of kStagingBufferSize if
+        //       target buffer exceeds kStagingBufferSize.
+        //
+        if (targetBufferInfo.BufferSize > pStagingBuffer->Size)
+        {
+            // Destroy current staging buffer
+            pTargetGraph->DestroyTemporaryBuffer(&pStagingBuffer);
+
+            // Allocate new staging buffer
+            bool res = pTargetGraph->CreateTemporaryBuffer(targetBufferInfo.BufferSize, nullptr, true, &pStagingBuffer);
+            if (!res)
+            {
+                assert(false && "create staging buffer failed!");
+                return false;
+            }
+        }
+
+        // Load mesh's geometry data
+        bool res = LoadGLTFMeshGeometryData(pInternals, pStagingBuffer, pGltfData, targetBufferInfo, pTargetMesh);
+        if (!res)
+        {
+            return false;
+        }
+    }
+
+    // Destroy staging buffer
+    pTargetGraph->DestroyTemporaryBuffer(&pStagingBuffer);
+
+    return true;
+}
+
+//
+// Image loading is split into decoding, which only touches the glTF data
+// and can run on any thread, and creating the API image from the decoded
+// data, which has to happen on the thread that owns the graph.
+//
+struct DecodedImage
+{
+    // PNG, JPG, etc
+    BitmapRGBA8u Bitmap = {};
+
+    // KTX2 - transcoded if needed
+    uint32_t               Width      = 0;
+    uint32_t               Height     = 0;
+    GREXFormat             Format     = GREX_FORMAT_UNKNOWN;
+    std::vector<MipOffset> MipOffsets = {};
+    std::vector<char>      Data       = {};
+};
+
+static bool DecodeGLTFImageKTX(
+    const std::filesystem::path& gltfPath,
+    const cgltf_image*           pGltfImage,
+    DecodedImage*                pDecodedImage)
+{
+    if (IsNull(pGltfImage) || IsNull(pDecodedImage))
+    {
+        return false;
+    }
+
+    // Scope utility class since there's a bunch of returns
+    struct KTXScopedTexture
+    {
+        ktxTexture2* pTexture = nullptr;
+
+        ~KTXScopedTexture()
+        {
+            if (pTexture != nullptr)
+            {
+                ktxTexture_Destroy(reinterpret_cast<ktxTexture*>(pTexture));
+                pTexture = nullptr;
+            }
+        }
+    };
+
+    // KTX texture object
+    KTXScopedTexture scopedTexture = {};
+
+    // Create texture from buffer view
+    if (!IsNull(pGltfImage->buffer_view))
+    {
+        auto* pGltfBufferView = pGltfImage->buffer_view;
+        auto* pGltfBuffer     = pGltfBufferView->buffer;
+
+        const ktx_size_t   srcDataSize = static_cast<ktx_size_t>(pGltfBufferView->size);
+        const ktx_uint8_t* pSrcData    = static_cast<const ktx_uint8_t*>(pGltfBuffer->data) + pGltfBufferView->offset;
+
+        auto ktxRes = ktxTexture_CreateFromMemory(
+            pSrcData,
+            srcDataSize,
+            0, // createFlags
+            reinterpret_cast<ktxTexture**>(&scopedTexture.pTexture));
+        if (ktxRes != KTX_SUCCESS)
+        {
+            assert(false && "KTX2 image load from memory failed");
+            return false;
+        }
+    }
+    // Create texture from file
+    else if (!IsNull(pGltfImage->uri))
+    {
+        const auto parentPath = gltfPath.parent_path();
+        const auto uriPath    = parentPath / pGltfImage->uri;
+
+        auto ktxRes = ktxTexture_CreateFromNamedFile(
+            uriPath.string().c_str(),
+            KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT,
+            reinterpret_cast<ktxTexture**>(&scopedTexture.pTexture));
+        if (ktxRes != KTX_SUCCESS)
+        {
+            assert(false && "KTX2 image load from file failed");
+            return false;
+        }
+    }
+    else
+    {
+        assert(false && "invalid KTX2 image data source");
+        return false;
+    }
+
+    // Target BC7 if transcode is needed
+    GREXFormat targetFormat = GREX_FORMAT_BC7_RGBA;
+    if (ktxTexture2_NeedsTranscoding(scopedTexture.pTexture))
+    {
+        auto ktxRes = ktxTexture2_TranscodeBasis(scopedTexture.pTexture, KTX_TTF_BC7_RGBA, 0);
+        if (ktxRes != KTX_SUCCESS)
+        {
+            assert(false && "KTX2 image transcode failed");
+            return false;
+        }
+    }
+    // Otherwise look up format using the vkFormat field in the texture
+    else
+    {
+        FauxRenderVkFormat ktxVkFormat = static_cast<FauxRenderVkFormat>(scopedTexture.pTexture->vkFormat);
+        switch (ktxVkFormat)
+        {
+            default: {
+                assert(false && "KTX2 format not supported");
+                return false;
+            }
+            break;
+
+            case FAUX_RENDER_VK_FORMAT_BC6H_SFLOAT_BLOCK: targetFormat = GREX_FORMAT_BC6H_SFLOAT; break;
+            case FAUX_RENDER_VK_FORMAT_BC6H_UFLOAT_BLOCK: targetFormat = GREX_FORMAT_BC6H_UFLOAT; break;
+        }
+    }
+
+    // Get pointer to image data for each level
+    std::vector<MipOffset> mipOffsets;
+    for (ktx_uint32_t mipLevel = 0; mipLevel < scopedTexture.pTexture->numLevels; ++mipLevel)
+    {
+        ktx_size_t imageOffset = 0;
+        //
+        auto ktxRes = ktxTexture_GetImageOffset(
+            reinterpret_cast<ktxTexture*>(scopedTexture.pTexture),
+            mipLevel,
+            0, // layer
+            0, // faceSlice,
+            &imageOffset);
+        if (ktxRes != KTX_SUCCESS)
+        {
+            assert(false && "KTX2 image get offset failed");
+            return false;
+        }
+
+        // Rows of 16 byte BC6H/BC7 blocks
+        const uint32_t levelWidth = std::max<uint32_t>(scopedTexture.pTexture->baseWidth >> mipLevel, 1);
+
+        MipOffset mipOffset = {};
+        mipOffset.Offset    = static_cast<uint32_t>(imageOffset);
+        mipOffset.RowStride = ((levelWidth + 3) / 4) * 16;
+        //
+        mipOffsets.push_back(mipOffset);
+    }
+
+    ktx_size_t imageDataSize = ktxTexture_GetDataSize(reinterpret_cast<ktxTexture*>(scopedTexture.pTexture));
+    if (imageDataSize == 0)
+    {
+        assert(false && "KTX2 image image data size is 0");
+        return false;
+    }
+
+    ktx_uint8_t* pKtxImageData = ktxTexture_GetData(reinterpret_cast<ktxTexture*>(scopedTexture.pTexture));
+    if (IsNull(pKtxImageData))
+    {
+        assert(false && "KTX2 image image data is null");
+        return false;
+    }
+
+    // Copy out the image data, the KTX texture is destroyed on return
+    pDecodedImage->Width      = static_cast<uint32_t>(scopedTexture.pTexture->baseWidth);
+    pDecodedImage->Height     = static_cast<uint32_t>(scopedTexture.pTexture->baseHeight);
+    pDecodedImage->Format     = targetFormat;
+    pDecodedImage->MipOffsets = mipOffsets;
+    pDecodedImage->Data.assign(reinterpret_cast<const char*>(pKtxImageData), reinterpret_cast<const char*>(pKtxImageData) + imageDataSize);
+
+    return true;
+}
+
+static bool DecodeGLTFImageBitmap(
+    const std::filesystem::path& gltfPath,
+    const cgltf_image*           pGltfImage,
+    DecodedImage*                pDecodedImage)
+{
+    if (IsNull(pGltfImage) || IsNull(pDecodedImage))
+    {
+        return false;
+    }
+
+    BitmapRGBA8u& bitmap = pDecodedImage->Bitmap;
+    //
+    if (!IsNull(pGltfImage->buffer_view))
+    {
+        auto* pGltfBufferView = pGltfImage->buffer_view;
+        auto* pGltfBuffer     = pGltfBufferView->buffer;
+
+        auto        srcDataSize = pGltfBufferView->size;
+        const char* pSrcData    = static_cast<const char*>(pGltfBuffer->data) + pGltfBufferView->offset;
+
+        bool res = BitmapRGBA8u::Load(srcDataSize, pSrcData, &bitmap);
+        if (!res)
+        {
+            assert(false && "image load from memory failed");
+            return false;
+        }
+    }
+    else if (!IsNull(pGltfImage->uri))
+    {
+        const auto parentPath = gltfPath.parent_path();
+        const auto uriPath    = parentPath / pGltfImage->uri;
+
+        bool res = BitmapRGBA8u::Load(uriPath, &bitmap);
+        if (!res)
+        {
+            assert(false && "image load from file failed");
+            return false;
+        }
+    }
+    else
+    {
+        assert(false && "invalid image data source");
+        return false;
+    }
+
+    // @TODO: Add mip map generation
+
+    return true;
+}
+
+static bool DecodeGLTFImage(
+    const std::filesystem::path& gltfPath,
+    const cgltf_image*           pGltfImage,
+    DecodedImage*                pDecodedImage)
+{
+    GREX_PROFILE_FUNCTION();
+
+    // Get mime type
+    std::string gltfMimeType = !IsNull(pGltfImage->mime_type) ? pGltfImage->mime_type : "";
+
+    // KTX image data
+    if (gltfMimeType == "image/ktx2")
+    {
+        return DecodeGLTFImageKTX(gltfPath, pGltfImage, pDecodedImage);
+    }
+
+    // PNG, JPG, etc image data
+    return DecodeGLTFImageBitmap(gltfPath, pGltfImage, pDecodedImage);
+}
+
+static bool CreateDecodedImage(
+    FauxRender::SceneGraph* pTargetGraph,
+    const DecodedImage&     decodedImage,
+    FauxRender::Image**     ppTargetImage)
+{
+    bool res = false;
+    if (!decodedImage.Bitmap.Empty())
+    {
+        res = pTargetGraph->CreateImage(&decodedImage.Bitmap, ppTargetImage);
+    }
+    else
+    {
+        res = pTargetGraph->CreateImage(
+            decodedImage.Width,
+            decodedImage.Height,
+            decodedImage.Format,
+            decodedImage.MipOffsets,
+            decodedImage.Data.size(),
+            DataPtr(decodedImage.Data),
+            ppTargetImage);
+    }
+
+    if (!res)
+    {
+        assert(false && "create image failed");
+        return false;
+    }
+
+    return true;
+}
+
+// Hands the decoded image to the texture streamer, which keeps the full mip
+// chain on the host and only creates the image with its mip tail resident.
+static bool CreateStreamedImage(
+    FauxRender::TextureStreamer* pStreamer,
+    FauxRender::SceneGraph*      pTargetGraph,
+    DecodedImage&&               decodedImage,
+    FauxRender::Image**          ppTargetImage)
+{
+    FauxRender::StreamingImageSource source = {};
+    if (!decodedImage.Bitmap.Empty())
+    {
+        if (!MakeStreamingImageSource(decodedImage.Bitmap, &source))
+        {
+            assert(false && "building streaming image source failed");
+            return false;
+        }
+    }
+    else
+    {
+        source.Width      = decodedImage.Width;
+        source.Height     = decodedImage.Height;
+        source.Format     = decodedImage.Format;
+        source.MipOffsets = std::move(decodedImage.MipOffsets);
+        source.Data       = std::move(decodedImage.Data);
+    }
+
+    if (!pStreamer->AddImage(pTargetGraph, std::move(source), ppTargetImage))
+    {
+        assert(false && "add streamed image failed");
+        return false;
+    }
+
+    return true;
+}
+
+static bool LoadGLTFImage(
+    LoaderInternals*    pInternals,
+    const cgltf_data*   pGltfData,
+    const cgltf_image*  pGltfImage,
+    FauxRender::Image** ppTargetImage)
+{
+    if (IsNull(pInternals) || IsNull(pGltfData) || IsNull(pGltfImage) || IsNull(ppTargetImage))
+    {
+        return false;
+    }
+
+    auto pTargetGraph = pInternals->pTargetGraph;
+
+    // Look up image
+    auto it = pInternals->ImageMap.find(pGltfImage);
+    if (it != pInternals->ImageMap.end())
+    {
+        // Image found, assign target image, and return
+        *ppTargetImage = (*it).second;
+        return true;
+    }
+
+    // No image found - so create one
+    std::string name = !IsNull(pGltfImage->name) ? pGltfImage->name : "";
+    GREX_LOG_INFO("    Loading image: " << name);
+
+    DecodedImage decodedImage = {};
+    if (!DecodeGLTFImage(pInternals->gltfPath, pGltfImage, &decodedImage))
+    {
+        return false;
+    }
+
+    // Target image
+    FauxRender::Image* pTargetImage = nullptr;
+    if (!IsNull(pInternals->pTextureStreamer))
+    {
+        if (!CreateStreamedImage(pInternals->pTextureStreamer, pTargetGraph, std::move(decodedImage), &pTargetImage))
+        {
+            return false;
+        }
+    }
+    else if (!CreateDecodedImage(pTargetGraph, decodedImage, &pTargetImage))
+    {
+        return false;
+    }
 
-                case cgltf_attribute_type_color: {
-                    if (loadOptions.EnableVertexColors)
-                    {
-                        pTargetBufferView = &targetBatch.VertexColorBufferView;
-                        // assert((dstFormat != GREX_FORMAT_UNKNOWN) && "invalid vertex color attribute format");
-                    }
-                }
-                break;
+    assert((pTargetImage != nullptr) && "pTargetImage is NULL");
+
+    // Update image name
+    pTargetImage->Name = name;
+
+    // Update map
+    pInternals->ImageMap[pGltfImage] = pTargetImage;
+
+    // Assign target image
+    *ppTargetImage = pTargetImage;
+
+    return true;
+}
+
+static bool LoadGLTFSampler(
+    LoaderInternals*      pInternals,
+    const cgltf_data*     pGltfData,
+    const cgltf_sampler*  pGltfSampler,
+    FauxRender::Sampler** ppTargetSampler)
+{
+    if (IsNull(pInternals) || IsNull(pGltfData) || IsNull(pGltfSampler) || IsNull(ppTargetSampler))
+    {
+        return false;
+    }
+
+    auto pTargetGraph = pInternals->pTargetGraph;
+
+    // Look up sampler
+    auto it = pInternals->SamplerMap.find(pGltfSampler);
+    if (it != pInternals->SamplerMap.end())
+    {
+        // Sampler found, assign target sampler, and return
+        *ppTargetSampler = (*it).second;
+        return true;
+    }
+
+    // No sampler found - so create one
+    auto targetSampler = std::make_unique<FauxRender::Sampler>();
+    if (!targetSampler)
+    {
+        assert(false && "allocation failed: FauxRender::Sampler");
+        return false;
+    }
+
+    // Get pointer to target mesh
+    auto pTargetSampler   = targetSampler.get();
+    pTargetSampler->Index = CountU32(pTargetGraph->Samplers);
+
+    // Update map
+    pInternals->SamplerMap[pGltfSampler] = pTargetSampler;
+
+    // Add target sampler to graph
+    pTargetGraph->Samplers.push_back(std::move(targetSampler));
+
+    // @TODO: Set sampler values
+    {
+        pTargetSampler->Name = !IsNull(pGltfSampler->name) ? pGltfSampler->name : "";
+        GREX_LOG_INFO("    Loading sampler: " << pTargetSampler->Name);
+    }
+
+    // Assign target sampler
+    *ppTargetSampler = pTargetSampler;
+
+    return true;
+}
+
+static bool LoadGLTFTexture(
+    LoaderInternals*          pInternals,
+    const cgltf_data*         pGltfData,
+    const cgltf_texture_view* pGltfTextureView,
+    FauxRender::Texture**     ppTargetTexture)
+{
+    if (IsNull(pInternals) || IsNull(pGltfData) || IsNull(pGltfTextureView) || IsNull(ppTargetTexture))
+    {
+        return false;
+    }
+
+    auto pTargetGraph = pInternals->pTargetGraph;
+
+    // GLTF texture
+    auto pGltfTexture = pGltfTextureView->texture;
+
+    // Look up texture
+    auto it = pInternals->TextureMap.find(pGltfTexture);
+    if (it != pInternals->TextureMap.end())
+    {
+        // Texture found, assign target texture, and return
+        *ppTargetTexture = (*it).second;
+        return true;
+    }
+
+    // No texture found - so create one
+    auto targetTexture = std::make_unique<FauxRender::Texture>();
+    if (!targetTexture)
+    {
+        assert(false && "allocation failed: FauxRender::Texture");
+        return false;
+    }
+
+    // Get pointer to target mesh
+    auto pTargetTexture = targetTexture.get();
+
+    // Update map
+    pInternals->TextureMap[pGltfTexture] = pTargetTexture;
+
+    // Add target sampler to graph
+    pTargetGraph->Textures.push_back(std::move(targetTexture));
+
+    // @TODO: Set texture values
+    {
+        pTargetTexture->Name = !IsNull(pGltfTexture->name) ? pGltfTexture->name : "";
+        GREX_LOG_INFO("    Loading texture: " << pTargetTexture->Name);
+    }
+
+    // Load image
+    {
+        auto pGltfImage = pGltfTexture->has_basisu ? pGltfTexture->basisu_image : pGltfTexture->image;
+        if (IsNull(pGltfImage))
+        {
+            assert("GLTF image data missing!");
+            return false;
+        }
+
+        if (pInternals->Progressive)
+        {
+            // The material falls back to a default image until the image is loaded
+            pInternals->DeferredImageTextures[pGltfImage].push_back(pTargetTexture);
+        }
+        else
+        {
+            bool res = LoadGLTFImage(pInternals, pGltfData, pGltfImage, &pTargetTexture->pImage);
+            if (!res)
+            {
+                return false;
             }
+        }
+    }
 
-            // Attributes that aren'te enabled by calling code will get get skipped.
-            if (!IsNull(pTargetBufferView))
+    // Load sampler
+    if (!IsNull(pGltfTexture->sampler))
+    {
+        bool res = LoadGLTFSampler(pInternals, pGltfData, pGltfTexture->sampler, &pTargetTexture->pSampler);
+        if (!res)
+        {
+            return false;
+        }
+    }
+
+    // Assign target texture
+    *ppTargetTexture = pTargetTexture;
+
+    return true;
+}
+
+static void CopyGLTFTexCoordTransform(
+    const cgltf_texture_view* pGltfTextureView,
+    bool&                     hasTexCoordTransform,
+    FauxRender::Material*     pTargetMaterial)
+{
+    if (!hasTexCoordTransform && pGltfTextureView->has_transform)
+    {
+        pTargetMaterial->TexCoordTranslate = {pGltfTextureView->transform.offset[0], pGltfTextureView->transform.offset[1]};
+        pTargetMaterial->TexCoordRotate    = pGltfTextureView->transform.rotation;
+        pTargetMaterial->TexCoordScale     = {pGltfTextureView->transform.scale[0], pGltfTextureView->transform.scale[1]};
+
+        hasTexCoordTransform = true;
+    }
+}
+
+static bool LoadGLTFMaterial(
+    LoaderInternals*      pInternals,
+    const cgltf_data*     pGltfData,
+    const cgltf_material* pGltfMaterial,
+    FauxRender::Material* pTargetMaterial)
+{
+    if (IsNull(pInternals) || IsNull(pGltfData) || IsNull(pGltfMaterial) || IsNull(pTargetMaterial))
+    {
+        return false;
+    }
+
+    // Name
+    pTargetMaterial->Name = !IsNull(pGltfMaterial->name) ? pGltfMaterial->name : "";
+    GREX_LOG_INFO("    Loading material: " << pTargetMaterial->Name);
+
+    // Tex coord transform flag
+    bool hasTexCoordTransform = false;
+
+    // PBR metallic roughness
+    if (pGltfMaterial->has_pbr_metallic_roughness)
+    {
+        auto& gltfPbr = pGltfMaterial->pbr_metallic_roughness;
+
+        pTargetMaterial->BaseColor = glm::vec4(
+            gltfPbr.base_color_factor[0],
+            gltfPbr.base_color_factor[1],
+            gltfPbr.base_color_factor[2],
+            gltfPbr.base_color_factor[3]);
+
+        pTargetMaterial->MetallicFactor  = gltfPbr.metallic_factor;
+        pTargetMaterial->RoughnessFactor = gltfPbr.roughness_factor;
+
+        // Base color texture
+        if (!IsNull(gltfPbr.base_color_texture.texture))
+        {
+            bool res = LoadGLTFTexture(pInternals, pGltfData, &gltfPbr.base_color_texture, &pTargetMaterial->pBaseColorTexture);
+            if (!res)
             {
-                // Fill out destination buffer view
-                const uint32_t gltfStride = static_cast<uint32_t>(pGltfVertexData->stride);
-                const uint32_t gltfCount  = static_cast<uint32_t>(pGltfVertexData->count);
-                //
-                pTargetBufferView->Offset = targetBufferSize;
-                pTargetBufferView->Size   = gltfCount * gltfStride;
-                pTargetBufferView->Stride = gltfStride;
-                pTargetBufferView->Format = targetFormat;
-                pTargetBufferView->Count  = gltfCount;
+                return false;
+            }
+
+            CopyGLTFTexCoordTransform(&gltfPbr.base_color_texture, hasTexCoordTransform, pTargetMaterial);
+        }
+
+        // Metallic roughness texture
+        if (!IsNull(gltfPbr.metallic_roughness_texture.texture))
+        {
+            bool res = LoadGLTFTexture(pInternals, pGltfData, &gltfPbr.metallic_roughness_texture, &pTargetMaterial->pMetallicRoughnessTexture);
+            if (!res)
+            {
+                return false;
+            }
+
+            CopyGLTFTexCoordTransform(&gltfPbr.metallic_roughness_texture, hasTexCoordTransform, pTargetMaterial);
+        }
+    }
+
+    // Normal texture
+    if (!IsNull(pGltfMaterial->normal_texture.texture))
+    {
+        bool res = LoadGLTFTexture(pInternals, pGltfData, &pGltfMaterial->normal_texture, &pTargetMaterial->pNormalTexture);
+        if (!res)
+        {
+            return false;
+        }
+
+        CopyGLTFTexCoordTransform(&pGltfMaterial->normal_texture, hasTexCoordTransform, pTargetMaterial);
+    }
+
+    // Occlusion texture
+    if (!IsNull(pGltfMaterial->occlusion_texture.texture))
+    {
+        bool res = LoadGLTFTexture(pInternals, pGltfData, &pGltfMaterial->occlusion_texture, &pTargetMaterial->pOcclusionTexture);
+        if (!res)
+        {
+            return false;
+        }
+
+        CopyGLTFTexCoordTransform(&pGltfMaterial->occlusion_texture, hasTexCoordTransform, pTargetMaterial);
+    }
 
-                // Increment destination buffer offset
-                targetBufferSize += pTargetBufferView->Size;
+    // Emissive
+    pTargetMaterial->Emissive = glm::vec3(
+        pGltfMaterial->emissive_factor[0],
+        pGltfMaterial->emissive_factor[1],
+        pGltfMaterial->emissive_factor[2]);
 
-                // Build copy range
-                const uint32_t gltfBufferViewOffset = static_cast<uint32_t>(pGltfBufferView->offset);
-                const uint32_t gltfAccessorOffset   = static_cast<uint32_t>(pGltfVertexData->offset);
-                //
-                BufferCopyRange copyRange = {};
-                copyRange.pGltfBuffer     = pGltfBufferView->buffer;
-                copyRange.GltfOffset      = gltfBufferViewOffset + gltfAccessorOffset;
-                copyRange.TargetOffset    = pTargetBufferView->Offset;
-                copyRange.Size            = pTargetBufferView->Size;
+    // Emissive strength
+    if (pGltfMaterial->has_emissive_strength)
+    {
+        pTargetMaterial->EmissiveStrength = pGltfMaterial->emissive_strength.emissive_strength;
+    }
 
-                // Add copy range
-                targetBufferInfo.CopyRanges.push_back(copyRange);
-            }
+    // Emissive texture
+    if (!IsNull(pGltfMaterial->emissive_texture.texture))
+    {
+        bool res = LoadGLTFTexture(pInternals, pGltfData, &pGltfMaterial->emissive_texture, &pTargetMaterial->pEmissiveTexture);
+        if (!res)
+        {
+            return false;
         }
+
+        CopyGLTFTexCoordTransform(&pGltfMaterial->emissive_texture, hasTexCoordTransform, pTargetMaterial);
     }
 
     return true;
 }
 
-static bool LoadGLTFMeshGeometryData(
-    LoaderInternals*    pInternals,
-    FauxRender::Buffer* pStagingBuffer,
-    const cgltf_data*   pGltfData,
-    const BufferInfo&   targetBufferInfo,
-    FauxRender::Mesh*   pTargetMesh)
+static bool LoadGLTFSkins(LoaderInternals* pInternals, const cgltf_data* pGltfData)
 {
-    if (IsNull(pStagingBuffer) || IsNull(pGltfData) || IsNull(pTargetMesh))
+    if (IsNull(pInternals) || IsNull(pGltfData))
     {
         return false;
     }
 
     auto pTargetGraph = pInternals->pTargetGraph;
 
-    // Map staging buffer
-    char* pDstData = nullptr;
-    bool  res      = pStagingBuffer->Map(reinterpret_cast<void**>(&pDstData));
-    if (!res)
+    // Graph skins are indexed by the glTF skin index
+    const size_t skinBase = pTargetGraph->Skins.size();
+    for (size_t gltfSkinIdx = 0; gltfSkinIdx < pGltfData->skins_count; ++gltfSkinIdx)
     {
-        assert(false && "create staging buffer failed!");
-        return false;
+        const auto& gltfSkin = pGltfData->skins[gltfSkinIdx];
+
+        auto pSkin  = std::make_unique<FauxRender::Skin>();
+        pSkin->Name = !IsNull(gltfSkin.name) ? gltfSkin.name : "";
+
+        pSkin->Joints.resize(gltfSkin.joints_count);
+        pSkin->InverseBindMatrices.resize(gltfSkin.joints_count, mat4(1));
+        for (size_t jointIdx = 0; jointIdx < gltfSkin.joints_count; ++jointIdx)
+        {
+            pSkin->Joints[jointIdx] = static_cast<uint32_t>(cgltf_node_index(pGltfData, gltfSkin.joints[jointIdx]));
+        }
+
+        auto pGltfMatrices = gltfSkin.inverse_bind_matrices;
+        if (IsReadableGLTFAccessor(pGltfMatrices))
+        {
+            const uint32_t count = static_cast<uint32_t>(std::min(pGltfMatrices->count, gltfSkin.joints_count));
+            for (uint32_t i = 0; i < count; ++i)
+            {
+                ReadGLTFElement(pGltfMatrices, i, &pSkin->InverseBindMatrices[i][0][0], 16);
+            }
+        }
+
+        GREX_LOG_INFO("    Loaded skin: " << pSkin->Name << " (" << pSkin->Joints.size() << " joints)");
+
+        pTargetGraph->Skins.push_back(std::move(pSkin));
     }
 
-    // Copy geometry data to staging buffer
-    for (size_t rangeIdx = 0; rangeIdx < targetBufferInfo.CopyRanges.size(); ++rangeIdx)
+    // Attach skins to nodes
+    for (size_t gltfNodeIdx = 0; gltfNodeIdx < pGltfData->nodes_count; ++gltfNodeIdx)
     {
-        const auto& copyRange   = targetBufferInfo.CopyRanges[rangeIdx];
-        const auto& pGltfBuffer = copyRange.pGltfBuffer;
-        const char* pSrcData    = static_cast<const char*>(pGltfBuffer->data);
-
-        const char* pSrcAddress = pSrcData + copyRange.GltfOffset;
-        char*       pDstAddress = pDstData + copyRange.TargetOffset;
+        const auto& gltfNode = pGltfData->nodes[gltfNodeIdx];
+        if (IsNull(gltfNode.skin) || (gltfNodeIdx >= pTargetGraph->Nodes.size()))
+        {
+            continue;
+        }
 
-        memcpy(pDstAddress, pSrcAddress, copyRange.Size);
+        const size_t skinIdx                   = skinBase + cgltf_skin_index(pGltfData, gltfNode.skin);
+        pTargetGraph->Nodes[gltfNodeIdx].pSkin = pTargetGraph->Skins[skinIdx].get();
     }
 
-    // Unmap staging buffer
-    pStagingBuffer->Unmap();
+    return true;
+}
 
-    // Create and copy data to buffer for target mesh
-    FauxRender::Buffer* pTargetBuffer = nullptr;
-    //
-    res = pTargetGraph->CreateBuffer(pStagingBuffer, false, &pTargetBuffer);
-    if (!res)
+static bool LoadGLTFAnimations(LoaderInternals* pInternals, const cgltf_data* pGltfData)
+{
+    if (IsNull(pInternals) || IsNull(pGltfData))
     {
         return false;
     }
 
-    // Update target mesh's buffer
-    pTargetMesh->pBuffer = pTargetBuffer;
+    auto pTargetGraph = pInternals->pTargetGraph;
+
+    for (size_t gltfAnimIdx = 0; gltfAnimIdx < pGltfData->animations_count; ++gltfAnimIdx)
+    {
+        const auto& gltfAnimation = pGltfData->animations[gltfAnimIdx];
+
+        auto pAnimation  = std::make_unique<FauxRender::Animation>();
+        pAnimation->Name = !IsNull(gltfAnimation.name) ? gltfAnimation.name : "";
+
+        // Samplers
+        pAnimation->Samplers.resize(gltfAnimation.samplers_count);
+        for (size_t samplerIdx = 0; samplerIdx < gltfAnimation.samplers_count; ++samplerIdx)
+        {
+            const auto& gltfSampler = gltfAnimation.samplers[samplerIdx];
+            auto&       sampler     = pAnimation->Samplers[samplerIdx];
+
+            // clang-format off
+            switch (gltfSampler.interpolation)
+            {
+                default                                    : sampler.Interpolation = ANIMATION_INTERPOLATION_LINEAR; break;
+                case cgltf_interpolation_type_step         : sampler.Interpolation = ANIMATION_INTERPOLATION_STEP; break;
+                case cgltf_interpolation_type_cubic_spline : sampler.Interpolation = ANIMATION_INTERPOLATION_CUBIC_SPLINE; break;
+            }
+            // clang-format on
+
+            if (!IsReadableGLTFAccessor(gltfSampler.input) || !IsReadableGLTFAccessor(gltfSampler.output) || (gltfSampler.input->count == 0))
+            {
+                GREX_LOG_WARN("      Animation " << pAnimation->Name << " sampler " << samplerIdx << " has no readable data, skipping");
+                continue;
+            }
+
+            const uint32_t numKeys = static_cast<uint32_t>(gltfSampler.input->count);
+            sampler.Times.resize(numKeys);
+            for (uint32_t i = 0; i < numKeys; ++i)
+            {
+                ReadGLTFElement(gltfSampler.input, i, &sampler.Times[i], 1);
+            }
+
+            // Weights outputs are scalars with one element per morph target
+            // per key, everything else is one element per key
+            const uint32_t numElements     = static_cast<uint32_t>(gltfSampler.output->count);
+            const uint32_t elementSize     = static_cast<uint32_t>(cgltf_num_components(gltfSampler.output->type));
+            const uint32_t numValuesPerKey = (sampler.Interpolation == ANIMATION_INTERPOLATION_CUBIC_SPLINE) ? 3 : 1;
+            sampler.NumComponents          = (numElements * elementSize) / (numKeys * numValuesPerKey);
+
+            sampler.Values.resize(static_cast<size_t>(numElements) * elementSize);
+            for (uint32_t i = 0; i < numElements; ++i)
+            {
+                ReadGLTFElement(gltfSampler.output, i, &sampler.Values[static_cast<size_t>(i) * elementSize], elementSize);
+            }
+
+            pAnimation->Duration = std::max(pAnimation->Duration, sampler.Times.back());
+        }
+
+        // Channels
+        for (size_t channelIdx = 0; channelIdx < gltfAnimation.channels_count; ++channelIdx)
+        {
+            const auto& gltfChannel = gltfAnimation.channels[channelIdx];
+            if (IsNull(gltfChannel.target_node) || IsNull(gltfChannel.sampler))
+            {
+                continue;
+            }
+
+            FauxRender::AnimationChannel channel = {};
+            channel.Node                         = static_cast<uint32_t>(cgltf_node_index(pGltfData, gltfChannel.target_node));
+            channel.Sampler                      = static_cast<uint32_t>(gltfChannel.sampler - gltfAnimation.samplers);
+
+            // clang-format off
+            switch (gltfChannel.target_path)
+            {
+                default                                    : continue;
+                case cgltf_animation_path_type_translation : channel.Path = ANIMATION_PATH_TRANSLATION; break;
+                case cgltf_animation_path_type_rotation    : channel.Path = ANIMATION_PATH_ROTATION; break;
+                case cgltf_animation_path_type_scale       : channel.Path = ANIMATION_PATH_SCALE; break;
+                case cgltf_animation_path_type_weights     : channel.Path = ANIMATION_PATH_WEIGHTS; break;
+            }
+            // clang-format on
+
+            pAnimation->Channels.push_back(channel);
+        }
+
+        GREX_LOG_INFO("    Loaded animation: " << pAnimation->Name << " (" << pAnimation->Channels.size() << " channels, " << pAnimation->Duration << "s)");
+
+        pTargetGraph->Animations.push_back(std::move(pAnimation));
+    }
 
     return true;
 }
 
-static bool LoadGLTFGeometryData(LoaderInternals* pInternals, const cgltf_data* pGltfData)
+static bool LoadGLTFNode(LoaderInternals* pInternals, const cgltf_data* pGltfData, const cgltf_node* pGltfNode, FauxRender::SceneNode* pTargetNode)
 {
-    if (IsNull(pInternals) || IsNull(pGltfData))
+    if (IsNull(pInternals) || IsNull(pGltfData) || IsNull(pGltfNode) || IsNull(pTargetNode))
     {
         return false;
     }
 
     auto pTargetGraph = pInternals->pTargetGraph;
 
-    // Try to reduce possible fragmentation
+    // Name
+    pTargetNode->Name = !IsNull(pGltfNode->name) ? pGltfNode->name : "";
+    GREX_LOG_INFO("    Loading node: " << pTargetNode->Name);
+
+    // Type
     //
-    // Create a staging buffer that's 128MB. This should handle
-    // the majority of the cases. If not it will get reallocated.
+    // cgltf doesn't seem to have any sort of node type
+    // so we need to filter using the pointers.
     //
-    const uint32_t      kStagingBufferSize = 128 * 1024 * 1024;
-    FauxRender::Buffer* pStagingBuffer     = nullptr;
-    bool                res                = pTargetGraph->CreateTemporaryBuffer(kStagingBufferSize, nullptr, true, &pStagingBuffer);
-    if (!res)
+    if (!IsNull(pGltfNode->mesh))
+    {
+        pTargetNode->Type = SCENE_NODE_TYPE_GEOMETRY;
+    }
+    else if (!IsNull(pGltfNode->camera))
+    {
+        pTargetNode->Type = SCENE_NODE_TYPE_CAMERA;
+    }
+    else if (!IsNull(pGltfNode->light))
+    {
+        pTargetNode->Type = SCENE_NODE_TYPE_LIGHT;
+    }
+    else
+    {
+        pTargetNode->Type = SCENE_NODE_TYPE_LOCATOR;
+    }
+
+    // Parent - if there is one
+    if (!IsNull(pGltfNode->parent))
+    {
+        pTargetNode->Parent = static_cast<uint32_t>(cgltf_node_index(pGltfData, pGltfNode->parent));
+    }
+
+    // Children indices - remember these are local to the scene
+    for (size_t childIterIdx = 0; childIterIdx < pGltfNode->children_count; ++childIterIdx)
+    {
+        const auto pGltfChildNode   = pGltfNode->children[childIterIdx];
+        auto       gltfChildNodeIdx = cgltf_node_index(pGltfData, pGltfChildNode);
+        pTargetNode->Children.push_back(static_cast<uint32_t>(gltfChildNodeIdx));
+    }
+
+    // Tranform
+    {
+        pTargetNode->Translate = glm::vec3(0);
+        if (pGltfNode->has_translation)
+        {
+            float x                = pGltfNode->translation[0];
+            float y                = pGltfNode->translation[1];
+            float z                = pGltfNode->translation[2];
+            pTargetNode->Translate = glm::vec3(x, y, z);
+        }
+
+        pTargetNode->Rotation = glm::quat(0, 0, 0, 1);
+        if (pGltfNode->has_rotation)
+        {
+            float x               = pGltfNode->rotation[0];
+            float y               = pGltfNode->rotation[1];
+            float z               = pGltfNode->rotation[2];
+            float w               = pGltfNode->rotation[3];
+            pTargetNode->Rotation = glm::quat(x, y, z, w);
+        }
+
+        pTargetNode->Scale = glm::vec3(1);
+        if (pGltfNode->has_scale)
+        {
+            float x            = pGltfNode->scale[0];
+            float y            = pGltfNode->scale[1];
+            float z            = pGltfNode->scale[2];
+            pTargetNode->Scale = glm::vec3(x, y, z);
+        }
+    }
+
+    switch (pTargetNode->Type)
+    {
+        default: assert(false && "unrecognized target node type"); break;
+
+        case SCENE_NODE_TYPE_GEOMETRY: {
+            FauxRender::Mesh* pTargetMesh = nullptr;
+            // Look to see if there's a corresponding FauxRender::Mesh for the GLTF mesh
+            auto it = pInternals->MeshMap.find(pGltfNode->mesh);
+            if (it != pInternals->MeshMap.end())
+            {
+                // We found a mesh!
+                pTargetMesh = (*it).second;
+            }
+            else
+            {
+                // Allocate target mesh
+                auto targetMesh = std::make_unique<FauxRender::Mesh>();
+                if (!targetMesh)
+                {
+                    assert(false && "allocation failed: FauxRender::Mesh");
+                    return false;
+                }
+
+                // Get pointer to target mesh
+                pTargetMesh = targetMesh.get();
+
+                // Update map
+                pInternals->MeshMap[pGltfNode->mesh] = pTargetMesh;
+
+                // Add target mesh to graph
+                pTargetGraph->Meshes.push_back(std::move(targetMesh));
+            }
+
+            pTargetNode->pMesh = pTargetMesh;
+
+            // Morph target weights - override the mesh's
+            if (!IsNull(pGltfNode->weights))
+            {
+                pTargetNode->MorphWeights.assign(pGltfNode->weights, pGltfNode->weights + pGltfNode->weights_count);
+            }
+        }
+        break;
+
+        case SCENE_NODE_TYPE_CAMERA: {
+            if (pGltfNode->camera->type == cgltf_camera_type_perspective)
+            {
+                auto& gltfCamera = pGltfNode->camera->data.perspective;
+                // Aspect ratio
+                if (gltfCamera.has_aspect_ratio)
+                {
+                    pTargetNode->Camera.AspectRatio = gltfCamera.aspect_ratio;
+                }
+                // Vertical FOV
+                pTargetNode->Camera.FovY = gltfCamera.yfov;
+                // Near clip
+                pTargetNode->Camera.NearClip = gltfCamera.znear;
+                if (gltfCamera.has_zfar)
+                {
+                    pTargetNode->Camera.FarClip = gltfCamera.zfar;
+                }
+                else
+                {
+                    pTargetNode->Camera.FarClip = gltfCamera.znear + 100.0f;
+                }
+            }
+            else
+            {
+                assert(false && "unsupported camera type");
+                return false;
+            }
+        }
+        break;
+
+        case SCENE_NODE_TYPE_LIGHT: break;
+        case SCENE_NODE_TYPE_LOCATOR: break;
+    }
+
+    return true;
+}
+
+static bool LoadGLTFSceneNodes(LoaderInternals* pInternals, const cgltf_data* pGltfData, const cgltf_node* pGltfNode, FauxRender::Scene* pTargetScene)
+{
+    if (IsNull(pGltfData) || IsNull(pGltfNode) || IsNull(pTargetScene))
     {
-        assert(false && "create staging buffer failed!");
         return false;
     }
 
-    // Create target mesh buffers
-    for (auto iter : pInternals->MeshBufferInfo)
-    {
-        auto        pTargetMesh      = iter.first;
-        const auto& targetBufferInfo = iter.second;
+    auto pTargetGraph = pInternals->pTargetGraph;
 
-        // Reallocate staging buffer if buffer size is too large.
-        //
-        // This is hacky and can potentially exhaust GPU memory.
-        //
-        // TODO: Change to handle copies use chunks of kStagingBufferSize if
-        //       target buffer exceeds kStagingBufferSize.
-        //
-        if (targetBufferInfo.BufferSize > pStagingBuffer->Size)
+    // Process children first
+    if (pGltfNode->children_count > 0)
+    {
+        for (size_t childIterIdx = 0; childIterIdx < pGltfNode->children_count; ++childIterIdx)
         {
-            // Destroy current staging buffer
-            pTargetGraph->DestroyTemporaryBuffer(&pStagingBuffer);
+            auto pGltfChildNode = pGltfNode->children[childIterIdx];
 
-            // Allocate new staging buffer
-            bool res = pTargetGraph->CreateTemporaryBuffer(targetBufferInfo.BufferSize, nullptr, true, &pStagingBuffer);
+            bool res = LoadGLTFSceneNodes(pInternals, pGltfData, pGltfChildNode, pTargetScene);
             if (!res)
             {
-                assert(false && "create staging buffer failed!");
                 return false;
             }
         }
+    }
+
+    // Add node to scene
+    {
+        // Node index
+        const size_t nodeIndex = cgltf_node_index(pGltfData, pGltfNode);
+
+        // Target node
+        auto pTargetNode = &pTargetGraph->Nodes[nodeIndex];
+
+        // Store faux node pointer to scene
+        pTargetScene->Nodes.push_back(pTargetNode);
+
+        // Store geometry node to scene to reduce searching later
+        if (pTargetNode->Type == FauxRender::SCENE_NODE_TYPE_GEOMETRY)
+        {
+            if (pInternals->Progressive)
+            {
+                // Added once the mesh's geometry is loaded
+                pInternals->DeferredInstances[pTargetNode->pMesh].push_back({pTargetScene, pTargetNode});
+            }
+            else
+            {
+                pTargetScene->AddGeometryNode(pTargetNode);
+            }
+        }
 
-        // Load mesh's geometry data
-        bool res = LoadGLTFMeshGeometryData(pInternals, pStagingBuffer, pGltfData, targetBufferInfo, pTargetMesh);
-        if (!res)
+        // Active camera
+        if (IsNull(pTargetScene->pActiveCamera) && (pTargetNode->Type == SCENE_NODE_TYPE_CAMERA))
         {
-            return false;
+            pTargetScene->pActiveCamera = pTargetNode;
         }
     }
 
-    // Destroy staging buffer
-    pTargetGraph->DestroyTemporaryBuffer(&pStagingBuffer);
-
     return true;
 }
 
-static bool LoadGLTFImageKTX(
-    LoaderInternals*    pInternals,
-    const cgltf_data*   pGltfData,
-    const cgltf_image*  pGltfImage,
-    FauxRender::Image** ppTargetImage)
+static bool LoadGLTFScene(LoaderInternals* pInternals, const cgltf_data* pGltfData, const cgltf_scene& gltfScene, FauxRender::Scene* pTargetScene)
 {
-    if (IsNull(pInternals) || IsNull(pGltfData) || IsNull(pGltfImage) || IsNull(ppTargetImage))
+    if (IsNull(pInternals) || IsNull(pGltfData) || IsNull(pTargetScene))
     {
         return false;
     }
 
     auto pTargetGraph = pInternals->pTargetGraph;
 
-    // Scope utility class since there's a bunch of returns
-    struct KTXScopedTexture
+    // Name
+    pTargetScene->Name = !IsNull(gltfScene.name) ? gltfScene.name : "";
+    GREX_LOG_INFO("  Loading scene: " << pTargetScene->Name);
+    GREX_LOG_INFO("    Num nodes: " << gltfScene.nodes_count);
+
+    // Instance index lookup, filled in as geometry nodes are added
+    pTargetScene->GeometryNodeIndices.assign(pTargetGraph->Nodes.size(), UINT32_MAX);
+
+    // Nodes
+    for (size_t nodeIterIdx = 0; nodeIterIdx < gltfScene.nodes_count; ++nodeIterIdx)
     {
-        ktxTexture2* pTexture = nullptr;
+        const auto pGltfNode = gltfScene.nodes[nodeIterIdx];
 
-        ~KTXScopedTexture()
+        bool res = LoadGLTFSceneNodes(pInternals, pGltfData, pGltfNode, pTargetScene);
+        if (!res)
         {
-            if (pTexture != nullptr)
-            {
-                ktxTexture_Destroy(reinterpret_cast<ktxTexture*>(pTexture));
-                pTexture = nullptr;
-            }
+            return false;
         }
-    };
+    }
 
-    // KTX texture object
-    KTXScopedTexture scopedTexture = {};
+    return true;
+}
 
-    // Create texture from buffer view
-    if (!IsNull(pGltfImage->buffer_view))
+static bool LoadGLTFNodes(LoaderInternals* pInternals, const cgltf_data* pGltfData)
+{
+    auto pTargetGraph = pInternals->pTargetGraph;
+
+    for (size_t nodeIdx = 0; nodeIdx < pGltfData->nodes_count; ++nodeIdx)
     {
-        auto* pGltfBufferView = pGltfImage->buffer_view;
-        auto* pGltfBuffer     = pGltfBufferView->buffer;
+        const auto& gltfNode = pGltfData->nodes[nodeIdx];
 
-        const ktx_size_t   srcDataSize = static_cast<ktx_size_t>(pGltfBufferView->size);
-        const ktx_uint8_t* pSrcData    = static_cast<const ktx_uint8_t*>(pGltfBuffer->data) + pGltfBufferView->offset;
+        // Add target node to graph
+        auto pTargetNode = pTargetGraph->AddNode();
 
-        auto ktxRes = ktxTexture_CreateFromMemory(
-            pSrcData,
-            srcDataSize,
-            0, // createFlags
-            reinterpret_cast<ktxTexture**>(&scopedTexture.pTexture));
-        if (ktxRes != KTX_SUCCESS)
+        // Load GLTF node
+        bool res = LoadGLTFNode(pInternals, pGltfData, &gltfNode, pTargetNode);
+        if (!res)
         {
-            assert(false && "KTX2 image load from memory failed");
             return false;
         }
     }
-    // Create texture from file
-    else if (!IsNull(pGltfImage->uri))
+
+    return true;
+}
+
+static bool LoadGLTFMeshes(LoaderInternals* pInternals, const FauxRender::LoadOptions& loadOptions, const cgltf_data* pGltfData)
+{
+    GREX_LOG_INFO("  Loading " << pInternals->MeshMap.size() << " unique meshes");
+
+    for (auto iter : pInternals->MeshMap)
     {
-        const auto parentPath = pInternals->gltfPath.parent_path();
-        const auto uriPath    = parentPath / pGltfImage->uri;
+        auto pGltfMesh   = iter.first;
+        auto pTargetMesh = iter.second;
 
-        auto ktxRes = ktxTexture_CreateFromNamedFile(
-            uriPath.string().c_str(),
-            KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT,
-            reinterpret_cast<ktxTexture**>(&scopedTexture.pTexture));
-        if (ktxRes != KTX_SUCCESS)
+        bool res = LoadGLTFMesh(pInternals, loadOptions, pGltfData, pGltfMesh, pTargetMesh);
+        if (!res)
         {
-            assert(false && "KTX2 image load from file failed");
             return false;
         }
     }
-    else
-    {
-        assert(false && "invalid KTX2 image data source");
-        return false;
-    }
 
-    // Target BC7 if transcode is needed
-    GREXFormat targetFormat = GREX_FORMAT_BC7_RGBA;
-    if (ktxTexture2_NeedsTranscoding(scopedTexture.pTexture))
+    return true;
+}
+
+static bool LoadGLTFMaterials(LoaderInternals* pInternals, const cgltf_data* pGltfData)
+{
+    GREX_LOG_INFO("  Loading " << pInternals->MaterialMap.size() << " unique materials");
+
+    for (auto iter : pInternals->MaterialMap)
     {
-        auto ktxRes = ktxTexture2_TranscodeBasis(scopedTexture.pTexture, KTX_TTF_BC7_RGBA, 0);
-        if (ktxRes != KTX_SUCCESS)
+        auto pGltfMaterial   = iter.first;
+        auto pTargetMaterial = iter.second;
+
+        bool res = LoadGLTFMaterial(pInternals, pGltfData, pGltfMaterial, pTargetMaterial);
+        if (!res)
         {
-            assert(false && "KTX2 image transcode failed");
             return false;
         }
     }
-    // Otherwise look up format using the vkFormat field in the texture
-    else
+
+    return true;
+}
+
+static bool LoadGLTFScenes(LoaderInternals* pInternals, const cgltf_data* pGltfData)
+{
+    auto pTargetGraph = pInternals->pTargetGraph;
+
+    for (size_t sceneIterIdx = 0; sceneIterIdx < pGltfData->scenes_count; ++sceneIterIdx)
     {
-        FauxRenderVkFormat ktxVkFormat = static_cast<FauxRenderVkFormat>(scopedTexture.pTexture->vkFormat);
-        switch (ktxVkFormat)
-        {
-            default: {
-                assert(false && "KTX2 format not supported");
-                return false;
-            }
-            break;
+        const auto& gltfScene = pGltfData->scenes[sceneIterIdx];
 
-            case FAUX_RENDER_VK_FORMAT_BC6H_SFLOAT_BLOCK: targetFormat = GREX_FORMAT_BC6H_SFLOAT; break;
-            case FAUX_RENDER_VK_FORMAT_BC6H_UFLOAT_BLOCK: targetFormat = GREX_FORMAT_BC6H_UFLOAT; break;
+        // Allocate target scene
+        auto targetScene = std::make_unique<FauxRender::Scene>();
+        if (!targetScene)
+        {
+            return false;
         }
-    }
 
-    // Get pointer to image data for each level
-    std::vector<MipOffset> mipOffsets;
-    for (ktx_uint32_t mipLevel = 0; mipLevel < scopedTexture.pTexture->numLevels; ++mipLevel)
-    {
-        ktx_size_t imageOffset = 0;
-        //
-        auto ktxRes = ktxTexture_GetImageOffset(
-            reinterpret_cast<ktxTexture*>(scopedTexture.pTexture),
-            mipLevel,
-            0, // layer
-            0, // faceSlice,
-            &imageOffset);
-        if (ktxRes != KTX_SUCCESS)
+        // Load GLTF scene
+        bool res = LoadGLTFScene(pInternals, pGltfData, gltfScene, targetScene.get());
+        if (!res)
         {
-            assert(false && "KTX2 image get offset failed");
             return false;
         }
 
-        MipOffset mipOffset = {};
-        mipOffset.Offset    = static_cast<uint32_t>(imageOffset);
-        mipOffset.RowStride = static_cast<uint32_t>(scopedTexture.pTexture->baseWidth >> mipLevel);
-        //
-        mipOffsets.push_back(mipOffset);
+        // Add scene to graph
+        pTargetGraph->Scenes.push_back(std::move(targetScene));
     }
 
-    ktx_size_t imageDataSize = ktxTexture_GetDataSize(reinterpret_cast<ktxTexture*>(scopedTexture.pTexture));
-    if (imageDataSize == 0)
+    return true;
+}
+
+bool LoadGLTF(const std::filesystem::path& path, const FauxRender::LoadOptions& loadOptions, FauxRender::SceneGraph* pTargetGraph)
+{
+    GREX_PROFILE_FUNCTION();
+
+    if (!std::filesystem::exists(path) || IsNull(pTargetGraph))
     {
-        assert(false && "KTX2 image image data size is 0");
         return false;
     }
 
-    ktx_uint8_t* pKtxImageData = ktxTexture_GetData(reinterpret_cast<ktxTexture*>(scopedTexture.pTexture));
-    if (IsNull(pKtxImageData))
+    GREX_LOG_INFO("Loading GLTF: " << path);
+
+    cgltf_options gltfOptions = {};
+    cgltf_data*   pGltfData   = nullptr;
+
+    // Parse
+    cgltf_result cgres = cgltf_result_success;
     {
-        assert(false && "KTX2 image image data is null");
-        return false;
+        GREX_PROFILE_SCOPE("cgltf_parse_file");
+        cgres = cgltf_parse_file(
+            &gltfOptions,
+            path.string().c_str(),
+            &pGltfData);
     }
-
-    // Create the target image
-    FauxRender::Image* pTargetImage = nullptr;
-    //
-    bool res = pTargetGraph->CreateImage(
-        static_cast<uint32_t>(scopedTexture.pTexture->baseWidth),
-        static_cast<uint32_t>(scopedTexture.pTexture->baseHeight),
-        targetFormat,
-        mipOffsets,
-        imageDataSize,
-        pKtxImageData,
-        &pTargetImage);
-    if (!res)
+    if (cgres != cgltf_result_success)
     {
         return false;
     }
 
-    // Assign output
-    *ppTargetImage = pTargetImage;
-
-    return true;
-}
+    // Internal loader scratch data
+    LoaderInternals internals  = {};
+    internals.gltfPath         = path;
+    internals.pTargetGraph     = pTargetGraph;
+    internals.pTextureStreamer = loadOptions.pTextureStreamer;
+    internals.OptimizeMeshes   = loadOptions.OptimizeMeshes;
 
-static bool LoadGLTFImageBitmap(
-    LoaderInternals*    pInternals,
-    const cgltf_data*   pGltfData,
-    const cgltf_image*  pGltfImage,
-    FauxRender::Image** ppTargetImage)
-{
-    if (IsNull(pInternals) || IsNull(pGltfData) || IsNull(pGltfImage) || IsNull(ppTargetImage))
+    // Load nodes
     {
-        return false;
+        GREX_PROFILE_SCOPE("LoadGLTFNodes");
+        if (!LoadGLTFNodes(&internals, pGltfData))
+        {
+            return false;
+        }
     }
 
-    auto pTargetGraph = pInternals->pTargetGraph;
+    // -------------------------------------------------------------------------
+    // Load meshes
+    // -------------------------------------------------------------------------
+    {
+        GREX_PROFILE_SCOPE("LoadGLTFMeshes");
+        if (!LoadGLTFMeshes(&internals, loadOptions, pGltfData))
+        {
+            return false;
+        }
+    }
 
-    BitmapRGBA8u bitmap = {};
-    //
-    if (!IsNull(pGltfImage->buffer_view))
+    // -------------------------------------------------------------------------
+    // Load geometry data from buffers
+    // -------------------------------------------------------------------------
     {
-        auto* pGltfBufferView = pGltfImage->buffer_view;
-        auto* pGltfBuffer     = pGltfBufferView->buffer;
+        // Load GLTF buffers from file.
+        // These buffers will be destroyed when cgltf_free() is called.
+        //
+        {
+            GREX_PROFILE_SCOPE("cgltf_load_buffers");
+            cgres = cgltf_load_buffers(
+                &gltfOptions,
+                pGltfData,
+                internals.gltfPath.string().c_str());
+        }
+        if (cgres != cgltf_result_success)
+        {
+            cgltf_free(pGltfData);
+            return false;
+        }
 
-        auto        srcDataSize = pGltfBufferView->size;
-        const char* pSrcData    = static_cast<const char*>(pGltfBuffer->data) + pGltfBufferView->offset;
+        if (!DecodeGLTFMeshoptBuffers(pGltfData))
+        {
+            cgltf_free(pGltfData);
+            return false;
+        }
 
-        bool res = BitmapRGBA8u::Load(srcDataSize, pSrcData, &bitmap);
+        std::vector<BufferInfo*> bufferInfos;
+        for (auto& iter : internals.MeshBufferInfo)
+        {
+            bufferInfos.push_back(&iter.second);
+        }
+        GenerateGLTFTangents(bufferInfos, loadOptions.NumTangentThreads);
+
+        GREX_PROFILE_SCOPE("LoadGLTFGeometryData");
+        bool res = LoadGLTFGeometryData(&internals, pGltfData);
         if (!res)
         {
-            assert(false && "image load from memory failed");
             return false;
         }
     }
-    else if (!IsNull(pGltfImage->uri))
+
+    // -------------------------------------------------------------------------
+    // Load skins and animations
+    // -------------------------------------------------------------------------
     {
-        const auto parentPath = pInternals->gltfPath.parent_path();
-        const auto uriPath    = parentPath / pGltfImage->uri;
+        GREX_PROFILE_SCOPE("LoadGLTFSkinsAndAnimations");
+        if (!LoadGLTFSkins(&internals, pGltfData) || !LoadGLTFAnimations(&internals, pGltfData))
+        {
+            return false;
+        }
 
-        bool res = BitmapRGBA8u::Load(uriPath, &bitmap);
-        if (!res)
+        if (!pTargetGraph->CreateDeformedBuffers())
         {
-            assert(false && "image load from file failed");
             return false;
         }
     }
-    else
+
+    // -------------------------------------------------------------------------
+    // Load materials and associated textures
+    // -------------------------------------------------------------------------
     {
-        assert(false && "invalid image data source");
-        return false;
+        GREX_PROFILE_SCOPE("LoadGLTFMaterials");
+        if (!LoadGLTFMaterials(&internals, pGltfData))
+        {
+            return false;
+        }
     }
 
-    // @TODO: Add mip map generation
-
-    // Create the target image
-    FauxRender::Image* pTargetImage = nullptr;
-    //
-    bool res = pTargetGraph->CreateImage(&bitmap, &pTargetImage);
-    if (!res)
+    // -------------------------------------------------------------------------
+    // Load scenes
+    // -------------------------------------------------------------------------
     {
-        assert(false && "create image failed");
-        return false;
+        GREX_PROFILE_SCOPE("LoadGLTFScenes");
+        if (!LoadGLTFScenes(&internals, pGltfData))
+        {
+            return false;
+        }
     }
 
-    // Assign output
-    *ppTargetImage = pTargetImage;
+    // Free GLTF data
+    cgltf_free(pGltfData);
+
+    GREX_LOG_INFO("  Successfully loaded GLTF: " << path);
 
     return true;
 }
 
-static bool LoadGLTFImage(
-    LoaderInternals*    pInternals,
-    const cgltf_data*   pGltfData,
-    const cgltf_image*  pGltfImage,
-    FauxRender::Image** ppTargetImage)
+// =============================================================================
+// LoadScene
+// =============================================================================
+template <typename T>
+static const T* GetSceneFileTable(const std::vector<char>& fileData, SceneFile::FileTableType type, uint32_t* pCount)
 {
-    if (IsNull(pInternals) || IsNull(pGltfData) || IsNull(pGltfImage) || IsNull(ppTargetImage))
-    {
-        return false;
-    }
-
-    auto pTargetGraph = pInternals->pTargetGraph;
+    auto pHeader = reinterpret_cast<const SceneFile::FileHeader*>(fileData.data());
+    auto table   = pHeader->Tables[type];
 
-    // Look up image
-    auto it = pInternals->ImageMap.find(pGltfImage);
-    if (it != pInternals->ImageMap.end())
+    *pCount = table.Count;
+    if (table.Count == 0)
     {
-        // Image found, assign target image, and return
-        *ppTargetImage = (*it).second;
-        return true;
+        return nullptr;
     }
+    return reinterpret_cast<const T*>(fileData.data() + table.Offset);
+}
 
-    // No image found - so create one
-    std::string name = !IsNull(pGltfImage->name) ? pGltfImage->name : "";
-    GREX_LOG_INFO("    Loading image: " << name);
-
-    // Get mime type
-    std::string gltfMimeType = !IsNull(pGltfImage->mime_type) ? pGltfImage->mime_type : "";
-
-    // Target image
-    FauxRender::Image* pTargetImage = nullptr;
+// Written so that offset + size can't wrap around
+static bool IsRangeInside(uint64_t offset, uint64_t size, uint64_t limit)
+{
+    return (offset <= limit) && (size <= (limit - offset));
+}
 
-    // KTX image data
-    if (gltfMimeType == "image/ktx2")
+static bool ValidateSceneFileImage(const SceneFile::FileImage& fileImage, const SceneFile::FileMipLevel* pMipLevels, uint32_t numMipLevels, uint64_t fileSize)
+{
+    if (!IsRangeInside(fileImage.DataOffset, fileImage.DataSize, fileSize) || !IsRangeInside(fileImage.FirstLevel, fileImage.NumLevels, numMipLevels))
     {
-        bool res = LoadGLTFImageKTX(pInternals, pGltfData, pGltfImage, &pTargetImage);
-        if (!res)
-        {
-            return false;
-        }
+        return false;
     }
-    // PNG, JPG, etc image data
-    else
+
+    // Compressed formats store rows of 4x4 blocks
+    const bool compressed = IsBlockCompressed(static_cast<GREXFormat>(fileImage.Format));
+    for (uint32_t level = 0; level < fileImage.NumLevels; ++level)
     {
-        bool res = LoadGLTFImageBitmap(pInternals, pGltfData, pGltfImage, &pTargetImage);
-        if (!res)
+        const auto&    fileMipLevel = pMipLevels[fileImage.FirstLevel + level];
+        const uint32_t levelHeight  = std::max<uint32_t>((level < 32) ? (fileImage.Height >> level) : 0, 1);
+        const uint32_t numRows      = compressed ? ((levelHeight + 3) / 4) : levelHeight;
+        if (!IsRangeInside(fileMipLevel.Offset, uint64_t(fileMipLevel.RowStride) * numRows, fileImage.DataSize))
         {
             return false;
         }
     }
 
-    assert((pTargetImage != nullptr) && "pTargetImage is NULL");
+    return true;
+}
 
-    // Update image name
-    pTargetImage->Name = name;
+static bool ValidateSceneFileMesh(const SceneFile::FileMesh& fileMesh, const SceneFile::FileBatch* pBatches, uint32_t numBatches, uint64_t fileSize)
+{
+    // Mesh buffers are created with a 32-bit size
+    if (!IsRangeInside(fileMesh.DataOffset, fileMesh.DataSize, fileSize) || (fileMesh.DataSize > UINT32_MAX) || !IsRangeInside(fileMesh.FirstBatch, fileMesh.NumBatches, numBatches))
+    {
+        return false;
+    }
 
-    // Update map
-    pInternals->ImageMap[pGltfImage] = pTargetImage;
+    for (uint32_t batchIdx = 0; batchIdx < fileMesh.NumBatches; ++batchIdx)
+    {
+        const auto& fileBatch = pBatches[fileMesh.FirstBatch + batchIdx];
+
+        const SceneFile::FileBufferView* views[] = {
+            &fileBatch.IndexBufferView,
+            &fileBatch.PositionBufferView,
+            &fileBatch.VertexColorBufferView,
+            &fileBatch.TexCoordBufferView,
+            &fileBatch.NormalBufferView,
+            &fileBatch.TangentBufferView,
+        };
 
-    // Assign target image
-    *ppTargetImage = pTargetImage;
+        for (auto pView : views)
+        {
+            if (!IsRangeInside(pView->Offset, pView->Size, fileMesh.DataSize))
+            {
+                return false;
+            }
+        }
+    }
 
     return true;
 }
 
-static bool LoadGLTFSampler(
-    LoaderInternals*      pInternals,
-    const cgltf_data*     pGltfData,
-    const cgltf_sampler*  pGltfSampler,
-    FauxRender::Sampler** ppTargetSampler)
+static bool ValidateSceneFile(const std::vector<char>& fileData)
 {
-    if (IsNull(pInternals) || IsNull(pGltfData) || IsNull(pGltfSampler) || IsNull(ppTargetSampler))
+    if (fileData.size() < sizeof(SceneFile::FileHeader))
     {
         return false;
     }
 
-    auto pTargetGraph = pInternals->pTargetGraph;
-
-    // Look up sampler
-    auto it = pInternals->SamplerMap.find(pGltfSampler);
-    if (it != pInternals->SamplerMap.end())
+    auto pHeader = reinterpret_cast<const SceneFile::FileHeader*>(fileData.data());
+    if ((memcmp(pHeader->Magic, SceneFile::FILE_MAGIC, sizeof(SceneFile::FILE_MAGIC)) != 0) ||
+        (pHeader->Version != SceneFile::FILE_VERSION) ||
+        (pHeader->HeaderSize != sizeof(SceneFile::FileHeader)) ||
+        (pHeader->FileSize != fileData.size()))
     {
-        // Sampler found, assign target sampler, and return
-        *ppTargetSampler = (*it).second;
-        return true;
+        return false;
     }
 
-    // No sampler found - so create one
-    auto targetSampler = std::make_unique<FauxRender::Sampler>();
-    if (!targetSampler)
+    // clang-format off
+    const uint32_t strides[SceneFile::FILE_TABLE_COUNT] = {
+        sizeof(char),                    // FILE_TABLE_STRINGS
+        sizeof(SceneFile::FileNode),     // FILE_TABLE_NODES
+        sizeof(uint32_t),                // FILE_TABLE_NODE_CHILDREN
+        sizeof(SceneFile::FileScene),    // FILE_TABLE_SCENES
+        sizeof(uint32_t),                // FILE_TABLE_SCENE_NODES
+        sizeof(SceneFile::FileMesh),     // FILE_TABLE_MESHES
+        sizeof(SceneFile::FileBatch),    // FILE_TABLE_BATCHES
+        sizeof(SceneFile::FileMaterial), // FILE_TABLE_MATERIALS
+        sizeof(SceneFile::FileTexture),  // FILE_TABLE_TEXTURES
+        sizeof(SceneFile::FileImage),    // FILE_TABLE_IMAGES
+        sizeof(SceneFile::FileMipLevel), // FILE_TABLE_MIP_LEVELS
+        sizeof(SceneFile::FileSampler),  // FILE_TABLE_SAMPLERS
+    };
+    // clang-format on
+
+    for (uint32_t i = 0; i < SceneFile::FILE_TABLE_COUNT; ++i)
     {
-        assert(false && "allocation failed: FauxRender::Sampler");
-        return false;
+        const auto& table = pHeader->Tables[i];
+        if ((table.Count > 0) && ((table.Stride != strides[i]) || !IsRangeInside(table.Offset, uint64_t(table.Count) * table.Stride, fileData.size())))
+        {
+            return false;
+        }
     }
 
-    // Get pointer to target mesh
-    auto pTargetSampler = targetSampler.get();
-
-    // Update map
-    pInternals->SamplerMap[pGltfSampler] = pTargetSampler;
+    //
+    // Images and meshes point into the blob data, check every mip level and
+    // buffer view up front so that a bad file fails before any resources are
+    // created.
+    //
+    uint32_t numMeshes    = 0;
+    uint32_t numBatches   = 0;
+    uint32_t numImages    = 0;
+    uint32_t numMipLevels = 0;
 
-    // Add target sampler to graph
-    pTargetGraph->Samplers.push_back(std::move(targetSampler));
+    auto pMeshes    = GetSceneFileTable<SceneFile::FileMesh>(fileData, SceneFile::FILE_TABLE_MESHES, &numMeshes);
+    auto pBatches   = GetSceneFileTable<SceneFile::FileBatch>(fileData, SceneFile::FILE_TABLE_BATCHES, &numBatches);
+    auto pImages    = GetSceneFileTable<SceneFile::FileImage>(fileData, SceneFile::FILE_TABLE_IMAGES, &numImages);
+    auto pMipLevels = GetSceneFileTable<SceneFile::FileMipLevel>(fileData, SceneFile::FILE_TABLE_MIP_LEVELS, &numMipLevels);
 
-    // @TODO: Set sampler values
+    for (uint32_t i = 0; i < numImages; ++i)
     {
-        pTargetSampler->Name = !IsNull(pGltfSampler->name) ? pGltfSampler->name : "";
-        GREX_LOG_INFO("    Loading sampler: " << pTargetSampler->Name);
+        if (!ValidateSceneFileImage(pImages[i], pMipLevels, numMipLevels, fileData.size()))
+        {
+            return false;
+        }
     }
 
-    // Assign target sampler
-    *ppTargetSampler = pTargetSampler;
+    for (uint32_t i = 0; i < numMeshes; ++i)
+    {
+        if (!ValidateSceneFileMesh(pMeshes[i], pBatches, numBatches, fileData.size()))
+        {
+            return false;
+        }
+    }
 
     return true;
 }
 
-static bool LoadGLTFTexture(
-    LoaderInternals*          pInternals,
-    const cgltf_data*         pGltfData,
-    const cgltf_texture_view* pGltfTextureView,
-    FauxRender::Texture**     ppTargetTexture)
+bool LoadScene(const std::filesystem::path& path, FauxRender::SceneGraph* pTargetGraph)
 {
-    if (IsNull(pInternals) || IsNull(pGltfData) || IsNull(pGltfTextureView) || IsNull(ppTargetTexture))
+    GREX_PROFILE_FUNCTION();
+
+    if (!std::filesystem::exists(path) || IsNull(pTargetGraph))
     {
         return false;
     }
 
-    auto pTargetGraph = pInternals->pTargetGraph;
+    GREX_LOG_INFO("Loading scene: " << path);
 
-    // GLTF texture
-    auto pGltfTexture = pGltfTextureView->texture;
+    auto startTime = std::chrono::high_resolution_clock::now();
 
-    // Look up texture
-    auto it = pInternals->TextureMap.find(pGltfTexture);
-    if (it != pInternals->TextureMap.end())
+    // Read the whole file - everything below points into it
+    std::vector<char> fileData;
     {
-        // Texture found, assign target texture, and return
-        *ppTargetTexture = (*it).second;
-        return true;
+        std::ifstream is(path, std::ios::binary);
+        if (!is.is_open())
+        {
+            return false;
+        }
+
+        fileData.resize(static_cast<size_t>(std::filesystem::file_size(path)));
+        is.read(fileData.data(), fileData.size());
+        if (!is)
+        {
+            return false;
+        }
     }
 
-    // No texture found - so create one
-    auto targetTexture = std::make_unique<FauxRender::Texture>();
-    if (!targetTexture)
+    if (!ValidateSceneFile(fileData))
     {
-        assert(false && "allocation failed: FauxRender::Texture");
+        GREX_LOG_ERROR("invalid scene file: " << path);
         return false;
     }
 
-    // Get pointer to target mesh
-    auto pTargetTexture = targetTexture.get();
-
-    // Update map
-    pInternals->TextureMap[pGltfTexture] = pTargetTexture;
+    const char* pFileData = fileData.data();
+
+    uint32_t numStrings      = 0;
+    uint32_t numNodes        = 0;
+    uint32_t numNodeChildren = 0;
+    uint32_t numScenes       = 0;
+    uint32_t numSceneNodes   = 0;
+    uint32_t numMeshes       = 0;
+    uint32_t numBatches      = 0;
+    uint32_t numMaterials    = 0;
+    uint32_t numTextures     = 0;
+    uint32_t numImages       = 0;
+    uint32_t numMipLevels    = 0;
+    uint32_t numSamplers     = 0;
+
+    auto pStrings      = GetSceneFileTable<char>(fileData, SceneFile::FILE_TABLE_STRINGS, &numStrings);
+    auto pNodes        = GetSceneFileTable<SceneFile::FileNode>(fileData, SceneFile::FILE_TABLE_NODES, &numNodes);
+    auto pNodeChildren = GetSceneFileTable<uint32_t>(fileData, SceneFile::FILE_TABLE_NODE_CHILDREN, &numNodeChildren);
+    auto pScenes       = GetSceneFileTable<SceneFile::FileScene>(fileData, SceneFile::FILE_TABLE_SCENES, &numScenes);
+    auto pSceneNodes   = GetSceneFileTable<uint32_t>(fileData, SceneFile::FILE_TABLE_SCENE_NODES, &numSceneNodes);
+    auto pMeshes       = GetSceneFileTable<SceneFile::FileMesh>(fileData, SceneFile::FILE_TABLE_MESHES, &numMeshes);
+    auto pBatches      = GetSceneFileTable<SceneFile::FileBatch>(fileData, SceneFile::FILE_TABLE_BATCHES, &numBatches);
+    auto pMaterials    = GetSceneFileTable<SceneFile::FileMaterial>(fileData, SceneFile::FILE_TABLE_MATERIALS, &numMaterials);
+    auto pTextures     = GetSceneFileTable<SceneFile::FileTexture>(fileData, SceneFile::FILE_TABLE_TEXTURES, &numTextures);
+    auto pImages       = GetSceneFileTable<SceneFile::FileImage>(fileData, SceneFile::FILE_TABLE_IMAGES, &numImages);
+    auto pMipLevels    = GetSceneFileTable<SceneFile::FileMipLevel>(fileData, SceneFile::FILE_TABLE_MIP_LEVELS, &numMipLevels);
+    auto pSamplers     = GetSceneFileTable<SceneFile::FileSampler>(fileData, SceneFile::FILE_TABLE_SAMPLERS, &numSamplers);
+
+    auto GetString = [pStrings, numStrings](const SceneFile::FileString& str) -> std::string {
+        if ((str.Length == 0) || ((uint64_t(str.Offset) + str.Length) > numStrings))
+        {
+            return "";
+        }
+        return std::string(pStrings + str.Offset, str.Length);
+    };
 
-    // Add target sampler to graph
-    pTargetGraph->Textures.push_back(std::move(targetTexture));
+    auto ToAABB = [](const float min[3], const float max[3]) -> FauxRender::AABB {
+        FauxRender::AABB bounds = {};
+        bounds.Min              = vec3(min[0], min[1], min[2]);
+        bounds.Max              = vec3(max[0], max[1], max[2]);
+        return bounds;
+    };
 
-    // @TODO: Set texture values
-    {
-        pTargetTexture->Name = !IsNull(pGltfTexture->name) ? pGltfTexture->name : "";
-        GREX_LOG_INFO("    Loading texture: " << pTargetTexture->Name);
-    }
+    auto ToBufferView = [](const SceneFile::FileBufferView& view) -> FauxRender::BufferView {
+        FauxRender::BufferView bufferView = {};
+        bufferView.Offset                 = view.Offset;
+        bufferView.Size                   = view.Size;
+        bufferView.Stride                 = view.Stride;
+        bufferView.Format                 = static_cast<GREXFormat>(view.Format);
+        bufferView.Count                  = view.Count;
+        return bufferView;
+    };
 
-    // Load image
+    // Samplers
+    std::vector<FauxRender::Sampler*> samplers(numSamplers, nullptr);
+    for (uint32_t i = 0; i < numSamplers; ++i)
     {
-        auto pGltfImage = pGltfTexture->has_basisu ? pGltfTexture->basisu_image : pGltfTexture->image;
-        if (IsNull(pGltfImage))
-        {
-            assert("GLTF image data missing!");
-            return false;
-        }
-
-        bool res = LoadGLTFImage(pInternals, pGltfData, pGltfImage, &pTargetTexture->pImage);
+        const auto& fileSampler = pSamplers[i];
+
+        bool res = pTargetGraph->CreateSampler(
+            static_cast<FauxRender::FilterMode>(fileSampler.MinFilter),
+            static_cast<FauxRender::FilterMode>(fileSampler.MagFilter),
+            static_cast<FauxRender::FilterMode>(fileSampler.MipFilter),
+            static_cast<FauxRender::TextureAddressMode>(fileSampler.AddressU),
+            static_cast<FauxRender::TextureAddressMode>(fileSampler.AddressV),
+            static_cast<FauxRender::TextureAddressMode>(fileSampler.AddressW),
+            &samplers[i]);
         if (!res)
         {
+            assert(false && "failed to create sampler");
             return false;
         }
+        samplers[i]->Name = GetString(fileSampler.Name);
     }
 
-    // Load sampler
-    if (!IsNull(pGltfTexture->sampler))
+    // Images - mip chains are uploaded straight from the file data, the
+    // ranges were checked by ValidateSceneFile()
+    std::vector<FauxRender::Image*> images(numImages, nullptr);
+    for (uint32_t i = 0; i < numImages; ++i)
     {
-        bool res = LoadGLTFSampler(pInternals, pGltfData, pGltfTexture->sampler, &pTargetTexture->pSampler);
-        if (!res)
+        const auto& fileImage = pImages[i];
+
+        std::vector<MipOffset> mipOffsets;
+        for (uint32_t level = 0; level < fileImage.NumLevels; ++level)
         {
-            return false;
+            const auto& fileMipLevel = pMipLevels[fileImage.FirstLevel + level];
+            mipOffsets.push_back(MipOffset{fileMipLevel.Offset, fileMipLevel.RowStride});
         }
-    }
-
-    // Assign target texture
-    *ppTargetTexture = pTargetTexture;
-
-    return true;
-}
-
-static void CopyGLTFTexCoordTransform(
-    const cgltf_texture_view* pGltfTextureView,
-    bool&                     hasTexCoordTransform,
-    FauxRender::Material*     pTargetMaterial)
-{
-    if (!hasTexCoordTransform && pGltfTextureView->has_transform)
-    {
-        pTargetMaterial->TexCoordTranslate = {pGltfTextureView->transform.offset[0], pGltfTextureView->transform.offset[1]};
-        pTargetMaterial->TexCoordRotate    = pGltfTextureView->transform.rotation;
-        pTargetMaterial->TexCoordScale     = {pGltfTextureView->transform.scale[0], pGltfTextureView->transform.scale[1]};
 
-        hasTexCoordTransform = true;
+        bool res = pTargetGraph->CreateImage(
+            fileImage.Width,
+            fileImage.Height,
+            static_cast<GREXFormat>(fileImage.Format),
+            mipOffsets,
+            static_cast<size_t>(fileImage.DataSize),
+            pFileData + fileImage.DataOffset,
+            &images[i]);
+        if (!res)
+        {
+            assert(false && "failed to create image");
+            return false;
+        }
+        images[i]->Name = GetString(fileImage.Name);
     }
-}
 
-static bool LoadGLTFMaterial(
-    LoaderInternals*      pInternals,
-    const cgltf_data*     pGltfData,
-    const cgltf_material* pGltfMaterial,
-    FauxRender::Material* pTargetMaterial)
-{
-    if (IsNull(pInternals) || IsNull(pGltfData) || IsNull(pGltfMaterial) || IsNull(pTargetMaterial))
+    // Textures
+    std::vector<FauxRender::Texture*> textures(numTextures, nullptr);
+    for (uint32_t i = 0; i < numTextures; ++i)
     {
-        return false;
+        const auto& fileTexture = pTextures[i];
+
+        auto targetTexture      = std::make_unique<FauxRender::Texture>();
+        targetTexture->Name     = GetString(fileTexture.Name);
+        targetTexture->pImage   = (fileTexture.ImageIndex < numImages) ? images[fileTexture.ImageIndex] : nullptr;
+        targetTexture->pSampler = (fileTexture.SamplerIndex < numSamplers) ? samplers[fileTexture.SamplerIndex] : nullptr;
+
+        textures[i] = targetTexture.get();
+        pTargetGraph->Textures.push_back(std::move(targetTexture));
     }
 
-    // Name
-    pTargetMaterial->Name = !IsNull(pGltfMaterial->name) ? pGltfMaterial->name : "";
-    GREX_LOG_INFO("    Loading material: " << pTargetMaterial->Name);
+    auto GetTexture = [&textures, numTextures](uint32_t index) -> FauxRender::Texture* {
+        return (index < numTextures) ? textures[index] : nullptr;
+    };
 
-    // Tex coord transform flag
-    bool hasTexCoordTransform = false;
+    // Materials
+    std::vector<FauxRender::Material*> materials(numMaterials, nullptr);
+    for (uint32_t i = 0; i < numMaterials; ++i)
+    {
+        const auto& fileMaterial = pMaterials[i];
+
+        auto pTargetMaterial                       = pTargetGraph->AddMaterial();
+        pTargetMaterial->Name                      = GetString(fileMaterial.Name);
+        pTargetMaterial->BaseColor                 = vec4(fileMaterial.BaseColor[0], fileMaterial.BaseColor[1], fileMaterial.BaseColor[2], fileMaterial.BaseColor[3]);
+        pTargetMaterial->MetallicFactor            = fileMaterial.MetallicFactor;
+        pTargetMaterial->RoughnessFactor           = fileMaterial.RoughnessFactor;
+        pTargetMaterial->Emissive                  = vec3(fileMaterial.Emissive[0], fileMaterial.Emissive[1], fileMaterial.Emissive[2]);
+        pTargetMaterial->EmissiveStrength          = fileMaterial.EmissiveStrength;
+        pTargetMaterial->pBaseColorTexture         = GetTexture(fileMaterial.BaseColorTexture);
+        pTargetMaterial->pMetallicRoughnessTexture = GetTexture(fileMaterial.MetallicRoughnessTexture);
+        pTargetMaterial->pNormalTexture            = GetTexture(fileMaterial.NormalTexture);
+        pTargetMaterial->pOcclusionTexture         = GetTexture(fileMaterial.OcclusionTexture);
+        pTargetMaterial->pEmissiveTexture          = GetTexture(fileMaterial.EmissiveTexture);
+        pTargetMaterial->TexCoordTranslate         = vec2(fileMaterial.TexCoordTranslate[0], fileMaterial.TexCoordTranslate[1]);
+        pTargetMaterial->TexCoordRotate            = fileMaterial.TexCoordRotate;
+        pTargetMaterial->TexCoordScale             = vec2(fileMaterial.TexCoordScale[0], fileMaterial.TexCoordScale[1]);
+
+        materials[i] = pTargetMaterial;
+    }
 
-    // PBR metallic roughness
-    if (pGltfMaterial->has_pbr_metallic_roughness)
+    // Meshes - vertex/index data is uploaded straight from the file data, the
+    // ranges were checked by ValidateSceneFile()
+    std::vector<FauxRender::Mesh*> meshes(numMeshes, nullptr);
+    for (uint32_t i = 0; i < numMeshes; ++i)
     {
-        auto& gltfPbr = pGltfMaterial->pbr_metallic_roughness;
+        const auto& fileMesh = pMeshes[i];
 
-        pTargetMaterial->BaseColor = glm::vec4(
-            gltfPbr.base_color_factor[0],
-            gltfPbr.base_color_factor[1],
-            gltfPbr.base_color_factor[2],
-            gltfPbr.base_color_factor[3]);
+        auto targetMesh    = std::make_unique<FauxRender::Mesh>();
+        targetMesh->Name   = GetString(fileMesh.Name);
+        targetMesh->Bounds = ToAABB(fileMesh.BoundsMin, fileMesh.BoundsMax);
 
-        pTargetMaterial->MetallicFactor  = gltfPbr.metallic_factor;
-        pTargetMaterial->RoughnessFactor = gltfPbr.roughness_factor;
+        for (uint32_t batchIdx = 0; batchIdx < fileMesh.NumBatches; ++batchIdx)
+        {
+            const auto& fileBatch = pBatches[fileMesh.FirstBatch + batchIdx];
+
+            FauxRender::PrimitiveBatch batch = {};
+            batch.pMaterial                  = (fileBatch.MaterialIndex < numMaterials) ? materials[fileBatch.MaterialIndex] : nullptr;
+            batch.IndexBufferView            = ToBufferView(fileBatch.IndexBufferView);
+            batch.PositionBufferView         = ToBufferView(fileBatch.PositionBufferView);
+            batch.VertexColorBufferView      = ToBufferView(fileBatch.VertexColorBufferView);
+            batch.TexCoordBufferView         = ToBufferView(fileBatch.TexCoordBufferView);
+            batch.NormalBufferView           = ToBufferView(fileBatch.NormalBufferView);
+            batch.TangentBufferView          = ToBufferView(fileBatch.TangentBufferView);
+            batch.Bounds                     = ToAABB(fileBatch.BoundsMin, fileBatch.BoundsMax);
+
+            targetMesh->DrawBatches.push_back(batch);
+        }
 
-        // Base color texture
-        if (!IsNull(gltfPbr.base_color_texture.texture))
+        const uint32_t dataSize = static_cast<uint32_t>(fileMesh.DataSize);
+
+        bool res = pTargetGraph->CreateBuffer(
+            dataSize,                        // bufferSize
+            dataSize,                        // srcSize
+            pFileData + fileMesh.DataOffset, // pSrcData
+            false,                           // mappable
+            &targetMesh->pBuffer);           // ppBuffer
+        if (!res)
         {
-            bool res = LoadGLTFTexture(pInternals, pGltfData, &gltfPbr.base_color_texture, &pTargetMaterial->pBaseColorTexture);
-            if (!res)
-            {
-                return false;
-            }
+            assert(false && "failed to create mesh buffer");
+            return false;
+        }
 
-            CopyGLTFTexCoordTransform(&gltfPbr.base_color_texture, hasTexCoordTransform, pTargetMaterial);
+        meshes[i] = targetMesh.get();
+        pTargetGraph->Meshes.push_back(std::move(targetMesh));
+    }
+
+    // Nodes - indices in the file are relative to the first node loaded
+    const uint32_t nodeBase = static_cast<uint32_t>(pTargetGraph->Nodes.size());
+    for (uint32_t i = 0; i < numNodes; ++i)
+    {
+        const auto& fileNode = pNodes[i];
+        if ((uint64_t(fileNode.FirstChild) + fileNode.NumChildren) > numNodeChildren)
+        {
+            assert(false && "node children out of range");
+            return false;
         }
 
-        // Metallic roughness texture
-        if (!IsNull(gltfPbr.metallic_roughness_texture.texture))
+        auto pTargetNode                = pTargetGraph->AddNode();
+        pTargetNode->Name               = GetString(fileNode.Name);
+        pTargetNode->Type               = static_cast<FauxRender::SceneNodeType>(fileNode.Type);
+        pTargetNode->Parent             = (fileNode.Parent < numNodes) ? (nodeBase + fileNode.Parent) : UINT32_MAX;
+        pTargetNode->pMesh              = (fileNode.MeshIndex < numMeshes) ? meshes[fileNode.MeshIndex] : nullptr;
+        pTargetNode->Translate          = vec3(fileNode.Translate[0], fileNode.Translate[1], fileNode.Translate[2]);
+        pTargetNode->Rotation           = quat(fileNode.Rotation[0], fileNode.Rotation[1], fileNode.Rotation[2], fileNode.Rotation[3]);
+        pTargetNode->Scale              = vec3(fileNode.Scale[0], fileNode.Scale[1], fileNode.Scale[2]);
+        pTargetNode->Camera.AspectRatio = fileNode.AspectRatio;
+        pTargetNode->Camera.FovY        = fileNode.FovY;
+        pTargetNode->Camera.NearClip    = fileNode.NearClip;
+        pTargetNode->Camera.FarClip     = fileNode.FarClip;
+
+        for (uint32_t childIdx = 0; childIdx < fileNode.NumChildren; ++childIdx)
         {
-            bool res = LoadGLTFTexture(pInternals, pGltfData, &gltfPbr.metallic_roughness_texture, &pTargetMaterial->pMetallicRoughnessTexture);
-            if (!res)
+            uint32_t fileChildIndex = pNodeChildren[fileNode.FirstChild + childIdx];
+            if (fileChildIndex >= numNodes)
             {
+                assert(false && "node child index out of range");
                 return false;
             }
 
-            CopyGLTFTexCoordTransform(&gltfPbr.metallic_roughness_texture, hasTexCoordTransform, pTargetMaterial);
+            pTargetNode->Children.push_back(nodeBase + fileChildIndex);
         }
     }
 
-    // Normal texture
-    if (!IsNull(pGltfMaterial->normal_texture.texture))
+    // Scenes
+    for (uint32_t i = 0; i < numScenes; ++i)
     {
-        bool res = LoadGLTFTexture(pInternals, pGltfData, &pGltfMaterial->normal_texture, &pTargetMaterial->pNormalTexture);
-        if (!res)
+        const auto& fileScene = pScenes[i];
+        if ((uint64_t(fileScene.FirstNode) + fileScene.NumNodes) > numSceneNodes)
         {
+            assert(false && "scene nodes out of range");
             return false;
         }
 
-        CopyGLTFTexCoordTransform(&pGltfMaterial->normal_texture, hasTexCoordTransform, pTargetMaterial);
-    }
+        auto targetScene  = std::make_unique<FauxRender::Scene>();
+        targetScene->Name = GetString(fileScene.Name);
+        targetScene->GeometryNodeIndices.assign(pTargetGraph->Nodes.size(), UINT32_MAX);
 
-    // Occlusion texture
-    if (!IsNull(pGltfMaterial->occlusion_texture.texture))
-    {
-        bool res = LoadGLTFTexture(pInternals, pGltfData, &pGltfMaterial->occlusion_texture, &pTargetMaterial->pOcclusionTexture);
-        if (!res)
+        for (uint32_t nodeIdx = 0; nodeIdx < fileScene.NumNodes; ++nodeIdx)
         {
-            return false;
-        }
-
-        CopyGLTFTexCoordTransform(&pGltfMaterial->occlusion_texture, hasTexCoordTransform, pTargetMaterial);
-    }
+            uint32_t fileNodeIndex = pSceneNodes[fileScene.FirstNode + nodeIdx];
+            if (fileNodeIndex >= numNodes)
+            {
+                assert(false && "scene node index out of range");
+                return false;
+            }
 
-    // Emissive
-    pTargetMaterial->Emissive = glm::vec3(
-        pGltfMaterial->emissive_factor[0],
-        pGltfMaterial->emissive_factor[1],
-        pGltfMaterial->emissive_factor[2]);
+            auto pTargetNode = &pTargetGraph->Nodes[nodeBase + fileNodeIndex];
+            targetScene->Nodes.push_back(pTargetNode);
 
-    // Emissive strength
-    if (pGltfMaterial->has_emissive_strength)
-    {
-        pTargetMaterial->EmissiveStrength = pGltfMaterial->emissive_strength.emissive_strength;
-    }
+            if (pTargetNode->Type == FauxRender::SCENE_NODE_TYPE_GEOMETRY)
+            {
+                targetScene->AddGeometryNode(pTargetNode);
+            }
+        }
 
-    // Emissive texture
-    if (!IsNull(pGltfMaterial->emissive_texture.texture))
-    {
-        bool res = LoadGLTFTexture(pInternals, pGltfData, &pGltfMaterial->emissive_texture, &pTargetMaterial->pEmissiveTexture);
-        if (!res)
+        if (fileScene.ActiveCamera < numNodes)
         {
-            return false;
+            targetScene->pActiveCamera = &pTargetGraph->Nodes[nodeBase + fileScene.ActiveCamera];
         }
 
-        CopyGLTFTexCoordTransform(&pGltfMaterial->emissive_texture, hasTexCoordTransform, pTargetMaterial);
+        pTargetGraph->Scenes.push_back(std::move(targetScene));
     }
 
+    auto endTime = std::chrono::high_resolution_clock::now();
+    auto elapsed = std::chrono::duration<double, std::milli>(endTime - startTime).count();
+
+    GREX_LOG_INFO("  Successfully loaded scene: " << path << " (" << elapsed << " ms)");
+
     return true;
 }
 
-static bool LoadGLTFNode(LoaderInternals* pInternals, const cgltf_data* pGltfData, const cgltf_node* pGltfNode, FauxRender::SceneNode* pTargetNode)
+// =============================================================================
+// LoadGLTFAsync
+// =============================================================================
+
+// Images larger than this get a single level preview that's created before
+// the full resolution image
+const uint32_t ASYNC_PREVIEW_IMAGE_SIZE = 64;
+
+// Decoded full resolution images the worker keeps queued before it waits for
+// Update() to catch up. Bounds the memory held by decoded images.
+const uint32_t ASYNC_MAX_QUEUED_IMAGES = 8;
+
+struct AsyncImage
 {
-    if (IsNull(pInternals) || IsNull(pGltfData) || IsNull(pGltfNode) || IsNull(pTargetNode))
+    const cgltf_image* pGltfImage = nullptr;
+    DecodedImage       Image      = {};
+};
+
+struct AsyncLoadState
+{
+    std::filesystem::path   Path         = "";
+    FauxRender::LoadOptions LoadOptions  = {};
+    FauxRender::SceneGraph* pTargetGraph = nullptr;
+    cgltf_options           GltfOptions  = {};
+    cgltf_data*             pGltfData    = nullptr;
+    LoaderInternals         Internals    = {};
+
+    // Worker thread status
+    std::thread       Worker;
+    std::atomic<bool> Cancelled     = false;
+    std::atomic<bool> Parsed        = false;
+    std::atomic<bool> BuffersLoaded = false;
+    std::atomic<bool> WorkerFailed  = false;
+    std::atomic<bool> WorkerDone    = false;
+
+    // Decoded images, guarded by Mutex
+    std::mutex              Mutex;
+    std::condition_variable QueueChanged;
+    std::deque<AsyncImage>  PreviewQueue;
+    std::deque<AsyncImage>  FullQueue;
+
+    // Everything below is only touched by the thread calling Update()
+    std::atomic<FauxRender::AsyncLoadStage>                    Stage            = ASYNC_LOAD_STAGE_PARSING;
+    std::vector<FauxRender::Mesh*>                             Meshes           = {};
+    uint32_t                                                   NumMeshesLoaded  = 0;
+    uint32_t                                                   NumImages        = 0;
+    uint32_t                                                   NumPreviewImages = 0;
+    uint32_t                                                   NumImagesLoaded  = 0;
+    std::unordered_map<const cgltf_image*, FauxRender::Image*> PreviewImages    = {};
+    std::vector<FauxRender::Image*>                            ReplacedPreviews = {};
+};
+
+//
+// Creates a single level image no larger than ASYNC_PREVIEW_IMAGE_SIZE.
+// Returns false if the image is small enough to not need a preview.
+//
+static bool MakePreviewImage(const DecodedImage& image, DecodedImage* pPreview)
+{
+    if (!image.Bitmap.Empty())
     {
-        return false;
-    }
+        const uint32_t maxSize = std::max(image.Bitmap.GetWidth(), image.Bitmap.GetHeight());
+        if (maxSize <= ASYNC_PREVIEW_IMAGE_SIZE)
+        {
+            return false;
+        }
 
-    auto pTargetGraph = pInternals->pTargetGraph;
+        const float scale = static_cast<float>(ASYNC_PREVIEW_IMAGE_SIZE) / static_cast<float>(maxSize);
+        pPreview->Bitmap  = image.Bitmap.Scale(scale, scale, BITMAP_SAMPLE_MODE_WRAP, BITMAP_SAMPLE_MODE_WRAP, BITMAP_FILTER_MODE_LINEAR);
 
-    // Name
-    pTargetNode->Name = !IsNull(pGltfNode->name) ? pGltfNode->name : "";
-    GREX_LOG_INFO("    Loading node: " << pTargetNode->Name);
+        return !pPreview->Bitmap.Empty();
+    }
 
-    // Type
     //
-    // cgltf doesn't seem to have any sort of node type
-    // so we need to filter using the pointers.
+    // Block compressed images use the first mip level that fits. RowStride
+    // is the pitch of a row of 4x4 blocks.
     //
-    if (!IsNull(pGltfNode->mesh))
+    for (uint32_t level = 1; level < CountU32(image.MipOffsets); ++level)
     {
-        pTargetNode->Type = SCENE_NODE_TYPE_GEOMETRY;
+        const uint32_t width  = std::max<uint32_t>(image.Width >> level, 1);
+        const uint32_t height = std::max<uint32_t>(image.Height >> level, 1);
+        if ((width < 4) || (height < 4))
+        {
+            break;
+        }
+        if (std::max(width, height) > ASYNC_PREVIEW_IMAGE_SIZE)
+        {
+            continue;
+        }
+
+        const size_t levelOffset = image.MipOffsets[level].Offset;
+        const size_t levelSize   = static_cast<size_t>(image.MipOffsets[level].RowStride) * ((height + 3) / 4);
+        if ((levelOffset + levelSize) > image.Data.size())
+        {
+            return false;
+        }
+
+        pPreview->Width      = width;
+        pPreview->Height     = height;
+        pPreview->Format     = image.Format;
+        pPreview->MipOffsets = {MipOffset{0, image.MipOffsets[level].RowStride}};
+        pPreview->Data.assign(image.Data.begin() + levelOffset, image.Data.begin() + levelOffset + levelSize);
+
+        return true;
     }
-    else if (!IsNull(pGltfNode->camera))
+
+    return false;
+}
+
+static void AsyncLoadWorker(AsyncLoadState* pState)
+{
+    GREX_PROFILE_THREAD_NAME("GLTF async loader");
+    GREX_PROFILE_FUNCTION();
+
+    const std::string path = pState->Path.string();
+
+    // Parse
+    cgltf_result cgres = cgltf_result_success;
     {
-        pTargetNode->Type = SCENE_NODE_TYPE_CAMERA;
+        GREX_PROFILE_SCOPE("cgltf_parse_file");
+        cgres = cgltf_parse_file(&pState->GltfOptions, path.c_str(), &pState->pGltfData);
     }
-    else if (!IsNull(pGltfNode->light))
+    if (cgres != cgltf_result_success)
     {
-        pTargetNode->Type = SCENE_NODE_TYPE_LIGHT;
+        GREX_LOG_ERROR("Failed to parse GLTF: " << pState->Path);
+        pState->WorkerFailed = true;
+        pState->WorkerDone   = true;
+        return;
     }
-    else
+    pState->Parsed = true;
+
+    //
+    // Load buffers. Update() builds the hierarchy in the meantime, which
+    // doesn't read buffer contents.
+    //
     {
-        pTargetNode->Type = SCENE_NODE_TYPE_LOCATOR;
+        GREX_PROFILE_SCOPE("cgltf_load_buffers");
+        cgres = cgltf_load_buffers(&pState->GltfOptions, pState->pGltfData, path.c_str());
     }
-
-    // Parent - if there is one
-    if (!IsNull(pGltfNode->parent))
+    if (cgres != cgltf_result_success)
     {
-        pTargetNode->Parent = static_cast<uint32_t>(cgltf_node_index(pGltfData, pGltfNode->parent));
+        GREX_LOG_ERROR("Failed to load GLTF buffers: " << pState->Path);
+        pState->WorkerFailed = true;
+        pState->WorkerDone   = true;
+        return;
     }
 
-    // Children indices - remember these are local to the scene
-    for (size_t childIterIdx = 0; childIterIdx < pGltfNode->children_count; ++childIterIdx)
+    if (!DecodeGLTFMeshoptBuffers(pState->pGltfData))
     {
-        const auto pGltfChildNode   = pGltfNode->children[childIterIdx];
-        auto       gltfChildNodeIdx = cgltf_node_index(pGltfData, pGltfChildNode);
-        pTargetNode->Children.push_back(static_cast<uint32_t>(gltfChildNodeIdx));
+        pState->WorkerFailed = true;
+        pState->WorkerDone   = true;
+        return;
     }
+    pState->BuffersLoaded = true;
 
-    // Tranform
+    // Unique images referenced by textures
+    std::vector<const cgltf_image*> gltfImages;
+    for (size_t textureIdx = 0; textureIdx < pState->pGltfData->textures_count; ++textureIdx)
     {
-        pTargetNode->Translate = glm::vec3(0);
-        if (pGltfNode->has_translation)
+        const auto& gltfTexture = pState->pGltfData->textures[textureIdx];
+        auto        pGltfImage  = gltfTexture.has_basisu ? gltfTexture.basisu_image : gltfTexture.image;
+        if (!IsNull(pGltfImage) && (std::find(gltfImages.begin(), gltfImages.end(), pGltfImage) == gltfImages.end()))
         {
-            float x                = pGltfNode->translation[0];
-            float y                = pGltfNode->translation[1];
-            float z                = pGltfNode->translation[2];
-            pTargetNode->Translate = glm::vec3(x, y, z);
+            gltfImages.push_back(pGltfImage);
         }
+    }
 
-        pTargetNode->Rotation = glm::quat(0, 0, 0, 1);
-        if (pGltfNode->has_rotation)
+    // Decode images
+    for (auto pGltfImage : gltfImages)
+    {
+        if (pState->Cancelled)
         {
-            float x               = pGltfNode->rotation[0];
-            float y               = pGltfNode->rotation[1];
-            float z               = pGltfNode->rotation[2];
-            float w               = pGltfNode->rotation[3];
-            pTargetNode->Rotation = glm::quat(x, y, z, w);
+            break;
         }
 
-        pTargetNode->Scale = glm::vec3(1);
-        if (pGltfNode->has_scale)
+        AsyncImage fullImage = {};
+        fullImage.pGltfImage = pGltfImage;
+        if (!DecodeGLTFImage(pState->Path, pGltfImage, &fullImage.Image))
         {
-            float x            = pGltfNode->scale[0];
-            float y            = pGltfNode->scale[1];
-            float z            = pGltfNode->scale[2];
-            pTargetNode->Scale = glm::vec3(x, y, z);
-        }
-    }
-
-    switch (pTargetNode->Type)
-    {
-        default: assert(false && "unrecognized target node type"); break;
-
-        case SCENE_NODE_TYPE_GEOMETRY: {
-            FauxRender::Mesh* pTargetMesh = nullptr;
-            // Look to see if there's a corresponding FauxRender::Mesh for the GLTF mesh
-            auto it = pInternals->MeshMap.find(pGltfNode->mesh);
-            if (it != pInternals->MeshMap.end())
-            {
-                // We found a mesh!
-                pTargetMesh = (*it).second;
-            }
-            else
-            {
-                // Allocate target mesh
-                auto targetMesh = std::make_unique<FauxRender::Mesh>();
-                if (!targetMesh)
-                {
-                    assert(false && "allocation failed: FauxRender::Mesh");
-                    return false;
-                }
-
-                // Get pointer to target mesh
-                pTargetMesh = targetMesh.get();
-
-                // Update map
-                pInternals->MeshMap[pGltfNode->mesh] = pTargetMesh;
-
-                // Add target mesh to graph
-                pTargetGraph->Meshes.push_back(std::move(targetMesh));
-            }
-
-            pTargetNode->pMesh = pTargetMesh;
+            pState->WorkerFailed = true;
+            break;
         }
-        break;
 
-        case SCENE_NODE_TYPE_CAMERA: {
-            if (pGltfNode->camera->type == cgltf_camera_type_perspective)
-            {
-                auto& gltfCamera = pGltfNode->camera->data.perspective;
-                // Aspect ratio
-                if (gltfCamera.has_aspect_ratio)
-                {
-                    pTargetNode->Camera.AspectRatio = gltfCamera.aspect_ratio;
-                }
-                // Vertical FOV
-                pTargetNode->Camera.FovY = gltfCamera.yfov;
-                // Near clip
-                pTargetNode->Camera.NearClip = gltfCamera.znear;
-                if (gltfCamera.has_zfar)
-                {
-                    pTargetNode->Camera.FarClip = gltfCamera.zfar;
-                }
-                else
-                {
-                    pTargetNode->Camera.FarClip = gltfCamera.znear + 100.0f;
-                }
-            }
-            else
-            {
-                assert(false && "unsupported camera type");
-                return false;
-            }
-        }
-        break;
+        AsyncImage previewImage = {};
+        previewImage.pGltfImage = pGltfImage;
+        bool hasPreview         = MakePreviewImage(fullImage.Image, &previewImage.Image);
 
-        case SCENE_NODE_TYPE_LIGHT: break;
-        case SCENE_NODE_TYPE_LOCATOR: break;
+        std::unique_lock<std::mutex> lock(pState->Mutex);
+        pState->QueueChanged.wait(lock, [pState]() { return pState->Cancelled || (pState->FullQueue.size() < ASYNC_MAX_QUEUED_IMAGES); });
+
+        if (hasPreview)
+        {
+            pState->PreviewQueue.push_back(std::move(previewImage));
+        }
+        pState->FullQueue.push_back(std::move(fullImage));
     }
 
-    return true;
+    pState->WorkerDone = true;
 }
 
-static bool LoadGLTFSceneNodes(LoaderInternals* pInternals, const cgltf_data* pGltfData, const cgltf_node* pGltfNode, FauxRender::Scene* pTargetScene)
+static bool LoadAsyncHierarchy(AsyncLoadState* pState)
 {
-    if (IsNull(pGltfData) || IsNull(pGltfNode) || IsNull(pTargetScene))
+    auto pInternals = &pState->Internals;
+    auto pGltfData  = pState->pGltfData;
+
+    if (!LoadGLTFNodes(pInternals, pGltfData))
     {
         return false;
     }
 
-    auto pTargetGraph = pInternals->pTargetGraph;
+    // Draw batches and bounds only, geometry data is loaded per mesh later
+    if (!LoadGLTFMeshes(pInternals, pState->LoadOptions, pGltfData))
+    {
+        return false;
+    }
 
-    // Process children first
-    if (pGltfNode->children_count > 0)
+    // Textures are created without images
+    if (!LoadGLTFMaterials(pInternals, pGltfData))
     {
-        for (size_t childIterIdx = 0; childIterIdx < pGltfNode->children_count; ++childIterIdx)
-        {
-            auto pGltfChildNode = pGltfNode->children[childIterIdx];
+        return false;
+    }
 
-            bool res = LoadGLTFSceneNodes(pInternals, pGltfData, pGltfChildNode, pTargetScene);
-            if (!res)
-            {
-                return false;
-            }
-        }
+    // Geometry nodes are deferred until their mesh's geometry is loaded
+    if (!LoadGLTFScenes(pInternals, pGltfData))
+    {
+        return false;
     }
 
-    // Add node to scene
+    for (auto iter : pInternals->MeshMap)
     {
-        // Node index
-        const size_t nodeIndex = cgltf_node_index(pGltfData, pGltfNode);
+        pState->Meshes.push_back(iter.second);
+    }
+    pState->NumImages = static_cast<uint32_t>(pInternals->DeferredImageTextures.size());
 
-        // Target node
-        auto pTargetNode = pTargetGraph->Nodes[nodeIndex].get();
+    return true;
+}
 
-        // Store faux node pointer to scene
-        pTargetScene->Nodes.push_back(pTargetNode);
+static bool LoadAsyncMeshGeometry(AsyncLoadState* pState, FauxRender::Mesh* pTargetMesh)
+{
+    auto pInternals   = &pState->Internals;
+    auto pTargetGraph = pState->pTargetGraph;
 
-        // Store geometry node to scene to reduce searching later
-        if (pTargetNode->Type == FauxRender::SCENE_NODE_TYPE_GEOMETRY)
+    auto& targetBufferInfo = pInternals->MeshBufferInfo[pTargetMesh];
+
+    // Tangents are generated per mesh so the work is spread across Update()
+    // calls like the rest of the geometry
+    GenerateGLTFTangents({&targetBufferInfo}, pState->LoadOptions.NumTangentThreads);
+
+    //
+    // Gather the mesh's data on the CPU and create the buffer from it
+    // directly. A staging buffer would have to stay alive across Update()
+    // calls, and copying from it sizes the mesh buffer to the staging
+    // buffer.
+    //
+    if (targetBufferInfo.BufferSize > 0)
+    {
+        std::vector<char> meshData(targetBufferInfo.BufferSize);
+        for (const auto& copyRange : targetBufferInfo.CopyRanges)
         {
-            pTargetScene->GeometryNodes.push_back(pTargetNode);
+            CopyGLTFRange(copyRange, meshData.data());
         }
 
-        // Active camera
-        if (IsNull(pTargetScene->pActiveCamera) && (pTargetNode->Type == SCENE_NODE_TYPE_CAMERA))
+        if (pInternals->OptimizeMeshes)
         {
-            pTargetScene->pActiveCamera = pTargetNode;
+            OptimizeMeshData(pTargetMesh, meshData.data());
+        }
+
+        LoadGLTFDeformableData(targetBufferInfo, pTargetMesh, meshData.data());
+
+        bool res = pTargetGraph->CreateBuffer(
+            targetBufferInfo.BufferSize,             // bufferSize
+            targetBufferInfo.BufferSize,             // srcSize
+            meshData.data(),                         // pSrcData
+            !pTargetMesh->DeformableBatches.empty(), // mappable
+            &pTargetMesh->pBuffer);                  // ppBuffer
+        if (!res)
+        {
+            assert(false && "failed to create mesh buffer");
+            return false;
+        }
+    }
+
+    if (IsNull(pTargetMesh->pBuffer))
+    {
+        return true;
+    }
+
+    // The mesh can be drawn now, add its nodes to their scenes
+    auto it = pInternals->DeferredInstances.find(pTargetMesh);
+    if (it != pInternals->DeferredInstances.end())
+    {
+        for (auto& instance : (*it).second)
+        {
+            instance.pScene->AddGeometryNode(instance.pNode);
         }
     }
 
     return true;
 }
 
-static bool LoadGLTFScene(LoaderInternals* pInternals, const cgltf_data* pGltfData, const cgltf_scene& gltfScene, FauxRender::Scene* pTargetScene)
+static bool CreateAsyncImage(AsyncLoadState* pState, const AsyncImage& asyncImage, bool preview)
 {
-    if (IsNull(pInternals) || IsNull(pGltfData) || IsNull(pTargetScene))
+    auto pInternals   = &pState->Internals;
+    auto pTargetGraph = pState->pTargetGraph;
+
+    // Images that aren't referenced by any material's textures are skipped
+    auto it = pInternals->DeferredImageTextures.find(asyncImage.pGltfImage);
+    if (it == pInternals->DeferredImageTextures.end())
+    {
+        return true;
+    }
+
+    FauxRender::Image* pTargetImage = nullptr;
+    if (!CreateDecodedImage(pTargetGraph, asyncImage.Image, &pTargetImage))
     {
         return false;
     }
 
-    // auto pTargetGraph = pInternals->pTargetGraph;
+    std::string name   = !IsNull(asyncImage.pGltfImage->name) ? asyncImage.pGltfImage->name : "";
+    pTargetImage->Name = preview ? (name + " (preview)") : name;
 
-    // Name
-    pTargetScene->Name = !IsNull(gltfScene.name) ? gltfScene.name : "";
-    GREX_LOG_INFO("  Loading scene: " << pTargetScene->Name);
-    GREX_LOG_INFO("    Num nodes: " << gltfScene.nodes_count);
+    for (auto pTargetTexture : (*it).second)
+    {
+        pTargetTexture->pImage = pTargetImage;
+    }
 
-    // Nodes
-    for (size_t nodeIterIdx = 0; nodeIterIdx < gltfScene.nodes_count; ++nodeIterIdx)
+    // Only the materials that sample the new image need another upload
+    for (auto& material : pTargetGraph->Materials)
     {
-        const auto pGltfNode = gltfScene.nodes[nodeIterIdx];
+        if ((material.Index != UINT32_MAX) && UsesImage(material, pTargetImage))
+        {
+            pTargetGraph->UpdateMaterial(&material);
+        }
+    }
 
-        bool res = LoadGLTFSceneNodes(pInternals, pGltfData, pGltfNode, pTargetScene);
-        if (!res)
+    if (preview)
+    {
+        pState->PreviewImages[asyncImage.pGltfImage] = pTargetImage;
+        pState->NumPreviewImages += 1;
+    }
+    else
+    {
+        // Previews are kept until ReleasePreviewImages() since frames in
+        // flight may still sample them
+        auto previewIt = pState->PreviewImages.find(asyncImage.pGltfImage);
+        if (previewIt != pState->PreviewImages.end())
         {
-            return false;
+            pState->ReplacedPreviews.push_back((*previewIt).second);
+            pState->PreviewImages.erase(previewIt);
+        }
+        else
+        {
+            pState->NumPreviewImages += 1;
         }
+
+        pInternals->ImageMap[asyncImage.pGltfImage] = pTargetImage;
+        pState->NumImagesLoaded += 1;
     }
 
     return true;
 }
 
-bool LoadGLTF(const std::filesystem::path& path, const FauxRender::LoadOptions& loadOptions, FauxRender::SceneGraph* pTargetGraph)
+static void FinishAsyncLoad(AsyncLoadState* pState, FauxRender::AsyncLoadStage stage)
 {
-    if (!std::filesystem::exists(path) || IsNull(pTargetGraph))
+    if (stage == ASYNC_LOAD_STAGE_CANCELLED)
     {
-        return false;
+        GREX_LOG_INFO("  Cancelled loading GLTF: " << pState->Path);
+    }
+    else if (stage == ASYNC_LOAD_STAGE_FAILED)
+    {
+        GREX_LOG_ERROR("Failed to load GLTF: " << pState->Path);
+    }
+    else
+    {
+        GREX_LOG_INFO("  Successfully loaded GLTF: " << pState->Path);
     }
 
-    GREX_LOG_INFO("Loading GLTF: " << path);
-
-    cgltf_options gltfOptions = {};
-    cgltf_data*   pGltfData   = nullptr;
+    // Wake the worker if it's waiting on the queue
+    {
+        std::lock_guard<std::mutex> lock(pState->Mutex);
+        pState->Cancelled = (stage != ASYNC_LOAD_STAGE_COMPLETE);
+    }
+    pState->QueueChanged.notify_all();
 
-    // Parse
-    cgltf_result cgres = cgltf_parse_file(
-        &gltfOptions,
-        path.string().c_str(),
-        &pGltfData);
-    if (cgres != cgltf_result_success)
+    if (pState->Worker.joinable())
     {
-        return false;
+        pState->Worker.join();
     }
 
-    // Internal loader scratch data
-    LoaderInternals internals = {};
-    internals.gltfPath        = path;
-    internals.pTargetGraph    = pTargetGraph;
+    pState->PreviewQueue.clear();
+    pState->FullQueue.clear();
 
-    // Load nodes
-    for (size_t nodeIdx = 0; nodeIdx < pGltfData->nodes_count; ++nodeIdx)
+    if (!IsNull(pState->pGltfData))
     {
-        const auto& gltfNode = pGltfData->nodes[nodeIdx];
-
-        // Allocate target node
-        auto targetNode = std::make_unique<FauxRender::SceneNode>();
-        if (!targetNode)
-        {
-            return false;
-        }
+        cgltf_free(pState->pGltfData);
+        pState->pGltfData = nullptr;
+    }
 
-        // Load GLTF node
-        bool res = LoadGLTFNode(&internals, pGltfData, &gltfNode, targetNode.get());
-        if (!res)
-        {
-            return false;
-        }
+    pState->Stage = stage;
+}
 
-        // Add node to graph
-        pTargetGraph->Nodes.push_back(std::move(targetNode));
+AsyncLoad::~AsyncLoad()
+{
+    if (this->pState && !this->IsDone())
+    {
+        FinishAsyncLoad(this->pState.get(), ASYNC_LOAD_STAGE_CANCELLED);
     }
+}
 
-    // -------------------------------------------------------------------------
-    // Load meshes
-    // -------------------------------------------------------------------------
+void AsyncLoad::Cancel()
+{
     {
-        GREX_LOG_INFO("  Loading " << internals.MeshMap.size() << " unique meshes");
+        std::lock_guard<std::mutex> lock(this->pState->Mutex);
+        this->pState->Cancelled = true;
+    }
+    this->pState->QueueChanged.notify_all();
+}
 
-        for (auto iter : internals.MeshMap)
-        {
-            auto pGltfMesh   = iter.first;
-            auto pTargetMesh = iter.second;
+FauxRender::AsyncLoadProgress AsyncLoad::GetProgress() const
+{
+    auto pState = this->pState.get();
+
+    FauxRender::AsyncLoadProgress progress = {};
+    progress.Stage                         = pState->Stage;
+    progress.NumMeshes                     = CountU32(pState->Meshes);
+    progress.NumMeshesLoaded               = pState->NumMeshesLoaded;
+    progress.NumImages                     = pState->NumImages;
+    progress.NumPreviewImages              = pState->NumPreviewImages;
+    progress.NumImagesLoaded               = pState->NumImagesLoaded;
+
+    // Weight hierarchy, geometry and textures as 10%, 40% and 50%
+    if (progress.Stage >= ASYNC_LOAD_STAGE_COMPLETE)
+    {
+        progress.Fraction = 1.0f;
+    }
+    else if (progress.Stage >= ASYNC_LOAD_STAGE_GEOMETRY)
+    {
+        float geometry = (progress.NumMeshes > 0) ? (static_cast<float>(progress.NumMeshesLoaded) / progress.NumMeshes) : 1.0f;
+        float textures = (progress.NumImages > 0) ? (static_cast<float>(progress.NumImagesLoaded) / progress.NumImages) : 0.0f;
 
-            bool res = LoadGLTFMesh(&internals, loadOptions, pGltfData, pGltfMesh, pTargetMesh);
-            if (!res)
-            {
-                return false;
-            }
-        }
+        progress.Fraction = 0.1f + 0.4f * geometry + 0.5f * textures;
     }
 
-    // -------------------------------------------------------------------------
-    // Load geometry data from buffers
-    // -------------------------------------------------------------------------
+    return progress;
+}
+
+bool AsyncLoad::IsDone() const
+{
+    return (this->pState->Stage >= ASYNC_LOAD_STAGE_COMPLETE);
+}
+
+uint32_t AsyncLoad::Update(float budgetMilliseconds)
+{
+    GREX_PROFILE_SCOPE("AsyncLoad::Update");
+
+    auto pState    = this->pState.get();
+    auto startTime = std::chrono::high_resolution_clock::now();
+
+    uint32_t changes = 0;
+    while (!this->IsDone())
     {
-        // Load GLTF buffers from file.
-        // These buffers will be destroyed when cgltf_free() is called.
-        //
-        cgres = cgltf_load_buffers(
-            &gltfOptions,
-            pGltfData,
-            internals.gltfPath.string().c_str());
-        if (cgres != cgltf_result_success)
+        if (pState->Cancelled)
         {
-            cgltf_free(pGltfData);
-            return false;
+            FinishAsyncLoad(pState, ASYNC_LOAD_STAGE_CANCELLED);
+            break;
         }
 
-        bool res = LoadGLTFGeometryData(&internals, pGltfData);
-        if (!res)
+        if (pState->WorkerFailed)
         {
-            return false;
+            FinishAsyncLoad(pState, ASYNC_LOAD_STAGE_FAILED);
+            break;
         }
-    }
 
-    // -------------------------------------------------------------------------
-    // Load materials and associated textures
-    // -------------------------------------------------------------------------
-    {
-        GREX_LOG_INFO("  Loading " << internals.MaterialMap.size() << " unique materials");
+        const FauxRender::AsyncLoadStage stage = pState->Stage;
+        if (stage == ASYNC_LOAD_STAGE_PARSING)
+        {
+            if (!pState->Parsed)
+            {
+                break;
+            }
+            pState->Stage = ASYNC_LOAD_STAGE_HIERARCHY;
+        }
+        else if (stage == ASYNC_LOAD_STAGE_HIERARCHY)
+        {
+            if (!LoadAsyncHierarchy(pState))
+            {
+                FinishAsyncLoad(pState, ASYNC_LOAD_STAGE_FAILED);
+                break;
+            }
 
-        for (auto iter : internals.MaterialMap)
+            changes |= ASYNC_LOAD_CHANGE_HIERARCHY;
+            pState->Stage = ASYNC_LOAD_STAGE_GEOMETRY;
+        }
+        else if (stage == ASYNC_LOAD_STAGE_GEOMETRY)
         {
-            auto pGltfMaterial   = iter.first;
-            auto pTargetMaterial = iter.second;
+            if (!pState->BuffersLoaded)
+            {
+                break;
+            }
 
-            bool res = LoadGLTFMaterial(&internals, pGltfData, pGltfMaterial, pTargetMaterial);
-            if (!res)
+            // Skins and animations read the glTF buffers too, they're
+            // loaded once all the geometry is in
+            if (pState->NumMeshesLoaded == CountU32(pState->Meshes))
             {
-                return false;
+                if (!LoadGLTFSkins(&pState->Internals, pState->pGltfData) ||
+                    !LoadGLTFAnimations(&pState->Internals, pState->pGltfData) ||
+                    !pState->pTargetGraph->CreateDeformedBuffers())
+                {
+                    FinishAsyncLoad(pState, ASYNC_LOAD_STAGE_FAILED);
+                    break;
+                }
+
+                if ((pState->pGltfData->skins_count > 0) || (pState->pGltfData->animations_count > 0))
+                {
+                    changes |= ASYNC_LOAD_CHANGE_HIERARCHY;
+                }
+                pState->Stage = ASYNC_LOAD_STAGE_TEXTURES;
+                continue;
             }
-        }
-    }
 
-    // -------------------------------------------------------------------------
-    // Load scenes
-    // -------------------------------------------------------------------------
-    for (size_t sceneIterIdx = 0; sceneIterIdx < pGltfData->scenes_count; ++sceneIterIdx)
-    {
-        const auto& gltfScene = pGltfData->scenes[sceneIterIdx];
+            if (!LoadAsyncMeshGeometry(pState, pState->Meshes[pState->NumMeshesLoaded]))
+            {
+                FinishAsyncLoad(pState, ASYNC_LOAD_STAGE_FAILED);
+                break;
+            }
 
-        // Allocate target scene
-        auto targetScene = std::make_unique<FauxRender::Scene>();
-        if (!targetScene)
+            changes |= ASYNC_LOAD_CHANGE_GEOMETRY;
+            pState->NumMeshesLoaded += 1;
+        }
+        else if (stage == ASYNC_LOAD_STAGE_TEXTURES)
         {
-            return false;
+            //
+            // Previews go first. A full resolution image is only taken
+            // once every preview the worker has produced so far is in.
+            //
+            AsyncImage asyncImage = {};
+            bool       hasImage   = false;
+            bool       preview    = false;
+            {
+                std::lock_guard<std::mutex> lock(pState->Mutex);
+                if (!pState->PreviewQueue.empty())
+                {
+                    asyncImage = std::move(pState->PreviewQueue.front());
+                    pState->PreviewQueue.pop_front();
+                    hasImage = true;
+                    preview  = true;
+                }
+                else if (!pState->FullQueue.empty())
+                {
+                    asyncImage = std::move(pState->FullQueue.front());
+                    pState->FullQueue.pop_front();
+                    hasImage = true;
+                }
+            }
+
+            if (!hasImage)
+            {
+                if (pState->WorkerDone)
+                {
+                    // The worker may have failed after the last check
+                    FinishAsyncLoad(pState, pState->WorkerFailed ? ASYNC_LOAD_STAGE_FAILED : ASYNC_LOAD_STAGE_COMPLETE);
+                }
+                break;
+            }
+
+            pState->QueueChanged.notify_all();
+
+            if (!CreateAsyncImage(pState, asyncImage, preview))
+            {
+                FinishAsyncLoad(pState, ASYNC_LOAD_STAGE_FAILED);
+                break;
+            }
+
+            changes |= ASYNC_LOAD_CHANGE_IMAGES;
         }
 
-        // Load GLTF scene
-        bool res = LoadGLTFScene(&internals, pGltfData, gltfScene, targetScene.get());
-        if (!res)
+        auto elapsed = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
+        if (elapsed >= budgetMilliseconds)
         {
-            return false;
+            break;
         }
+    }
 
-        // Add scene to graph
-        pTargetGraph->Scenes.push_back(std::move(targetScene));
+    return changes;
+}
+
+uint32_t AsyncLoad::ReleasePreviewImages()
+{
+    if (this->pState->ReplacedPreviews.empty())
+    {
+        return 0;
     }
 
-    // Free GLTF data
-    cgltf_free(pGltfData);
+    for (auto pImage : this->pState->ReplacedPreviews)
+    {
+        this->pState->pTargetGraph->RemoveImage(pImage);
+    }
+    this->pState->ReplacedPreviews.clear();
 
-    GREX_LOG_INFO("  Successfully loaded GLTF: " << path);
+    return ASYNC_LOAD_CHANGE_IMAGES;
+}
+
+bool LoadGLTFAsync(
+    const std::filesystem::path&            path,
+    const FauxRender::LoadOptions&          loadOptions,
+    FauxRender::SceneGraph*                 pTargetGraph,
+    std::unique_ptr<FauxRender::AsyncLoad>* ppLoad)
+{
+    if (!std::filesystem::exists(path) || IsNull(pTargetGraph) || IsNull(ppLoad))
+    {
+        return false;
+    }
+
+    GREX_LOG_INFO("Loading GLTF asynchronously: " << path);
+
+    auto load    = std::make_unique<FauxRender::AsyncLoad>();
+    load->pState = std::make_unique<FauxRender::AsyncLoadState>();
+
+    auto pState                      = load->pState.get();
+    pState->Path                     = path;
+    pState->LoadOptions              = loadOptions;
+    pState->pTargetGraph             = pTargetGraph;
+    pState->Internals.gltfPath       = path;
+    pState->Internals.pTargetGraph   = pTargetGraph;
+    pState->Internals.OptimizeMeshes = loadOptions.OptimizeMeshes;
+    pState->Internals.Progressive    = true;
+
+    pState->Worker = std::thread(AsyncLoadWorker, pState);
+
+    *ppLoad = std::move(load);
 
     return true;
 }
@@ -4,11 +4,16 @@
 #include "config.h"
 #include "bitmap.h"
 
+#include <cfloat>
+#include <deque>
+#include <unordered_map>
+
 #define GLM_FORCE_QUAT_DATA_XYZW
 #include <glm/glm.hpp>
 #include <glm/matrix.hpp>
 #include <glm/gtx/quaternion.hpp>
 #include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_precision.hpp>
 #include <glm/gtx/matrix_transform_2d.hpp>
 #include <glm/gtx/transform.hpp>
 #include <glm/gtx/transform2.hpp>
@@ -40,9 +45,90 @@ enum TextureAddressMode
     TEXTURE_ADDRESS_MODE_BORDER = 3,
 };
 
+enum VertexLayoutBits
+{
+    VERTEX_LAYOUT_POSITION     = (1 << 0),
+    VERTEX_LAYOUT_VERTEX_COLOR = (1 << 1),
+    VERTEX_LAYOUT_TEX_COORD    = (1 << 2),
+    VERTEX_LAYOUT_NORMAL       = (1 << 3),
+    VERTEX_LAYOUT_TANGENT      = (1 << 4),
+};
+
+// Starting capacities for the growable instance, material and image
+// tables. The tables double in size as needed, so these aren't limits.
+const uint32_t INITIAL_INSTANCE_CAPACITY = 256;
+const uint32_t INITIAL_MATERIAL_CAPACITY = 64;
+const uint32_t INITIAL_IMAGE_CAPACITY    = 64;
+
+// GPU copies kept of the instance and material tables, see SlotTableBuffers.
+// Enough for this many frames the GPU hasn't finished, counting the one
+// being recorded.
+const uint32_t NUM_BUFFERED_FRAMES = 3;
+
 struct Buffer;
 struct Texture;
 struct Sampler;
+struct DrawList;
+struct TextureStreamer;
+
+struct AABB
+{
+    glm::vec3 Min = glm::vec3(FLT_MAX);
+    glm::vec3 Max = glm::vec3(-FLT_MAX);
+
+    bool      IsValid() const { return (this->Min.x <= this->Max.x) && (this->Min.y <= this->Max.y) && (this->Min.z <= this->Max.z); }
+    glm::vec3 Center() const { return (this->Min + this->Max) * 0.5f; }
+    glm::vec3 Extent() const { return (this->Max - this->Min) * 0.5f; }
+
+    float SurfaceArea() const;
+    bool  Contains(const FauxRender::AABB& other) const;
+    void  Expand(const FauxRender::AABB& other);
+
+    // Returns the box that encloses this box after transformation
+    FauxRender::AABB Transform(const glm::mat4& matrix) const;
+};
+
+//
+// CPU side bookkeeping for a growable GPU table. Slots released with
+// Free() are handed out again before the table grows, and the range of
+// slots written since the last upload is tracked so that only that range
+// needs to be copied to the GPU. No graphics API objects are involved.
+//
+struct SlotTable
+{
+    uint32_t              MinCapacity = 64;
+    uint32_t              Capacity    = 0; // Number of slots backed by GPU storage
+    uint32_t              NumSlots    = 0; // Slots [0, NumSlots) have been handed out at least once
+    uint32_t              Count       = 0; // Number of live slots
+    std::vector<uint32_t> FreeSlots   = {};
+    std::vector<bool>     Live        = {};
+    uint32_t              DirtyBegin  = UINT32_MAX;
+    uint32_t              DirtyEnd    = 0;
+
+    uint32_t Allocate();
+    void     Free(uint32_t slot);
+    bool     IsLive(uint32_t slot) const;
+    void     MarkDirty(uint32_t slot);
+    void     MarkAllDirty();
+    bool     IsDirty() const;
+    void     ClearDirty();
+};
+
+//
+// GPU copies of a slot table, one per buffered frame. Data holds the params
+// of every slot on the CPU. An upload writes the table's dirty slots to Data
+// once, then brings the next copy up to date and makes it current, so the
+// copies that frames in flight read aren't touched. Each copy keeps the slot
+// range that changed since it was last written, which keeps uploads partial.
+//
+struct SlotTableBuffers
+{
+    std::vector<char>   Data                            = {};
+    FauxRender::Buffer* Buffers[NUM_BUFFERED_FRAMES]    = {};
+    uint32_t            DirtyBegin[NUM_BUFFERED_FRAMES] = {}; // Copy is up to date if DirtyBegin >= DirtyEnd
+    uint32_t            DirtyEnd[NUM_BUFFERED_FRAMES]   = {};
+    uint32_t            Current                         = 0;
+};
 
 struct BufferView
 {
@@ -58,6 +144,8 @@ struct Buffer
     uint32_t Size     = 0;
     bool     Mappable = false;
 
+    virtual ~Buffer() {}
+
     virtual bool Map(void** ppData) = 0;
     virtual void Unmap()            = 0;
 };
@@ -71,6 +159,9 @@ struct Image
     GREXFormat  Format    = GREX_FORMAT_UNKNOWN;
     uint32_t    NumLevels = 0;
     uint32_t    NumLayers = 0;
+    uint32_t    Index     = UINT32_MAX; // Index into SceneGraph::Images
+
+    virtual ~Image() {}
 };
 
 struct Texture
@@ -89,6 +180,7 @@ struct Sampler
     FauxRender::TextureAddressMode AddressU  = TEXTURE_ADDRESS_MODE_CLAMP;
     FauxRender::TextureAddressMode AddressV  = TEXTURE_ADDRESS_MODE_CLAMP;
     FauxRender::TextureAddressMode AddressW  = TEXTURE_ADDRESS_MODE_CLAMP;
+    uint32_t                       Index     = UINT32_MAX; // Index into SceneGraph::Samplers
 };
 
 //
@@ -120,7 +212,8 @@ struct Material
     glm::vec2            TexCoordTranslate         = {0, 0};
     float                TexCoordRotate            = 0;
     glm::vec2            TexCoordScale             = {1, 1};
-}; // namespace FauxRender
+    uint32_t             Index                     = UINT32_MAX; // Index into SceneGraph::Materials
+};
 
 struct PrimitiveBatch
 {
@@ -131,19 +224,157 @@ struct PrimitiveBatch
     FauxRender::BufferView TexCoordBufferView    = {};
     FauxRender::BufferView NormalBufferView      = {};
     FauxRender::BufferView TangentBufferView     = {};
+    FauxRender::AABB       Bounds                = {}; // Local space, from the POSITION accessor's min/max
+
+    // Returns VERTEX_LAYOUT_* bits for the attributes present in the batch
+    uint32_t GetVertexLayout() const;
+};
+
+//
+// Source data for primitives that are deformed on the CPU - primitives with
+// JOINTS_0/WEIGHTS_0 or morph targets. The batch's position, normal and
+// tangent views are float so deformed vertices can be written over them.
+//
+struct MorphTarget
+{
+    std::vector<glm::vec3> PositionDeltas = {};
+    std::vector<glm::vec3> NormalDeltas   = {}; // Empty if the target has no NORMAL
+    std::vector<glm::vec3> TangentDeltas  = {}; // Empty if the target has no TANGENT
+};
+
+struct DeformableBatch
+{
+    uint32_t                             BatchIndex = UINT32_MAX; // Index into Mesh::DrawBatches
+    std::vector<glm::vec3>               Positions  = {};
+    std::vector<glm::vec3>               Normals    = {};
+    std::vector<glm::vec4>               Tangents   = {}; // W is the bitangent sign
+    std::vector<glm::u16vec4>            Joints     = {}; // Empty if the batch isn't skinned
+    std::vector<glm::vec4>               Weights    = {};
+    std::vector<FauxRender::MorphTarget> Targets    = {};
 };
 
 struct Mesh
 {
-    std::string                 Name        = "";
-    std::vector<PrimitiveBatch> DrawBatches = {};
-    FauxRender::Buffer*         pBuffer     = nullptr;
+    std::string                              Name              = "";
+    std::vector<PrimitiveBatch>              DrawBatches       = {};
+    FauxRender::Buffer*                      pBuffer           = nullptr; // Mappable if the mesh has deformable batches
+    FauxRender::AABB                         Bounds            = {};      // Local space, union of the batch bounds
+    std::vector<FauxRender::DeformableBatch> DeformableBatches = {};
+    std::vector<float>                       MorphWeights      = {};      // Default morph target weights
+};
+
+struct Skin
+{
+    std::string            Name                = "";
+    std::vector<uint32_t>  Joints              = {}; // Indexes into SceneGraph::Nodes
+    std::vector<glm::mat4> InverseBindMatrices = {};
+};
+
+enum AnimationPath
+{
+    ANIMATION_PATH_TRANSLATION = 0,
+    ANIMATION_PATH_ROTATION    = 1,
+    ANIMATION_PATH_SCALE       = 2,
+    ANIMATION_PATH_WEIGHTS     = 3,
+};
+
+enum AnimationInterpolation
+{
+    ANIMATION_INTERPOLATION_STEP         = 0,
+    ANIMATION_INTERPOLATION_LINEAR       = 1,
+    ANIMATION_INTERPOLATION_CUBIC_SPLINE = 2,
+};
+
+struct AnimationSampler
+{
+    AnimationInterpolation Interpolation = ANIMATION_INTERPOLATION_LINEAR;
+    uint32_t               NumComponents = 0;  // Per value: 3, 4 or the number of morph targets
+    std::vector<float>     Times         = {};
+    std::vector<float>     Values        = {}; // CUBIC_SPLINE keys store in-tangent, value, out-tangent
+};
+
+struct AnimationChannel
+{
+    uint32_t      Node    = UINT32_MAX; // Index into SceneGraph::Nodes
+    AnimationPath Path    = ANIMATION_PATH_TRANSLATION;
+    uint32_t      Sampler = UINT32_MAX; // Index into Animation::Samplers
+};
+
+struct Animation
+{
+    std::string                               Name     = "";
+    std::vector<FauxRender::AnimationSampler> Samplers = {};
+    std::vector<FauxRender::AnimationChannel> Channels = {};
+    float                                     Duration = 0; // Last key time of all samplers
+};
+
+//
+// Frustum planes in SoA layout so that four planes are tested per SIMD
+// operation. The six planes are padded to eight with planes that never
+// reject anything. Points p with dot(N, p) + D >= 0 are inside.
+//
+struct FrustumPlanes
+{
+    alignas(16) float Nx[8];
+    alignas(16) float Ny[8];
+    alignas(16) float Nz[8];
+    alignas(16) float D[8];
+};
+
+enum FrustumTest
+{
+    FRUSTUM_TEST_OUTSIDE   = 0,
+    FRUSTUM_TEST_INTERSECT = 1,
+    FRUSTUM_TEST_INSIDE    = 2,
+};
+
+void                    ExtractFrustumPlanes(const glm::mat4& viewProjectionMatrix, FauxRender::FrustumPlanes* pPlanes);
+FauxRender::FrustumTest TestFrustum(const FauxRender::FrustumPlanes& planes, const FauxRender::AABB& bounds);
+
+//
+// Dynamic AABB tree over a scene's instances. Leaves store fattened world
+// bounds so that small movements don't touch the tree; an instance is only
+// reinserted when its bounds leave its fat box. Instances without valid
+// bounds are kept out of the tree and are always visible.
+//
+struct SceneBVH
+{
+    struct Node
+    {
+        FauxRender::AABB Bounds        = {};
+        uint32_t         Parent        = UINT32_MAX;
+        uint32_t         Left          = UINT32_MAX;
+        uint32_t         Right         = UINT32_MAX;
+        uint32_t         InstanceIndex = UINT32_MAX; // Leaves only
+
+        bool IsLeaf() const { return (this->Left == UINT32_MAX); }
+    };
+
+    std::vector<Node>     Nodes              = {};
+    std::vector<uint32_t> FreeNodes          = {};
+    std::vector<uint32_t> InstanceLeaves     = {}; // Instance index to leaf node
+    std::vector<uint32_t> UnboundedInstances = {}; // Unordered, removal swaps in the last entry
+    std::vector<uint32_t> UnboundedPositions = {}; // Instance index to UnboundedInstances position
+    uint32_t              Root               = UINT32_MAX;
+    float                 FatMargin          = 0.1f; // Fraction of the box size added on each side
+
+    // Inserts the instance or moves it if it left its fat box
+    void Update(uint32_t instanceIndex, const FauxRender::AABB& worldBounds);
+    void Remove(uint32_t instanceIndex);
+
+private:
+    uint32_t AllocateNode();
+    void     FreeNode(uint32_t nodeIndex);
+    void     InsertLeaf(uint32_t leaf);
+    void     RemoveLeaf(uint32_t leaf);
+    void     RemoveUnbounded(uint32_t instanceIndex);
 };
 
 struct SceneNode
 {
     std::string           Name      = "";
     SceneNodeType         Type      = SCENE_NODE_TYPE_UNKNOWN;
+    uint32_t              Index     = UINT32_MAX; // Index into SceneGraph::Nodes
     uint32_t              Parent    = UINT32_MAX; // Indexes into SceneGraph::Nodes
     std::vector<uint32_t> Children  = {};         // Indexes into SceneGraph::Nodes
     FauxRender::Mesh*     pMesh     = nullptr;
@@ -151,6 +382,10 @@ struct SceneNode
     glm::quat             Rotation  = quat(0, 0, 0, 1); // <X, Y, Z, W>
     glm::vec3             Scale     = vec3(1);
 
+    FauxRender::Skin*   pSkin           = nullptr;
+    std::vector<float>  MorphWeights    = {};      // Overrides Mesh::MorphWeights if not empty
+    FauxRender::Buffer* pDeformedBuffer = nullptr; // Node's copy of its deformable mesh's buffer
+
     struct
     {
         float AspectRatio = 1.0f;
@@ -158,6 +393,10 @@ struct SceneNode
         float NearClip    = 0.1f;
         float FarClip     = 10000.0f;
     } Camera;
+
+    // Index and vertex buffer the node's batches are drawn from: the
+    // deformed buffer if it has one, the mesh's buffer otherwise
+    FauxRender::Buffer* GetDrawBuffer() const;
 };
 
 struct Scene
@@ -167,24 +406,62 @@ struct Scene
     std::vector<FauxRender::SceneNode*> GeometryNodes = {};
     const SceneNode*                    pActiveCamera = nullptr;
 
+    // Maps SceneNode::Index to the node's position in GeometryNodes, which
+    // is also its instance index. Non-geometry nodes map to UINT32_MAX.
+    std::vector<uint32_t> GeometryNodeIndices = {};
+
+    // Instance slots - GeometryNodes entries for freed slots are NULL
+    FauxRender::SlotTable InstanceSlots = {FauxRender::INITIAL_INSTANCE_CAPACITY};
+
+    // World bounds of the instances, kept up to date by
+    // SceneGraph::UpdateInstanceBuffer()
+    FauxRender::SceneBVH BVH = {};
+
     FauxRender::Buffer* pCameraArgs = nullptr;
 
-    FauxRender::Buffer* pInstanceBuffer = nullptr;
-    uint32_t            NumInstances    = 0;
+    // Current copy of InstanceBuffers
+    FauxRender::SlotTableBuffers InstanceBuffers = {};
+    FauxRender::Buffer*          pInstanceBuffer = nullptr;
+    uint32_t                     NumInstances    = 0;
 
     uint32_t GetGeometryNodeIndex(const FauxRender::SceneNode* pGeometryNode) const;
+
+    // Returns the instance index assigned to the node
+    uint32_t AddGeometryNode(FauxRender::SceneNode* pGeometryNode);
+    void     RemoveGeometryNode(const FauxRender::SceneNode* pGeometryNode);
+
+    // Call after changing a node's transform so its instance and bounds are
+    // updated by the next SceneGraph::UpdateInstanceBuffer().
+    void UpdateGeometryNode(const FauxRender::SceneNode* pGeometryNode);
 };
 
+//
+// Nodes and materials are stored by value in deques: elements live in
+// contiguous chunks and pointers to them stay valid as the graph grows.
+// Images are allocated by the API specific scene graphs, so they're
+// still stored through unique_ptr.
+//
+// Every object that lives in the graph caches its own index so that
+// the Get*Index functions are O(1).
+//
+// Materials and images are allocated from slot tables: removed slots are
+// reused by later additions, so a material's or image's index is also its
+// slot in the GPU material buffer or the image descriptor range. Removed
+// image slots hold NULL until they're reused, write image descriptors with
+// GetDescriptorImage() so they still get a valid image.
+//
 struct SceneGraph
 {
     std::vector<std::unique_ptr<FauxRender::Scene>>     Scenes;
-    std::vector<std::unique_ptr<FauxRender::SceneNode>> Nodes;
+    std::deque<FauxRender::SceneNode>                   Nodes;
     std::vector<std::unique_ptr<FauxRender::Mesh>>      Meshes;
     std::vector<std::unique_ptr<FauxRender::Buffer>>    Buffers;
-    std::vector<std::unique_ptr<FauxRender::Material>>  Materials;
+    std::deque<FauxRender::Material>                    Materials;
     std::vector<std::unique_ptr<FauxRender::Texture>>   Textures;
     std::vector<std::unique_ptr<FauxRender::Image>>     Images;
     std::vector<std::unique_ptr<FauxRender::Sampler>>   Samplers;
+    std::vector<std::unique_ptr<FauxRender::Skin>>      Skins;
+    std::vector<std::unique_ptr<FauxRender::Animation>> Animations;
     FauxRender::Image*                                  pDefaultBaseColorImage         = nullptr;
     FauxRender::Image*                                  pDefaultMetallicRoughnessImage = nullptr;
     FauxRender::Image*                                  pDefaultNormalImage            = nullptr;
@@ -193,13 +470,59 @@ struct SceneGraph
     FauxRender::Sampler*                                pDefaultClampedSampler         = nullptr;
     FauxRender::Sampler*                                pDefaultRepeatSampler          = nullptr;
 
-    FauxRender::Buffer* pMaterialBuffer = nullptr;
-    uint32_t            NumMaterials    = 0;
+    FauxRender::SlotTable MaterialSlots = {FauxRender::INITIAL_MATERIAL_CAPACITY};
+    FauxRender::SlotTable ImageSlots    = {FauxRender::INITIAL_IMAGE_CAPACITY};
+
+    // Current copy of MaterialBuffers
+    FauxRender::SlotTableBuffers MaterialBuffers = {};
+    FauxRender::Buffer*          pMaterialBuffer = nullptr;
+    uint32_t                     NumMaterials    = 0;
+
+    // Material and instance buffer copies replaced by a larger one and the
+    // buffers of destroyed draw lists, see ReleaseRetiredBuffers()
+    std::vector<std::unique_ptr<FauxRender::Buffer>> RetiredBuffers;
 
     uint32_t GetMaterialIndex(const FauxRender::Material* pMaterial) const;
     uint32_t GetImageIndex(const FauxRender::Image* pImage) const;
     uint32_t GetSamplerIndex(const FauxRender::Sampler* pSampler) const;
 
+    // Image for descriptor slot 'slot': the image in that slot, or
+    // pDefaultBaseColorImage if the slot was freed.
+    FauxRender::Image* GetDescriptorImage(uint32_t slot) const;
+
+    // True if every slot of the shader image range is taken. Backends check
+    // this before creating an image's API resources.
+    bool IsImageTableFull() const;
+
+    FauxRender::SceneNode* AddNode();
+    FauxRender::Material*  AddMaterial();
+
+    // Fails if the image would land outside the shader image range, the
+    // caller still owns the image then.
+    bool AddImage(FauxRender::Image* pImage);
+
+    // The caller must make sure the GPU is no longer using the material
+    // or image. Removing an image destroys it.
+    void RemoveMaterial(FauxRender::Material* pMaterial);
+    void RemoveImage(FauxRender::Image* pImage);
+
+    // Call after changing a material so it's uploaded by the next
+    // UpdateMaterialBuffer().
+    void UpdateMaterial(const FauxRender::Material* pMaterial);
+
+    // Uploads the dirty slot range of the material or instance table to the
+    // next of the table's NUM_BUFFERED_FRAMES buffer copies and makes it the
+    // current one, so call these at most once per frame. Copies the frames in
+    // flight read are left alone. A copy the table outgrew is replaced by a
+    // new buffer sized to the table's capacity, and the old one moves to
+    // RetiredBuffers.
+    bool UpdateMaterialBuffer();
+    bool UpdateInstanceBuffer(FauxRender::Scene* pScene);
+
+    // Destroys the retired buffers. Call once the GPU has finished every
+    // frame that was submitted before the last Update*Buffer() call.
+    void ReleaseRetiredBuffers();
+
     virtual bool CreateTemporaryBuffer(
         uint32_t             size,
         const void*          pData,
@@ -234,7 +557,8 @@ struct SceneGraph
         const void*                   pSrcImageData,
         FauxRender::Image**           ppImage) = 0;
 
-    // Vulkan needs to override this since it needs to store a sampler object
+    // Vulkan needs to override this since it needs to store a sampler object.
+    // Fails once there are MAX_SAMPLERS samplers.
     virtual bool CreateSampler(
         FauxRender::FilterMode         minFilter,
         FauxRender::FilterMode         magFilter,
@@ -246,8 +570,34 @@ struct SceneGraph
 
     bool InitializeResources();
 
+    // Gives every geometry node with a deformable mesh a mappable copy of
+    // the mesh buffer for UpdateDeformedMesh() to write to. Nodes that
+    // already have one are skipped. The glTF loaders call this once the
+    // geometry is loaded.
+    bool CreateDeformedBuffers();
+
+    // Creates the draw ordered instance buffer and the indirect argument
+    // buffer for a draw list built with BuildDrawList(). Call after the
+    // scene's first UpdateInstanceBuffer(). Rebuild and reinitialize the
+    // list after adding or removing geometry nodes.
+    bool InitializeDrawList(const FauxRender::Scene* pScene, FauxRender::DrawList* pDrawList);
+
+    // Copies the instances that changed in the scene's instance buffer into
+    // the draw list's instance buffer, call once per frame after the scene's
+    // UpdateInstanceBuffer(). Uses the same buffered copies as the slot
+    // tables, so the copies that frames in flight read aren't touched.
+    bool UpdateDrawList(const FauxRender::Scene* pScene, FauxRender::DrawList* pDrawList);
+
+    // Moves the draw list's buffers to RetiredBuffers
+    void DestroyDrawList(FauxRender::DrawList* pDrawList);
+
 protected:
     bool InitializeDefaults();
+
+    // Writes DrawList::IndirectArgs to a new buffer. D3D12 overrides this
+    // since its indirect commands also set the draw's root constants and
+    // buffer views.
+    virtual bool CreateDrawListArgsBuffer(const FauxRender::DrawList* pDrawList, FauxRender::Buffer** ppBuffer);
 };
 
 struct LoadOptions
@@ -256,10 +606,134 @@ struct LoadOptions
     bool EnableTexCoords    = true;
     bool EnableNormals      = true;
     bool EnableTangents     = true;
+
+    // KHR_mesh_quantization attributes are converted to float, which is
+    // what the samples' fixed vertex layouts expect. Clear this to keep
+    // normalized attributes in their integer formats, the pipeline's
+    // vertex layout then has to be built from each batch's buffer view
+    // formats. Integer attributes that aren't normalized are always
+    // converted to float.
+    bool DequantizeVertexAttributes = true;
+
+    // Primitives without a TANGENT attribute get MikkTSpace tangents if
+    // EnableTangents is set. Primitives are processed in parallel on the
+    // shared JobSystem with at most NumTangentThreads threads, 0 uses the
+    // whole pool.
+    bool     GenerateMissingTangents = true;
+    uint32_t NumTangentThreads       = 0;
+
+    // Reorders each primitive's triangles for the vertex cache and overdraw
+    // and its vertices for fetch locality with meshoptimizer. ACMR, ATVR
+    // and overdraw before and after are logged per mesh.
+    bool OptimizeMeshes = false;
+
+    // LoadGLTF() hands images to the streamer instead of creating them
+    // with all levels resident. Ignored by LoadGLTFAsync().
+    FauxRender::TextureStreamer* pTextureStreamer = nullptr;
 };
 
 bool LoadGLTF(const std::filesystem::path& path, const FauxRender::LoadOptions& loadOptions, FauxRender::SceneGraph* pGraph);
 
+// Loads a .grexscene file written by the gltf_to_grexscene tool. The file
+// holds GPU ready geometry and mip chains so nothing is parsed per element.
+bool LoadScene(const std::filesystem::path& path, FauxRender::SceneGraph* pGraph);
+
+// =============================================================================
+// Asynchronous loading
+// =============================================================================
+//
+// LoadGLTFAsync() returns as soon as a worker thread has been started. The
+// worker parses the file, reads the buffers and decodes images. Everything
+// that creates API resources or changes the graph happens in
+// AsyncLoad::Update(), which the application calls once per frame on the
+// thread that owns the graph. The scene streams in stages:
+//
+//   HIERARCHY - nodes, meshes without geometry, materials, textures without
+//               images and scenes without geometry instances
+//   GEOMETRY  - one mesh buffer at a time, the mesh's nodes are added to
+//               their scenes as instances once the buffer exists
+//   TEXTURES  - a small preview of every image is created before any full
+//               resolution image. Until then materials use the graph's
+//               default images.
+//
+// Update() returns ASYNC_LOAD_CHANGE_* bits so the application knows what
+// to refresh:
+//   HIERARCHY - call SceneGraph::InitializeResources() the first time.
+//               Reported again once skins and animations are loaded.
+//   GEOMETRY  - call SceneGraph::UpdateInstanceBuffer() for the scenes and
+//               rebuild draw lists
+//   IMAGES    - call SceneGraph::UpdateMaterialBuffer() and rewrite image
+//               descriptors through SceneGraph::GetDescriptorImage()
+//
+// The graph must outlive the AsyncLoad. Cancelling or failing leaves
+// whatever was loaded so far in the graph.
+//
+enum AsyncLoadStage
+{
+    ASYNC_LOAD_STAGE_PARSING   = 0,
+    ASYNC_LOAD_STAGE_HIERARCHY = 1,
+    ASYNC_LOAD_STAGE_GEOMETRY  = 2,
+    ASYNC_LOAD_STAGE_TEXTURES  = 3,
+    ASYNC_LOAD_STAGE_COMPLETE  = 4,
+    ASYNC_LOAD_STAGE_CANCELLED = 5,
+    ASYNC_LOAD_STAGE_FAILED    = 6,
+};
+
+enum AsyncLoadChangeBits
+{
+    ASYNC_LOAD_CHANGE_HIERARCHY = (1 << 0),
+    ASYNC_LOAD_CHANGE_GEOMETRY  = (1 << 1),
+    ASYNC_LOAD_CHANGE_IMAGES    = (1 << 2),
+};
+
+struct AsyncLoadProgress
+{
+    FauxRender::AsyncLoadStage Stage            = ASYNC_LOAD_STAGE_PARSING;
+    uint32_t                   NumMeshes        = 0;
+    uint32_t                   NumMeshesLoaded  = 0;
+    uint32_t                   NumImages        = 0;
+    uint32_t                   NumPreviewImages = 0; // Images that have at least their preview loaded
+    uint32_t                   NumImagesLoaded  = 0; // Images loaded at full resolution
+    float                      Fraction         = 0; // Estimate of overall progress, 0 to 1
+};
+
+struct AsyncLoadState;
+
+struct AsyncLoad
+{
+    // Cancels the load and waits for the worker thread
+    ~AsyncLoad();
+
+    // Thread safe, the worker stops at the next image and Update() moves
+    // the load to ASYNC_LOAD_STAGE_CANCELLED.
+    void Cancel();
+
+    FauxRender::AsyncLoadProgress GetProgress() const;
+
+    // True once the load is complete, cancelled or failed
+    bool IsDone() const;
+
+    // Applies finished worker results to the graph for roughly
+    // budgetMilliseconds, at least one item is always processed.
+    // Returns ASYNC_LOAD_CHANGE_* bits.
+    uint32_t Update(float budgetMilliseconds);
+
+    // Removes the preview images that were replaced by full resolution
+    // images. The caller must make sure the GPU is no longer using them.
+    // Returns ASYNC_LOAD_CHANGE_IMAGES if any were removed: their slots
+    // are free now, rewrite image descriptors with
+    // SceneGraph::GetDescriptorImage().
+    uint32_t ReleasePreviewImages();
+
+    std::unique_ptr<FauxRender::AsyncLoadState> pState;
+};
+
+bool LoadGLTFAsync(
+    const std::filesystem::path&            path,
+    const FauxRender::LoadOptions&          loadOptions,
+    FauxRender::SceneGraph*                 pGraph,
+    std::unique_ptr<FauxRender::AsyncLoad>* ppLoad);
+
 namespace Shader
 {
 
@@ -269,10 +743,11 @@ using float3   = glm::vec3;
 using float4   = glm::vec4;
 using float4x4 = glm::mat4;
 
-const uint32_t MAX_INSTANCES = 100;
-const uint32_t MAX_MATERIALS = 100;
-const uint32_t MAX_SAMPLERS  = 32;
-const uint32_t MAX_IMAGES    = 1024;
+// Instance and material buffers are structured buffers sized by their
+// slot tables. Samplers and images are bound through fixed size descriptor
+// ranges, so these two are still hard limits: creating more fails.
+const uint32_t MAX_SAMPLERS = 32;
+const uint32_t MAX_IMAGES   = 1024;
 
 enum MaterialFlagBits
 {
@@ -337,8 +812,279 @@ struct MaterialParams
 #endif // __APPLE__
 };
 
+// Matches the layout of D3D12_DRAW_INDEXED_ARGUMENTS,
+// VkDrawIndexedIndirectCommand and MTLDrawIndexedPrimitivesIndirectArguments
+struct DrawIndexedIndirectArgs
+{
+    uint IndexCount;
+    uint InstanceCount;
+    uint FirstIndex;
+    int  BaseVertex;
+    uint FirstInstance;
+};
+
 } // namespace Shader
 
+// =============================================================================
+// Draw lists
+// =============================================================================
+//
+// A draw list collapses the per node draws of a scene into instanced draws.
+// Primitive batches are grouped by mesh and batch - which also fixes the
+// material and the vertex layout - and sorted by vertex layout and then
+// material to minimize state changes. Skinned and morphed nodes have
+// buffers of their own, so each of them gets separate draws.
+//
+// Each draw covers a contiguous range of InstanceIndices. The draw list's
+// instance buffer is written in that order, so shaders fetch instance data
+// with Draw.InstanceIndex + instance id, where Draw.InstanceIndex is set to
+// the draw's FirstInstance. The indirect arguments always use a first
+// instance of 0 so this works the same on D3D12, Vulkan and Metal.
+//
+struct InstancedDraw
+{
+    const FauxRender::Mesh* pMesh         = nullptr;
+    FauxRender::Buffer*     pBuffer       = nullptr;    // SceneNode::GetDrawBuffer() of the draw's instances
+    uint32_t                BatchIndex    = UINT32_MAX; // Indexes into Mesh::DrawBatches
+    uint32_t                MaterialIndex = UINT32_MAX; // Indexes into SceneGraph::Materials
+    uint32_t                VertexLayout  = 0;          // VERTEX_LAYOUT_* bits
+    uint32_t                FirstInstance = 0;          // Indexes into DrawList::InstanceIndices
+    uint32_t                InstanceCount = 0;
+};
+
+struct DrawList
+{
+    std::vector<FauxRender::InstancedDraw>                   Draws           = {};
+    std::vector<uint32_t>                                    InstanceIndices = {}; // Indexes into Scene::GeometryNodes
+    std::vector<FauxRender::Shader::DrawIndexedIndirectArgs> IndirectArgs    = {}; // One per draw
+    uint32_t                                                 NumNodeDraws    = 0;  // Draws needed without instancing
+
+    // One slot per InstanceIndices entry, pInstanceBuffer is the current
+    // copy of InstanceBuffers
+    FauxRender::SlotTable        InstanceSlots       = {};
+    FauxRender::SlotTableBuffers InstanceBuffers     = {};
+    FauxRender::Buffer*          pInstanceBuffer     = nullptr; // Shader::InstanceParams in InstanceIndices order
+    FauxRender::Buffer*          pIndirectArgsBuffer = nullptr;
+};
+
+// CPU only, doesn't touch any API resources
+bool BuildDrawList(const FauxRender::SceneGraph* pGraph, const FauxRender::Scene* pScene, FauxRender::DrawList* pDrawList);
+
+// =============================================================================
+// Culling
+// =============================================================================
+//
+// CullScene() walks the scene's BVH and writes the instances that intersect
+// the view frustum into a visible list. Subtrees that are fully inside the
+// frustum are accepted without testing their children. The visible list is
+// meant to be rebuilt every frame after SceneGraph::UpdateInstanceBuffer().
+//
+struct CullStats
+{
+    uint32_t NumVisible     = 0;
+    uint32_t NumCulled      = 0;
+    uint32_t NumNodesTested = 0;
+    float    Microseconds   = 0;
+};
+
+struct VisibleList
+{
+    std::vector<uint32_t> InstanceIndices = {}; // Indexes into Scene::GeometryNodes
+    FauxRender::CullStats Stats           = {};
+};
+
+bool CullScene(const FauxRender::Scene* pScene, const glm::mat4& viewProjectionMatrix, FauxRender::VisibleList* pVisibleList);
+
+// =============================================================================
+// Texture streaming
+// =============================================================================
+//
+// The texture streamer keeps a host copy of each streamed image's mip chain
+// and decides how many of its finest levels are resident on the GPU. Images
+// can't be partially updated through the scene graph, so changing an
+// image's residency recreates it from its resident mip tail and points the
+// textures that use it at the new image.
+//
+// The required level of an image is estimated from the visible geometry
+// nodes whose materials use it: projected pixels per world unit at the
+// nearest point of the node's bounds against texels per world unit, which
+// assumes the texture's UVs span 0..1 once over the node's bounds. That
+// holds for uniquely textured assets and underestimates tiled ones, which
+// is what LodBias is for.
+//
+// If the required levels don't fit the budget, the images that would free
+// the most memory are coarsened one level at a time until they do.
+//
+// Replaced images are kept for RetireLatency updates so frames in flight
+// can still read them. Removing them frees their image slots, so after
+// ImagesChanged is set the application rewrites its image descriptors
+// through SceneGraph::GetDescriptorImage(), uploads the material buffer
+// and clears the flag. Everything but ApplyTargetLevels() is CPU only,
+// so the policy can be driven with a HostFauxRender::SceneGraph.
+//
+struct StreamingImageSource
+{
+    uint32_t               Width      = 0;
+    uint32_t               Height     = 0;
+    GREXFormat             Format     = GREX_FORMAT_UNKNOWN;
+    std::vector<MipOffset> MipOffsets = {}; // One per level, finest first
+    std::vector<char>      Data       = {};
+};
+
+// Builds a full RGBA8 mip chain for a bitmap
+bool MakeStreamingImageSource(const BitmapRGBA8u& bitmap, FauxRender::StreamingImageSource* pSource);
+
+struct StreamingView
+{
+    glm::vec3 EyePosition          = glm::vec3(0);
+    glm::mat4 ViewProjectionMatrix = glm::mat4(1);
+    float     FovY                 = glm::radians(60.0f);
+    float     ViewportHeight       = 1080;
+};
+
+// Uses the scene's active camera, returns false if there isn't one
+bool GetStreamingView(const FauxRender::Scene* pScene, float viewportHeight, FauxRender::StreamingView* pView);
+
+struct StreamingStats
+{
+    uint32_t NumImages              = 0;
+    uint32_t NumImagesBelowRequired = 0; // Resident level coarser than required
+    uint64_t ResidentBytes          = 0;
+    uint64_t RequiredBytes          = 0;
+    uint64_t TargetBytes            = 0;
+    uint64_t BudgetBytes            = 0;
+    uint32_t NumLoads               = 0; // Totals since the streamer was created
+    uint32_t NumEvictions           = 0;
+    uint64_t BytesLoaded            = 0;
+    uint64_t BytesEvicted           = 0;
+};
+
+struct TextureStreamer
+{
+    struct Entry
+    {
+        FauxRender::StreamingImageSource Source        = {};
+        std::vector<uint32_t>            LevelSizes    = {};
+        FauxRender::Image*               pImage        = nullptr;
+        uint32_t                         TailLevel     = 0; // Coarsest level that's kept resident
+        uint32_t                         ResidentLevel = 0; // Finest resident level
+        uint32_t                         RequiredLevel = 0;
+        uint32_t                         TargetLevel   = 0;
+    };
+
+    struct RetiredImage
+    {
+        FauxRender::Image* pImage      = nullptr;
+        uint64_t           UpdateIndex = 0;
+    };
+
+    uint64_t BudgetBytes       = 256 * 1024 * 1024;
+    uint32_t MaxLoadsPerUpdate = 4;
+    float    LodBias           = 0;
+    uint32_t MinTailSize       = 64; // Levels this size and smaller are always resident
+    uint32_t RetireLatency     = 3;  // Updates before a replaced image is removed
+
+    std::vector<Entry>                                     Entries       = {};
+    std::unordered_map<const FauxRender::Image*, uint32_t> ImageEntries  = {}; // Current image to entry index
+    std::vector<RetiredImage>                              RetiredImages = {};
+    uint64_t                                               UpdateIndex   = 0;
+    FauxRender::StreamingStats                             Stats         = {};
+    bool                                                   ImagesChanged = false; // Images were created or removed, cleared by the application
+
+    // Creates the image with only its mip tail resident
+    bool AddImage(FauxRender::SceneGraph* pGraph, FauxRender::StreamingImageSource&& source, FauxRender::Image** ppImage);
+
+    // CPU only. Expects the scene's BVH to be up to date, see
+    // SceneGraph::UpdateInstanceBuffer().
+    void ComputeRequiredLevels(const FauxRender::SceneGraph* pGraph, const FauxRender::Scene* pScene, const FauxRender::StreamingView& view);
+    void ComputeTargetLevels();
+
+    // Recreates images whose resident level differs from their target.
+    // Evictions are applied right away, loads are limited to
+    // MaxLoadsPerUpdate per call.
+    bool ApplyTargetLevels(FauxRender::SceneGraph* pGraph);
+
+    bool Update(FauxRender::SceneGraph* pGraph, const FauxRender::Scene* pScene, const FauxRender::StreamingView& view);
+
+    // Removes all retired images, the GPU must be idle
+    void ReleaseRetiredImages(FauxRender::SceneGraph* pGraph);
+
+private:
+    bool     SetResidentLevel(FauxRender::SceneGraph* pGraph, uint32_t entryIndex, uint32_t level);
+    uint64_t GetResidentSize(const Entry& entry, uint32_t level) const;
+    void     UpdateStats();
+};
+
+// =============================================================================
+// Animation and skinning
+// =============================================================================
+//
+// Everything here runs on the CPU. A frame typically:
+//
+//   ApplyAnimation()        - samples the channels into node TRS and morph
+//                             weights, and marks the moved instances dirty
+//   ComputeWorldMatrices()  - once for the whole graph
+//   UpdateDeformedMesh()    - per skinned or morphed geometry node, writes
+//                             the deformed vertices to the mesh buffer
+//
+// Skinned vertices are in the geometry node's local space so they're drawn
+// with the node's regular instance transform. Every node with a deformable
+// mesh gets its own copy of the mesh buffer from
+// SceneGraph::CreateDeformedBuffers(), so nodes that share a mesh can have
+// different poses. The application has to keep the GPU from reading a
+// node's buffer while it's written.
+//
+
+// Samples every channel at time, which is clamped to each sampler's key
+// range. Geometry nodes under an animated node are marked dirty in pScene
+// if it's not NULL.
+void ApplyAnimation(const FauxRender::Animation& animation, float time, FauxRender::SceneGraph* pGraph, FauxRender::Scene* pScene = nullptr);
+
+// World matrix of every node in the graph, indexed like SceneGraph::Nodes
+void ComputeWorldMatrices(const FauxRender::SceneGraph* pGraph, std::vector<glm::mat4>* pWorldMatrices);
+
+// Joint palette for a skinned geometry node: inverse(node world) *
+// joint world * inverse bind matrix for every joint of the node's skin
+bool ComputeJointMatrices(
+    const FauxRender::SceneGraph* pGraph,
+    const std::vector<glm::mat4>& worldMatrices,
+    const FauxRender::SceneNode*  pNode,
+    std::vector<glm::mat4>*       pJointMatrices);
+
+struct DeformedVertices
+{
+    std::vector<glm::vec3> Positions = {};
+    std::vector<glm::vec3> Normals   = {};
+    std::vector<glm::vec4> Tangents  = {};
+};
+
+//
+// Applies the morph targets and then, if the batch is skinned, linear blend
+// skinning with up to four joints per vertex. Normals and tangents are
+// transformed with the blended matrix and renormalized, which is exact for
+// joints without non-uniform scale. Uses SSE2 when it's available.
+//
+void DeformBatch(
+    const FauxRender::DeformableBatch& batch,
+    const float*                       pMorphWeights,
+    uint32_t                           numMorphWeights,
+    const glm::mat4*                   pJointMatrices,
+    uint32_t                           numJoints,
+    FauxRender::DeformedVertices*      pVertices);
+
+// Writes deformed vertices over the batch's position, normal and tangent
+// views in pMeshData, the mesh buffer's contents
+void WriteDeformedVertices(const FauxRender::PrimitiveBatch& batch, const FauxRender::DeformedVertices& vertices, char* pMeshData);
+
+// Deforms every deformable batch of the node's mesh and writes the result
+// to the node's deformed buffer. pScratch is reused between calls to avoid
+// allocations.
+bool UpdateDeformedMesh(
+    const FauxRender::SceneGraph* pGraph,
+    const std::vector<glm::mat4>& worldMatrices,
+    const FauxRender::SceneNode*  pNode,
+    FauxRender::DeformedVertices* pScratch);
+
 } // namespace FauxRender
 
 #endif // FAUX_RENDER_H
@@ -0,0 +1,196 @@
+#ifndef FAUX_RENDER_SCENE_FILE_H
+#define FAUX_RENDER_SCENE_FILE_H
+
+#include "config.h"
+
+// =============================================================================
+// .grexscene file format
+// =============================================================================
+//
+// A preprocessed FauxRender scene graph. Everything is stored as fixed size
+// little endian records so that a loader can point straight into the file
+// contents - whether they were read in one go or memory mapped - without
+// parsing individual elements.
+//
+// Layout:
+//   FileHeader
+//   Tables    - one array of records per FileTableType, located by
+//               FileHeader::Tables[type]
+//   Blob data - vertex/index data and image mip chains. Every blob and
+//               every mip level starts on a FILE_BLOB_ALIGNMENT boundary
+//               and mip rows are padded to FILE_ROW_PITCH_ALIGNMENT. These
+//               match D3D12's texture placement and pitch alignments.
+//               Loaders must still honor FileMipLevel::RowStride, files
+//               from other writers aren't required to pad.
+//
+// All offsets are in bytes from the start of the file. Indices refer to
+// records in the corresponding table, UINT32_MAX means none.
+//
+namespace FauxRender
+{
+namespace SceneFile
+{
+
+const char     FILE_MAGIC[8]            = {'G', 'R', 'E', 'X', 'S', 'C', 'N', '\0'};
+const uint32_t FILE_VERSION             = 1;
+const uint32_t FILE_BLOB_ALIGNMENT      = 512;
+const uint32_t FILE_ROW_PITCH_ALIGNMENT = 256;
+
+enum FileTableType
+{
+    FILE_TABLE_STRINGS       = 0,  // char
+    FILE_TABLE_NODES         = 1,  // FileNode
+    FILE_TABLE_NODE_CHILDREN = 2,  // uint32_t
+    FILE_TABLE_SCENES        = 3,  // FileScene
+    FILE_TABLE_SCENE_NODES   = 4,  // uint32_t
+    FILE_TABLE_MESHES        = 5,  // FileMesh
+    FILE_TABLE_BATCHES       = 6,  // FileBatch
+    FILE_TABLE_MATERIALS     = 7,  // FileMaterial
+    FILE_TABLE_TEXTURES      = 8,  // FileTexture
+    FILE_TABLE_IMAGES        = 9,  // FileImage
+    FILE_TABLE_MIP_LEVELS    = 10, // FileMipLevel
+    FILE_TABLE_SAMPLERS      = 11, // FileSampler
+    FILE_TABLE_COUNT         = 12,
+};
+
+struct FileTable
+{
+    uint64_t Offset = 0;
+    uint32_t Count  = 0;
+    uint32_t Stride = 0;
+};
+
+struct FileHeader
+{
+    char      Magic[8]                 = {};
+    uint32_t  Version                  = 0;
+    uint32_t  HeaderSize               = 0;
+    uint64_t  FileSize                 = 0;
+    FileTable Tables[FILE_TABLE_COUNT] = {};
+};
+
+// Range in FILE_TABLE_STRINGS, not null terminated
+struct FileString
+{
+    uint32_t Offset = 0;
+    uint32_t Length = 0;
+};
+
+struct FileBufferView
+{
+    uint32_t Offset = 0; // Relative to the owning mesh's blob
+    uint32_t Size   = 0;
+    uint32_t Stride = 0;
+    uint32_t Format = 0; // GREXFormat
+    uint32_t Count  = 0;
+};
+
+struct FileNode
+{
+    FileString Name         = {};
+    uint32_t   Type         = 0;  // SceneNodeType
+    uint32_t   Parent       = UINT32_MAX;
+    uint32_t   FirstChild   = 0;  // Into FILE_TABLE_NODE_CHILDREN
+    uint32_t   NumChildren  = 0;
+    uint32_t   MeshIndex    = UINT32_MAX;
+    float      Translate[3] = {};
+    float      Rotation[4]  = {}; // <X, Y, Z, W>
+    float      Scale[3]     = {};
+    float      AspectRatio  = 0;
+    float      FovY         = 0;
+    float      NearClip     = 0;
+    float      FarClip      = 0;
+};
+
+struct FileScene
+{
+    FileString Name         = {};
+    uint32_t   FirstNode    = 0;          // Into FILE_TABLE_SCENE_NODES
+    uint32_t   NumNodes     = 0;
+    uint32_t   ActiveCamera = UINT32_MAX; // Node index
+    uint32_t   _padding0    = 0;
+};
+
+struct FileMesh
+{
+    FileString Name         = {};
+    uint32_t   FirstBatch   = 0; // Into FILE_TABLE_BATCHES
+    uint32_t   NumBatches   = 0;
+    uint64_t   DataOffset   = 0; // Vertex/index blob
+    uint64_t   DataSize     = 0;
+    float      BoundsMin[3] = {};
+    float      BoundsMax[3] = {};
+};
+
+struct FileBatch
+{
+    uint32_t       MaterialIndex         = UINT32_MAX;
+    FileBufferView IndexBufferView       = {};
+    FileBufferView PositionBufferView    = {};
+    FileBufferView VertexColorBufferView = {};
+    FileBufferView TexCoordBufferView    = {};
+    FileBufferView NormalBufferView      = {};
+    FileBufferView TangentBufferView     = {};
+    float          BoundsMin[3]          = {};
+    float          BoundsMax[3]          = {};
+};
+
+struct FileMaterial
+{
+    FileString Name                     = {};
+    float      BaseColor[4]             = {};
+    float      MetallicFactor           = 0;
+    float      RoughnessFactor          = 0;
+    float      Emissive[3]              = {};
+    float      EmissiveStrength         = 0;
+    uint32_t   BaseColorTexture         = UINT32_MAX; // Texture indices
+    uint32_t   MetallicRoughnessTexture = UINT32_MAX;
+    uint32_t   NormalTexture            = UINT32_MAX;
+    uint32_t   OcclusionTexture         = UINT32_MAX;
+    uint32_t   EmissiveTexture          = UINT32_MAX;
+    float      TexCoordTranslate[2]     = {};
+    float      TexCoordRotate           = 0;
+    float      TexCoordScale[2]         = {};
+};
+
+struct FileTexture
+{
+    FileString Name         = {};
+    uint32_t   ImageIndex   = UINT32_MAX;
+    uint32_t   SamplerIndex = UINT32_MAX;
+};
+
+struct FileImage
+{
+    FileString Name       = {};
+    uint32_t   Width      = 0;
+    uint32_t   Height     = 0;
+    uint32_t   Format     = 0; // GREXFormat
+    uint32_t   FirstLevel = 0; // Into FILE_TABLE_MIP_LEVELS
+    uint32_t   NumLevels  = 0;
+    uint32_t   _padding0  = 0;
+    uint64_t   DataOffset = 0; // Mip chain blob
+    uint64_t   DataSize   = 0;
+};
+
+struct FileMipLevel
+{
+    uint32_t Offset    = 0; // Relative to the owning image's blob
+    uint32_t RowStride = 0;
+};
+
+struct FileSampler
+{
+    FileString Name      = {};
+    uint32_t   MinFilter = 0; // FilterMode
+    uint32_t   MagFilter = 0;
+    uint32_t   MipFilter = 0;
+    uint32_t   AddressU  = 0; // TextureAddressMode
+    uint32_t   AddressV  = 0;
+    uint32_t   AddressW  = 0;
+};
+
+} // namespace SceneFile
+} // namespace FauxRender
+
+#endif // FAUX_RENDER_SCENE_FILE_H
@@ -0,0 +1,216 @@
+#include "host_faux_render.h"
+
+namespace HostFauxRender
+{
+
+bool Buffer::Map(void** ppData)
+{
+    if (!this->Mappable || IsNull(ppData))
+    {
+        return false;
+    }
+
+    *ppData = this->Data.data();
+
+    return true;
+}
+
+void Buffer::Unmap()
+{
+}
+
+// =============================================================================
+// SceneGraph
+// =============================================================================
+SceneGraph::SceneGraph(bool initializeDefaults)
+{
+    if (initializeDefaults)
+    {
+        this->InitializeDefaults();
+    }
+}
+
+bool SceneGraph::CreateTemporaryBuffer(
+    uint32_t             size,
+    const void*          pData,
+    bool                 mappable,
+    FauxRender::Buffer** ppBuffer)
+{
+    if ((size == 0) || IsNull(ppBuffer))
+    {
+        return false;
+    }
+
+    auto pBuffer = new HostFauxRender::Buffer();
+    if (IsNull(pBuffer))
+    {
+        return false;
+    }
+
+    pBuffer->Size     = size;
+    pBuffer->Mappable = mappable;
+    pBuffer->Data.resize(size);
+    if (!IsNull(pData))
+    {
+        memcpy(pBuffer->Data.data(), pData, size);
+    }
+
+    //
+    // Don't add buffer to SceneGraph::Buffers since it's temporary
+    //
+
+    *ppBuffer = pBuffer;
+
+    return true;
+}
+
+void SceneGraph::DestroyTemporaryBuffer(
+    FauxRender::Buffer** ppBuffer)
+{
+    if (IsNull(ppBuffer))
+    {
+        return;
+    }
+
+    delete Cast(*ppBuffer);
+    *ppBuffer = nullptr;
+}
+
+bool SceneGraph::CreateBuffer(
+    uint32_t             bufferSize,
+    uint32_t             srcSize,
+    const void*          pSrcData,
+    bool                 mappable,
+    FauxRender::Buffer** ppBuffer)
+{
+    if (IsNull(ppBuffer) || (srcSize > bufferSize))
+    {
+        return false;
+    }
+
+    // Allocate buffer container
+    auto pBuffer = new HostFauxRender::Buffer();
+    if (IsNull(pBuffer))
+    {
+        return false;
+    }
+
+    // Update buffer container
+    pBuffer->Size     = bufferSize;
+    pBuffer->Mappable = mappable;
+    pBuffer->Data.resize(bufferSize);
+    if (!IsNull(pSrcData))
+    {
+        memcpy(pBuffer->Data.data(), pSrcData, srcSize);
+    }
+
+    // Store buffer in the graph
+    this->Buffers.push_back(std::unique_ptr<FauxRender::Buffer>(pBuffer));
+
+    // Write output pointer
+    *ppBuffer = pBuffer;
+
+    return true;
+}
+
+bool SceneGraph::CreateBuffer(
+    FauxRender::Buffer*  pSrcBuffer,
+    bool                 mappable,
+    FauxRender::Buffer** ppBuffer)
+{
+    if (IsNull(pSrcBuffer) || IsNull(ppBuffer))
+    {
+        return false;
+    }
+
+    auto pSrcHostBuffer = Cast(pSrcBuffer);
+
+    return this->CreateBuffer(
+        pSrcHostBuffer->Size,
+        pSrcHostBuffer->Size,
+        pSrcHostBuffer->Data.data(),
+        mappable,
+        ppBuffer);
+}
+
+bool SceneGraph::CreateImage(
+    const BitmapRGBA8u* pBitmap,
+    FauxRender::Image** ppImage)
+{
+    if (IsNull(pBitmap) || IsNull(ppImage))
+    {
+        return false;
+    }
+
+    std::vector<MipOffset> mipOffsets = {
+        MipOffset{0, pBitmap->GetRowStride()}
+    };
+
+    return this->CreateImage(
+        pBitmap->GetWidth(),
+        pBitmap->GetHeight(),
+        GREX_FORMAT_R8G8B8A8_UNORM,
+        mipOffsets,
+        pBitmap->GetSizeInBytes(),
+        pBitmap->GetPixels(),
+        ppImage);
+}
+
+bool SceneGraph::CreateImage(
+    uint32_t                      width,
+    uint32_t                      height,
+    GREXFormat                    format,
+    const std::vector<MipOffset>& mipOffsets,
+    size_t                        srcImageDataSize,
+    const void*                   pSrcImageData,
+    FauxRender::Image**           ppImage)
+{
+    if (mipOffsets.empty() || (srcImageDataSize == 0) || IsNull(pSrcImageData) || IsNull(ppImage))
+    {
+        return false;
+    }
+
+    // Allocate image container
+    auto pImage = new HostFauxRender::Image();
+    if (IsNull(pImage))
+    {
+        return false;
+    }
+
+    // Update image container
+    pImage->Width      = width;
+    pImage->Height     = height;
+    pImage->Depth      = 1;
+    pImage->Format     = format;
+    pImage->NumLevels  = CountU32(mipOffsets);
+    pImage->NumLayers  = 1;
+    pImage->MipOffsets = mipOffsets;
+    pImage->Data.assign(static_cast<const char*>(pSrcImageData), static_cast<const char*>(pSrcImageData) + srcImageDataSize);
+
+    // Store image in the graph
+    if (!this->AddImage(pImage))
+    {
+        delete pImage;
+        return false;
+    }
+
+    // Write output pointer
+    *ppImage = pImage;
+
+    return true;
+}
+
+// =============================================================================
+// Functions
+// =============================================================================
+HostFauxRender::Buffer* Cast(FauxRender::Buffer* pBuffer)
+{
+    return static_cast<HostFauxRender::Buffer*>(pBuffer);
+}
+
+HostFauxRender::Image* Cast(FauxRender::Image* pImage)
+{
+    return static_cast<HostFauxRender::Image*>(pImage);
+}
+
+} // namespace HostFauxRender
@@ -0,0 +1,76 @@
+#ifndef HOST_FAUX_RENDER_H
+#define HOST_FAUX_RENDER_H
+
+#include "faux_render.h"
+
+//
+// A FauxRender backend that keeps buffers and images in host memory. It
+// doesn't need a graphics API, so it's used by offline tools and to
+// exercise the graph's CPU side bookkeeping.
+//
+namespace HostFauxRender
+{
+
+struct Buffer
+    : public FauxRender::Buffer
+{
+    std::vector<char> Data;
+
+    virtual bool Map(void** ppData) override;
+    virtual void Unmap() override;
+};
+
+struct Image
+    : public FauxRender::Image
+{
+    std::vector<char>      Data;
+    std::vector<MipOffset> MipOffsets;
+};
+
+struct SceneGraph : public FauxRender::SceneGraph
+{
+    // Offline tools that write out the graph don't want the default
+    // images and samplers in it.
+    SceneGraph(bool initializeDefaults = true);
+
+    virtual bool CreateTemporaryBuffer(
+        uint32_t             size,
+        const void*          pData,
+        bool                 mappable,
+        FauxRender::Buffer** ppBuffer) override;
+
+    virtual void DestroyTemporaryBuffer(
+        FauxRender::Buffer** ppBuffer) override;
+
+    virtual bool CreateBuffer(
+        uint32_t             bufferSize,
+        uint32_t             srcSize,
+        const void*          pSrcData,
+        bool                 mappable,
+        FauxRender::Buffer** ppBuffer) override;
+
+    virtual bool CreateBuffer(
+        FauxRender::Buffer*  pSrcBuffer,
+        bool                 mappable,
+        FauxRender::Buffer** ppBuffer) override;
+
+    virtual bool CreateImage(
+        const BitmapRGBA8u* pBitmap,
+        FauxRender::Image** ppImage) override;
+
+    virtual bool CreateImage(
+        uint32_t                      width,
+        uint32_t                      height,
+        GREXFormat                    format,
+        const std::vector<MipOffset>& mipOffsets,
+        size_t                        srcImageDataSize,
+        const void*                   pSrcImageData,
+        FauxRender::Image**           ppImage) override;
+};
+
+HostFauxRender::Buffer* Cast(FauxRender::Buffer* pBuffer);
+HostFauxRender::Image*  Cast(FauxRender::Image* pImage);
+
+} // namespace HostFauxRender
+
+#endif // HOST_FAUX_RENDER_H
@@ -0,0 +1,379 @@
+#include "job_system.h"
+#include "profiler.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+namespace
+{
+
+// Pieces per thread when ParallelFor() picks the grain size
+const uint32_t kPiecesPerThread = 4;
+
+} // namespace
+
+// =============================================================================
+// JobSystem::Job
+// =============================================================================
+struct JobSystem::Job
+{
+    JobFn Fn;
+
+    // Dependencies that aren't done yet, plus one that Run() holds until
+    // it has registered with all of them
+    std::atomic<uint32_t> NumPending = 1;
+
+    std::atomic<bool>      Done = false;
+    std::mutex             Mutex; // Guards Dependents and setting Done
+    std::vector<JobHandle> Dependents;
+};
+
+// =============================================================================
+// JobSystem::Pool
+// =============================================================================
+//
+// Sleeping and waking: a thread about to sleep bumps its counter before
+// it checks NumQueued or Done, and a thread queueing or finishing a job
+// updates those before it checks the counters. One of the two always sees
+// the other, so nobody sleeps through work or through the job it waits on.
+//
+struct JobSystem::Pool
+{
+    struct Deque
+    {
+        std::mutex            Mutex;
+        std::deque<JobHandle> Jobs;
+    };
+
+    // One per worker, the last one is for threads outside the pool
+    std::vector<std::unique_ptr<Deque>> Deques;
+    std::vector<std::thread>            Workers;
+
+    std::atomic<uint32_t>   NumQueued   = 0;
+    std::atomic<uint32_t>   NumSleeping = 0; // Workers with nothing to do
+    std::atomic<uint32_t>   NumWaiting  = 0; // Threads blocked in Wait()
+    std::mutex              SleepMutex;
+    std::condition_variable WorkCondition;
+    std::condition_variable DoneCondition;
+    bool                    Stop = false; // Guarded by SleepMutex
+
+    // Set on the pool's own workers
+    static thread_local Pool*    sCurrentPool;
+    static thread_local uint32_t sCurrentWorker;
+
+    void Submit(const JobHandle& job)
+    {
+        Deque* pDeque = (sCurrentPool == this) ? this->Deques[sCurrentWorker].get() : this->Deques.back().get();
+        {
+            std::lock_guard<std::mutex> lock(pDeque->Mutex);
+            pDeque->Jobs.push_back(job);
+        }
+        ++this->NumQueued;
+
+        // Threads in Wait() help out, so they're woken too
+        if ((this->NumSleeping > 0) || (this->NumWaiting > 0))
+        {
+            std::lock_guard<std::mutex> lock(this->SleepMutex);
+            this->WorkCondition.notify_one();
+            this->DoneCondition.notify_all();
+        }
+    }
+
+    // Own deque from the back, then the others from the front
+    JobHandle FindJob()
+    {
+        if (this->NumQueued == 0)
+        {
+            return nullptr;
+        }
+
+        const uint32_t numDeques = CountU32(this->Deques);
+        const bool     isWorker  = (sCurrentPool == this);
+        const uint32_t first     = isWorker ? sCurrentWorker : (numDeques - 1);
+
+        for (uint32_t i = 0; i < numDeques; ++i)
+        {
+            Deque&                      deque = *this->Deques[(first + i) % numDeques];
+            std::lock_guard<std::mutex> lock(deque.Mutex);
+            if (deque.Jobs.empty())
+            {
+                continue;
+            }
+
+            JobHandle job;
+            if ((i == 0) && isWorker)
+            {
+                job = std::move(deque.Jobs.back());
+                deque.Jobs.pop_back();
+            }
+            else
+            {
+                job = std::move(deque.Jobs.front());
+                deque.Jobs.pop_front();
+            }
+            --this->NumQueued;
+
+            return job;
+        }
+
+        return nullptr;
+    }
+
+    void Execute(const JobHandle& job)
+    {
+        if (job->Fn)
+        {
+            job->Fn();
+        }
+        // Let go of whatever the function captured
+        job->Fn = nullptr;
+
+        std::vector<JobHandle> dependents;
+        {
+            std::lock_guard<std::mutex> lock(job->Mutex);
+            job->Done = true;
+            dependents.swap(job->Dependents);
+        }
+
+        for (auto& dependent : dependents)
+        {
+            if (--dependent->NumPending == 0)
+            {
+                Submit(dependent);
+            }
+        }
+
+        if (this->NumWaiting > 0)
+        {
+            std::lock_guard<std::mutex> lock(this->SleepMutex);
+            this->DoneCondition.notify_all();
+        }
+    }
+
+    void WorkerMain(uint32_t workerIndex)
+    {
+        sCurrentPool   = this;
+        sCurrentWorker = workerIndex;
+
+        GREX_PROFILE_THREAD_NAME("JobSystem worker " + std::to_string(workerIndex));
+
+        while (true)
+        {
+            JobHandle job = FindJob();
+            if (job)
+            {
+                Execute(job);
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(this->SleepMutex);
+            ++this->NumSleeping;
+            this->WorkCondition.wait(lock, [this]() { return this->Stop || (this->NumQueued > 0); });
+            --this->NumSleeping;
+
+            if (this->Stop)
+            {
+                break;
+            }
+        }
+
+        sCurrentPool = nullptr;
+    }
+
+    void WaitUntilDone(const JobHandle& job)
+    {
+        while (!job->Done)
+        {
+            JobHandle other = FindJob();
+            if (other)
+            {
+                Execute(other);
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(this->SleepMutex);
+            ++this->NumWaiting;
+            this->DoneCondition.wait(lock, [this, &job]() { return job->Done || (this->NumQueued > 0); });
+            --this->NumWaiting;
+        }
+    }
+};
+
+thread_local JobSystem::Pool* JobSystem::Pool::sCurrentPool   = nullptr;
+thread_local uint32_t         JobSystem::Pool::sCurrentWorker = 0;
+
+// =============================================================================
+// JobSystem
+// =============================================================================
+JobSystem::JobSystem(uint32_t numWorkers)
+    : mPool(std::make_unique<Pool>())
+{
+    if (numWorkers == 0)
+    {
+        numWorkers = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+    }
+
+    for (uint32_t i = 0; i <= numWorkers; ++i)
+    {
+        mPool->Deques.push_back(std::make_unique<Pool::Deque>());
+    }
+    for (uint32_t i = 0; i < numWorkers; ++i)
+    {
+        mPool->Workers.emplace_back(&Pool::WorkerMain, mPool.get(), i);
+    }
+}
+
+JobSystem::~JobSystem()
+{
+    {
+        std::lock_guard<std::mutex> lock(mPool->SleepMutex);
+        mPool->Stop = true;
+        mPool->WorkCondition.notify_all();
+    }
+
+    for (auto& worker : mPool->Workers)
+    {
+        worker.join();
+    }
+}
+
+JobSystem& JobSystem::Get()
+{
+    static JobSystem sJobSystem;
+    return sJobSystem;
+}
+
+uint32_t JobSystem::GetNumThreads() const
+{
+    return CountU32(mPool->Workers) + 1;
+}
+
+JobSystem::JobHandle JobSystem::Run(JobFn fn, std::initializer_list<JobHandle> dependencies)
+{
+    return Run(std::move(fn), std::vector<JobHandle>(dependencies));
+}
+
+JobSystem::JobHandle JobSystem::Run(JobFn fn, const std::vector<JobHandle>& dependencies)
+{
+    auto job = std::make_shared<Job>();
+    job->Fn  = std::move(fn);
+
+    for (auto& dependency : dependencies)
+    {
+        if (!dependency)
+        {
+            continue;
+        }
+
+        std::lock_guard<std::mutex> lock(dependency->Mutex);
+        if (!dependency->Done)
+        {
+            ++job->NumPending;
+            dependency->Dependents.push_back(job);
+        }
+    }
+
+    // Otherwise the last dependency to finish queues it
+    if (--job->NumPending == 0)
+    {
+        mPool->Submit(job);
+    }
+
+    return job;
+}
+
+bool JobSystem::IsDone(const JobHandle& job) const
+{
+    return !job || job->Done;
+}
+
+void JobSystem::Wait(const JobHandle& job)
+{
+    if (job)
+    {
+        mPool->WaitUntilDone(job);
+    }
+}
+
+void JobSystem::Wait(const std::vector<JobHandle>& jobs)
+{
+    for (auto& job : jobs)
+    {
+        Wait(job);
+    }
+}
+
+void JobSystem::ParallelFor(uint32_t begin, uint32_t end, uint32_t grainSize, const RangeFn& fn, uint32_t maxThreads)
+{
+    if (end <= begin)
+    {
+        return;
+    }
+
+    const uint32_t count = end - begin;
+
+    uint32_t numThreads = GetNumThreads();
+    if (maxThreads > 0)
+    {
+        numThreads = std::min(numThreads, maxThreads);
+    }
+    if (grainSize == 0)
+    {
+        grainSize = std::max(count / (numThreads * kPiecesPerThread), 1u);
+    }
+
+    const uint32_t numPieces = count / grainSize + ((count % grainSize) != 0 ? 1 : 0);
+    numThreads               = std::min(numThreads, numPieces);
+
+    // Helpers that start after the pieces have run out return right away
+    std::atomic<uint32_t> nextPiece = 0;
+
+    auto runPieces = [&]() {
+        for (uint32_t piece = nextPiece++; piece < numPieces; piece = nextPiece++)
+        {
+            const uint32_t pieceBegin = begin + piece * grainSize;
+            fn(pieceBegin, pieceBegin + std::min(grainSize, end - pieceBegin));
+        }
+    };
+
+    std::vector<JobHandle> helpers;
+    for (uint32_t i = 1; i < numThreads; ++i)
+    {
+        helpers.push_back(Run(runPieces));
+    }
+    runPieces();
+
+    Wait(helpers);
+}
+
+void JobSystem::ParallelFor2D(
+    uint32_t      width,
+    uint32_t      height,
+    uint32_t      tileWidth,
+    uint32_t      tileHeight,
+    const TileFn& fn,
+    uint32_t      maxThreads)
+{
+    tileWidth  = std::max(tileWidth, 1u);
+    tileHeight = std::max(tileHeight, 1u);
+
+    const uint32_t numTilesX = (width + tileWidth - 1) / tileWidth;
+    const uint32_t numTilesY = (height + tileHeight - 1) / tileHeight;
+
+    ParallelFor(
+        0,
+        numTilesX * numTilesY,
+        1,
+        [&](uint32_t begin, uint32_t end) {
+            for (uint32_t tile = begin; tile < end; ++tile)
+            {
+                const uint32_t x0 = (tile % numTilesX) * tileWidth;
+                const uint32_t y0 = (tile / numTilesX) * tileHeight;
+                fn(x0, y0, std::min(x0 + tileWidth, width), std::min(y0 + tileHeight, height));
+            }
+        },
+        maxThreads);
+}
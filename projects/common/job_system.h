@@ -0,0 +1,90 @@
+#pragma once
+
+#include "config.h"
+
+#include <functional>
+#include <initializer_list>
+
+//
+// Work stealing job system
+//
+// One fixed pool of worker threads for the whole process, so the tools,
+// TriMesh processing and the glTF loader can split work across threads
+// without each of them starting a thread per core of their own.
+//
+// Every worker owns a deque. Jobs a worker submits go on the back of its
+// own deque and it pops from the back, so it stays on recent, cache warm
+// work. Workers that run dry steal from the front of the other deques,
+// which holds the oldest and usually biggest pieces of work. Jobs from
+// threads outside the pool go to one more deque that every worker steals
+// from. Deques are mostly touched by their owner, so each one has its own
+// mutex rather than being lock free.
+//
+// A thread waiting on a job runs queued jobs until it's done, so jobs can
+// submit and wait on more jobs, and ParallelFor() can be nested, without
+// starving the pool. Workers sleep when there is nothing to run.
+//
+//   JobSystem& jobSystem = JobSystem::Get();
+//
+//   auto load  = jobSystem.Run([&]() { ... });
+//   auto build = jobSystem.Run([&]() { ... }, {load}); // Starts once load is done
+//   jobSystem.Wait(build);
+//
+//   jobSystem.ParallelFor(0, height, 1, [&](uint32_t begin, uint32_t end) { ... });
+//
+class JobSystem
+{
+public:
+    struct Job;
+    using JobHandle = std::shared_ptr<Job>;
+
+    using JobFn   = std::function<void()>;
+    using RangeFn = std::function<void(uint32_t begin, uint32_t end)>;
+    using TileFn  = std::function<void(uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1)>;
+
+    // 0 starts one worker less than there are hardware threads, the
+    // waiting thread makes up the last one. There's always at least one.
+    explicit JobSystem(uint32_t numWorkers = 0);
+
+    // Jobs that haven't started yet are dropped, wait on them first
+    ~JobSystem();
+
+    // Shared pool, started on first use
+    static JobSystem& Get();
+
+    // Workers plus the thread that waits
+    uint32_t GetNumThreads() const;
+
+    // Queues fn to run once every job in dependencies is done. Null
+    // dependencies are ignored.
+    JobHandle Run(JobFn fn, std::initializer_list<JobHandle> dependencies = {});
+    JobHandle Run(JobFn fn, const std::vector<JobHandle>& dependencies);
+
+    bool IsDone(const JobHandle& job) const;
+
+    // Runs other jobs until the job, or every job, is done
+    void Wait(const JobHandle& job);
+    void Wait(const std::vector<JobHandle>& jobs);
+
+    //
+    // Calls fn on consecutive pieces of [begin, end), at most grainSize
+    // items each, from up to maxThreads threads counting the caller, and
+    // returns once every piece is done. grainSize 0 gives every thread a
+    // few pieces to balance uneven work, maxThreads 0 uses the whole pool.
+    //
+    void ParallelFor(uint32_t begin, uint32_t end, uint32_t grainSize, const RangeFn& fn, uint32_t maxThreads = 0);
+
+    // Same over a width x height grid, one tile per piece. x1 and y1 are exclusive.
+    void ParallelFor2D(
+        uint32_t      width,
+        uint32_t      height,
+        uint32_t      tileWidth,
+        uint32_t      tileHeight,
+        const TileFn& fn,
+        uint32_t      maxThreads = 0);
+
+private:
+    struct Pool;
+
+    std::unique_ptr<Pool> mPool;
+};
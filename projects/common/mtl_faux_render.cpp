@@ -212,6 +212,12 @@ bool SceneGraph::CreateImage(
         return false;
     }
 
+    // Fail before the resource is created if there's no slot for the image
+    if (this->IsImageTableFull())
+    {
+        return false;
+    }
+
     // Create the buffer resource
     MetalTexture resource;
     //
@@ -245,7 +251,11 @@ bool SceneGraph::CreateImage(
     pImage->Resource  = resource;
 
     // Store image in the graph
-    this->Images.push_back(std::move(std::unique_ptr<FauxRender::Image>(pImage)));
+    if (!this->AddImage(pImage))
+    {
+        delete pImage;
+        return false;
+    }
 
     // Write output pointer
     *ppImage = pImage;
@@ -267,6 +277,12 @@ bool SceneGraph::CreateImage(
         return false;
     }
 
+    // Fail before the resource is created if there's no slot for the image
+    if (this->IsImageTableFull())
+    {
+        return false;
+    }
+
     auto mtlFormat = ToMTLFormat(format);
     if (mtlFormat == MTL::PixelFormatInvalid)
     {
@@ -307,7 +323,11 @@ bool SceneGraph::CreateImage(
     pImage->Resource  = resource;
 
     // Store image in the graph
-    this->Images.push_back(std::move(std::unique_ptr<FauxRender::Image>(pImage)));
+    if (!this->AddImage(pImage))
+    {
+        delete pImage;
+        return false;
+    }
 
     // Write output pointer
     *ppImage = pImage;
@@ -338,7 +358,12 @@ bool CalculateVertexStrides(FauxRender::Scene* pScene, std::vector<uint32>& vert
 
     for (auto pGeometryNode : pScene->GeometryNodes)
     {
-        assert((pGeometryNode != nullptr) && "pGeometryNode is NULL");
+        // Freed instance slot
+        if (IsNull(pGeometryNode))
+        {
+            continue;
+        }
+
         assert((pGeometryNode->Type == FauxRender::SCENE_NODE_TYPE_GEOMETRY) && "node is not of drawable type");
 
         const FauxRender::Mesh* pMesh           = pGeometryNode->pMesh;
@@ -400,11 +425,112 @@ bool CalculateVertexStrides(FauxRender::Scene* pScene, std::vector<uint32>& vert
     }
 }
 
+static void BindBatch(const MtlFauxRender::Buffer* pBuffer, const FauxRender::PrimitiveBatch& batch, MTL::RenderCommandEncoder* pRenderEncoder)
+{
+    // Vertex buffers
+    {
+        MTL::Buffer* bufferViews[GREX_MAX_VERTEX_ATTRIBUTES]   = {};
+        NS::UInteger bufferOffsets[GREX_MAX_VERTEX_ATTRIBUTES] = {};
+
+        // Position
+        {
+           assert(batch.PositionBufferView.Format != GREX_FORMAT_UNKNOWN);
+           bufferViews[kPositionIndex]   = pBuffer->Resource.Buffer.get();
+           bufferOffsets[kPositionIndex] = batch.PositionBufferView.Offset;
+        }
+
+        // Tex Coord
+        {
+            bufferViews[kTexCoordIndex]   = pBuffer->Resource.Buffer.get();
+
+            bufferOffsets[kTexCoordIndex] = batch.TexCoordBufferView.Format != GREX_FORMAT_UNKNOWN
+              ? batch.TexCoordBufferView.Offset
+              : batch.PositionBufferView.Offset;
+        }
+
+        //  Normal
+        {
+            bufferViews[kNormalIndex]   = pBuffer->Resource.Buffer.get();
+
+            bufferOffsets[kNormalIndex] = batch.NormalBufferView.Format != GREX_FORMAT_UNKNOWN
+              ? batch.NormalBufferView.Offset
+              : batch.PositionBufferView.Offset;
+        }
+
+        //  Tangent
+        {
+            bufferViews[kTangentIndex]   = pBuffer->Resource.Buffer.get();
+            bufferOffsets[kTangentIndex] = batch.TangentBufferView.Format != GREX_FORMAT_UNKNOWN
+              ? batch.TangentBufferView.Offset
+              : batch.PositionBufferView.Offset;
+        }
+
+        pRenderEncoder->setVertexBuffers(bufferViews, bufferOffsets, NS::Range::Make(0, 4));
+    }
+}
+
+static void SetDrawParams(const FauxRender::SceneGraph* pGraph, uint32_t instanceIndex, uint32_t materialIndex, MTL::RenderCommandEncoder* pRenderEncoder)
+{
+    // Need struct with padding for Metal, make sure we changes this if the original changes
+    assert(sizeof(FauxRender::Shader::DrawParams) == 8 && "DrawParams struct changed, please change the AlignedDrawParams version as well");
+
+    struct AlignedDrawParams
+    {
+        uint32_t InstanceIndex;
+        uint32_t MaterialIndex;
+        uint32_t _padding0[2];
+    };
+
+    AlignedDrawParams drawParams = {};
+    drawParams.InstanceIndex     = instanceIndex;
+    drawParams.MaterialIndex     = materialIndex;
+    assert((drawParams.InstanceIndex != UINT32_MAX) && "drawParams.InstanceIndex is invalid");
+    assert((drawParams.MaterialIndex != UINT32_MAX) && "drawParams.MaterialIndex is invalid");
+
+    uint32_t index = static_cast<const MtlFauxRender::SceneGraph*>(pGraph)->RootParameterIndices.Draw;
+    pRenderEncoder->setVertexBytes(&drawParams, sizeof(AlignedDrawParams), index);
+    pRenderEncoder->setFragmentBytes(&drawParams, sizeof(AlignedDrawParams), index);
+}
+
+static void BindSceneResources(const FauxRender::SceneGraph* pGraph, const FauxRender::Scene* pScene, FauxRender::Buffer* pInstanceBuffer, MTL::RenderCommandEncoder* pRenderEncoder)
+{
+    // Set camera
+    {
+        auto&    resource = MtlFauxRender::Cast(pScene->pCameraArgs)->Resource;
+        uint32_t index    = static_cast<const MtlFauxRender::SceneGraph*>(pGraph)->RootParameterIndices.Camera;
+        pRenderEncoder->setVertexBuffer(resource.Buffer.get(), 0, index);
+        pRenderEncoder->setFragmentBuffer(resource.Buffer.get(), 0, index);
+    }
+
+    // Set instance buffer
+    {
+        auto&    resource = MtlFauxRender::Cast(pInstanceBuffer)->Resource;
+        uint32_t index    = static_cast<const MtlFauxRender::SceneGraph*>(pGraph)->RootParameterIndices.InstanceBuffer;
+        pRenderEncoder->setVertexBuffer(resource.Buffer.get(), 0, index);
+        pRenderEncoder->setFragmentBuffer(resource.Buffer.get(), 0, index);
+    }
+
+    // Set material buffer
+    {
+        auto&    resource = MtlFauxRender::Cast(pGraph->pMaterialBuffer)->Resource;
+        uint32_t index    = static_cast<const MtlFauxRender::SceneGraph*>(pGraph)->RootParameterIndices.MaterialBuffer;
+        pRenderEncoder->setVertexBuffer(resource.Buffer.get(), 0, index);
+        pRenderEncoder->setFragmentBuffer(resource.Buffer.get(), 0, index);
+    }
+}
+
 void Draw(const FauxRender::SceneGraph* pGraph, uint32_t instanceIndex, const FauxRender::Mesh* pMesh, MTL::RenderCommandEncoder* pRenderEncoder)
 {
     assert((pMesh != nullptr) && "pMesh is NULL");
 
-    const MtlFauxRender::Buffer* pBuffer = MtlFauxRender::Cast(pMesh->pBuffer);
+    Draw(pGraph, instanceIndex, pMesh, pMesh->pBuffer, pRenderEncoder);
+}
+
+void Draw(const FauxRender::SceneGraph* pGraph, uint32_t instanceIndex, const FauxRender::Mesh* pMesh, FauxRender::Buffer* pMeshBuffer, MTL::RenderCommandEncoder* pRenderEncoder)
+{
+    assert((pMesh != nullptr) && "pMesh is NULL");
+
+    const MtlFauxRender::Buffer* pBuffer = MtlFauxRender::Cast(pMeshBuffer);
     assert((pBuffer != nullptr) && "mesh's buffer is NULL");
 
     const size_t numBatches = pMesh->DrawBatches.size();
@@ -419,68 +545,10 @@ void Draw(const FauxRender::SceneGraph* pGraph, uint32_t instanceIndex, const Fa
         }
 
         // Vertex buffers
-        {
-            MTL::Buffer* bufferViews[GREX_MAX_VERTEX_ATTRIBUTES]   = {};
-            NS::UInteger bufferOffsets[GREX_MAX_VERTEX_ATTRIBUTES] = {};
-
-            // Position
-            {
-               assert(batch.PositionBufferView.Format != GREX_FORMAT_UNKNOWN);
-               bufferViews[kPositionIndex]   = pBuffer->Resource.Buffer.get();
-               bufferOffsets[kPositionIndex] = batch.PositionBufferView.Offset;
-            }
-
-            // Tex Coord
-            {
-                bufferViews[kTexCoordIndex]   = pBuffer->Resource.Buffer.get();
-
-                bufferOffsets[kTexCoordIndex] = batch.TexCoordBufferView.Format != GREX_FORMAT_UNKNOWN
-                  ? batch.TexCoordBufferView.Offset
-                  : batch.PositionBufferView.Offset;
-            }
-
-            //  Normal
-            {
-                bufferViews[kNormalIndex]   = pBuffer->Resource.Buffer.get();
-
-                bufferOffsets[kNormalIndex] = batch.NormalBufferView.Format != GREX_FORMAT_UNKNOWN
-                  ? batch.NormalBufferView.Offset
-                  : batch.PositionBufferView.Offset;
-            }
-
-            //  Tangent
-            {
-                bufferViews[kTangentIndex]   = pBuffer->Resource.Buffer.get();
-                bufferOffsets[kTangentIndex] = batch.TangentBufferView.Format != GREX_FORMAT_UNKNOWN
-                  ? batch.TangentBufferView.Offset
-                  : batch.PositionBufferView.Offset;
-            }
-
-            pRenderEncoder->setVertexBuffers(bufferViews, bufferOffsets, NS::Range::Make(0, 4));
-        }
+        BindBatch(pBuffer, batch, pRenderEncoder);
 
         // Draw root constants
-        {
-            // Need struct with padding for Metal, make sure we changes this if the original changes
-            assert(sizeof(FauxRender::Shader::DrawParams) == 8 && "DrawParams struct changed, please change the AlignedDrawParams version as well");
-
-            struct AlignedDrawParams
-            {
-                uint32_t InstanceIndex;
-                uint32_t MaterialIndex;
-                uint32_t _padding0[2];
-            };
-
-            AlignedDrawParams drawParams = {};
-            drawParams.InstanceIndex     = instanceIndex;
-            drawParams.MaterialIndex     = pGraph->GetMaterialIndex(batch.pMaterial);
-            assert((drawParams.InstanceIndex != UINT32_MAX) && "drawParams.InstanceIndex is invalid");
-            assert((drawParams.MaterialIndex != UINT32_MAX) && "drawParams.MaterialIndex is invalid");
-
-            uint32_t index = static_cast<const MtlFauxRender::SceneGraph*>(pGraph)->RootParameterIndices.Draw;
-            pRenderEncoder->setVertexBytes(&drawParams, sizeof(AlignedDrawParams), index);
-            pRenderEncoder->setFragmentBytes(&drawParams, sizeof(AlignedDrawParams), index);
-        }
+        SetDrawParams(pGraph, instanceIndex, pGraph->GetMaterialIndex(batch.pMaterial), pRenderEncoder);
 
         // Draw
         pRenderEncoder->drawIndexedPrimitives(
@@ -501,40 +569,90 @@ void Draw(const FauxRender::SceneGraph* pGraph, const FauxRender::Scene* pScene,
     uint32_t instanceIndex = pScene->GetGeometryNodeIndex(pGeometryNode);
     assert((instanceIndex != UINT32_MAX) && "instanceIndex is invalid");
 
-    Draw(pGraph, instanceIndex, pGeometryNode->pMesh, pRenderEncoder);
+    Draw(pGraph, instanceIndex, pGeometryNode->pMesh, pGeometryNode->GetDrawBuffer(), pRenderEncoder);
 }
 
 void Draw(const FauxRender::SceneGraph* pGraph, const FauxRender::Scene* pScene, MTL::RenderCommandEncoder* pRenderEncoder)
 {
     assert((pScene != nullptr) && "pScene is NULL");
 
-    // Set camera
+    BindSceneResources(pGraph, pScene, pScene->pInstanceBuffer, pRenderEncoder);
+
+    for (auto pGeometryNode : pScene->GeometryNodes)
     {
-        auto&    resource = MtlFauxRender::Cast(pScene->pCameraArgs)->Resource;
-        uint32_t index    = static_cast<const MtlFauxRender::SceneGraph*>(pGraph)->RootParameterIndices.Camera;
-        pRenderEncoder->setVertexBuffer(resource.Buffer.get(), 0, index);
-        pRenderEncoder->setFragmentBuffer(resource.Buffer.get(), 0, index);
+        // Freed instance slot
+        if (IsNull(pGeometryNode))
+        {
+            continue;
+        }
+
+        Draw(pGraph, pScene, pGeometryNode, pRenderEncoder);
     }
+}
 
-    // Set instance buffer
+void Draw(const FauxRender::SceneGraph* pGraph, const FauxRender::Scene* pScene, const FauxRender::VisibleList* pVisibleList, MTL::RenderCommandEncoder* pRenderEncoder)
+{
+    assert((pScene != nullptr) && "pScene is NULL");
+    assert((pVisibleList != nullptr) && "pVisibleList is NULL");
+
+    BindSceneResources(pGraph, pScene, pScene->pInstanceBuffer, pRenderEncoder);
+
+    for (auto instanceIndex : pVisibleList->InstanceIndices)
     {
-        auto&    resource = MtlFauxRender::Cast(pScene->pInstanceBuffer)->Resource;
-        uint32_t index    = static_cast<const MtlFauxRender::SceneGraph*>(pGraph)->RootParameterIndices.InstanceBuffer;
-        pRenderEncoder->setVertexBuffer(resource.Buffer.get(), 0, index);
-        pRenderEncoder->setFragmentBuffer(resource.Buffer.get(), 0, index);
+        auto pGeometryNode = pScene->GeometryNodes[instanceIndex];
+        Draw(pGraph, instanceIndex, pGeometryNode->pMesh, pGeometryNode->GetDrawBuffer(), pRenderEncoder);
     }
+}
 
-    // Set material buffer
+void Draw(const FauxRender::SceneGraph* pGraph, const FauxRender::Scene* pScene, const FauxRender::DrawList* pDrawList, MTL::RenderCommandEncoder* pRenderEncoder)
+{
+    assert((pScene != nullptr) && "pScene is NULL");
+    assert((pDrawList != nullptr) && "pDrawList is NULL");
+
+    if (pDrawList->Draws.empty())
     {
-        auto&    resource = MtlFauxRender::Cast(pGraph->pMaterialBuffer)->Resource;
-        uint32_t index    = static_cast<const MtlFauxRender::SceneGraph*>(pGraph)->RootParameterIndices.MaterialBuffer;
-        pRenderEncoder->setVertexBuffer(resource.Buffer.get(), 0, index);
-        pRenderEncoder->setFragmentBuffer(resource.Buffer.get(), 0, index);
+        return;
     }
 
-    for (auto pGeometryNode : pScene->GeometryNodes)
+    BindSceneResources(pGraph, pScene, pDrawList->pInstanceBuffer, pRenderEncoder);
+
+    const MtlFauxRender::Buffer* pArgsBuffer = IsNull(pDrawList->pIndirectArgsBuffer) ? nullptr : MtlFauxRender::Cast(pDrawList->pIndirectArgsBuffer);
+
+    for (size_t drawIdx = 0; drawIdx < pDrawList->Draws.size(); ++drawIdx)
     {
-        Draw(pGraph, pScene, pGeometryNode, pRenderEncoder);
+        const auto& draw  = pDrawList->Draws[drawIdx];
+        const auto& batch = draw.pMesh->DrawBatches[draw.BatchIndex];
+
+        const MtlFauxRender::Buffer* pBuffer = MtlFauxRender::Cast(draw.pBuffer);
+        assert((pBuffer != nullptr) && "mesh's buffer is NULL");
+
+        // Vertex buffers
+        BindBatch(pBuffer, batch, pRenderEncoder);
+
+        // Instances for this draw start at FirstInstance in the draw list's instance buffer
+        SetDrawParams(pGraph, draw.FirstInstance, draw.MaterialIndex, pRenderEncoder);
+
+        // Draw
+        if (!IsNull(pArgsBuffer))
+        {
+            pRenderEncoder->drawIndexedPrimitives(
+                /* primitiveType        */ MTL::PrimitiveType::PrimitiveTypeTriangle,
+                /* indexType            */ ToMTLIndexType(batch.IndexBufferView.Format),
+                /* indexBuffer          */ pBuffer->Resource.Buffer.get(),
+                /* indexBufferOffset    */ batch.IndexBufferView.Offset,
+                /* indirectBuffer       */ pArgsBuffer->Resource.Buffer.get(),
+                /* indirectBufferOffset */ drawIdx * sizeof(FauxRender::Shader::DrawIndexedIndirectArgs));
+        }
+        else
+        {
+            pRenderEncoder->drawIndexedPrimitives(
+                /* primitiveType        */ MTL::PrimitiveType::PrimitiveTypeTriangle,
+                /* indexCount           */ batch.IndexBufferView.Count,
+                /* indexType            */ ToMTLIndexType(batch.IndexBufferView.Format),
+                /* indexBuffer          */ pBuffer->Resource.Buffer.get(),
+                /* indexBufferOffset    */ batch.IndexBufferView.Offset,
+                /* instanceCount        */ draw.InstanceCount);
+        }
     }
 }
 
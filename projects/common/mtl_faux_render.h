@@ -84,8 +84,11 @@ MtlFauxRender::Image*  Cast(FauxRender::Image* pImage);
 bool CalculateVertexStrides(FauxRender::Scene* pScene, std::vector<uint32> &vertexStrides);
 
 void Draw(const FauxRender::SceneGraph* pGraph, uint32_t instanceIndex, const FauxRender::Mesh* pMesh, MTL::RenderCommandEncoder* pRenderEncoder);
+void Draw(const FauxRender::SceneGraph* pGraph, uint32_t instanceIndex, const FauxRender::Mesh* pMesh, FauxRender::Buffer* pMeshBuffer, MTL::RenderCommandEncoder* pRenderEncoder);
 void Draw(const FauxRender::SceneGraph* pGraph, const FauxRender::Scene* pScene, const FauxRender::SceneNode* pGeometryNode, MTL::RenderCommandEncoder* pRenderEncoder);
 void Draw(const FauxRender::SceneGraph* pGraph, const FauxRender::Scene* pScene, MTL::RenderCommandEncoder* pRenderEncoder);
+void Draw(const FauxRender::SceneGraph* pGraph, const FauxRender::Scene* pScene, const FauxRender::DrawList* pDrawList, MTL::RenderCommandEncoder* pRenderEncoder);
+void Draw(const FauxRender::SceneGraph* pGraph, const FauxRender::Scene* pScene, const FauxRender::VisibleList* pVisibleList, MTL::RenderCommandEncoder* pRenderEncoder);
 
 } // namespace MtlFauxRender
 
@@ -179,6 +179,24 @@ MTL::PixelFormat ToMTLFormat(
         case GREX_FORMAT_BC7_RGBA:
             return MTL::PixelFormatBC7_RGBAUnorm;
 
+        case GREX_FORMAT_R8G8_SNORM:
+            return MTL::PixelFormatRG8Snorm;
+
+        case GREX_FORMAT_R8G8B8A8_SNORM:
+            return MTL::PixelFormatRGBA8Snorm;
+
+        case GREX_FORMAT_R16G16_UNORM:
+            return MTL::PixelFormatRG16Unorm;
+
+        case GREX_FORMAT_R16G16_SNORM:
+            return MTL::PixelFormatRG16Snorm;
+
+        case GREX_FORMAT_R16G16B16A16_UNORM:
+            return MTL::PixelFormatRGBA16Unorm;
+
+        case GREX_FORMAT_R16G16B16A16_SNORM:
+            return MTL::PixelFormatRGBA16Snorm;
+
         case GREX_FORMAT_R32G32B32_FLOAT: // Undefined in MTL::PixelFormat
         default:
             return MTL::PixelFormatInvalid;
@@ -307,14 +325,8 @@ NS::Error* CreateTexture(
         auto        region  = MTL::Region::Make2D(0, 0, mipWidth, mipHeight);
         const void* mipData = reinterpret_cast<const char*>(pSrcData) + mipOffset.Offset;
 
-        uint32_t mipRowStride = mipOffset.RowStride;
-        if (IsCompressed(format))
-        {
-            mipRowStride = mipWidth * 4;
-            mipRowStride = (mipRowStride > 16) ? mipRowStride : 16;
-        }
-
-        pResource->Texture->replaceRegion(region, mipIndex, mipData, mipRowStride);
+        // For compressed formats RowStride is the pitch of a row of 4x4 blocks
+        pResource->Texture->replaceRegion(region, mipIndex, mipData, mipOffset.RowStride);
 
         mipWidth >>= 1;
         mipHeight >>= 1;
@@ -0,0 +1,577 @@
+#include "occlusion_culler.h"
+
+#include <chrono>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define OCCLUSION_CULLER_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+
+using Clock = std::chrono::high_resolution_clock;
+
+double ElapsedUs(const Clock::time_point& start)
+{
+    return std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+}
+
+// Bit per frustum plane the clip space position is outside of
+uint32_t GetOutcode(const glm::vec4& p)
+{
+    uint32_t outcode = 0;
+    outcode |= (p.z < 0) ? 0x01 : 0;
+    outcode |= (p.z > p.w) ? 0x02 : 0;
+    outcode |= (p.x < -p.w) ? 0x04 : 0;
+    outcode |= (p.x > p.w) ? 0x08 : 0;
+    outcode |= (p.y < -p.w) ? 0x10 : 0;
+    outcode |= (p.y > p.w) ? 0x20 : 0;
+    return outcode;
+}
+
+// Point on ab where z = 0, a and b on opposite sides
+glm::vec4 ClipToNearPlane(const glm::vec4& a, const glm::vec4& b)
+{
+    const float t = a.z / (a.z - b.z);
+    return a + t * (b - a);
+}
+
+#if defined(OCCLUSION_CULLER_SSE2)
+float HorizontalMin4(__m128 v)
+{
+    v = _mm_min_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1)));
+    v = _mm_min_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 3, 2)));
+    return _mm_cvtss_f32(v);
+}
+
+float HorizontalMax4(__m128 v)
+{
+    v = _mm_max_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1)));
+    v = _mm_max_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 3, 2)));
+    return _mm_cvtss_f32(v);
+}
+
+// True if both halves of the comparison are set in every lane
+bool AllSet8(__m128 lo, __m128 hi)
+{
+    return (_mm_movemask_ps(_mm_and_ps(lo, hi)) == 0xF);
+}
+#endif
+
+//
+// Projects the 8 corners of the sphere's box. The outcode bits are set for
+// the planes every corner is outside of. Returns false if a corner is in
+// front of the near plane, the NDC bounds are only written otherwise.
+//
+// Corners are the clip space center plus or minus the view projection
+// matrix's first three columns scaled by the radius. The SSE2 version does corners 0-3 and 4-7
+// in one register each.
+//
+bool ProjectSphereBox(
+    const glm::mat4& viewProjectionMatrix,
+    const glm::vec4& clipCenter,
+    float            radius,
+    uint32_t*        pOutcodeAnd,
+    glm::vec3*       pNdcMin,
+    glm::vec3*       pNdcMax)
+{
+    const glm::vec4 axisX = viewProjectionMatrix[0] * radius;
+    const glm::vec4 axisY = viewProjectionMatrix[1] * radius;
+    const glm::vec4 axisZ = viewProjectionMatrix[2] * radius;
+
+#if defined(OCCLUSION_CULLER_SSE2)
+    const __m128 signX = _mm_setr_ps(-1.0f, 1.0f, -1.0f, 1.0f);
+    const __m128 signY = _mm_setr_ps(-1.0f, -1.0f, 1.0f, 1.0f);
+
+    // x, y, z, w of corners 0-3, then 4-7
+    __m128 lo[4];
+    __m128 hi[4];
+    for (int i = 0; i < 4; ++i)
+    {
+        const __m128 base = _mm_add_ps(
+            _mm_set1_ps(clipCenter[i]),
+            _mm_add_ps(_mm_mul_ps(signX, _mm_set1_ps(axisX[i])), _mm_mul_ps(signY, _mm_set1_ps(axisY[i]))));
+        lo[i] = _mm_sub_ps(base, _mm_set1_ps(axisZ[i]));
+        hi[i] = _mm_add_ps(base, _mm_set1_ps(axisZ[i]));
+    }
+
+    const __m128 zero   = _mm_setzero_ps();
+    const __m128 negWLo = _mm_sub_ps(zero, lo[3]);
+    const __m128 negWHi = _mm_sub_ps(zero, hi[3]);
+
+    uint32_t outcodeAnd = 0;
+    outcodeAnd |= AllSet8(_mm_cmplt_ps(lo[2], zero), _mm_cmplt_ps(hi[2], zero)) ? 0x01 : 0;
+    outcodeAnd |= AllSet8(_mm_cmpgt_ps(lo[2], lo[3]), _mm_cmpgt_ps(hi[2], hi[3])) ? 0x02 : 0;
+    outcodeAnd |= AllSet8(_mm_cmplt_ps(lo[0], negWLo), _mm_cmplt_ps(hi[0], negWHi)) ? 0x04 : 0;
+    outcodeAnd |= AllSet8(_mm_cmpgt_ps(lo[0], lo[3]), _mm_cmpgt_ps(hi[0], hi[3])) ? 0x08 : 0;
+    outcodeAnd |= AllSet8(_mm_cmplt_ps(lo[1], negWLo), _mm_cmplt_ps(hi[1], negWHi)) ? 0x10 : 0;
+    outcodeAnd |= AllSet8(_mm_cmpgt_ps(lo[1], lo[3]), _mm_cmpgt_ps(hi[1], hi[3])) ? 0x20 : 0;
+    *pOutcodeAnd = outcodeAnd;
+
+    // Written as not (z >= 0 and w > 0) so NaNs count as in front
+    const __m128 inFront = _mm_and_ps(
+        _mm_and_ps(_mm_cmpge_ps(lo[2], zero), _mm_cmpgt_ps(lo[3], zero)),
+        _mm_and_ps(_mm_cmpge_ps(hi[2], zero), _mm_cmpgt_ps(hi[3], zero)));
+    if (_mm_movemask_ps(inFront) != 0xF)
+    {
+        return false;
+    }
+
+    const __m128 invWLo = _mm_div_ps(_mm_set1_ps(1.0f), lo[3]);
+    const __m128 invWHi = _mm_div_ps(_mm_set1_ps(1.0f), hi[3]);
+    for (int i = 0; i < 3; ++i)
+    {
+        const __m128 ndcLo = _mm_mul_ps(lo[i], invWLo);
+        const __m128 ndcHi = _mm_mul_ps(hi[i], invWHi);
+        (*pNdcMin)[i]      = HorizontalMin4(_mm_min_ps(ndcLo, ndcHi));
+        (*pNdcMax)[i]      = HorizontalMax4(_mm_max_ps(ndcLo, ndcHi));
+    }
+    return true;
+#else
+    uint32_t  outcodeAnd    = 0x3F;
+    bool      inFrontOfNear = true;
+    glm::vec3 ndcMin        = glm::vec3(FLT_MAX);
+    glm::vec3 ndcMax        = glm::vec3(-FLT_MAX);
+    for (uint32_t i = 0; i < 8; ++i)
+    {
+        const glm::vec4 corner = clipCenter + ((i & 1) ? axisX : -axisX) + ((i & 2) ? axisY : -axisY) + ((i & 4) ? axisZ : -axisZ);
+
+        outcodeAnd &= GetOutcode(corner);
+        if (!(corner.z >= 0) || !(corner.w > 0))
+        {
+            inFrontOfNear = false;
+            continue;
+        }
+
+        const glm::vec3 ndc = glm::vec3(corner) / corner.w;
+        ndcMin              = glm::min(ndcMin, ndc);
+        ndcMax              = glm::max(ndcMax, ndc);
+    }
+
+    *pOutcodeAnd = outcodeAnd;
+    if (inFrontOfNear)
+    {
+        *pNdcMin = ndcMin;
+        *pNdcMax = ndcMax;
+    }
+    return inFrontOfNear;
+#endif
+}
+
+} // namespace
+
+// =============================================================================
+// OcclusionCuller
+// =============================================================================
+OcclusionCuller::OcclusionCuller(uint32_t width, uint32_t height)
+{
+    mWidth  = (std::max(width, 1u) + 3) & ~3u;
+    mHeight = std::max(height, 1u);
+
+    // Halve down to 1x1, odd sizes round up
+    size_t   offset      = 0;
+    uint32_t levelWidth  = mWidth;
+    uint32_t levelHeight = mHeight;
+    while (true)
+    {
+        mLevels.push_back({levelWidth, levelHeight, offset});
+        offset += static_cast<size_t>(levelWidth) * levelHeight;
+
+        if ((levelWidth == 1) && (levelHeight == 1))
+        {
+            break;
+        }
+        levelWidth  = (levelWidth + 1) / 2;
+        levelHeight = (levelHeight + 1) / 2;
+    }
+
+    mDepth.resize(offset, 1.0f);
+}
+
+OcclusionCuller::~OcclusionCuller()
+{
+}
+
+void OcclusionCuller::BeginFrame(const glm::mat4& viewProjectionMatrix)
+{
+    mViewProjectionMatrix = viewProjectionMatrix;
+    mStats                = {};
+
+    std::fill(mDepth.begin(), mDepth.end(), 1.0f);
+}
+
+void OcclusionCuller::AddOccluder(const TriMesh& mesh, const glm::mat4& modelMatrix)
+{
+    AddOccluder(
+        DataPtr(mesh.GetPositions()),
+        mesh.GetNumVertices(),
+        reinterpret_cast<const uint32_t*>(DataPtr(mesh.GetTriangles())),
+        mesh.GetNumIndices(),
+        modelMatrix);
+}
+
+void OcclusionCuller::AddOccluder(
+    const glm::vec3* pPositions,
+    uint32_t         numPositions,
+    const uint32_t*  pIndices,
+    uint32_t         numIndices,
+    const glm::mat4& modelMatrix)
+{
+    if (IsNull(pPositions) || IsNull(pIndices))
+    {
+        return;
+    }
+
+    auto startTime = Clock::now();
+
+    // Occluders are indexed, transform every vertex once
+    const glm::mat4 mvpMatrix = mViewProjectionMatrix * modelMatrix;
+
+    mClipPositions.resize(numPositions);
+    for (uint32_t i = 0; i < numPositions; ++i)
+    {
+        mClipPositions[i] = mvpMatrix * glm::vec4(pPositions[i], 1);
+    }
+
+    const uint32_t numTriangles = numIndices / 3;
+    for (uint32_t i = 0; i < numTriangles; ++i)
+    {
+        const glm::vec4& v0 = mClipPositions[pIndices[3 * i + 0]];
+        const glm::vec4& v1 = mClipPositions[pIndices[3 * i + 1]];
+        const glm::vec4& v2 = mClipPositions[pIndices[3 * i + 2]];
+
+        if ((GetOutcode(v0) & GetOutcode(v1) & GetOutcode(v2)) != 0)
+        {
+            continue;
+        }
+
+        // Only the near plane needs clipping, x and y are clamped to the buffer
+        const bool in0 = (v0.z >= 0);
+        const bool in1 = (v1.z >= 0);
+        const bool in2 = (v2.z >= 0);
+        if (in0 && in1 && in2)
+        {
+            RasterizeTriangle(v0, v1, v2);
+            continue;
+        }
+
+        // Rotate so the vertices keep their winding and the odd one out is first
+        const glm::vec4* pVertices[3] = {&v0, &v1, &v2};
+        const bool       inside[3]    = {in0, in1, in2};
+        const uint32_t   numInside    = in0 + in1 + in2;
+
+        uint32_t first = 0;
+        while (inside[first] != (numInside == 1))
+        {
+            ++first;
+        }
+        const glm::vec4& a = *pVertices[first];
+        const glm::vec4& b = *pVertices[(first + 1) % 3];
+        const glm::vec4& c = *pVertices[(first + 2) % 3];
+
+        if (numInside == 1)
+        {
+            RasterizeTriangle(a, ClipToNearPlane(a, b), ClipToNearPlane(a, c));
+        }
+        else
+        {
+            const glm::vec4 ab = ClipToNearPlane(a, b);
+            const glm::vec4 ca = ClipToNearPlane(c, a);
+            RasterizeTriangle(ab, b, c);
+            RasterizeTriangle(ab, c, ca);
+        }
+    }
+
+    mStats.NumOccluderTriangles += numTriangles;
+    mStats.RasterizeUs += ElapsedUs(startTime);
+}
+
+//
+// Depth only, nearest wins. Pixel centers inside all three edges, no fill
+// rule since covering a shared edge twice writes the same depth.
+//
+void OcclusionCuller::RasterizeTriangle(const glm::vec4& v0, const glm::vec4& v1, const glm::vec4& v2)
+{
+    if (!(v0.w > 0) || !(v1.w > 0) || !(v2.w > 0))
+    {
+        return;
+    }
+
+    const float width  = static_cast<float>(mWidth);
+    const float height = static_cast<float>(mHeight);
+
+    // Screen space, NDC +Y is up and row 0 is the top
+    float x[3];
+    float y[3];
+    float z[3];
+    {
+        const glm::vec4* pVertices[3] = {&v0, &v1, &v2};
+        for (uint32_t i = 0; i < 3; ++i)
+        {
+            const glm::vec4& p    = *pVertices[i];
+            const float      invW = 1.0f / p.w;
+            x[i]                  = (p.x * invW * 0.5f + 0.5f) * width;
+            y[i]                  = (0.5f - p.y * invW * 0.5f) * height;
+            z[i]                  = std::min(p.z * invW, 1.0f);
+        }
+    }
+
+    // Counter clockwise in NDC is clockwise once Y points down, only those are front facing
+    const float area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+    if (!(area < 0))
+    {
+        return;
+    }
+    std::swap(x[1], x[2]);
+    std::swap(y[1], y[2]);
+    std::swap(z[1], z[2]);
+
+    // Pixels whose centers fall inside the bounds
+    const float minX = std::min(std::min(x[0], x[1]), x[2]);
+    const float minY = std::min(std::min(y[0], y[1]), y[2]);
+    const float maxX = std::max(std::max(x[0], x[1]), x[2]);
+    const float maxY = std::max(std::max(y[0], y[1]), y[2]);
+
+    const int32_t x0 = static_cast<int32_t>(std::max(std::ceil(minX - 0.5f), 0.0f));
+    const int32_t y0 = static_cast<int32_t>(std::max(std::ceil(minY - 0.5f), 0.0f));
+    const int32_t x1 = static_cast<int32_t>(std::min(std::floor(maxX - 0.5f), width - 1.0f));
+    const int32_t y1 = static_cast<int32_t>(std::min(std::floor(maxY - 0.5f), height - 1.0f));
+    if ((x0 > x1) || (y0 > y1))
+    {
+        return;
+    }
+
+    // Edge i is opposite vertex i: E(px, py) = A * px + B * py + C, positive inside
+    float edgeA[3];
+    float edgeB[3];
+    float edgeC[3];
+    for (uint32_t i = 0; i < 3; ++i)
+    {
+        const uint32_t a = (i + 1) % 3;
+        const uint32_t b = (i + 2) % 3;
+        edgeA[i]         = -(y[b] - y[a]);
+        edgeB[i]         = x[b] - x[a];
+        edgeC[i]         = (y[b] - y[a]) * x[a] - (x[b] - x[a]) * y[a];
+    }
+
+    // Depth is linear in screen space: z0 + l1 * (z1 - z0) + l2 * (z2 - z0), l = E / area
+    const float invArea = -1.0f / area;
+    const float zA      = (edgeA[1] * (z[1] - z[0]) + edgeA[2] * (z[2] - z[0])) * invArea;
+    const float zB      = (edgeB[1] * (z[1] - z[0]) + edgeB[2] * (z[2] - z[0])) * invArea;
+    const float zC      = z[0] + (edgeC[1] * (z[1] - z[0]) + edgeC[2] * (z[2] - z[0])) * invArea;
+
+#if defined(OCCLUSION_CULLER_SSE2)
+    // Groups of 4 start on multiples of 4, the width is one too
+    const int32_t xStart = x0 & ~3;
+
+    const __m128 laneX = _mm_add_ps(_mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f), _mm_set1_ps(static_cast<float>(xStart) + 0.5f));
+    __m128       edgeSteps[3];
+    for (uint32_t i = 0; i < 3; ++i)
+    {
+        edgeSteps[i] = _mm_set1_ps(4.0f * edgeA[i]);
+    }
+    const __m128 zStep = _mm_set1_ps(4.0f * zA);
+    const __m128 xMin  = _mm_set1_ps(static_cast<float>(x0));
+    const __m128 xMax  = _mm_set1_ps(static_cast<float>(x1) + 1.0f);
+#endif
+
+    for (int32_t py = y0; py <= y1; ++py)
+    {
+        const float cy     = static_cast<float>(py) + 0.5f;
+        float*      pDepth = DataPtr(mDepth) + static_cast<size_t>(py) * mWidth;
+
+#if defined(OCCLUSION_CULLER_SSE2)
+        __m128 e0 = _mm_add_ps(_mm_mul_ps(laneX, _mm_set1_ps(edgeA[0])), _mm_set1_ps(edgeB[0] * cy + edgeC[0]));
+        __m128 e1 = _mm_add_ps(_mm_mul_ps(laneX, _mm_set1_ps(edgeA[1])), _mm_set1_ps(edgeB[1] * cy + edgeC[1]));
+        __m128 e2 = _mm_add_ps(_mm_mul_ps(laneX, _mm_set1_ps(edgeA[2])), _mm_set1_ps(edgeB[2] * cy + edgeC[2]));
+        __m128 zs = _mm_add_ps(_mm_mul_ps(laneX, _mm_set1_ps(zA)), _mm_set1_ps(zB * cy + zC));
+        __m128 cx = laneX;
+
+        for (int32_t px = xStart; px <= x1; px += 4)
+        {
+            // Lanes outside [x0, x1] may be past the buffer's edge on either side of the triangle's bounds
+            __m128 inside = _mm_and_ps(_mm_cmpge_ps(cx, xMin), _mm_cmplt_ps(cx, xMax));
+            inside        = _mm_and_ps(inside, _mm_cmpge_ps(e0, _mm_setzero_ps()));
+            inside        = _mm_and_ps(inside, _mm_cmpge_ps(e1, _mm_setzero_ps()));
+            inside        = _mm_and_ps(inside, _mm_cmpge_ps(e2, _mm_setzero_ps()));
+
+            const __m128 depth  = _mm_loadu_ps(pDepth + px);
+            const __m128 nearer = _mm_min_ps(depth, zs);
+            _mm_storeu_ps(pDepth + px, _mm_or_ps(_mm_and_ps(inside, nearer), _mm_andnot_ps(inside, depth)));
+
+            e0 = _mm_add_ps(e0, edgeSteps[0]);
+            e1 = _mm_add_ps(e1, edgeSteps[1]);
+            e2 = _mm_add_ps(e2, edgeSteps[2]);
+            zs = _mm_add_ps(zs, zStep);
+            cx = _mm_add_ps(cx, _mm_set1_ps(4.0f));
+        }
+#else
+        for (int32_t px = x0; px <= x1; ++px)
+        {
+            const float cx = static_cast<float>(px) + 0.5f;
+            const float e0 = edgeA[0] * cx + edgeB[0] * cy + edgeC[0];
+            const float e1 = edgeA[1] * cx + edgeB[1] * cy + edgeC[1];
+            const float e2 = edgeA[2] * cx + edgeB[2] * cy + edgeC[2];
+            if ((e0 >= 0) && (e1 >= 0) && (e2 >= 0))
+            {
+                pDepth[px] = std::min(pDepth[px], zA * cx + zB * cy + zC);
+            }
+        }
+#endif
+    }
+
+    ++mStats.NumRasterizedTriangles;
+}
+
+void OcclusionCuller::BuildHiZ()
+{
+    auto startTime = Clock::now();
+
+    for (size_t levelIndex = 1; levelIndex < mLevels.size(); ++levelIndex)
+    {
+        const Level& src = mLevels[levelIndex - 1];
+        const Level& dst = mLevels[levelIndex];
+
+        const float* pSrc = DataPtr(mDepth) + src.Offset;
+        float*       pDst = DataPtr(mDepth) + dst.Offset;
+
+        // Farthest of each 2x2, the last row and column repeat on odd sizes
+        for (uint32_t y = 0; y < dst.Height; ++y)
+        {
+            const float* pRow0 = pSrc + static_cast<size_t>(2 * y) * src.Width;
+            const float* pRow1 = pSrc + static_cast<size_t>(std::min(2 * y + 1, src.Height - 1)) * src.Width;
+            for (uint32_t x = 0; x < dst.Width; ++x)
+            {
+                const uint32_t x0 = 2 * x;
+                const uint32_t x1 = std::min(2 * x + 1, src.Width - 1);
+
+                pDst[y * dst.Width + x] = std::max(std::max(pRow0[x0], pRow0[x1]), std::max(pRow1[x0], pRow1[x1]));
+            }
+        }
+    }
+
+    mStats.BuildHiZUs += ElapsedUs(startTime);
+}
+
+OcclusionCuller::CullResult OcclusionCuller::TestClipSphere(const glm::vec4& clipCenter, float radius) const
+{
+    uint32_t  outcodeAnd = 0;
+    glm::vec3 ndcMin     = glm::vec3(0);
+    glm::vec3 ndcMax     = glm::vec3(0);
+
+    const bool inFrontOfNear = ProjectSphereBox(mViewProjectionMatrix, clipCenter, radius, &outcodeAnd, &ndcMin, &ndcMax);
+    if (outcodeAnd != 0)
+    {
+        return CULL_RESULT_FRUSTUM_CULLED;
+    }
+    if (!inFrontOfNear)
+    {
+        return CULL_RESULT_VISIBLE;
+    }
+
+    // Parts outside the frustum don't matter
+    ndcMin = glm::max(ndcMin, glm::vec3(-1));
+    ndcMax = glm::min(ndcMax, glm::vec3(1));
+
+    // Texels under the screen rectangle, row 0 is the top. Everything is
+    // positive after the clamp above, so truncating is the same as floor.
+    const float   width  = static_cast<float>(mWidth);
+    const float   height = static_cast<float>(mHeight);
+    const int32_t maxX   = static_cast<int32_t>(mWidth) - 1;
+    const int32_t maxY   = static_cast<int32_t>(mHeight) - 1;
+
+    const int32_t x0 = std::min(static_cast<int32_t>((ndcMin.x * 0.5f + 0.5f) * width), maxX);
+    const int32_t x1 = std::min(static_cast<int32_t>((ndcMax.x * 0.5f + 0.5f) * width), maxX);
+    const int32_t y0 = std::min(static_cast<int32_t>((0.5f - ndcMax.y * 0.5f) * height), maxY);
+    const int32_t y1 = std::min(static_cast<int32_t>((0.5f - ndcMin.y * 0.5f) * height), maxY);
+
+    // First level where the rectangle is at most 2x2 texels
+    uint32_t level = 0;
+    while ((((x1 >> level) - (x0 >> level)) > 1) || (((y1 >> level) - (y0 >> level)) > 1))
+    {
+        ++level;
+    }
+
+    const Level& hiz    = mLevels[level];
+    const float* pDepth = DataPtr(mDepth) + hiz.Offset;
+
+    float farthest = 0;
+    for (int32_t y = (y0 >> level); y <= (y1 >> level); ++y)
+    {
+        for (int32_t x = (x0 >> level); x <= (x1 >> level); ++x)
+        {
+            farthest = std::max(farthest, pDepth[y * hiz.Width + x]);
+        }
+    }
+
+    return (ndcMin.z > farthest) ? CULL_RESULT_OCCLUDED : CULL_RESULT_VISIBLE;
+}
+
+OcclusionCuller::CullResult OcclusionCuller::TestSphere(const glm::vec3& center, float radius)
+{
+    // Not timed, reading the clock costs about as much as the test
+    const CullResult result = TestClipSphere(mViewProjectionMatrix * glm::vec4(center, 1), radius);
+
+    ++mStats.NumTested;
+    mStats.NumFrustumCulled += (result == CULL_RESULT_FRUSTUM_CULLED) ? 1 : 0;
+    mStats.NumOccluded += (result == CULL_RESULT_OCCLUDED) ? 1 : 0;
+
+    return result;
+}
+
+uint32_t OcclusionCuller::TestSpheres(const glm::vec4* pSpheres, uint32_t count, const glm::mat4& modelMatrix, uint32_t* pVisibleIndices)
+{
+    if (IsNull(pSpheres) || IsNull(pVisibleIndices))
+    {
+        return 0;
+    }
+
+    auto startTime = Clock::now();
+
+    const float scale = std::sqrt(std::max({
+        glm::dot(glm::vec3(modelMatrix[0]), glm::vec3(modelMatrix[0])),
+        glm::dot(glm::vec3(modelMatrix[1]), glm::vec3(modelMatrix[1])),
+        glm::dot(glm::vec3(modelMatrix[2]), glm::vec3(modelMatrix[2])),
+    }));
+
+    // Centers go straight to clip space, the box axes stay world space
+    const glm::mat4 modelViewProjectionMatrix = mViewProjectionMatrix * modelMatrix;
+
+    uint32_t numVisible = 0;
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        const glm::vec4  clipCenter = modelViewProjectionMatrix * glm::vec4(glm::vec3(pSpheres[i]), 1);
+        const CullResult result     = TestClipSphere(clipCenter, pSpheres[i].w * scale);
+
+        mStats.NumFrustumCulled += (result == CULL_RESULT_FRUSTUM_CULLED) ? 1 : 0;
+        mStats.NumOccluded += (result == CULL_RESULT_OCCLUDED) ? 1 : 0;
+        if (result == CULL_RESULT_VISIBLE)
+        {
+            pVisibleIndices[numVisible++] = i;
+        }
+    }
+
+    mStats.NumTested += count;
+    mStats.TestUs += ElapsedUs(startTime);
+
+    return numVisible;
+}
+
+const float* OcclusionCuller::GetLevel(uint32_t level, uint32_t* pWidth, uint32_t* pHeight) const
+{
+    if (level >= mLevels.size())
+    {
+        return nullptr;
+    }
+
+    if (!IsNull(pWidth))
+    {
+        *pWidth = mLevels[level].Width;
+    }
+    if (!IsNull(pHeight))
+    {
+        *pHeight = mLevels[level].Height;
+    }
+    return DataPtr(mDepth) + mLevels[level].Offset;
+}
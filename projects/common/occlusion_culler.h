@@ -0,0 +1,120 @@
+#pragma once
+
+#include "config.h"
+#include "tri_mesh.h"
+
+#include <glm/glm.hpp>
+
+//
+// Software occlusion culling
+//
+// Rasterizes a handful of low poly occluders into a small depth buffer on
+// the CPU, builds a hierarchical Z pyramid from it and tests bounding
+// spheres against the pyramid, so instances and meshlets hidden behind
+// the occluders are never handed to the GPU.
+//
+// Per frame:
+//
+//   BeginFrame(viewProjectionMatrix)
+//   AddOccluder(...)  for every occluder, nearest first works best
+//   BuildHiZ()
+//   TestSphere(...) / TestSpheres(...)
+//
+// Clip space and depth follow the samples: triangles are clipped to
+// z >= 0, depth is z / w with 1 as the far value, counter clockwise
+// triangles are front facing and back faces are skipped, so occluders
+// should be closed meshes.
+//
+// The depth buffer is rasterized 4 pixels at a time with SSE2 (scalar
+// fallback otherwise) at pixel centers. Each HiZ texel keeps the farthest
+// depth under it. A sphere is occluded if the nearest point of its box
+// is behind the farthest depth of the 2x2 texels that cover its screen
+// rectangle at the level where that rectangle is at most 2 texels wide.
+// Spheres reaching in front of the near plane are always visible.
+//
+// Occluder triangles only count at the pixel centers they cover, so an
+// object can be culled when it shows only through the uncovered part of
+// a pixel. At the default 256x128 that's well under a pixel on screen,
+// same trade off as other CPU occlusion cullers. Occluders must not be
+// larger than what they stand in for.
+//
+class OcclusionCuller
+{
+public:
+    enum CullResult
+    {
+        CULL_RESULT_VISIBLE        = 0,
+        CULL_RESULT_FRUSTUM_CULLED = 1,
+        CULL_RESULT_OCCLUDED       = 2,
+    };
+
+    struct Stats
+    {
+        uint32_t NumOccluderTriangles   = 0; // Passed to AddOccluder()
+        uint32_t NumRasterizedTriangles = 0; // Left after clipping and culling
+        uint64_t NumTested              = 0;
+        uint64_t NumFrustumCulled       = 0;
+        uint64_t NumOccluded            = 0;
+        double   RasterizeUs            = 0;
+        double   BuildHiZUs             = 0;
+        double   TestUs                 = 0; // TestSpheres() only
+    };
+
+    // Width is rounded up to a multiple of 4
+    OcclusionCuller(uint32_t width = 256, uint32_t height = 128);
+    ~OcclusionCuller();
+
+    // Clears the depth buffer and the stats
+    void BeginFrame(const glm::mat4& viewProjectionMatrix);
+
+    void AddOccluder(const TriMesh& mesh, const glm::mat4& modelMatrix);
+    void AddOccluder(
+        const glm::vec3* pPositions,
+        uint32_t         numPositions,
+        const uint32_t*  pIndices,
+        uint32_t         numIndices,
+        const glm::mat4& modelMatrix);
+
+    void BuildHiZ();
+
+    // World space sphere, use TestSpheres() for more than a few
+    CullResult TestSphere(const glm::vec3& center, float radius);
+
+    //
+    // Object space spheres, xyz = center and w = radius, placed by
+    // modelMatrix. Radii are scaled by the largest axis scale. Writes the
+    // index of every visible sphere to pVisibleIndices, which has room for
+    // count entries, and returns how many there are.
+    //
+    uint32_t TestSpheres(const glm::vec4* pSpheres, uint32_t count, const glm::mat4& modelMatrix, uint32_t* pVisibleIndices);
+
+    const Stats& GetStats() const { return mStats; }
+
+    uint32_t GetWidth() const { return mWidth; }
+    uint32_t GetHeight() const { return mHeight; }
+    uint32_t GetNumLevels() const { return CountU32(mLevels); }
+
+    // Level 0 is the depth buffer, row 0 is the top
+    const float* GetLevel(uint32_t level, uint32_t* pWidth, uint32_t* pHeight) const;
+
+private:
+    struct Level
+    {
+        uint32_t Width  = 0;
+        uint32_t Height = 0;
+        size_t   Offset = 0;
+    };
+
+    void RasterizeTriangle(const glm::vec4& v0, const glm::vec4& v1, const glm::vec4& v2);
+
+    CullResult TestClipSphere(const glm::vec4& clipCenter, float radius) const;
+
+private:
+    uint32_t               mWidth                = 0;
+    uint32_t               mHeight               = 0;
+    glm::mat4              mViewProjectionMatrix = glm::mat4(1);
+    std::vector<Level>     mLevels;
+    std::vector<float>     mDepth; // Every level, level 0 first
+    std::vector<glm::vec4> mClipPositions;
+    Stats                  mStats = {};
+};
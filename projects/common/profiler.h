@@ -0,0 +1,368 @@
+#pragma once
+
+#include "config.h"
+
+//
+// CPU profiling scopes
+//
+//   void LoadThing()
+//   {
+//       GREX_PROFILE_FUNCTION();
+//       ...
+//       {
+//           GREX_PROFILE_SCOPE("Parse");
+//           ...
+//       }
+//   }
+//
+// Every scope records its start and end in nanoseconds. Events go into a
+// buffer owned by the recording thread, so recording never takes a lock:
+// the thread appends to its current block of events and publishes the new
+// count, readers only look at events below the published count. A thread
+// registers its buffer, under a mutex, the first time it records.
+//
+// Scope names must be string literals or otherwise outlive the process,
+// only the pointer is stored.
+//
+// The scopes compile to nothing unless GREX_ENABLE_PROFILER is defined,
+// which the GREX_ENABLE_PROFILER CMake option does for every project. With
+// it defined, a summary of the time spent per scope name is logged when
+// the process exits, and if the GREX_PROFILE_TRACE environment variable
+// names a file the events are written to it as Chrome trace event JSON.
+// Open it with chrome://tracing or https://ui.perfetto.dev. Call
+// WriteProfileTrace() to write one at a point of your choosing.
+//
+// Everything here is inline so projects pick it up without changes to
+// their source lists.
+//
+#if defined(GREX_ENABLE_PROFILER)
+#    include <atomic>
+#    include <chrono>
+#    include <cstdlib>
+#    include <iomanip>
+#    include <map>
+#    include <mutex>
+
+#    define GREX_PROFILE_CONCAT_INNER(A, B) A##B
+#    define GREX_PROFILE_CONCAT(A, B)       GREX_PROFILE_CONCAT_INNER(A, B)
+
+#    define GREX_PROFILE_SCOPE(NAME)       ProfileScope GREX_PROFILE_CONCAT(grex_profile_scope_, __LINE__)(NAME)
+#    define GREX_PROFILE_FUNCTION()        GREX_PROFILE_SCOPE(__func__)
+#    define GREX_PROFILE_THREAD_NAME(NAME) SetProfileThreadName(NAME)
+#else
+#    define GREX_PROFILE_SCOPE(NAME)       (void)0
+#    define GREX_PROFILE_FUNCTION()        (void)0
+#    define GREX_PROFILE_THREAD_NAME(NAME) (void)0
+#endif
+
+#if defined(GREX_ENABLE_PROFILER)
+
+struct ProfileEvent
+{
+    const char* pName   = nullptr;
+    uint64_t    StartNs = 0; // Since the first event in the process
+    uint64_t    EndNs   = 0;
+};
+
+namespace ProfilerInternal
+{
+
+const uint32_t kEventsPerBlock = 1024;
+
+struct EventBlock
+{
+    ProfileEvent             Events[kEventsPerBlock];
+    std::atomic<uint32_t>    Count = 0;       // Written by the owning thread only
+    std::atomic<EventBlock*> pNext = nullptr; // Same
+};
+
+struct ThreadBuffer
+{
+    uint32_t    ThreadIndex = 0;
+    std::string Name        = ""; // Guarded by State::Mutex
+    EventBlock* pFirst      = nullptr;
+    EventBlock* pLast       = nullptr; // Owning thread only
+};
+
+struct State
+{
+    std::chrono::steady_clock::time_point      Epoch = std::chrono::steady_clock::now();
+    std::mutex                                 Mutex; // Guards ThreadBuffers
+    std::vector<std::unique_ptr<ThreadBuffer>> ThreadBuffers;
+};
+
+inline void OnExit();
+
+//
+// Never destroyed, and neither are the event blocks: worker threads and
+// static destructors can still record while the process exits, and the
+// exit handler reads the events.
+//
+inline State& GetState()
+{
+    static State* sState = []() {
+        State* pState = new State();
+        std::atexit(OnExit);
+        return pState;
+    }();
+    return *sState;
+}
+
+inline uint64_t GetTimeNs()
+{
+    auto elapsed = std::chrono::steady_clock::now() - GetState().Epoch;
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+}
+
+inline ThreadBuffer* GetThreadBuffer()
+{
+    thread_local ThreadBuffer* tpBuffer = nullptr;
+    if (IsNull(tpBuffer))
+    {
+        State&      state  = GetState();
+        EventBlock* pBlock = new EventBlock();
+
+        std::lock_guard<std::mutex> lock(state.Mutex);
+        state.ThreadBuffers.push_back(std::make_unique<ThreadBuffer>());
+        tpBuffer              = state.ThreadBuffers.back().get();
+        tpBuffer->ThreadIndex = CountU32(state.ThreadBuffers) - 1;
+        tpBuffer->pFirst      = pBlock;
+        tpBuffer->pLast       = pBlock;
+    }
+    return tpBuffer;
+}
+
+inline void Record(const char* pName, uint64_t startNs, uint64_t endNs)
+{
+    ThreadBuffer* pBuffer = GetThreadBuffer();
+
+    EventBlock* pBlock = pBuffer->pLast;
+    uint32_t    count  = pBlock->Count.load(std::memory_order_relaxed);
+    if (count == kEventsPerBlock)
+    {
+        EventBlock* pNewBlock = new EventBlock();
+        pBlock->pNext.store(pNewBlock, std::memory_order_release);
+        pBuffer->pLast = pNewBlock;
+
+        pBlock = pNewBlock;
+        count  = 0;
+    }
+
+    pBlock->Events[count] = ProfileEvent{pName, startNs, endNs};
+    // Publishes the event to readers
+    pBlock->Count.store(count + 1, std::memory_order_release);
+}
+
+// Calls fn(threadIndex, threadName, event) for every event recorded so
+// far, one thread after the other
+template <typename Fn>
+void ForEachEvent(Fn fn)
+{
+    State& state = GetState();
+
+    std::lock_guard<std::mutex> lock(state.Mutex);
+    for (auto& pBuffer : state.ThreadBuffers)
+    {
+        for (EventBlock* pBlock = pBuffer->pFirst; !IsNull(pBlock); pBlock = pBlock->pNext.load(std::memory_order_acquire))
+        {
+            const uint32_t count = pBlock->Count.load(std::memory_order_acquire);
+            for (uint32_t i = 0; i < count; ++i)
+            {
+                fn(pBuffer->ThreadIndex, pBuffer->Name, pBlock->Events[i]);
+            }
+        }
+    }
+}
+
+inline void WriteJSONString(std::ostream& os, const std::string& s)
+{
+    os << '"';
+    for (char c : s)
+    {
+        if ((c == '"') || (c == '\\'))
+        {
+            os << '\\' << c;
+        }
+        else if (static_cast<unsigned char>(c) < 0x20)
+        {
+            os << ' ';
+        }
+        else
+        {
+            os << c;
+        }
+    }
+    os << '"';
+}
+
+// Trace timestamps are in microseconds, the fraction keeps the nanoseconds
+inline void WriteMicroseconds(std::ostream& os, uint64_t ns)
+{
+    os << (ns / 1000) << '.' << std::setw(3) << std::setfill('0') << (ns % 1000) << std::setfill(' ');
+}
+
+} // namespace ProfilerInternal
+
+class ProfileScope
+{
+public:
+    explicit ProfileScope(const char* pName)
+        : mName(pName),
+          mStartNs(ProfilerInternal::GetTimeNs())
+    {
+    }
+
+    ~ProfileScope()
+    {
+        ProfilerInternal::Record(mName, mStartNs, ProfilerInternal::GetTimeNs());
+    }
+
+    ProfileScope(const ProfileScope&)            = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    const char* mName    = nullptr;
+    uint64_t    mStartNs = 0;
+};
+
+// Shown for the calling thread in traces, "Thread <index>" otherwise
+inline void SetProfileThreadName(const std::string& name)
+{
+    auto  pBuffer = ProfilerInternal::GetThreadBuffer();
+    auto& state   = ProfilerInternal::GetState();
+
+    std::lock_guard<std::mutex> lock(state.Mutex);
+    pBuffer->Name = name;
+}
+
+//
+// Writes every event recorded so far as Chrome trace event JSON. Scopes
+// still open on other threads aren't in it. Safe to call while other
+// threads record.
+//
+inline bool WriteProfileTrace(const std::filesystem::path& path)
+{
+    std::ofstream os(path);
+    if (!os.is_open())
+    {
+        GREX_LOG_ERROR("failed to open profile trace file: " << path);
+        return false;
+    }
+
+    os << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+
+    bool     first          = true;
+    uint32_t namedThreadIdx = UINT32_MAX;
+    ProfilerInternal::ForEachEvent([&](uint32_t threadIndex, const std::string& threadName, const ProfileEvent& event) {
+        os << (first ? "\n" : ",\n");
+        first = false;
+
+        // Thread name before the thread's first event
+        if (threadIndex != namedThreadIdx)
+        {
+            os << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << threadIndex << ",\"args\":{\"name\":";
+            ProfilerInternal::WriteJSONString(os, threadName.empty() ? ("Thread " + std::to_string(threadIndex)) : threadName);
+            os << "}},\n";
+            namedThreadIdx = threadIndex;
+        }
+
+        os << "{\"name\":";
+        ProfilerInternal::WriteJSONString(os, event.pName);
+        os << ",\"cat\":\"grex\",\"ph\":\"X\",\"pid\":1,\"tid\":" << threadIndex << ",\"ts\":";
+        ProfilerInternal::WriteMicroseconds(os, event.StartNs);
+        os << ",\"dur\":";
+        ProfilerInternal::WriteMicroseconds(os, event.EndNs - event.StartNs);
+        os << "}";
+    });
+
+    os << "\n]}\n";
+
+    if (!os.good())
+    {
+        GREX_LOG_ERROR("failed to write profile trace file: " << path);
+        return false;
+    }
+
+    return true;
+}
+
+//
+// Logs call count, total and longest time per scope name, most total time
+// first. Times include nested scopes, and scopes that run on several
+// threads at once add up to more than the wall clock time.
+//
+inline void LogProfileSummary()
+{
+    struct Entry
+    {
+        std::string Name    = "";
+        uint64_t    Count   = 0;
+        uint64_t    TotalNs = 0;
+        uint64_t    MaxNs   = 0;
+    };
+
+    std::map<std::string, Entry> entries;
+    ProfilerInternal::ForEachEvent([&entries](uint32_t, const std::string&, const ProfileEvent& event) {
+        const uint64_t durationNs = event.EndNs - event.StartNs;
+
+        Entry& entry = entries[event.pName];
+        entry.Name   = event.pName;
+        entry.Count += 1;
+        entry.TotalNs += durationNs;
+        entry.MaxNs = std::max(entry.MaxNs, durationNs);
+    });
+
+    if (entries.empty())
+    {
+        return;
+    }
+
+    std::vector<Entry> sorted;
+    for (auto& iter : entries)
+    {
+        sorted.push_back(iter.second);
+    }
+    std::sort(sorted.begin(), sorted.end(), [](const Entry& a, const Entry& b) { return a.TotalNs > b.TotalNs; });
+
+    GREX_LOG_INFO("Profile summary (total ms / max ms / count):");
+    for (auto& entry : sorted)
+    {
+        GREX_LOG_INFO("  " << std::fixed << std::setprecision(3)
+                           << std::setw(12) << (entry.TotalNs / 1.0e6) << " "
+                           << std::setw(12) << (entry.MaxNs / 1.0e6) << " "
+                           << std::setw(8) << entry.Count << "  "
+                           << entry.Name);
+    }
+}
+
+inline void ProfilerInternal::OnExit()
+{
+    LogProfileSummary();
+
+    const char* pPath = std::getenv("GREX_PROFILE_TRACE");
+    if (!IsNull(pPath) && (pPath[0] != '\0'))
+    {
+        if (WriteProfileTrace(pPath))
+        {
+            GREX_LOG_INFO("Wrote profile trace: " << pPath);
+        }
+    }
+}
+
+#else
+
+inline void SetProfileThreadName(const std::string&)
+{
+}
+
+inline bool WriteProfileTrace(const std::filesystem::path& path)
+{
+    GREX_LOG_WARN("profiling is compiled out, build with GREX_ENABLE_PROFILER to write " << path);
+    return false;
+}
+
+inline void LogProfileSummary()
+{
+}
+
+#endif // defined(GREX_ENABLE_PROFILER)
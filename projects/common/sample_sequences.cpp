@@ -0,0 +1,676 @@
+#include "sample_sequences.h"
+
+#include <cmath>
+#include <numeric>
+
+namespace
+{
+
+const double kPi = 3.14159265358979323846;
+
+// Largest float below 1, so conversions from fixed point never return 1
+const float kOneMinusEpsilon = 0x1.fffffep-1f;
+
+// =============================================================================
+// Sobol direction numbers
+// =============================================================================
+
+//
+// Primitive polynomials and initial direction numbers for dimensions 1
+// and up, from Joe and Kuo's new-joe-kuo-6.21201. Degree, the polynomial's
+// interior coefficients as bits, then the first Degree direction numbers.
+// Dimension 0 is the van der Corput sequence and isn't listed.
+//
+struct SobolInitParams
+{
+    uint32_t Degree;
+    uint32_t Coefficients;
+    uint32_t M[6];
+};
+
+const SobolInitParams kSobolInitParams[kSobolMaxDimensions - 1] = {
+    {1, 0, {1}},
+    {2, 1, {1, 3}},
+    {3, 1, {1, 3, 1}},
+    {3, 2, {1, 1, 1}},
+    {4, 1, {1, 1, 3, 3}},
+    {4, 4, {1, 3, 5, 13}},
+    {5, 2, {1, 1, 5, 5, 17}},
+    {5, 4, {1, 1, 5, 5, 5}},
+    {5, 7, {1, 1, 7, 11, 19}},
+    {5, 11, {1, 1, 5, 1, 1}},
+    {5, 13, {1, 1, 1, 3, 11}},
+    {5, 14, {1, 3, 5, 5, 31}},
+    {6, 1, {1, 3, 3, 9, 7, 49}},
+    {6, 13, {1, 1, 1, 15, 21, 21}},
+    {6, 16, {1, 3, 1, 13, 27, 49}},
+};
+
+struct SobolDirections
+{
+    uint32_t V[kSobolMaxDimensions * kSobolNumBits];
+    // XOR of the direction numbers selected by each byte of the index, 4 lookups instead of 32 steps
+    uint32_t ByteTables[kSobolMaxDimensions][4][256];
+
+    SobolDirections()
+    {
+        for (uint32_t bit = 0; bit < kSobolNumBits; ++bit)
+        {
+            V[bit] = 1u << (31 - bit);
+        }
+
+        for (uint32_t dim = 1; dim < kSobolMaxDimensions; ++dim)
+        {
+            const SobolInitParams& params = kSobolInitParams[dim - 1];
+            const uint32_t         s      = params.Degree;
+
+            uint32_t* pV = V + dim * kSobolNumBits;
+            for (uint32_t bit = 0; bit < kSobolNumBits; ++bit)
+            {
+                if (bit < s)
+                {
+                    pV[bit] = params.M[bit] << (31 - bit);
+                    continue;
+                }
+
+                uint32_t v = pV[bit - s] ^ (pV[bit - s] >> s);
+                for (uint32_t k = 1; k < s; ++k)
+                {
+                    if ((params.Coefficients >> (s - 1 - k)) & 1)
+                    {
+                        v ^= pV[bit - k];
+                    }
+                }
+                pV[bit] = v;
+            }
+        }
+
+        for (uint32_t dim = 0; dim < kSobolMaxDimensions; ++dim)
+        {
+            for (uint32_t byte = 0; byte < 4; ++byte)
+            {
+                const uint32_t* pV = V + dim * kSobolNumBits + byte * 8;
+                for (uint32_t value = 0; value < 256; ++value)
+                {
+                    uint32_t x = 0;
+                    for (uint32_t bit = 0; bit < 8; ++bit)
+                    {
+                        x ^= ((value >> bit) & 1) ? pV[bit] : 0;
+                    }
+                    ByteTables[dim][byte][value] = x;
+                }
+            }
+        }
+    }
+};
+
+const SobolDirections& GetSobolDirections()
+{
+    static const SobolDirections sDirections;
+    return sDirections;
+}
+
+uint32_t SobolFromTables(const uint32_t (*pTables)[256], uint32_t index)
+{
+    return pTables[0][index & 0xFF] ^ pTables[1][(index >> 8) & 0xFF] ^ pTables[2][(index >> 16) & 0xFF] ^
+           pTables[3][index >> 24];
+}
+
+// =============================================================================
+// Hashing
+// =============================================================================
+uint32_t ReverseBits(uint32_t x)
+{
+    x = (x << 16) | (x >> 16);
+    x = ((x & 0x55555555u) << 1) | ((x & 0xAAAAAAAAu) >> 1);
+    x = ((x & 0x33333333u) << 2) | ((x & 0xCCCCCCCCu) >> 2);
+    x = ((x & 0x0F0F0F0Fu) << 4) | ((x & 0xF0F0F0F0u) >> 4);
+    x = ((x & 0x00FF00FFu) << 8) | ((x & 0xFF00FF00u) >> 8);
+    return x;
+}
+
+// Only ever flips a bit based on the bits below it [Laine and Karras 2011]
+uint32_t LaineKarrasPermutation(uint32_t x, uint32_t seed)
+{
+    x += seed;
+    x ^= x * 0x6c50b47cu;
+    x ^= x * 0xb82f1e52u;
+    x ^= x * 0xc7afe638u;
+    x ^= x * 0x8d22f6e6u;
+    return x;
+}
+
+// lowbias32 by Chris Wellons
+uint32_t Hash(uint32_t x)
+{
+    x ^= x >> 16;
+    x *= 0x7feb352du;
+    x ^= x >> 15;
+    x *= 0x846ca68bu;
+    x ^= x >> 16;
+    return x;
+}
+
+float FixedToFloat(uint32_t x)
+{
+    return std::min(static_cast<float>(x >> 8) * 0x1p-24f, kOneMinusEpsilon);
+}
+
+// =============================================================================
+// CMJ
+// =============================================================================
+// CMJ borrowed from https://github.com/TheRealMJP/DXRPathTracer/blob/master/SampleFramework12/v1.02/Shaders/Sampling.hlsl
+//
+// clang-format off
+uint32_t CMJPermute(uint32_t i, uint32_t l, uint32_t p)
+{
+    uint32_t w = l - 1;
+    w |= w >> 1;
+    w |= w >> 2;
+    w |= w >> 4;
+    w |= w >> 8;
+    w |= w >> 16;
+    do
+    {
+        i ^= p; i *= 0xe170893d;
+        i ^= p >> 16;
+        i ^= (i & w) >> 4;
+        i ^= p >> 8; i *= 0x0929eb3f;
+        i ^= p >> 23;
+        i ^= (i & w) >> 1; i *= 1 | p >> 27;
+        i *= 0x6935fa69;
+        i ^= (i & w) >> 11; i *= 0x74dcb303;
+        i ^= (i & w) >> 2; i *= 0x9e501cc3;
+        i ^= (i & w) >> 2; i *= 0xc860a3df;
+        i &= w;
+        i ^= i >> 5;
+    }
+    while (i >= l);
+    return (i + p) % l;
+}
+
+float CMJRandFloat(uint32_t i, uint32_t p)
+{
+    i ^= p;
+    i ^= i >> 17;
+    i ^= i >> 10; i *= 0xb36534e5;
+    i ^= i >> 12;
+    i ^= i >> 21; i *= 0x93fc4795;
+    i ^= 0xdf6e307f;
+    i ^= i >> 17; i *= 1 | p >> 18;
+    return i * (1.0f / 4294967808.0f);
+}
+// clang-format on
+
+// =============================================================================
+// Blue noise
+// =============================================================================
+struct BlueNoiseFileHeader
+{
+    char     Magic[4];
+    uint32_t Version;
+    uint32_t Size;
+};
+
+const char     kBlueNoiseFileMagic[4] = {'G', 'X', 'B', 'N'};
+const uint32_t kBlueNoiseFileVersion  = 1;
+
+const uint32_t kBlueNoiseMaxSize = 256;
+const float    kBlueNoiseSigma   = 1.5f;
+
+//
+// Binary pattern plus the Gaussian filtered energy of its set pixels,
+// updated incrementally as pixels are set and cleared. Distances wrap so
+// the result tiles.
+//
+class VoidAndCluster
+{
+public:
+    VoidAndCluster(uint32_t size)
+        : mSize(size),
+          mPattern(size * size, 0),
+          mEnergy(size * size, 0.0f),
+          mKernel(size * size)
+    {
+        const float scale = -1.0f / (2.0f * kBlueNoiseSigma * kBlueNoiseSigma);
+        for (uint32_t y = 0; y < size; ++y)
+        {
+            for (uint32_t x = 0; x < size; ++x)
+            {
+                float dx = static_cast<float>(std::min(x, size - x));
+                float dy = static_cast<float>(std::min(y, size - y));
+
+                mKernel[y * size + x] = expf((dx * dx + dy * dy) * scale);
+            }
+        }
+    }
+
+    bool IsSet(uint32_t pixel) const { return mPattern[pixel] != 0; }
+
+    void Set(uint32_t pixel, bool value)
+    {
+        mPattern[pixel] = value ? 1 : 0;
+
+        const float    sign = value ? 1.0f : -1.0f;
+        const uint32_t px   = pixel % mSize;
+        const uint32_t py   = pixel / mSize;
+        for (uint32_t y = 0; y < mSize; ++y)
+        {
+            const float* pKernelRow = mKernel.data() + ((y >= py) ? (y - py) : (y + mSize - py)) * mSize;
+            float*       pEnergyRow = mEnergy.data() + y * mSize;
+
+            // Two runs instead of a modulo per pixel
+            const uint32_t split = mSize - px;
+            for (uint32_t x = 0; x < px; ++x)
+            {
+                pEnergyRow[x] += sign * pKernelRow[x + split];
+            }
+            for (uint32_t x = px; x < mSize; ++x)
+            {
+                pEnergyRow[x] += sign * pKernelRow[x - px];
+            }
+        }
+    }
+
+    // Set pixel with the highest energy
+    uint32_t FindTightestCluster() const
+    {
+        uint32_t best       = 0;
+        float    bestEnergy = -FLT_MAX;
+        for (uint32_t i = 0; i < CountU32(mPattern); ++i)
+        {
+            if (mPattern[i] && (mEnergy[i] > bestEnergy))
+            {
+                best       = i;
+                bestEnergy = mEnergy[i];
+            }
+        }
+        return best;
+    }
+
+    // Clear pixel with the lowest energy
+    uint32_t FindLargestVoid() const
+    {
+        uint32_t best       = 0;
+        float    bestEnergy = FLT_MAX;
+        for (uint32_t i = 0; i < CountU32(mPattern); ++i)
+        {
+            if (!mPattern[i] && (mEnergy[i] < bestEnergy))
+            {
+                best       = i;
+                bestEnergy = mEnergy[i];
+            }
+        }
+        return best;
+    }
+
+private:
+    uint32_t             mSize;
+    std::vector<uint8_t> mPattern;
+    std::vector<float>   mEnergy;
+    std::vector<float>   mKernel;
+};
+
+} // namespace
+
+// =============================================================================
+// Sobol
+// =============================================================================
+uint32_t SobolSample(uint32_t index, uint32_t dim)
+{
+    assert((dim < kSobolMaxDimensions) && "dimension out of range");
+    return SobolFromTables(GetSobolDirections().ByteTables[dim], index);
+}
+
+uint32_t NestedUniformScramble(uint32_t x, uint32_t seed)
+{
+    x = ReverseBits(x);
+    x = LaineKarrasPermutation(x, seed);
+    x = ReverseBits(x);
+    return x;
+}
+
+uint32_t HashCombine(uint32_t seed, uint32_t value)
+{
+    return seed ^ (value + (seed << 6) + (seed >> 2));
+}
+
+float SobolOwenSample(uint32_t index, uint32_t dim, uint32_t seed)
+{
+    uint32_t shuffled = NestedUniformScramble(index, seed);
+    uint32_t x        = SobolSample(shuffled, dim);
+    return FixedToFloat(NestedUniformScramble(x, HashCombine(seed, Hash(dim))));
+}
+
+void GenerateSobolOwen(uint32_t firstIndex, uint32_t numSamples, uint32_t numDims, uint32_t seed, float* pSamples)
+{
+    assert((numDims <= kSobolMaxDimensions) && "too many dimensions");
+
+    const SobolDirections& directions = GetSobolDirections();
+
+    uint32_t dimSeeds[kSobolMaxDimensions];
+    for (uint32_t dim = 0; dim < numDims; ++dim)
+    {
+        dimSeeds[dim] = HashCombine(seed, Hash(dim));
+    }
+
+    for (uint32_t i = 0; i < numSamples; ++i)
+    {
+        uint32_t shuffled = NestedUniformScramble(firstIndex + i, seed);
+        for (uint32_t dim = 0; dim < numDims; ++dim)
+        {
+            uint32_t x                  = SobolFromTables(directions.ByteTables[dim], shuffled);
+            pSamples[i * numDims + dim] = FixedToFloat(NestedUniformScramble(x, dimSeeds[dim]));
+        }
+    }
+}
+
+void GenerateSobolOwen2D(uint32_t firstIndex, uint32_t numSamples, uint32_t seed, glm::vec2* pSamples)
+{
+    GenerateSobolOwen(firstIndex, numSamples, 2, seed, reinterpret_cast<float*>(pSamples));
+}
+
+const uint32_t* GetSobolDirectionTable()
+{
+    return GetSobolDirections().V;
+}
+
+// =============================================================================
+// Hammersley and CMJ
+// =============================================================================
+glm::vec2 Hammersley(uint32_t i, uint32_t N)
+{
+    float rdi = static_cast<float>(ReverseBits(i)) * 2.3283064365386963e-10f;
+    return glm::vec2(static_cast<float>(i) / static_cast<float>(N), rdi);
+}
+
+void GenerateHammersley(uint32_t numSamples, glm::vec2* pSamples)
+{
+    for (uint32_t i = 0; i < numSamples; ++i)
+    {
+        pSamples[i] = Hammersley(i, numSamples);
+    }
+}
+
+// clang-format off
+glm::vec2 SampleCMJ2D(uint32_t sampleIdx, uint32_t numSamplesX, uint32_t numSamplesY, uint32_t pattern)
+{
+    uint32_t N  = numSamplesX * numSamplesY;
+    sampleIdx   = CMJPermute(sampleIdx, N, pattern * 0x51633e2d);
+    uint32_t sx = CMJPermute(sampleIdx % numSamplesX, numSamplesX, pattern * 0x68bc21eb);
+    uint32_t sy = CMJPermute(sampleIdx / numSamplesX, numSamplesY, pattern * 0x02e5be93);
+    float    jx = CMJRandFloat(sampleIdx, pattern * 0x967a889b);
+    float    jy = CMJRandFloat(sampleIdx, pattern * 0x368cc8b7);
+    return glm::vec2((sx + (sy + jx) / numSamplesY) / numSamplesX, (sampleIdx + jy) / N);
+}
+// clang-format on
+
+void GenerateCMJ(uint32_t numSamples, uint32_t pattern, glm::vec2* pSamples)
+{
+    if (numSamples == 0)
+    {
+        return;
+    }
+
+    uint32_t numSamplesX = static_cast<uint32_t>(sqrtf(static_cast<float>(numSamples)));
+    while ((numSamplesX > 1) && ((numSamples % numSamplesX) != 0))
+    {
+        --numSamplesX;
+    }
+    numSamplesX                = std::max(numSamplesX, 1u);
+    const uint32_t numSamplesY = numSamples / numSamplesX;
+
+    for (uint32_t i = 0; i < numSamples; ++i)
+    {
+        pSamples[i] = SampleCMJ2D(i, numSamplesX, numSamplesY, pattern);
+    }
+}
+
+// =============================================================================
+// Rank1Lattice
+// =============================================================================
+Rank1Lattice::Rank1Lattice()
+{
+}
+
+Rank1Lattice::~Rank1Lattice()
+{
+}
+
+bool Rank1Lattice::Create(uint32_t numPoints, uint32_t numDims, Rank1Lattice* pLattice)
+{
+    if ((numPoints == 0) || (numDims == 0) || IsNull(pLattice))
+    {
+        return false;
+    }
+
+    //
+    // P2 = -1 + 1/N * sum_k prod_j (1 + 2pi^2 * B2({k * g_j / N})), the
+    // worst case error for functions with square integrable mixed first
+    // derivatives. B2 is the second Bernoulli polynomial, x^2 - x + 1/6.
+    //
+    std::vector<double> factors(numPoints);
+    for (uint32_t r = 0; r < numPoints; ++r)
+    {
+        double x   = static_cast<double>(r) / numPoints;
+        factors[r] = 1.0 + 2.0 * kPi * kPi * (x * x - x + 1.0 / 6.0);
+    }
+
+    std::vector<uint32_t> generator(numDims);
+    std::vector<uint32_t> bestGenerator(numDims, 1);
+    double                bestMerit = DBL_MAX;
+
+    // a and N - a give mirrored lattices, only search the lower half
+    for (uint32_t a = 1; a <= std::max(numPoints / 2, 1u); ++a)
+    {
+        if (std::gcd(a, numPoints) != 1)
+        {
+            continue;
+        }
+
+        generator[0] = 1;
+        for (uint32_t dim = 1; dim < numDims; ++dim)
+        {
+            generator[dim] = static_cast<uint32_t>((static_cast<uint64_t>(generator[dim - 1]) * a) % numPoints);
+        }
+
+        double sum = 0;
+        for (uint32_t k = 0; k < numPoints; ++k)
+        {
+            double product = 1.0;
+            for (uint32_t dim = 0; dim < numDims; ++dim)
+            {
+                product *= factors[(static_cast<uint64_t>(k) * generator[dim]) % numPoints];
+            }
+            sum += product;
+        }
+
+        double merit = sum / numPoints;
+        if (merit < bestMerit)
+        {
+            bestMerit     = merit;
+            bestGenerator = generator;
+        }
+    }
+
+    pLattice->mNumPoints = numPoints;
+    pLattice->mNumDims   = numDims;
+    pLattice->mGenerator = std::move(bestGenerator);
+
+    return true;
+}
+
+void Rank1Lattice::Generate(uint32_t firstIndex, uint32_t numSamples, const float* pShift, float* pSamples) const
+{
+    const double invNumPoints = 1.0 / mNumPoints;
+    for (uint32_t i = 0; i < numSamples; ++i)
+    {
+        const uint64_t index = (firstIndex + i) % mNumPoints;
+        for (uint32_t dim = 0; dim < mNumDims; ++dim)
+        {
+            float x = static_cast<float>(((index * mGenerator[dim]) % mNumPoints) * invNumPoints);
+            if (!IsNull(pShift))
+            {
+                x += pShift[dim];
+                x = (x >= 1.0f) ? (x - 1.0f) : x;
+            }
+            pSamples[i * mNumDims + dim] = std::min(x, kOneMinusEpsilon);
+        }
+    }
+}
+
+// =============================================================================
+// BlueNoiseTile
+// =============================================================================
+BlueNoiseTile::BlueNoiseTile()
+{
+}
+
+BlueNoiseTile::~BlueNoiseTile()
+{
+}
+
+bool BlueNoiseTile::Generate(uint32_t size, uint32_t seed, BlueNoiseTile* pTile)
+{
+    if ((size < 4) || (size > kBlueNoiseMaxSize) || IsNull(pTile))
+    {
+        return false;
+    }
+
+    const uint32_t numPixels  = size * size;
+    const uint32_t numInitial = std::max(numPixels / 10, 1u);
+
+    // Initial pattern: random pixels...
+    VoidAndCluster initial(size);
+    uint32_t       rngState = Hash(seed);
+    for (uint32_t count = 0; count < numInitial;)
+    {
+        rngState       = Hash(rngState + 0x9e3779b9u);
+        uint32_t pixel = rngState % numPixels;
+        if (!initial.IsSet(pixel))
+        {
+            initial.Set(pixel, true);
+            ++count;
+        }
+    }
+
+    // ...relaxed by moving the tightest cluster into the largest void until that's a no-op
+    for (uint32_t i = 0; i < numPixels; ++i)
+    {
+        uint32_t cluster = initial.FindTightestCluster();
+        initial.Set(cluster, false);
+
+        uint32_t largestVoid = initial.FindLargestVoid();
+        initial.Set(largestVoid, true);
+        if (largestVoid == cluster)
+        {
+            break;
+        }
+    }
+
+    std::vector<uint16_t> ranks(numPixels);
+
+    // Phase 1: ranks below numInitial, removing the tightest cluster each time
+    {
+        VoidAndCluster pattern = initial;
+        for (uint32_t rank = numInitial; rank > 0; --rank)
+        {
+            uint32_t cluster = pattern.FindTightestCluster();
+            pattern.Set(cluster, false);
+            ranks[cluster] = static_cast<uint16_t>(rank - 1);
+        }
+    }
+
+    //
+    // Phases 2 and 3: the rest, filling the largest void each time. Past
+    // half full Ulichney switches to removing the tightest cluster of
+    // clear pixels, but the energy of the clear pixels is the kernel sum
+    // minus the energy of the set ones, so that's the same pixel.
+    //
+    {
+        VoidAndCluster pattern = std::move(initial);
+        for (uint32_t rank = numInitial; rank < numPixels; ++rank)
+        {
+            uint32_t largestVoid = pattern.FindLargestVoid();
+            pattern.Set(largestVoid, true);
+            ranks[largestVoid] = static_cast<uint16_t>(rank);
+        }
+    }
+
+    pTile->mSize  = size;
+    pTile->mRanks = std::move(ranks);
+
+    return true;
+}
+
+bool BlueNoiseTile::Load(const std::filesystem::path& absPath, BlueNoiseTile* pTile)
+{
+    if (IsNull(pTile))
+    {
+        return false;
+    }
+
+    std::ifstream is(absPath, std::ios::binary);
+    if (!is.is_open())
+    {
+        return false;
+    }
+
+    BlueNoiseFileHeader header = {};
+    is.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!is || !std::equal(kBlueNoiseFileMagic, kBlueNoiseFileMagic + 4, header.Magic) || (header.Version != kBlueNoiseFileVersion))
+    {
+        return false;
+    }
+    if ((header.Size == 0) || (header.Size > kBlueNoiseMaxSize))
+    {
+        return false;
+    }
+
+    std::vector<uint16_t> ranks(header.Size * header.Size);
+    is.read(reinterpret_cast<char*>(DataPtr(ranks)), SizeInBytes(ranks));
+    if (!is)
+    {
+        return false;
+    }
+
+    pTile->mSize  = header.Size;
+    pTile->mRanks = std::move(ranks);
+
+    return true;
+}
+
+bool BlueNoiseTile::Save(const std::filesystem::path& absPath, const BlueNoiseTile* pTile)
+{
+    if (IsNull(pTile) || pTile->Empty())
+    {
+        return false;
+    }
+
+    std::ofstream os(absPath, std::ios::binary);
+    if (!os.is_open())
+    {
+        return false;
+    }
+
+    BlueNoiseFileHeader header = {};
+    std::copy(kBlueNoiseFileMagic, kBlueNoiseFileMagic + 4, header.Magic);
+    header.Version = kBlueNoiseFileVersion;
+    header.Size    = pTile->mSize;
+
+    os.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    os.write(reinterpret_cast<const char*>(DataPtr(pTile->mRanks)), SizeInBytes(pTile->mRanks));
+
+    return static_cast<bool>(os);
+}
+
+float BlueNoiseTile::GetValue(uint32_t x, uint32_t y) const
+{
+    if (Empty())
+    {
+        return 0.5f;
+    }
+
+    uint32_t rank = mRanks[(y % mSize) * mSize + (x % mSize)];
+    return (rank + 0.5f) / static_cast<float>(mRanks.size());
+}
@@ -0,0 +1,134 @@
+#pragma once
+
+#include "config.h"
+
+#include <glm/glm.hpp>
+
+//
+// Low discrepancy sample sequences
+//
+//   - Sobol with hash based Owen scrambling [Burley 2020]
+//   - Rank-1 lattices with Korobov generators and Cranley-Patterson shifts
+//   - Blue noise tiles from void and cluster [Ulichney 1993]
+//   - Hammersley and correlated multi-jitter, moved here from sampling_vis
+//
+// Generators write into caller provided buffers and never allocate, so
+// they're fine to call per pixel or per path. Multi dimensional samples
+// are interleaved: sample i, dimension d is at pSamples[i * numDims + d].
+//
+// Everything a shader needs to produce the same numbers is exposed as a
+// flat table: the Sobol direction numbers, the lattice generator vector
+// and the blue noise ranks. The hashes are plain 32 bit integer math and
+// port to HLSL/MSL as is.
+//
+
+// =============================================================================
+// Sobol
+// =============================================================================
+const uint32_t kSobolMaxDimensions = 16;
+const uint32_t kSobolNumBits       = 32;
+
+// Unscrambled Sobol, 32 bit fixed point. dim < kSobolMaxDimensions.
+uint32_t SobolSample(uint32_t index, uint32_t dim);
+
+//
+// Owen scrambled Sobol. The index goes through a nested uniform scramble
+// of its own before the per dimension scrambles, so every seed gives a
+// different ordering as well as different points. Any power of two sized
+// block of consecutive indices starting at a multiple of its size is
+// still a (0, m, 2)-net in dimensions 0 and 1.
+//
+float SobolOwenSample(uint32_t index, uint32_t dim, uint32_t seed);
+void  GenerateSobolOwen(uint32_t firstIndex, uint32_t numSamples, uint32_t numDims, uint32_t seed, float* pSamples);
+void  GenerateSobolOwen2D(uint32_t firstIndex, uint32_t numSamples, uint32_t seed, glm::vec2* pSamples);
+
+// kSobolMaxDimensions x kSobolNumBits direction numbers, dimension major.
+// Bit b of the index XORs in entry [dim * kSobolNumBits + b].
+const uint32_t* GetSobolDirectionTable();
+
+// Nested uniform scramble of the bits of x, the building block of SobolOwenSample()
+uint32_t NestedUniformScramble(uint32_t x, uint32_t seed);
+uint32_t HashCombine(uint32_t seed, uint32_t value);
+
+// =============================================================================
+// Hammersley and CMJ
+// =============================================================================
+glm::vec2 Hammersley(uint32_t i, uint32_t N);
+void      GenerateHammersley(uint32_t numSamples, glm::vec2* pSamples);
+
+// Returns a 2D sample from a particular pattern using correlated multi-jittered sampling [Kensler 2013]
+glm::vec2 SampleCMJ2D(uint32_t sampleIdx, uint32_t numSamplesX, uint32_t numSamplesY, uint32_t pattern);
+// Picks the most square numSamplesX x numSamplesY grid with exactly numSamples cells
+void      GenerateCMJ(uint32_t numSamples, uint32_t pattern, glm::vec2* pSamples);
+
+// =============================================================================
+// Rank1Lattice
+//
+// N points x_i = frac(i * g / N + shift). The generator g is a Korobov
+// vector (1, a, a^2, ...) mod N, with a picked to minimize the P2 figure
+// of merit. The search is O(N^2 * numDims), which is instant for the
+// sample counts used per pixel but not meant for millions of points.
+// Unlike Sobol a lattice is a fixed size point set, only all N points
+// together are well distributed.
+// =============================================================================
+class Rank1Lattice
+{
+public:
+    Rank1Lattice();
+    ~Rank1Lattice();
+
+    static bool Create(uint32_t numPoints, uint32_t numDims, Rank1Lattice* pLattice);
+
+    bool     Empty() const { return mGenerator.empty(); }
+    uint32_t GetNumPoints() const { return mNumPoints; }
+    uint32_t GetNumDims() const { return mNumDims; }
+
+    // GetNumDims() entries
+    const std::vector<uint32_t>& GetGenerator() const { return mGenerator; }
+
+    // pShift has GetNumDims() entries in [0, 1), or is null for the unshifted lattice
+    void Generate(uint32_t firstIndex, uint32_t numSamples, const float* pShift, float* pSamples) const;
+
+private:
+    uint32_t              mNumPoints = 0;
+    uint32_t              mNumDims   = 0;
+    std::vector<uint32_t> mGenerator = {};
+};
+
+// =============================================================================
+// BlueNoiseTile
+//
+// A size x size tileable dither array: every pixel holds a distinct rank
+// in [0, size^2) and any threshold of the ranks gives a blue noise point
+// set. Used as a per pixel Cranley-Patterson shift, or to pick a per
+// pixel seed, it turns the error of a low sample count into high
+// frequency noise that's far less visible and easier to filter.
+//
+// Generation is O(size^4), about a second for 128 x 128, so bake the
+// tile with Save() and Load() it at run time.
+// =============================================================================
+class BlueNoiseTile
+{
+public:
+    BlueNoiseTile();
+    ~BlueNoiseTile();
+
+    // size is at most 256, so ranks fit in 16 bits
+    static bool Generate(uint32_t size, uint32_t seed, BlueNoiseTile* pTile);
+
+    static bool Load(const std::filesystem::path& absPath, BlueNoiseTile* pTile);
+    static bool Save(const std::filesystem::path& absPath, const BlueNoiseTile* pTile);
+
+    bool     Empty() const { return mRanks.empty(); }
+    uint32_t GetSize() const { return mSize; }
+
+    // GetSize()^2 entries, row major, upload as R16_UINT
+    const std::vector<uint16_t>& GetRanks() const { return mRanks; }
+
+    // Rank mapped to (rank + 0.5) / size^2, x and y wrap
+    float GetValue(uint32_t x, uint32_t y) const;
+
+private:
+    uint32_t              mSize  = 0;
+    std::vector<uint16_t> mRanks = {};
+};
@@ -0,0 +1,323 @@
+#pragma once
+
+#include "config.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <type_traits>
+
+#if defined(_WIN32)
+#    include <process.h>
+#else
+#    include <unistd.h>
+#endif
+
+//
+// Content addressed on-disk cache for compiled shaders
+//
+// CompileGLSL() and CompileHLSL() hash everything that affects their
+// output - language, target, stage or profile, entry point, options and
+// the source itself - and look the hash up before creating a compiler.
+// Hits return the stored SPIR-V or DXIL, misses compile and write the
+// result. Failed compiles aren't cached.
+//
+// The cache lives in the directory named by the GREX_SHADER_CACHE_DIR
+// environment variable, or in <temp>/grex_shader_cache if it's not set.
+// Setting GREX_SHADER_CACHE_DIR to an empty string turns the cache off.
+//
+// The glslang and DXC versions are part of the key, so updating a
+// compiler doesn't return stale entries. Bump GREX_SHADER_CACHE_VERSION
+// when a change to the compile settings must invalidate existing entries.
+//
+// Everything here is inline so the renderers pick it up without changes
+// to the projects' source lists. All functions are thread safe.
+//
+#define GREX_SHADER_CACHE_VERSION 1
+
+struct ShaderCacheStats
+{
+    uint32_t Hits          = 0;
+    uint32_t Misses        = 0;
+    uint32_t Writes        = 0;
+    uint32_t WriteFailures = 0;
+    uint64_t BytesRead     = 0;
+    uint64_t BytesWritten  = 0;
+};
+
+// 128 bit key built from two FNV-1a hashes with different offset bases
+struct ShaderCacheKey
+{
+    uint64_t Hash0 = 0xcbf29ce484222325ull;
+    uint64_t Hash1 = 0x84222325cbf29ce4ull;
+
+    void Add(const void* pData, size_t size)
+    {
+        const uint64_t kPrime = 0x00000100000001b3ull;
+
+        const unsigned char* pBytes = static_cast<const unsigned char*>(pData);
+        for (size_t i = 0; i < size; ++i) {
+            this->Hash0 = (this->Hash0 ^ pBytes[i]) * kPrime;
+            this->Hash1 = (this->Hash1 ^ pBytes[i]) * kPrime;
+        }
+    }
+
+    // Strings are length prefixed so adjacent fields can't run together
+    void Add(const std::string& s)
+    {
+        this->Add(static_cast<uint64_t>(s.size()));
+        this->Add(s.data(), s.size());
+    }
+
+    void Add(const char* s)
+    {
+        this->Add(std::string(s));
+    }
+
+    template <typename T>
+    void Add(const T& value)
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "T must be trivially copyable");
+        this->Add(&value, sizeof(T));
+    }
+
+    std::string ToString() const
+    {
+        const char* kDigits = "0123456789abcdef";
+
+        std::string s;
+        for (uint64_t hash : {this->Hash0, this->Hash1}) {
+            for (int shift = 60; shift >= 0; shift -= 4) {
+                s.push_back(kDigits[(hash >> shift) & 0xF]);
+            }
+        }
+        return s;
+    }
+};
+
+namespace ShaderCacheInternal
+{
+
+struct State
+{
+    std::mutex            Mutex;
+    bool                  Initialized   = false;
+    std::filesystem::path Directory     = "";
+    std::atomic<uint32_t> Hits          = 0;
+    std::atomic<uint32_t> Misses        = 0;
+    std::atomic<uint32_t> Writes        = 0;
+    std::atomic<uint32_t> WriteFailures = 0;
+    std::atomic<uint64_t> BytesRead     = 0;
+    std::atomic<uint64_t> BytesWritten  = 0;
+};
+
+inline State& GetState()
+{
+    static State sState;
+    return sState;
+}
+
+// Entry file layout: header followed by the payload
+struct FileHeader
+{
+    char     Magic[4]    = {'G', 'R', 'X', 'S'};
+    uint32_t Version     = GREX_SHADER_CACHE_VERSION;
+    uint64_t PayloadSize = 0;
+    uint64_t Checksum    = 0; // Hash0 of the payload, catches truncated writes
+};
+
+inline uint64_t Checksum(const void* pData, size_t size)
+{
+    ShaderCacheKey key = {};
+    key.Add(pData, size);
+    return key.Hash0;
+}
+
+// Unique across processes sharing the cache directory and across
+// threads and calls within one process
+inline std::string GetTempSuffix()
+{
+    static std::atomic<uint64_t> sCounter = 0;
+
+#if defined(_WIN32)
+    const uint64_t pid = static_cast<uint64_t>(_getpid());
+#else
+    const uint64_t pid = static_cast<uint64_t>(getpid());
+#endif
+
+    std::stringstream ss;
+    ss << pid << "." << sCounter.fetch_add(1) << ".tmp";
+    return ss.str();
+}
+
+inline std::filesystem::path GetEntryPath(const ShaderCacheKey& key)
+{
+    State& state = GetState();
+
+    std::lock_guard<std::mutex> lock(state.Mutex);
+    if (!state.Initialized) {
+        const char* pEnv = std::getenv("GREX_SHADER_CACHE_DIR");
+        if (!IsNull(pEnv)) {
+            state.Directory = pEnv;
+        }
+        else {
+            std::error_code ec;
+            auto            tempDir = std::filesystem::temp_directory_path(ec);
+            state.Directory         = ec ? std::filesystem::path() : (tempDir / "grex_shader_cache");
+        }
+        state.Initialized = true;
+    }
+
+    if (state.Directory.empty()) {
+        return {};
+    }
+
+    return state.Directory / (key.ToString() + ".bin");
+}
+
+} // namespace ShaderCacheInternal
+
+// An empty path turns the cache off
+inline void SetShaderCacheDirectory(const std::filesystem::path& dir)
+{
+    auto& state = ShaderCacheInternal::GetState();
+
+    std::lock_guard<std::mutex> lock(state.Mutex);
+    state.Directory   = dir;
+    state.Initialized = true;
+}
+
+inline std::filesystem::path GetShaderCacheDirectory()
+{
+    // Resolves the default directory if it hasn't been yet
+    ShaderCacheInternal::GetEntryPath({});
+
+    auto& state = ShaderCacheInternal::GetState();
+
+    std::lock_guard<std::mutex> lock(state.Mutex);
+    return state.Directory;
+}
+
+inline ShaderCacheStats GetShaderCacheStats()
+{
+    auto& state = ShaderCacheInternal::GetState();
+
+    ShaderCacheStats stats = {};
+    stats.Hits             = state.Hits;
+    stats.Misses           = state.Misses;
+    stats.Writes           = state.Writes;
+    stats.WriteFailures    = state.WriteFailures;
+    stats.BytesRead        = state.BytesRead;
+    stats.BytesWritten     = state.BytesWritten;
+    return stats;
+}
+
+inline void ResetShaderCacheStats()
+{
+    auto& state = ShaderCacheInternal::GetState();
+
+    state.Hits          = 0;
+    state.Misses        = 0;
+    state.Writes        = 0;
+    state.WriteFailures = 0;
+    state.BytesRead     = 0;
+    state.BytesWritten  = 0;
+}
+
+// Returns true on a hit. Misses include entries that fail to read or
+// whose header doesn't match.
+template <typename T>
+bool LoadCachedShader(const ShaderCacheKey& key, std::vector<T>* pData)
+{
+    auto& state = ShaderCacheInternal::GetState();
+
+    auto path = ShaderCacheInternal::GetEntryPath(key);
+    if (path.empty() || IsNull(pData)) {
+        return false;
+    }
+
+    std::ifstream is(path, std::ios::binary);
+    if (!is.is_open()) {
+        state.Misses += 1;
+        return false;
+    }
+
+    ShaderCacheInternal::FileHeader expected = {};
+    ShaderCacheInternal::FileHeader header   = {};
+    is.read(reinterpret_cast<char*>(&header), sizeof(header));
+
+    const bool valid = is.good() &&
+                       (memcmp(header.Magic, expected.Magic, sizeof(header.Magic)) == 0) &&
+                       (header.Version == expected.Version) &&
+                       (header.PayloadSize > 0) &&
+                       ((header.PayloadSize % sizeof(T)) == 0);
+    if (!valid) {
+        state.Misses += 1;
+        return false;
+    }
+
+    std::vector<T> data(static_cast<size_t>(header.PayloadSize / sizeof(T)));
+    is.read(reinterpret_cast<char*>(data.data()), static_cast<std::streamsize>(header.PayloadSize));
+    if (!is.good() || (ShaderCacheInternal::Checksum(data.data(), header.PayloadSize) != header.Checksum)) {
+        state.Misses += 1;
+        return false;
+    }
+
+    *pData = std::move(data);
+
+    state.Hits += 1;
+    state.BytesRead += header.PayloadSize;
+
+    return true;
+}
+
+//
+// Entries are written to a temporary file and renamed into place, so a
+// concurrent reader - another thread or another sample starting up -
+// never sees a partial entry.
+//
+template <typename T>
+void StoreCachedShader(const ShaderCacheKey& key, const std::vector<T>& data)
+{
+    auto& state = ShaderCacheInternal::GetState();
+
+    auto path = ShaderCacheInternal::GetEntryPath(key);
+    if (path.empty() || data.empty()) {
+        return;
+    }
+
+    std::error_code ec;
+    std::filesystem::create_directories(path.parent_path(), ec);
+
+    auto tmpPath = path.parent_path() / (path.filename().string() + "." + ShaderCacheInternal::GetTempSuffix());
+
+    ShaderCacheInternal::FileHeader header = {};
+    header.PayloadSize                     = SizeInBytes(data);
+    header.Checksum                        = ShaderCacheInternal::Checksum(data.data(), SizeInBytes(data));
+
+    bool written = false;
+    {
+        std::ofstream os(tmpPath, std::ios::binary);
+        if (os.is_open()) {
+            os.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            os.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(SizeInBytes(data)));
+            written = os.good();
+        }
+    }
+
+    if (written) {
+        std::filesystem::rename(tmpPath, path, ec);
+        written = !ec;
+    }
+
+    if (!written) {
+        std::filesystem::remove(tmpPath, ec);
+        state.WriteFailures += 1;
+        GREX_LOG_WARN("shader cache write failed: " << path);
+        return;
+    }
+
+    state.Writes += 1;
+    state.BytesWritten += header.PayloadSize;
+}
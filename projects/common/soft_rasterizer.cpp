@@ -0,0 +1,922 @@
+#include "soft_rasterizer.h"
+#include "job_system.h"
+
+#include <atomic>
+#include <chrono>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define SOFT_RASTERIZER_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+
+// Tiles are small enough that stepping an edge function across one stays in int32, see RasterizeTriangle
+const int32_t kTileShift = 6;
+const int32_t kTileSize  = 1 << kTileShift;
+
+const int32_t kSubpixelBits  = 4;
+const int32_t kSubpixelScale = 1 << kSubpixelBits;
+const int32_t kSubpixelHalf  = kSubpixelScale / 2;
+
+// Triangles reaching less than this far past the viewport aren't clipped in x and y.
+// With kMaxViewportSize that keeps snapped coordinates under 2^18.
+const float    kGuardBandPixels = 2048.0f;
+const uint32_t kMaxViewportSize = 8192;
+
+// Edge function values at the start of a row are clamped to this. Steps
+// across a tile add less than 2^29, so the sign never flips and int32
+// never overflows.
+const int64_t kEdgeClamp = int64_t(1) << 30;
+
+// Setup triangles are about 100 bytes, a batch stays in the low MBs per thread
+const uint64_t kBatchTrianglesPerThread = 16384;
+
+// A triangle clipped by all 6 planes gains at most one vertex per plane
+const uint32_t kMaxClipVertices = 9;
+const uint32_t kNumClipPlanes   = 6;
+
+struct ClipVertex
+{
+    glm::vec4 Position; // Clip space
+    glm::vec3 Bary;     // Blend of the mesh triangle's vertices
+};
+
+//
+// A triangle ready for the raster stage. Vertices are ordered so Area is
+// positive. Clipping may have moved the vertices off the mesh triangle's,
+// Bary holds where each one landed so attributes can be fetched from the
+// mesh in the raster stage instead of being carried through.
+//
+struct SetupTriangle
+{
+    int32_t   X[3]; // Subpixels, row 0 is the top
+    int32_t   Y[3];
+    float     Z[3]; // z / w
+    float     InvW[3];
+    glm::vec3 Bary[3];
+    int64_t   Area; // Twice the area in subpixels
+    int32_t   MinX; // Pixels whose center may be covered, inclusive and inside the viewport
+    int32_t   MinY;
+    int32_t   MaxX;
+    int32_t   MaxY;
+    uint32_t  DrawIndex;
+    uint32_t  TriangleIndex;
+    bool      FrontFacing;
+};
+
+// Attributes at a setup triangle's vertices, world space
+struct VertexAttributes
+{
+    glm::vec3 Position[3];
+    glm::vec3 Normal[3];
+    glm::vec3 Color[3];
+    glm::vec2 TexCoord[3];
+};
+
+int32_t FloorDiv(int32_t value, int32_t divisor)
+{
+    return (value >= 0) ? (value / divisor) : -((-value + divisor - 1) / divisor);
+}
+
+//
+// Clips the polygon against the planes dot(plane, position) >= 0. The
+// polygon is convex, so every plane takes away at most a wedge and adds at
+// most one vertex.
+//
+uint32_t ClipPolygon(const glm::vec4* pPlanes, uint32_t numPlanes, ClipVertex* pVertices, uint32_t numVertices)
+{
+    ClipVertex scratch[kMaxClipVertices];
+
+    ClipVertex* pIn  = pVertices;
+    ClipVertex* pOut = scratch;
+    for (uint32_t planeIndex = 0; (planeIndex < numPlanes) && (numVertices >= 3); ++planeIndex)
+    {
+        const glm::vec4& plane = pPlanes[planeIndex];
+
+        uint32_t numOut = 0;
+        for (uint32_t i = 0; i < numVertices; ++i)
+        {
+            const ClipVertex& a  = pIn[i];
+            const ClipVertex& b  = pIn[(i + 1) % numVertices];
+            const float       da = glm::dot(plane, a.Position);
+            const float       db = glm::dot(plane, b.Position);
+
+            if (da >= 0)
+            {
+                pOut[numOut++] = a;
+            }
+            if ((da >= 0) != (db >= 0))
+            {
+                const float t         = da / (da - db);
+                pOut[numOut].Position = a.Position + t * (b.Position - a.Position);
+                pOut[numOut].Bary     = a.Bary + t * (b.Bary - a.Bary);
+                ++numOut;
+            }
+        }
+
+        std::swap(pIn, pOut);
+        numVertices = numOut;
+    }
+
+    if (pIn != pVertices)
+    {
+        std::copy(pIn, pIn + numVertices, pVertices);
+    }
+    return (numVertices >= 3) ? numVertices : 0;
+}
+
+} // namespace
+
+// =============================================================================
+// SoftRasterizer::Framebuffer
+// =============================================================================
+void SoftRasterizer::Framebuffer::Resize(uint32_t width, uint32_t height)
+{
+    this->Width  = width;
+    this->Height = height;
+
+    const size_t numPixels = static_cast<size_t>(width) * height;
+    this->Color.resize(numPixels);
+    this->Depth.resize(numPixels);
+}
+
+void SoftRasterizer::Framebuffer::Clear(const glm::vec4& color, float depth)
+{
+    std::fill(this->Color.begin(), this->Color.end(), color);
+    std::fill(this->Depth.begin(), this->Depth.end(), depth);
+}
+
+BitmapRGBA8u SoftRasterizer::Framebuffer::ToBitmap() const
+{
+    BitmapRGBA8u bitmap = BitmapRGBA8u(this->Width, this->Height);
+    for (uint32_t y = 0; y < this->Height; ++y)
+    {
+        for (uint32_t x = 0; x < this->Width; ++x)
+        {
+            const glm::vec4 color = glm::clamp(this->Color[y * this->Width + x], glm::vec4(0), glm::vec4(1));
+
+            PixelRGBA8u* pPixel = bitmap.GetPixels(x, y);
+            pPixel->r           = static_cast<uint8_t>(color.r * 255.0f + 0.5f);
+            pPixel->g           = static_cast<uint8_t>(color.g * 255.0f + 0.5f);
+            pPixel->b           = static_cast<uint8_t>(color.b * 255.0f + 0.5f);
+            pPixel->a           = static_cast<uint8_t>(color.a * 255.0f + 0.5f);
+        }
+    }
+    return bitmap;
+}
+
+// =============================================================================
+// SoftRasterizer::DrawCall / SoftRasterizer::Batch
+// =============================================================================
+struct SoftRasterizer::DrawCall
+{
+    const TriMesh* pMesh         = nullptr;
+    glm::mat4      ModelMatrix   = glm::mat4(1);
+    glm::mat3      NormalMatrix  = glm::mat3(1);
+    glm::mat4      MVPMatrix     = glm::mat4(1); // Filled in by Render()
+    PixelShader    Shader        = nullptr;
+    CullMode       Cull          = CULL_MODE_BACK;
+    uint64_t       FirstTriangle = 0; // Position in the frame's triangle sequence
+};
+
+//
+// Scratch kept between frames. Each slot sets up its slice of the batch
+// into its own Slice, so the geometry stage doesn't share anything, and
+// owns a tile sized color and depth buffer for the raster stage.
+//
+struct SoftRasterizer::Batch
+{
+    struct Slice
+    {
+        std::vector<SetupTriangle>         Triangles;
+        std::vector<std::vector<uint32_t>> Bins; // Per tile, indices into Triangles in submission order
+        uint64_t                           NumSetupTriangles = 0;
+        uint64_t                           NumFragments      = 0;
+    };
+
+    std::vector<Slice>                  Slices;
+    std::vector<std::vector<glm::vec4>> TileColor;
+    std::vector<std::vector<float>>     TileDepth;
+
+    void Resize(uint32_t numThreads, uint32_t numTiles)
+    {
+        this->Slices.resize(numThreads);
+        this->TileColor.resize(numThreads);
+        this->TileDepth.resize(numThreads);
+        for (uint32_t i = 0; i < numThreads; ++i)
+        {
+            this->Slices[i].Bins.resize(numTiles);
+            this->Slices[i].NumSetupTriangles = 0;
+            this->Slices[i].NumFragments      = 0;
+            this->TileColor[i].resize(kTileSize * kTileSize);
+            this->TileDepth[i].resize(kTileSize * kTileSize);
+        }
+    }
+};
+
+// =============================================================================
+// Geometry stage
+// =============================================================================
+namespace
+{
+
+struct Viewport
+{
+    uint32_t Width     = 0;
+    uint32_t Height    = 0;
+    uint32_t NumTilesX = 0;
+    uint32_t NumTilesY = 0;
+    // Clip planes: near, far and the guard band
+    glm::vec4 ClipPlanes[kNumClipPlanes];
+};
+
+Viewport GetViewport(uint32_t width, uint32_t height)
+{
+    const float guardX = 1.0f + 2.0f * kGuardBandPixels / static_cast<float>(width);
+    const float guardY = 1.0f + 2.0f * kGuardBandPixels / static_cast<float>(height);
+
+    Viewport viewport      = {};
+    viewport.Width         = width;
+    viewport.Height        = height;
+    viewport.NumTilesX     = (width + kTileSize - 1) >> kTileShift;
+    viewport.NumTilesY     = (height + kTileSize - 1) >> kTileShift;
+    viewport.ClipPlanes[0] = glm::vec4(0, 0, 1, 0);       // z >= 0
+    viewport.ClipPlanes[1] = glm::vec4(0, 0, -1, 1);      // z <= w
+    viewport.ClipPlanes[2] = glm::vec4(1, 0, 0, guardX);  // x >= -guardX * w
+    viewport.ClipPlanes[3] = glm::vec4(-1, 0, 0, guardX); // x <= guardX * w
+    viewport.ClipPlanes[4] = glm::vec4(0, 1, 0, guardY);
+    viewport.ClipPlanes[5] = glm::vec4(0, -1, 0, guardY);
+    return viewport;
+}
+
+// Bit per frustum plane the position is outside of, the guard band doesn't count
+uint32_t GetOutcode(const glm::vec4& p)
+{
+    uint32_t outcode = 0;
+    outcode |= (p.z < 0) ? 0x01 : 0;
+    outcode |= (p.z > p.w) ? 0x02 : 0;
+    outcode |= (p.x < -p.w) ? 0x04 : 0;
+    outcode |= (p.x > p.w) ? 0x08 : 0;
+    outcode |= (p.y < -p.w) ? 0x10 : 0;
+    outcode |= (p.y > p.w) ? 0x20 : 0;
+    return outcode;
+}
+
+bool InsideClipPlanes(const Viewport& viewport, const glm::vec4& p)
+{
+    for (uint32_t i = 0; i < kNumClipPlanes; ++i)
+    {
+        if (glm::dot(viewport.ClipPlanes[i], p) < 0)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+//
+// Projects, snaps and culls a clipped triangle, then bins it. Returns
+// false if nothing is left of it.
+//
+bool SetupAndBinTriangle(
+    const Viewport&                     viewport,
+    const ClipVertex&                   v0,
+    const ClipVertex&                   v1,
+    const ClipVertex&                   v2,
+    SoftRasterizer::CullMode            cullMode,
+    uint32_t                            drawIndex,
+    uint32_t                            triangleIndex,
+    std::vector<SetupTriangle>*         pTriangles,
+    std::vector<std::vector<uint32_t>>* pBins)
+{
+    const ClipVertex* pVertices[3] = {&v0, &v1, &v2};
+
+    SetupTriangle tri = {};
+    for (uint32_t i = 0; i < 3; ++i)
+    {
+        const glm::vec4& p = pVertices[i]->Position;
+        if (!(p.w > 0))
+        {
+            return false;
+        }
+
+        // NDC +Y is up and row 0 is the top
+        const float invW = 1.0f / p.w;
+        const float x    = (p.x * invW * 0.5f + 0.5f) * static_cast<float>(viewport.Width);
+        const float y    = (0.5f - p.y * invW * 0.5f) * static_cast<float>(viewport.Height);
+
+        tri.X[i]    = static_cast<int32_t>(lrintf(x * kSubpixelScale));
+        tri.Y[i]    = static_cast<int32_t>(lrintf(y * kSubpixelScale));
+        tri.Z[i]    = glm::clamp(p.z * invW, 0.0f, 1.0f);
+        tri.InvW[i] = invW;
+        tri.Bary[i] = pVertices[i]->Bary;
+    }
+
+    tri.Area = static_cast<int64_t>(tri.X[1] - tri.X[0]) * (tri.Y[2] - tri.Y[0]) - static_cast<int64_t>(tri.X[2] - tri.X[0]) * (tri.Y[1] - tri.Y[0]);
+    if (tri.Area == 0)
+    {
+        return false;
+    }
+
+    // Counter clockwise in NDC is clockwise once Y points down
+    tri.FrontFacing = (tri.Area < 0);
+    if (((cullMode == SoftRasterizer::CULL_MODE_BACK) && !tri.FrontFacing) || ((cullMode == SoftRasterizer::CULL_MODE_FRONT) && tri.FrontFacing))
+    {
+        return false;
+    }
+
+    if (tri.Area < 0)
+    {
+        std::swap(tri.X[1], tri.X[2]);
+        std::swap(tri.Y[1], tri.Y[2]);
+        std::swap(tri.Z[1], tri.Z[2]);
+        std::swap(tri.InvW[1], tri.InvW[2]);
+        std::swap(tri.Bary[1], tri.Bary[2]);
+        tri.Area = -tri.Area;
+    }
+
+    // Pixels whose centers fall inside the bounds
+    const int32_t minX = std::min(std::min(tri.X[0], tri.X[1]), tri.X[2]);
+    const int32_t minY = std::min(std::min(tri.Y[0], tri.Y[1]), tri.Y[2]);
+    const int32_t maxX = std::max(std::max(tri.X[0], tri.X[1]), tri.X[2]);
+    const int32_t maxY = std::max(std::max(tri.Y[0], tri.Y[1]), tri.Y[2]);
+
+    tri.MinX = std::max(-FloorDiv(kSubpixelHalf - minX, kSubpixelScale), 0);
+    tri.MinY = std::max(-FloorDiv(kSubpixelHalf - minY, kSubpixelScale), 0);
+    tri.MaxX = std::min(FloorDiv(maxX - kSubpixelHalf, kSubpixelScale), static_cast<int32_t>(viewport.Width) - 1);
+    tri.MaxY = std::min(FloorDiv(maxY - kSubpixelHalf, kSubpixelScale), static_cast<int32_t>(viewport.Height) - 1);
+    if ((tri.MinX > tri.MaxX) || (tri.MinY > tri.MaxY))
+    {
+        return false;
+    }
+
+    tri.DrawIndex     = drawIndex;
+    tri.TriangleIndex = triangleIndex;
+
+    const uint32_t index = CountU32(*pTriangles);
+    pTriangles->push_back(tri);
+
+    for (int32_t tileY = (tri.MinY >> kTileShift); tileY <= (tri.MaxY >> kTileShift); ++tileY)
+    {
+        for (int32_t tileX = (tri.MinX >> kTileShift); tileX <= (tri.MaxX >> kTileShift); ++tileX)
+        {
+            (*pBins)[tileY * viewport.NumTilesX + tileX].push_back(index);
+        }
+    }
+
+    return true;
+}
+
+} // namespace
+
+// =============================================================================
+// Raster stage
+// =============================================================================
+namespace
+{
+
+struct Tile
+{
+    int32_t    X0     = 0;
+    int32_t    Y0     = 0;
+    int32_t    X1     = 0; // Exclusive, clamped to the viewport
+    int32_t    Y1     = 0;
+    glm::vec4* pColor = nullptr; // kTileSize x kTileSize, pixel (X0, Y0) first
+    float*     pDepth = nullptr;
+};
+
+struct EdgeFunction
+{
+    int32_t A;    // Step per subpixel in x
+    int32_t B;    // Step per subpixel in y
+    int32_t Bias; // 0 on top and left edges, -1 elsewhere so pixels exactly on them are out
+    int32_t X;    // Start vertex
+    int32_t Y;
+
+    // At the pixel center (x, y), clamped so int32 steps across a tile stay exact in sign
+    int32_t Evaluate(int32_t x, int32_t y) const
+    {
+        const int64_t cx = static_cast<int64_t>(x) * kSubpixelScale + kSubpixelHalf;
+        const int64_t cy = static_cast<int64_t>(y) * kSubpixelScale + kSubpixelHalf;
+        const int64_t e  = static_cast<int64_t>(this->B) * (cy - this->Y) + static_cast<int64_t>(this->A) * (cx - this->X) + this->Bias;
+        return static_cast<int32_t>(std::clamp(e, -kEdgeClamp, kEdgeClamp));
+    }
+};
+
+//
+// Edge from a to b, positive on the side the third vertex is on. Vertices
+// are ordered with positive area, which on screen with Y down is clockwise:
+// top edges run exactly horizontal to the right and left edges run up.
+//
+EdgeFunction GetEdgeFunction(int32_t ax, int32_t ay, int32_t bx, int32_t by)
+{
+    const int32_t dx      = bx - ax;
+    const int32_t dy      = by - ay;
+    const bool    topLeft = ((dy == 0) && (dx > 0)) || (dy < 0);
+
+    EdgeFunction edge = {};
+    edge.A            = -dy;
+    edge.B            = dx;
+    edge.Bias         = topLeft ? 0 : -1;
+    edge.X            = ax;
+    edge.Y            = ay;
+    return edge;
+}
+
+//
+// Bit per pixel of 4 starting at the ones e0, e1 and e2 were evaluated
+// at, set if all edge functions are >= 0.
+//
+#if defined(SOFT_RASTERIZER_SSE2)
+uint32_t CoverageMask4(__m128i e0, __m128i e1, __m128i e2)
+{
+    const __m128i any = _mm_or_si128(_mm_or_si128(e0, e1), e2);
+    return ~static_cast<uint32_t>(_mm_movemask_ps(_mm_castsi128_ps(any))) & 0xF;
+}
+#else
+uint32_t CoverageMask4(const int32_t* pE0, const int32_t* pE1, const int32_t* pE2)
+{
+    uint32_t mask = 0;
+    for (uint32_t i = 0; i < 4; ++i)
+    {
+        mask |= ((pE0[i] | pE1[i] | pE2[i]) >= 0) ? (1u << i) : 0;
+    }
+    return mask;
+}
+#endif
+
+VertexAttributes GetVertexAttributes(const TriMesh& mesh, const glm::mat4& modelMatrix, const glm::mat3& normalMatrix, const SetupTriangle& tri)
+{
+    const TriMesh::Triangle& triangle = mesh.GetTriangles()[tri.TriangleIndex];
+    const uint32_t           vIdx[3]  = {triangle.vIdx0, triangle.vIdx1, triangle.vIdx2};
+
+    const bool hasNormals   = !mesh.GetNormals().empty();
+    const bool hasColors    = !mesh.GetVertexColors().empty();
+    const bool hasTexCoords = !mesh.GetTexCoords().empty();
+
+    VertexAttributes mesh3 = {};
+    for (uint32_t i = 0; i < 3; ++i)
+    {
+        mesh3.Position[i] = glm::vec3(modelMatrix * glm::vec4(mesh.GetPositions()[vIdx[i]], 1));
+        mesh3.Normal[i]   = hasNormals ? (normalMatrix * mesh.GetNormals()[vIdx[i]]) : glm::vec3(0);
+        mesh3.Color[i]    = hasColors ? mesh.GetVertexColors()[vIdx[i]] : glm::vec3(1);
+        mesh3.TexCoord[i] = hasTexCoords ? mesh.GetTexCoords()[vIdx[i]] : glm::vec2(0);
+    }
+
+    VertexAttributes attributes = {};
+    for (uint32_t i = 0; i < 3; ++i)
+    {
+        const glm::vec3& b     = tri.Bary[i];
+        attributes.Position[i] = b.x * mesh3.Position[0] + b.y * mesh3.Position[1] + b.z * mesh3.Position[2];
+        attributes.Normal[i]   = b.x * mesh3.Normal[0] + b.y * mesh3.Normal[1] + b.z * mesh3.Normal[2];
+        attributes.Color[i]    = b.x * mesh3.Color[0] + b.y * mesh3.Color[1] + b.z * mesh3.Color[2];
+        attributes.TexCoord[i] = b.x * mesh3.TexCoord[0] + b.y * mesh3.TexCoord[1] + b.z * mesh3.TexCoord[2];
+    }
+    return attributes;
+}
+
+//
+// Draws the part of the triangle inside the tile. Returns the number of
+// shaded pixels.
+//
+// Coverage is exact: edge functions are integers in subpixels. Each row
+// starts from a 64 bit evaluation clamped to +/-2^30, and 4 pixels at a
+// time step from there in int32. Snapped coordinates are under 2^18, so a
+// step across a 64 pixel tile is under 2^28 and neither overflows nor
+// flips a clamped sign.
+//
+// Depth and attributes use float barycentrics on the same snapped
+// vertices. Depth is linear in screen space, the attributes are
+// perspective corrected with 1/w.
+//
+uint64_t RasterizeTriangle(
+    const TriMesh&                     mesh,
+    const glm::mat4&                   modelMatrix,
+    const glm::mat3&                   normalMatrix,
+    const SoftRasterizer::PixelShader& shader,
+    const SetupTriangle&               tri,
+    const Tile&                        tile)
+{
+    const int32_t x0 = std::max(tri.MinX, tile.X0);
+    const int32_t y0 = std::max(tri.MinY, tile.Y0);
+    const int32_t x1 = std::min(tri.MaxX, tile.X1 - 1);
+    const int32_t y1 = std::min(tri.MaxY, tile.Y1 - 1);
+    if ((x0 > x1) || (y0 > y1))
+    {
+        return 0;
+    }
+
+    // Edge i is opposite vertex i, divided by the area it's vertex i's barycentric
+    const EdgeFunction edges[3] = {
+        GetEdgeFunction(tri.X[1], tri.Y[1], tri.X[2], tri.Y[2]),
+        GetEdgeFunction(tri.X[2], tri.Y[2], tri.X[0], tri.Y[0]),
+        GetEdgeFunction(tri.X[0], tri.Y[0], tri.X[1], tri.Y[1]),
+    };
+
+    // Barycentrics per pixel, same snapped vertices as the coverage
+    const double invArea = 1.0 / static_cast<double>(tri.Area);
+    const float  dl1dx   = static_cast<float>(edges[1].A * kSubpixelScale * invArea);
+    const float  dl2dx   = static_cast<float>(edges[2].A * kSubpixelScale * invArea);
+    const float  dzdx    = dl1dx * (tri.Z[1] - tri.Z[0]) + dl2dx * (tri.Z[2] - tri.Z[0]);
+
+    auto getBarycentric = [&](const EdgeFunction& edge, int32_t x, int32_t y) -> float {
+        const double cx = static_cast<double>(x) * kSubpixelScale + kSubpixelHalf;
+        const double cy = static_cast<double>(y) * kSubpixelScale + kSubpixelHalf;
+        return static_cast<float>((edge.B * (cy - edge.Y) + edge.A * (cx - edge.X)) * invArea);
+    };
+
+    // Groups of 4 start on multiples of 4, so they never run past a tile buffer row
+    const int32_t xStart = x0 & ~3;
+
+    bool             hasAttributes = false;
+    VertexAttributes attributes    = {};
+    uint64_t         numFragments  = 0;
+
+#if defined(SOFT_RASTERIZER_SSE2)
+    const __m128i laneSteps = _mm_setr_epi32(0, 1, 2, 3);
+    __m128i       edgeSteps[3];
+    __m128i       groupSteps[3];
+    for (uint32_t i = 0; i < 3; ++i)
+    {
+        // laneSteps * A * kSubpixelScale, SSE2 has no 32 bit multiply
+        const int32_t step = edges[i].A * kSubpixelScale;
+        edgeSteps[i]       = _mm_setr_epi32(0, step, 2 * step, 3 * step);
+        groupSteps[i]      = _mm_set1_epi32(4 * step);
+    }
+    const __m128 zSteps     = _mm_mul_ps(_mm_cvtepi32_ps(laneSteps), _mm_set1_ps(dzdx));
+    const __m128 zGroupStep = _mm_set1_ps(4.0f * dzdx);
+#endif
+
+    for (int32_t y = y0; y <= y1; ++y)
+    {
+        const float l1Row = getBarycentric(edges[1], xStart, y);
+        const float l2Row = getBarycentric(edges[2], xStart, y);
+        const float zRow  = tri.Z[0] + l1Row * (tri.Z[1] - tri.Z[0]) + l2Row * (tri.Z[2] - tri.Z[0]);
+
+        glm::vec4* pColorRow = tile.pColor + (y - tile.Y0) * kTileSize;
+        float*     pDepthRow = tile.pDepth + (y - tile.Y0) * kTileSize;
+
+#if defined(SOFT_RASTERIZER_SSE2)
+        __m128i e0 = _mm_add_epi32(_mm_set1_epi32(edges[0].Evaluate(xStart, y)), edgeSteps[0]);
+        __m128i e1 = _mm_add_epi32(_mm_set1_epi32(edges[1].Evaluate(xStart, y)), edgeSteps[1]);
+        __m128i e2 = _mm_add_epi32(_mm_set1_epi32(edges[2].Evaluate(xStart, y)), edgeSteps[2]);
+        __m128  z  = _mm_add_ps(_mm_set1_ps(zRow), zSteps);
+#else
+        int32_t e[3][4];
+        float   z[4];
+        for (uint32_t i = 0; i < 3; ++i)
+        {
+            const int32_t start = edges[i].Evaluate(xStart, y);
+            for (int32_t lane = 0; lane < 4; ++lane)
+            {
+                e[i][lane] = start + lane * edges[i].A * kSubpixelScale;
+            }
+        }
+        for (int32_t lane = 0; lane < 4; ++lane)
+        {
+            z[lane] = zRow + static_cast<float>(lane) * dzdx;
+        }
+#endif
+
+        for (int32_t x = xStart; x <= x1; x += 4)
+        {
+            float* pDepth = pDepthRow + (x - tile.X0);
+
+            // Lanes past x1 may be outside the viewport
+            uint32_t mask = ((x1 - x) >= 3) ? 0xF : ((1u << (x1 - x + 1)) - 1);
+            float    depths[4];
+
+#if defined(SOFT_RASTERIZER_SSE2)
+            mask &= CoverageMask4(e0, e1, e2);
+            if (mask != 0)
+            {
+                const __m128 depth = _mm_loadu_ps(pDepth);
+                mask &= static_cast<uint32_t>(_mm_movemask_ps(_mm_cmplt_ps(z, depth)));
+                _mm_storeu_ps(depths, z);
+            }
+
+            e0 = _mm_add_epi32(e0, groupSteps[0]);
+            e1 = _mm_add_epi32(e1, groupSteps[1]);
+            e2 = _mm_add_epi32(e2, groupSteps[2]);
+            z  = _mm_add_ps(z, zGroupStep);
+#else
+            mask &= CoverageMask4(e[0], e[1], e[2]);
+            for (int32_t lane = 0; lane < 4; ++lane)
+            {
+                if (!(z[lane] < pDepth[lane]))
+                {
+                    mask &= ~(1u << lane);
+                }
+                depths[lane] = z[lane];
+            }
+
+            for (uint32_t i = 0; i < 3; ++i)
+            {
+                for (int32_t lane = 0; lane < 4; ++lane)
+                {
+                    e[i][lane] += 4 * edges[i].A * kSubpixelScale;
+                }
+            }
+            for (int32_t lane = 0; lane < 4; ++lane)
+            {
+                z[lane] += 4.0f * dzdx;
+            }
+#endif
+
+            for (; mask != 0; mask &= (mask - 1))
+            {
+                uint32_t lane = 0;
+                while ((mask & (1u << lane)) == 0)
+                {
+                    ++lane;
+                }
+
+                if (!hasAttributes)
+                {
+                    attributes    = GetVertexAttributes(mesh, modelMatrix, normalMatrix, tri);
+                    hasAttributes = true;
+                }
+
+                // Perspective correct barycentrics
+                const float offset = static_cast<float>(x - xStart + static_cast<int32_t>(lane));
+                const float l1     = l1Row + offset * dl1dx;
+                const float l2     = l2Row + offset * dl2dx;
+                const float q0     = (1.0f - l1 - l2) * tri.InvW[0];
+                const float q1     = l1 * tri.InvW[1];
+                const float q2     = l2 * tri.InvW[2];
+                const float invSum = 1.0f / (q0 + q1 + q2);
+                const float w0     = q0 * invSum;
+                const float w1     = q1 * invSum;
+                const float w2     = q2 * invSum;
+
+                SoftRasterizer::Fragment fragment = {};
+                fragment.X                        = static_cast<uint32_t>(x) + lane;
+                fragment.Y                        = static_cast<uint32_t>(y);
+                fragment.Depth                    = depths[lane];
+                fragment.Position                 = w0 * attributes.Position[0] + w1 * attributes.Position[1] + w2 * attributes.Position[2];
+                fragment.Normal                   = w0 * attributes.Normal[0] + w1 * attributes.Normal[1] + w2 * attributes.Normal[2];
+                fragment.Color                    = w0 * attributes.Color[0] + w1 * attributes.Color[1] + w2 * attributes.Color[2];
+                fragment.TexCoord                 = w0 * attributes.TexCoord[0] + w1 * attributes.TexCoord[1] + w2 * attributes.TexCoord[2];
+                fragment.TriangleIndex            = tri.TriangleIndex;
+                fragment.FrontFacing              = tri.FrontFacing;
+
+                const float normalLength = glm::length(fragment.Normal);
+                if (normalLength > 0)
+                {
+                    fragment.Normal /= normalLength;
+                }
+
+                pDepth[lane]                  = depths[lane];
+                pColorRow[x - tile.X0 + lane] = shader ? shader(fragment) : glm::vec4(fragment.Color, 1);
+                ++numFragments;
+            }
+        }
+    }
+
+    return numFragments;
+}
+
+} // namespace
+
+// =============================================================================
+// SoftRasterizer
+// =============================================================================
+SoftRasterizer::SoftRasterizer()
+    : mBatch(std::make_unique<Batch>())
+{
+}
+
+SoftRasterizer::~SoftRasterizer()
+{
+}
+
+void SoftRasterizer::Draw(
+    const TriMesh*     pMesh,
+    const glm::mat4&   modelMatrix,
+    const PixelShader& pixelShader,
+    CullMode           cullMode)
+{
+    if (IsNull(pMesh) || (pMesh->GetNumTriangles() == 0))
+    {
+        return;
+    }
+
+    DrawCall draw     = {};
+    draw.pMesh        = pMesh;
+    draw.ModelMatrix  = modelMatrix;
+    draw.NormalMatrix = glm::transpose(glm::inverse(glm::mat3(modelMatrix)));
+    draw.Shader       = pixelShader;
+    draw.Cull         = cullMode;
+    mDraws.push_back(draw);
+}
+
+SoftRasterizer::Stats SoftRasterizer::Render(const Camera& camera, const Options& options, Framebuffer* pFramebuffer)
+{
+    return Render(camera.GetViewProjectionMatrix(), options, pFramebuffer);
+}
+
+SoftRasterizer::Stats SoftRasterizer::Render(const glm::mat4& viewProjectionMatrix, const Options& options, Framebuffer* pFramebuffer)
+{
+    if (IsNull(pFramebuffer) || (pFramebuffer->Width == 0) || (pFramebuffer->Height == 0))
+    {
+        mDraws.clear();
+        return {};
+    }
+    if ((pFramebuffer->Width > kMaxViewportSize) || (pFramebuffer->Height > kMaxViewportSize))
+    {
+        assert(false && "framebuffer exceeds the maximum viewport size");
+        mDraws.clear();
+        return {};
+    }
+
+    auto startTime = std::chrono::high_resolution_clock::now();
+
+    uint64_t numTriangles = 0;
+    for (DrawCall& draw : mDraws)
+    {
+        draw.MVPMatrix     = viewProjectionMatrix * draw.ModelMatrix;
+        draw.FirstTriangle = numTriangles;
+        numTriangles += draw.pMesh->GetNumTriangles();
+    }
+
+    const Viewport viewport = GetViewport(pFramebuffer->Width, pFramebuffer->Height);
+    const uint32_t numTiles = viewport.NumTilesX * viewport.NumTilesY;
+
+    uint32_t numThreads = options.NumThreads;
+    if (numThreads == 0)
+    {
+        numThreads = JobSystem::Get().GetNumThreads();
+    }
+
+    Batch& batch = *mBatch;
+    batch.Resize(numThreads, numTiles);
+
+    const uint64_t batchSize = numThreads * kBatchTrianglesPerThread;
+
+    // Tiles are handed out from the counter, reset before each raster stage
+    std::atomic<uint32_t> nextTile = 0;
+
+    auto setupSlice = [&](uint32_t slot, uint64_t begin, uint64_t end) {
+        Batch::Slice& slice = batch.Slices[slot];
+        slice.Triangles.clear();
+        for (auto& bin : slice.Bins)
+        {
+            bin.clear();
+        }
+
+        // First draw with triangles in the slice
+        size_t drawIndex = 0;
+        while ((drawIndex + 1 < mDraws.size()) && (mDraws[drawIndex + 1].FirstTriangle <= begin))
+        {
+            ++drawIndex;
+        }
+
+        for (uint64_t i = begin; i < end;)
+        {
+            const DrawCall&                       draw      = mDraws[drawIndex];
+            const std::vector<TriMesh::Triangle>& triangles = draw.pMesh->GetTriangles();
+            const std::vector<glm::vec3>&         positions = draw.pMesh->GetPositions();
+
+            const uint64_t drawEnd = std::min(end, draw.FirstTriangle + triangles.size());
+            for (; i < drawEnd; ++i)
+            {
+                const uint32_t           triangleIndex = static_cast<uint32_t>(i - draw.FirstTriangle);
+                const TriMesh::Triangle& triangle      = triangles[triangleIndex];
+
+                ClipVertex vertices[kMaxClipVertices];
+                vertices[0] = {draw.MVPMatrix * glm::vec4(positions[triangle.vIdx0], 1), glm::vec3(1, 0, 0)};
+                vertices[1] = {draw.MVPMatrix * glm::vec4(positions[triangle.vIdx1], 1), glm::vec3(0, 1, 0)};
+                vertices[2] = {draw.MVPMatrix * glm::vec4(positions[triangle.vIdx2], 1), glm::vec3(0, 0, 1)};
+
+                // Entirely outside one of the frustum planes
+                if ((GetOutcode(vertices[0].Position) & GetOutcode(vertices[1].Position) & GetOutcode(vertices[2].Position)) != 0)
+                {
+                    continue;
+                }
+
+                uint32_t numVertices = 3;
+                if (!InsideClipPlanes(viewport, vertices[0].Position) || !InsideClipPlanes(viewport, vertices[1].Position) || !InsideClipPlanes(viewport, vertices[2].Position))
+                {
+                    numVertices = ClipPolygon(viewport.ClipPlanes, kNumClipPlanes, vertices, numVertices);
+                }
+
+                // Fan out whatever is left
+                for (uint32_t j = 2; j < numVertices; ++j)
+                {
+                    if (SetupAndBinTriangle(viewport, vertices[0], vertices[j - 1], vertices[j], draw.Cull, static_cast<uint32_t>(drawIndex), triangleIndex, &slice.Triangles, &slice.Bins))
+                    {
+                        ++slice.NumSetupTriangles;
+                    }
+                }
+            }
+            ++drawIndex;
+        }
+    };
+
+    auto rasterizeTile = [&](uint32_t slot, uint32_t tileIndex) {
+        bool empty = true;
+        for (const Batch::Slice& slice : batch.Slices)
+        {
+            empty = empty && slice.Bins[tileIndex].empty();
+        }
+        if (empty)
+        {
+            return;
+        }
+
+        Tile tile   = {};
+        tile.X0     = static_cast<int32_t>(tileIndex % viewport.NumTilesX) * kTileSize;
+        tile.Y0     = static_cast<int32_t>(tileIndex / viewport.NumTilesX) * kTileSize;
+        tile.X1     = std::min(tile.X0 + kTileSize, static_cast<int32_t>(viewport.Width));
+        tile.Y1     = std::min(tile.Y0 + kTileSize, static_cast<int32_t>(viewport.Height));
+        tile.pColor = DataPtr(batch.TileColor[slot]);
+        tile.pDepth = DataPtr(batch.TileDepth[slot]);
+
+        const uint32_t tileWidth = static_cast<uint32_t>(tile.X1 - tile.X0);
+        for (int32_t y = tile.Y0; y < tile.Y1; ++y)
+        {
+            const size_t offset = static_cast<size_t>(y) * viewport.Width + tile.X0;
+            std::copy_n(pFramebuffer->Color.begin() + offset, tileWidth, tile.pColor + (y - tile.Y0) * kTileSize);
+            std::copy_n(pFramebuffer->Depth.begin() + offset, tileWidth, tile.pDepth + (y - tile.Y0) * kTileSize);
+        }
+
+        uint64_t numFragments = 0;
+        for (const Batch::Slice& slice : batch.Slices)
+        {
+            for (uint32_t index : slice.Bins[tileIndex])
+            {
+                const SetupTriangle& tri  = slice.Triangles[index];
+                const DrawCall&      draw = mDraws[tri.DrawIndex];
+                numFragments += RasterizeTriangle(*draw.pMesh, draw.ModelMatrix, draw.NormalMatrix, draw.Shader, tri, tile);
+            }
+        }
+        batch.Slices[slot].NumFragments += numFragments;
+
+        for (int32_t y = tile.Y0; y < tile.Y1; ++y)
+        {
+            const size_t offset = static_cast<size_t>(y) * viewport.Width + tile.X0;
+            std::copy_n(tile.pColor + (y - tile.Y0) * kTileSize, tileWidth, pFramebuffer->Color.begin() + offset);
+            std::copy_n(tile.pDepth + (y - tile.Y0) * kTileSize, tileWidth, pFramebuffer->Depth.begin() + offset);
+        }
+    };
+
+    //
+    // Each stage is a ParallelFor() over the numThreads slots, one piece per
+    // slot, so a slot's slice and tile scratch are only ever used by the
+    // thread that took its piece. ParallelFor() returning separates the
+    // stages, setup must finish before any tile reads the bins.
+    //
+    JobSystem& jobSystem = JobSystem::Get();
+    for (uint64_t batchBegin = 0; batchBegin < numTriangles; batchBegin += batchSize)
+    {
+        const uint64_t batchEnd   = std::min(batchBegin + batchSize, numTriangles);
+        const uint64_t batchCount = batchEnd - batchBegin;
+
+        jobSystem.ParallelFor(
+            0,
+            numThreads,
+            1,
+            [&](uint32_t firstSlot, uint32_t endSlot) {
+                for (uint32_t slot = firstSlot; slot < endSlot; ++slot)
+                {
+                    setupSlice(slot, batchBegin + (batchCount * slot) / numThreads, batchBegin + (batchCount * (slot + 1)) / numThreads);
+                }
+            },
+            numThreads);
+
+        nextTile.store(0);
+        jobSystem.ParallelFor(
+            0,
+            numThreads,
+            1,
+            [&](uint32_t firstSlot, uint32_t endSlot) {
+                for (uint32_t slot = firstSlot; slot < endSlot; ++slot)
+                {
+                    for (uint32_t tileIndex = nextTile++; tileIndex < numTiles; tileIndex = nextTile++)
+                    {
+                        rasterizeTile(slot, tileIndex);
+                    }
+                }
+            },
+            numThreads);
+    }
+
+    auto endTime = std::chrono::high_resolution_clock::now();
+
+    Stats stats        = {};
+    stats.NumTriangles = numTriangles;
+    stats.NumThreads   = numThreads;
+    stats.ElapsedMs    = std::chrono::duration<double, std::milli>(endTime - startTime).count();
+    for (const Batch::Slice& slice : batch.Slices)
+    {
+        stats.NumSetupTriangles += slice.NumSetupTriangles;
+        stats.NumFragments += slice.NumFragments;
+    }
+    stats.TrianglesPerSecond = (stats.ElapsedMs > 0) ? (numTriangles / (stats.ElapsedMs / 1000.0)) : 0;
+
+    mDraws.clear();
+
+    return stats;
+}
@@ -0,0 +1,127 @@
+#pragma once
+
+#include "config.h"
+#include "bitmap.h"
+#include "camera.h"
+#include "tri_mesh.h"
+
+#include <glm/glm.hpp>
+
+#include <functional>
+
+//
+// Tile binned software rasterizer
+//
+// Draws TriMesh instances into a color and depth buffer on the CPU, for
+// reference frames on machines without a GPU and for measuring how much
+// geometry a frame can push. Follows the same rules as the Vulkan and
+// D3D12 samples, so a frame lines up with theirs pixel for pixel:
+//
+//   - Clip space is the one the samples' matrices produce, triangles are
+//     clipped to 0 <= z <= w and depth is z / w.
+//   - NDC +Y is up, pixel row 0 is the top of the image.
+//   - Counter clockwise triangles are front facing.
+//   - Depth test is LESS, the depth buffer clears to 1.
+//   - Pixel centers are at +0.5, vertices snap to 1/16 pixel and shared
+//     edges follow the top-left rule: no gaps, no double hits.
+//
+// Frames go through in batches of triangles, each in two job system
+// ParallelFor() stages over Options::NumThreads slots:
+//
+//   1. Geometry: every slot takes a contiguous slice of the batch,
+//      transforms, culls, clips and snaps its triangles, then bins them
+//      into the 64x64 tiles they touch.
+//   2. Raster: slots take whole tiles. A tile's triangles are walked
+//      slice by slice, so they come out in submission order and the image
+//      doesn't depend on the slot count. Edge functions are evaluated 4
+//      pixels at a time with SSE2 integer math, depth is tested before
+//      shading and only surviving pixels call the pixel shader.
+//
+// Draws only keep a pointer to their mesh, it has to stay alive until
+// Render() returns.
+//
+class SoftRasterizer
+{
+public:
+    enum CullMode
+    {
+        CULL_MODE_NONE  = 0,
+        CULL_MODE_BACK  = 1,
+        CULL_MODE_FRONT = 2,
+    };
+
+    struct Options
+    {
+        uint32_t NumThreads = 0; // Cap on job system threads, 0 uses them all
+    };
+
+    struct Stats
+    {
+        uint64_t NumTriangles       = 0; // Submitted
+        uint64_t NumSetupTriangles  = 0; // Left after culling and clipping, clipped triangles may be split
+        uint64_t NumFragments       = 0; // Passed the depth test and shaded
+        uint32_t NumThreads         = 0;
+        double   ElapsedMs          = 0;
+        double   TrianglesPerSecond = 0; // Submitted triangles
+    };
+
+    //
+    // Interpolated attributes of a pixel that passed the depth test.
+    // Position and Normal are world space. Attributes the mesh doesn't
+    // have are zero, except Color which is white.
+    //
+    struct Fragment
+    {
+        uint32_t  X             = 0;
+        uint32_t  Y             = 0;
+        float     Depth         = 0;
+        glm::vec3 Position      = glm::vec3(0);
+        glm::vec3 Normal        = glm::vec3(0);
+        glm::vec3 Color         = glm::vec3(1);
+        glm::vec2 TexCoord      = glm::vec2(0);
+        uint32_t  TriangleIndex = 0; // Index into the mesh's triangles
+        bool      FrontFacing   = true;
+    };
+
+    // Called from the raster threads, possibly at the same time
+    using PixelShader = std::function<glm::vec4(const Fragment&)>;
+
+    // Width * Height entries each, row major, row 0 is the top
+    struct Framebuffer
+    {
+        uint32_t               Width  = 0;
+        uint32_t               Height = 0;
+        std::vector<glm::vec4> Color;
+        std::vector<float>     Depth;
+
+        void Resize(uint32_t width, uint32_t height);
+        void Clear(const glm::vec4& color, float depth = 1.0f);
+
+        // Saturated and scaled to 8 bits, no sRGB encode - same as writing to an UNORM swapchain
+        BitmapRGBA8u ToBitmap() const;
+    };
+
+    SoftRasterizer();
+    ~SoftRasterizer();
+
+    //
+    // Queues a draw for the next Render(). A null pixel shader outputs the
+    // vertex color. Everything queued is drawn in order and the queue is
+    // emptied when Render() returns.
+    //
+    void Draw(
+        const TriMesh*     pMesh,
+        const glm::mat4&   modelMatrix,
+        const PixelShader& pixelShader = nullptr,
+        CullMode           cullMode    = CULL_MODE_BACK);
+
+    Stats Render(const glm::mat4& viewProjectionMatrix, const Options& options, Framebuffer* pFramebuffer);
+    Stats Render(const Camera& camera, const Options& options, Framebuffer* pFramebuffer);
+
+private:
+    struct DrawCall;
+    struct Batch;
+
+    std::vector<DrawCall>  mDraws;
+    std::unique_ptr<Batch> mBatch;
+};
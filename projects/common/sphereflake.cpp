@@ -1,4 +1,5 @@
 #include "sphereflake.h"
+#include "job_system.h"
 
 #define GLM_ENABLE_EXPERIMENTAL
 #include <glm/glm.hpp>
@@ -6,20 +7,214 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtx/quaternion.hpp>
 #include <glm/gtx/transform.hpp>
-using glm::mat4;
+using glm::mat3;
+using glm::mat3x4;
 using glm::vec3;
 using glm::vec4;
 
+
 //
 // Quick sphereflake generator using Eric Haines' sphereflake algorithm from SPD:
 // https://www.realtimerendering.com/resources/SPD/
 //
 // This version cheats a little by using the coordinates generated by
-// gen_sphereflake_coords as fixed offsets. Each sphereflake child's 
-// position is rotated into the parent's orientation from the initial 
-// orientation vector, which is <0, 0, 1>. Then the child offset is
-// applied to the parent center to get the final child position.
+// gen_sphereflake_coords as fixed offsets. Each sphere carries a frame,
+// the rotation from the initial orientation vector <0, 0, 1> to its own.
+// A child's offset is rotated by the parent's frame and added to the
+// parent center to get the child position. The child's frame is the
+// shortest arc rotation from <0, 0, 1> to that offset.
+//
+// The instanced version composes the frames instead: the child's frame
+// is the parent's followed by the rotation to the unrotated offset. That
+// makes every child an exact copy of the whole flake, which is what lets
+// it share one cluster.
+//
+
+namespace {
+
+// Spheres this many levels down are far below float precision
+const int kMaxLevels = 16;
+
+// Below this many spheres splitting the work costs more than it saves
+const uint64_t kMinParallelSpheres = 65536;
+
+// clang-format off
+const vec3 kSphereFlakeVectors[9] = {
+    { 0.408248290f,  0.408248290f, 0.816496581f},
+    { 0.965925826f,  0.258819045f, 0.000000000f},
+    { 0.258819045f,  0.965925826f, 0.000000000f},
+    {-0.557677536f,  0.149429245f, 0.816496581f},
+    {-0.707106781f,  0.707106781f, 0.000000000f},
+    {-0.965925826f, -0.258819045f, 0.000000000f},
+    { 0.149429245f, -0.557677536f, 0.816496581f},
+    {-0.258819045f, -0.965925826f, 0.000000000f},
+    { 0.707106781f, -0.707106781f, 0.000000000f},
+};
+// clang-format on
+
+const vec3 kSphereOrientation = vec3(0, 0, 1);
+
+struct ChildFrames
+{
+    vec3 directions[9]; // Normalized offsets
+    mat3 frames[9];
+};
+
+// Rotation from kSphereOrientation to each of the offsets, built once
+const ChildFrames& GetChildFrames()
+{
+    static const ChildFrames sChildFrames = []() {
+        ChildFrames childFrames = {};
+        for (uint32_t i = 0; i < 9; ++i) {
+            childFrames.directions[i] = glm::normalize(kSphereFlakeVectors[i]);
+            childFrames.frames[i]     = glm::toMat3(glm::rotation(kSphereOrientation, childFrames.directions[i]));
+        }
+        return childFrames;
+    }();
+    return sChildFrames;
+}
+
+// Frame of child i of a parent with parentFrame, dir is the child's offset
+// direction. The shortest arc rotation turns quickly near -Z, so dir is
+// built from the normalized offsets: any error in it grows level by level.
+mat3 GetChildFrame(const ChildFrames& childFrames, const mat3& parentFrame, uint32_t i, const vec3& dir, bool composeFrames)
+{
+    if (composeFrames) {
+        return parentFrame * childFrames.frames[i];
+    }
+    return glm::toMat3(glm::rotation(kSphereOrientation, dir));
+}
+
+struct FlakeNode
+{
+    mat3     frame;
+    vec3     center;
+    float    radius;
+    float    childRadius;
+    uint64_t firstChild; // Depth first position of the first child
+};
+
+SphereFlake GetAABB(const vec3& center, float radius)
+{
+    SphereFlake sphere = {};
+    sphere.aabbMin     = center - vec3(radius);
+    sphere.aabbMax     = center + vec3(radius);
+    return sphere;
+}
+
+FlakeNode GetRootNode(float childRadius, float parentRadius, const vec3& parentCenter, const vec3& parentOrientation)
+{
+    FlakeNode root   = {};
+    root.frame       = glm::toMat3(glm::rotation(kSphereOrientation, glm::normalize(parentOrientation)));
+    root.center      = parentCenter;
+    root.radius      = parentRadius;
+    root.childRadius = childRadius;
+    root.firstChild  = 0;
+    return root;
+}
+
+//
+// Writes the GetSphereFlakeCount(numLevels) spheres under root to
+// pSpheres in depth first order. The stack holds one parent per level,
+// so the walk never allocates.
+//
+void GenerateSubtree(const FlakeNode& root, int numLevels, bool composeFrames, SphereFlake* pSpheres)
+{
+    if (numLevels <= 0) {
+        return;
+    }
+
+    struct StackEntry
+    {
+        mat3     frame;
+        vec3     center;
+        float    radius;
+        float    childRadius;
+        uint32_t nextChild;
+    };
+
+    const ChildFrames& childFrames = GetChildFrames();
+
+    StackEntry stack[kMaxLevels] = {};
+    stack[0]                     = {root.frame, root.center, root.radius, root.childRadius, 0};
+
+    int top = 0;
+    while (top >= 0) {
+        StackEntry& parent = stack[top];
+        if (parent.nextChild == 9) {
+            --top;
+            continue;
+        }
+
+        const uint32_t i      = parent.nextChild++;
+        const float    radius = parent.childRadius;
+        const vec3     dir    = parent.frame * childFrames.directions[i];
+        const vec3     center = parent.center + (parent.radius + radius) * dir;
+
+        *pSpheres = GetAABB(center, radius);
+        ++pSpheres;
+
+        if ((top + 1) < numLevels) {
+            StackEntry& child = stack[top + 1];
+            child.frame       = GetChildFrame(childFrames, parent.frame, i, dir, composeFrames);
+            child.center      = center;
+            child.radius      = radius;
+            child.childRadius = radius / 3.0f;
+            child.nextChild   = 0;
+            ++top;
+        }
+    }
+}
+
 //
+// Children of every parent, 9 per parent in the same order.
+// childSubtreeSize is the number of spheres in each child's subtree,
+// counting the child, and places the children in depth first order.
+// If pSpheres isn't null the children are written there.
+//
+void ExpandLevel(
+    const std::vector<FlakeNode>& parents,
+    uint64_t                      childSubtreeSize,
+    bool                          composeFrames,
+    SphereFlake*                  pSpheres,
+    std::vector<FlakeNode>*       pChildren)
+{
+    const ChildFrames& childFrames = GetChildFrames();
+
+    pChildren->resize(9 * parents.size());
+
+    FlakeNode* pChild = DataPtr(*pChildren);
+    for (const FlakeNode& parent : parents) {
+        for (uint32_t i = 0; i < 9; ++i, ++pChild) {
+            const uint64_t position = parent.firstChild + i * childSubtreeSize;
+            const vec3     dir      = parent.frame * childFrames.directions[i];
+
+            pChild->frame       = GetChildFrame(childFrames, parent.frame, i, dir, composeFrames);
+            pChild->center      = parent.center + (parent.radius + parent.childRadius) * dir;
+            pChild->radius      = parent.childRadius;
+            pChild->childRadius = parent.childRadius / 3.0f;
+            pChild->firstChild  = position + 1;
+
+            if (!IsNull(pSpheres)) {
+                pSpheres[position] = GetAABB(pChild->center, pChild->radius);
+            }
+        }
+    }
+}
+
+} // namespace
+
+uint64_t GetSphereFlakeCount(int numLevels)
+{
+    uint64_t count     = 0;
+    uint64_t levelSize = 1;
+    for (int level = 0; level < numLevels; ++level) {
+        levelSize *= 9;
+        count += levelSize;
+    }
+    return count;
+}
+
 void GenerateSphereFlake(
     int                       level,
     int                       maxLevels,
@@ -29,40 +224,115 @@ void GenerateSphereFlake(
     const glm::vec3&          parentOrientation,
     std::vector<SphereFlake>& spheres)
 {
-    if (level >= maxLevels) {
+    const int numLevels = std::min(maxLevels - level, kMaxLevels);
+    if (numLevels <= 0) {
         return;
     }
 
-    // clang-format off
-    const std::vector<vec3> kSphereFlakeVectors = {
-        { 0.408248290f,  0.408248290f, 0.816496581f},
-        { 0.965925826f,  0.258819045f, 0.000000000f},
-        { 0.258819045f,  0.965925826f, 0.000000000f},
-        {-0.557677536f,  0.149429245f, 0.816496581f},
-        {-0.707106781f,  0.707106781f, 0.000000000f},
-        {-0.965925826f, -0.258819045f, 0.000000000f},
-        { 0.149429245f, -0.557677536f, 0.816496581f},
-        {-0.258819045f, -0.965925826f, 0.000000000f},
-        { 0.707106781f, -0.707106781f, 0.000000000f},
-    };
-    // clang-format on
+    const uint64_t count = GetSphereFlakeCount(numLevels);
+    const size_t   first = spheres.size();
+    spheres.resize(first + count);
+
+    SphereFlake*    pSpheres = DataPtr(spheres) + first;
+    const FlakeNode root     = GetRootNode(childRadius, parentRadius, parentCenter, parentOrientation);
+
+    JobSystem&     jobSystem  = JobSystem::Get();
+    const uint32_t numThreads = jobSystem.GetNumThreads();
+    if ((numThreads == 1) || (count < kMinParallelSpheres)) {
+        GenerateSubtree(root, numLevels, false, pSpheres);
+        return;
+    }
+
+    //
+    // Expand the top levels until there are a few subtrees per thread,
+    // then hand those out. Every subtree's position is known up front so
+    // the threads write straight into place.
+    //
+    std::vector<FlakeNode> subtrees = {root};
+    std::vector<FlakeNode> children;
+
+    int depth = 0;
+    while (((depth + 1) < numLevels) && (subtrees.size() < (4 * numThreads))) {
+        ++depth;
+        ExpandLevel(subtrees, 1 + GetSphereFlakeCount(numLevels - depth), false, pSpheres, &children);
+        std::swap(subtrees, children);
+    }
+
+    const int subtreeLevels = numLevels - depth;
+
+    jobSystem.ParallelFor(0, CountU32(subtrees), 1, [&](uint32_t begin, uint32_t end) {
+        for (uint32_t i = begin; i < end; ++i) {
+            GenerateSubtree(subtrees[i], subtreeLevels, false, pSpheres + subtrees[i].firstChild);
+        }
+    });
+}
+
+void GenerateSphereFlakeInstanced(
+    int                   maxLevels,
+    int                   clusterLevels,
+    float                 childRadius,
+    float                 parentRadius,
+    const glm::vec3&      parentCenter,
+    const glm::vec3&      parentOrientation,
+    SphereFlakeInstances* pInstances)
+{
+    if (IsNull(pInstances)) {
+        return;
+    }
+
+    pInstances->spheres.clear();
+    pInstances->cluster.clear();
+    pInstances->transforms.clear();
+
+    const int numLevels = std::min(maxLevels, kMaxLevels);
+    if (numLevels <= 0) {
+        return;
+    }
+    clusterLevels = std::clamp(clusterLevels, 0, numLevels - 1);
+
+    // Every level past the first shrinks by 3, so does the cluster
+    FlakeNode unitSphere   = {};
+    unitSphere.frame       = mat3(1);
+    unitSphere.center      = vec3(0);
+    unitSphere.radius      = 1.0f;
+    unitSphere.childRadius = 1.0f / 3.0f;
+
+    pInstances->cluster.resize(1 + GetSphereFlakeCount(clusterLevels));
+    pInstances->cluster[0] = GetAABB(unitSphere.center, unitSphere.radius);
+    GenerateSubtree(unitSphere, clusterLevels, true, DataPtr(pInstances->cluster) + 1);
+
+    // Walk down to the parents of the instanced level, keeping the spheres on the way
+    const int instancedLevel = numLevels - clusterLevels;
+
+    std::vector<FlakeNode> parents = {GetRootNode(childRadius, parentRadius, parentCenter, parentOrientation)};
+    std::vector<FlakeNode> children;
+
+    pInstances->spheres.reserve(GetSphereFlakeCount(instancedLevel - 1));
+    for (int level = 1; level < instancedLevel; ++level) {
+        ExpandLevel(parents, 0, true, nullptr, &children);
+        std::swap(parents, children);
+
+        for (const FlakeNode& node : parents) {
+            pInstances->spheres.push_back(GetAABB(node.center, node.radius));
+        }
+    }
 
-    const vec3 kSphereOrienation = vec3(0, 0, 1);
+    // The instanced level only needs its transforms, skip keeping the nodes
+    const ChildFrames& childFrames = GetChildFrames();
 
-    glm::quat rotQuat = glm::rotation(kSphereOrienation, parentOrientation);
-    mat4      rotMat  = glm::toMat4(rotQuat);
+    pInstances->transforms.resize(9 * parents.size());
 
-    float dist = parentRadius + childRadius;
-    for (uint32_t i = 0; i < 9; ++i) {
-        auto dir           = glm::normalize(kSphereFlakeVectors[i]);
-        dir                = rotMat * vec4(dir, 0);
-        vec3        offset = parentCenter + (dist * dir);
-        SphereFlake sphere = {};
-        sphere.aabbMin     = offset + vec3(-childRadius);
-        sphere.aabbMax     = offset + vec3(childRadius);
-        spheres.push_back(sphere);
+    mat3x4* pTransform = DataPtr(pInstances->transforms);
+    for (const FlakeNode& parent : parents) {
+        for (uint32_t i = 0; i < 9; ++i, ++pTransform) {
+            const vec3 dir    = parent.frame * childFrames.directions[i];
+            const vec3 center = parent.center + (parent.radius + parent.childRadius) * dir;
+            const mat3 basis  = (parent.frame * childFrames.frames[i]) * parent.childRadius;
 
-        vec3 center = (sphere.aabbMax + sphere.aabbMin) / 2.0f;
-        GenerateSphereFlake(level + 1, maxLevels, childRadius / 3.0f, childRadius, center, dir, spheres);
+            // glm stores columns, the TLAS takes rows
+            for (int row = 0; row < 3; ++row) {
+                (*pTransform)[row] = vec4(basis[0][row], basis[1][row], basis[2][row], center[row]);
+            }
+        }
     }
-}
\ No newline at end of file
+}
@@ -10,6 +10,21 @@ struct SphereFlake
     glm::vec3 aabbMax;
 };
 
+//
+// Number of spheres GenerateSphereFlake() adds for numLevels levels of
+// children: 9 + 81 + ... + 9^numLevels. Every level adds 9x as many as
+// the one before, 7 levels is 5.4M spheres and 8 levels is 48M.
+//
+uint64_t GetSphereFlakeCount(int numLevels);
+
+//
+// Appends the children of the parent sphere, maxLevels - level levels
+// deep, in depth first order: each child is followed by its own
+// children. The parent itself isn't added.
+//
+// Large flakes are split by subtree across threads and written straight
+// into place, nothing is allocated past the initial resize.
+//
 void GenerateSphereFlake(
     int                       level,
     int                       maxLevels,
@@ -18,3 +33,39 @@ void GenerateSphereFlake(
     const glm::vec3&          parentCenter,
     const glm::vec3&          parentOrientation,
     std::vector<SphereFlake>& spheres);
+
+//
+// Instanced sphereflake
+//
+// Each child sphere and its children are the whole flake, a level
+// shallower, scaled, rotated and moved into place. So the bottom
+// clusterLevels levels are generated once, around a unit sphere at the
+// origin pointing down +Z, and each sphere clusterLevels levels above the
+// bottom gets a transform that instances the cluster in its place. The
+// levels above those are plain spheres.
+//
+// For 8 levels with a cluster of 4, that's 819 spheres, 7381 cluster
+// spheres and 6561 transforms standing in for 48M spheres. Put the
+// cluster in one BLAS and the spheres in another, the TLAS takes one
+// instance per transform. clusterLevels = 0 gives a single sphere
+// cluster and a transform per bottom level sphere.
+//
+struct SphereFlakeInstances
+{
+    // Levels above the instanced one, world space, level by level
+    std::vector<SphereFlake> spheres;
+    // Unit sphere at the origin and clusterLevels levels of children
+    std::vector<SphereFlake> cluster;
+    // Cluster to world, rows of a 3x4 matrix: the layout of
+    // VkTransformMatrixKHR and D3D12_RAYTRACING_INSTANCE_DESC::Transform
+    std::vector<glm::mat3x4> transforms;
+};
+
+void GenerateSphereFlakeInstanced(
+    int                   maxLevels,
+    int                   clusterLevels,
+    float                 childRadius,
+    float                 parentRadius,
+    const glm::vec3&      parentCenter,
+    const glm::vec3&      parentOrientation,
+    SphereFlakeInstances* pInstances);
@@ -3,14 +3,20 @@
 #endif
 
 #include "tri_mesh.h"
+#include "profiler.h"
 
 #define TINYOBJLOADER_IMPLEMENTATION
 #include "tiny_obj_loader.h"
 
 #if defined(TRIMESH_USE_MIKKTSPACE)
+#    include "job_system.h"
 #    include "mikktspace.h"
 #endif
 
+#if defined(TRIMESH_USE_MESHOPTIMIZER)
+#    include "meshoptimizer.h"
+#endif
+
 #define GLM_ENABLE_EXPERIMENTAL
 #include <glm/gtc/constants.hpp>
 #include <glm/gtc/matrix_transform.hpp>
@@ -19,6 +25,7 @@
 #include <glm/gtx/transform.hpp>
 #include <glm/gtx/string_cast.hpp>
 
+#include <algorithm>
 #include <filesystem>
 #include <fstream>
 #include <iomanip>
@@ -83,8 +90,31 @@ static inline glm::vec3 SphericalTangent(float theta, float phi)
 }
 
 #if defined(TRIMESH_USE_MIKKTSPACE)
+//
+// MikkTSpace runs once per group so that groups can be processed on
+// separate threads. Jobs write to their own result lists, which are applied
+// to the mesh in group order once all jobs are done - so the output doesn't
+// depend on the number of threads.
+//
+// Vertices shared between groups get the tangent from the last group that
+// uses them, the same as a vertex shared between faces within a group.
+//
 struct CalculateTangents
 {
+    struct Result
+    {
+        uint32_t  vIdx      = UINT32_MAX;
+        glm::vec3 tangent   = glm::vec3(0);
+        glm::vec3 bitangent = glm::vec3(0);
+    };
+
+    struct Job
+    {
+        const TriMesh*               pMesh            = nullptr;
+        const std::vector<uint32_t>* pTriangleIndices = nullptr; // All triangles if NULL
+        std::vector<Result>          results          = {};
+    };
+
     static int  getNumFaces(const SMikkTSpaceContext* pContext);
     static int  getNumVerticesOfFace(const SMikkTSpaceContext* pContext, const int iFace);
     static void getPosition(const SMikkTSpaceContext* pContext, float fvPosOut[], const int iFace, const int iVert);
@@ -92,7 +122,19 @@ struct CalculateTangents
     static void getTexCoord(const SMikkTSpaceContext* pContext, float fvTexcOut[], const int iFace, const int iVert);
     static void setTSpaceBasic(const SMikkTSpaceContext* pContext, const float fvTangent[], const float fSign, const int iFace, const int iVert);
 
-    static void Calculate(TriMesh* pMesh)
+    static uint32_t GetVertexIndex(const SMikkTSpaceContext* pContext, const int iFace, const int iVert)
+    {
+        const Job* pJob = static_cast<const Job*>(pContext->m_pUserData);
+        assert((pJob != nullptr) && "pJob is NULL!");
+
+        uint32_t triIdx = !IsNull(pJob->pTriangleIndices) ? (*pJob->pTriangleIndices)[iFace] : static_cast<uint32_t>(iFace);
+
+        const TriMesh::Triangle& tri            = pJob->pMesh->GetTriangles()[triIdx];
+        const uint32_t*          pVertexIndices = reinterpret_cast<const uint32_t*>(&tri);
+        return pVertexIndices[iVert];
+    }
+
+    static void CalculateJob(Job* pJob)
     {
         SMikkTSpaceInterface callbacks   = {};
         callbacks.m_getNumFaces          = CalculateTangents::getNumFaces;
@@ -104,18 +146,78 @@ struct CalculateTangents
 
         SMikkTSpaceContext context = {};
         context.m_pInterface       = &callbacks;
-        context.m_pUserData        = pMesh;
+        context.m_pUserData        = pJob;
 
         genTangSpace(&context, 180.0f);
     }
+
+    static void Calculate(TriMesh* pMesh, uint32_t numThreads = 0)
+    {
+        GREX_PROFILE_SCOPE("TriMesh::CalculateTangents");
+
+        const uint32_t numTriangles = pMesh->GetNumTriangles();
+
+        // Triangles that aren't in a group are processed as one more job
+        std::vector<uint32_t> ungroupedTriangles;
+        std::vector<Job>      jobs;
+        if (pMesh->GetNumGroups() == 0)
+        {
+            jobs.push_back({pMesh, nullptr});
+        }
+        else
+        {
+            std::vector<bool> grouped(numTriangles, false);
+            for (auto& group : pMesh->GetGroups())
+            {
+                jobs.push_back({pMesh, &group.GetTriangleIndices()});
+                for (auto triIdx : group.GetTriangleIndices())
+                {
+                    grouped[triIdx] = true;
+                }
+            }
+
+            for (uint32_t triIdx = 0; triIdx < numTriangles; ++triIdx)
+            {
+                if (!grouped[triIdx])
+                {
+                    ungroupedTriangles.push_back(triIdx);
+                }
+            }
+            if (!ungroupedTriangles.empty())
+            {
+                jobs.push_back({pMesh, &ungroupedTriangles});
+            }
+        }
+
+        // One group per piece, groups can be very different in size
+        JobSystem::Get().ParallelFor(
+            0,
+            static_cast<uint32_t>(jobs.size()),
+            1,
+            [&jobs](uint32_t begin, uint32_t end) {
+                for (uint32_t jobIdx = begin; jobIdx < end; ++jobIdx)
+                {
+                    CalculateJob(&jobs[jobIdx]);
+                }
+            },
+            numThreads);
+
+        for (auto& job : jobs)
+        {
+            for (auto& result : job.results)
+            {
+                pMesh->SetTangents(result.vIdx, result.tangent, result.bitangent);
+            }
+        }
+    }
 };
 
 int CalculateTangents::getNumFaces(const SMikkTSpaceContext* pContext)
 {
-    TriMesh* pMesh = static_cast<TriMesh*>(pContext->m_pUserData);
-    assert((pMesh != nullptr) && "pMesh is NULL!");
+    const Job* pJob = static_cast<const Job*>(pContext->m_pUserData);
+    assert((pJob != nullptr) && "pJob is NULL!");
 
-    int numFaces = static_cast<int>(pMesh->GetNumTriangles());
+    int numFaces = !IsNull(pJob->pTriangleIndices) ? static_cast<int>(pJob->pTriangleIndices->size()) : static_cast<int>(pJob->pMesh->GetNumTriangles());
     return numFaces;
 }
 
@@ -126,13 +228,9 @@ int CalculateTangents::getNumVerticesOfFace(const SMikkTSpaceContext*, const int
 
 void CalculateTangents::getPosition(const SMikkTSpaceContext* pContext, float fvPosOut[], const int iFace, const int iVert)
 {
-    TriMesh* pMesh = static_cast<TriMesh*>(pContext->m_pUserData);
-    assert((pMesh != nullptr) && "pMesh is NULL!");
-
-    const TriMesh::Triangle& tri            = pMesh->GetTriangles()[iFace];
-    const uint32_t*          pVertexIndices = reinterpret_cast<const uint32_t*>(&tri);
-    uint32_t                 vIdx           = pVertexIndices[iVert];
-    const glm::vec3&         position       = pMesh->GetPositions()[vIdx];
+    const Job*       pJob     = static_cast<const Job*>(pContext->m_pUserData);
+    uint32_t         vIdx     = GetVertexIndex(pContext, iFace, iVert);
+    const glm::vec3& position = pJob->pMesh->GetPositions()[vIdx];
 
     fvPosOut[0] = position.x;
     fvPosOut[1] = position.y;
@@ -141,13 +239,9 @@ void CalculateTangents::getPosition(const SMikkTSpaceContext* pContext, float fv
 
 void CalculateTangents::getNormal(const SMikkTSpaceContext* pContext, float fvNormOut[], const int iFace, const int iVert)
 {
-    TriMesh* pMesh = static_cast<TriMesh*>(pContext->m_pUserData);
-    assert((pMesh != nullptr) && "pMesh is NULL!");
-
-    const TriMesh::Triangle& tri            = pMesh->GetTriangles()[iFace];
-    const uint32_t*          pVertexIndices = reinterpret_cast<const uint32_t*>(&tri);
-    uint32_t                 vIdx           = pVertexIndices[iVert];
-    const glm::vec3&         normal         = pMesh->GetNormals()[vIdx];
+    const Job*       pJob   = static_cast<const Job*>(pContext->m_pUserData);
+    uint32_t         vIdx   = GetVertexIndex(pContext, iFace, iVert);
+    const glm::vec3& normal = pJob->pMesh->GetNormals()[vIdx];
 
     fvNormOut[0] = normal.x;
     fvNormOut[1] = normal.y;
@@ -156,13 +250,9 @@ void CalculateTangents::getNormal(const SMikkTSpaceContext* pContext, float fvNo
 
 void CalculateTangents::getTexCoord(const SMikkTSpaceContext* pContext, float fvTexcOut[], const int iFace, const int iVert)
 {
-    TriMesh* pMesh = static_cast<TriMesh*>(pContext->m_pUserData);
-    assert((pMesh != nullptr) && "pMesh is NULL!");
-
-    const TriMesh::Triangle& tri            = pMesh->GetTriangles()[iFace];
-    const uint32_t*          pVertexIndices = reinterpret_cast<const uint32_t*>(&tri);
-    uint32_t                 vIdx           = pVertexIndices[iVert];
-    const glm::vec2&         texCoord       = pMesh->GetTexCoords()[vIdx];
+    const Job*       pJob     = static_cast<const Job*>(pContext->m_pUserData);
+    uint32_t         vIdx     = GetVertexIndex(pContext, iFace, iVert);
+    const glm::vec2& texCoord = pJob->pMesh->GetTexCoords()[vIdx];
 
     fvTexcOut[0] = texCoord.x;
     fvTexcOut[1] = texCoord.y;
@@ -170,18 +260,14 @@ void CalculateTangents::getTexCoord(const SMikkTSpaceContext* pContext, float fv
 
 void CalculateTangents::setTSpaceBasic(const SMikkTSpaceContext* pContext, const float fvTangent[], const float fSign, const int iFace, const int iVert)
 {
-    TriMesh* pMesh = static_cast<TriMesh*>(pContext->m_pUserData);
-    assert((pMesh != nullptr) && "pMesh is NULL!");
-
-    const TriMesh::Triangle& tri            = pMesh->GetTriangles()[iFace];
-    const uint32_t*          pVertexIndices = reinterpret_cast<const uint32_t*>(&tri);
-    uint32_t                 vIdx           = pVertexIndices[iVert];
-    const glm::vec3&         normal         = pMesh->GetNormals()[vIdx];
+    Job*             pJob   = static_cast<Job*>(pContext->m_pUserData);
+    uint32_t         vIdx   = GetVertexIndex(pContext, iFace, iVert);
+    const glm::vec3& normal = pJob->pMesh->GetNormals()[vIdx];
 
     glm::vec3 tangent   = glm::vec3(fvTangent[0], fvTangent[1], fvTangent[2]);
     glm::vec3 bitangent = fSign * glm::cross(normal, glm::vec3(tangent));
 
-    pMesh->SetTangents(vIdx, tangent, bitangent);
+    pJob->results.push_back({vIdx, tangent, bitangent});
 }
 #else
 struct CalculateTangents
@@ -189,6 +275,32 @@ struct CalculateTangents
 };
 #endif // defined(TRIMESH_USE_MIKKTSPACE)
 
+#if defined(TRIMESH_USE_MESHOPTIMIZER)
+// Same cache size meshopt_optimizeVertexCache() optimizes for
+const uint32_t kVertexCacheSize = 16;
+
+// Moves vertex i to remap[i], vertices that map to UINT32_MAX are dropped
+template <typename T>
+static void RemapVertexAttribute(const std::vector<uint32_t>& remap, size_t newVertexCount, std::vector<T>* pAttribute)
+{
+    // Attributes that aren't enabled are empty
+    if (pAttribute->size() != remap.size())
+    {
+        return;
+    }
+
+    std::vector<T> remapped(newVertexCount);
+    for (size_t i = 0; i < remap.size(); ++i)
+    {
+        if (remap[i] != UINT32_MAX)
+        {
+            remapped[remap[i]] = (*pAttribute)[i];
+        }
+    }
+    *pAttribute = std::move(remapped);
+}
+#endif // defined(TRIMESH_USE_MESHOPTIMIZER)
+
 std::vector<uint32_t> TriMesh::GetIndices() const
 {
     std::vector<uint32_t> indices;
@@ -471,6 +583,159 @@ void TriMesh::SetTangents(uint32_t vIdx, const glm::vec3& tangent, const glm::ve
     mBitangents[vIdx] = bitangent;
 }
 
+void TriMesh::GenerateTangents(uint32_t numThreads)
+{
+#if defined(TRIMESH_USE_MIKKTSPACE)
+    CalculateTangents::Calculate(this, numThreads);
+#else
+    (void)numThreads;
+    assert(false && "GenerateTangents requires TRIMESH_USE_MIKKTSPACE");
+#endif
+}
+
+TriMesh::OptimizeStats TriMesh::Analyze() const
+{
+    TriMesh::OptimizeStats stats = {};
+
+#if defined(TRIMESH_USE_MESHOPTIMIZER)
+    if (mTriangles.empty())
+    {
+        return stats;
+    }
+
+    const std::vector<uint32_t> indices     = this->GetIndices();
+    const size_t                vertexCount = mPositions.size();
+
+    size_t vertexSize = sizeof(glm::vec3);
+    vertexSize += !mVertexColors.empty() ? sizeof(glm::vec3) : 0;
+    vertexSize += !mTexCoords.empty() ? sizeof(glm::vec2) : 0;
+    vertexSize += !mNormals.empty() ? sizeof(glm::vec3) : 0;
+    vertexSize += !mTangents.empty() ? 2 * sizeof(glm::vec3) : 0;
+
+    auto cacheStats    = meshopt_analyzeVertexCache(indices.data(), indices.size(), vertexCount, kVertexCacheSize, 0, 0);
+    auto overdrawStats = meshopt_analyzeOverdraw(indices.data(), indices.size(), reinterpret_cast<const float*>(mPositions.data()), vertexCount, sizeof(glm::vec3));
+    auto fetchStats    = meshopt_analyzeVertexFetch(indices.data(), indices.size(), vertexCount, vertexSize);
+
+    stats.acmr      = cacheStats.acmr;
+    stats.atvr      = cacheStats.atvr;
+    stats.overdraw  = overdrawStats.overdraw;
+    stats.overfetch = fetchStats.overfetch;
+#else
+    assert(false && "Analyze requires TRIMESH_USE_MESHOPTIMIZER");
+#endif
+
+    return stats;
+}
+
+void TriMesh::Optimize(float overdrawThreshold)
+{
+#if defined(TRIMESH_USE_MESHOPTIMIZER)
+    GREX_PROFILE_SCOPE("TriMesh::Optimize");
+
+    const size_t   vertexCount = mPositions.size();
+    const float*   pPositions  = reinterpret_cast<const float*>(mPositions.data());
+    const uint32_t numTris     = GetNumTriangles();
+
+    //
+    // Triangles are only reordered within their group and material, each
+    // group's triangle list keeps pointing at triangles of that group and
+    // material. Triangles that aren't in any group form one more partition.
+    //
+    std::vector<std::vector<uint32_t>> partitions;
+    {
+        std::vector<bool> assigned(numTris, false);
+        for (auto& group : mGroups)
+        {
+            const auto& triIndices = group.GetTriangleIndices();
+            const auto& matIndices = group.GetMaterialIndices();
+
+            std::map<int32_t, size_t> materialPartitions;
+            for (size_t i = 0; i < triIndices.size(); ++i)
+            {
+                uint32_t triIdx = triIndices[i];
+                if ((triIdx >= numTris) || assigned[triIdx])
+                {
+                    continue;
+                }
+                assigned[triIdx] = true;
+
+                auto it = materialPartitions.find(matIndices[i]);
+                if (it == materialPartitions.end())
+                {
+                    it = materialPartitions.insert({matIndices[i], partitions.size()}).first;
+                    partitions.push_back({});
+                }
+                partitions[(*it).second].push_back(triIdx);
+            }
+        }
+
+        std::vector<uint32_t> ungrouped;
+        for (uint32_t triIdx = 0; triIdx < numTris; ++triIdx)
+        {
+            if (!assigned[triIdx])
+            {
+                ungrouped.push_back(triIdx);
+            }
+        }
+        if (!ungrouped.empty())
+        {
+            partitions.push_back(std::move(ungrouped));
+        }
+    }
+
+    // Vertex cache, then overdraw
+    std::vector<uint32_t> indices;
+    std::vector<uint32_t> optimizedIndices;
+    for (const auto& partition : partitions)
+    {
+        indices.clear();
+        for (auto triIdx : partition)
+        {
+            const auto& tri = mTriangles[triIdx];
+            indices.push_back(tri.vIdx0);
+            indices.push_back(tri.vIdx1);
+            indices.push_back(tri.vIdx2);
+        }
+
+        optimizedIndices.resize(indices.size());
+        meshopt_optimizeVertexCache(optimizedIndices.data(), indices.data(), indices.size(), vertexCount);
+        meshopt_optimizeOverdraw(indices.data(), optimizedIndices.data(), optimizedIndices.size(), pPositions, vertexCount, sizeof(glm::vec3), overdrawThreshold);
+
+        // Write back in the order the group lists its triangles
+        for (size_t i = 0; i < partition.size(); ++i)
+        {
+            mTriangles[partition[i]] = {indices[3 * i + 0], indices[3 * i + 1], indices[3 * i + 2]};
+        }
+    }
+
+    // Vertex fetch - vertices are renumbered in the order they're first
+    // used, unreferenced vertices are dropped
+    indices = this->GetIndices();
+
+    std::vector<uint32_t> remap(vertexCount);
+    size_t                newVertexCount = meshopt_optimizeVertexFetchRemap(remap.data(), indices.data(), indices.size(), vertexCount);
+
+    RemapVertexAttribute(remap, newVertexCount, &mPositions);
+    RemapVertexAttribute(remap, newVertexCount, &mVertexColors);
+    RemapVertexAttribute(remap, newVertexCount, &mTexCoords);
+    RemapVertexAttribute(remap, newVertexCount, &mNormals);
+    RemapVertexAttribute(remap, newVertexCount, &mTangents);
+    RemapVertexAttribute(remap, newVertexCount, &mBitangents);
+
+    for (auto& tri : mTriangles)
+    {
+        tri.vIdx0 = remap[tri.vIdx0];
+        tri.vIdx1 = remap[tri.vIdx1];
+        tri.vIdx2 = remap[tri.vIdx2];
+    }
+
+    this->CalculateBounds();
+#else
+    (void)overdrawThreshold;
+    assert(false && "Optimize requires TRIMESH_USE_MESHOPTIMIZER");
+#endif
+}
+
 void TriMesh::CalculateBounds()
 {
     mBounds = {};
@@ -614,6 +879,8 @@ void TriMesh::WeldVertices(
     float texCoordDistanceThreshold,
     float normalAngleThreshold)
 {
+    GREX_PROFILE_SCOPE("TriMesh::WeldVertices");
+
     // if (mOptions.enableVertexColors || mOptions.enableTexCoords || mOptions.enableNormals || mOptions.enableTangents)
     if (mOptions.enableVertexColors || mOptions.enableTangents)
     {
@@ -1501,6 +1768,8 @@ TriMesh TriMesh::CornellBox(const TriMesh::Options& options)
 
 bool TriMesh::LoadOBJ(const std::string& path, const std::string& mtlBaseDir, const TriMesh::Options& options, TriMesh* pMesh)
 {
+    GREX_PROFILE_SCOPE("TriMesh::LoadOBJ");
+
     if (pMesh == nullptr)
     {
         return false;
@@ -1522,7 +1791,11 @@ bool TriMesh::LoadOBJ(const std::string& path, const std::string& mtlBaseDir, co
 
     std::string warn;
     std::string err;
-    bool        loaded = tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, path.c_str(), mtlBaseDir.c_str(), true);
+    bool        loaded = false;
+    {
+        GREX_PROFILE_SCOPE("tinyobj::LoadObj");
+        loaded = tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, path.c_str(), mtlBaseDir.c_str(), true);
+    }
 
     if (!loaded || !err.empty())
     {
@@ -1563,6 +1836,8 @@ bool TriMesh::LoadOBJ(const std::string& path, const std::string& mtlBaseDir, co
     // Build geometry
     for (size_t shapeIdx = 0; shapeIdx < numShapes; ++shapeIdx)
     {
+        GREX_PROFILE_SCOPE("TriMesh::LoadOBJ shape");
+
         const tinyobj::shape_t& shape     = shapes[shapeIdx];
         const tinyobj::mesh_t&  shapeMesh = shape.mesh;
 
@@ -1737,6 +2012,8 @@ bool TriMesh::LoadOBJ(const std::string& path, const std::string& mtlBaseDir, co
 
 bool TriMesh::LoadOBJ2(const std::string& path, TriMesh* pMesh)
 {
+    GREX_PROFILE_SCOPE("TriMesh::LoadOBJ2");
+
     if (pMesh == nullptr)
     {
         return false;
@@ -1748,7 +2025,11 @@ bool TriMesh::LoadOBJ2(const std::string& path, TriMesh* pMesh)
 
     std::string warn;
     std::string err;
-    bool        loaded = tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, path.c_str(), nullptr, false);
+    bool        loaded = false;
+    {
+        GREX_PROFILE_SCOPE("tinyobj::LoadObj");
+        loaded = tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, path.c_str(), nullptr, false);
+    }
 
     if (!loaded || !err.empty())
     {
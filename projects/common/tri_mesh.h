@@ -112,6 +112,17 @@ public:
         uint32_t vIdx2 = UINT32_MAX;
     };
 
+    // -------------------------------------------------------------------------
+    // OptimizeStats
+    // -------------------------------------------------------------------------
+    struct OptimizeStats
+    {
+        float acmr      = 0; // Average cache miss ratio - transformed vertices per triangle
+        float atvr      = 0; // Average transformed vertex ratio - 1.0 is optimal
+        float overdraw  = 0; // Pixels shaded per pixel covered
+        float overfetch = 0; // Vertex bytes fetched per vertex byte
+    };
+
     // -------------------------------------------------------------------------
     // Material
     // -------------------------------------------------------------------------
@@ -301,6 +312,23 @@ public:
         float texCoordDistanceThreshold = DEFAULT_TEX_COORD_DISTANCE_TRESHOLD,
         float normalAngleThreshold      = DEFAULT_NORMAL_ANGLE_THRESHOLD);
 
+    // Recalculates tangents and bitangents with MikkTSpace, groups run in
+    // parallel on the shared JobSystem. Needs TRIMESH_USE_MIKKTSPACE,
+    // normals, tex coords and enableTangents. numThreads caps the threads
+    // used, 0 uses the whole pool.
+    void GenerateTangents(uint32_t numThreads = 0);
+
+    // Vertex cache, overdraw and vertex fetch statistics from meshoptimizer's
+    // analyzers. Needs TRIMESH_USE_MESHOPTIMIZER.
+    TriMesh::OptimizeStats Analyze() const;
+
+    // Reorders triangles for the post transform vertex cache and then for
+    // overdraw, within each group and material. Vertices are then reordered
+    // for fetch locality and unreferenced vertices are dropped.
+    // overdrawThreshold is how much worse ACMR may get in exchange for less
+    // overdraw. Needs TRIMESH_USE_MESHOPTIMIZER.
+    void Optimize(float overdrawThreshold = 1.05f);
+
     std::vector<glm::vec3> GetTBNLineSegments(uint32_t* pNumVertices, float length = 0.1f) const;
 
     static TriMesh Box(
@@ -68,6 +68,81 @@ SceneGraph::SceneGraph(VulkanRenderer* pTheRenderer, VulkanPipelineLayout* pTheP
     this->InitializeDefaults();
 }
 
+SceneGraph::~SceneGraph()
+{
+    DestroyUploadBatch(&this->UploadBatch);
+}
+
+bool SceneGraph::BeginUploads(VkDeviceSize chunkSize)
+{
+    if (this->IsRecordingUploads())
+    {
+        return true;
+    }
+
+    // Previous batch must be done before its staging memory can go away
+    DestroyUploadBatch(&this->UploadBatch);
+
+    VkResult vkres = CreateUploadBatch(this->pRenderer, chunkSize, &this->UploadBatch);
+    if (vkres != VK_SUCCESS)
+    {
+        return false;
+    }
+
+    return true;
+}
+
+bool SceneGraph::SubmitUploads()
+{
+    if (!this->IsRecordingUploads())
+    {
+        return false;
+    }
+
+    VkResult vkres = SubmitUploadBatch(&this->UploadBatch);
+    if (vkres != VK_SUCCESS)
+    {
+        return false;
+    }
+
+    GREX_LOG_INFO("Submitted " << this->UploadBatch.NumUploads << " uploads (" << this->UploadBatch.NumBytes << " bytes)");
+
+    return true;
+}
+
+bool SceneGraph::IsUploadComplete() const
+{
+    if (!this->UploadBatch.Submitted)
+    {
+        return true;
+    }
+
+    return IsUploadBatchComplete(&this->UploadBatch);
+}
+
+bool SceneGraph::WaitUploads()
+{
+    if (!this->UploadBatch.Submitted)
+    {
+        return false;
+    }
+
+    VkResult vkres = WaitUploadBatch(&this->UploadBatch);
+    if (vkres != VK_SUCCESS)
+    {
+        return false;
+    }
+
+    DestroyUploadBatch(&this->UploadBatch);
+
+    return true;
+}
+
+bool SceneGraph::IsRecordingUploads() const
+{
+    return (this->UploadBatch.CmdBuf.CommandBuffer != VK_NULL_HANDLE) && !this->UploadBatch.Submitted;
+}
+
 bool SceneGraph::CreateTemporaryBuffer(
     uint32_t             size,
     const void*          pData,
@@ -126,6 +201,7 @@ void SceneGraph::DestroyTemporaryBuffer(
 
     VkFauxRender::Buffer* pBuffer = static_cast<VkFauxRender::Buffer*>(*ppBuffer);
 
+    ::DestroyBuffer(this->pRenderer, &pBuffer->Resource);
     delete pBuffer;
 
     *ppBuffer = nullptr;
@@ -143,19 +219,37 @@ bool SceneGraph::CreateBuffer(
         return false;
     }
 
-    VkBufferUsageFlags usageFlags = VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT;
+    // Indirect usage is needed for draw list argument buffers
+    VkBufferUsageFlags usageFlags =
+        VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT |
+        VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT;
 
     // Create the buffer resource
     VulkanBuffer resource;
     //
-    VkResult vkres = ::CreateBuffer(
-        this->pRenderer,
-        srcSize,
-        pSrcData,
-        usageFlags,
-        VMA_MEMORY_USAGE_GPU_ONLY,
-        0,
-        &resource);
+    VkResult vkres = VK_SUCCESS;
+    if (this->IsRecordingUploads() && !mappable)
+    {
+        vkres = ::CreateBuffer(
+            &this->UploadBatch,
+            srcSize,
+            pSrcData,
+            usageFlags,
+            VMA_MEMORY_USAGE_GPU_ONLY,
+            0,
+            &resource);
+    }
+    else
+    {
+        vkres = ::CreateBuffer(
+            this->pRenderer,
+            srcSize,
+            pSrcData,
+            usageFlags,
+            VMA_MEMORY_USAGE_GPU_ONLY,
+            0,
+            &resource);
+    }
 
     if (vkres != VK_SUCCESS)
     {
@@ -202,14 +296,46 @@ bool SceneGraph::CreateBuffer(
     // Create the buffer resource
     VulkanBuffer resource;
     //
-    HRESULT hr = ::CreateBuffer(
-        this->pRenderer,
-        usageFlags,
-        &pSrcResource,
-        &resource);
-    if (FAILED(hr))
+    if (this->IsRecordingUploads() && !mappable)
     {
-        return false;
+        //
+        // The loader reuses the source buffer for the next mesh as soon as
+        // this returns, so its contents are copied into the batch's staging
+        // memory rather than recording a buffer to buffer copy.
+        //
+        void* pSrcData = nullptr;
+        if (!pSrcBuffer->Map(&pSrcData))
+        {
+            return false;
+        }
+
+        VkResult vkres = ::CreateBuffer(
+            &this->UploadBatch,
+            static_cast<size_t>(pSrcResource.Size),
+            pSrcData,
+            usageFlags | VK_BUFFER_USAGE_RESOURCE_DESCRIPTOR_BUFFER_BIT_EXT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+            VMA_MEMORY_USAGE_AUTO,
+            0,
+            &resource);
+
+        pSrcBuffer->Unmap();
+
+        if (vkres != VK_SUCCESS)
+        {
+            return false;
+        }
+    }
+    else
+    {
+        HRESULT hr = ::CreateBuffer(
+            this->pRenderer,
+            usageFlags,
+            &pSrcResource,
+            &resource);
+        if (FAILED(hr))
+        {
+            return false;
+        }
     }
 
     // Allocate buffer container
@@ -242,18 +368,45 @@ bool SceneGraph::CreateImage(
         return false;
     }
 
+    // Fail before the resource is created if there's no slot for the image
+    if (this->IsImageTableFull())
+    {
+        return false;
+    }
+
     // Create the buffer resource
     VulkanImage resource;
     //
-    HRESULT hr = ::CreateTexture(
-        this->pRenderer,
-        pBitmap->GetWidth(),
-        pBitmap->GetHeight(),
-        VK_FORMAT_R8G8B8A8_UNORM,
-        pBitmap->GetSizeInBytes(),
-        pBitmap->GetPixels(),
-        &resource);
-    if (FAILED(hr))
+    MipOffset mipOffset = {};
+    mipOffset.Offset    = 0;
+    mipOffset.RowStride = pBitmap->GetWidth() * BytesPerPixel(VK_FORMAT_R8G8B8A8_UNORM);
+
+    VkResult vkres = VK_SUCCESS;
+    if (this->IsRecordingUploads())
+    {
+        vkres = ::CreateTexture(
+            &this->UploadBatch,
+            pBitmap->GetWidth(),
+            pBitmap->GetHeight(),
+            VK_FORMAT_R8G8B8A8_UNORM,
+            {mipOffset},
+            pBitmap->GetSizeInBytes(),
+            pBitmap->GetPixels(),
+            &resource);
+    }
+    else
+    {
+        vkres = ::CreateTexture(
+            this->pRenderer,
+            pBitmap->GetWidth(),
+            pBitmap->GetHeight(),
+            VK_FORMAT_R8G8B8A8_UNORM,
+            {mipOffset},
+            pBitmap->GetSizeInBytes(),
+            pBitmap->GetPixels(),
+            &resource);
+    }
+    if (vkres != VK_SUCCESS)
     {
         return false;
     }
@@ -275,7 +428,11 @@ bool SceneGraph::CreateImage(
     pImage->Resource  = resource;
 
     // Store image in the graph
-    this->Images.push_back(std::move(std::unique_ptr<FauxRender::Image>(pImage)));
+    if (!this->AddImage(pImage))
+    {
+        delete pImage;
+        return false;
+    }
 
     // Write output pointer
     *ppImage = pImage;
@@ -297,6 +454,12 @@ bool SceneGraph::CreateImage(
         return false;
     }
 
+    // Fail before the resource is created if there's no slot for the image
+    if (this->IsImageTableFull())
+    {
+        return false;
+    }
+
     auto vkFormat = ToVkFormat(format);
     if (vkFormat == VK_FORMAT_UNDEFINED)
     {
@@ -306,15 +469,31 @@ bool SceneGraph::CreateImage(
     // Create the buffer resource
     VulkanImage resource;
     //
-    VkResult vkres = ::CreateTexture(
-        this->pRenderer,
-        width,
-        height,
-        vkFormat,
-        mipOffsets,
-        srcImageDataSize,
-        pSrcImageData,
-        &resource);
+    VkResult vkres = VK_SUCCESS;
+    if (this->IsRecordingUploads())
+    {
+        vkres = ::CreateTexture(
+            &this->UploadBatch,
+            width,
+            height,
+            vkFormat,
+            mipOffsets,
+            srcImageDataSize,
+            pSrcImageData,
+            &resource);
+    }
+    else
+    {
+        vkres = ::CreateTexture(
+            this->pRenderer,
+            width,
+            height,
+            vkFormat,
+            mipOffsets,
+            srcImageDataSize,
+            pSrcImageData,
+            &resource);
+    }
     if (vkres != VK_SUCCESS)
     {
         return false;
@@ -337,7 +516,11 @@ bool SceneGraph::CreateImage(
     pImage->Resource  = resource;
 
     // Store image in the graph
-    this->Images.push_back(std::move(std::unique_ptr<FauxRender::Image>(pImage)));
+    if (!this->AddImage(pImage))
+    {
+        delete pImage;
+        return false;
+    }
 
     // Write output pointer
     *ppImage = pImage;
@@ -358,140 +541,94 @@ VkFauxRender::Image* Cast(FauxRender::Image* pImage)
     return static_cast<VkFauxRender::Image*>(pImage);
 }
 
-void Draw(const FauxRender::SceneGraph* pGraph, uint32_t instanceIndex, const FauxRender::Mesh* pMesh, CommandObjects* pCmdObjects)
+static void BindBatch(const VkFauxRender::Buffer* pBuffer, const FauxRender::PrimitiveBatch& batch, CommandObjects* pCmdObjects)
 {
-    assert((pMesh != nullptr) && "pMesh is NULL");
-
-    const VkFauxRender::Buffer* pBuffer = VkFauxRender::Cast(pMesh->pBuffer);
-    assert((pBuffer != nullptr) && "mesh's buffer is NULL");
-
-    const size_t numBatches = pMesh->DrawBatches.size();
-    for (size_t batchIdx = 0; batchIdx < numBatches; ++batchIdx)
+    // Index buffer
     {
-        auto& batch = pMesh->DrawBatches[batchIdx];
+        vkCmdBindIndexBuffer(
+            pCmdObjects->CommandBuffer,
+            pBuffer->Resource.Buffer,
+            batch.IndexBufferView.Offset,
+            ToVkIndexType(batch.IndexBufferView.Format));
+    }
 
-        // Skip if no material
-        if (IsNull(batch.pMaterial))
+    // Vertex buffers
+    {
+        // Bind the Vertex Buffer
+        UINT         numBufferViews                            = 0;
+        VkBuffer     bufferViews[GREX_MAX_VERTEX_ATTRIBUTES]   = {};
+        VkDeviceSize bufferOffsets[GREX_MAX_VERTEX_ATTRIBUTES] = {};
+        VkDeviceSize bufferSizes[GREX_MAX_VERTEX_ATTRIBUTES]   = {};
+        VkDeviceSize bufferStrides[GREX_MAX_VERTEX_ATTRIBUTES] = {};
+
+        // Position
+        if (batch.PositionBufferView.Format != GREX_FORMAT_UNKNOWN)
         {
-            continue;
-        }
+            auto& srcView                 = batch.PositionBufferView;
+            bufferViews[numBufferViews]   = pBuffer->Resource.Buffer;
+            bufferOffsets[numBufferViews] = srcView.Offset;
+            bufferSizes[numBufferViews]   = srcView.Size;
+            bufferStrides[numBufferViews] = srcView.Stride;
 
-        // Index buffer
-        {
-            vkCmdBindIndexBuffer(
-                pCmdObjects->CommandBuffer,
-                pBuffer->Resource.Buffer,
-                batch.IndexBufferView.Offset,
-                ToVkIndexType(batch.IndexBufferView.Format));
+            ++numBufferViews;
         }
-
-        // Vertex buffers
+        // Tex Coord
+        if (batch.TexCoordBufferView.Format != GREX_FORMAT_UNKNOWN)
         {
-            // Bind the Vertex Buffer
-            UINT         numBufferViews                            = 0;
-            VkBuffer     bufferViews[GREX_MAX_VERTEX_ATTRIBUTES]   = {};
-            VkDeviceSize bufferOffsets[GREX_MAX_VERTEX_ATTRIBUTES] = {};
-            VkDeviceSize bufferSizes[GREX_MAX_VERTEX_ATTRIBUTES]   = {};
-            VkDeviceSize bufferStrides[GREX_MAX_VERTEX_ATTRIBUTES] = {};
-
-            // Position
-            if (batch.PositionBufferView.Format != GREX_FORMAT_UNKNOWN)
-            {
-                auto& srcView                 = batch.PositionBufferView;
-                bufferViews[numBufferViews]   = pBuffer->Resource.Buffer;
-                bufferOffsets[numBufferViews] = srcView.Offset;
-                bufferSizes[numBufferViews]   = srcView.Size;
-                bufferStrides[numBufferViews] = srcView.Stride;
-
-                ++numBufferViews;
-            }
-            // Tex Coord
-            if (batch.TexCoordBufferView.Format != GREX_FORMAT_UNKNOWN)
-            {
-                auto& srcView = batch.TexCoordBufferView;
-                bufferViews[numBufferViews] = pBuffer->Resource.Buffer;
-                bufferOffsets[numBufferViews] = srcView.Offset;
-                bufferSizes[numBufferViews]   = srcView.Size;
-                bufferStrides[numBufferViews] = srcView.Stride;
-
-                ++numBufferViews;
-            }
-            //  Normal
-            if (batch.NormalBufferView.Format != GREX_FORMAT_UNKNOWN)
-            {
-                auto& srcView                 = batch.NormalBufferView;
-                bufferViews[numBufferViews]   = pBuffer->Resource.Buffer;
-                bufferOffsets[numBufferViews] = srcView.Offset;
-                bufferSizes[numBufferViews]   = srcView.Size;
-                bufferStrides[numBufferViews] = srcView.Stride;
-
-                ++numBufferViews;
-            }
-            //  Tangent
-            if (batch.TangentBufferView.Format != GREX_FORMAT_UNKNOWN)
-            {
-                auto& srcView                 = batch.TangentBufferView;
-                bufferViews[numBufferViews]   = pBuffer->Resource.Buffer;
-                bufferOffsets[numBufferViews] = srcView.Offset;
-                bufferSizes[numBufferViews]   = srcView.Size;
-                bufferStrides[numBufferViews] = srcView.Stride;
-
-                ++numBufferViews;
-            }
-
-            vkCmdBindVertexBuffers2(pCmdObjects->CommandBuffer, 0, 4, bufferViews, bufferOffsets, bufferSizes, bufferStrides);
+            auto& srcView = batch.TexCoordBufferView;
+            bufferViews[numBufferViews] = pBuffer->Resource.Buffer;
+            bufferOffsets[numBufferViews] = srcView.Offset;
+            bufferSizes[numBufferViews]   = srcView.Size;
+            bufferStrides[numBufferViews] = srcView.Stride;
+
+            ++numBufferViews;
         }
+        //  Normal
+        if (batch.NormalBufferView.Format != GREX_FORMAT_UNKNOWN)
+        {
+            auto& srcView                 = batch.NormalBufferView;
+            bufferViews[numBufferViews]   = pBuffer->Resource.Buffer;
+            bufferOffsets[numBufferViews] = srcView.Offset;
+            bufferSizes[numBufferViews]   = srcView.Size;
+            bufferStrides[numBufferViews] = srcView.Stride;
 
-        // Draw root constants
+            ++numBufferViews;
+        }
+        //  Tangent
+        if (batch.TangentBufferView.Format != GREX_FORMAT_UNKNOWN)
         {
-            FauxRender::Shader::DrawParams drawParams = {};
-            drawParams.InstanceIndex                  = instanceIndex;
-            drawParams.MaterialIndex                  = pGraph->GetMaterialIndex(batch.pMaterial);
-            assert((drawParams.InstanceIndex != UINT32_MAX) && "drawParams.InstanceIndex is invalid");
-            assert((drawParams.MaterialIndex != UINT32_MAX) && "drawParams.MaterialIndex is invalid");
-
-            vkCmdPushConstants(
-                pCmdObjects->CommandBuffer,
-                reinterpret_cast<const VkFauxRender::SceneGraph*>(pGraph)->pPipelineLayout->PipelineLayout,
-                VK_SHADER_STAGE_ALL_GRAPHICS,
-                0,
-                sizeof(FauxRender::Shader::DrawParams),
-                &drawParams);
+            auto& srcView                 = batch.TangentBufferView;
+            bufferViews[numBufferViews]   = pBuffer->Resource.Buffer;
+            bufferOffsets[numBufferViews] = srcView.Offset;
+            bufferSizes[numBufferViews]   = srcView.Size;
+            bufferStrides[numBufferViews] = srcView.Stride;
+
+            ++numBufferViews;
         }
 
-        // Draw
-        vkCmdDrawIndexed(
-            /* Command Buffer */ pCmdObjects->CommandBuffer,
-            /* indexCount     */ batch.IndexBufferView.Count,
-            /* instanceCount  */ 1,
-            /* firstIndex     */ 0,
-            /* vertexOffset   */ 0,
-            /* firstInstance  */ 0);
+        vkCmdBindVertexBuffers2(pCmdObjects->CommandBuffer, 0, 4, bufferViews, bufferOffsets, bufferSizes, bufferStrides);
     }
 }
 
-void Draw(const FauxRender::SceneGraph* pGraph, const FauxRender::Scene* pScene, const FauxRender::SceneNode* pGeometryNode, CommandObjects* pCmdObjects)
+static void PushDrawParams(const FauxRender::SceneGraph* pGraph, uint32_t instanceIndex, uint32_t materialIndex, CommandObjects* pCmdObjects)
 {
-    assert((pScene != nullptr) && "pScene is NULL");
-    assert((pGeometryNode != nullptr) && "pGeometryNode is NULL");
-    assert((pGeometryNode->Type == FauxRender::SCENE_NODE_TYPE_GEOMETRY) && "node is not of drawable type");
-
-    // mat4 Rmat     = glm::toMat4(pGeometryNode->Rotation);
-    // mat4 modelMat = glm::translate(pGeometryNode->Translate) * Rmat * glm::scale(pGeometryNode->Scale);
+    FauxRender::Shader::DrawParams drawParams = {};
+    drawParams.InstanceIndex                  = instanceIndex;
+    drawParams.MaterialIndex                  = materialIndex;
+    assert((drawParams.InstanceIndex != UINT32_MAX) && "drawParams.InstanceIndex is invalid");
+    assert((drawParams.MaterialIndex != UINT32_MAX) && "drawParams.MaterialIndex is invalid");
 
-    // pCmdList->SetGraphicsRoot32BitConstants(0, 16, &modelMat, 0);
-    // pCmdList->SetGraphicsRoot32BitConstants(0, 16, &Rmat, 32);
-
-    uint32_t instanceIndex = pScene->GetGeometryNodeIndex(pGeometryNode);
-    assert((instanceIndex != UINT32_MAX) && "instanceIndex is invalid");
-
-    Draw(pGraph, instanceIndex, pGeometryNode->pMesh, pCmdObjects);
+    vkCmdPushConstants(
+        pCmdObjects->CommandBuffer,
+        reinterpret_cast<const VkFauxRender::SceneGraph*>(pGraph)->pPipelineLayout->PipelineLayout,
+        VK_SHADER_STAGE_ALL_GRAPHICS,
+        0,
+        sizeof(FauxRender::Shader::DrawParams),
+        &drawParams);
 }
 
-void Draw(const FauxRender::SceneGraph* pGraph, const FauxRender::Scene* pScene, CommandObjects* pCmdObjects)
+static void BindSceneResources(const FauxRender::SceneGraph* pGraph, const FauxRender::Scene* pScene, FauxRender::Buffer* pInstanceBuffer, CommandObjects* pCmdObjects)
 {
-    assert((pScene != nullptr) && "pScene is NULL");
-
     const VkFauxRender::SceneGraph* pVkGraph          = static_cast<const VkFauxRender::SceneGraph*>(pGraph);
     VulkanRenderer*                 pRenderer         = pVkGraph->pRenderer;
 
@@ -517,7 +654,7 @@ void Draw(const FauxRender::SceneGraph* pGraph, const FauxRender::Scene* pScene,
 
     // Set instance buffer
     {
-        auto     resource      = VkFauxRender::Cast(pScene->pInstanceBuffer)->Resource;
+        auto     resource      = VkFauxRender::Cast(pInstanceBuffer)->Resource;
 
         WriteDescriptor(
             pRenderer,
@@ -562,12 +699,143 @@ void Draw(const FauxRender::SceneGraph* pGraph, const FauxRender::Scene* pScene,
         1, // setCount
         &bufferIndices,
         &descriptorBufferOffsets);
+}
+
+void Draw(const FauxRender::SceneGraph* pGraph, uint32_t instanceIndex, const FauxRender::Mesh* pMesh, CommandObjects* pCmdObjects)
+{
+    assert((pMesh != nullptr) && "pMesh is NULL");
+
+    Draw(pGraph, instanceIndex, pMesh, pMesh->pBuffer, pCmdObjects);
+}
+
+void Draw(const FauxRender::SceneGraph* pGraph, uint32_t instanceIndex, const FauxRender::Mesh* pMesh, FauxRender::Buffer* pMeshBuffer, CommandObjects* pCmdObjects)
+{
+    assert((pMesh != nullptr) && "pMesh is NULL");
+
+    const VkFauxRender::Buffer* pBuffer = VkFauxRender::Cast(pMeshBuffer);
+    assert((pBuffer != nullptr) && "mesh's buffer is NULL");
 
+    const size_t numBatches = pMesh->DrawBatches.size();
+    for (size_t batchIdx = 0; batchIdx < numBatches; ++batchIdx)
+    {
+        auto& batch = pMesh->DrawBatches[batchIdx];
+
+        // Skip if no material
+        if (IsNull(batch.pMaterial))
+        {
+            continue;
+        }
+
+        // Index and vertex buffers
+        BindBatch(pBuffer, batch, pCmdObjects);
+
+        // Draw root constants
+        PushDrawParams(pGraph, instanceIndex, pGraph->GetMaterialIndex(batch.pMaterial), pCmdObjects);
+
+        // Draw
+        vkCmdDrawIndexed(
+            /* Command Buffer */ pCmdObjects->CommandBuffer,
+            /* indexCount     */ batch.IndexBufferView.Count,
+            /* instanceCount  */ 1,
+            /* firstIndex     */ 0,
+            /* vertexOffset   */ 0,
+            /* firstInstance  */ 0);
+    }
+}
+
+void Draw(const FauxRender::SceneGraph* pGraph, const FauxRender::Scene* pScene, const FauxRender::SceneNode* pGeometryNode, CommandObjects* pCmdObjects)
+{
+    assert((pScene != nullptr) && "pScene is NULL");
+    assert((pGeometryNode != nullptr) && "pGeometryNode is NULL");
+    assert((pGeometryNode->Type == FauxRender::SCENE_NODE_TYPE_GEOMETRY) && "node is not of drawable type");
+
+    uint32_t instanceIndex = pScene->GetGeometryNodeIndex(pGeometryNode);
+    assert((instanceIndex != UINT32_MAX) && "instanceIndex is invalid");
+
+    Draw(pGraph, instanceIndex, pGeometryNode->pMesh, pGeometryNode->GetDrawBuffer(), pCmdObjects);
+}
+
+void Draw(const FauxRender::SceneGraph* pGraph, const FauxRender::Scene* pScene, CommandObjects* pCmdObjects)
+{
+    assert((pScene != nullptr) && "pScene is NULL");
+
+    BindSceneResources(pGraph, pScene, pScene->pInstanceBuffer, pCmdObjects);
 
     for (auto pGeometryNode : pScene->GeometryNodes)
     {
+        // Freed instance slot
+        if (IsNull(pGeometryNode))
+        {
+            continue;
+        }
+
         Draw(pGraph, pScene, pGeometryNode, pCmdObjects);
     }
 }
 
+void Draw(const FauxRender::SceneGraph* pGraph, const FauxRender::Scene* pScene, const FauxRender::VisibleList* pVisibleList, CommandObjects* pCmdObjects)
+{
+    assert((pScene != nullptr) && "pScene is NULL");
+    assert((pVisibleList != nullptr) && "pVisibleList is NULL");
+
+    BindSceneResources(pGraph, pScene, pScene->pInstanceBuffer, pCmdObjects);
+
+    for (auto instanceIndex : pVisibleList->InstanceIndices)
+    {
+        auto pGeometryNode = pScene->GeometryNodes[instanceIndex];
+        Draw(pGraph, instanceIndex, pGeometryNode->pMesh, pGeometryNode->GetDrawBuffer(), pCmdObjects);
+    }
+}
+
+void Draw(const FauxRender::SceneGraph* pGraph, const FauxRender::Scene* pScene, const FauxRender::DrawList* pDrawList, CommandObjects* pCmdObjects)
+{
+    assert((pScene != nullptr) && "pScene is NULL");
+    assert((pDrawList != nullptr) && "pDrawList is NULL");
+
+    if (pDrawList->Draws.empty())
+    {
+        return;
+    }
+
+    BindSceneResources(pGraph, pScene, pDrawList->pInstanceBuffer, pCmdObjects);
+
+    const VkFauxRender::Buffer* pArgsBuffer = IsNull(pDrawList->pIndirectArgsBuffer) ? nullptr : VkFauxRender::Cast(pDrawList->pIndirectArgsBuffer);
+
+    for (size_t drawIdx = 0; drawIdx < pDrawList->Draws.size(); ++drawIdx)
+    {
+        const auto& draw  = pDrawList->Draws[drawIdx];
+        const auto& batch = draw.pMesh->DrawBatches[draw.BatchIndex];
+
+        const VkFauxRender::Buffer* pBuffer = VkFauxRender::Cast(draw.pBuffer);
+        assert((pBuffer != nullptr) && "mesh's buffer is NULL");
+
+        // Index and vertex buffers
+        BindBatch(pBuffer, batch, pCmdObjects);
+
+        // Instances for this draw start at FirstInstance in the draw list's instance buffer
+        PushDrawParams(pGraph, draw.FirstInstance, draw.MaterialIndex, pCmdObjects);
+
+        // Draw
+        if (!IsNull(pArgsBuffer))
+        {
+            vkCmdDrawIndexedIndirect(
+                /* Command Buffer */ pCmdObjects->CommandBuffer,
+                /* buffer         */ pArgsBuffer->Resource.Buffer,
+                /* offset         */ drawIdx * sizeof(FauxRender::Shader::DrawIndexedIndirectArgs),
+                /* drawCount      */ 1,
+                /* stride         */ sizeof(FauxRender::Shader::DrawIndexedIndirectArgs));
+        }
+        else
+        {
+            vkCmdDrawIndexed(
+                /* Command Buffer */ pCmdObjects->CommandBuffer,
+                /* indexCount     */ batch.IndexBufferView.Count,
+                /* instanceCount  */ draw.InstanceCount,
+                /* firstIndex     */ 0,
+                /* vertexOffset   */ 0,
+                /* firstInstance  */ 0);
+        }
+    }
+}
+
 } // namespace VkFauxRender
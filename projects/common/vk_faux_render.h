@@ -27,6 +27,7 @@ struct SceneGraph : public FauxRender::SceneGraph
     VulkanRenderer*       pRenderer        = nullptr;
     VulkanPipelineLayout* pPipelineLayout  = nullptr;
     VulkanBuffer          DescriptorBuffer = {};
+    VulkanUploadBatch     UploadBatch      = {};
 
     struct
     {
@@ -45,6 +46,29 @@ struct SceneGraph : public FauxRender::SceneGraph
     } RootParameterIndices;
 
     SceneGraph(VulkanRenderer* pTheRenderer, VulkanPipelineLayout* pThePipelineLayout);
+    ~SceneGraph();
+
+    //
+    // Buffers and images created from data between BeginUploads() and
+    // SubmitUploads() are uploaded with a single submit instead of a
+    // submit and wait each. Their contents aren't valid until
+    // IsUploadComplete() returns true or WaitUploads() returns, and
+    // IsUploadComplete() is also true when nothing is in flight. Mappable
+    // buffers are always uploaded right away since the CPU may write to
+    // them before the batch runs.
+    //
+    // Typical use is to wrap LoadGLTF():
+    //   graph.BeginUploads();
+    //   FauxRender::LoadGLTF(path, {}, &graph);
+    //   graph.SubmitUploads();
+    //   ...
+    //   graph.WaitUploads();
+    //
+    bool BeginUploads(VkDeviceSize chunkSize = GREX_DEFAULT_UPLOAD_CHUNK_SIZE);
+    bool SubmitUploads();
+    bool IsUploadComplete() const;
+    bool WaitUploads();
+    bool IsRecordingUploads() const;
 
     virtual bool CreateTemporaryBuffer(
         uint32_t             size,
@@ -85,8 +109,11 @@ VkFauxRender::Buffer* Cast(FauxRender::Buffer* pBuffer);
 VkFauxRender::Image*  Cast(FauxRender::Image* pImage);
 
 void Draw(const FauxRender::SceneGraph* pGraph, uint32_t instanceIndex, const FauxRender::Mesh* pMesh, CommandObjects* pCmdObjects);
+void Draw(const FauxRender::SceneGraph* pGraph, uint32_t instanceIndex, const FauxRender::Mesh* pMesh, FauxRender::Buffer* pMeshBuffer, CommandObjects* pCmdObjects);
 void Draw(const FauxRender::SceneGraph* pGraph, const FauxRender::Scene* pScene, const FauxRender::SceneNode* pGeometryNode, CommandObjects* pCmdObjects);
 void Draw(const FauxRender::SceneGraph* pGraph, const FauxRender::Scene* pScene, CommandObjects* pCmdObjects);
+void Draw(const FauxRender::SceneGraph* pGraph, const FauxRender::Scene* pScene, const FauxRender::DrawList* pDrawList, CommandObjects* pCmdObjects);
+void Draw(const FauxRender::SceneGraph* pGraph, const FauxRender::Scene* pScene, const FauxRender::VisibleList* pVisibleList, CommandObjects* pCmdObjects);
 
 } // namespace VkFauxRender
 
@@ -1,10 +1,19 @@
 #include "vk_renderer.h"
+#include "shader_cache.h"
+#include "job_system.h"
 
 #define VMA_IMPLEMENTATION
 #include "vk_mem_alloc.h"
 
 #include "glslang/Include/glslang_c_interface.h"
 #include "glslang/Public/resource_limits_c.h"
+#if __has_include("glslang/build_info.h")
+#    include "glslang/build_info.h"
+#endif
+
+#include <atomic>
+#include <chrono>
+#include <numeric>
 
 #define VK_KHR_VALIDATION_LAYER_NAME "VK_LAYER_KHRONOS_validation"
 
@@ -572,11 +581,16 @@ VkResult AcquireNextImage(VulkanRenderer* pRenderer, uint32_t* pImageIndex)
 }
 
 bool SwapchainPresent(VulkanRenderer* pRenderer, uint32_t imageIndex)
+{
+    return SwapchainPresent(pRenderer, imageIndex, VK_NULL_HANDLE);
+}
+
+bool SwapchainPresent(VulkanRenderer* pRenderer, uint32_t imageIndex, VkSemaphore waitSemaphore)
 {
     VkPresentInfoKHR presentInfo   = {VK_STRUCTURE_TYPE_PRESENT_INFO_KHR};
     presentInfo.pNext              = nullptr;
-    presentInfo.waitSemaphoreCount = 0;
-    presentInfo.pWaitSemaphores    = nullptr;
+    presentInfo.waitSemaphoreCount = (waitSemaphore != VK_NULL_HANDLE) ? 1 : 0;
+    presentInfo.pWaitSemaphores    = (waitSemaphore != VK_NULL_HANDLE) ? &waitSemaphore : nullptr;
     presentInfo.swapchainCount     = 1;
     presentInfo.pSwapchains        = &pRenderer->Swapchain;
     presentInfo.pImageIndices      = &imageIndex;
@@ -612,6 +626,12 @@ VkFormat ToVkFormat(GREXFormat format)
         case GREX_FORMAT_BC6H_SFLOAT        : return VK_FORMAT_BC6H_SFLOAT_BLOCK;
         case GREX_FORMAT_BC6H_UFLOAT        : return VK_FORMAT_BC6H_UFLOAT_BLOCK;
         case GREX_FORMAT_BC7_RGBA           : return VK_FORMAT_BC7_UNORM_BLOCK;
+        case GREX_FORMAT_R8G8_SNORM         : return VK_FORMAT_R8G8_SNORM;
+        case GREX_FORMAT_R8G8B8A8_SNORM     : return VK_FORMAT_R8G8B8A8_SNORM;
+        case GREX_FORMAT_R16G16_UNORM       : return VK_FORMAT_R16G16_UNORM;
+        case GREX_FORMAT_R16G16_SNORM       : return VK_FORMAT_R16G16_SNORM;
+        case GREX_FORMAT_R16G16B16A16_UNORM : return VK_FORMAT_R16G16B16A16_UNORM;
+        case GREX_FORMAT_R16G16B16A16_SNORM : return VK_FORMAT_R16G16B16A16_SNORM;
     }
     // clang-format on
     return VK_FORMAT_UNDEFINED;
@@ -961,24 +981,15 @@ VkResult TransitionImageLayout(
     ResourceState      stateBefore,
     ResourceState      stateAfter)
 {
-    CommandObjects cmdBuf = {};
-    VkResult       vkres  = CreateCommandBuffer(pRenderer, VK_COMMAND_POOL_CREATE_TRANSIENT_BIT, &cmdBuf);
-    if (vkres != VK_SUCCESS) {
-        assert(false && "CreateCommandBuffer failed");
-        return vkres;
-    }
-
-    VkCommandBufferBeginInfo vkbi = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO};
-    vkbi.flags                    = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
-
-    vkres = vkBeginCommandBuffer(cmdBuf.CommandBuffer, &vkbi);
+    VulkanUploadBatch batch = {};
+    VkResult          vkres = CreateUploadBatch(pRenderer, 0, &batch);
     if (vkres != VK_SUCCESS) {
-        assert(false && "vkBeginCommandBuffer failed");
+        assert(false && "CreateUploadBatch failed");
         return vkres;
     }
 
     CmdTransitionImageLayout(
-        cmdBuf.CommandBuffer,
+        batch.CmdBuf.CommandBuffer,
         image,
         firstMip,
         mipCount,
@@ -988,27 +999,14 @@ VkResult TransitionImageLayout(
         stateBefore,
         stateAfter);
 
-    vkres = vkEndCommandBuffer(cmdBuf.CommandBuffer);
-    if (vkres != VK_SUCCESS) {
-        assert(false && "vkEndCommandBuffer failed");
-        return vkres;
-    }
-
-    vkres = ExecuteCommandBuffer(pRenderer, &cmdBuf);
-    if (vkres != VK_SUCCESS) {
-        assert(false && "ExecuteCommandBuffer failed");
-        return vkres;
-    }
-
-    vkres = vkQueueWaitIdle(pRenderer->Queue);
-    if (vkres != VK_SUCCESS) {
-        assert(false && "vkQueueWaitIdle failed");
-        return vkres;
+    vkres = SubmitUploadBatch(&batch);
+    if (vkres == VK_SUCCESS) {
+        vkres = WaitUploadBatch(&batch);
     }
 
-    DestroyCommandBuffer(pRenderer, &cmdBuf);
+    DestroyUploadBatch(&batch);
 
-    return VK_SUCCESS;
+    return vkres;
 }
 
 VkResult CreateBuffer(
@@ -1033,22 +1031,11 @@ VkResult CreateBuffer(
         return vkres;
     }
 
-    VkCommandBufferBeginInfo vkbi = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO};
-    vkbi.flags                    = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
-
-    CommandObjects cmdBuf = {};
-
-    vkres  = CreateCommandBuffer(pRenderer, VK_COMMAND_POOL_CREATE_TRANSIENT_BIT, &cmdBuf);
-    if (vkres != VK_SUCCESS)
-    {
-        assert(false && "CreateCommandBuffer failed");
-        return vkres;
-    }
-
-    vkres = vkBeginCommandBuffer(cmdBuf.CommandBuffer, &vkbi);
-    if (vkres != VK_SUCCESS)
-    {
-        assert(false && "vkBeginCommandBuffer failed");
+    VulkanUploadBatch batch = {};
+    //
+    vkres = CreateUploadBatch(pRenderer, 0, &batch);
+    if (vkres != VK_SUCCESS) {
+        assert(false && "CreateUploadBatch failed");
         return vkres;
     }
 
@@ -1058,34 +1045,18 @@ VkResult CreateBuffer(
     region.size         = pSrcBuffer->Size;
 
     vkCmdCopyBuffer(
-        cmdBuf.CommandBuffer,
+        batch.CmdBuf.CommandBuffer,
         pSrcBuffer->Buffer,
         pBuffer->Buffer,
         1,
         &region);
 
-    vkres = vkEndCommandBuffer(cmdBuf.CommandBuffer);
-    if (vkres != VK_SUCCESS)
-    {
-        assert(false && "vkEndCommandBuffer failed");
-        return vkres;
-    }
-
-    vkres = ExecuteCommandBuffer(pRenderer, &cmdBuf);
-    if (vkres != VK_SUCCESS)
-    {
-        assert(false && "ExecuteCommandBuffer failed");
-        return vkres;
-    }
-
-    vkres = vkQueueWaitIdle(pRenderer->Queue);
-    if (vkres != VK_SUCCESS)
-    {
-        assert(false && "vkQueueWaitIdle failed");
-        return vkres;
+    vkres = SubmitUploadBatch(&batch);
+    if (vkres == VK_SUCCESS) {
+        vkres = WaitUploadBatch(&batch);
     }
 
-    DestroyCommandBuffer(pRenderer, &cmdBuf);
+    DestroyUploadBatch(&batch);
 
     return vkres;
 }
@@ -1188,80 +1159,79 @@ VkResult CreateBuffer(
     VkDeviceSize       minAlignment, // Use 0 for no alignment
     VulkanBuffer*      pBuffer)
 {
-    VkResult vkres = CreateBuffer(
-        pRenderer,
+    if ((srcSize == 0) || IsNull(pSrcData)) {
+        return CreateBuffer(
+            pRenderer,
+            srcSize,
+            usageFlags | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            memoryUsage,
+            minAlignment,
+            pBuffer);
+    }
+
+    VulkanUploadBatch batch = {};
+    //
+    VkResult vkres = CreateUploadBatch(pRenderer, 0, &batch);
+    if (vkres != VK_SUCCESS) {
+        assert(false && "CreateUploadBatch failed");
+        return vkres;
+    }
+
+    vkres = CreateBuffer(
+        &batch,
         srcSize,
-        usageFlags | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        pSrcData,
+        usageFlags,
         memoryUsage,
         minAlignment,
         pBuffer);
-    if (vkres != VK_SUCCESS) {
-        return vkres;
+    if (vkres == VK_SUCCESS) {
+        vkres = SubmitUploadBatch(&batch);
+    }
+    if (vkres == VK_SUCCESS) {
+        vkres = WaitUploadBatch(&batch);
     }
 
-    if ((srcSize > 0) && !IsNull(pSrcData)) {
-        VulkanBuffer stagingBuffer = {};
-        //
-        vkres = CreateBuffer(
-            pRenderer,
-            srcSize,
-            pSrcData,
-            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-            0,
-            &stagingBuffer);
-        if (vkres != VK_SUCCESS) {
-            assert(false && "create staging buffer failed");
-            return vkres;
-        }
-
-        CommandObjects cmdBuf = {};
-        VkResult       vkres  = CreateCommandBuffer(pRenderer, VK_COMMAND_POOL_CREATE_TRANSIENT_BIT, &cmdBuf);
-        if (vkres != VK_SUCCESS) {
-            assert(false && "CreateCommandBuffer failed");
-            return vkres;
-        }
-
-        VkCommandBufferBeginInfo vkbi = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO};
-        vkbi.flags                    = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
-
-        vkres = vkBeginCommandBuffer(cmdBuf.CommandBuffer, &vkbi);
-        if (vkres != VK_SUCCESS) {
-            assert(false && "vkBeginCommandBuffer failed");
-            return vkres;
-        }
+    DestroyUploadBatch(&batch);
 
-        VkBufferCopy region = {};
-        region.srcOffset    = 0;
-        region.dstOffset    = 0;
-        region.size         = srcSize;
+    if (vkres != VK_SUCCESS) {
+        assert(false && "buffer upload failed");
+        return vkres;
+    }
 
-        vkCmdCopyBuffer(
-            cmdBuf.CommandBuffer,
-            stagingBuffer.Buffer,
-            pBuffer->Buffer,
-            1,
-            &region);
+    return VK_SUCCESS;
+}
 
-        vkres = vkEndCommandBuffer(cmdBuf.CommandBuffer);
-        if (vkres != VK_SUCCESS) {
-            assert(false && "vkEndCommandBuffer failed");
-            return vkres;
-        }
+VkResult CreateBuffer(
+    VulkanUploadBatch* pBatch,
+    size_t             srcSize,
+    const void*        pSrcData, // [OPTIONAL] NULL if no data
+    VkBufferUsageFlags usageFlags,
+    VmaMemoryUsage     memoryUsage,
+    VkDeviceSize       minAlignment, // Use 0 for no alignment
+    VulkanBuffer*      pBuffer)
+{
+    if (IsNull(pBatch)) {
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
 
-        vkres = ExecuteCommandBuffer(pRenderer, &cmdBuf);
-        if (vkres != VK_SUCCESS) {
-            assert(false && "ExecuteCommandBuffer failed");
-            return vkres;
-        }
+    VkResult vkres = CreateBuffer(
+        pBatch->pRenderer,
+        srcSize,
+        usageFlags | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        memoryUsage,
+        minAlignment,
+        pBuffer);
+    if (vkres != VK_SUCCESS) {
+        return vkres;
+    }
 
-        vkres = vkQueueWaitIdle(pRenderer->Queue);
+    if ((srcSize > 0) && !IsNull(pSrcData)) {
+        vkres = UploadBuffer(pBatch, srcSize, pSrcData, pBuffer);
         if (vkres != VK_SUCCESS) {
-            assert(false && "vkQueueWaitIdle failed");
+            assert(false && "UploadBuffer failed");
             return vkres;
         }
-
-        DestroyCommandBuffer(pRenderer, &cmdBuf);
-        DestroyBuffer(pRenderer, &stagingBuffer);
     }
 
     return VK_SUCCESS;
@@ -1297,233 +1267,941 @@ VkResult CreateImage(
     vkci.initialLayout     = initialLayout;
     vkci.samples           = VK_SAMPLE_COUNT_1_BIT;
 
-    VmaAllocationCreateInfo allocCreateInfo = {};
-    allocCreateInfo.usage                   = memoryUsage;
+    VmaAllocationCreateInfo allocCreateInfo = {};
+    allocCreateInfo.usage                   = memoryUsage;
+
+    VkResult vkres = vmaCreateImage(
+        pRenderer->Allocator,
+        &vkci,
+        &allocCreateInfo,
+        &pImage->Image,
+        &pImage->Allocation,
+        &pImage->AllocationInfo);
+
+    return vkres;
+}
+
+VkResult CreateTexture(
+    VulkanRenderer*               pRenderer,
+    uint32_t                      width,
+    uint32_t                      height,
+    VkFormat                      format,
+    const std::vector<MipOffset>& mipOffsets,
+    uint64_t                      srcSizeBytes,
+    const void*                   pSrcData,
+    VulkanImage*                  pImage)
+{
+    VulkanUploadBatch batch = {};
+    //
+    VkResult vkres = CreateUploadBatch(pRenderer, 0, &batch);
+    if (vkres != VK_SUCCESS) {
+        assert(false && "CreateUploadBatch failed");
+        return vkres;
+    }
+
+    vkres = CreateTexture(
+        &batch,
+        width,
+        height,
+        format,
+        mipOffsets,
+        srcSizeBytes,
+        pSrcData,
+        pImage);
+    if (vkres == VK_SUCCESS) {
+        vkres = SubmitUploadBatch(&batch);
+    }
+    if (vkres == VK_SUCCESS) {
+        vkres = WaitUploadBatch(&batch);
+    }
+
+    DestroyUploadBatch(&batch);
+
+    if (vkres != VK_SUCCESS) {
+        assert(false && "texture upload failed");
+        return vkres;
+    }
+
+    return VK_SUCCESS;
+}
+
+VkResult CreateTexture(
+    VulkanUploadBatch*            pBatch,
+    uint32_t                      width,
+    uint32_t                      height,
+    VkFormat                      format,
+    const std::vector<MipOffset>& mipOffsets,
+    uint64_t                      srcSizeBytes,
+    const void*                   pSrcData,
+    VulkanImage*                  pImage)
+{
+    if (IsNull(pBatch)) {
+        return VK_ERROR_UNKNOWN;
+    }
+    if (IsNull(pImage)) {
+        return VK_ERROR_UNKNOWN;
+    }
+    if (format == VK_FORMAT_UNDEFINED) {
+        return VK_ERROR_UNKNOWN;
+    }
+    if (mipOffsets.empty()) {
+        return VK_ERROR_UNKNOWN;
+    }
+
+    uint32_t mipLevels = CountU32(mipOffsets);
+
+    VkResult vkres = CreateImage(
+        pBatch->pRenderer,
+        VK_IMAGE_TYPE_2D,
+        VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+        width,
+        height,
+        1,
+        format,
+        mipLevels,
+        1,
+        VK_IMAGE_LAYOUT_UNDEFINED,
+        VMA_MEMORY_USAGE_GPU_ONLY,
+        pImage);
+    if (vkres != VK_SUCCESS) {
+        assert(false && "create image failed");
+        return vkres;
+    }
+
+    vkres = UploadTexture(
+        pBatch,
+        width,
+        height,
+        format,
+        mipOffsets,
+        srcSizeBytes,
+        pSrcData,
+        pImage);
+    if (vkres != VK_SUCCESS) {
+        assert(false && "UploadTexture failed");
+        return vkres;
+    }
+
+    return VK_SUCCESS;
+}
+
+VkResult CreateTexture(
+    VulkanRenderer* pRenderer,
+    uint32_t        width,
+    uint32_t        height,
+    VkFormat        format,
+    uint64_t        srcSizeBytes,
+    const void*     pSrcData,
+    VulkanImage*    pImage)
+{
+    MipOffset mipOffset   = {};
+    mipOffset.Offset      = 0;
+    mipOffset.RowStride   = width * BytesPerPixel(format);
+
+    return CreateTexture(
+        pRenderer,
+        width,
+        height,
+        format,
+        {mipOffset},
+        srcSizeBytes,
+        pSrcData,
+        pImage);
+}
+
+// =================================================================================================
+// Upload batch
+// =================================================================================================
+VkResult CreateUploadBatch(
+    VulkanRenderer*    pRenderer,
+    VkDeviceSize       chunkSize,
+    VulkanUploadBatch* pBatch)
+{
+    if (IsNull(pRenderer) || IsNull(pBatch)) {
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+
+    pBatch->pRenderer  = pRenderer;
+    pBatch->Fence      = VK_NULL_HANDLE;
+    pBatch->ChunkSize  = chunkSize;
+    pBatch->NumUploads = 0;
+    pBatch->NumBytes   = 0;
+    pBatch->Submitted  = false;
+    pBatch->Chunks.clear();
+
+    VkResult vkres = CreateCommandBuffer(pRenderer, VK_COMMAND_POOL_CREATE_TRANSIENT_BIT, &pBatch->CmdBuf);
+    if (vkres != VK_SUCCESS) {
+        assert(false && "CreateCommandBuffer failed");
+        return vkres;
+    }
+
+    VkFenceCreateInfo fenceCreateInfo = {VK_STRUCTURE_TYPE_FENCE_CREATE_INFO};
+    //
+    vkres = vkCreateFence(pRenderer->Device, &fenceCreateInfo, nullptr, &pBatch->Fence);
+    if (vkres != VK_SUCCESS) {
+        assert(false && "vkCreateFence failed");
+        DestroyCommandBuffer(pRenderer, &pBatch->CmdBuf);
+        return vkres;
+    }
+
+    VkCommandBufferBeginInfo vkbi = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO};
+    vkbi.flags                    = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+    vkres = vkBeginCommandBuffer(pBatch->CmdBuf.CommandBuffer, &vkbi);
+    if (vkres != VK_SUCCESS) {
+        assert(false && "vkBeginCommandBuffer failed");
+        DestroyUploadBatch(pBatch);
+        return vkres;
+    }
+
+    return VK_SUCCESS;
+}
+
+static void ReleaseUploadStaging(VulkanUploadBatch* pBatch)
+{
+    for (auto& chunk : pBatch->Chunks) {
+        vmaUnmapMemory(pBatch->pRenderer->Allocator, chunk.Buffer.Allocation);
+        DestroyBuffer(pBatch->pRenderer, &chunk.Buffer);
+    }
+    pBatch->Chunks.clear();
+}
+
+// Copies size bytes of pSrcData into the staging memory and returns the
+// chunk's buffer and the offset of the copy in it. The offset is a
+// multiple of alignment, which doesn't have to be a power of two. Chunks
+// are filled linearly, the last chunk in the list is the one being
+// filled. Oversized uploads get a dedicated chunk that's inserted in
+// front of it.
+static VkResult StageUploadData(
+    VulkanUploadBatch* pBatch,
+    VkDeviceSize       size,
+    VkDeviceSize       alignment,
+    const void*        pSrcData,
+    VkBuffer*          pStagingBuffer,
+    VkDeviceSize*      pStagingOffset)
+{
+    VulkanUploadBatch::StagingChunk* pChunk = nullptr;
+    VkDeviceSize                     offset = 0;
+
+    if (!pBatch->Chunks.empty()) {
+        auto& chunk = pBatch->Chunks.back();
+        offset      = ((chunk.Offset + alignment - 1) / alignment) * alignment;
+        if ((offset + size) <= chunk.Size) {
+            pChunk = &chunk;
+        }
+    }
+
+    if (IsNull(pChunk)) {
+        VulkanUploadBatch::StagingChunk chunk = {};
+        chunk.Size                            = std::max<VkDeviceSize>(size, pBatch->ChunkSize);
+
+        VkResult vkres = CreateBuffer(
+            pBatch->pRenderer,
+            static_cast<size_t>(chunk.Size),
+            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            VMA_MEMORY_USAGE_CPU_TO_GPU,
+            DEFAULT_MIN_ALIGNMENT_SIZE,
+            &chunk.Buffer);
+        if (vkres != VK_SUCCESS) {
+            assert(false && "create staging buffer failed");
+            return vkres;
+        }
+
+        vkres = vmaMapMemory(pBatch->pRenderer->Allocator, chunk.Buffer.Allocation, reinterpret_cast<void**>(&chunk.pMappedData));
+        if (vkres != VK_SUCCESS) {
+            assert(false && "map staging buffer failed");
+            DestroyBuffer(pBatch->pRenderer, &chunk.Buffer);
+            return vkres;
+        }
+
+        offset = 0;
+
+        // Keep the partially filled chunk last if this one can't take
+        // anything else
+        const bool dedicated = (chunk.Size == size) && !pBatch->Chunks.empty();
+        if (dedicated) {
+            auto it = pBatch->Chunks.insert(pBatch->Chunks.end() - 1, chunk);
+            pChunk  = &(*it);
+        }
+        else {
+            pBatch->Chunks.push_back(chunk);
+            pChunk = &pBatch->Chunks.back();
+        }
+    }
+
+    memcpy(pChunk->pMappedData + offset, pSrcData, static_cast<size_t>(size));
+    pChunk->Offset = offset + size;
+
+    *pStagingBuffer = pChunk->Buffer.Buffer;
+    *pStagingOffset = offset;
+
+    pBatch->NumBytes += size;
+
+    return VK_SUCCESS;
+}
+
+VkResult UploadBuffer(
+    VulkanUploadBatch* pBatch,
+    size_t             srcSize,
+    const void*        pSrcData,
+    VulkanBuffer*      pBuffer,
+    VkDeviceSize       dstOffset)
+{
+    if (IsNull(pBatch) || IsNull(pSrcData) || IsNull(pBuffer)) {
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+    if (pBatch->Submitted) {
+        assert(false && "upload batch was already submitted");
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+    if ((dstOffset + srcSize) > pBuffer->Size) {
+        assert(false && "upload exceeds buffer size");
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+    if (srcSize == 0) {
+        return VK_SUCCESS;
+    }
+
+    VkBuffer     stagingBuffer = VK_NULL_HANDLE;
+    VkDeviceSize stagingOffset = 0;
+    //
+    VkResult vkres = StageUploadData(pBatch, srcSize, DEFAULT_MIN_ALIGNMENT_SIZE, pSrcData, &stagingBuffer, &stagingOffset);
+    if (vkres != VK_SUCCESS) {
+        return vkres;
+    }
+
+    VkBufferCopy region = {};
+    region.srcOffset    = stagingOffset;
+    region.dstOffset    = dstOffset;
+    region.size         = srcSize;
+
+    vkCmdCopyBuffer(
+        pBatch->CmdBuf.CommandBuffer,
+        stagingBuffer,
+        pBuffer->Buffer,
+        1,
+        &region);
+
+    pBatch->NumUploads += 1;
+
+    return VK_SUCCESS;
+}
+
+VkResult UploadTexture(
+    VulkanUploadBatch*            pBatch,
+    uint32_t                      width,
+    uint32_t                      height,
+    VkFormat                      format,
+    const std::vector<MipOffset>& mipOffsets,
+    uint64_t                      srcSizeBytes,
+    const void*                   pSrcData,
+    VulkanImage*                  pImage,
+    ResourceState                 stateBefore,
+    ResourceState                 stateAfter)
+{
+    if (IsNull(pBatch) || IsNull(pImage) || mipOffsets.empty()) {
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+    if (pBatch->Submitted) {
+        assert(false && "upload batch was already submitted");
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+
+    CmdTransitionImageLayout(
+        pBatch->CmdBuf.CommandBuffer,
+        pImage->Image,
+        GREX_ALL_SUBRESOURCES,
+        VK_IMAGE_ASPECT_COLOR_BIT,
+        stateBefore,
+        RESOURCE_STATE_TRANSFER_DST);
+
+    if ((srcSizeBytes > 0) && !IsNull(pSrcData)) {
+        // bufferOffset must be a multiple of the texel size, which isn't a
+        // power of two for 3 component formats (RGB32 has 12 byte texels).
+        // Block sizes of compressed formats divide the default alignment.
+        VkDeviceSize alignment = DEFAULT_MIN_ALIGNMENT_SIZE;
+        if (!IsCompressed(format)) {
+            alignment = std::lcm<VkDeviceSize>(alignment, std::max<VkDeviceSize>(BytesPerPixel(format), 1));
+        }
+
+        VkBuffer     stagingBuffer = VK_NULL_HANDLE;
+        VkDeviceSize stagingOffset = 0;
+        //
+        VkResult vkres = StageUploadData(pBatch, srcSizeBytes, alignment, pSrcData, &stagingBuffer, &stagingOffset);
+        if (vkres != VK_SUCCESS) {
+            return vkres;
+        }
+
+        // One region per mip level, all recorded with a single copy
+        std::vector<VkBufferImageCopy> regions;
+        {
+            uint32_t levelWidth        = width;
+            uint32_t levelHeight       = height;
+            uint32_t formatSizeInBytes = BytesPerPixel(format);
+            for (uint32_t level = 0; level < CountU32(mipOffsets); ++level) {
+                const auto& mipOffset            = mipOffsets[level];
+                uint32_t    mipRowStrideInPixels = mipOffset.RowStride / formatSizeInBytes;
+                uint32_t    mipLevelHeight       = levelHeight;
+
+                if (IsCompressed(format)) {
+                    //
+                    // BytesPerPixel() is the size of a 4x4 block for compressed formats and RowStride
+                    // is the pitch of a row of blocks, which may be padded. Rows are tightly stacked
+                    // so the height is left to the API.
+                    //
+                    mipRowStrideInPixels = (mipOffset.RowStride / formatSizeInBytes) * 4;
+                    mipLevelHeight       = 0;
+                }
+
+                VkBufferImageCopy srcRegion           = {};
+                srcRegion.bufferOffset                = stagingOffset + mipOffset.Offset;
+                srcRegion.bufferRowLength             = mipRowStrideInPixels; // Row stride but in Pixels/texels
+                srcRegion.bufferImageHeight           = mipLevelHeight;       // Pixels/texels
+                srcRegion.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+                srcRegion.imageSubresource.layerCount = 1;
+                srcRegion.imageSubresource.mipLevel   = level;
+                srcRegion.imageExtent.width           = levelWidth;
+                srcRegion.imageExtent.height          = levelHeight;
+                srcRegion.imageExtent.depth           = 1;
+                regions.push_back(srcRegion);
+
+                levelWidth >>= 1;
+                levelHeight >>= 1;
+            }
+        }
+
+        vkCmdCopyBufferToImage(
+            pBatch->CmdBuf.CommandBuffer,
+            stagingBuffer,
+            pImage->Image,
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            CountU32(regions),
+            DataPtr(regions));
+    }
+
+    CmdTransitionImageLayout(
+        pBatch->CmdBuf.CommandBuffer,
+        pImage->Image,
+        GREX_ALL_SUBRESOURCES,
+        VK_IMAGE_ASPECT_COLOR_BIT,
+        RESOURCE_STATE_TRANSFER_DST,
+        stateAfter);
+
+    pBatch->NumUploads += 1;
+
+    return VK_SUCCESS;
+}
+
+VkResult SubmitUploadBatch(VulkanUploadBatch* pBatch)
+{
+    if (IsNull(pBatch) || (pBatch->CmdBuf.CommandBuffer == VK_NULL_HANDLE)) {
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+    if (pBatch->Submitted) {
+        assert(false && "upload batch was already submitted");
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+
+    //
+    // Make the copies visible to everything submitted after the batch and
+    // to the host. Waiting on the fence alone doesn't give later
+    // submissions a memory dependency on the transfer writes.
+    //
+    VkMemoryBarrier2 barrier = {VK_STRUCTURE_TYPE_MEMORY_BARRIER_2};
+    barrier.srcStageMask     = VK_PIPELINE_STAGE_2_TRANSFER_BIT;
+    barrier.srcAccessMask    = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+    barrier.dstStageMask     = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT | VK_PIPELINE_STAGE_2_HOST_BIT;
+    barrier.dstAccessMask    = VK_ACCESS_2_MEMORY_READ_BIT | VK_ACCESS_2_MEMORY_WRITE_BIT | VK_ACCESS_2_HOST_READ_BIT;
+
+    VkDependencyInfo dependencyInfo   = {VK_STRUCTURE_TYPE_DEPENDENCY_INFO};
+    dependencyInfo.memoryBarrierCount = 1;
+    dependencyInfo.pMemoryBarriers    = &barrier;
+
+    vkCmdPipelineBarrier2(pBatch->CmdBuf.CommandBuffer, &dependencyInfo);
+
+    VkResult vkres = vkEndCommandBuffer(pBatch->CmdBuf.CommandBuffer);
+    if (vkres != VK_SUCCESS) {
+        assert(false && "vkEndCommandBuffer failed");
+        return vkres;
+    }
+
+    vkres = ExecuteCommandBuffer(pBatch->pRenderer, &pBatch->CmdBuf, pBatch->Fence);
+    if (vkres != VK_SUCCESS) {
+        assert(false && "ExecuteCommandBuffer failed");
+        return vkres;
+    }
+
+    pBatch->Submitted = true;
+
+    return VK_SUCCESS;
+}
+
+bool IsUploadBatchComplete(const VulkanUploadBatch* pBatch)
+{
+    if (IsNull(pBatch) || !pBatch->Submitted) {
+        return false;
+    }
+
+    VkResult vkres = vkGetFenceStatus(pBatch->pRenderer->Device, pBatch->Fence);
+    return (vkres == VK_SUCCESS);
+}
+
+VkResult WaitUploadBatch(VulkanUploadBatch* pBatch)
+{
+    if (IsNull(pBatch) || !pBatch->Submitted) {
+        assert(false && "upload batch wasn't submitted");
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+
+    VkResult vkres = vkWaitForFences(pBatch->pRenderer->Device, 1, &pBatch->Fence, VK_TRUE, UINT64_MAX);
+    if (vkres != VK_SUCCESS) {
+        assert(false && "vkWaitForFences failed");
+        return vkres;
+    }
+
+    ReleaseUploadStaging(pBatch);
+
+    return VK_SUCCESS;
+}
+
+void DestroyUploadBatch(VulkanUploadBatch* pBatch)
+{
+    if (IsNull(pBatch) || IsNull(pBatch->pRenderer)) {
+        return;
+    }
+
+    if (pBatch->Submitted) {
+        vkWaitForFences(pBatch->pRenderer->Device, 1, &pBatch->Fence, VK_TRUE, UINT64_MAX);
+    }
+
+    ReleaseUploadStaging(pBatch);
+
+    if (pBatch->Fence != VK_NULL_HANDLE) {
+        vkDestroyFence(pBatch->pRenderer->Device, pBatch->Fence, nullptr);
+        pBatch->Fence = VK_NULL_HANDLE;
+    }
+
+    if (pBatch->CmdBuf.CommandPool != VK_NULL_HANDLE) {
+        DestroyCommandBuffer(pBatch->pRenderer, &pBatch->CmdBuf);
+    }
+
+    pBatch->Submitted = false;
+}
+
+VkResult CreateRingBuffer(
+    VulkanRenderer*    pRenderer,
+    VkDeviceSize       size,
+    VkBufferUsageFlags usageFlags,
+    VkDeviceSize       alignment,
+    VulkanRingBuffer*  pRing)
+{
+    if (IsNull(pRenderer) || IsNull(pRing) || (size == 0)) {
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+
+    alignment = std::max<VkDeviceSize>(alignment, 1);
+    size      = Align<VkDeviceSize>(size, alignment);
+
+    VkResult vkres = CreateBuffer(
+        pRenderer,
+        static_cast<size_t>(size),
+        usageFlags | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+        VMA_MEMORY_USAGE_CPU_TO_GPU,
+        alignment,
+        &pRing->Buffer);
+    if (vkres != VK_SUCCESS) {
+        assert(false && "create ring buffer failed");
+        return vkres;
+    }
+
+    vkres = vmaMapMemory(pRenderer->Allocator, pRing->Buffer.Allocation, reinterpret_cast<void**>(&pRing->pMappedData));
+    if (vkres != VK_SUCCESS) {
+        assert(false && "map ring buffer failed");
+        DestroyBuffer(pRenderer, &pRing->Buffer);
+        return vkres;
+    }
+
+    pRing->BaseAddress = GetDeviceAddress(pRenderer, &pRing->Buffer);
+    pRing->Size        = size;
+    pRing->Alignment   = alignment;
+    pRing->Head        = 0;
+    pRing->Used        = 0;
+
+    return VK_SUCCESS;
+}
+
+void DestroyRingBuffer(VulkanRenderer* pRenderer, VulkanRingBuffer* pRing)
+{
+    if (IsNull(pRenderer) || IsNull(pRing) || (pRing->Buffer.Buffer == VK_NULL_HANDLE)) {
+        return;
+    }
+
+    vmaUnmapMemory(pRenderer->Allocator, pRing->Buffer.Allocation);
+    DestroyBuffer(pRenderer, &pRing->Buffer);
+
+    *pRing = {};
+}
+
+VkDeviceSize AllocateRingBuffer(VulkanRingBuffer* pRing, VkDeviceSize size, VulkanRingAllocation* pAllocation)
+{
+    if (IsNull(pRing) || IsNull(pAllocation) || (size == 0) || (size > pRing->Size)) {
+        return 0;
+    }
+
+    VkDeviceSize offset = Align<VkDeviceSize>(pRing->Head, pRing->Alignment);
+    // Allocations never straddle the end, skip what's left and wrap
+    if ((offset + size) > pRing->Size) {
+        offset = 0;
+    }
+
+    VkDeviceSize consumed = (offset >= pRing->Head) ? (offset + size - pRing->Head) : (pRing->Size - pRing->Head + size);
+    if ((pRing->Used + consumed) > pRing->Size) {
+        return 0;
+    }
+
+    pRing->Head = offset + size;
+    pRing->Used += consumed;
+
+    pAllocation->pData   = pRing->pMappedData + offset;
+    pAllocation->Offset  = offset;
+    pAllocation->Size    = size;
+    pAllocation->Address = pRing->BaseAddress + offset;
+
+    return consumed;
+}
+
+void ReleaseRingBuffer(VulkanRingBuffer* pRing, VkDeviceSize numBytes)
+{
+    if (IsNull(pRing)) {
+        return;
+    }
+
+    assert((numBytes <= pRing->Used) && "releasing more than was allocated");
+    pRing->Used -= std::min(numBytes, pRing->Used);
+
+    // Start over at the beginning when the ring drains so the next frame's
+    // allocations don't wrap for nothing
+    if (pRing->Used == 0) {
+        pRing->Head = 0;
+    }
+}
+
+VkResult CreateFrameContext(
+    VulkanRenderer*     pRenderer,
+    uint32_t            numFramesInFlight,
+    VkDeviceSize        constantRingSize,
+    VkDeviceSize        descriptorRingSize,
+    VulkanFrameContext* pFrameCtx)
+{
+    if (IsNull(pRenderer) || IsNull(pFrameCtx) || (numFramesInFlight == 0)) {
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+
+    pFrameCtx->pRenderer     = pRenderer;
+    pFrameCtx->FrameIndex    = 0;
+    pFrameCtx->FrameNumber   = 0;
+    pFrameCtx->Recording     = false;
+    pFrameCtx->FenceWaitTime = 0;
+
+    // Sized once, the frames own command pools and sync objects and
+    // must not be copied by a reallocation
+    pFrameCtx->Frames.clear();
+    pFrameCtx->Frames.resize(numFramesInFlight);
+
+    for (auto& frame : pFrameCtx->Frames) {
+        VkResult vkres = CreateCommandBuffer(pRenderer, VK_COMMAND_POOL_CREATE_TRANSIENT_BIT, &frame.CmdBuf);
+        if (vkres != VK_SUCCESS) {
+            assert(false && "CreateCommandBuffer failed");
+            DestroyFrameContext(pFrameCtx);
+            return vkres;
+        }
+
+        // Created signaled so the first BeginFrame() on each slot doesn't block
+        VkFenceCreateInfo fenceCreateInfo = {VK_STRUCTURE_TYPE_FENCE_CREATE_INFO};
+        fenceCreateInfo.flags             = VK_FENCE_CREATE_SIGNALED_BIT;
+
+        vkres = vkCreateFence(pRenderer->Device, &fenceCreateInfo, nullptr, &frame.Fence);
+        if (vkres != VK_SUCCESS) {
+            assert(false && "vkCreateFence failed");
+            DestroyFrameContext(pFrameCtx);
+            return vkres;
+        }
+    }
+
+    // None without a swapchain
+    pFrameCtx->PresentSemaphores.resize(pRenderer->SwapchainImageCount, VK_NULL_HANDLE);
+
+    for (auto& semaphore : pFrameCtx->PresentSemaphores) {
+        VkSemaphoreCreateInfo semaphoreCreateInfo = {VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO};
+
+        VkResult vkres = vkCreateSemaphore(pRenderer->Device, &semaphoreCreateInfo, nullptr, &semaphore);
+        if (vkres != VK_SUCCESS) {
+            assert(false && "vkCreateSemaphore failed");
+            DestroyFrameContext(pFrameCtx);
+            return vkres;
+        }
+    }
+
+    VkPhysicalDeviceDescriptorBufferPropertiesEXT descriptorBufferProperties = {VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_BUFFER_PROPERTIES_EXT};
+    VkPhysicalDeviceProperties2                   properties                 = {VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2};
+    properties.pNext                                                         = &descriptorBufferProperties;
+    vkGetPhysicalDeviceProperties2(pRenderer->PhysicalDevice, &properties);
+
+    if (constantRingSize > 0) {
+        VkDeviceSize alignment = std::max<VkDeviceSize>(
+            properties.properties.limits.minUniformBufferOffsetAlignment,
+            properties.properties.limits.minStorageBufferOffsetAlignment);
+
+        VkResult vkres = CreateRingBuffer(
+            pRenderer,
+            constantRingSize,
+            VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+            alignment,
+            &pFrameCtx->ConstantRing);
+        if (vkres != VK_SUCCESS) {
+            DestroyFrameContext(pFrameCtx);
+            return vkres;
+        }
+    }
+
+    if (descriptorRingSize > 0) {
+        VkResult vkres = CreateRingBuffer(
+            pRenderer,
+            descriptorRingSize,
+            VK_BUFFER_USAGE_RESOURCE_DESCRIPTOR_BUFFER_BIT_EXT,
+            descriptorBufferProperties.descriptorBufferOffsetAlignment,
+            &pFrameCtx->DescriptorRing);
+        if (vkres != VK_SUCCESS) {
+            DestroyFrameContext(pFrameCtx);
+            return vkres;
+        }
+    }
+
+    return VK_SUCCESS;
+}
+
+VkResult BeginFrame(VulkanFrameContext* pFrameCtx, VulkanFrame** ppFrame)
+{
+    if (IsNull(pFrameCtx) || IsNull(pFrameCtx->pRenderer) || pFrameCtx->Frames.empty()) {
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+
+    if (pFrameCtx->Recording) {
+        assert(false && "BeginFrame called twice without EndFrame");
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+
+    VkDevice     device = pFrameCtx->pRenderer->Device;
+    VulkanFrame& frame  = pFrameCtx->Frames[pFrameCtx->FrameIndex];
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    VkResult vkres = vkWaitForFences(device, 1, &frame.Fence, VK_TRUE, UINT64_MAX);
+    if (vkres != VK_SUCCESS) {
+        assert(false && "vkWaitForFences failed");
+        return vkres;
+    }
+
+    auto end = std::chrono::high_resolution_clock::now();
+    pFrameCtx->FenceWaitTime += std::chrono::duration<double, std::milli>(end - start).count();
+
+    // The fence is reset by EndFrame() right before the submit, so a frame
+    // that's abandoned before EndFrame() doesn't leave an unsignaled fence
+    // for the next BeginFrame() or WaitFrameContext() to wait on forever.
+
+    // The GPU is done with everything this slot allocated last time
+    ReleaseRingBuffer(&pFrameCtx->ConstantRing, frame.ConstantBytes);
+    ReleaseRingBuffer(&pFrameCtx->DescriptorRing, frame.DescriptorBytes);
+    frame.ConstantBytes   = 0;
+    frame.DescriptorBytes = 0;
+
+    vkres = vkResetCommandPool(device, frame.CmdBuf.CommandPool, 0);
+    if (vkres != VK_SUCCESS) {
+        assert(false && "vkResetCommandPool failed");
+        return vkres;
+    }
+
+    VkCommandBufferBeginInfo vkbi = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO};
+    vkbi.flags                    = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+    vkres = vkBeginCommandBuffer(frame.CmdBuf.CommandBuffer, &vkbi);
+    if (vkres != VK_SUCCESS) {
+        assert(false && "vkBeginCommandBuffer failed");
+        return vkres;
+    }
 
-    VkResult vkres = vmaCreateImage(
-        pRenderer->Allocator,
-        &vkci,
-        &allocCreateInfo,
-        &pImage->Image,
-        &pImage->Allocation,
-        &pImage->AllocationInfo);
+    frame.FrameNumber             = pFrameCtx->FrameNumber;
+    frame.RenderCompleteSemaphore = VK_NULL_HANDLE;
+    pFrameCtx->Recording          = true;
 
-    return vkres;
+    if (!IsNull(ppFrame)) {
+        *ppFrame = &frame;
+    }
+
+    return VK_SUCCESS;
 }
 
-VkResult CreateTexture(
-    VulkanRenderer*               pRenderer,
-    uint32_t                      width,
-    uint32_t                      height,
-    VkFormat                      format,
-    const std::vector<MipOffset>& mipOffsets,
-    uint64_t                      srcSizeBytes,
-    const void*                   pSrcData,
-    VulkanImage*                  pImage)
+static bool AllocateFrameRing(
+    VulkanFrameContext*   pFrameCtx,
+    VulkanRingBuffer*     pRing,
+    VkDeviceSize*         pFrameBytes,
+    VkDeviceSize          size,
+    VulkanRingAllocation* pAllocation)
 {
-    if (IsNull(pRenderer)) {
-        return VK_ERROR_UNKNOWN;
-    }
-    if (IsNull(pImage)) {
-        return VK_ERROR_UNKNOWN;
+    if (!pFrameCtx->Recording) {
+        assert(false && "frame allocations must be made between BeginFrame and EndFrame");
+        return false;
     }
-    if (format == VK_FORMAT_UNDEFINED) {
-        return VK_ERROR_UNKNOWN;
+
+    VkDeviceSize consumed = AllocateRingBuffer(pRing, size, pAllocation);
+    if (consumed == 0) {
+        GREX_LOG_ERROR("frame ring buffer is full (" << pRing->Used << " of " << pRing->Size << " bytes in use, " << size << " requested)");
+        return false;
     }
-    if (mipOffsets.empty()) {
-        return VK_ERROR_UNKNOWN;
+
+    *pFrameBytes += consumed;
+
+    return true;
+}
+
+bool AllocateFrameConstants(VulkanFrameContext* pFrameCtx, VkDeviceSize size, VulkanRingAllocation* pAllocation)
+{
+    if (IsNull(pFrameCtx)) {
+        return false;
     }
 
-    uint32_t mipLevels = CountU32(mipOffsets);
+    VulkanFrame& frame = pFrameCtx->Frames[pFrameCtx->FrameIndex];
+    return AllocateFrameRing(pFrameCtx, &pFrameCtx->ConstantRing, &frame.ConstantBytes, size, pAllocation);
+}
 
-    VkResult vkres = CreateImage(
-        pRenderer,
-        VK_IMAGE_TYPE_2D,
-        VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
-        width,
-        height,
-        1,
-        format,
-        mipLevels,
-        1,
-        VK_IMAGE_LAYOUT_UNDEFINED,
-        VMA_MEMORY_USAGE_GPU_ONLY,
-        pImage);
-    if (vkres != VK_SUCCESS) {
-        assert(false && "create image failed");
-        return vkres;
+bool AllocateFrameDescriptors(VulkanFrameContext* pFrameCtx, VkDeviceSize size, VulkanRingAllocation* pAllocation)
+{
+    if (IsNull(pFrameCtx)) {
+        return false;
     }
 
-    vkres = TransitionImageLayout(
-        pRenderer,
-        pImage->Image,
-        GREX_ALL_SUBRESOURCES,
-        VK_IMAGE_ASPECT_COLOR_BIT,
-        RESOURCE_STATE_UNKNOWN,
-        RESOURCE_STATE_TRANSFER_DST);
-    if (vkres != VK_SUCCESS) {
-        assert(false && "transition image layout failed");
-        return vkres;
+    VulkanFrame& frame = pFrameCtx->Frames[pFrameCtx->FrameIndex];
+    return AllocateFrameRing(pFrameCtx, &pFrameCtx->DescriptorRing, &frame.DescriptorBytes, size, pAllocation);
+}
+
+VkResult EndFrame(VulkanFrameContext* pFrameCtx, uint32_t presentImageIndex)
+{
+    if (IsNull(pFrameCtx) || !pFrameCtx->Recording) {
+        assert(false && "EndFrame called without BeginFrame");
+        return VK_ERROR_INITIALIZATION_FAILED;
     }
 
-    if ((srcSizeBytes > 0) && !IsNull(pSrcData)) {
-        VulkanBuffer stagingBuffer = {};
-        if (IsCompressed(format))
-        {
-            vkres = CreateBuffer(
-                pRenderer,
-                srcSizeBytes,
-                pSrcData,
-                VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-                DEFAULT_MIN_ALIGNMENT_SIZE,
-                &stagingBuffer);
-        }
-        else
-        {
-        const uint32_t rowStride = width * BytesPerPixel(format);
-            // Calculate the total number of rows for all mip maps
-            uint32_t numRows = 0;
-            {
-                uint32_t mipHeight = height;
-                for (UINT level = 0; level < mipLevels; ++level) {
-                    numRows += mipHeight;
-                    mipHeight >>= 1;
-                }
-            }
+    const bool signalRenderComplete = (presentImageIndex != UINT32_MAX);
+    if (signalRenderComplete && (presentImageIndex >= CountU32(pFrameCtx->PresentSemaphores))) {
+        assert(false && "presentImageIndex is not a swapchain image");
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
 
-            //
-            vkres = CreateBuffer(
-                pRenderer,
-                rowStride * numRows,
-                pSrcData,
-                VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-                DEFAULT_MIN_ALIGNMENT_SIZE,
-                &stagingBuffer);
-        }
-        if (vkres != VK_SUCCESS) {
-            assert(false && "create staging buffer failed");
-            return vkres;
-        }
+    VulkanFrame& frame = pFrameCtx->Frames[pFrameCtx->FrameIndex];
 
-        CommandObjects cmdBuf = {};
-        VkResult       vkres  = CreateCommandBuffer(pRenderer, VK_COMMAND_POOL_CREATE_TRANSIENT_BIT, &cmdBuf);
-        if (vkres != VK_SUCCESS) {
-            assert(false && "CreateCommandBuffer failed");
-            return vkres;
-        }
+    VkResult vkres = vkEndCommandBuffer(frame.CmdBuf.CommandBuffer);
+    if (vkres != VK_SUCCESS) {
+        assert(false && "vkEndCommandBuffer failed");
+        return vkres;
+    }
 
-        VkCommandBufferBeginInfo vkbi = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO};
-        vkbi.flags                    = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    frame.RenderCompleteSemaphore = signalRenderComplete ? pFrameCtx->PresentSemaphores[presentImageIndex] : VK_NULL_HANDLE;
 
-        vkres = vkBeginCommandBuffer(cmdBuf.CommandBuffer, &vkbi);
-        if (vkres != VK_SUCCESS) {
-            assert(false && "vkBeginCommandBuffer failed");
-            return vkres;
-        }
+    VkCommandBufferSubmitInfo cmdSubmitinfo = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO};
+    cmdSubmitinfo.commandBuffer             = frame.CmdBuf.CommandBuffer;
 
-        // Build command buffer
-        {
-            uint32_t levelWidth  = width;
-            uint32_t levelHeight = height;
-            uint32_t formatSizeInBytes = BytesPerPixel(format);
-            for (UINT level = 0; level < mipLevels; ++level) {
-                const auto& mipOffset    = mipOffsets[level];
-                uint32_t    mipRowStrideInPixels = mipOffset.RowStride / formatSizeInBytes;
-                uint32_t    mipLevelHeight = levelHeight;
+    VkSemaphoreSubmitInfo signalInfo = {VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO};
+    signalInfo.semaphore             = frame.RenderCompleteSemaphore;
+    signalInfo.stageMask             = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
 
-                if (IsCompressed(format))
-                {
-                    //
-                    // If it's compressed, just set the variables to zero and let the API figure it out based on the imageExtents
-                    //
-                    mipRowStrideInPixels = 0;
-                    mipLevelHeight       = 0;
-                }
+    VkSubmitInfo2 submitInfo            = {VK_STRUCTURE_TYPE_SUBMIT_INFO_2};
+    submitInfo.commandBufferInfoCount   = 1;
+    submitInfo.pCommandBufferInfos      = &cmdSubmitinfo;
+    submitInfo.signalSemaphoreInfoCount = signalRenderComplete ? 1 : 0;
+    submitInfo.pSignalSemaphoreInfos    = signalRenderComplete ? &signalInfo : nullptr;
 
-                VkImageAspectFlagBits aspectFlags     = VK_IMAGE_ASPECT_COLOR_BIT;
-                VkBufferImageCopy     srcRegion       = {};
-                srcRegion.bufferOffset                = mipOffset.Offset;
-                srcRegion.bufferRowLength             = mipRowStrideInPixels; // Row stride but in Pixels/texels
-                srcRegion.bufferImageHeight           = mipLevelHeight;       // Pixels/texels
-                srcRegion.imageSubresource.aspectMask = aspectFlags;
-                srcRegion.imageSubresource.layerCount = 1;
-                srcRegion.imageSubresource.mipLevel   = level;
-                srcRegion.imageExtent.width           = levelWidth;
-                srcRegion.imageExtent.height          = levelHeight;
-                srcRegion.imageExtent.depth           = 1;
+    vkres = vkResetFences(pFrameCtx->pRenderer->Device, 1, &frame.Fence);
+    if (vkres != VK_SUCCESS) {
+        assert(false && "vkResetFences failed");
+        return vkres;
+    }
 
-                vkCmdCopyBufferToImage(
-                    cmdBuf.CommandBuffer,
-                    stagingBuffer.Buffer,
-                    pImage->Image,
-                    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-                    1,
-                    &srcRegion);
+    vkres = vkQueueSubmit2(pFrameCtx->pRenderer->Queue, 1, &submitInfo, frame.Fence);
+    if (vkres != VK_SUCCESS) {
+        assert(false && "vkQueueSubmit2 failed");
+        return vkres;
+    }
 
-                levelWidth >>= 1;
-                levelHeight >>= 1;
-            }
-        }
+    pFrameCtx->Recording  = false;
+    pFrameCtx->FrameIndex = (pFrameCtx->FrameIndex + 1) % CountU32(pFrameCtx->Frames);
+    pFrameCtx->FrameNumber += 1;
 
-        vkres = vkEndCommandBuffer(cmdBuf.CommandBuffer);
-        if (vkres != VK_SUCCESS) {
-            assert(false && "vkEndCommandBuffer failed");
-            return vkres;
-        }
+    return VK_SUCCESS;
+}
 
-        vkres = ExecuteCommandBuffer(pRenderer, &cmdBuf);
-        if (vkres != VK_SUCCESS) {
-            assert(false && "ExecuteCommandBuffer failed");
-            return vkres;
-        }
+VkResult WaitFrameContext(VulkanFrameContext* pFrameCtx)
+{
+    if (IsNull(pFrameCtx) || IsNull(pFrameCtx->pRenderer)) {
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
 
-        vkres = vkQueueWaitIdle(pRenderer->Queue);
-        if (vkres != VK_SUCCESS) {
-            assert(false && "vkQueueWaitIdle failed");
-            return vkres;
+    std::vector<VkFence> fences;
+    for (auto& frame : pFrameCtx->Frames) {
+        if (frame.Fence != VK_NULL_HANDLE) {
+            fences.push_back(frame.Fence);
         }
+    }
 
-        DestroyCommandBuffer(pRenderer, &cmdBuf);
-        DestroyBuffer(pRenderer, &stagingBuffer);
+    if (fences.empty()) {
+        return VK_SUCCESS;
     }
 
-    vkres = TransitionImageLayout(
-        pRenderer,
-        pImage->Image,
-        GREX_ALL_SUBRESOURCES,
-        VK_IMAGE_ASPECT_COLOR_BIT,
-        RESOURCE_STATE_TRANSFER_DST,
-        RESOURCE_STATE_COMPUTE_SHADER_RESOURCE);
+    VkResult vkres = vkWaitForFences(pFrameCtx->pRenderer->Device, CountU32(fences), DataPtr(fences), VK_TRUE, UINT64_MAX);
     if (vkres != VK_SUCCESS) {
-        assert(false && "transition image layout failed");
+        assert(false && "vkWaitForFences failed");
         return vkres;
     }
 
     return VK_SUCCESS;
 }
 
-VkResult CreateTexture(
-    VulkanRenderer* pRenderer,
-    uint32_t        width,
-    uint32_t        height,
-    VkFormat        format,
-    uint64_t        srcSizeBytes,
-    const void*     pSrcData,
-    VulkanImage*    pImage)
+void DestroyFrameContext(VulkanFrameContext* pFrameCtx)
 {
-    MipOffset mipOffset   = {};
-    mipOffset.Offset      = 0;
-    mipOffset.RowStride   = width * BytesPerPixel(format);
+    if (IsNull(pFrameCtx) || IsNull(pFrameCtx->pRenderer)) {
+        return;
+    }
 
-    return CreateTexture(
-        pRenderer,
-        width,
-        height,
-        format,
-        {mipOffset},
-        srcSizeBytes,
-        pSrcData,
-        pImage);
+    VulkanRenderer* pRenderer = pFrameCtx->pRenderer;
+
+    WaitFrameContext(pFrameCtx);
+
+    // The fences don't cover presents that still wait on the semaphores
+    if (!pFrameCtx->PresentSemaphores.empty()) {
+        vkQueueWaitIdle(pRenderer->Queue);
+    }
+
+    for (auto& semaphore : pFrameCtx->PresentSemaphores) {
+        if (semaphore != VK_NULL_HANDLE) {
+            vkDestroySemaphore(pRenderer->Device, semaphore, nullptr);
+        }
+    }
+    pFrameCtx->PresentSemaphores.clear();
+
+    for (auto& frame : pFrameCtx->Frames) {
+        if (frame.Fence != VK_NULL_HANDLE) {
+            vkDestroyFence(pRenderer->Device, frame.Fence, nullptr);
+            frame.Fence = VK_NULL_HANDLE;
+        }
+        if (frame.CmdBuf.CommandPool != VK_NULL_HANDLE) {
+            DestroyCommandBuffer(pRenderer, &frame.CmdBuf);
+        }
+    }
+    pFrameCtx->Frames.clear();
+
+    DestroyRingBuffer(pRenderer, &pFrameCtx->ConstantRing);
+    DestroyRingBuffer(pRenderer, &pFrameCtx->DescriptorRing);
+
+    pFrameCtx->Recording = false;
 }
 
 VkResult CreateImageView(
@@ -2898,6 +3576,32 @@ CompileResult CompileGLSL(
         return COMPILE_ERROR_INVALID_SHADER_STAGE;
     }
 
+    //
+    // Cache lookup - hits don't touch glslang at all
+    //
+    ShaderCacheKey cacheKey = {};
+    cacheKey.Add("GLSL");
+#if defined(GLSLANG_VERSION_MAJOR)
+    cacheKey.Add(GLSLANG_VERSION_MAJOR);
+    cacheKey.Add(GLSLANG_VERSION_MINOR);
+    cacheKey.Add(GLSLANG_VERSION_PATCH);
+    cacheKey.Add(GLSLANG_VERSION_FLAVOR);
+#endif
+    cacheKey.Add(glslang_stage);
+    cacheKey.Add(k_client_version);
+    cacheKey.Add(GLSLANG_TARGET_SPV_1_4);
+    cacheKey.Add(options.BindingShiftTexture);
+    cacheKey.Add(options.BindingShiftUBO);
+    cacheKey.Add(options.BindingShiftImage);
+    cacheKey.Add(options.BindingShiftSampler);
+    cacheKey.Add(options.BindingShiftSSBO);
+    cacheKey.Add(options.BindingShiftUAV);
+    cacheKey.Add(shaderSource);
+
+    if (!IsNull(pSPIRV) && LoadCachedShader(cacheKey, pSPIRV)) {
+        return COMPILE_SUCCESS;
+    }
+
     glslang_input_t input                   = {};
     input.language                          = GLSLANG_SOURCE_GLSL;
     input.stage                             = glslang_stage;
@@ -3097,6 +3801,8 @@ CompileResult CompileGLSL(
         const uint32_t* p_spirv = reinterpret_cast<const uint32_t*>(glslang_program_SPIRV_get_ptr(program));
 
         *pSPIRV = std::vector<uint32_t>(p_spirv, p_spirv + size);
+
+        StoreCachedShader(cacheKey, *pSPIRV);
     }
 
     //
@@ -3107,6 +3813,41 @@ CompileResult CompileGLSL(
     return COMPILE_SUCCESS;
 }
 
+//
+// DXC's version and commit, queried once per process so cache hits still
+// don't create a compiler. Empty if the compiler doesn't report them.
+//
+static const std::string& GetDXCVersion()
+{
+    static const std::string sVersion = []() {
+        std::stringstream ss;
+
+        ComPtr<IDxcVersionInfo> versionInfo;
+        if (FAILED(DxcCreateInstance(CLSID_DxcCompiler, IID_PPV_ARGS(&versionInfo)))) {
+            return ss.str();
+        }
+
+        UINT32 major = 0;
+        UINT32 minor = 0;
+        if (SUCCEEDED(versionInfo->GetVersion(&major, &minor))) {
+            ss << major << "." << minor;
+        }
+
+        ComPtr<IDxcVersionInfo2> versionInfo2;
+        if (SUCCEEDED(versionInfo.As(&versionInfo2))) {
+            UINT32 commitCount = 0;
+            char*  pCommitHash = nullptr;
+            if (SUCCEEDED(versionInfo2->GetCommitInfo(&commitCount, &pCommitHash))) {
+                ss << "." << commitCount << "-" << (IsNull(pCommitHash) ? "" : pCommitHash);
+                CoTaskMemFree(pCommitHash);
+            }
+        }
+
+        return ss.str();
+    }();
+    return sVersion;
+}
+
 static std::wstring AsciiToUTF16(const std::string& ascii)
 {
     std::wstring utf16;
@@ -3144,6 +3885,26 @@ HRESULT CompileHLSL(
         return E_INVALIDARG;
     }
 
+    std::vector<LPCWSTR> args = {
+        L"-spirv",
+        L"-fspv-target-env=vulkan1.1spirv1.4",
+        L"-fvk-use-dx-layout"};
+
+    // Cache lookup - hits don't touch DXC at all
+    ShaderCacheKey cacheKey = {};
+    cacheKey.Add("HLSL-SPIRV");
+    cacheKey.Add(GetDXCVersion());
+    for (auto arg : args) {
+        cacheKey.Add(arg, wcslen(arg) * sizeof(wchar_t));
+    }
+    cacheKey.Add(entryPoint);
+    cacheKey.Add(profile);
+    cacheKey.Add(shaderSource);
+
+    if (LoadCachedShader(cacheKey, pSPIRV)) {
+        return S_OK;
+    }
+
     ComPtr<IDxcLibrary> dxcLibrary;
     HRESULT             hr = DxcCreateInstance(CLSID_DxcLibrary, IID_PPV_ARGS(&dxcLibrary));
 
@@ -3157,11 +3918,6 @@ HRESULT CompileHLSL(
     std::wstring entryPointUTF16 = AsciiToUTF16(entryPoint);
     std::wstring profileUT16     = AsciiToUTF16(profile);
 
-    std::vector<LPCWSTR> args = {
-        L"-spirv",
-        L"-fspv-target-env=vulkan1.1spirv1.4",
-        L"-fvk-use-dx-layout"};
-
     args.push_back(L"-E");
     args.push_back(entryPointUTF16.c_str());
     args.push_back(L"-T");
@@ -3206,9 +3962,80 @@ HRESULT CompileHLSL(
     pSPIRV->resize(wordCount);
     memcpy(pSPIRV->data(), pBuffer, bufferSize);
 
+    StoreCachedShader(cacheKey, *pSPIRV);
+
     return S_OK;
 }
 
+bool CompileShaders(
+    const std::vector<VulkanShaderCompileJob>& jobs,
+    std::vector<VulkanShaderCompileResult>*    pResults,
+    uint32_t                                   numThreads)
+{
+    if (IsNull(pResults)) {
+        assert(false && "results output arg is null");
+        return false;
+    }
+
+    pResults->clear();
+    pResults->resize(jobs.size());
+    if (jobs.empty()) {
+        return true;
+    }
+
+    //
+    // glslang's process state is reference counted. Holding a reference
+    // for the whole batch turns the initialize/finalize pair in each
+    // CompileGLSL() call into a counter update instead of a full setup and
+    // teardown per shader.
+    //
+    const bool hasGLSL = std::any_of(jobs.begin(), jobs.end(), [](const VulkanShaderCompileJob& job) { return job.Language == SHADER_LANGUAGE_GLSL; });
+    if (hasGLSL && (glslang_initialize_process() == 0)) {
+        assert(false && "glslang initialization failed");
+        return false;
+    }
+
+    // Largest sources first so a long compile doesn't start last
+    std::vector<size_t> order(jobs.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [&jobs](size_t a, size_t b) { return jobs[a].Source.size() > jobs[b].Source.size(); });
+
+    std::atomic<uint32_t> numFailures = 0;
+
+    auto compileShaders = [&](uint32_t begin, uint32_t end) {
+        for (uint32_t orderIdx = begin; orderIdx < end; ++orderIdx) {
+            const auto& job    = jobs[order[orderIdx]];
+            auto&       result = (*pResults)[order[orderIdx]];
+
+            auto start = std::chrono::high_resolution_clock::now();
+            if (job.Language == SHADER_LANGUAGE_GLSL) {
+                result.Success = (CompileGLSL(job.Source, job.Stage, job.Options, &result.SPIRV, &result.ErrorMsg) == COMPILE_SUCCESS);
+            }
+            else {
+                result.Success = SUCCEEDED(CompileHLSL(job.Source, job.EntryPoint, job.Profile, &result.SPIRV, &result.ErrorMsg));
+            }
+            auto end = std::chrono::high_resolution_clock::now();
+
+            result.CompileTime = std::chrono::duration<double, std::milli>(end - start).count();
+
+            if (!result.Success) {
+                ++numFailures;
+            }
+        }
+    };
+
+    // One shader per piece, handed out in order, so the largest start first
+    JobSystem::Get().ParallelFor(0, CountU32(order), 1, compileShaders, numThreads);
+
+    if (hasGLSL) {
+        glslang_finalize_process();
+    }
+
+    return (numFailures == 0);
+}
+
 void WriteDescriptor(
     VulkanRenderer*       pRenderer,
     void*                 pDescriptorBufferStartAddress,
@@ -3217,6 +4044,27 @@ void WriteDescriptor(
     uint32_t              arrayElement,
     VkDescriptorType      descriptorType,
     const VulkanBuffer*   pBuffer)
+{
+    WriteDescriptor(
+        pRenderer,
+        pDescriptorBufferStartAddress,
+        descriptorSetLayout,
+        binding,
+        arrayElement,
+        descriptorType,
+        GetDeviceAddress(pRenderer, pBuffer),
+        pBuffer->Size);
+}
+
+void WriteDescriptor(
+    VulkanRenderer*       pRenderer,
+    void*                 pDescriptorBufferStartAddress,
+    VkDescriptorSetLayout descriptorSetLayout,
+    uint32_t              binding,
+    uint32_t              arrayElement,
+    VkDescriptorType      descriptorType,
+    VkDeviceAddress       address,
+    VkDeviceSize          range)
 {
     // Get the descriptor buffer properties so we can look up the descriptor size
     VkPhysicalDeviceDescriptorBufferPropertiesEXT descriptorBufferProperties = {VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_BUFFER_PROPERTIES_EXT};
@@ -3226,8 +4074,8 @@ void WriteDescriptor(
 
     // Address info
     VkDescriptorAddressInfoEXT addressInfo = {VK_STRUCTURE_TYPE_DESCRIPTOR_ADDRESS_INFO_EXT};
-    addressInfo.address                    = GetDeviceAddress(pRenderer, pBuffer);
-    addressInfo.range                      = pBuffer->Size;
+    addressInfo.address                    = address;
+    addressInfo.range                      = range;
 
     // Get buffer device address for acceleration structure
     VkDescriptorGetInfoEXT descriptorInfo = {VK_STRUCTURE_TYPE_DESCRIPTOR_GET_INFO_EXT};
@@ -68,6 +68,30 @@ struct CompilerOptions
     uint32_t BindingShiftUAV     = 0;
 };
 
+enum ShaderLanguage
+{
+    SHADER_LANGUAGE_GLSL = 0,
+    SHADER_LANGUAGE_HLSL = 1,
+};
+
+struct VulkanShaderCompileJob
+{
+    ShaderLanguage        Language   = SHADER_LANGUAGE_GLSL;
+    std::string           Source     = "";
+    VkShaderStageFlagBits Stage      = VK_SHADER_STAGE_VERTEX_BIT; // GLSL only
+    CompilerOptions       Options    = {};                         // GLSL only
+    std::string           EntryPoint = "";                         // HLSL only, ignored for lib_6_*
+    std::string           Profile    = "";                         // HLSL only
+};
+
+struct VulkanShaderCompileResult
+{
+    bool                  Success     = false;
+    std::vector<uint32_t> SPIRV       = {};
+    std::string           ErrorMsg    = "";
+    double                CompileTime = 0; // Milliseconds, includes cache lookups
+};
+
 #define GREX_DEFAULT_RTV_FORMAT VK_FORMAT_B8G8R8A8_UNORM
 #define GREX_DEFAULT_DSV_FORMAT VK_FORMAT_D32_SFLOAT
 
@@ -124,6 +148,7 @@ bool     WaitForFence(VulkanRenderer* pRenderer, VkFence fence);
 VkResult GetSwapchainImages(VulkanRenderer* pRenderer, std::vector<VkImage>& images);
 VkResult AcquireNextImage(VulkanRenderer* pRenderer, uint32_t* pImageIndex);
 bool     SwapchainPresent(VulkanRenderer* pRenderer, uint32_t imageIndex);
+bool     SwapchainPresent(VulkanRenderer* pRenderer, uint32_t imageIndex, VkSemaphore waitSemaphore);
 
 
 VkFormat    ToVkFormat(GREXFormat format);
@@ -295,6 +320,285 @@ VkResult CreateTexture(
     const void*     pSrcData,
     VulkanImage*    pImage);
 
+// =================================================================================================
+// Upload batch
+//
+// Records buffer and texture uploads into one command buffer and submits
+// them together with a single fence, instead of one staging buffer, one
+// submit and one vkQueueWaitIdle per resource.
+//
+// Source data is copied into a linear staging allocation made of large
+// persistently mapped chunks. An upload that's larger than the chunk size
+// gets a dedicated chunk. Staging memory is released when the batch is
+// waited on or destroyed.
+//
+// Usage:
+//   VulkanUploadBatch batch = {};
+//   CreateUploadBatch(pRenderer, GREX_DEFAULT_UPLOAD_CHUNK_SIZE, &batch);
+//   UploadBuffer(&batch, ...);
+//   UploadTexture(&batch, ...);
+//   SubmitUploadBatch(&batch);
+//   ... do other work, poll with IsUploadBatchComplete() ...
+//   WaitUploadBatch(&batch);
+//   DestroyUploadBatch(&batch);
+//
+// Destination resources must not be used by the GPU or written by the
+// CPU until the batch is complete. After WaitUploadBatch() the uploads
+// are visible to any work submitted afterwards.
+// =================================================================================================
+#define GREX_DEFAULT_UPLOAD_CHUNK_SIZE (64 * 1024 * 1024)
+
+struct VulkanUploadBatch
+{
+    struct StagingChunk
+    {
+        VulkanBuffer Buffer      = {};
+        char*        pMappedData = nullptr;
+        VkDeviceSize Size        = 0;
+        VkDeviceSize Offset      = 0;
+    };
+
+    VulkanRenderer*           pRenderer  = nullptr;
+    CommandObjects            CmdBuf     = {};
+    VkFence                   Fence      = VK_NULL_HANDLE;
+    VkDeviceSize              ChunkSize  = 0;
+    std::vector<StagingChunk> Chunks     = {};
+    uint32_t                  NumUploads = 0;
+    VkDeviceSize              NumBytes   = 0;
+    bool                      Submitted  = false;
+};
+
+//! @fn CreateUploadBatch
+//!
+//! Creates the command buffer and fence and starts recording. Staging
+//! chunks are allocated on demand. Use 0 for chunkSize to size every
+//! staging allocation to its upload.
+//!
+VkResult CreateUploadBatch(
+    VulkanRenderer*    pRenderer,
+    VkDeviceSize       chunkSize,
+    VulkanUploadBatch* pBatch);
+
+//! @fn CreateBuffer
+//!
+//! Same as the memoryUsage overload above, but the copy of pSrcData is
+//! recorded into pBatch. The buffer's contents aren't valid until the
+//! batch completes.
+//!
+VkResult CreateBuffer(
+    VulkanUploadBatch* pBatch,
+    size_t             srcSize,
+    const void*        pSrcData, // [OPTIONAL] NULL if no data
+    VkBufferUsageFlags usageFlags,
+    VmaMemoryUsage     memoryUsage,
+    VkDeviceSize       minAlignment, // Use 0 for no alignment
+    VulkanBuffer*      pBuffer);
+
+//! @fn CreateTexture
+//!
+//! Same as the renderer overload, but the upload and layout transitions
+//! are recorded into pBatch. The image ends up in
+//! RESOURCE_STATE_COMPUTE_SHADER_RESOURCE once the batch completes.
+//!
+VkResult CreateTexture(
+    VulkanUploadBatch*            pBatch,
+    uint32_t                      width,
+    uint32_t                      height,
+    VkFormat                      format,
+    const std::vector<MipOffset>& mipOffsets,
+    uint64_t                      srcSizeBytes,
+    const void*                   pSrcData,
+    VulkanImage*                  pImage);
+
+//! @fn UploadBuffer
+//!
+//! Copies srcSize bytes of pSrcData to pBuffer at dstOffset. pBuffer
+//! must have been created with VK_BUFFER_USAGE_TRANSFER_DST_BIT.
+//!
+VkResult UploadBuffer(
+    VulkanUploadBatch* pBatch,
+    size_t             srcSize,
+    const void*        pSrcData,
+    VulkanBuffer*      pBuffer,
+    VkDeviceSize       dstOffset = 0);
+
+//! @fn UploadTexture
+//!
+//! Copies all mip levels of pSrcData to pImage, which must be in
+//! stateBefore. Records the transitions to RESOURCE_STATE_TRANSFER_DST
+//! and from there to stateAfter.
+//!
+VkResult UploadTexture(
+    VulkanUploadBatch*            pBatch,
+    uint32_t                      width,
+    uint32_t                      height,
+    VkFormat                      format,
+    const std::vector<MipOffset>& mipOffsets,
+    uint64_t                      srcSizeBytes,
+    const void*                   pSrcData,
+    VulkanImage*                  pImage,
+    ResourceState                 stateBefore = RESOURCE_STATE_UNKNOWN,
+    ResourceState                 stateAfter  = RESOURCE_STATE_COMPUTE_SHADER_RESOURCE);
+
+//! @fn SubmitUploadBatch
+//!
+//! Ends recording and submits everything recorded so far with the
+//! batch's fence. Doesn't wait.
+//!
+VkResult SubmitUploadBatch(VulkanUploadBatch* pBatch);
+
+//! @fn IsUploadBatchComplete
+//!
+//! Returns true once a submitted batch has finished on the GPU.
+//!
+bool IsUploadBatchComplete(const VulkanUploadBatch* pBatch);
+
+//! @fn WaitUploadBatch
+//!
+//! Waits for a submitted batch and releases its staging memory.
+//!
+VkResult WaitUploadBatch(VulkanUploadBatch* pBatch);
+
+//! @fn DestroyUploadBatch
+//!
+//! Waits for the batch if it was submitted and destroys it. A batch
+//! that was never submitted is discarded.
+//!
+void DestroyUploadBatch(VulkanUploadBatch* pBatch);
+
+// =================================================================================================
+// Ring buffer
+//
+// Persistently mapped buffer that hands out linear allocations and wraps
+// around at the end. Space is given back in allocation order with
+// ReleaseRingBuffer(), which is what VulkanFrameContext does once a
+// frame's fence has signaled.
+// =================================================================================================
+struct VulkanRingBuffer
+{
+    VulkanBuffer    Buffer      = {};
+    char*           pMappedData = nullptr;
+    VkDeviceAddress BaseAddress = 0;
+    VkDeviceSize    Size        = 0;
+    VkDeviceSize    Alignment   = 0;
+    VkDeviceSize    Head        = 0; // Next free byte
+    VkDeviceSize    Used        = 0; // Bytes in use, including padding and skipped bytes at the end
+};
+
+struct VulkanRingAllocation
+{
+    void*           pData   = nullptr;
+    VkDeviceSize    Offset  = 0; // From the start of the ring's buffer
+    VkDeviceSize    Size    = 0;
+    VkDeviceAddress Address = 0;
+};
+
+VkResult CreateRingBuffer(
+    VulkanRenderer*    pRenderer,
+    VkDeviceSize       size,
+    VkBufferUsageFlags usageFlags,
+    VkDeviceSize       alignment,
+    VulkanRingBuffer*  pRing);
+
+void DestroyRingBuffer(VulkanRenderer* pRenderer, VulkanRingBuffer* pRing);
+
+// Returns the number of bytes the allocation took from the ring, which
+// is what must be released for it later, or 0 if the ring is full.
+VkDeviceSize AllocateRingBuffer(VulkanRingBuffer* pRing, VkDeviceSize size, VulkanRingAllocation* pAllocation);
+
+void ReleaseRingBuffer(VulkanRingBuffer* pRing, VkDeviceSize numBytes);
+
+// =================================================================================================
+// Frames in flight
+//
+// Lets the CPU record frame N+1 while the GPU is still working on frame N,
+// instead of calling WaitForGpu() at the end of every frame. Each frame
+// slot has its own command pool and fence. Per frame constants and
+// descriptor sets come from two ring buffers shared by all slots. A
+// frame's ring space is released once its fence has signaled.
+//
+// Render complete semaphores belong to swapchain images, not to frame
+// slots. A frame's fence doesn't say whether the present that waited on
+// its semaphore is done with it, acquiring the same image again does.
+//
+// Usage:
+//   VulkanFrameContext frameCtx = {};
+//   CreateFrameContext(pRenderer, GREX_DEFAULT_FRAMES_IN_FLIGHT, constantsSize, descriptorsSize, &frameCtx);
+//   while (...) {
+//       VulkanFrame* pFrame = nullptr;
+//       BeginFrame(&frameCtx, &pFrame);
+//       AllocateFrameConstants(&frameCtx, sizeof(Params), &alloc);
+//       ... record into pFrame->CmdBuf.CommandBuffer ...
+//       EndFrame(&frameCtx, imageIndex);
+//       SwapchainPresent(pRenderer, imageIndex, pFrame->RenderCompleteSemaphore);
+//   }
+//   WaitFrameContext(&frameCtx);
+//   DestroyFrameContext(&frameCtx);
+//
+// Resources that frames write and later frames read still need barriers,
+// since frames are no longer separated by a queue idle.
+// =================================================================================================
+#define GREX_DEFAULT_FRAMES_IN_FLIGHT 2
+
+struct VulkanFrame
+{
+    CommandObjects CmdBuf                  = {};
+    VkFence        Fence                   = VK_NULL_HANDLE; // Signaled when the frame's work is done
+    VkSemaphore    RenderCompleteSemaphore = VK_NULL_HANDLE; // Signaled by EndFrame() for the present to wait on, not owned
+    VkDeviceSize   ConstantBytes           = 0;
+    VkDeviceSize   DescriptorBytes         = 0;
+    uint64_t       FrameNumber             = 0;
+};
+
+struct VulkanFrameContext
+{
+    VulkanRenderer*          pRenderer         = nullptr;
+    std::vector<VulkanFrame> Frames            = {}; // Never resized after creation, VulkanFrame owns Vulkan objects
+    std::vector<VkSemaphore> PresentSemaphores = {}; // One per swapchain image
+    VulkanRingBuffer         ConstantRing      = {};
+    VulkanRingBuffer         DescriptorRing    = {};
+    uint32_t                 FrameIndex        = 0;
+    uint64_t                 FrameNumber       = 0;
+    bool                     Recording         = false;
+    double                   FenceWaitTime     = 0; // Milliseconds BeginFrame() spent waiting on fences
+};
+
+//! @fn CreateFrameContext
+//!
+//! Use 0 for descriptorRingSize if no descriptor sets are allocated per
+//! frame. Ring sizes should cover numFramesInFlight frames' worth of
+//! allocations.
+//!
+VkResult CreateFrameContext(
+    VulkanRenderer*     pRenderer,
+    uint32_t            numFramesInFlight,
+    VkDeviceSize        constantRingSize,
+    VkDeviceSize        descriptorRingSize,
+    VulkanFrameContext* pFrameCtx);
+
+//! @fn BeginFrame
+//!
+//! Waits until the GPU is done with the frame that last used the next
+//! slot, releases its ring space and starts recording its command buffer.
+//!
+VkResult BeginFrame(VulkanFrameContext* pFrameCtx, VulkanFrame** ppFrame);
+
+bool AllocateFrameConstants(VulkanFrameContext* pFrameCtx, VkDeviceSize size, VulkanRingAllocation* pAllocation);
+bool AllocateFrameDescriptors(VulkanFrameContext* pFrameCtx, VkDeviceSize size, VulkanRingAllocation* pAllocation);
+
+//! @fn EndFrame
+//!
+//! Ends recording and submits the frame with its fence. If
+//! presentImageIndex names a swapchain image, signals that image's
+//! semaphore and stores it in the frame's RenderCompleteSemaphore, which
+//! must then be waited on by the present. Frames that aren't presented
+//! pass UINT32_MAX.
+//!
+VkResult EndFrame(VulkanFrameContext* pFrameCtx, uint32_t presentImageIndex);
+
+VkResult WaitFrameContext(VulkanFrameContext* pFrameCtx);
+void     DestroyFrameContext(VulkanFrameContext* pFrameCtx);
+
 VkResult CreateImageView(
     VulkanRenderer*    pRenderer,
     const VulkanImage* pImage,
@@ -434,6 +738,14 @@ HRESULT CompileHLSL(
     std::vector<uint32_t>* pSPIRV,
     std::string*           pErrorMsg);
 
+// Compiles the jobs concurrently on up to numThreads job system
+// threads, 0 uses them all. Results are in job order. Returns false if any job
+// failed, the failed results have their ErrorMsg set.
+bool CompileShaders(
+    const std::vector<VulkanShaderCompileJob>& jobs,
+    std::vector<VulkanShaderCompileResult>*    pResults,
+    uint32_t                                   numThreads = 0);
+
 // Buffer
 void WriteDescriptor(
     VulkanRenderer*       pRenderer,
@@ -444,6 +756,17 @@ void WriteDescriptor(
     VkDescriptorType      descriptorType,
     const VulkanBuffer*   pBuffer);
 
+// Buffer range, e.g. a VulkanRingAllocation
+void WriteDescriptor(
+    VulkanRenderer*       pRenderer,
+    void*                 pDescriptorBufferStartAddress,
+    VkDescriptorSetLayout descriptorSetLayout,
+    uint32_t              binding,
+    uint32_t              arrayElement,
+    VkDescriptorType      descriptorType,
+    VkDeviceAddress       address,
+    VkDeviceSize          range);
+
 // Acceleration structure
 void WriteDescriptor(
     VulkanRenderer*          pRenderer,
@@ -73,39 +73,33 @@ int main(int argc, char** argv)
         auto source = LoadString("projects/112_mesh_shader_amplification/shaders.hlsl");
         assert((!source.empty()) && "no shader source!");
 
-        std::string errorMsg;
-        HRESULT     hr = CompileHLSL(source, "asmain", "as_6_5", &dxilAS, &errorMsg);
-        if (FAILED(hr))
-        {
-            std::stringstream ss;
-            ss << "\n"
-               << "Shader compiler error (AS): " << errorMsg << "\n";
-            GREX_LOG_ERROR(ss.str().c_str());
-            assert(false);
-            return EXIT_FAILURE;
-        }
+        const char* kStageNames[] = {"AS", "MS", "PS"};
 
-        hr = CompileHLSL(source, "msmain", "ms_6_5", &dxilMS, &errorMsg);
-        if (FAILED(hr))
-        {
-            std::stringstream ss;
-            ss << "\n"
-               << "Shader compiler error (MS): " << errorMsg << "\n";
-            GREX_LOG_ERROR(ss.str().c_str());
-            assert(false);
-            return EXIT_FAILURE;
-        }
+        std::vector<DxShaderCompileJob> jobs = {
+            {source, "asmain", "as_6_5"},
+            {source, "msmain", "ms_6_5"},
+            {source, "psmain", "ps_6_5"},
+        };
 
-        hr = CompileHLSL(source, "psmain", "ps_6_5", &dxilPS, &errorMsg);
-        if (FAILED(hr))
+        std::vector<DxShaderCompileResult> results;
+        CompileShaders(jobs, &results);
+        for (size_t i = 0; i < results.size(); ++i)
         {
-            std::stringstream ss;
-            ss << "\n"
-               << "Shader compiler error (PS): " << errorMsg << "\n";
-            GREX_LOG_ERROR(ss.str().c_str());
-            assert(false);
-            return EXIT_FAILURE;
+            if (!results[i].Success)
+            {
+                std::stringstream ss;
+                ss << "\n"
+                   << "Shader compiler error (" << kStageNames[i] << "): " << results[i].ErrorMsg << "\n";
+                GREX_LOG_ERROR(ss.str().c_str());
+                assert(false);
+                return EXIT_FAILURE;
+            }
+            GREX_LOG_INFO("Compiled " << kStageNames[i] << " in " << results[i].CompileTime << "ms");
         }
+
+        dxilAS = std::move(results[0].DXIL);
+        dxilMS = std::move(results[1].DXIL);
+        dxilPS = std::move(results[2].DXIL);
     }
 
     // *************************************************************************
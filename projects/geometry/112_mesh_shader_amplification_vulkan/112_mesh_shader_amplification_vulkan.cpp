@@ -75,36 +75,31 @@ int main(int argc, char** argv)
         auto source = LoadString("projects/112_mesh_shader_amplification/shaders.hlsl");
         assert((!source.empty()) && "no shader source!");
 
-        std::string errorMsg;
-        auto        hr = CompileHLSL(source, "asmain", "as_6_5", &spirvAS, &errorMsg);
-        if (FAILED(hr))
-        {
-            std::stringstream ss;
-            ss << "\n"
-               << "Shader compiler error (AS): " << errorMsg << "\n";
-            GREX_LOG_ERROR(ss.str().c_str());
-            return EXIT_FAILURE;
-        }
+        const char* kStageNames[] = {"AS", "MS", "FS"};
 
-        hr = CompileHLSL(source, "msmain", "ms_6_5", &spirvMS, &errorMsg);
-        if (FAILED(hr))
-        {
-            std::stringstream ss;
-            ss << "\n"
-               << "Shader compiler error (MS): " << errorMsg << "\n";
-            GREX_LOG_ERROR(ss.str().c_str());
-            return EXIT_FAILURE;
-        }
+        std::vector<VulkanShaderCompileJob> jobs(3);
+        jobs[0] = {SHADER_LANGUAGE_HLSL, source, {}, {}, "asmain", "as_6_5"};
+        jobs[1] = {SHADER_LANGUAGE_HLSL, source, {}, {}, "msmain", "ms_6_5"};
+        jobs[2] = {SHADER_LANGUAGE_HLSL, source, {}, {}, "psmain", "ps_6_5"};
 
-        hr = CompileHLSL(source, "psmain", "ps_6_5", &spirvFS, &errorMsg);
-        if (FAILED(hr))
+        std::vector<VulkanShaderCompileResult> results;
+        CompileShaders(jobs, &results);
+        for (size_t i = 0; i < results.size(); ++i)
         {
-            std::stringstream ss;
-            ss << "\n"
-               << "Shader compiler error (FS): " << errorMsg << "\n";
-            GREX_LOG_ERROR(ss.str().c_str());
-            return EXIT_FAILURE;
+            if (!results[i].Success)
+            {
+                std::stringstream ss;
+                ss << "\n"
+                   << "Shader compiler error (" << kStageNames[i] << "): " << results[i].ErrorMsg << "\n";
+                GREX_LOG_ERROR(ss.str().c_str());
+                return EXIT_FAILURE;
+            }
+            GREX_LOG_INFO("Compiled " << kStageNames[i] << " in " << results[i].CompileTime << "ms");
         }
+
+        spirvAS = std::move(results[0].SPIRV);
+        spirvMS = std::move(results[1].SPIRV);
+        spirvFS = std::move(results[2].SPIRV);
     }
 
     // *************************************************************************
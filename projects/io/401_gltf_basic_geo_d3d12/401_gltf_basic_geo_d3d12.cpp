@@ -171,7 +171,7 @@ int main(int argc, char** argv)
         {
             for (size_t i = 0; i < graph.Images.size(); ++i)
             {
-                auto image    = DxFauxRender::Cast(graph.Images[i].get());
+                auto image    = DxFauxRender::Cast(graph.GetDescriptorImage(static_cast<uint32_t>(i)));
                 auto resource = image->Resource;
 
                 auto descriptorHandle = D3D12_CPU_DESCRIPTOR_HANDLE{cbvsrvuavHeapStart.ptr + (i * cbvsrvuavInc)};
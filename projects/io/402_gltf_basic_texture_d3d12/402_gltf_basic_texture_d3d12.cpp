@@ -51,6 +51,7 @@ static float gAngle       = 0.0f;
 
 void CreateGlobalRootSig(DxRenderer* pRenderer, DxFauxRender::SceneGraph* pSceneGraph, ID3D12RootSignature** ppRootSig);
 void CreateDescriptorHeaps(DxRenderer* pRenderer, ID3D12DescriptorHeap** ppCBVSRVUAVHeap, ID3D12DescriptorHeap** ppSamplerHeap);
+void WriteMaterialImageDescriptors(DxRenderer* pRenderer, const DxFauxRender::SceneGraph* pSceneGraph, ID3D12DescriptorHeap* pCBVSRVUAVHeap);
 void CreateIBLTextures(
     DxRenderer*                          pRenderer,
     ID3D12Resource**                     ppBRDFLUT,
@@ -123,8 +124,16 @@ int main(int argc, char** argv)
     // *************************************************************************
     // Scene
     // *************************************************************************
-    DxFauxRender::SceneGraph graph = DxFauxRender::SceneGraph(renderer.get());
-    if (!FauxRender::LoadGLTF(GetAssetPath("scenes/basic_texture.gltf"), {}, &graph))
+    //
+    // Images start with only their mip tail resident, the streamer brings
+    // in finer levels for the scene camera in the main loop
+    //
+    DxFauxRender::SceneGraph    graph    = DxFauxRender::SceneGraph(renderer.get());
+    FauxRender::TextureStreamer streamer = {};
+
+    FauxRender::LoadOptions loadOptions = {};
+    loadOptions.pTextureStreamer        = &streamer;
+    if (!FauxRender::LoadGLTF(GetAssetPath("scenes/basic_texture.gltf"), loadOptions, &graph))
     {
         assert(false && "LoadGLTF failed");
         return EXIT_FAILURE;
@@ -161,34 +170,11 @@ int main(int argc, char** argv)
     ComPtr<ID3D12DescriptorHeap> samplerHeap;
     CreateDescriptorHeaps(renderer.get(), &cbvsrvuavHeap, &samplerHeap);
     {
-        const auto cbvsrvuavHeapStart = cbvsrvuavHeap->GetCPUDescriptorHandleForHeapStart();
-        const auto cbvsrvuavInc       = renderer->Device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+        const auto samplerInc = renderer->Device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER);
 
-        const auto samplerHeapStart = samplerHeap->GetCPUDescriptorHandleForHeapStart();
-        const auto samplerInc       = renderer->Device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER);
-
-        // Material Textures
-        {
-            for (size_t i = 0; i < graph.Images.size(); ++i)
-            {
-                auto image    = DxFauxRender::Cast(graph.Images[i].get());
-                auto resource = image->Resource;
-
-                auto descriptorHandle = D3D12_CPU_DESCRIPTOR_HANDLE{cbvsrvuavHeapStart.ptr + (i * cbvsrvuavInc)};
-
-                // Write texture descriptor
-                D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
-                srvDesc.Format                          = resource->GetDesc().Format;
-                srvDesc.ViewDimension                   = D3D12_SRV_DIMENSION_TEXTURE2D;
-                srvDesc.Shader4ComponentMapping         = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-                srvDesc.Texture2D.MostDetailedMip       = 0;
-                srvDesc.Texture2D.MipLevels             = image->NumLevels;
-                srvDesc.Texture2D.PlaneSlice            = 0;
-                srvDesc.Texture2D.ResourceMinLODClamp   = 0;
-
-                renderer->Device->CreateShaderResourceView(resource.Get(), &srvDesc, descriptorHandle);
-            }
-        }
+        // Material Textures - rewritten whenever the streamer replaces images
+        WriteMaterialImageDescriptors(renderer.get(), &graph, cbvsrvuavHeap.Get());
+        streamer.ImagesChanged = false;
 
         // Material Samplers
         {
@@ -279,6 +265,30 @@ int main(int argc, char** argv)
     // *************************************************************************
     while (window->PollEvents())
     {
+        // Stream the material images for the scene camera. Every frame
+        // waits for the GPU, so the descriptors can be rewritten here.
+        {
+            const auto& scene = graph.Scenes[0];
+
+            FauxRender::StreamingView view = {};
+            if (FauxRender::GetStreamingView(scene.get(), static_cast<float>(gWindowHeight), &view))
+            {
+                if (!streamer.Update(&graph, scene.get(), view))
+                {
+                    assert(false && "TextureStreamer::Update failed");
+                    break;
+                }
+            }
+
+            if (streamer.ImagesChanged)
+            {
+                graph.UpdateMaterialBuffer();
+                WriteMaterialImageDescriptors(renderer.get(), &graph, cbvsrvuavHeap.Get());
+                streamer.ImagesChanged = false;
+            }
+            graph.ReleaseRetiredBuffers();
+        }
+
         UINT bufferIndex = renderer->Swapchain->GetCurrentBackBufferIndex();
 
         ComPtr<ID3D12Resource> swapchainBuffer;
@@ -492,3 +502,30 @@ void CreateDescriptorHeaps(DxRenderer* pRenderer, ID3D12DescriptorHeap** ppCBVSR
         IID_PPV_ARGS(ppSamplerHeap)));
 }
 
+
+void WriteMaterialImageDescriptors(DxRenderer* pRenderer, const DxFauxRender::SceneGraph* pSceneGraph, ID3D12DescriptorHeap* pCBVSRVUAVHeap)
+{
+    const auto cbvsrvuavHeapStart = pCBVSRVUAVHeap->GetCPUDescriptorHandleForHeapStart();
+    const auto cbvsrvuavInc       = pRenderer->Device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+
+    for (size_t i = 0; i < pSceneGraph->Images.size(); ++i)
+    {
+        // Slots of images the streamer removed get a default image
+        auto image    = DxFauxRender::Cast(pSceneGraph->GetDescriptorImage(static_cast<uint32_t>(i)));
+        auto resource = image->Resource;
+
+        auto descriptorHandle = D3D12_CPU_DESCRIPTOR_HANDLE{cbvsrvuavHeapStart.ptr + (i * cbvsrvuavInc)};
+
+        // Write texture descriptor
+        D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+        srvDesc.Format                          = resource->GetDesc().Format;
+        srvDesc.ViewDimension                   = D3D12_SRV_DIMENSION_TEXTURE2D;
+        srvDesc.Shader4ComponentMapping         = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+        srvDesc.Texture2D.MostDetailedMip       = 0;
+        srvDesc.Texture2D.MipLevels             = image->NumLevels;
+        srvDesc.Texture2D.PlaneSlice            = 0;
+        srvDesc.Texture2D.ResourceMinLODClamp   = 0;
+
+        pRenderer->Device->CreateShaderResourceView(resource.Get(), &srvDesc, descriptorHandle);
+    }
+}
@@ -51,6 +51,7 @@ static float gAngle       = 0.0f;
 
 void CreateGlobalRootSig(DxRenderer* pRenderer, DxFauxRender::SceneGraph* pSceneGraph, ID3D12RootSignature** ppRootSig);
 void CreateDescriptorHeaps(DxRenderer* pRenderer, ID3D12DescriptorHeap** ppCBVSRVUAVHeap, ID3D12DescriptorHeap** ppSamplerHeap);
+void WriteMaterialImageDescriptors(DxRenderer* pRenderer, const DxFauxRender::SceneGraph* pSceneGraph, ID3D12DescriptorHeap* pCBVSRVUAVHeap);
 void CreateIBLTextures(
     DxRenderer*                          pRenderer,
     ID3D12Resource**                     ppBRDFLUT,
@@ -122,18 +123,17 @@ int main(int argc, char** argv)
 
     // *************************************************************************
     // Scene
+    //
+    // The scene streams in while the window is up, see the main loop
     // *************************************************************************
-    DxFauxRender::SceneGraph graph = DxFauxRender::SceneGraph(renderer.get());
-    if (!FauxRender::LoadGLTF(GetAssetPath("scenes/treasure_box_ktx2/treasure_box.gltf"), {}, &graph))
-    {
-        assert(false && "LoadGLTF failed");
-        return EXIT_FAILURE;
-    }
-    if (!graph.InitializeResources())
+    DxFauxRender::SceneGraph               graph = DxFauxRender::SceneGraph(renderer.get());
+    std::unique_ptr<FauxRender::AsyncLoad> asyncLoad;
+    if (!FauxRender::LoadGLTFAsync(GetAssetPath("scenes/treasure_box_ktx2/treasure_box.gltf"), {}, &graph, &asyncLoad))
     {
-        assert(false && "Graph resources initialization failed");
+        assert(false && "LoadGLTFAsync failed");
         return EXIT_FAILURE;
     }
+    bool graphResourcesInitialized = false;
 
     // *************************************************************************
     // Root signature
@@ -161,34 +161,11 @@ int main(int argc, char** argv)
     ComPtr<ID3D12DescriptorHeap> samplerHeap;
     CreateDescriptorHeaps(renderer.get(), &cbvsrvuavHeap, &samplerHeap);
     {
-        const auto cbvsrvuavHeapStart = cbvsrvuavHeap->GetCPUDescriptorHandleForHeapStart();
-        const auto cbvsrvuavInc       = renderer->Device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+        const auto samplerInc = renderer->Device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER);
 
-        const auto samplerHeapStart = samplerHeap->GetCPUDescriptorHandleForHeapStart();
-        const auto samplerInc       = renderer->Device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER);
-
-        // Material Textures
-        {
-            for (size_t i = 0; i < graph.Images.size(); ++i)
-            {
-                auto image    = DxFauxRender::Cast(graph.Images[i].get());
-                auto resource = image->Resource;
-
-                auto descriptorHandle = D3D12_CPU_DESCRIPTOR_HANDLE{cbvsrvuavHeapStart.ptr + (i * cbvsrvuavInc)};
-
-                // Write texture descriptor
-                D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
-                srvDesc.Format                          = resource->GetDesc().Format;
-                srvDesc.ViewDimension                   = D3D12_SRV_DIMENSION_TEXTURE2D;
-                srvDesc.Shader4ComponentMapping         = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-                srvDesc.Texture2D.MostDetailedMip       = 0;
-                srvDesc.Texture2D.MipLevels             = image->NumLevels;
-                srvDesc.Texture2D.PlaneSlice            = 0;
-                srvDesc.Texture2D.ResourceMinLODClamp   = 0;
-
-                renderer->Device->CreateShaderResourceView(resource.Get(), &srvDesc, descriptorHandle);
-            }
-        }
+        // Material Textures - only the default images so far, rewritten
+        // as the load brings in more
+        WriteMaterialImageDescriptors(renderer.get(), &graph, cbvsrvuavHeap.Get());
 
         // Material Samplers
         {
@@ -279,6 +256,48 @@ int main(int argc, char** argv)
     // *************************************************************************
     while (window->PollEvents())
     {
+        // Apply what the loader finished since the last frame. Every frame
+        // waits for the GPU, so nothing is in flight here and replaced
+        // previews and buffers can be released right away.
+        if (asyncLoad)
+        {
+            uint32_t changes = asyncLoad->Update(4.0f);
+            changes |= asyncLoad->ReleasePreviewImages();
+
+            if ((changes & FauxRender::ASYNC_LOAD_CHANGE_HIERARCHY) && !graphResourcesInitialized)
+            {
+                if (!graph.InitializeResources())
+                {
+                    assert(false && "Graph resources initialization failed");
+                    break;
+                }
+                graphResourcesInitialized = true;
+            }
+            if (changes & FauxRender::ASYNC_LOAD_CHANGE_GEOMETRY)
+            {
+                for (auto& scene : graph.Scenes)
+                {
+                    graph.UpdateInstanceBuffer(scene.get());
+                }
+            }
+            if (changes & FauxRender::ASYNC_LOAD_CHANGE_IMAGES)
+            {
+                graph.UpdateMaterialBuffer();
+                WriteMaterialImageDescriptors(renderer.get(), &graph, cbvsrvuavHeap.Get());
+            }
+            graph.ReleaseRetiredBuffers();
+
+            if (asyncLoad->IsDone())
+            {
+                if (asyncLoad->GetProgress().Stage == FauxRender::ASYNC_LOAD_STAGE_FAILED)
+                {
+                    assert(false && "LoadGLTFAsync failed");
+                    break;
+                }
+                asyncLoad.reset();
+            }
+        }
+
         UINT bufferIndex = renderer->Swapchain->GetCurrentBackBufferIndex();
 
         ComPtr<ID3D12Resource> swapchainBuffer;
@@ -333,9 +352,12 @@ int main(int argc, char** argv)
             // Topology
             commandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 
-            // Draw scene
-            const auto& scene = graph.Scenes[0];
-            DxFauxRender::Draw(&graph, scene.get(), commandList.Get());
+            // Draw scene once it has geometry
+            if (graphResourcesInitialized && !graph.Scenes.empty() && !IsNull(graph.Scenes[0]->pInstanceBuffer))
+            {
+                const auto& scene = graph.Scenes[0];
+                DxFauxRender::Draw(&graph, scene.get(), commandList.Get());
+            }
         }
         D3D12_RESOURCE_BARRIER postRenderBarrier = CreateTransition(swapchainBuffer.Get(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PRESENT);
         commandList->ResourceBarrier(1, &postRenderBarrier);
@@ -492,3 +514,30 @@ void CreateDescriptorHeaps(DxRenderer* pRenderer, ID3D12DescriptorHeap** ppCBVSR
         IID_PPV_ARGS(ppSamplerHeap)));
 }
 
+
+void WriteMaterialImageDescriptors(DxRenderer* pRenderer, const DxFauxRender::SceneGraph* pSceneGraph, ID3D12DescriptorHeap* pCBVSRVUAVHeap)
+{
+    const auto cbvsrvuavHeapStart = pCBVSRVUAVHeap->GetCPUDescriptorHandleForHeapStart();
+    const auto cbvsrvuavInc       = pRenderer->Device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+
+    for (size_t i = 0; i < pSceneGraph->Images.size(); ++i)
+    {
+        // Slots freed by released previews get a default image
+        auto image    = DxFauxRender::Cast(pSceneGraph->GetDescriptorImage(static_cast<uint32_t>(i)));
+        auto resource = image->Resource;
+
+        auto descriptorHandle = D3D12_CPU_DESCRIPTOR_HANDLE{cbvsrvuavHeapStart.ptr + (i * cbvsrvuavInc)};
+
+        // Write texture descriptor
+        D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+        srvDesc.Format                          = resource->GetDesc().Format;
+        srvDesc.ViewDimension                   = D3D12_SRV_DIMENSION_TEXTURE2D;
+        srvDesc.Shader4ComponentMapping         = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+        srvDesc.Texture2D.MostDetailedMip       = 0;
+        srvDesc.Texture2D.MipLevels             = image->NumLevels;
+        srvDesc.Texture2D.PlaneSlice            = 0;
+        srvDesc.Texture2D.ResourceMinLODClamp   = 0;
+
+        pRenderer->Device->CreateShaderResourceView(resource.Get(), &srvDesc, descriptorHandle);
+    }
+}
@@ -176,7 +176,7 @@ int main(int argc, char** argv)
 
             for (size_t i = 0; i < graph.Images.size(); ++i)
             {
-                auto          image    = MtlFauxRender::Cast(graph.Images[i].get());
+                auto          image    = MtlFauxRender::Cast(graph.GetDescriptorImage(static_cast<uint32_t>(i)));
                 MTL::Texture* resource = image->Resource.Texture.get();
 
                 pMaterialImagesArgEncoder->setTexture(resource, i);
@@ -151,6 +151,28 @@ int main(int argc, char** argv)
     ComPtr<ID3D12RootSignature> rootSig;
     CreateGlobalRootSig(renderer.get(), &graph, &rootSig);
 
+    // *************************************************************************
+    // Draw list
+    // *************************************************************************
+    // The scene is drawn with one ExecuteIndirect, the command signature
+    // needs the root signature for the draw root constants.
+    FauxRender::DrawList drawList = {};
+    if (!graph.CreateDrawListCommandSignature(rootSig.Get()))
+    {
+        assert(false && "CreateDrawListCommandSignature failed");
+        return EXIT_FAILURE;
+    }
+    if (!FauxRender::BuildDrawList(&graph, graph.Scenes[0].get(), &drawList))
+    {
+        assert(false && "BuildDrawList failed");
+        return EXIT_FAILURE;
+    }
+    if (!graph.InitializeDrawList(graph.Scenes[0].get(), &drawList))
+    {
+        assert(false && "InitializeDrawList failed");
+        return EXIT_FAILURE;
+    }
+
     // *************************************************************************
     // Graphics pipeline state object
     // *************************************************************************
@@ -257,7 +279,7 @@ int main(int argc, char** argv)
         {
             for (size_t i = 0; i < graph.Images.size(); ++i)
             {
-                auto image    = DxFauxRender::Cast(graph.Images[i].get());
+                auto image    = DxFauxRender::Cast(graph.GetDescriptorImage(static_cast<uint32_t>(i)));
                 auto resource = image->Resource;
 
                 auto descriptorHandle = D3D12_CPU_DESCRIPTOR_HANDLE{cbvsrvuavHeapStart.ptr + ((gMaterialTextureOffset + i) * cbvsrvuavInc)};
@@ -461,7 +483,7 @@ int main(int argc, char** argv)
 
             // Draw scene
             const auto& scene = graph.Scenes[0];
-            DxFauxRender::Draw(&graph, scene.get(), commandList.Get());
+            DxFauxRender::Draw(&graph, scene.get(), &drawList, commandList.Get());
         }
         D3D12_RESOURCE_BARRIER postRenderBarrier = CreateTransition(swapchainBuffer.Get(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PRESENT);
         commandList->ResourceBarrier(1, &postRenderBarrier);
@@ -485,6 +507,9 @@ int main(int argc, char** argv)
         }
     }
 
+    graph.DestroyDrawList(&drawList);
+    graph.ReleaseRetiredBuffers();
+
     return 0;
 }
 
@@ -173,16 +173,35 @@ int main(int argc, char** argv)
     // Scene
     // *************************************************************************
     VkFauxRender::SceneGraph graph = VkFauxRender::SceneGraph(renderer.get(), &pipelineLayout);
+    //
+    // Record all of the scene's uploads into one batch and let it run
+    // while the graph's CPU side resources are initialized
+    //
+    if (!graph.BeginUploads())
+    {
+        assert(false && "BeginUploads failed");
+        return EXIT_FAILURE;
+    }
     if (!FauxRender::LoadGLTF(GetAssetPath("scenes/material_test_001_ktx2/material_test_001.gltf"), {}, &graph))
     {
         assert(false && "LoadGLTF failed");
         return EXIT_FAILURE;
     }
+    if (!graph.SubmitUploads())
+    {
+        assert(false && "SubmitUploads failed");
+        return EXIT_FAILURE;
+    }
     if (!graph.InitializeResources())
     {
         assert(false && "Graph resources initialization failed");
         return EXIT_FAILURE;
     }
+    if (!graph.WaitUploads())
+    {
+        assert(false && "WaitUploads failed");
+        return EXIT_FAILURE;
+    }
 
     // *************************************************************************
     // Graphics pipeline state object
@@ -397,7 +416,7 @@ int main(int argc, char** argv)
         {
             for (size_t i = 0; i < graph.Images.size(); ++i)
             {
-                auto               image    = VkFauxRender::Cast(graph.Images[i].get());
+                auto               image    = VkFauxRender::Cast(graph.GetDescriptorImage(static_cast<uint32_t>(i)));
                 const VulkanImage* resource = &image->Resource;
 
                 VkImageView imageView = VK_NULL_HANDLE;
@@ -0,0 +1,295 @@
+//
+// Builds a Bvh over a few meshes and measures each query type:
+//
+//   - build time with every thread and with one thread
+//   - camera rays, one at a time and as packets of 8 (2x4 pixel blocks)
+//   - incoherent rays, closest hit and any hit
+//   - closest point queries
+//
+// Queries run on one thread, so the numbers are per core. Packet results
+// are checked against single ray results, and a sample of the incoherent
+// rays against brute force, so a traversal bug shows up as mismatches
+// rather than as a suspiciously fast run.
+//
+
+#include "bvh.h"
+#include "window.h"
+
+#include <chrono>
+#include <random>
+
+using glm::vec3;
+
+using Clock = std::chrono::high_resolution_clock;
+
+double SecondsSince(const Clock::time_point& start)
+{
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+bool BruteForceIntersect(const TriMesh& mesh, const Bvh::Ray& ray, float* pT)
+{
+    const auto& positions = mesh.GetPositions();
+
+    float tClosest = ray.TMax;
+    for (const auto& tri : mesh.GetTriangles()) {
+        vec3 P0 = positions[tri.vIdx0];
+        vec3 E1 = positions[tri.vIdx1] - P0;
+        vec3 E2 = positions[tri.vIdx2] - P0;
+
+        vec3  pvec = glm::cross(ray.Direction, E2);
+        float det  = glm::dot(E1, pvec);
+        if (fabsf(det) <= 1e-12f) {
+            continue;
+        }
+        float inv = 1.0f / det;
+
+        vec3  tvec = ray.Origin - P0;
+        float u    = glm::dot(tvec, pvec) * inv;
+        vec3  qvec = glm::cross(tvec, E1);
+        float v    = glm::dot(ray.Direction, qvec) * inv;
+        float t    = glm::dot(E2, qvec) * inv;
+        if ((u >= 0) && (v >= 0) && ((u + v) <= 1) && (t > ray.TMin) && (t < tClosest)) {
+            tClosest = t;
+        }
+    }
+
+    *pT = tClosest;
+    return tClosest < ray.TMax;
+}
+
+// Camera rays from in front of the mesh, ordered so every 8 consecutive rays are a 2x4 pixel block
+std::vector<Bvh::Ray> GenerateCameraRays(const TriMesh::Aabb& bounds, uint32_t width, uint32_t height)
+{
+    const vec3  center = bounds.Center();
+    const float radius = glm::length(bounds.max - bounds.min) / 2.0f;
+    const vec3  eye    = center + glm::normalize(vec3(0.3f, 0.4f, 1.0f)) * (1.5f * radius);
+
+    const vec3  forward     = glm::normalize(center - eye);
+    const vec3  right       = glm::normalize(glm::cross(forward, vec3(0, 1, 0)));
+    const vec3  up          = glm::cross(right, forward);
+    const float tanHalfFov  = tanf(glm::radians(30.0f));
+    const float aspectRatio = width / static_cast<float>(height);
+
+    std::vector<Bvh::Ray> rays;
+    rays.reserve(static_cast<size_t>(width) * height);
+    for (uint32_t blockY = 0; blockY < height; blockY += 2) {
+        for (uint32_t blockX = 0; blockX < width; blockX += 4) {
+            for (uint32_t y = blockY; y < std::min(blockY + 2, height); ++y) {
+                for (uint32_t x = blockX; x < std::min(blockX + 4, width); ++x) {
+                    float sx = (2.0f * (x + 0.5f) / width - 1.0f) * tanHalfFov * aspectRatio;
+                    float sy = (1.0f - 2.0f * (y + 0.5f) / height) * tanHalfFov;
+
+                    Bvh::Ray ray  = {};
+                    ray.Origin    = eye;
+                    ray.Direction = glm::normalize(forward + sx * right + sy * up);
+                    rays.push_back(ray);
+                }
+            }
+        }
+    }
+
+    return rays;
+}
+
+// Rays from a sphere around the mesh towards random points inside its bounds
+std::vector<Bvh::Ray> GenerateIncoherentRays(const TriMesh::Aabb& bounds, uint32_t count, std::mt19937& rng)
+{
+    const vec3  center = bounds.Center();
+    const float radius = glm::length(bounds.max - bounds.min);
+
+    std::uniform_real_distribution<float> dist(0.0f, 1.0f);
+
+    std::vector<Bvh::Ray> rays(count);
+    for (auto& ray : rays) {
+        vec3 dir;
+        do {
+            dir = vec3(dist(rng), dist(rng), dist(rng)) * 2.0f - 1.0f;
+        } while ((glm::dot(dir, dir) > 1.0f) || (glm::dot(dir, dir) < 1e-4f));
+
+        vec3 target = bounds.min + (bounds.max - bounds.min) * vec3(dist(rng), dist(rng), dist(rng));
+
+        ray.Origin    = center + glm::normalize(dir) * radius;
+        ray.Direction = glm::normalize(target - ray.Origin);
+    }
+
+    return rays;
+}
+
+void RunBenchmarks(const std::string& name, const TriMesh& mesh, uint32_t width, uint32_t height, uint32_t numIncoherent)
+{
+    std::cout << name << ": " << mesh.GetNumTriangles() << " triangles" << std::endl;
+
+    // Build
+    Bvh bvh;
+    {
+        Bvh::BuildOptions options = {};
+        options.NumThreads        = 1;
+
+        Bvh singleThreaded;
+        Bvh::Build(mesh, options, &singleThreaded);
+
+        options.NumThreads = 0;
+        if (!Bvh::Build(mesh, options, &bvh)) {
+            std::cout << "   error: BVH build failed" << std::endl;
+            return;
+        }
+
+        const Bvh::Stats& stats = bvh.GetStats();
+        std::cout << "   build           : " << stats.BuildTimeMs << " ms, "
+                  << singleThreaded.GetStats().BuildTimeMs << " ms on 1 thread" << std::endl;
+        std::cout << "   tree            : " << stats.NumNodes << " nodes, " << stats.NumLeaves << " leaves, "
+                  << stats.MaxDepth << " levels, SAH cost " << stats.SahCost << std::endl;
+    }
+
+    // Camera rays
+    {
+        std::vector<Bvh::Ray> rays = GenerateCameraRays(mesh.GetBounds(), width, height);
+        std::vector<Bvh::Hit> singleHits(rays.size());
+        std::vector<Bvh::Hit> packetHits(rays.size());
+
+        auto     start   = Clock::now();
+        uint32_t numHits = 0;
+        for (size_t i = 0; i < rays.size(); ++i) {
+            numHits += bvh.Intersect(rays[i], &singleHits[i]) ? 1 : 0;
+        }
+        double singleSeconds = SecondsSince(start);
+
+        start = Clock::now();
+        bvh.IntersectPacket(CountU32(rays), DataPtr(rays), DataPtr(packetHits));
+        double packetSeconds = SecondsSince(start);
+
+        uint32_t mismatches = 0;
+        for (size_t i = 0; i < rays.size(); ++i) {
+            if ((singleHits[i].TriangleIndex != packetHits[i].TriangleIndex) || (singleHits[i].T != packetHits[i].T)) {
+                ++mismatches;
+            }
+        }
+
+        std::cout << "   camera rays     : " << (rays.size() / singleSeconds / 1e6) << " Mrays/s single, "
+                  << (rays.size() / packetSeconds / 1e6) << " Mrays/s packets, "
+                  << (100.0 * numHits / rays.size()) << "% hit, " << mismatches << " packet mismatches" << std::endl;
+    }
+
+    // Incoherent rays
+    {
+        std::mt19937          rng(1234);
+        std::vector<Bvh::Ray> rays = GenerateIncoherentRays(mesh.GetBounds(), numIncoherent, rng);
+        std::vector<Bvh::Hit> hits(rays.size());
+
+        auto     start   = Clock::now();
+        uint32_t numHits = 0;
+        for (size_t i = 0; i < rays.size(); ++i) {
+            numHits += bvh.Intersect(rays[i], &hits[i]) ? 1 : 0;
+        }
+        double closestSeconds = SecondsSince(start);
+
+        start           = Clock::now();
+        uint32_t numAny = 0;
+        for (const auto& ray : rays) {
+            numAny += bvh.IntersectAny(ray) ? 1 : 0;
+        }
+        double anySeconds = SecondsSince(start);
+
+        uint32_t       mismatches = (numAny != numHits) ? 1 : 0;
+        const uint32_t numChecked = std::min(CountU32(rays), 256u);
+        for (uint32_t i = 0; i < numChecked; ++i) {
+            float t   = 0;
+            bool  hit = BruteForceIntersect(mesh, rays[i], &t);
+            if ((hit != (hits[i].TriangleIndex != UINT32_MAX)) || (hit && (t != hits[i].T))) {
+                ++mismatches;
+            }
+        }
+
+        std::cout << "   incoherent rays : " << (rays.size() / closestSeconds / 1e6) << " Mrays/s closest hit, "
+                  << (rays.size() / anySeconds / 1e6) << " Mrays/s any hit, "
+                  << (100.0 * numHits / rays.size()) << "% hit, " << mismatches << " mismatches" << std::endl;
+    }
+
+    // Closest point
+    {
+        const auto& bounds = mesh.GetBounds();
+        const vec3  extent = bounds.max - bounds.min;
+
+        std::mt19937                          rng(5678);
+        std::uniform_real_distribution<float> dist(-0.25f, 1.25f);
+
+        const uint32_t    numQueries = numIncoherent / 4;
+        std::vector<vec3> points(numQueries);
+        for (auto& point : points) {
+            point = bounds.min + extent * vec3(dist(rng), dist(rng), dist(rng));
+        }
+
+        auto   start       = Clock::now();
+        double sumDistance = 0;
+        for (const auto& point : points) {
+            Bvh::ClosestPoint result = {};
+            if (bvh.FindClosestPoint(point, FLT_MAX, &result)) {
+                sumDistance += result.Distance;
+            }
+        }
+        double seconds = SecondsSince(start);
+
+        std::cout << "   closest point   : " << (numQueries / seconds / 1e6) << " Mqueries/s, mean distance "
+                  << (sumDistance / std::max(numQueries, 1u)) << std::endl;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t                 width         = 1024;
+    uint32_t                 height        = 1024;
+    uint32_t                 numIncoherent = 1 << 20;
+    std::vector<std::string> models        = {};
+
+    std::string badOption = "";
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if ((arg == "-w") || (arg == "-h") || (arg == "-rays") || (arg == "-model")) {
+            ++i;
+            if (i >= argc) {
+                badOption = arg;
+                break;
+            }
+        }
+
+        if (arg == "-w") {
+            width = static_cast<uint32_t>(std::max(atoi(argv[i]), 1));
+        }
+        else if (arg == "-h") {
+            height = static_cast<uint32_t>(std::max(atoi(argv[i]), 1));
+        }
+        else if (arg == "-rays") {
+            numIncoherent = static_cast<uint32_t>(std::max(atoi(argv[i]), 1));
+        }
+        else if (arg == "-model") {
+            models.push_back(argv[i]);
+        }
+        else {
+            std::cout << "error: unrecognized arg " << arg << std::endl;
+            std::cout << "   "
+                      << "bvh_bench [-w <width>] [-h <height>] [-rays <incoherent rays>] [-model <asset path>]..." << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+    if (!badOption.empty()) {
+        std::cout << "error: missing arg for option " << badOption << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    if (models.empty()) {
+        models = {"models/horse_statue_01_1k.obj", "models/material_knob.obj"};
+    }
+
+    for (const auto& model : models) {
+        TriMesh mesh;
+        if (!TriMesh::LoadOBJ(GetAssetPath(model).string(), "", {}, &mesh)) {
+            std::cout << "error: failed to load " << model << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        RunBenchmarks(model, mesh, width, height, numIncoherent);
+    }
+
+    return EXIT_SUCCESS;
+}
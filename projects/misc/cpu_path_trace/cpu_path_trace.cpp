@@ -0,0 +1,418 @@
+//
+// Renders the 031_raytracing_path_trace_pbr scene with the CPU reference
+// path tracer and writes the accumulated HDR image and the tonemapped
+// image. Samples/sec are reported after every pass, so this doubles as a
+// benchmark for the tracer.
+//
+// -denoise runs the edge aware denoiser on the result and also writes
+// <output>_denoised.hdr/.png. With -reference pointing at a converged
+// render, e.g. an earlier run with a high -spp, the error of the noisy
+// and the denoised image is printed.
+//
+// With the same IBL, window size, camera angle and max samples, the PNG
+// is what the GPU sample shows once it has finished accumulating.
+//
+
+#include "cpu_path_tracer.h"
+#include "denoiser.h"
+#include "window.h"
+
+#include <chrono>
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtx/transform.hpp>
+
+using glm::mat3x4;
+using glm::mat4;
+using glm::vec3;
+using glm::vec4;
+
+bool LoadMesh(const std::string& subPath, float rotateY, float scaleToFit, TriMesh* pMesh)
+{
+    TriMesh::Options options = {.enableNormals = true};
+    if (rotateY != 0) {
+        options.applyTransform    = true;
+        options.transformRotate.y = glm::radians(rotateY);
+    }
+
+    if (!TriMesh::LoadOBJ(GetAssetPath(subPath).string(), "", options, pMesh)) {
+        std::cout << "error: failed to load " << subPath << std::endl;
+        return false;
+    }
+
+    if (scaleToFit > 0) {
+        pMesh->ScaleToFit(scaleToFit);
+    }
+
+    return true;
+}
+
+// Same scene as CreateGeometries() and CreateTLAS() in 031_raytracing_path_trace_pbr_vulkan.cpp
+bool Build031Scene(CpuPathTracer* pTracer)
+{
+    TriMesh sphere = TriMesh::Sphere(1.0f, 256, 256, {.enableNormals = true});
+
+    TriMesh knob;
+    TriMesh monkey;
+    TriMesh teapot;
+    TriMesh box;
+    if (!LoadMesh("models/material_knob.obj", 180.0f, 1.25f, &knob) ||
+        !LoadMesh("models/monkey_lowres.obj", 0, 1.20f, &monkey) ||
+        !LoadMesh("models/teapot.obj", 160.0f, 1.5f, &teapot) ||
+        !LoadMesh("models/shelf.obj", 0, 0, &box)) {
+        return false;
+    }
+
+    // clang-format off
+    std::vector<mat3x4> transforms = {
+        // Spheres: rough plastic, shiny plastic, crystal, metal
+        {{ 1.0f, 0.0f,  0.0f,  1.25f}, { 0.0f, 1.0f,  0.0f,  4.0f  }, { 0.0f, 0.0f,  1.0f,  1.5f }},
+        {{-1.0f, 0.0f,  0.0f, -1.25f}, { 0.0f, 1.0f,  0.0f,  1.0f  }, { 0.0f, 0.0f, -1.0f, -1.5f }},
+        {{ 1.0f, 0.0f,  0.0f,  3.75f}, { 0.0f, 1.0f,  0.0f,  1.0f  }, { 0.0f, 0.0f,  1.0f,  1.5f }},
+        {{-1.0f, 0.0f,  0.0f,  3.75f}, { 0.0f, 1.0f,  0.0f,  4.0f  }, { 0.0f, 0.0f, -1.0f, -1.5f }},
+        // Knobs: rough plastic, shiny plastic, glass, metal
+        {{-1.0f, 0.0f,  0.0f,  3.75f}, { 0.0f, 1.0f,  0.0f,  0.96f }, { 0.0f, 0.0f, -1.0f, -1.5f }},
+        {{-1.0f, 0.0f,  0.0f, -3.75f}, { 0.0f, 1.0f,  0.0f,  3.96f }, { 0.0f, 0.0f, -1.0f, -1.5f }},
+        {{ 1.0f, 0.0f,  0.0f, -3.75f}, { 0.0f, 1.0f,  0.0f,  3.96f }, { 0.0f, 0.0f,  1.0f,  1.5f }},
+        {{ 1.0f, 0.0f,  0.0f, -1.25f}, { 0.0f, 1.0f,  0.0f,  0.96f }, { 0.0f, 0.0f,  1.0f,  1.5f }},
+        // Monkeys: rough plastic, shiny plastic, diamond, metal
+        {{-1.0f, 0.0f,  0.0f,  1.25f}, { 0.0f, 1.0f,  0.0f,  3.96f }, { 0.0f, 0.0f, -1.0f, -1.5f }},
+        {{ 1.0f, 0.0f,  0.0f,  1.25f}, { 0.0f, 1.0f,  0.0f,  0.96f }, { 0.0f, 0.0f,  1.0f,  1.5f }},
+        {{-1.0f, 0.0f,  0.0f, -3.75f}, { 0.0f, 1.0f,  0.0f,  0.96f }, { 0.0f, 0.0f, -1.0f, -1.5f }},
+        {{ 1.0f, 0.0f,  0.0f,  3.75f}, { 0.0f, 1.0f,  0.0f,  3.96f }, { 0.0f, 0.0f,  1.0f,  1.5f }},
+        // Teapots: rough plastic, shiny plastic, glass, metal
+        {{ 1.0f, 0.0f,  0.0f, -3.75f}, { 0.0f, 1.0f,  0.0f,  0.001f}, { 0.0f, 0.0f,  1.0f,  1.35f}},
+        {{ 1.0f, 0.0f,  0.0f, -1.25f}, { 0.0f, 1.0f,  0.0f,  3.001f}, { 0.0f, 0.0f,  1.0f,  1.35f}},
+        {{-1.0f, 0.0f,  0.0f, -1.25f}, { 0.0f, 1.0f,  0.0f,  3.001f}, { 0.0f, 0.0f, -1.0f, -1.35f}},
+        {{-1.0f, 0.0f,  0.0f,  1.25f}, { 0.0f, 1.0f,  0.0f,  0.001f}, { 0.0f, 0.0f, -1.0f, -1.35f}},
+        // Box
+        {{ 1.0f, 0.0f,  0.0f,  0.0f }, { 0.0f, 1.0f,  0.0f,  0.0f  }, { 0.0f, 0.0f,  1.0f,  0.0f }},
+    };
+
+    // baseColor, roughness, metallic, specularReflectance, ior, emissionColor
+    std::vector<CpuPathTracer::Material> materials = {
+        // Spheres
+        {vec3(0.0f, 1.0f, 1.0f),                    1.0f,  0, 0.0f, 0,      vec3(0)},
+        {vec3(0.07f, 0.05f, 0.1f),                  0.0f,  0, 1.0f, 0,      vec3(0)},
+        {F0_DiletricCrystal,                        0.0f,  0, 0.5f, 2.0f,   vec3(0)},
+        {F0_MetalChromium,                          0.25f, 1, 0.0f, 0,      vec3(0)},
+        // Knobs
+        {vec3(1.0f, 0.0f, 1.0f),                    1.0f,  0, 0.0f, 0,      vec3(0)},
+        {vec3(1.25f, 0.07f, 0.05f),                 0.0f,  0, 1.0f, 0,      vec3(0)},
+        {vec3(1, 1, 1),                             0.0f,  0, 0.5f, 1.5f,   vec3(0)},
+        {F0_MetalGold,                              0.25f, 1, 0.0f, 0,      vec3(0)},
+        // Monkeys
+        {vec3(1.0f, 1.0f, 0.2f),                    1.0f,  0, 0.0f, 0,      vec3(0)},
+        {vec3(0.2f, 1.0f, 0.2f),                    0.0f,  0, 1.0f, 0,      vec3(0)},
+        {F0_DiletricDiamond + vec3(0, 0, 0.25f),    0.0f,  0, 0.5f, 2.418f, vec3(0)},
+        {F0_MetalSilver,                            0.0f,  1, 0.0f, 0,      vec3(0)},
+        // Teapots
+        {vec3(1.0f, 1.0f, 1.0f),                    1.0f,  0, 0.0f, 0,      vec3(1.0f, 1.0f, 1.0f)},
+        {2.0f * vec3(1.0f, 0.35f, 0.05f),           0.0f,  0, 1.0f, 0,      vec3(0)},
+        {vec3(1, 1, 1),                             0.25f, 0, 0.5f, 1.5f,   vec3(0)},
+        {F0_MetalCopper,                            0.45f, 1, 0.0f, 0,      vec3(0)},
+        // Box
+        {vec3(0.35f, 0.36f, 0.36f),                 1.0f,  0, 0.2f, 0,      vec3(0)},
+    };
+    // clang-format on
+
+    const TriMesh* meshes[] = {
+        &sphere, &sphere, &sphere, &sphere,
+        &knob, &knob, &knob, &knob,
+        &monkey, &monkey, &monkey, &monkey,
+        &teapot, &teapot, &teapot, &teapot,
+        &box};
+
+    for (size_t i = 0; i < transforms.size(); ++i) {
+        uint32_t materialIndex = pTracer->AddMaterial(materials[i]);
+
+        // The TLAS takes rows, glm stores columns
+        mat4 transform = mat4(glm::transpose(transforms[i]));
+
+        pTracer->AddMesh(*meshes[i], transform, materialIndex);
+    }
+
+    return true;
+}
+
+// Root mean squared error and relative MSE, (x - ref)^2 / (ref^2 + 0.01), over every channel
+void ComputeError(const std::vector<vec3>& image, const BitmapRGBA32f& reference, double* pRMSE, double* pRelMSE)
+{
+    double sumSq    = 0;
+    double sumRelSq = 0;
+    for (uint32_t y = 0; y < reference.GetHeight(); ++y) {
+        for (uint32_t x = 0; x < reference.GetWidth(); ++x) {
+            const PixelRGBA32f* pRef  = reference.GetPixels(x, y);
+            const vec3&         color = image[y * reference.GetWidth() + x];
+
+            const float refColor[3] = {pRef->r, pRef->g, pRef->b};
+            for (uint32_t c = 0; c < 3; ++c) {
+                double diff = color[c] - refColor[c];
+                sumSq += diff * diff;
+                sumRelSq += diff * diff / (refColor[c] * refColor[c] + 0.01);
+            }
+        }
+    }
+
+    const double count = 3.0 * reference.GetWidth() * reference.GetHeight();
+    *pRMSE             = std::sqrt(sumSq / count);
+    *pRelMSE           = sumRelSq / count;
+}
+
+bool WriteImage(const std::filesystem::path& outputBase, const CpuPathTracer::Image& image)
+{
+    BitmapRGBA32f hdr = CpuPathTracer::ResolveHDR(image);
+    BitmapRGBA8u  ldr = CpuPathTracer::ResolveLDR(image);
+
+    auto hdrPath = std::filesystem::path(outputBase).replace_extension(".hdr");
+    auto pngPath = std::filesystem::path(outputBase).replace_extension(".png");
+    if (!BitmapRGBA32f::Save(hdrPath, &hdr) || !BitmapRGBA8u::Save(pngPath, &ldr)) {
+        std::cout << "error: failed to write " << outputBase << std::endl;
+        return false;
+    }
+
+    std::cout << "Wrote " << hdrPath << " and " << pngPath << std::endl;
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    std::string           iblName     = "";
+    std::filesystem::path outputBase  = "cpu_path_trace";
+    uint32_t              width       = 1280;
+    uint32_t              height      = 720;
+    uint32_t              numSamples  = 256;
+    uint32_t              passSamples = 16;
+    float                 angle       = 0;
+    bool                  denoise     = false;
+    std::filesystem::path referencePath;
+
+    CpuPathTracer::Options options        = {};
+    Denoiser::Options      denoiseOptions = {};
+
+    std::string badOption = "";
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if ((arg == "-w") || (arg == "-h") || (arg == "-spp") || (arg == "-pass") || (arg == "-max-samples") ||
+            (arg == "-threads") || (arg == "-tile") || (arg == "-angle") || (arg == "-ibl") || (arg == "-o") ||
+            (arg == "-denoise-iterations") || (arg == "-reference")) {
+            ++i;
+            if (i >= argc) {
+                badOption = arg;
+                break;
+            }
+        }
+
+        if (arg == "-w") {
+            width = static_cast<uint32_t>(std::max(atoi(argv[i]), 1));
+        }
+        else if (arg == "-h") {
+            height = static_cast<uint32_t>(std::max(atoi(argv[i]), 1));
+        }
+        else if (arg == "-spp") {
+            numSamples = static_cast<uint32_t>(std::max(atoi(argv[i]), 1));
+        }
+        else if (arg == "-pass") {
+            passSamples = static_cast<uint32_t>(std::max(atoi(argv[i]), 1));
+        }
+        else if (arg == "-max-samples") {
+            options.MaxSamples = static_cast<uint32_t>(std::max(atoi(argv[i]), 1));
+        }
+        else if (arg == "-threads") {
+            options.NumThreads = static_cast<uint32_t>(std::max(atoi(argv[i]), 0));
+        }
+        else if (arg == "-tile") {
+            options.TileSize = static_cast<uint32_t>(std::max(atoi(argv[i]), 1));
+        }
+        else if (arg == "-angle") {
+            angle = static_cast<float>(atof(argv[i]));
+        }
+        else if (arg == "-ibl") {
+            iblName = argv[i];
+        }
+        else if (arg == "-o") {
+            outputBase = argv[i];
+        }
+        else if (arg == "-denoise") {
+            denoise = true;
+        }
+        else if (arg == "-denoise-iterations") {
+            denoise                      = true;
+            denoiseOptions.NumIterations = static_cast<uint32_t>(std::max(atoi(argv[i]), 0));
+        }
+        else if (arg == "-reference") {
+            referencePath = argv[i];
+        }
+        else {
+            std::cout << "error: unrecognized arg " << arg << std::endl;
+            std::cout << "   "
+                      << "cpu_path_trace [-w <width>] [-h <height>] [-spp <samples>] [-pass <samples per pass>]" << std::endl;
+            std::cout << "   "
+                      << "               [-max-samples <n>] [-threads <n>] [-tile <size>] [-angle <degrees>]" << std::endl;
+            std::cout << "   "
+                      << "               [-ibl <name>] [-o <output path without extension>]" << std::endl;
+            std::cout << "   "
+                      << "               [-denoise] [-denoise-iterations <n>] [-reference <converged .hdr>]" << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+    if (!badOption.empty()) {
+        std::cout << "error: missing arg for option " << badOption << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    BitmapRGBA32f reference;
+    if (!referencePath.empty()) {
+        if (!BitmapRGBA32f::Load(referencePath, &reference)) {
+            std::cout << "error: failed to load " << referencePath << std::endl;
+            return EXIT_FAILURE;
+        }
+        if ((reference.GetWidth() != width) || (reference.GetHeight() != height)) {
+            std::cout << "error: reference is " << reference.GetWidth() << "x" << reference.GetHeight()
+                      << ", expected " << width << "x" << height << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    // IBL, the first one by name unless one was asked for
+    std::vector<std::filesystem::path> iblFiles;
+    for (auto& dir : GetEveryAssetPath("IBL")) {
+        for (auto& entry : std::filesystem::directory_iterator(dir)) {
+            if (entry.is_regular_file() && (entry.path().extension() == ".ibl")) {
+                iblFiles.push_back(std::filesystem::relative(entry.path(), dir.parent_path()));
+            }
+        }
+    }
+    std::sort(iblFiles.begin(), iblFiles.end());
+
+    auto iblIt = std::find_if(
+        iblFiles.begin(),
+        iblFiles.end(),
+        [&iblName](const std::filesystem::path& path) { return iblName.empty() || (path.stem().string() == iblName); });
+    if (iblIt == iblFiles.end()) {
+        std::cout << "error: IBL not found: " << iblName << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    IBLMaps ibl = {};
+    if (!LoadIBLMaps32f(*iblIt, &ibl)) {
+        std::cout << "error: failed to load " << *iblIt << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    CpuPathTracer tracer;
+    if (!Build031Scene(&tracer)) {
+        return EXIT_FAILURE;
+    }
+    tracer.SetEnvironment(ibl);
+
+    auto buildStart = std::chrono::high_resolution_clock::now();
+    tracer.Build();
+    auto buildEnd = std::chrono::high_resolution_clock::now();
+
+    std::cout << "Scene: " << tracer.GetNumTriangles() << " triangles, IBL " << iblIt->stem().string() << std::endl;
+    std::cout << "BVH build: " << std::chrono::duration<double, std::milli>(buildEnd - buildStart).count() << " ms" << std::endl;
+
+    // Same camera as the sample
+    mat4 transformEyeMat     = glm::rotate(glm::radians(-angle), vec3(0, 1, 0));
+    vec3 startingEyePosition = vec3(0, 4.0f, 8.5f);
+    vec3 eyePosition         = transformEyeMat * vec4(startingEyePosition, 1);
+    mat4 viewMat             = glm::lookAt(eyePosition, vec3(0, 3, 0), vec3(0, 1, 0));
+    mat4 projMat             = glm::perspective(glm::radians(60.0f), width / static_cast<float>(height), 0.1f, 10000.0f);
+
+    CpuPathTracer::Camera camera   = {};
+    camera.ViewInverseMatrix       = glm::inverse(viewMat);
+    camera.ProjectionInverseMatrix = glm::inverse(projMat);
+
+    CpuPathTracer::Image image = CpuPathTracer::Image(width, height);
+
+    uint64_t totalSamples = 0;
+    uint64_t totalRays    = 0;
+    double   totalSeconds = 0;
+    for (uint32_t done = 0; done < numSamples; done += passSamples) {
+        uint32_t thisPass = std::min(passSamples, numSamples - done);
+
+        CpuPathTracer::Stats stats = tracer.Render(camera, thisPass, options, &image);
+        if (stats.NumSamples == 0) {
+            break; // Every pixel is at max samples
+        }
+
+        totalSamples += stats.NumSamples;
+        totalRays += stats.NumRays;
+        totalSeconds += stats.ElapsedSeconds;
+
+        std::cout << "spp " << (done + thisPass) << "/" << numSamples
+                  << ": " << (stats.SamplesPerSecond / 1e6) << " Msamples/s"
+                  << ", " << (stats.RaysPerSecond / 1e6) << " Mrays/s"
+                  << ", " << stats.NumTiles << " tiles"
+                  << ", " << stats.NumThreads << " threads" << std::endl;
+    }
+
+    if (totalSeconds > 0) {
+        std::cout << "Total: " << totalSamples << " samples, " << totalRays << " rays in " << totalSeconds << " s"
+                  << " - " << (totalSamples / totalSeconds / 1e6) << " Msamples/s"
+                  << ", " << (totalRays / totalSeconds / 1e6) << " Mrays/s" << std::endl;
+    }
+
+    if (!WriteImage(outputBase, image)) {
+        return EXIT_FAILURE;
+    }
+
+    if (!denoise && reference.Empty()) {
+        return EXIT_SUCCESS;
+    }
+
+    CpuPathTracer::AOVs aovs = {};
+    CpuPathTracer::ResolveAOVs(image, &aovs);
+
+    double noisyRMSE   = 0;
+    double noisyRelMSE = 0;
+    if (!reference.Empty()) {
+        ComputeError(aovs.Color, reference, &noisyRMSE, &noisyRelMSE);
+        std::cout << "Noisy: RMSE " << noisyRMSE << ", relMSE " << noisyRelMSE << std::endl;
+    }
+
+    if (!denoise) {
+        return EXIT_SUCCESS;
+    }
+
+    Denoiser::Inputs inputs = {};
+    inputs.Width            = width;
+    inputs.Height           = height;
+    inputs.pColor           = DataPtr(aovs.Color);
+    inputs.pAlbedo          = DataPtr(aovs.Albedo);
+    inputs.pNormal          = DataPtr(aovs.Normal);
+    inputs.pDepth           = DataPtr(aovs.Depth);
+
+    denoiseOptions.NumThreads = options.NumThreads;
+
+    Denoiser          denoiser;
+    std::vector<vec3> denoised(aovs.Color.size());
+    Denoiser::Stats   denoiseStats = denoiser.Denoise(inputs, denoiseOptions, DataPtr(denoised));
+
+    std::cout << "Denoise: " << denoiseStats.ElapsedMs << " ms, " << denoiseOptions.NumIterations << " iterations"
+              << ", " << denoiseStats.NumThreads << " threads" << std::endl;
+
+    if (!reference.Empty()) {
+        double rmse   = 0;
+        double relMSE = 0;
+        ComputeError(denoised, reference, &rmse, &relMSE);
+        std::cout << "Denoised: RMSE " << rmse << ", relMSE " << relMSE
+                  << " (" << (noisyRelMSE / std::max(relMSE, 1e-12)) << "x lower)" << std::endl;
+    }
+
+    // Resolve through a single sample image so both get the same tonemap
+    CpuPathTracer::Image denoisedImage = CpuPathTracer::Image(width, height);
+    for (size_t i = 0; i < denoised.size(); ++i) {
+        denoisedImage.Accum[i]        = vec4(denoised[i], 1);
+        denoisedImage.SampleCounts[i] = 1;
+    }
+
+    auto denoisedBase = std::filesystem::path(outputBase);
+    denoisedBase.replace_filename(denoisedBase.stem().string() + "_denoised");
+    if (!WriteImage(denoisedBase, denoisedImage)) {
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
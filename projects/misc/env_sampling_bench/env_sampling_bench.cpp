@@ -0,0 +1,276 @@
+//
+// Compares strategies for sampling an IBL environment when estimating
+// diffuse irradiance, E(n) = integral of L(w) * max(dot(n, w), 0) dw, for a
+// set of normals spread over the sphere:
+//
+//   uniform - uniform directions on the sphere
+//   cosine  - cosine weighted hemisphere, what BRDF-only sampling does
+//             for a diffuse surface
+//   env     - EnvironmentSampler, luminance * sin(phi) importance sampling
+//   MIS     - half cosine, half env, balance heuristic
+//
+// For each sample count the RMSE against a high sample count reference is
+// printed relative to the mean irradiance, averaged over several runs.
+// Environment lookups are the same as GetIBLEnvironment() in the shaders.
+//
+
+#include "env_sampling.h"
+#include "window.h"
+
+#include <chrono>
+#include <iomanip>
+#include <random>
+
+using glm::vec2;
+using glm::vec3;
+
+const float kPi = 3.14159265358979f;
+
+struct Environment
+{
+    uint32_t          width  = 0;
+    uint32_t          height = 0;
+    std::vector<vec3> texels = {};
+};
+
+// Bilinear, U repeats and V clamps, clamped to 100 like GetIBLEnvironment()
+vec3 LookupEnvironment(const Environment& env, const vec3& dir)
+{
+    float theta = atan2f(dir.z, dir.x);
+    if (theta < 0) {
+        theta += 2.0f * kPi;
+    }
+    float phi = acosf(std::clamp(dir.y, -1.0f, 1.0f));
+
+    const int width  = static_cast<int>(env.width);
+    const int height = static_cast<int>(env.height);
+
+    float x  = theta / (2.0f * kPi) * width - 0.5f;
+    float y  = phi / kPi * height - 0.5f;
+    int   x0 = static_cast<int>(floorf(x));
+    int   y0 = static_cast<int>(floorf(y));
+    float fx = x - x0;
+    float fy = y - y0;
+    int   x1 = ((x0 + 1) % width + width) % width;
+    int   y1 = std::clamp(y0 + 1, 0, height - 1);
+    x0       = (x0 % width + width) % width;
+    y0       = std::clamp(y0, 0, height - 1);
+
+    vec3 c0 = env.texels[y0 * width + x0] * (1 - fx) + env.texels[y0 * width + x1] * fx;
+    vec3 c1 = env.texels[y1 * width + x0] * (1 - fx) + env.texels[y1 * width + x1] * fx;
+    return glm::min(c0 * (1 - fy) + c1 * fy, vec3(100.0f));
+}
+
+float Luminance(const vec3& c)
+{
+    return 0.2126f * c.r + 0.7152f * c.g + 0.0722f * c.b;
+}
+
+void MakeBasis(const vec3& n, vec3* pT, vec3* pB)
+{
+    vec3 up = (fabsf(n.y) < 0.999f) ? vec3(0, 1, 0) : vec3(1, 0, 0);
+    *pT     = glm::normalize(glm::cross(up, n));
+    *pB     = glm::cross(n, *pT);
+}
+
+enum Strategy
+{
+    STRATEGY_UNIFORM = 0,
+    STRATEGY_COSINE  = 1,
+    STRATEGY_ENV     = 2,
+    STRATEGY_MIS     = 3,
+    STRATEGY_COUNT   = 4,
+};
+
+const char* kStrategyNames[STRATEGY_COUNT] = {"uniform", "cosine", "env", "MIS"};
+
+// Luminance of the irradiance estimate for normal n from numSamples samples
+float EstimateIrradiance(
+    const Environment&        env,
+    const EnvironmentSampler& sampler,
+    const vec3&               n,
+    Strategy                  strategy,
+    uint32_t                  numSamples,
+    std::mt19937&             rng)
+{
+    std::uniform_real_distribution<float> dist(0.0f, 1.0f);
+
+    vec3 T, B;
+    MakeBasis(n, &T, &B);
+
+    double sum = 0;
+    for (uint32_t i = 0; i < numSamples; ++i) {
+        vec2 xi = vec2(dist(rng), dist(rng));
+
+        // MIS alternates between the two techniques, equal sample counts
+        bool useCosine = (strategy == STRATEGY_COSINE) || ((strategy == STRATEGY_MIS) && ((i & 1) == 0));
+        bool useEnv    = (strategy == STRATEGY_ENV) || ((strategy == STRATEGY_MIS) && ((i & 1) == 1));
+
+        vec3  dir = vec3(0);
+        float pdf = 0;
+        if (strategy == STRATEGY_UNIFORM) {
+            float z = 1.0f - 2.0f * xi.x;
+            float r = sqrtf(std::max(1.0f - z * z, 0.0f));
+            float a = 2.0f * kPi * xi.y;
+            dir     = vec3(r * cosf(a), r * sinf(a), z);
+            pdf     = 1.0f / (4.0f * kPi);
+        }
+        else if (useCosine) {
+            float r = sqrtf(xi.x);
+            float a = 2.0f * kPi * xi.y;
+            float z = sqrtf(std::max(1.0f - xi.x, 0.0f));
+            dir     = T * (r * cosf(a)) + B * (r * sinf(a)) + n * z;
+            pdf     = z / kPi;
+        }
+        else if (useEnv) {
+            dir = sampler.Sample(xi, &pdf);
+        }
+
+        float cosTheta = glm::dot(n, dir);
+        if ((cosTheta <= 0) || (pdf <= 0)) {
+            continue;
+        }
+
+        if (strategy == STRATEGY_MIS) {
+            // Balance heuristic with one sample from each technique per pair
+            pdf = 0.5f * (cosTheta / kPi) + 0.5f * sampler.Pdf(dir);
+        }
+
+        sum += Luminance(LookupEnvironment(env, dir)) * cosTheta / pdf;
+    }
+
+    return static_cast<float>(sum / numSamples);
+}
+
+int main(int argc, char** argv)
+{
+    std::string iblName       = "venice_sunset_4k";
+    uint32_t    numNormals    = 64;
+    uint32_t    numTrials     = 8;
+    uint32_t    numRefSamples = 1 << 17;
+
+    std::string badOption = "";
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if ((arg == "-ibl") || (arg == "-normals") || (arg == "-trials") || (arg == "-ref-samples")) {
+            ++i;
+            if (i >= argc) {
+                badOption = arg;
+                break;
+            }
+        }
+
+        if (arg == "-ibl") {
+            iblName = argv[i];
+        }
+        else if (arg == "-normals") {
+            numNormals = static_cast<uint32_t>(std::max(atoi(argv[i]), 1));
+        }
+        else if (arg == "-trials") {
+            numTrials = static_cast<uint32_t>(std::max(atoi(argv[i]), 1));
+        }
+        else if (arg == "-ref-samples") {
+            numRefSamples = static_cast<uint32_t>(std::max(atoi(argv[i]), 1));
+        }
+        else {
+            std::cout << "error: unrecognized arg " << arg << std::endl;
+            std::cout << "   "
+                      << "env_sampling_bench [-ibl <name>] [-normals <n>] [-trials <n>] [-ref-samples <n>]" << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+    if (!badOption.empty()) {
+        std::cout << "error: missing arg for option " << badOption << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    IBLMaps ibl = {};
+    if (!LoadIBLMaps32f("IBL/" + iblName + ".ibl", &ibl)) {
+        std::cout << "error: failed to load IBL " << iblName << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // Base level only, the path tracers sample LOD 0
+    Environment env = {};
+    env.width       = std::min(ibl.baseWidth, ibl.environmentMap.GetWidth());
+    env.height      = std::min(ibl.baseHeight, ibl.environmentMap.GetHeight());
+    env.texels.resize(static_cast<size_t>(env.width) * env.height);
+    for (uint32_t y = 0; y < env.height; ++y) {
+        for (uint32_t x = 0; x < env.width; ++x) {
+            const PixelRGBA32f* pPixel = ibl.environmentMap.GetPixels(x, y);
+
+            env.texels[y * env.width + x] = vec3(pPixel->r, pPixel->g, pPixel->b);
+        }
+    }
+
+    auto               buildStart = std::chrono::high_resolution_clock::now();
+    EnvironmentSampler sampler;
+    if (!EnvironmentSampler::Create(ibl, {}, &sampler)) {
+        std::cout << "error: failed to create the sampling table" << std::endl;
+        return EXIT_FAILURE;
+    }
+    auto buildEnd = std::chrono::high_resolution_clock::now();
+
+    std::cout << "IBL " << iblName << ": " << env.width << "x" << env.height << ", sampling table " << sampler.GetWidth()
+              << "x" << sampler.GetHeight() << (ibl.samplingTablePath.empty() ? " built in " : " loaded in ")
+              << std::chrono::duration<double, std::milli>(buildEnd - buildStart).count() << " ms" << std::endl;
+
+    // Normals on a Fibonacci sphere
+    std::vector<vec3> normals(numNormals);
+    for (uint32_t i = 0; i < numNormals; ++i) {
+        float y    = 1.0f - 2.0f * (i + 0.5f) / numNormals;
+        float r    = sqrtf(std::max(1.0f - y * y, 0.0f));
+        float a    = i * kPi * (3.0f - sqrtf(5.0f));
+        normals[i] = vec3(r * cosf(a), y, r * sinf(a));
+    }
+
+    // Reference
+    std::mt19937       rng(1);
+    std::vector<float> reference(numNormals);
+    double             meanReference = 0;
+    for (uint32_t i = 0; i < numNormals; ++i) {
+        reference[i] = EstimateIrradiance(env, sampler, normals[i], STRATEGY_MIS, numRefSamples, rng);
+        meanReference += reference[i];
+    }
+    meanReference /= numNormals;
+
+    std::cout << "Relative RMSE over " << numNormals << " normals x " << numTrials << " trials, mean irradiance luminance "
+              << meanReference << std::endl;
+    std::cout << "   spp";
+    for (uint32_t s = 0; s < STRATEGY_COUNT; ++s) {
+        std::cout << std::setw(12) << kStrategyNames[s];
+    }
+    std::cout << std::endl;
+
+    double seconds[STRATEGY_COUNT] = {};
+    for (uint32_t spp = 1; spp <= 1024; spp *= 4) {
+        std::cout << std::setw(6) << spp;
+        for (uint32_t s = 0; s < STRATEGY_COUNT; ++s) {
+            auto start = std::chrono::high_resolution_clock::now();
+
+            double sumSqError = 0;
+            for (uint32_t trial = 0; trial < numTrials; ++trial) {
+                for (uint32_t i = 0; i < numNormals; ++i) {
+                    float estimate = EstimateIrradiance(env, sampler, normals[i], static_cast<Strategy>(s), spp, rng);
+                    sumSqError += (estimate - reference[i]) * (estimate - reference[i]);
+                }
+            }
+
+            seconds[s] += std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+            double rmse = sqrt(sumSqError / (numTrials * numNormals)) / std::max(meanReference, 1e-12);
+            std::cout << std::setw(12) << std::setprecision(4) << rmse;
+        }
+        std::cout << std::endl;
+    }
+
+    // Every strategy evaluated the same number of samples
+    double totalSamples = numTrials * numNormals * (1.0 + 4 + 16 + 64 + 256 + 1024);
+    std::cout << "Msamples/s";
+    for (uint32_t s = 0; s < STRATEGY_COUNT; ++s) {
+        std::cout << "  " << kStrategyNames[s] << " " << std::setprecision(3) << (totalSamples / seconds[s] / 1e6);
+    }
+    std::cout << std::endl;
+
+    return EXIT_SUCCESS;
+}
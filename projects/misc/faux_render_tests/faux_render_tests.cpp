@@ -0,0 +1,810 @@
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "host_faux_render.h"
+#include "faux_render_scene_file.h"
+
+//
+// Checks the CPU side of FauxRender against HostFauxRender, no graphics API
+// needed. Each test sets up a small synthetic case and compares the result
+// with values worked out by hand. glTF scenes passed on the command line
+// are loaded and their draw list reduction is reported.
+//
+// Exits with EXIT_FAILURE if any check fails.
+//
+// usage: faux_render_tests [scene.gltf ...]
+//
+
+static uint32_t gNumChecks   = 0;
+static uint32_t gNumFailures = 0;
+
+#define CHECK(COND) Check((COND), #COND, __LINE__)
+
+static void Check(bool cond, const char* pExpr, int line)
+{
+    ++gNumChecks;
+    if (!cond)
+    {
+        ++gNumFailures;
+        std::cout << "  FAILED line " << line << ": " << pExpr << std::endl;
+    }
+}
+
+static void PrintReduction(const std::string& name, const FauxRender::DrawList& drawList)
+{
+    const uint32_t numDraws = CountU32(drawList.Draws);
+    const double   percent  = (drawList.NumNodeDraws > 0) ? (100.0 * (drawList.NumNodeDraws - numDraws) / drawList.NumNodeDraws) : 0.0;
+
+    std::cout << "  " << name << ": " << drawList.NumNodeDraws << " node draws -> " << numDraws << " instanced draws ("
+              << std::fixed << std::setprecision(1) << percent << "% fewer)" << std::endl;
+}
+
+// =============================================================================
+// Slot tables
+// =============================================================================
+static void TestSlotTable()
+{
+    std::cout << "slot table" << std::endl;
+
+    FauxRender::SlotTable table = {4};
+
+    // Slots are handed out in order, capacity starts at MinCapacity and doubles
+    for (uint32_t i = 0; i < 5; ++i)
+    {
+        CHECK(table.Allocate() == i);
+    }
+    CHECK(table.Count == 5);
+    CHECK(table.NumSlots == 5);
+    CHECK(table.Capacity == 8);
+    CHECK(table.IsDirty() && (table.DirtyBegin == 0) && (table.DirtyEnd == 5));
+
+    table.ClearDirty();
+    CHECK(!table.IsDirty());
+
+    // Freed slots are dirty so they get zeroed, and are reused last freed first
+    table.Free(1);
+    table.Free(3);
+    CHECK(table.Count == 3);
+    CHECK(!table.IsLive(1) && !table.IsLive(3) && table.IsLive(2));
+    CHECK((table.DirtyBegin == 1) && (table.DirtyEnd == 4));
+
+    table.ClearDirty();
+    CHECK(table.Allocate() == 3);
+    CHECK(table.Allocate() == 1);
+    CHECK((table.DirtyBegin == 1) && (table.DirtyEnd == 4));
+
+    // The table only grows once the free slots are used up
+    CHECK(table.Allocate() == 5);
+    CHECK(table.NumSlots == 6);
+    CHECK(table.Capacity == 8);
+    CHECK(table.Count == 6);
+
+    table.MarkAllDirty();
+    CHECK((table.DirtyBegin == 0) && (table.DirtyEnd == table.NumSlots));
+}
+
+static bool CreateTestImage(FauxRender::SceneGraph* pGraph, FauxRender::Image** ppImage)
+{
+    const uint32_t pixels[4] = {};
+    return pGraph->CreateImage(2, 2, GREX_FORMAT_R8G8B8A8_UNORM, {MipOffset{0, 8}}, sizeof(pixels), pixels, ppImage);
+}
+
+static void TestImageTable()
+{
+    std::cout << "image table" << std::endl;
+
+    HostFauxRender::SceneGraph graph;
+    CHECK(!IsNull(graph.pDefaultBaseColorImage));
+
+    const uint32_t numDefaultImages = CountU32(graph.Images);
+
+    FauxRender::Image* pImage0 = nullptr;
+    FauxRender::Image* pImage1 = nullptr;
+    CHECK(CreateTestImage(&graph, &pImage0));
+    CHECK(CreateTestImage(&graph, &pImage1));
+    CHECK(graph.GetImageIndex(pImage0) == numDefaultImages);
+    CHECK(graph.GetImageIndex(pImage1) == numDefaultImages + 1);
+
+    // A removed image leaves a NULL slot that descriptors fill with the default
+    const uint32_t slot0 = pImage0->Index;
+    graph.RemoveImage(pImage0);
+    CHECK(!graph.Images[slot0]);
+    CHECK(graph.GetDescriptorImage(slot0) == graph.pDefaultBaseColorImage);
+    CHECK(graph.GetDescriptorImage(pImage1->Index) == pImage1);
+
+    // ...and is reused by the next image
+    FauxRender::Image* pImage2 = nullptr;
+    CHECK(CreateTestImage(&graph, &pImage2));
+    CHECK(graph.GetImageIndex(pImage2) == slot0);
+    CHECK(graph.GetDescriptorImage(slot0) == pImage2);
+
+    // Images past the shader image range fail
+    while (CountU32(graph.Images) < FauxRender::Shader::MAX_IMAGES)
+    {
+        FauxRender::Image* pImage = nullptr;
+        if (!CreateTestImage(&graph, &pImage))
+        {
+            break;
+        }
+    }
+    CHECK(graph.Images.size() == FauxRender::Shader::MAX_IMAGES);
+    CHECK(graph.IsImageTableFull());
+
+    FauxRender::Image* pExtraImage = nullptr;
+    CHECK(!CreateTestImage(&graph, &pExtraImage));
+    CHECK(IsNull(pExtraImage));
+
+    graph.RemoveImage(pImage1);
+    CHECK(!graph.IsImageTableFull());
+    CHECK(CreateTestImage(&graph, &pExtraImage));
+    CHECK(graph.Images.size() == FauxRender::Shader::MAX_IMAGES);
+
+    // Same for samplers
+    FauxRender::Sampler* pSampler = nullptr;
+    while (graph.Samplers.size() < FauxRender::Shader::MAX_SAMPLERS)
+    {
+        if (!graph.CreateSampler(
+                FauxRender::FILTER_MODE_LINEAR,
+                FauxRender::FILTER_MODE_LINEAR,
+                FauxRender::FILTER_MODE_LINEAR,
+                FauxRender::TEXTURE_ADDRESS_MODE_WRAP,
+                FauxRender::TEXTURE_ADDRESS_MODE_WRAP,
+                FauxRender::TEXTURE_ADDRESS_MODE_WRAP,
+                &pSampler))
+        {
+            break;
+        }
+    }
+    CHECK(graph.Samplers.size() == FauxRender::Shader::MAX_SAMPLERS);
+    CHECK(!graph.CreateSampler(
+        FauxRender::FILTER_MODE_LINEAR,
+        FauxRender::FILTER_MODE_LINEAR,
+        FauxRender::FILTER_MODE_LINEAR,
+        FauxRender::TEXTURE_ADDRESS_MODE_WRAP,
+        FauxRender::TEXTURE_ADDRESS_MODE_WRAP,
+        FauxRender::TEXTURE_ADDRESS_MODE_WRAP,
+        &pSampler));
+}
+
+static void TestMaterialBuffer()
+{
+    std::cout << "material buffer" << std::endl;
+
+    HostFauxRender::SceneGraph graph(false);
+
+    auto readRoughness = [](FauxRender::Buffer* pBuffer, uint32_t index) {
+        auto pParams = reinterpret_cast<const FauxRender::Shader::MaterialParams*>(HostFauxRender::Cast(pBuffer)->Data.data());
+        return pParams[index].RoughnessFactor;
+    };
+
+    auto pMaterial = graph.AddMaterial();
+    CHECK(graph.UpdateMaterialBuffer());
+
+    auto pFirstBuffer = graph.pMaterialBuffer;
+    CHECK(!IsNull(pFirstBuffer));
+    CHECK(pFirstBuffer->Size == FauxRender::INITIAL_MATERIAL_CAPACITY * sizeof(FauxRender::Shader::MaterialParams));
+    CHECK(graph.RetiredBuffers.empty());
+
+    // Nothing changed: the current copy stays
+    CHECK(graph.UpdateMaterialBuffer());
+    CHECK(graph.pMaterialBuffer == pFirstBuffer);
+
+    // Updates go to the next copy, the one frames in flight may read is left alone
+    std::vector<FauxRender::Buffer*> copies      = {pFirstBuffer};
+    const float                      roughness[] = {0.25f, 0.5f, 0.75f};
+    for (float value : roughness)
+    {
+        pMaterial->RoughnessFactor = value;
+        graph.UpdateMaterial(pMaterial);
+        CHECK(graph.UpdateMaterialBuffer());
+        CHECK(graph.pMaterialBuffer != copies.back());
+        CHECK(readRoughness(graph.pMaterialBuffer, pMaterial->Index) == value);
+        CHECK(readRoughness(copies.back(), pMaterial->Index) != value);
+        copies.push_back(graph.pMaterialBuffer);
+    }
+
+    // After NUM_BUFFERED_FRAMES updates the first copy is reused and catches up
+    CHECK(FauxRender::NUM_BUFFERED_FRAMES == 3);
+    CHECK(graph.pMaterialBuffer == pFirstBuffer);
+    CHECK(readRoughness(pFirstBuffer, pMaterial->Index) == 0.75f);
+    CHECK(graph.RetiredBuffers.empty());
+
+    // Growing replaces the next copy, the old one is retired instead of kept in Buffers
+    for (uint32_t i = 0; i < FauxRender::INITIAL_MATERIAL_CAPACITY; ++i)
+    {
+        graph.AddMaterial();
+    }
+    CHECK(graph.UpdateMaterialBuffer());
+    CHECK(graph.pMaterialBuffer != copies[1]);
+    CHECK(graph.pMaterialBuffer->Size == 2 * FauxRender::INITIAL_MATERIAL_CAPACITY * sizeof(FauxRender::Shader::MaterialParams));
+    CHECK(readRoughness(graph.pMaterialBuffer, pMaterial->Index) == 0.75f);
+    CHECK(graph.NumMaterials == FauxRender::INITIAL_MATERIAL_CAPACITY + 1);
+    CHECK((graph.RetiredBuffers.size() == 1) && (graph.RetiredBuffers[0].get() == copies[1]));
+
+    bool retiredBufferInGraph = false;
+    for (const auto& pBuffer : graph.Buffers)
+    {
+        retiredBufferInGraph = retiredBufferInGraph || (pBuffer.get() == copies[1]);
+    }
+    CHECK(!retiredBufferInGraph);
+
+    graph.ReleaseRetiredBuffers();
+    CHECK(graph.RetiredBuffers.empty());
+}
+
+// =============================================================================
+// Draw lists
+// =============================================================================
+static FauxRender::PrimitiveBatch CreateBatch(FauxRender::Material* pMaterial, uint32_t indexCount, bool tangents)
+{
+    FauxRender::PrimitiveBatch batch = {};
+    batch.pMaterial                  = pMaterial;
+    batch.IndexBufferView.Format     = GREX_FORMAT_R32_UINT;
+    batch.IndexBufferView.Count      = indexCount;
+    batch.PositionBufferView.Format  = GREX_FORMAT_R32G32B32_FLOAT;
+    batch.NormalBufferView.Format    = GREX_FORMAT_R32G32B32_FLOAT;
+    if (tangents)
+    {
+        batch.TangentBufferView.Format = GREX_FORMAT_R32G32B32A32_FLOAT;
+    }
+    return batch;
+}
+
+//
+// Three meshes instanced by eight nodes, plus a freed instance slot:
+//
+//   mesh A - batches with material 1 and material 0, 4 nodes
+//   mesh B - tangents, material 0, 3 nodes
+//   mesh C - material 1 and a batch without material, 1 node
+//
+// Without instancing that's 4 * 2 + 3 + 1 = 12 draws, with instancing one
+// per batch that has a material: 4.
+//
+static void TestDrawList()
+{
+    std::cout << "draw list" << std::endl;
+
+    HostFauxRender::SceneGraph graph(false);
+
+    auto pMaterial0 = graph.AddMaterial();
+    auto pMaterial1 = graph.AddMaterial();
+
+    graph.Meshes.push_back(std::make_unique<FauxRender::Mesh>());
+    auto pMeshA = graph.Meshes.back().get();
+    pMeshA->DrawBatches.push_back(CreateBatch(pMaterial1, 30, false));
+    pMeshA->DrawBatches.push_back(CreateBatch(pMaterial0, 60, false));
+
+    graph.Meshes.push_back(std::make_unique<FauxRender::Mesh>());
+    auto pMeshB = graph.Meshes.back().get();
+    pMeshB->DrawBatches.push_back(CreateBatch(pMaterial0, 90, true));
+
+    graph.Meshes.push_back(std::make_unique<FauxRender::Mesh>());
+    auto pMeshC = graph.Meshes.back().get();
+    pMeshC->DrawBatches.push_back(CreateBatch(pMaterial1, 120, false));
+    pMeshC->DrawBatches.push_back(CreateBatch(nullptr, 150, false));
+
+    // Instance index:            0       1       2       3       4        5       6       7       8
+    FauxRender::Mesh* meshes[] = {pMeshA, pMeshB, pMeshA, pMeshC, nullptr, pMeshB, pMeshA, pMeshA, pMeshB};
+
+    FauxRender::Scene                   scene = {};
+    std::vector<FauxRender::SceneNode*> nodes = {};
+    for (auto pMesh : meshes)
+    {
+        auto pNode   = graph.AddNode();
+        pNode->Type  = FauxRender::SCENE_NODE_TYPE_GEOMETRY;
+        pNode->pMesh = IsNull(pMesh) ? pMeshA : pMesh;
+        scene.AddGeometryNode(pNode);
+        nodes.push_back(pNode);
+    }
+    scene.RemoveGeometryNode(nodes[4]);
+    CHECK(graph.UpdateInstanceBuffer(&scene));
+
+    FauxRender::DrawList drawList = {};
+    CHECK(FauxRender::BuildDrawList(&graph, &scene, &drawList));
+
+    CHECK(drawList.NumNodeDraws == 12);
+    CHECK(drawList.Draws.size() == 4);
+    CHECK(drawList.IndirectArgs.size() == drawList.Draws.size());
+
+    // Meshes keep the order they're first seen in: A, B, C
+    const std::vector<uint32_t> expectedInstances = {0, 2, 6, 7, 1, 5, 8, 3};
+    CHECK(drawList.InstanceIndices == expectedInstances);
+
+    // Sorted by vertex layout then material, so B with tangents is last
+    struct Expected
+    {
+        const FauxRender::Mesh* pMesh;
+        uint32_t                BatchIndex;
+        uint32_t                MaterialIndex;
+        uint32_t                FirstInstance;
+        uint32_t                InstanceCount;
+        uint32_t                IndexCount;
+    };
+    const Expected expectedDraws[] = {
+        {pMeshA, 1, 0, 0, 4, 60},
+        {pMeshA, 0, 1, 0, 4, 30},
+        {pMeshC, 0, 1, 7, 1, 120},
+        {pMeshB, 0, 0, 4, 3, 90},
+    };
+
+    for (size_t i = 0; (i < drawList.Draws.size()) && (i < std::size(expectedDraws)); ++i)
+    {
+        const auto& draw     = drawList.Draws[i];
+        const auto& args     = drawList.IndirectArgs[i];
+        const auto& expected = expectedDraws[i];
+
+        CHECK(draw.pMesh == expected.pMesh);
+        CHECK(draw.BatchIndex == expected.BatchIndex);
+        CHECK(draw.MaterialIndex == expected.MaterialIndex);
+        CHECK(draw.FirstInstance == expected.FirstInstance);
+        CHECK(draw.InstanceCount == expected.InstanceCount);
+        CHECK(args.IndexCount == expected.IndexCount);
+        CHECK(args.InstanceCount == expected.InstanceCount);
+        CHECK(args.FirstInstance == 0);
+
+        // Every instance in the draw's range uses the draw's mesh
+        for (uint32_t j = 0; j < draw.InstanceCount; ++j)
+        {
+            const uint32_t instanceIndex = drawList.InstanceIndices[draw.FirstInstance + j];
+            CHECK(scene.GeometryNodes[instanceIndex]->pMesh == draw.pMesh);
+        }
+    }
+
+    CHECK(graph.InitializeDrawList(&scene, &drawList));
+    CHECK(!IsNull(drawList.pInstanceBuffer) && (drawList.pInstanceBuffer->Size == 8 * sizeof(FauxRender::Shader::InstanceParams)));
+    CHECK(!IsNull(drawList.pIndirectArgsBuffer) && (drawList.pIndirectArgsBuffer->Size == 4 * sizeof(FauxRender::Shader::DrawIndexedIndirectArgs)));
+
+    auto readTranslation = [](FauxRender::Buffer* pBuffer, uint32_t index) {
+        auto pParams = reinterpret_cast<const FauxRender::Shader::InstanceParams*>(HostFauxRender::Cast(pBuffer)->Data.data());
+        return glm::vec3(pParams[index].ModelMatrix[3]);
+    };
+
+    // Moving a node reaches the draw list's next copy, instance 3 is the
+    // last in draw order
+    auto pFirstBuffer = drawList.pInstanceBuffer;
+    CHECK(graph.UpdateDrawList(&scene, &drawList));
+    CHECK(drawList.pInstanceBuffer == pFirstBuffer);
+
+    nodes[3]->Translate = glm::vec3(1, 2, 3);
+    scene.UpdateGeometryNode(nodes[3]);
+    CHECK(graph.UpdateInstanceBuffer(&scene));
+    CHECK(graph.UpdateDrawList(&scene, &drawList));
+    CHECK(drawList.pInstanceBuffer != pFirstBuffer);
+    CHECK(readTranslation(drawList.pInstanceBuffer, 7) == glm::vec3(1, 2, 3));
+    CHECK(readTranslation(pFirstBuffer, 7) == glm::vec3(0));
+
+    // Destroying retires all of the list's buffers
+    const size_t numBuffers = graph.Buffers.size();
+    graph.DestroyDrawList(&drawList);
+    CHECK(IsNull(drawList.pInstanceBuffer) && IsNull(drawList.pIndirectArgsBuffer));
+    CHECK(graph.RetiredBuffers.size() == 3);
+    CHECK(graph.Buffers.size() == numBuffers - 3);
+    graph.ReleaseRetiredBuffers();
+
+    PrintReduction("synthetic", drawList);
+}
+
+// =============================================================================
+// Texture streaming
+// =============================================================================
+static FauxRender::StreamingImageSource CreateStreamingSource(uint32_t size)
+{
+    FauxRender::StreamingImageSource source = {};
+    source.Width                            = size;
+    source.Height                           = size;
+    source.Format                           = GREX_FORMAT_R8G8B8A8_UNORM;
+
+    for (uint32_t levelSize = size; levelSize > 0; levelSize >>= 1)
+    {
+        MipOffset mipOffset = {};
+        mipOffset.Offset    = static_cast<uint32_t>(source.Data.size());
+        mipOffset.RowStride = levelSize * 4;
+        source.MipOffsets.push_back(mipOffset);
+
+        source.Data.resize(source.Data.size() + mipOffset.RowStride * levelSize);
+    }
+
+    return source;
+}
+
+// Looks down -Z at the origin from z, or away from it
+static FauxRender::StreamingView CreateStreamingView(float z, bool facingAway)
+{
+    const vec3 eyePosition = vec3(0, 0, z);
+    const vec3 center      = eyePosition + vec3(0, 0, facingAway ? 1.0f : -1.0f);
+
+    FauxRender::StreamingView view = {};
+    view.EyePosition               = eyePosition;
+    view.FovY                      = glm::radians(60.0f);
+    view.ViewportHeight            = 1080;
+    view.ViewProjectionMatrix      = glm::perspective(view.FovY, 16.0f / 9.0f, 0.1f, 1000.0f) * glm::lookAt(eyePosition, center, vec3(0, 1, 0));
+    return view;
+}
+
+//
+// One 256x256 RGBA8 image on a unit cube at the origin. With the default
+// MinTailSize of 64 the tail starts at level 2, and the resident sizes are:
+//
+//   level 0 - 349524 bytes
+//   level 1 -  87380 bytes
+//   level 2 -  21844 bytes (tail)
+//
+// The view is 1080 pixels high with a 60 degree FOV, so about 935 pixels
+// per world unit at a distance of 1. The required level is
+// log2(256 * distance / 935): level 0 at distance 1, level 1 at 10 and the
+// tail at 100.
+//
+static void TestTextureStreamer()
+{
+    std::cout << "texture streamer" << std::endl;
+
+    HostFauxRender::SceneGraph  graph;
+    FauxRender::TextureStreamer streamer = {};
+
+    FauxRender::Image* pImage = nullptr;
+    CHECK(streamer.AddImage(&graph, CreateStreamingSource(256), &pImage));
+    CHECK(!IsNull(pImage));
+    CHECK(streamer.ImagesChanged);
+    streamer.ImagesChanged = false;
+
+    const auto& entry = streamer.Entries[0];
+    CHECK(entry.TailLevel == 2);
+    CHECK(entry.ResidentLevel == 2);
+    CHECK((pImage->Width == 64) && (pImage->Height == 64));
+    CHECK(streamer.Stats.ResidentBytes == 21844);
+
+    graph.Textures.push_back(std::make_unique<FauxRender::Texture>());
+    auto pTexture    = graph.Textures.back().get();
+    pTexture->pImage = pImage;
+
+    auto pMaterial               = graph.AddMaterial();
+    pMaterial->pBaseColorTexture = pTexture;
+
+    graph.Meshes.push_back(std::make_unique<FauxRender::Mesh>());
+    auto pMesh    = graph.Meshes.back().get();
+    pMesh->Bounds = {vec3(-0.5f), vec3(0.5f)};
+    pMesh->DrawBatches.push_back(CreateBatch(pMaterial, 36, false));
+
+    auto pNode   = graph.AddNode();
+    pNode->Type  = FauxRender::SCENE_NODE_TYPE_GEOMETRY;
+    pNode->pMesh = pMesh;
+
+    FauxRender::Scene scene = {};
+    scene.BVH.FatMargin     = 0;
+    scene.AddGeometryNode(pNode);
+    CHECK(graph.UpdateInstanceBuffer(&scene));
+    CHECK(graph.UpdateMaterialBuffer());
+
+    // Required level follows the distance, images out of view only need the tail
+    auto requiredLevel = [&](float z, bool facingAway) {
+        streamer.ComputeRequiredLevels(&graph, &scene, CreateStreamingView(z, facingAway));
+        return streamer.Entries[0].RequiredLevel;
+    };
+    CHECK(requiredLevel(1.5f, false) == 0);
+    CHECK(requiredLevel(10.5f, false) == 1);
+    CHECK(requiredLevel(100.5f, false) == 2);
+    CHECK(requiredLevel(1.5f, true) == 2);
+
+    // Budget for everything: the finest level is loaded and the texture
+    // and material move to the new image
+    streamer.BudgetBytes = 1024 * 1024;
+    CHECK(streamer.Update(&graph, &scene, CreateStreamingView(1.5f, false)));
+    CHECK(entry.TargetLevel == 0);
+    CHECK(entry.ResidentLevel == 0);
+    CHECK(streamer.Stats.ResidentBytes == 349524);
+    CHECK(streamer.Stats.NumLoads == 1);
+    CHECK(streamer.ImagesChanged);
+    CHECK(pTexture->pImage == entry.pImage);
+    CHECK((entry.pImage->Width == 256) && (entry.pImage->Height == 256));
+    CHECK(graph.MaterialSlots.IsDirty());
+    CHECK(streamer.RetiredImages.size() == 1);
+
+    // The tail image is still in the graph for frames in flight
+    const uint32_t tailSlot = pImage->Index;
+    CHECK(graph.GetDescriptorImage(tailSlot) == pImage);
+
+    // Budget below level 0: coarsened to level 1 even though 0 is required
+    streamer.ImagesChanged = false;
+    streamer.BudgetBytes   = 100000;
+    CHECK(streamer.Update(&graph, &scene, CreateStreamingView(1.5f, false)));
+    CHECK(entry.RequiredLevel == 0);
+    CHECK(entry.TargetLevel == 1);
+    CHECK(entry.ResidentLevel == 1);
+    CHECK(streamer.Stats.NumImagesBelowRequired == 1);
+    CHECK(streamer.Stats.NumEvictions == 1);
+    CHECK(streamer.Stats.BytesEvicted == 349524 - 87380);
+    CHECK(streamer.ImagesChanged);
+    CHECK(streamer.RetiredImages.size() == 2);
+
+    // The tail image is removed RetireLatency updates after it was replaced,
+    // its slot reads as the default image until it's reused
+    CHECK(streamer.Update(&graph, &scene, CreateStreamingView(1.5f, false)));
+    CHECK(graph.GetDescriptorImage(tailSlot) == pImage);
+    streamer.ImagesChanged = false;
+    CHECK(streamer.Update(&graph, &scene, CreateStreamingView(1.5f, false)));
+    CHECK(streamer.ImagesChanged);
+    CHECK(!graph.Images[tailSlot]);
+    CHECK(graph.GetDescriptorImage(tailSlot) == graph.pDefaultBaseColorImage);
+    CHECK(streamer.RetiredImages.size() == 1);
+
+    // The budget never takes the tail
+    streamer.BudgetBytes = 1000;
+    CHECK(streamer.Update(&graph, &scene, CreateStreamingView(1.5f, false)));
+    CHECK(entry.TargetLevel == 2);
+    CHECK(entry.ResidentLevel == 2);
+    CHECK(streamer.Stats.ResidentBytes == 21844);
+
+    streamer.ReleaseRetiredImages(&graph);
+    CHECK(streamer.RetiredImages.empty());
+    CHECK(graph.GetImageIndex(entry.pImage) != UINT32_MAX);
+    CHECK(graph.GetDescriptorImage(entry.pImage->Index) == entry.pImage);
+}
+
+// =============================================================================
+// Deformed buffers
+// =============================================================================
+//
+// Two nodes share a mesh with one morph target that moves every vertex up
+// by 1, node A at weight 0 and node B at weight 1. Each node has to end up
+// with its own vertices and its own draw.
+//
+static void TestDeformedBuffers()
+{
+    std::cout << "deformed buffers" << std::endl;
+
+    HostFauxRender::SceneGraph graph(false);
+
+    auto pMaterial = graph.AddMaterial();
+
+    const std::vector<vec3> positions = {vec3(0, 0, 0), vec3(1, 0, 0), vec3(0, 1, 0)};
+    const uint32_t          indices[] = {0, 1, 2};
+
+    // Indices first, then positions
+    std::vector<char> meshData(sizeof(indices) + SizeInBytes(positions));
+    memcpy(meshData.data(), indices, sizeof(indices));
+    memcpy(meshData.data() + sizeof(indices), DataPtr(positions), SizeInBytes(positions));
+
+    graph.Meshes.push_back(std::make_unique<FauxRender::Mesh>());
+    auto pMesh = graph.Meshes.back().get();
+    CHECK(graph.CreateBuffer(CountU32(meshData), CountU32(meshData), meshData.data(), true, &pMesh->pBuffer));
+
+    auto batch                      = CreateBatch(pMaterial, 3, false);
+    batch.NormalBufferView          = {};
+    batch.PositionBufferView.Offset = sizeof(indices);
+    batch.PositionBufferView.Size   = static_cast<uint32_t>(SizeInBytes(positions));
+    batch.PositionBufferView.Stride = sizeof(vec3);
+    batch.PositionBufferView.Count  = CountU32(positions);
+    pMesh->DrawBatches.push_back(batch);
+
+    FauxRender::DeformableBatch deformable = {};
+    deformable.BatchIndex                  = 0;
+    deformable.Positions                   = positions;
+    deformable.Targets.push_back({std::vector<vec3>(positions.size(), vec3(0, 1, 0))});
+    pMesh->DeformableBatches.push_back(deformable);
+    pMesh->MorphWeights = {0};
+
+    FauxRender::Scene scene     = {};
+    const float       weights[] = {0, 1};
+    for (float weight : weights)
+    {
+        auto pNode          = graph.AddNode();
+        pNode->Type         = FauxRender::SCENE_NODE_TYPE_GEOMETRY;
+        pNode->pMesh        = pMesh;
+        pNode->MorphWeights = {weight};
+        scene.AddGeometryNode(pNode);
+    }
+    auto pNodeA = &graph.Nodes[0];
+    auto pNodeB = &graph.Nodes[1];
+
+    CHECK(graph.CreateDeformedBuffers());
+    CHECK(!IsNull(pNodeA->pDeformedBuffer) && !IsNull(pNodeB->pDeformedBuffer));
+    CHECK(pNodeA->pDeformedBuffer != pNodeB->pDeformedBuffer);
+    CHECK(pNodeA->GetDrawBuffer() == pNodeA->pDeformedBuffer);
+    CHECK(pNodeA->pDeformedBuffer->Size == pMesh->pBuffer->Size);
+
+    // A second call leaves the existing buffers alone
+    auto pFirstBufferA = pNodeA->pDeformedBuffer;
+    CHECK(graph.CreateDeformedBuffers());
+    CHECK(pNodeA->pDeformedBuffer == pFirstBufferA);
+
+    std::vector<mat4>            worldMatrices;
+    FauxRender::DeformedVertices scratch = {};
+    FauxRender::ComputeWorldMatrices(&graph, &worldMatrices);
+    CHECK(FauxRender::UpdateDeformedMesh(&graph, worldMatrices, pNodeA, &scratch));
+    CHECK(FauxRender::UpdateDeformedMesh(&graph, worldMatrices, pNodeB, &scratch));
+
+    auto readPosition = [&](FauxRender::Buffer* pBuffer, uint32_t i) {
+        vec3 position = {};
+        memcpy(&position, HostFauxRender::Cast(pBuffer)->Data.data() + sizeof(indices) + i * sizeof(vec3), sizeof(vec3));
+        return position;
+    };
+    for (uint32_t i = 0; i < CountU32(positions); ++i)
+    {
+        CHECK(readPosition(pNodeA->pDeformedBuffer, i) == positions[i]);
+        CHECK(readPosition(pNodeB->pDeformedBuffer, i) == positions[i] + vec3(0, 1, 0));
+        CHECK(readPosition(pMesh->pBuffer, i) == positions[i]);
+    }
+
+    // Same mesh, different buffers: one draw per node
+    FauxRender::DrawList drawList = {};
+    CHECK(FauxRender::BuildDrawList(&graph, &scene, &drawList));
+    CHECK(drawList.Draws.size() == 2);
+    if (drawList.Draws.size() == 2)
+    {
+        CHECK(drawList.Draws[0].pBuffer == pNodeA->pDeformedBuffer);
+        CHECK(drawList.Draws[1].pBuffer == pNodeB->pDeformedBuffer);
+        CHECK((drawList.Draws[0].InstanceCount == 1) && (drawList.Draws[1].InstanceCount == 1));
+    }
+
+    // The bind pose bounds don't cover the morphed positions, so both
+    // instances are unbounded. Removing one moves the other into its
+    // position.
+    pMesh->Bounds = {vec3(0, 0, 0), vec3(1, 1, 0)};
+    CHECK(graph.UpdateInstanceBuffer(&scene));
+    CHECK(scene.BVH.UnboundedInstances == std::vector<uint32_t>({0, 1}));
+
+    scene.RemoveGeometryNode(pNodeA);
+    CHECK(scene.BVH.UnboundedInstances == std::vector<uint32_t>({1}));
+    CHECK((scene.BVH.UnboundedPositions[0] == UINT32_MAX) && (scene.BVH.UnboundedPositions[1] == 0));
+    CHECK(scene.BVH.Root == UINT32_MAX);
+}
+
+// =============================================================================
+// Scene files
+// =============================================================================
+struct TestSceneFile
+{
+    FauxRender::SceneFile::FileImage    Image    = {};
+    FauxRender::SceneFile::FileMipLevel MipLevel = {};
+    FauxRender::SceneFile::FileMesh     Mesh     = {};
+    FauxRender::SceneFile::FileBatch    Batch    = {};
+};
+
+// One 4x4 RGBA8 image and one mesh with a single index buffer view
+static TestSceneFile CreateTestSceneFile()
+{
+    using namespace FauxRender::SceneFile;
+
+    TestSceneFile file         = {};
+    file.Image.Format          = GREX_FORMAT_R8G8B8A8_UNORM;
+    file.Image.Width           = 4;
+    file.Image.Height          = 4;
+    file.Image.NumLevels       = 1;
+    file.Image.DataOffset      = FILE_BLOB_ALIGNMENT;
+    file.Image.DataSize        = 4 * 16;
+    file.MipLevel.RowStride    = 16;
+    file.Mesh.NumBatches       = 1;
+    file.Mesh.DataOffset       = 2 * FILE_BLOB_ALIGNMENT;
+    file.Mesh.DataSize         = 12;
+    file.Batch.IndexBufferView = {0, 12, 4, GREX_FORMAT_R32_UINT, 3};
+    return file;
+}
+
+static bool WriteTestSceneFile(const std::filesystem::path& path, const TestSceneFile& file)
+{
+    using namespace FauxRender::SceneFile;
+
+    std::vector<char> data(3 * FILE_BLOB_ALIGNMENT);
+
+    FileHeader header = {};
+    memcpy(header.Magic, FILE_MAGIC, sizeof(FILE_MAGIC));
+    header.Version    = FILE_VERSION;
+    header.HeaderSize = sizeof(FileHeader);
+    header.FileSize   = data.size();
+
+    uint64_t offset   = sizeof(FileHeader);
+    auto     addTable = [&](FileTableType type, const void* pRecord, uint32_t size) {
+        header.Tables[type] = {offset, 1, size};
+        memcpy(data.data() + offset, pRecord, size);
+        offset += size;
+    };
+    addTable(FILE_TABLE_IMAGES, &file.Image, sizeof(file.Image));
+    addTable(FILE_TABLE_MIP_LEVELS, &file.MipLevel, sizeof(file.MipLevel));
+    addTable(FILE_TABLE_MESHES, &file.Mesh, sizeof(file.Mesh));
+    addTable(FILE_TABLE_BATCHES, &file.Batch, sizeof(file.Batch));
+    memcpy(data.data(), &header, sizeof(header));
+
+    std::ofstream os(path, std::ios::binary);
+    os.write(data.data(), data.size());
+    return static_cast<bool>(os);
+}
+
+static void TestSceneFileValidation()
+{
+    std::cout << "scene file validation" << std::endl;
+
+    const auto path = std::filesystem::temp_directory_path() / "faux_render_tests.grexscene";
+
+    auto loads = [&path](const TestSceneFile& file) {
+        HostFauxRender::SceneGraph graph(false);
+        if (!WriteTestSceneFile(path, file))
+        {
+            return false;
+        }
+        bool res = FauxRender::LoadScene(path, &graph);
+        // Nothing is created for files that fail validation
+        CHECK(res || (graph.Images.empty() && graph.Meshes.empty() && graph.Buffers.empty()));
+        return res;
+    };
+
+    CHECK(loads(CreateTestSceneFile()));
+
+    // Mip rows past the end of the image's blob
+    auto file               = CreateTestSceneFile();
+    file.MipLevel.RowStride = 256;
+    CHECK(!loads(file));
+
+    file                 = CreateTestSceneFile();
+    file.MipLevel.Offset = 4;
+    CHECK(!loads(file));
+
+    // Buffer view past the end of the mesh's blob
+    file                            = CreateTestSceneFile();
+    file.Batch.IndexBufferView.Size = 16;
+    CHECK(!loads(file));
+
+    // DataOffset + DataSize wraps around
+    file                  = CreateTestSceneFile();
+    file.Image.DataOffset = UINT64_MAX - 16;
+    CHECK(!loads(file));
+
+    file                 = CreateTestSceneFile();
+    file.Mesh.DataOffset = UINT64_MAX - 4;
+    CHECK(!loads(file));
+
+    std::filesystem::remove(path);
+}
+
+static bool ReportGLTF(const std::filesystem::path& path)
+{
+    HostFauxRender::SceneGraph graph(false);
+    if (!FauxRender::LoadGLTF(path, {}, &graph))
+    {
+        std::cout << "error: failed to load scene\n   path=" << path << std::endl;
+        return false;
+    }
+
+    std::cout << path.filename().string() << std::endl;
+    for (const auto& pScene : graph.Scenes)
+    {
+        FauxRender::DrawList drawList = {};
+        if (!FauxRender::BuildDrawList(&graph, pScene.get(), &drawList))
+        {
+            std::cout << "error: failed to build draw list\n   scene=" << pScene->Name << std::endl;
+            return false;
+        }
+
+        PrintReduction(pScene->Name.empty() ? "<unnamed scene>" : pScene->Name, drawList);
+    }
+
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    TestSlotTable();
+    TestImageTable();
+    TestMaterialBuffer();
+    TestDrawList();
+    TestTextureStreamer();
+    TestDeformedBuffers();
+    TestSceneFileValidation();
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::cout << std::endl;
+        if (!ReportGLTF(argv[i]))
+        {
+            return EXIT_FAILURE;
+        }
+    }
+
+    std::cout << std::endl;
+    std::cout << (gNumChecks - gNumFailures) << " of " << gNumChecks << " checks passed" << std::endl;
+
+    return (gNumFailures == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
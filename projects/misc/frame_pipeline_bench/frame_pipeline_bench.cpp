@@ -0,0 +1,452 @@
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+
+#include "vk_renderer.h"
+
+//
+// Runs the same headless frame loop with a growing number of frames in
+// flight and reports the average frame time:
+//
+//   serial - 1 frame, waits for the GPU after every submit like the
+//            sample loops used to
+//   N      - VulkanFrameContext with N frames in flight, the CPU work of
+//            frame N+1 overlaps the GPU work of frame N
+//
+// Every frame spins the CPU for a while, standing in for a sample's scene
+// update and command recording. It then takes its constants and a copy of
+// the descriptor set from the frame context's rings and dispatches a
+// compute shader that reads them. Each frame writes one result that's
+// checked afterwards, so a ring allocation that's reused while the GPU is
+// still reading it shows up as a mismatch.
+//
+// usage: frame_pipeline_bench [num frames] [cpu ms per frame] [gpu iterations]
+//
+// Needs no window or display, so it runs on Mesa's lavapipe:
+//   VK_ICD_FILENAMES=/usr/share/vulkan/icd.d/lvp_icd.x86_64.json frame_pipeline_bench
+//
+
+const char* gShaderCS = R"(
+#version 460
+
+layout(local_size_x = 64) in;
+
+layout(set = 0, binding = 0) uniform FrameParams
+{
+    uint FrameNumber;
+    uint Iterations;
+} Params;
+
+layout(set = 0, binding = 1) buffer ScratchBuffer
+{
+    uint Values[];
+} Scratch;
+
+layout(set = 0, binding = 2) buffer ResultsBuffer
+{
+    uint Values[];
+} Results;
+
+void main()
+{
+    uint value = Params.FrameNumber * 747796405u + gl_GlobalInvocationID.x;
+    for (uint i = 0; i < Params.Iterations; ++i) {
+        value = value * 1664525u + 1013904223u;
+        value ^= value >> 16;
+    }
+
+    Scratch.Values[gl_GlobalInvocationID.x] = value;
+
+    if (gl_GlobalInvocationID.x == 0) {
+        Results.Values[Params.FrameNumber] = value;
+    }
+}
+)";
+
+struct FrameParams
+{
+    uint32_t FrameNumber;
+    uint32_t Iterations;
+};
+
+struct BenchResources
+{
+    VulkanPipelineLayout PipelineLayout = {};
+    VkPipeline           Pipeline       = VK_NULL_HANDLE;
+    VulkanBuffer         ScratchBuffer  = {};
+    VulkanBuffer         ResultsBuffer  = {};
+    std::vector<char>    DescriptorTemplate;
+};
+
+struct RunStats
+{
+    double TotalMs     = 0;
+    double FenceWaitMs = 0;
+};
+
+static const uint32_t kNumThreads = 64 * 256;
+
+static uint32_t ExpectedResult(uint32_t frameNumber, uint32_t iterations)
+{
+    uint32_t value = frameNumber * 747796405u;
+    for (uint32_t i = 0; i < iterations; ++i) {
+        value = value * 1664525u + 1013904223u;
+        value ^= value >> 16;
+    }
+    return value;
+}
+
+static void SpinFor(double milliseconds)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+    while (std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count() < milliseconds) {
+    }
+}
+
+static bool CreateResources(VulkanRenderer* pRenderer, uint32_t numFrames, BenchResources* pResources)
+{
+    std::vector<uint32_t> spirv;
+    std::string           errorMsg;
+    CompileResult         res = CompileGLSL(gShaderCS, VK_SHADER_STAGE_COMPUTE_BIT, {}, &spirv, &errorMsg);
+    if (res != COMPILE_SUCCESS) {
+        std::cout << "error: shader compiler error (CS): " << errorMsg << std::endl;
+        return false;
+    }
+
+    // Descriptor set layout
+    {
+        std::vector<VkDescriptorSetLayoutBinding> bindings = {
+            {0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT},
+            {1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT},
+            {2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT},
+        };
+
+        VkDescriptorSetLayoutCreateInfo createInfo = {VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO};
+        createInfo.flags                           = VK_DESCRIPTOR_SET_LAYOUT_CREATE_DESCRIPTOR_BUFFER_BIT_EXT;
+        createInfo.bindingCount                    = CountU32(bindings);
+        createInfo.pBindings                       = DataPtr(bindings);
+
+        if (vkCreateDescriptorSetLayout(pRenderer->Device, &createInfo, nullptr, &pResources->PipelineLayout.DescriptorSetLayout) != VK_SUCCESS) {
+            std::cout << "error: vkCreateDescriptorSetLayout failed" << std::endl;
+            return false;
+        }
+    }
+
+    // Pipeline layout
+    {
+        VkPipelineLayoutCreateInfo createInfo = {VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO};
+        createInfo.setLayoutCount             = 1;
+        createInfo.pSetLayouts                = &pResources->PipelineLayout.DescriptorSetLayout;
+
+        if (vkCreatePipelineLayout(pRenderer->Device, &createInfo, nullptr, &pResources->PipelineLayout.PipelineLayout) != VK_SUCCESS) {
+            std::cout << "error: vkCreatePipelineLayout failed" << std::endl;
+            return false;
+        }
+    }
+
+    // Pipeline
+    {
+        VkShaderModuleCreateInfo moduleCreateInfo = {VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO};
+        moduleCreateInfo.codeSize                 = SizeInBytes(spirv);
+        moduleCreateInfo.pCode                    = DataPtr(spirv);
+
+        VkShaderModule shaderModule = VK_NULL_HANDLE;
+        if (vkCreateShaderModule(pRenderer->Device, &moduleCreateInfo, nullptr, &shaderModule) != VK_SUCCESS) {
+            std::cout << "error: vkCreateShaderModule failed" << std::endl;
+            return false;
+        }
+
+        VkComputePipelineCreateInfo createInfo = {VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO};
+        createInfo.flags                       = VK_PIPELINE_CREATE_DESCRIPTOR_BUFFER_BIT_EXT;
+        createInfo.stage                       = {VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO};
+        createInfo.stage.stage                 = VK_SHADER_STAGE_COMPUTE_BIT;
+        createInfo.stage.module                = shaderModule;
+        createInfo.stage.pName                 = "main";
+        createInfo.layout                      = pResources->PipelineLayout.PipelineLayout;
+
+        VkResult vkres = vkCreateComputePipelines(pRenderer->Device, VK_NULL_HANDLE, 1, &createInfo, nullptr, &pResources->Pipeline);
+        vkDestroyShaderModule(pRenderer->Device, shaderModule, nullptr);
+        if (vkres != VK_SUCCESS) {
+            std::cout << "error: vkCreateComputePipelines failed" << std::endl;
+            return false;
+        }
+    }
+
+    // Buffers
+    {
+        VkResult vkres = CreateBuffer(
+            pRenderer,
+            kNumThreads * sizeof(uint32_t),
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+            VMA_MEMORY_USAGE_GPU_ONLY,
+            0,
+            &pResources->ScratchBuffer);
+        if (vkres != VK_SUCCESS) {
+            std::cout << "error: CreateBuffer failed" << std::endl;
+            return false;
+        }
+
+        vkres = CreateBuffer(
+            pRenderer,
+            numFrames * sizeof(uint32_t),
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+            VMA_MEMORY_USAGE_GPU_TO_CPU,
+            0,
+            &pResources->ResultsBuffer);
+        if (vkres != VK_SUCCESS) {
+            std::cout << "error: CreateBuffer failed" << std::endl;
+            return false;
+        }
+    }
+
+    // Descriptor template, the frame params (binding 0) are written per frame
+    {
+        VkDeviceSize size = 0;
+        fn_vkGetDescriptorSetLayoutSizeEXT(pRenderer->Device, pResources->PipelineLayout.DescriptorSetLayout, &size);
+
+        pResources->DescriptorTemplate.resize(static_cast<size_t>(size));
+
+        WriteDescriptor(
+            pRenderer,
+            DataPtr(pResources->DescriptorTemplate),
+            pResources->PipelineLayout.DescriptorSetLayout,
+            1, // binding
+            0, // arrayElement
+            VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            &pResources->ScratchBuffer);
+
+        WriteDescriptor(
+            pRenderer,
+            DataPtr(pResources->DescriptorTemplate),
+            pResources->PipelineLayout.DescriptorSetLayout,
+            2, // binding
+            0, // arrayElement
+            VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            &pResources->ResultsBuffer);
+    }
+
+    return true;
+}
+
+static void DestroyResources(VulkanRenderer* pRenderer, BenchResources* pResources)
+{
+    DestroyBuffer(pRenderer, &pResources->ScratchBuffer);
+    DestroyBuffer(pRenderer, &pResources->ResultsBuffer);
+    vkDestroyPipeline(pRenderer->Device, pResources->Pipeline, nullptr);
+    vkDestroyPipelineLayout(pRenderer->Device, pResources->PipelineLayout.PipelineLayout, nullptr);
+    vkDestroyDescriptorSetLayout(pRenderer->Device, pResources->PipelineLayout.DescriptorSetLayout, nullptr);
+}
+
+static bool RecordFrame(VulkanRenderer* pRenderer, VulkanFrameContext* pFrameCtx, VulkanFrame* pFrame, const BenchResources& resources, uint32_t iterations)
+{
+    VulkanRingAllocation paramsAlloc = {};
+    if (!AllocateFrameConstants(pFrameCtx, sizeof(FrameParams), &paramsAlloc)) {
+        std::cout << "error: AllocateFrameConstants failed" << std::endl;
+        return false;
+    }
+
+    FrameParams* pParams = static_cast<FrameParams*>(paramsAlloc.pData);
+    pParams->FrameNumber = static_cast<uint32_t>(pFrame->FrameNumber);
+    pParams->Iterations  = iterations;
+
+    VulkanRingAllocation descriptorAlloc = {};
+    if (!AllocateFrameDescriptors(pFrameCtx, resources.DescriptorTemplate.size(), &descriptorAlloc)) {
+        std::cout << "error: AllocateFrameDescriptors failed" << std::endl;
+        return false;
+    }
+
+    memcpy(descriptorAlloc.pData, DataPtr(resources.DescriptorTemplate), resources.DescriptorTemplate.size());
+
+    WriteDescriptor(
+        pRenderer,
+        descriptorAlloc.pData,
+        resources.PipelineLayout.DescriptorSetLayout,
+        0, // binding
+        0, // arrayElement
+        VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+        paramsAlloc.Address,
+        paramsAlloc.Size);
+
+    VkCommandBuffer commandBuffer = pFrame->CmdBuf.CommandBuffer;
+
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, resources.Pipeline);
+
+    VkDescriptorBufferBindingInfoEXT descriptorBufferBindingInfo = {VK_STRUCTURE_TYPE_DESCRIPTOR_BUFFER_BINDING_INFO_EXT};
+    descriptorBufferBindingInfo.address                          = pFrameCtx->DescriptorRing.BaseAddress;
+    descriptorBufferBindingInfo.usage                            = VK_BUFFER_USAGE_RESOURCE_DESCRIPTOR_BUFFER_BIT_EXT;
+    fn_vkCmdBindDescriptorBuffersEXT(commandBuffer, 1, &descriptorBufferBindingInfo);
+
+    uint32_t     bufferIndices           = 0;
+    VkDeviceSize descriptorBufferOffsets = descriptorAlloc.Offset;
+    fn_vkCmdSetDescriptorBufferOffsetsEXT(
+        commandBuffer,
+        VK_PIPELINE_BIND_POINT_COMPUTE,
+        resources.PipelineLayout.PipelineLayout,
+        0, // firstSet
+        1, // setCount
+        &bufferIndices,
+        &descriptorBufferOffsets);
+
+    vkCmdDispatch(commandBuffer, kNumThreads / 64, 1, 1);
+
+    // Results are read on the host once all frames are done
+    VkMemoryBarrier2 barrier = {VK_STRUCTURE_TYPE_MEMORY_BARRIER_2};
+    barrier.srcStageMask     = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+    barrier.srcAccessMask    = VK_ACCESS_2_SHADER_WRITE_BIT;
+    barrier.dstStageMask     = VK_PIPELINE_STAGE_2_HOST_BIT;
+    barrier.dstAccessMask    = VK_ACCESS_2_HOST_READ_BIT;
+
+    VkDependencyInfo dependencyInfo   = {VK_STRUCTURE_TYPE_DEPENDENCY_INFO};
+    dependencyInfo.memoryBarrierCount = 1;
+    dependencyInfo.pMemoryBarriers    = &barrier;
+
+    vkCmdPipelineBarrier2(commandBuffer, &dependencyInfo);
+
+    return true;
+}
+
+// numFramesInFlight == 0 runs the serial loop
+static bool RunFrames(
+    VulkanRenderer*       pRenderer,
+    const BenchResources& resources,
+    uint32_t              numFramesInFlight,
+    uint32_t              numFrames,
+    double                cpuMsPerFrame,
+    uint32_t              iterations,
+    RunStats*             pStats)
+{
+    const bool serial = (numFramesInFlight == 0);
+
+    const VkDeviceSize paramsSize      = Align<VkDeviceSize>(sizeof(FrameParams), 256);
+    const VkDeviceSize descriptorsSize = Align<VkDeviceSize>(resources.DescriptorTemplate.size(), 256);
+    const uint32_t     numSlots        = serial ? 1 : numFramesInFlight;
+
+    VulkanFrameContext frameCtx = {};
+    VkResult           vkres    = CreateFrameContext(pRenderer, numSlots, numSlots * paramsSize, numSlots * descriptorsSize, &frameCtx);
+    if (vkres != VK_SUCCESS) {
+        std::cout << "error: CreateFrameContext failed" << std::endl;
+        return false;
+    }
+
+    // Clear last run's results
+    {
+        void* pData = nullptr;
+        vmaMapMemory(pRenderer->Allocator, resources.ResultsBuffer.Allocation, &pData);
+        memset(pData, 0, static_cast<size_t>(resources.ResultsBuffer.Size));
+        vmaUnmapMemory(pRenderer->Allocator, resources.ResultsBuffer.Allocation);
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    bool good = true;
+    for (uint32_t i = 0; (i < numFrames) && good; ++i) {
+        VulkanFrame* pFrame = nullptr;
+        if (BeginFrame(&frameCtx, &pFrame) != VK_SUCCESS) {
+            good = false;
+            break;
+        }
+
+        SpinFor(cpuMsPerFrame);
+
+        good = RecordFrame(pRenderer, &frameCtx, pFrame, resources, iterations);
+
+        if (EndFrame(&frameCtx, UINT32_MAX) != VK_SUCCESS) {
+            good = false;
+        }
+
+        if (serial && !WaitForGpu(pRenderer)) {
+            good = false;
+        }
+    }
+
+    WaitFrameContext(&frameCtx);
+
+    auto end = std::chrono::high_resolution_clock::now();
+
+    pStats->TotalMs     = std::chrono::duration<double, std::milli>(end - start).count();
+    pStats->FenceWaitMs = frameCtx.FenceWaitTime;
+
+    DestroyFrameContext(&frameCtx);
+
+    if (!good) {
+        std::cout << "error: frame loop failed" << std::endl;
+        return false;
+    }
+
+    // Check every frame's result
+    uint32_t* pResults = nullptr;
+    vmaMapMemory(pRenderer->Allocator, resources.ResultsBuffer.Allocation, reinterpret_cast<void**>(&pResults));
+
+    uint32_t numMismatches = 0;
+    for (uint32_t i = 0; i < numFrames; ++i) {
+        if (pResults[i] != ExpectedResult(i, iterations)) {
+            ++numMismatches;
+        }
+    }
+
+    vmaUnmapMemory(pRenderer->Allocator, resources.ResultsBuffer.Allocation);
+
+    if (numMismatches > 0) {
+        std::cout << "error: " << numMismatches << " frames produced the wrong result" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t numFrames     = 200;
+    double   cpuMsPerFrame = 4.0;
+    uint32_t iterations    = 1000;
+    if (argc > 1) {
+        numFrames = static_cast<uint32_t>(std::max(atoi(argv[1]), 1));
+    }
+    if (argc > 2) {
+        cpuMsPerFrame = std::max(atof(argv[2]), 0.0);
+    }
+    if (argc > 3) {
+        iterations = static_cast<uint32_t>(std::max(atoi(argv[3]), 0));
+    }
+
+    std::unique_ptr<VulkanRenderer> renderer = std::make_unique<VulkanRenderer>();
+    if (!InitVulkan(renderer.get(), false, {})) {
+        std::cout << "error: InitVulkan failed" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    BenchResources resources = {};
+    if (!CreateResources(renderer.get(), numFrames, &resources)) {
+        return EXIT_FAILURE;
+    }
+
+    std::cout << numFrames << " frames, " << cpuMsPerFrame << " ms CPU work, " << iterations << " GPU iterations per frame" << std::endl;
+
+    double serialMs = 0;
+    for (uint32_t numFramesInFlight : {0u, 2u, 3u}) {
+        RunStats stats = {};
+        if (!RunFrames(renderer.get(), resources, numFramesInFlight, numFrames, cpuMsPerFrame, iterations, &stats)) {
+            DestroyResources(renderer.get(), &resources);
+            return EXIT_FAILURE;
+        }
+
+        const double frameMs = stats.TotalMs / numFrames;
+        if (numFramesInFlight == 0) {
+            serialMs = frameMs;
+            std::cout << "  serial          ";
+        }
+        else {
+            std::cout << "  " << numFramesInFlight << " in flight     ";
+        }
+
+        std::cout << std::fixed << std::setprecision(2) << std::setw(8) << frameMs << " ms/frame"
+                  << ", fence wait " << std::setw(8) << (stats.FenceWaitMs / numFrames) << " ms/frame"
+                  << ", " << std::setprecision(2) << (serialMs / std::max(frameMs, 0.001)) << "x" << std::endl;
+    }
+
+    std::cout << "  results matched for every frame" << std::endl;
+
+    DestroyResources(renderer.get(), &resources);
+
+    return EXIT_SUCCESS;
+}
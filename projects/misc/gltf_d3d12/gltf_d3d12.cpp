@@ -133,8 +133,11 @@ int main(int argc, char** argv)
     // *************************************************************************
     // Scene
     // *************************************************************************
+    // usage: gltf_d3d12 [scene.gltf]
+    std::filesystem::path scenePath = (argc > 1) ? std::filesystem::path(argv[1]) : GetAssetPath("scenes/material_test_001_ktx2/material_test_001.gltf");
+
     DxFauxRender::SceneGraph graph = DxFauxRender::SceneGraph(renderer.get());
-    if (!FauxRender::LoadGLTF(GetAssetPath("scenes/material_test_001_ktx2/material_test_001.gltf"), {}, &graph))
+    if (!FauxRender::LoadGLTF(scenePath, {}, &graph))
     {
         assert(false && "LoadGLTF failed");
         return EXIT_FAILURE;
@@ -257,7 +260,7 @@ int main(int argc, char** argv)
         {
             for (size_t i = 0; i < graph.Images.size(); ++i)
             {
-                auto image    = DxFauxRender::Cast(graph.Images[i].get());
+                auto image    = DxFauxRender::Cast(graph.GetDescriptorImage(static_cast<uint32_t>(i)));
                 auto resource = image->Resource;
 
                 auto descriptorHandle = D3D12_CPU_DESCRIPTOR_HANDLE{cbvsrvuavHeapStart.ptr + ((gMaterialTextureOffset + i) * cbvsrvuavInc)};
@@ -363,8 +366,40 @@ int main(int argc, char** argv)
     // *************************************************************************
     // Main loop
     // *************************************************************************
+    std::vector<mat4>            worldMatrices;
+    FauxRender::DeformedVertices deformScratch = {};
+    const double                 startTime     = glfwGetTime();
+
     while (window->PollEvents())
     {
+        // Play the first animation in a loop. Skinned and morphed nodes
+        // are written to their own deformed buffers, which is safe here
+        // since every frame waits for the GPU.
+        if (!graph.Animations.empty())
+        {
+            const auto& animation = *graph.Animations[0];
+            const auto& scene     = graph.Scenes[0];
+            const float time      = (animation.Duration > 0) ? static_cast<float>(fmod(glfwGetTime() - startTime, animation.Duration)) : 0.0f;
+
+            FauxRender::ApplyAnimation(animation, time, &graph, scene.get());
+            FauxRender::ComputeWorldMatrices(&graph, &worldMatrices);
+            for (auto pGeometryNode : scene->GeometryNodes)
+            {
+                if (IsNull(pGeometryNode) || IsNull(pGeometryNode->pDeformedBuffer))
+                {
+                    continue;
+                }
+
+                if (!FauxRender::UpdateDeformedMesh(&graph, worldMatrices, pGeometryNode, &deformScratch))
+                {
+                    assert(false && "UpdateDeformedMesh failed");
+                    break;
+                }
+            }
+            graph.UpdateInstanceBuffer(scene.get());
+            graph.ReleaseRetiredBuffers();
+        }
+
         UINT bufferIndex = renderer->Swapchain->GetCurrentBackBufferIndex();
 
         ComPtr<ID3D12Resource> swapchainBuffer;
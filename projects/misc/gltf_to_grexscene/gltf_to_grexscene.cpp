@@ -0,0 +1,577 @@
+//
+// gltf_to_grexscene
+// - Converts a glTF file into a .grexscene file that FauxRender::LoadScene() can load without parsing
+// - Geometry is stored exactly as FauxRender lays it out in GPU buffers
+// - PNG/JPG images get a full mip chain, color images are compressed to BC3, normal and
+//   metallic-roughness/occlusion maps stay RGBA8. KTX2 images are stored as transcoded
+//
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <unordered_map>
+#include <vector>
+
+#include "host_faux_render.h"
+#include "faux_render_scene_file.h"
+#include "bitmap.h"
+
+#define STB_DXT_IMPLEMENTATION
+#include "stb_dxt.h"
+
+using namespace FauxRender::SceneFile;
+
+// =============================================================================
+// Image processing
+// =============================================================================
+static void AppendPadding(std::vector<char>& data, uint32_t alignment)
+{
+    data.resize(Align<size_t>(data.size(), alignment), 0);
+}
+
+//
+// Normal, metallic-roughness and occlusion maps are data rather than color:
+// BC3's color endpoints are shared by the RGB channels, which visibly bends
+// normals and bleeds roughness into metalness. The shaders read normals
+// from RGB, so BC5 isn't an option either without reconstructing Z there.
+//
+enum ImageUsage
+{
+    IMAGE_USAGE_COLOR = 0,
+    IMAGE_USAGE_DATA  = 1,
+};
+
+static bool IsDataTexture(const FauxRender::Material& material, const FauxRender::Image* pImage)
+{
+    auto UsesImage = [pImage](const FauxRender::Texture* pTexture) -> bool {
+        return !IsNull(pTexture) && (pTexture->pImage == pImage);
+    };
+
+    return UsesImage(material.pNormalTexture) || UsesImage(material.pMetallicRoughnessTexture) || UsesImage(material.pOcclusionTexture);
+}
+
+static ImageUsage GetImageUsage(const HostFauxRender::SceneGraph* pGraph, const FauxRender::Image* pImage)
+{
+    for (const auto& material : pGraph->Materials)
+    {
+        if (IsDataTexture(material, pImage))
+        {
+            return IMAGE_USAGE_DATA;
+        }
+    }
+    return IMAGE_USAGE_COLOR;
+}
+
+// Bytes per 4x4 block for the BC formats, bytes per pixel otherwise
+static uint32_t GetElementSize(GREXFormat format)
+{
+    // clang-format off
+    switch (format) {
+        default: return 4;
+        case GREX_FORMAT_BC1_RGB     : return 8;
+        case GREX_FORMAT_BC4_R       : return 8;
+        case GREX_FORMAT_BC3_RGBA    : return 16;
+        case GREX_FORMAT_BC5_RG      : return 16;
+        case GREX_FORMAT_BC6H_SFLOAT : return 16;
+        case GREX_FORMAT_BC6H_UFLOAT : return 16;
+        case GREX_FORMAT_BC7_RGBA    : return 16;
+    }
+    // clang-format on
+}
+
+// Rows are padded to FILE_ROW_PITCH_ALIGNMENT and the padded stride is recorded
+static MipOffset AppendMipLevel(HostFauxRender::Image* pImage, uint32_t rowSize, uint32_t numRows)
+{
+    AppendPadding(pImage->Data, FILE_BLOB_ALIGNMENT);
+
+    const uint32_t rowStride = (rowSize + FILE_ROW_PITCH_ALIGNMENT - 1) & ~(FILE_ROW_PITCH_ALIGNMENT - 1);
+
+    MipOffset mipOffset = {};
+    mipOffset.Offset    = static_cast<uint32_t>(pImage->Data.size());
+    mipOffset.RowStride = rowStride;
+    pImage->MipOffsets.push_back(mipOffset);
+
+    pImage->Data.resize(pImage->Data.size() + size_t(rowStride) * numRows);
+    return mipOffset;
+}
+
+// Blocks that hang over the level's edge repeat the last row and column
+static void CompressMipLevel(const BitmapRGBA8u& mip, HostFauxRender::Image* pImage)
+{
+    const uint32_t blockSize  = GetElementSize(GREX_FORMAT_BC3_RGBA);
+    const uint32_t numBlocksX = (mip.GetWidth() + 3) / 4;
+    const uint32_t numBlocksY = (mip.GetHeight() + 3) / 4;
+
+    MipOffset mipOffset = AppendMipLevel(pImage, numBlocksX * blockSize, numBlocksY);
+
+    for (uint32_t by = 0; by < numBlocksY; ++by)
+    {
+        unsigned char* pDst = reinterpret_cast<unsigned char*>(pImage->Data.data() + mipOffset.Offset + size_t(by) * mipOffset.RowStride);
+        for (uint32_t bx = 0; bx < numBlocksX; ++bx)
+        {
+            unsigned char block[16 * 4] = {};
+            for (uint32_t y = 0; y < 4; ++y)
+            {
+                for (uint32_t x = 0; x < 4; ++x)
+                {
+                    const uint32_t srcX = std::min(bx * 4 + x, mip.GetWidth() - 1);
+                    const uint32_t srcY = std::min(by * 4 + y, mip.GetHeight() - 1);
+                    memcpy(&block[(y * 4 + x) * 4], mip.GetPixels(srcX, srcY), 4);
+                }
+            }
+
+            stb_compress_dxt_block(pDst, block, 1, STB_DXT_HIGHQUAL);
+            pDst += blockSize;
+        }
+    }
+}
+
+static void CopyMipLevel(const BitmapRGBA8u& mip, HostFauxRender::Image* pImage)
+{
+    const uint32_t rowSize   = mip.GetWidth() * mip.GetPixelStride();
+    MipOffset      mipOffset = AppendMipLevel(pImage, rowSize, mip.GetHeight());
+
+    for (uint32_t y = 0; y < mip.GetHeight(); ++y)
+    {
+        memcpy(pImage->Data.data() + mipOffset.Offset + size_t(y) * mipOffset.RowStride, mip.GetPixels(0, y), rowSize);
+    }
+}
+
+//
+// Builds the full mip chain for images loaded from PNG/JPG. Color images
+// are compressed to BC3 if the base level is a multiple of 4, the smaller
+// levels are padded to whole blocks. Data images and color images with
+// other sizes stay RGBA8. Each level starts on a FILE_BLOB_ALIGNMENT
+// boundary and each row on a FILE_ROW_PITCH_ALIGNMENT boundary, so D3D12
+// can copy the levels straight out of the blob.
+//
+static void ProcessImage(HostFauxRender::Image* pImage, ImageUsage usage)
+{
+    if ((pImage->Format != GREX_FORMAT_R8G8B8A8_UNORM) || (pImage->NumLevels != 1))
+    {
+        return;
+    }
+
+    const BitmapRGBA8u bitmap(pImage->Width, pImage->Height, pImage->MipOffsets[0].RowStride, pImage->Data.data());
+
+    const bool compress = (usage == IMAGE_USAGE_COLOR) && ((bitmap.GetWidth() % 4) == 0) && ((bitmap.GetHeight() % 4) == 0);
+
+    MipmapT<BitmapRGBA8u> mipmap(bitmap, BITMAP_SAMPLE_MODE_WRAP, BITMAP_SAMPLE_MODE_WRAP, BITMAP_FILTER_MODE_LINEAR);
+
+    pImage->Data.clear();
+    pImage->MipOffsets.clear();
+    for (uint32_t level = 0; level < mipmap.GetNumLevels(); ++level)
+    {
+        if (compress)
+        {
+            CompressMipLevel(mipmap.GetMip(level), pImage);
+        }
+        else
+        {
+            CopyMipLevel(mipmap.GetMip(level), pImage);
+        }
+    }
+
+    pImage->Format    = compress ? GREX_FORMAT_BC3_RGBA : GREX_FORMAT_R8G8B8A8_UNORM;
+    pImage->NumLevels = CountU32(pImage->MipOffsets);
+}
+
+// =============================================================================
+// Writer
+// =============================================================================
+class SceneFileWriter
+{
+public:
+    FileString AddString(const std::string& str)
+    {
+        FileString fileString = {};
+        fileString.Offset     = CountU32(mStrings);
+        fileString.Length     = static_cast<uint32_t>(str.size());
+        mStrings.insert(mStrings.end(), str.begin(), str.end());
+        return fileString;
+    }
+
+    // Returns the blob's offset relative to the start of blob data
+    uint64_t AddBlob(const void* pData, size_t size)
+    {
+        AppendPadding(mBlobs, FILE_BLOB_ALIGNMENT);
+        uint64_t offset = mBlobs.size();
+        mBlobs.insert(mBlobs.end(), static_cast<const char*>(pData), static_cast<const char*>(pData) + size);
+        return offset;
+    }
+
+    bool Write(
+        const std::filesystem::path&     path,
+        std::vector<FileNode>&           nodes,
+        const std::vector<uint32_t>&     nodeChildren,
+        const std::vector<FileScene>&    scenes,
+        const std::vector<uint32_t>&     sceneNodes,
+        std::vector<FileMesh>&           meshes,
+        const std::vector<FileBatch>&    batches,
+        const std::vector<FileMaterial>& materials,
+        const std::vector<FileTexture>&  textures,
+        std::vector<FileImage>&          images,
+        const std::vector<FileMipLevel>& mipLevels,
+        const std::vector<FileSampler>&  samplers)
+    {
+        FileHeader header = {};
+        memcpy(header.Magic, FILE_MAGIC, sizeof(FILE_MAGIC));
+        header.Version    = FILE_VERSION;
+        header.HeaderSize = sizeof(FileHeader);
+
+        // Table layout
+        uint64_t offset = sizeof(FileHeader);
+
+        auto SetTable = [&header, &offset](FileTableType type, size_t count, size_t stride) {
+            offset                     = Align<uint64_t>(offset, 16);
+            header.Tables[type].Offset = offset;
+            header.Tables[type].Count  = static_cast<uint32_t>(count);
+            header.Tables[type].Stride = static_cast<uint32_t>(stride);
+            offset += count * stride;
+        };
+
+        SetTable(FILE_TABLE_STRINGS, mStrings.size(), sizeof(char));
+        SetTable(FILE_TABLE_NODES, nodes.size(), sizeof(FileNode));
+        SetTable(FILE_TABLE_NODE_CHILDREN, nodeChildren.size(), sizeof(uint32_t));
+        SetTable(FILE_TABLE_SCENES, scenes.size(), sizeof(FileScene));
+        SetTable(FILE_TABLE_SCENE_NODES, sceneNodes.size(), sizeof(uint32_t));
+        SetTable(FILE_TABLE_MESHES, meshes.size(), sizeof(FileMesh));
+        SetTable(FILE_TABLE_BATCHES, batches.size(), sizeof(FileBatch));
+        SetTable(FILE_TABLE_MATERIALS, materials.size(), sizeof(FileMaterial));
+        SetTable(FILE_TABLE_TEXTURES, textures.size(), sizeof(FileTexture));
+        SetTable(FILE_TABLE_IMAGES, images.size(), sizeof(FileImage));
+        SetTable(FILE_TABLE_MIP_LEVELS, mipLevels.size(), sizeof(FileMipLevel));
+        SetTable(FILE_TABLE_SAMPLERS, samplers.size(), sizeof(FileSampler));
+
+        // Blob offsets become file offsets
+        const uint64_t blobBase = Align<uint64_t>(offset, FILE_BLOB_ALIGNMENT);
+        for (auto& mesh : meshes)
+        {
+            mesh.DataOffset += blobBase;
+        }
+        for (auto& image : images)
+        {
+            image.DataOffset += blobBase;
+        }
+        header.FileSize = blobBase + mBlobs.size();
+
+        // Assemble file contents
+        std::vector<char> fileData(static_cast<size_t>(header.FileSize), 0);
+
+        auto CopyTable = [&fileData, &header](FileTableType type, const void* pData) {
+            const auto& table = header.Tables[type];
+            if (table.Count > 0)
+            {
+                memcpy(fileData.data() + table.Offset, pData, size_t(table.Count) * table.Stride);
+            }
+        };
+
+        memcpy(fileData.data(), &header, sizeof(header));
+        CopyTable(FILE_TABLE_STRINGS, DataPtr(mStrings));
+        CopyTable(FILE_TABLE_NODES, DataPtr(nodes));
+        CopyTable(FILE_TABLE_NODE_CHILDREN, DataPtr(nodeChildren));
+        CopyTable(FILE_TABLE_SCENES, DataPtr(scenes));
+        CopyTable(FILE_TABLE_SCENE_NODES, DataPtr(sceneNodes));
+        CopyTable(FILE_TABLE_MESHES, DataPtr(meshes));
+        CopyTable(FILE_TABLE_BATCHES, DataPtr(batches));
+        CopyTable(FILE_TABLE_MATERIALS, DataPtr(materials));
+        CopyTable(FILE_TABLE_TEXTURES, DataPtr(textures));
+        CopyTable(FILE_TABLE_IMAGES, DataPtr(images));
+        CopyTable(FILE_TABLE_MIP_LEVELS, DataPtr(mipLevels));
+        CopyTable(FILE_TABLE_SAMPLERS, DataPtr(samplers));
+        if (!mBlobs.empty())
+        {
+            memcpy(fileData.data() + blobBase, mBlobs.data(), mBlobs.size());
+        }
+
+        std::ofstream os(path, std::ios::binary);
+        if (!os.is_open())
+        {
+            return false;
+        }
+        os.write(fileData.data(), fileData.size());
+        return static_cast<bool>(os);
+    }
+
+private:
+    std::vector<char> mStrings;
+    std::vector<char> mBlobs;
+};
+
+static FileBufferView ToFileBufferView(const FauxRender::BufferView& view)
+{
+    FileBufferView fileView = {};
+    fileView.Offset         = view.Offset;
+    fileView.Size           = view.Size;
+    fileView.Stride         = view.Stride;
+    fileView.Format         = static_cast<uint32_t>(view.Format);
+    fileView.Count          = view.Count;
+    return fileView;
+}
+
+static size_t GetBufferViewEnd(const FauxRender::BufferView& view)
+{
+    return static_cast<size_t>(view.Offset) + view.Size;
+}
+
+static void CopyBounds(const FauxRender::AABB& bounds, float min[3], float max[3])
+{
+    for (int i = 0; i < 3; ++i)
+    {
+        min[i] = bounds.Min[i];
+        max[i] = bounds.Max[i];
+    }
+}
+
+template <typename T>
+static uint32_t FindIndex(const std::unordered_map<const T*, uint32_t>& indexMap, const T* pObject)
+{
+    auto it = indexMap.find(pObject);
+    return (it != indexMap.end()) ? (*it).second : UINT32_MAX;
+}
+
+static bool WriteSceneFile(const std::filesystem::path& path, HostFauxRender::SceneGraph* pGraph)
+{
+    SceneFileWriter writer;
+
+    // Samplers
+    std::vector<FileSampler> samplers;
+    for (auto& sampler : pGraph->Samplers)
+    {
+        FileSampler fileSampler = {};
+        fileSampler.Name        = writer.AddString(sampler->Name);
+        fileSampler.MinFilter   = static_cast<uint32_t>(sampler->MinFilter);
+        fileSampler.MagFilter   = static_cast<uint32_t>(sampler->MagFilter);
+        fileSampler.MipFilter   = static_cast<uint32_t>(sampler->MipFilter);
+        fileSampler.AddressU    = static_cast<uint32_t>(sampler->AddressU);
+        fileSampler.AddressV    = static_cast<uint32_t>(sampler->AddressV);
+        fileSampler.AddressW    = static_cast<uint32_t>(sampler->AddressW);
+        samplers.push_back(fileSampler);
+    }
+
+    // Images
+    std::vector<FileImage>    images;
+    std::vector<FileMipLevel> mipLevels;
+    for (auto& image : pGraph->Images)
+    {
+        auto pImage = HostFauxRender::Cast(image.get());
+
+        const ImageUsage usage = GetImageUsage(pGraph, pImage);
+        ProcessImage(pImage, usage);
+
+        std::cout << "  Image " << pImage->Name << ": " << pImage->Width << "x" << pImage->Height << ", " << pImage->NumLevels << " levels, "
+                  << ((pImage->Format == GREX_FORMAT_BC3_RGBA) ? "BC3" : "RGBA8") << ((usage == IMAGE_USAGE_DATA) ? " (data)" : "") << std::endl;
+
+        FileImage fileImage  = {};
+        fileImage.Name       = writer.AddString(pImage->Name);
+        fileImage.Width      = pImage->Width;
+        fileImage.Height     = pImage->Height;
+        fileImage.Format     = static_cast<uint32_t>(pImage->Format);
+        fileImage.FirstLevel = CountU32(mipLevels);
+        fileImage.NumLevels  = CountU32(pImage->MipOffsets);
+        fileImage.DataOffset = writer.AddBlob(pImage->Data.data(), pImage->Data.size());
+        fileImage.DataSize   = pImage->Data.size();
+        images.push_back(fileImage);
+
+        for (auto& mipOffset : pImage->MipOffsets)
+        {
+            mipLevels.push_back(FileMipLevel{mipOffset.Offset, mipOffset.RowStride});
+        }
+    }
+
+    // Textures
+    std::vector<FileTexture>                                 textures;
+    std::unordered_map<const FauxRender::Texture*, uint32_t> textureIndices;
+    for (auto& texture : pGraph->Textures)
+    {
+        FileTexture fileTexture  = {};
+        fileTexture.Name         = writer.AddString(texture->Name);
+        fileTexture.ImageIndex   = pGraph->GetImageIndex(texture->pImage);
+        fileTexture.SamplerIndex = pGraph->GetSamplerIndex(texture->pSampler);
+
+        textureIndices[texture.get()] = CountU32(textures);
+        textures.push_back(fileTexture);
+    }
+
+    // Materials
+    std::vector<FileMaterial> materials;
+    for (auto& material : pGraph->Materials)
+    {
+        FileMaterial fileMaterial             = {};
+        fileMaterial.Name                     = writer.AddString(material.Name);
+        fileMaterial.MetallicFactor           = material.MetallicFactor;
+        fileMaterial.RoughnessFactor          = material.RoughnessFactor;
+        fileMaterial.EmissiveStrength         = material.EmissiveStrength;
+        fileMaterial.BaseColorTexture         = FindIndex(textureIndices, material.pBaseColorTexture);
+        fileMaterial.MetallicRoughnessTexture = FindIndex(textureIndices, material.pMetallicRoughnessTexture);
+        fileMaterial.NormalTexture            = FindIndex(textureIndices, material.pNormalTexture);
+        fileMaterial.OcclusionTexture         = FindIndex(textureIndices, material.pOcclusionTexture);
+        fileMaterial.EmissiveTexture          = FindIndex(textureIndices, material.pEmissiveTexture);
+        fileMaterial.TexCoordRotate           = material.TexCoordRotate;
+        for (int i = 0; i < 4; ++i)
+        {
+            fileMaterial.BaseColor[i] = material.BaseColor[i];
+        }
+        for (int i = 0; i < 3; ++i)
+        {
+            fileMaterial.Emissive[i] = material.Emissive[i];
+        }
+        for (int i = 0; i < 2; ++i)
+        {
+            fileMaterial.TexCoordTranslate[i] = material.TexCoordTranslate[i];
+            fileMaterial.TexCoordScale[i]     = material.TexCoordScale[i];
+        }
+        materials.push_back(fileMaterial);
+    }
+
+    // Meshes
+    std::vector<FileMesh>                                 meshes;
+    std::vector<FileBatch>                                batches;
+    std::unordered_map<const FauxRender::Mesh*, uint32_t> meshIndices;
+    for (auto& mesh : pGraph->Meshes)
+    {
+        auto pBuffer = HostFauxRender::Cast(mesh->pBuffer);
+
+        // The loader copies geometry through its staging buffer, so mesh
+        // buffers can be larger than the data the batches use.
+        size_t dataSize = 0;
+        for (auto& batch : mesh->DrawBatches)
+        {
+            dataSize = std::max<size_t>(dataSize, GetBufferViewEnd(batch.IndexBufferView));
+            dataSize = std::max<size_t>(dataSize, GetBufferViewEnd(batch.PositionBufferView));
+            dataSize = std::max<size_t>(dataSize, GetBufferViewEnd(batch.VertexColorBufferView));
+            dataSize = std::max<size_t>(dataSize, GetBufferViewEnd(batch.TexCoordBufferView));
+            dataSize = std::max<size_t>(dataSize, GetBufferViewEnd(batch.NormalBufferView));
+            dataSize = std::max<size_t>(dataSize, GetBufferViewEnd(batch.TangentBufferView));
+        }
+        dataSize = std::min(dataSize, pBuffer->Data.size());
+
+        FileMesh fileMesh   = {};
+        fileMesh.Name       = writer.AddString(mesh->Name);
+        fileMesh.FirstBatch = CountU32(batches);
+        fileMesh.NumBatches = CountU32(mesh->DrawBatches);
+        fileMesh.DataOffset = writer.AddBlob(pBuffer->Data.data(), dataSize);
+        fileMesh.DataSize   = dataSize;
+        CopyBounds(mesh->Bounds, fileMesh.BoundsMin, fileMesh.BoundsMax);
+
+        for (auto& batch : mesh->DrawBatches)
+        {
+            FileBatch fileBatch             = {};
+            fileBatch.MaterialIndex         = pGraph->GetMaterialIndex(batch.pMaterial);
+            fileBatch.IndexBufferView       = ToFileBufferView(batch.IndexBufferView);
+            fileBatch.PositionBufferView    = ToFileBufferView(batch.PositionBufferView);
+            fileBatch.VertexColorBufferView = ToFileBufferView(batch.VertexColorBufferView);
+            fileBatch.TexCoordBufferView    = ToFileBufferView(batch.TexCoordBufferView);
+            fileBatch.NormalBufferView      = ToFileBufferView(batch.NormalBufferView);
+            fileBatch.TangentBufferView     = ToFileBufferView(batch.TangentBufferView);
+            CopyBounds(batch.Bounds, fileBatch.BoundsMin, fileBatch.BoundsMax);
+            batches.push_back(fileBatch);
+        }
+
+        meshIndices[mesh.get()] = CountU32(meshes);
+        meshes.push_back(fileMesh);
+    }
+
+    // Nodes
+    std::vector<FileNode> nodes;
+    std::vector<uint32_t> nodeChildren;
+    for (auto& node : pGraph->Nodes)
+    {
+        FileNode fileNode    = {};
+        fileNode.Name        = writer.AddString(node.Name);
+        fileNode.Type        = static_cast<uint32_t>(node.Type);
+        fileNode.Parent      = node.Parent;
+        fileNode.FirstChild  = CountU32(nodeChildren);
+        fileNode.NumChildren = CountU32(node.Children);
+        fileNode.MeshIndex   = FindIndex(meshIndices, node.pMesh);
+        fileNode.AspectRatio = node.Camera.AspectRatio;
+        fileNode.FovY        = node.Camera.FovY;
+        fileNode.NearClip    = node.Camera.NearClip;
+        fileNode.FarClip     = node.Camera.FarClip;
+        for (int i = 0; i < 3; ++i)
+        {
+            fileNode.Translate[i] = node.Translate[i];
+            fileNode.Scale[i]     = node.Scale[i];
+        }
+        for (int i = 0; i < 4; ++i)
+        {
+            fileNode.Rotation[i] = node.Rotation[i];
+        }
+        nodeChildren.insert(nodeChildren.end(), node.Children.begin(), node.Children.end());
+        nodes.push_back(fileNode);
+    }
+
+    // Scenes
+    std::vector<FileScene> scenes;
+    std::vector<uint32_t>  sceneNodes;
+    for (auto& scene : pGraph->Scenes)
+    {
+        FileScene fileScene    = {};
+        fileScene.Name         = writer.AddString(scene->Name);
+        fileScene.FirstNode    = CountU32(sceneNodes);
+        fileScene.NumNodes     = CountU32(scene->Nodes);
+        fileScene.ActiveCamera = !IsNull(scene->pActiveCamera) ? scene->pActiveCamera->Index : UINT32_MAX;
+        for (auto pNode : scene->Nodes)
+        {
+            sceneNodes.push_back(pNode->Index);
+        }
+        scenes.push_back(fileScene);
+    }
+
+    return writer.Write(path, nodes, nodeChildren, scenes, sceneNodes, meshes, batches, materials, textures, images, mipLevels, samplers);
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 3)
+    {
+        std::cout << "error: missing arguments" << std::endl;
+        std::cout << "   "
+                  << "gltf_to_grexscene <input file> <output file>" << std::endl;
+        std::cout << "\nEx:\n";
+        std::cout << "   "
+                  << "gltf_to_grexscene scene.gltf scene.grexscene" << std::endl;
+        std::cout << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::filesystem::path inputFile  = argv[1];
+    std::filesystem::path outputFile = argv[2];
+
+    if (!std::filesystem::exists(inputFile))
+    {
+        std::cout << "error: input file does not exist " << inputFile << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    auto startTime = std::chrono::high_resolution_clock::now();
+
+    // Vertex colors are kept so the file covers every LoadOptions setup.
+    // Meshes are optimized once here instead of on every load.
+    FauxRender::LoadOptions loadOptions = {};
+    loadOptions.EnableVertexColors      = true;
+    loadOptions.OptimizeMeshes          = true;
+
+    // No default images or samplers, they'd end up in the output file
+    HostFauxRender::SceneGraph graph(false);
+    if (!FauxRender::LoadGLTF(inputFile, loadOptions, &graph))
+    {
+        std::cout << "error: failed to load input file " << inputFile << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    if (!WriteSceneFile(outputFile, &graph))
+    {
+        std::cout << "error: failed to write output file " << outputFile << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    auto endTime = std::chrono::high_resolution_clock::now();
+    auto elapsed = std::chrono::duration<double>(endTime - startTime).count();
+
+    std::cout << "Successfully wrote output file " << outputFile << " (" << elapsed << " s)" << std::endl;
+
+    return EXIT_SUCCESS;
+}
@@ -1,9 +1,10 @@
 
+#include <atomic>
 #include <filesystem>
+#include <iomanip>
 #include <iostream>
 #include <memory>
 #include <mutex>
-#include <thread>
 #include <vector>
 
 #define GLM_ENABLE_EXPERIMENTAL
@@ -11,6 +12,9 @@
 #include <glm/gtx/string_cast.hpp>
 using namespace glm;
 
+#include "job_system.h"
+#include "profiler.h"
+
 #define STB_IMAGE_WRITE_IMPLEMENTATION
 #include "stb_image_write.h"
 
@@ -285,73 +289,65 @@ float2 IntegrateBRDF_Narkowicz(int x, float ndotv, int LUT_WIDTH)
 // Main
 // =============================================================================
 
-int                 gNumThreads = 16;
-int                 gResX       = 0;
-int                 gResY       = 0;
-std::vector<int>    gScanlines;
-std::mutex          gScanlineMutex;
-std::vector<float3> gPixels;
-bool                gMultiscatter = false;
+int                   gResX = 0;
+int                   gResY = 0;
+std::vector<float3>   gPixels;
+bool                  gMultiscatter = false;
+std::atomic<uint32_t> gNumScanlinesDone;
+std::mutex            gProgressMutex;
 
-int GetNextScanline()
+void ReportScanlineDone()
 {
-    std::lock_guard<std::mutex> lock(gScanlineMutex);
-
-    int scanline = -1;
-    if (!gScanlines.empty()) {
-        scanline = gScanlines.back();
-        gScanlines.pop_back();
-
-        // Print every 32 scanlines
-        size_t n = gResY - gScanlines.size();
-        if (((n % 32) == 0) || (n == 0) || (n == gResY)) {
-            float percent = n / static_cast<float>(gResY) * 100.0f;
-            std::cout << "Procssing:  " << std::fixed << std::setw(4) << std::setprecision(2) << percent << "% complete" << std::endl;
-        }
-    }
+    // Print every 32 scanlines
+    uint32_t n = ++gNumScanlinesDone;
+    if (((n % 32) == 0) || (n == static_cast<uint32_t>(gResY))) {
+        std::lock_guard<std::mutex> lock(gProgressMutex);
 
-    return scanline;
+        float percent = n / static_cast<float>(gResY) * 100.0f;
+        std::cout << "Procssing:  " << std::fixed << std::setw(4) << std::setprecision(2) << percent << "% complete" << std::endl;
+    }
 }
 
-void ProcessScaline()
+void ProcessScanline(int y)
 {
-    int y = GetNextScanline();
-    while (y != -1) {
-        float3* pPixels = &gPixels[y * gResX];
-
-        for (int x = 0; x < gResX; ++x) {
-            float  roughness = (static_cast<float>(x) + 0.5f) / static_cast<float>(gResX);
-            float  NoV       = (static_cast<float>(y) + 0.5f) / static_cast<float>(gResY);
-            float2 brdf      = float2(0, 0);
-            if (gMultiscatter) {
-                brdf = IntegrateBRDF_Multiscatter(roughness, NoV);
-            }
-            else {
-                brdf = IntegrateBRDF(roughness, NoV);
-            }
-            *pPixels = float3(brdf, 0);
-            ++pPixels;
-        }
+    GREX_PROFILE_FUNCTION();
+
+    float3* pPixels = &gPixels[y * gResX];
 
-        //
-        // Alternative version using Krzysztof Narkowicz's implementation
-        //
-        // int         LUT_WIDTH  = gResX;
-        // int         LUT_HEIGHT = gResY;
-        // const float ndotv      = (y + 0.5f) / static_cast<float>(LUT_HEIGHT);
-        // for (int x = 0; x < gResX; ++x) {
-        //    float2 brdf = IntegrateBRDF_Narkowicz(x, ndotv, LUT_WIDTH);
-        //    *pPixels    = float3(brdf, 0);
-        //    ++pPixels;
-        // }
-        //
-
-        y = GetNextScanline();
+    for (int x = 0; x < gResX; ++x) {
+        float  roughness = (static_cast<float>(x) + 0.5f) / static_cast<float>(gResX);
+        float  NoV       = (static_cast<float>(y) + 0.5f) / static_cast<float>(gResY);
+        float2 brdf      = float2(0, 0);
+        if (gMultiscatter) {
+            brdf = IntegrateBRDF_Multiscatter(roughness, NoV);
+        }
+        else {
+            brdf = IntegrateBRDF(roughness, NoV);
+        }
+        *pPixels = float3(brdf, 0);
+        ++pPixels;
     }
+
+    //
+    // Alternative version using Krzysztof Narkowicz's implementation
+    //
+    // int         LUT_WIDTH  = gResX;
+    // int         LUT_HEIGHT = gResY;
+    // const float ndotv      = (y + 0.5f) / static_cast<float>(LUT_HEIGHT);
+    // for (int x = 0; x < gResX; ++x) {
+    //    float2 brdf = IntegrateBRDF_Narkowicz(x, ndotv, LUT_WIDTH);
+    //    *pPixels    = float3(brdf, 0);
+    //    ++pPixels;
+    // }
+    //
+
+    ReportScanlineDone();
 }
 
 int main(int argc, char** argv)
 {
+    GREX_PROFILE_THREAD_NAME("Main");
+
     const uint32_t kMaxWidth  = 8192;
     const uint32_t kMaxHeight = 8192;
 
@@ -424,21 +420,18 @@ int main(int argc, char** argv)
 
     gPixels.resize(gResX * gResY);
 
-    for (int i = 0; i < gResY; ++i) {
-        gScanlines.push_back(gResY - i - 1);
-    }
-
-    std::vector<std::unique_ptr<std::thread>> threads;
-    for (int i = 0; i < gNumThreads; ++i) {
-        auto thread = std::make_unique<std::thread>(&ProcessScaline);
-        threads.push_back(std::move(thread));
-    }
-
-    for (auto& thread : threads) {
-        thread->join();
+    // One scanline per job
+    {
+        GREX_PROFILE_SCOPE("Integrate BRDF");
+        JobSystem::Get().ParallelFor(0, gResY, 1, [](uint32_t begin, uint32_t end) {
+            for (uint32_t y = begin; y < end; ++y) {
+                ProcessScanline(static_cast<int>(y));
+            }
+        });
     }
 
     if (!gPixels.empty()) {
+        GREX_PROFILE_SCOPE("stbi_write_hdr");
         int res = stbi_write_hdr(outputFile.string().c_str(), gResX, gResY, 3, reinterpret_cast<const float*>(gPixels.data()));
         if (res == 0) {
             std::cout << "ERROR: failed to write " << outputFile << std::endl;
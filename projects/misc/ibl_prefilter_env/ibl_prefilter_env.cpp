@@ -1,11 +1,11 @@
 
+#include <atomic>
 #include <filesystem>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
 #include <memory>
 #include <mutex>
-#include <thread>
 #include <vector>
 
 #define GLM_ENABLE_EXPERIMENTAL
@@ -14,6 +14,9 @@
 using namespace glm;
 
 #include "bitmap.h"
+#include "env_sampling.h"
+#include "job_system.h"
+#include "profiler.h"
 
 #include "pcg32.h"
 
@@ -23,10 +26,8 @@ using float2 = glm::vec2;
 using float3 = glm::vec3;
 using float4 = glm::vec4;
 
-BitmapRGBA32f               gEnvironmentMap;
-std::vector<float>          gGaussianKernel;
-std::vector<pcg32>          gRandoms;
-static std::atomic_uint32_t sThreadCounter;
+BitmapRGBA32f      gEnvironmentMap;
+std::vector<float> gGaussianKernel;
 
 // circular atan2 - converts (x,y) on a unit circle to [0, 2pi]
 //
@@ -211,132 +212,130 @@ float3 PrefilterEnvMap(float Roughness, float3 R, pcg32* pRandom)
 // Main
 // =============================================================================
 
-int              gNumThreads = 16;
-int              gResX       = 0;
-int              gResY       = 0;
-float            gDu         = 0;
-float            gDv         = 0;
-float            gRoughness  = 0;
-std::vector<int> gScanlines;
-std::mutex       gScanlineMutex;
-BitmapRGBA32f*   gIrradianceSource = nullptr;
-BitmapRGBA32f*   gTarget           = nullptr;
-uint32_t         gTargetYOffset    = 0;
-uint32_t         gNumLevels        = 0;
-uint32_t         gCurrentLevel     = 0;
-
-int GetNextScanline()
+int                   gResX             = 0;
+int                   gResY             = 0;
+float                 gDu               = 0;
+float                 gDv               = 0;
+float                 gRoughness        = 0;
+BitmapRGBA32f*        gIrradianceSource = nullptr;
+BitmapRGBA32f*        gTarget           = nullptr;
+uint32_t              gTargetYOffset    = 0;
+uint32_t              gNumLevels        = 0;
+uint32_t              gCurrentLevel     = 0;
+std::atomic<uint32_t> gNumScanlinesDone;
+std::mutex            gProgressMutex;
+
+void ReportScanlineDone()
 {
-    std::lock_guard<std::mutex> lock(gScanlineMutex);
-
-    int scanline = -1;
-    if (!gScanlines.empty()) {
-        scanline = gScanlines.back();
-        gScanlines.pop_back();
-
-        // Print every 32 scanlines
-        size_t n = gResY - gScanlines.size();
-        if (((n % 32) == 0) || (n == 0) || (n == gResY)) {
-            float percent = n / static_cast<float>(gResY) * 100.0f;
-            std::cout << "Procssing level " << gCurrentLevel << "/" << (gNumLevels - 1) << ": " << std::fixed << std::setw(4) << std::setprecision(2) << percent << "% complete" << std::endl;
-        }
-    }
+    // Print every 32 scanlines
+    uint32_t n = ++gNumScanlinesDone;
+    if (((n % 32) == 0) || (n == static_cast<uint32_t>(gResY))) {
+        std::lock_guard<std::mutex> lock(gProgressMutex);
 
-    return scanline;
+        float percent = n / static_cast<float>(gResY) * 100.0f;
+        std::cout << "Procssing level " << gCurrentLevel << "/" << (gNumLevels - 1) << ": " << std::fixed << std::setw(4) << std::setprecision(2) << percent << "% complete" << std::endl;
+    }
 }
 
-void ProcessScanlineEnvironmentMap()
+//
+// Processes every scanline in parallel. Each scanline gets its own random
+// stream, so the output doesn't depend on the number of threads or on
+// which thread picked up which scanline.
+//
+template <typename ProcessFn>
+void ProcessScanlines(ProcessFn processScanline)
 {
-    uint32_t threadIndex = sThreadCounter++;
-    pcg32*   pRandom     = &gRandoms[threadIndex];
-
-    int y = GetNextScanline();
-    while (y != -1) {
-        float4* pPixels = reinterpret_cast<float4*>(gTarget->GetPixels(0, y + gTargetYOffset));
-
-        for (int x = 0; x < gResX; ++x) {
-            float  theta  = (x * gDu) * 2 * PI;
-            float  phi    = (y * gDv) * PI * 0.99999f;
-            float3 R      = glm::normalize(SphericalToCartesian(theta, phi));
-            float3 sample = PrefilterEnvMap(gRoughness, R, pRandom);
-            *pPixels      = float4(sample, 1);
-            ++pPixels;
+    gNumScanlinesDone = 0;
+
+    JobSystem::Get().ParallelFor(0, gResY, 1, [&processScanline](uint32_t begin, uint32_t end) {
+        for (uint32_t y = begin; y < end; ++y) {
+            GREX_PROFILE_SCOPE("Scanline");
+
+            pcg32 random = pcg32(0xDEADBEEF, y);
+            processScanline(static_cast<int>(y), &random);
+            ReportScanlineDone();
         }
+    });
+}
 
-        y = GetNextScanline();
+void ProcessScanlineEnvironmentMap(int y, pcg32* pRandom)
+{
+    float4* pPixels = reinterpret_cast<float4*>(gTarget->GetPixels(0, y + gTargetYOffset));
+
+    for (int x = 0; x < gResX; ++x) {
+        float  theta  = (x * gDu) * 2 * PI;
+        float  phi    = (y * gDv) * PI * 0.99999f;
+        float3 R      = glm::normalize(SphericalToCartesian(theta, phi));
+        float3 sample = PrefilterEnvMap(gRoughness, R, pRandom);
+        *pPixels      = float4(sample, 1);
+        ++pPixels;
     }
 }
 
-void ProcessScanlineIrradiance()
+void ProcessScanlineIrradiance(int y, pcg32* pRandom)
 {
     const uint32_t kNumSamples = 4069;
     const float    kRoughness  = 1.0f;
 
-    uint32_t threadIndex = sThreadCounter++;
-    pcg32*   pRandom     = &gRandoms[threadIndex];
-
-    int y = GetNextScanline();
-    while (y != -1) {
-        float4* pPixels = reinterpret_cast<float4*>(gTarget->GetPixels(0, y + gTargetYOffset));
-
-        for (int x = 0; x < gResX; ++x) {
-            // Get normal direction at (x, y)
-            float  u     = saturate((x + 0.5f) / static_cast<float>(gResX));
-            float  v     = saturate((y + 0.5f) / static_cast<float>(gResY));
-            float  theta = u * 2 * PI;
-            float  phi   = v * PI;
-            float3 N     = glm::normalize(SphericalToCartesian(theta, phi));
-
-            float4 pixel        = float4(0);
-            float  totalSamples = 0;
-            for (uint32_t i = 0; i < kNumSamples; ++i) {
-                // NOTE: Hammersley is not used here because it can causes artifacting
-                //       on the poles. The artifact looks like a pinch at the poles.
-                //
-                // Random point on sphere
-                float  u   = pRandom->nextFloat();
-                float  v   = pRandom->nextFloat();
-                float3 L   = ImportanceSampleGGX(float2(u, v), kRoughness, N);
-                float  NoL = saturate(dot(N, L));
-
-                // Get the spherical coordinate of of the sample vector
-                float2 uv = CartesianToSpherical(L);
-                u         = saturate(uv.x / (2.0f * PI));
-                v         = saturate(uv.y / PI);
-
-                // Use Gaussian sampling since bilinear produces too much noise
-                auto value = gIrradianceSource->GetGaussianSampleUV(u, v, gGaussianKernel, BITMAP_SAMPLE_MODE_WRAP, BITMAP_SAMPLE_MODE_CLAMP);
-                //
-                // This may be incorrect logic...but scale the contribution
-                // based on Lambert. This produces a much nicer result than
-                // without it.
-                //
-                //value *= NoL;
+    float4* pPixels = reinterpret_cast<float4*>(gTarget->GetPixels(0, y + gTargetYOffset));
+
+    for (int x = 0; x < gResX; ++x) {
+        // Get normal direction at (x, y)
+        float  u     = saturate((x + 0.5f) / static_cast<float>(gResX));
+        float  v     = saturate((y + 0.5f) / static_cast<float>(gResY));
+        float  theta = u * 2 * PI;
+        float  phi   = v * PI;
+        float3 N     = glm::normalize(SphericalToCartesian(theta, phi));
+
+        float4 pixel        = float4(0);
+        float  totalSamples = 0;
+        for (uint32_t i = 0; i < kNumSamples; ++i) {
+            // NOTE: Hammersley is not used here because it can causes artifacting
+            //       on the poles. The artifact looks like a pinch at the poles.
+            //
+            // Random point on sphere
+            float  u   = pRandom->nextFloat();
+            float  v   = pRandom->nextFloat();
+            float3 L   = ImportanceSampleGGX(float2(u, v), kRoughness, N);
+            float  NoL = saturate(dot(N, L));
 
-                // Accumulate!
-                pixel.r += value.r;
-                pixel.g += value.g;
-                pixel.b += value.b;
-                pixel.a += value.a;
+            // Get the spherical coordinate of of the sample vector
+            float2 uv = CartesianToSpherical(L);
+            u         = saturate(uv.x / (2.0f * PI));
+            v         = saturate(uv.y / PI);
 
-                totalSamples += 1; // NoL;
-            }
-            // Compute average
-            pixel = pixel / static_cast<float>(totalSamples);
-
-            pPixels->r = pixel.r;
-            pPixels->g = pixel.g;
-            pPixels->b = pixel.b;
-            pPixels->a = pixel.a;
-            ++pPixels;
-        }
+            // Use Gaussian sampling since bilinear produces too much noise
+            auto value = gIrradianceSource->GetGaussianSampleUV(u, v, gGaussianKernel, BITMAP_SAMPLE_MODE_WRAP, BITMAP_SAMPLE_MODE_CLAMP);
+            //
+            // This may be incorrect logic...but scale the contribution
+            // based on Lambert. This produces a much nicer result than
+            // without it.
+            //
+            //value *= NoL;
 
-        y = GetNextScanline();
+            // Accumulate!
+            pixel.r += value.r;
+            pixel.g += value.g;
+            pixel.b += value.b;
+            pixel.a += value.a;
+
+            totalSamples += 1; // NoL;
+        }
+        // Compute average
+        pixel = pixel / static_cast<float>(totalSamples);
+
+        pPixels->r = pixel.r;
+        pPixels->g = pixel.g;
+        pPixels->b = pixel.b;
+        pPixels->a = pixel.a;
+        ++pPixels;
     }
 }
 
 int main(int argc, char** argv)
 {
+    GREX_PROFILE_THREAD_NAME("Main");
+
     if (argc < 3) {
         std::cout << "error: ibl_prefilter_env requires two arguments:" << std::endl;
         std::cout << "   ibl_prefilter_env <input file> <output dir>" << std::endl;
@@ -351,8 +350,7 @@ int main(int argc, char** argv)
         }
     }
 
-    gNumThreads = std::thread::hardware_concurrency();
-    std::cout << "Using " << gNumThreads << " threads" << std::endl;
+    std::cout << "Using " << JobSystem::Get().GetNumThreads() << " threads" << std::endl;
 
     std::filesystem::path inputFilePath = std::filesystem::absolute(argv[1]);
     std::filesystem::path outputDir     = std::filesystem::absolute(argv[2]);
@@ -361,6 +359,7 @@ int main(int argc, char** argv)
 
     std::filesystem::path irradianceMapFilePath  = (outputDir / (baseFileName.string() + "_irr")).replace_extension(extension);
     std::filesystem::path environmentMapFilePath = (outputDir / (baseFileName.string() + "_env")).replace_extension(extension);
+    std::filesystem::path samplingTableFilePath  = (outputDir / (baseFileName.string() + "_sampling")).replace_extension("bin");
     std::filesystem::path iblFilePath            = (outputDir / baseFileName).replace_extension("ibl");
 
     BitmapRGBA32f sourceImage = {};
@@ -376,16 +375,13 @@ int main(int argc, char** argv)
     // Irradiance map
     // =========================================================================
     {
+        GREX_PROFILE_SCOPE("Irradiance map");
+
         // Kernel for irridiance map sampling
         uint32_t radius     = 3; // 128;
         uint32_t kernelSize = 2 * radius + 1;
         gGaussianKernel     = GaussianKernel(kernelSize);
 
-        gRandoms.resize(gNumThreads);
-        for (int i = 0; i < gNumThreads; ++i) {
-            gRandoms[i].seed(0xDEADBEEF + i);
-        }
-
         uint32_t      width  = 360;
         uint32_t      height = static_cast<uint32_t>(width / (sourceImage.GetWidth() / static_cast<float>(sourceImage.GetHeight())));
         BitmapRGBA32f target = BitmapRGBA32f(width, height);
@@ -400,23 +396,11 @@ int main(int argc, char** argv)
         gCurrentLevel     = 1;
         gNumLevels        = 2; // Use 2 so that 1/1 gets printed
 
-        // Queue scanlines
-        for (int i = 0; i < gResY; ++i) {
-            gScanlines.push_back(gResY - i - 1);
-        }
-
-        // Launch threads to process scanlines
-        std::vector<std::unique_ptr<std::thread>> threads;
-        for (int i = 0; i < gNumThreads; ++i) {
-            auto thread = std::make_unique<std::thread>(&ProcessScanlineIrradiance);
-            threads.push_back(std::move(thread));
-        }
-        // Wait to threads complete
-        for (auto& thread : threads) {
-            thread->join();
-        }
+        ProcessScanlines(ProcessScanlineIrradiance);
 
         if (!target.Empty()) {
+            GREX_PROFILE_SCOPE("Irradiance blur");
+
             BitmapRGBA32f blurred = BitmapRGBA32f(target.GetWidth(), target.GetHeight());
 
             // Kernel for image convolution sampling to smooth out the noise
@@ -456,6 +440,8 @@ int main(int argc, char** argv)
 
     gNumLevels = 0;
     {
+        GREX_PROFILE_SCOPE("Environment map");
+
         // Calculate the number of mip levels and output height
         gNumLevels       = 1;
         int outputHeight = gEnvironmentMap.GetHeight();
@@ -497,6 +483,8 @@ int main(int argc, char** argv)
         float deltaRoughness = 1.0f / static_cast<float>(1.44f * gNumLevels);
 
         for (uint32_t level = 0; level < gNumLevels; ++level) {
+            GREX_PROFILE_SCOPE("Environment map level");
+
             gCurrentLevel = level;
 
             gDu = 1.0f / static_cast<float>(gResX - 1);
@@ -506,24 +494,7 @@ int main(int argc, char** argv)
             gRoughness = level * deltaRoughness;
             std::cout << "level=" << level << ", roughness=" << std::setw(2) << std::setprecision(6) << std::fixed << gRoughness << std::endl;
 
-            // Queue scanlines
-            for (int i = 0; i < gResY; ++i) {
-                gScanlines.push_back(i);
-            }
-
-            // Reset thread counter
-            sThreadCounter = 0;
-
-            // Launch threads to process scanlines
-            std::vector<std::unique_ptr<std::thread>> threads;
-            for (int i = 0; i < gNumThreads; ++i) {
-                auto thread = std::make_unique<std::thread>(&ProcessScanlineEnvironmentMap);
-                threads.push_back(std::move(thread));
-            }
-            // Wait to complete
-            for (auto& thread : threads) {
-                thread->join();
-            }
+            ProcessScanlines(ProcessScanlineEnvironmentMap);
 
             gEnvironmentMap = gTarget->CopyFrom(0, gTargetYOffset, gResX, gResY);
 
@@ -556,12 +527,33 @@ int main(int argc, char** argv)
         }
     }
 
+    // =========================================================================
+    // Importance sampling table
+    // =========================================================================
+    {
+        GREX_PROFILE_SCOPE("Importance sampling table");
+
+        // Built from the source image, level 0 of the environment map is the same image
+        EnvironmentSampler sampler;
+        if (!EnvironmentSampler::Build(sourceImage, {}, &sampler)) {
+            std::cout << "error: failed to build the importance sampling table" << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        if (!EnvironmentSampler::Save(samplingTableFilePath, &sampler)) {
+            std::cout << "error: failed to write " << samplingTableFilePath << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        std::cout << "Successfully wrote " << samplingTableFilePath << " (" << sampler.GetWidth() << "x" << sampler.GetHeight() << ")" << std::endl;
+    }
+
     // =========================================================================
     // IBL file
     // =========================================================================
     {
         std::ofstream os = std::ofstream(iblFilePath.string().c_str());
-        os << irradianceMapFilePath.filename() << " " << environmentMapFilePath.filename() << " " << sourceImage.GetWidth() << " " << sourceImage.GetHeight() << " " << gNumLevels << std::endl;
+        os << irradianceMapFilePath.filename() << " " << environmentMapFilePath.filename() << " " << sourceImage.GetWidth() << " " << sourceImage.GetHeight() << " " << gNumLevels << " " << samplingTableFilePath.filename() << std::endl;
         std::cout << "Successfully wrote " << iblFilePath << std::endl;
     }
 
@@ -1,5 +1,6 @@
 
 #include <filesystem>
+#include <iomanip>
 #include <iostream>
 #include <string>
 
@@ -75,6 +76,23 @@ int main(int argc, char** argv)
     }
     std::cout << "spatial sorting complete" << std::endl;
 
+    std::cout << std::endl;
+    std::cout << "optimizing vertex cache, overdraw and vertex fetch..." << std::endl;
+    {
+        auto before = inputMesh.Analyze();
+        inputMesh.Optimize();
+        auto after = inputMesh.Analyze();
+
+        std::cout << std::fixed << std::setprecision(3);
+        std::cout << "              before     after" << std::endl;
+        std::cout << "ACMR     : " << std::setw(10) << before.acmr << std::setw(10) << after.acmr << std::endl;
+        std::cout << "ATVR     : " << std::setw(10) << before.atvr << std::setw(10) << after.atvr << std::endl;
+        std::cout << "overdraw : " << std::setw(10) << before.overdraw << std::setw(10) << after.overdraw << std::endl;
+        std::cout << "overfetch: " << std::setw(10) << before.overfetch << std::setw(10) << after.overfetch << std::endl;
+        std::cout << "num vertices: " << inputMesh.GetNumVertices() << std::endl;
+    }
+    std::cout << "optimization complete" << std::endl;
+
     TriMesh::WriteOBJ(outputPath.string(), inputMesh);
     std::cout << std::endl;
     std::cout << "wrote " << outputPath << std::endl;
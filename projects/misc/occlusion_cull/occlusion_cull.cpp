@@ -0,0 +1,346 @@
+//
+// Runs the software occlusion culler over 117_mesh_shader_cull_lod's
+// scene and reports how much it culls and what it costs per frame.
+//
+// 117 draws a 40x40 grid of horse statues with a camera in the middle of
+// the grid and only tests instances and meshlets against the frustum.
+// Here the camera turns a full circle over -frames frames. Every frame
+// the nearest -occluders instances in front of the camera are rasterized
+// with their lowest LOD, then every instance's bounding sphere is tested
+// and the LOD 0 meshlets of the instances that pass are tested too.
+//
+// Triangle counts compare what a frustum-only pass would submit against
+// what's left after occlusion culling. -o writes the last frame's depth
+// buffer as a PNG.
+//
+
+#include "occlusion_culler.h"
+#include "camera.h"
+#include "window.h"
+
+#include "meshoptimizer.h"
+
+#include <chrono>
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtx/transform.hpp>
+
+using glm::mat4;
+using glm::vec3;
+using glm::vec4;
+
+const uint32_t kNumInstanceCols = 40;
+const uint32_t kNumInstanceRows = 40;
+
+// Same as 117
+const size_t kMaxMeshletVertices  = 64;
+const size_t kMaxMeshletTriangles = 124;
+
+struct Meshlets
+{
+    std::vector<vec4>     bounds; // xyz = center, w = radius
+    std::vector<uint32_t> triangleCounts;
+};
+
+bool LoadMesh(const std::string& name, TriMesh* pMesh)
+{
+    if (!TriMesh::LoadOBJ2(GetAssetPath("models/" + name).string(), pMesh)) {
+        std::cout << "error: failed to load " << name << std::endl;
+        return false;
+    }
+    return true;
+}
+
+Meshlets BuildMeshlets(const TriMesh& mesh)
+{
+    const float kConeWeight = 0.0f;
+
+    const size_t maxMeshlets = meshopt_buildMeshletsBound(mesh.GetNumIndices(), kMaxMeshletVertices, kMaxMeshletTriangles);
+
+    std::vector<meshopt_Meshlet> meshlets(maxMeshlets);
+    std::vector<uint32_t>        meshletVertices(maxMeshlets * kMaxMeshletVertices);
+    std::vector<uint8_t>         meshletTriangles(maxMeshlets * kMaxMeshletTriangles * 3);
+
+    size_t meshletCount = meshopt_buildMeshlets(
+        meshlets.data(),
+        meshletVertices.data(),
+        meshletTriangles.data(),
+        reinterpret_cast<const uint32_t*>(mesh.GetTriangles().data()),
+        mesh.GetNumIndices(),
+        reinterpret_cast<const float*>(mesh.GetPositions().data()),
+        mesh.GetNumVertices(),
+        sizeof(vec3),
+        kMaxMeshletVertices,
+        kMaxMeshletTriangles,
+        kConeWeight);
+    meshlets.resize(meshletCount);
+
+    Meshlets result = {};
+    for (auto& meshlet : meshlets) {
+        auto bounds = meshopt_computeMeshletBounds(
+            &meshletVertices[meshlet.vertex_offset],
+            &meshletTriangles[meshlet.triangle_offset],
+            meshlet.triangle_count,
+            reinterpret_cast<const float*>(mesh.GetPositions().data()),
+            mesh.GetNumVertices(),
+            sizeof(vec3));
+        result.bounds.push_back(vec4(bounds.center[0], bounds.center[1], bounds.center[2], bounds.radius));
+        result.triangleCounts.push_back(meshlet.triangle_count);
+    }
+    return result;
+}
+
+// Covered texels go from white (nearest) to dark gray (farthest), uncovered ones are black
+BitmapRGBA8u DepthToBitmap(const OcclusionCuller& culler)
+{
+    uint32_t     width  = 0;
+    uint32_t     height = 0;
+    const float* pDepth = culler.GetLevel(0, &width, &height);
+
+    float minDepth = 1.0f;
+    float maxDepth = 0.0f;
+    for (uint32_t i = 0; i < width * height; ++i) {
+        if (pDepth[i] < 1.0f) {
+            minDepth = std::min(minDepth, pDepth[i]);
+            maxDepth = std::max(maxDepth, pDepth[i]);
+        }
+    }
+    const float range = std::max(maxDepth - minDepth, 1e-6f);
+
+    BitmapRGBA8u bitmap = BitmapRGBA8u(width, height);
+    for (uint32_t y = 0; y < height; ++y) {
+        for (uint32_t x = 0; x < width; ++x) {
+            const float depth = pDepth[y * width + x];
+
+            uint8_t value = 0;
+            if (depth < 1.0f) {
+                value = static_cast<uint8_t>(255.0f - 191.0f * (depth - minDepth) / range + 0.5f);
+            }
+
+            PixelRGBA8u* pPixel = bitmap.GetPixels(x, y);
+            pPixel->r           = value;
+            pPixel->g           = value;
+            pPixel->b           = value;
+            pPixel->a           = 255;
+        }
+    }
+    return bitmap;
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t              width        = 256;
+    uint32_t              height       = 128;
+    uint32_t              numFrames    = 120;
+    uint32_t              numOccluders = 64;
+    std::filesystem::path outputPath   = "";
+
+    std::string badOption = "";
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if ((arg == "-w") || (arg == "-h") || (arg == "-frames") || (arg == "-occluders") || (arg == "-o")) {
+            ++i;
+            if (i >= argc) {
+                badOption = arg;
+                break;
+            }
+        }
+
+        if (arg == "-w") {
+            width = static_cast<uint32_t>(std::max(atoi(argv[i]), 4));
+        }
+        else if (arg == "-h") {
+            height = static_cast<uint32_t>(std::max(atoi(argv[i]), 1));
+        }
+        else if (arg == "-frames") {
+            numFrames = static_cast<uint32_t>(std::max(atoi(argv[i]), 1));
+        }
+        else if (arg == "-occluders") {
+            numOccluders = static_cast<uint32_t>(std::max(atoi(argv[i]), 0));
+        }
+        else if (arg == "-o") {
+            outputPath = argv[i];
+        }
+        else {
+            std::cout << "error: unrecognized arg " << arg << std::endl;
+            std::cout << "   "
+                      << "occlusion_cull [-w <depth buffer width>] [-h <depth buffer height>] [-frames <n>]" << std::endl;
+            std::cout << "   "
+                      << "               [-occluders <n>] [-o <depth png path>]" << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+    if (!badOption.empty()) {
+        std::cout << "error: missing arg for option " << badOption << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // LOD 0 is drawn, LOD 4 (117 triangles) stands in for it as the occluder
+    TriMesh mesh;
+    TriMesh occluderMesh;
+    if (!LoadMesh("horse_statue_01_1k.obj", &mesh) || !LoadMesh("horse_statue_01_1k_LOD_4.obj", &occluderMesh)) {
+        return EXIT_FAILURE;
+    }
+
+    const Meshlets meshlets = BuildMeshlets(mesh);
+
+    const TriMesh::Aabb meshBounds   = mesh.GetBounds();
+    const vec3          sphereCenter = meshBounds.Center();
+    const float         sphereRadius = glm::length(meshBounds.max - meshBounds.min) / 2.0f;
+
+    std::cout << "Mesh: " << mesh.GetNumTriangles() << " triangles, " << meshlets.bounds.size() << " meshlets" << std::endl;
+    std::cout << "Occluder: " << occluderMesh.GetNumTriangles() << " triangles" << std::endl;
+
+    // Instance layout from 117
+    const float maxSpan       = std::max<float>(meshBounds.Width(), meshBounds.Depth());
+    const float instanceSpanX = 4.0f * maxSpan;
+    const float instanceSpanZ = 4.5f * maxSpan;
+    const float totalSpanX    = kNumInstanceCols * instanceSpanX;
+    const float totalSpanZ    = kNumInstanceRows * instanceSpanZ;
+    const float farDist       = std::max(totalSpanX, totalSpanZ);
+
+    OcclusionCuller culler = OcclusionCuller(width, height);
+
+    std::vector<mat4>                        instances(kNumInstanceCols * kNumInstanceRows);
+    std::vector<OcclusionCuller::CullResult> instanceResults(instances.size());
+    std::vector<std::pair<float, uint32_t>>  occluderCandidates;
+    std::vector<uint32_t>                    visibleMeshlets(meshlets.bounds.size());
+
+    uint64_t numInstancesVisible       = 0;
+    uint64_t numInstancesFrustumCulled = 0;
+    uint64_t numInstancesOccluded      = 0;
+    uint64_t numMeshletsTested         = 0;
+    uint64_t numMeshletsVisible        = 0;
+    uint64_t numMeshletsFrustumCulled  = 0;
+    uint64_t numMeshletsOccluded       = 0;
+    uint64_t numFrustumOnlyTriangles   = 0;
+    uint64_t numSubmittedTriangles     = 0;
+    double   totalRasterizeUs          = 0;
+    double   totalBuildHiZUs           = 0;
+    double   totalInstanceTestUs       = 0;
+    double   totalMeshletTestUs        = 0;
+    double   totalFrameUs              = 0;
+
+    for (uint32_t frame = 0; frame < numFrames; ++frame) {
+        const float time  = frame / 60.0f;
+        const float angle = 360.0f * frame / numFrames;
+
+        for (uint32_t j = 0; j < kNumInstanceRows; ++j) {
+            for (uint32_t i = 0; i < kNumInstanceCols; ++i) {
+                float x = i * instanceSpanX - (totalSpanX / 2.0f) + instanceSpanX / 2.0f;
+                float y = 0;
+                float z = j * instanceSpanZ - (totalSpanZ / 2.0f) + instanceSpanZ / 2.0f;
+
+                uint32_t index   = j * kNumInstanceCols + i;
+                float    t       = time + ((i ^ (j + i)) / 10.0f);
+                instances[index] = glm::translate(vec3(x, y, z)) * glm::rotate(t, vec3(0, 1, 0));
+            }
+        }
+
+        const vec3 eyePosition = vec3(0, 0.2f, 0.0f);
+        const vec3 target      = vec3(glm::rotate(glm::radians(angle), vec3(0, 1, 0)) * vec4(0, 0.0f, -1.3f, 1.0));
+        const vec3 viewDir     = glm::normalize(target - eyePosition);
+
+        PerspCamera camera = PerspCamera(45.0f, width / static_cast<float>(height), 0.1f, farDist);
+        camera.LookAt(eyePosition, target);
+
+        auto frameStart = std::chrono::high_resolution_clock::now();
+
+        // Nearest instances in front of the camera make the best occluders
+        occluderCandidates.clear();
+        for (uint32_t i = 0; i < CountU32(instances); ++i) {
+            const vec3  center = vec3(instances[i] * vec4(sphereCenter, 1));
+            const float depth  = glm::dot(center - eyePosition, viewDir);
+            if (depth > sphereRadius) {
+                occluderCandidates.push_back({depth, i});
+            }
+        }
+        const uint32_t numUsedOccluders = std::min(numOccluders, CountU32(occluderCandidates));
+        std::partial_sort(occluderCandidates.begin(), occluderCandidates.begin() + numUsedOccluders, occluderCandidates.end());
+
+        culler.BeginFrame(camera.GetViewProjectionMatrix());
+        for (uint32_t i = 0; i < numUsedOccluders; ++i) {
+            culler.AddOccluder(occluderMesh, instances[occluderCandidates[i].second]);
+        }
+        culler.BuildHiZ();
+
+        // Instances first, then the meshlets of whatever is left
+        auto instanceTestStart = std::chrono::high_resolution_clock::now();
+        for (uint32_t i = 0; i < CountU32(instances); ++i) {
+            instanceResults[i] = culler.TestSphere(vec3(instances[i] * vec4(sphereCenter, 1)), sphereRadius);
+        }
+        auto instanceTestEnd = std::chrono::high_resolution_clock::now();
+
+        const uint64_t numTestedBeforeMeshlets   = culler.GetStats().NumTested;
+        const uint64_t numFrustumBeforeMeshlets  = culler.GetStats().NumFrustumCulled;
+        const uint64_t numOccludedBeforeMeshlets = culler.GetStats().NumOccluded;
+
+        for (uint32_t i = 0; i < CountU32(instances); ++i) {
+            if (instanceResults[i] == OcclusionCuller::CULL_RESULT_FRUSTUM_CULLED) {
+                ++numInstancesFrustumCulled;
+                continue;
+            }
+
+            // A frustum-only pass would draw every meshlet of this instance that's in the frustum,
+            // close enough to count the whole mesh
+            numFrustumOnlyTriangles += mesh.GetNumTriangles();
+
+            if (instanceResults[i] == OcclusionCuller::CULL_RESULT_OCCLUDED) {
+                ++numInstancesOccluded;
+                continue;
+            }
+            ++numInstancesVisible;
+
+            const uint32_t numVisible = culler.TestSpheres(meshlets.bounds.data(), CountU32(meshlets.bounds), instances[i], visibleMeshlets.data());
+            for (uint32_t k = 0; k < numVisible; ++k) {
+                numSubmittedTriangles += meshlets.triangleCounts[visibleMeshlets[k]];
+            }
+            numMeshletsVisible += numVisible;
+        }
+
+        auto frameEnd = std::chrono::high_resolution_clock::now();
+
+        const OcclusionCuller::Stats& stats = culler.GetStats();
+        numMeshletsTested += stats.NumTested - numTestedBeforeMeshlets;
+        numMeshletsFrustumCulled += stats.NumFrustumCulled - numFrustumBeforeMeshlets;
+        numMeshletsOccluded += stats.NumOccluded - numOccludedBeforeMeshlets;
+
+        totalRasterizeUs += stats.RasterizeUs;
+        totalBuildHiZUs += stats.BuildHiZUs;
+        totalInstanceTestUs += std::chrono::duration<double, std::micro>(instanceTestEnd - instanceTestStart).count();
+        totalMeshletTestUs += std::chrono::duration<double, std::micro>(frameEnd - instanceTestEnd).count();
+        totalFrameUs += std::chrono::duration<double, std::micro>(frameEnd - frameStart).count();
+    }
+
+    const uint64_t numInstances = static_cast<uint64_t>(instances.size()) * numFrames;
+    auto           percent      = [](uint64_t count, uint64_t total) { return 100.0 * count / std::max<uint64_t>(total, 1); };
+
+    std::cout << "Culled over " << numFrames << " frames, " << width << "x" << height << " depth buffer, "
+              << numOccluders << " occluders" << std::endl;
+    std::cout << "   instances: " << percent(numInstancesFrustumCulled, numInstances) << "% frustum culled, "
+              << percent(numInstancesOccluded, numInstances) << "% occluded, "
+              << percent(numInstancesVisible, numInstances) << "% visible" << std::endl;
+    std::cout << "   meshlets of visible instances: " << percent(numMeshletsFrustumCulled, numMeshletsTested) << "% frustum culled, "
+              << percent(numMeshletsOccluded, numMeshletsTested) << "% occluded, "
+              << percent(numMeshletsVisible, numMeshletsTested) << "% visible" << std::endl;
+    std::cout << "   triangles/frame: " << (numFrustumOnlyTriangles / numFrames) << " frustum only, "
+              << (numSubmittedTriangles / numFrames) << " with occlusion culling ("
+              << (100.0 - percent(numSubmittedTriangles, numFrustumOnlyTriangles)) << "% fewer)" << std::endl;
+    std::cout << "Time per frame" << std::endl;
+    std::cout << "   rasterize occluders: " << (totalRasterizeUs / numFrames) << " us" << std::endl;
+    std::cout << "   build HiZ:           " << (totalBuildHiZUs / numFrames) << " us" << std::endl;
+    std::cout << "   test instances:      " << (totalInstanceTestUs / numFrames) << " us" << std::endl;
+    std::cout << "   test meshlets:       " << (totalMeshletTestUs / numFrames) << " us" << std::endl;
+    std::cout << "   total:               " << (totalFrameUs / numFrames) << " us" << std::endl;
+
+    if (!outputPath.empty()) {
+        BitmapRGBA8u bitmap = DepthToBitmap(culler);
+        if (!BitmapRGBA8u::Save(outputPath, &bitmap)) {
+            std::cout << "error: failed to write " << outputPath << std::endl;
+            return EXIT_FAILURE;
+        }
+        std::cout << "Wrote " << outputPath << std::endl;
+    }
+
+    return EXIT_SUCCESS;
+}
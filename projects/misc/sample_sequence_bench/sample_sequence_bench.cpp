@@ -0,0 +1,334 @@
+//
+// Convergence of the 2D sample sequences in sample_sequences.h on
+// hemisphere integrals with known values, sampled uniformly over the
+// hemisphere:
+//
+//   cos      - integral of cos(theta), pi
+//   cos^8    - integral of cos(theta)^8, 2pi / 9, peaked around the normal
+//   x^2      - integral of x^2, 2pi / 3, not rotationally symmetric
+//   cap      - indicator of a tilted spherical cap, 2pi * (1 - cos(alpha)),
+//              discontinuous so no sequence gets its best rate
+//
+// For each sample count the RMSE over independently randomized runs is
+// printed relative to the exact value, followed by the convergence rate
+// fitted over the higher sample counts: -0.5 is Monte Carlo, closer to -1
+// or below is what low discrepancy buys. Randomization is a new seed for
+// random, CMJ and Sobol, and a random Cranley-Patterson shift for the
+// deterministic Hammersley set and the lattices.
+//
+// Generation throughput of each sequence and void and cluster timings
+// for the blue noise tiles are printed at the end.
+//
+
+#include "sample_sequences.h"
+
+#include <chrono>
+#include <iomanip>
+#include <random>
+
+using glm::vec2;
+using glm::vec3;
+
+using Clock = std::chrono::high_resolution_clock;
+
+const float kPi = 3.14159265358979f;
+
+double SecondsSince(const Clock::time_point& start)
+{
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+enum Sequence
+{
+    SEQUENCE_RANDOM     = 0,
+    SEQUENCE_HAMMERSLEY = 1,
+    SEQUENCE_CMJ        = 2,
+    SEQUENCE_SOBOL      = 3,
+    SEQUENCE_RANK1      = 4,
+    SEQUENCE_COUNT      = 5,
+};
+
+const char* kSequenceNames[SEQUENCE_COUNT] = {"random", "Hammersley", "CMJ", "Sobol", "rank-1"};
+
+enum Integrand
+{
+    INTEGRAND_COS   = 0,
+    INTEGRAND_COS8  = 1,
+    INTEGRAND_X2    = 2,
+    INTEGRAND_CAP   = 3,
+    INTEGRAND_COUNT = 4,
+};
+
+const char* kIntegrandNames[INTEGRAND_COUNT] = {"cos", "cos^8", "x^2", "cap"};
+
+const float kCapCosAngle = 0.9f;
+
+const vec3& GetCapAxis()
+{
+    static const vec3 sAxis = glm::normalize(vec3(0.5f, 0.2f, 1.0f));
+    return sAxis;
+}
+
+double GetExactValue(Integrand integrand)
+{
+    switch (integrand) {
+        default: break;
+        case INTEGRAND_COS: return kPi;
+        case INTEGRAND_COS8: return 2.0 * kPi / 9.0;
+        case INTEGRAND_X2: return 2.0 * kPi / 3.0;
+        case INTEGRAND_CAP: return 2.0 * kPi * (1.0 - kCapCosAngle);
+    }
+    return 0;
+}
+
+float Evaluate(Integrand integrand, const vec3& w)
+{
+    switch (integrand) {
+        default: break;
+        case INTEGRAND_COS: return w.z;
+        case INTEGRAND_COS8: {
+            float z2 = w.z * w.z;
+            float z4 = z2 * z2;
+            return z4 * z4;
+        }
+        case INTEGRAND_X2: return w.x * w.x;
+        case INTEGRAND_CAP: return (glm::dot(w, GetCapAxis()) > kCapCosAngle) ? 1.0f : 0.0f;
+    }
+    return 0;
+}
+
+// Uniform hemisphere around +Z, pdf is 1 / 2pi
+vec3 UniformHemisphere(const vec2& xi)
+{
+    float z   = 1.0f - xi.y;
+    float r   = sqrtf(std::max(1.0f - z * z, 0.0f));
+    float phi = 2.0f * kPi * xi.x;
+    return vec3(r * cosf(phi), r * sinf(phi), z);
+}
+
+// Fills numSamples samples of trial's randomization of sequence
+void GenerateSamples(
+    Sequence            sequence,
+    uint32_t            numSamples,
+    uint32_t            trial,
+    const Rank1Lattice& lattice,
+    std::mt19937&       rng,
+    vec2*               pSamples)
+{
+    std::uniform_real_distribution<float> dist(0.0f, 1.0f);
+
+    switch (sequence) {
+        default: break;
+
+        case SEQUENCE_RANDOM: {
+            for (uint32_t i = 0; i < numSamples; ++i) {
+                pSamples[i] = vec2(dist(rng), dist(rng));
+            }
+        } break;
+
+        case SEQUENCE_HAMMERSLEY: {
+            GenerateHammersley(numSamples, pSamples);
+
+            vec2 shift = vec2(dist(rng), dist(rng));
+            for (uint32_t i = 0; i < numSamples; ++i) {
+                pSamples[i] += shift;
+                pSamples[i].x = (pSamples[i].x >= 1.0f) ? (pSamples[i].x - 1.0f) : pSamples[i].x;
+                pSamples[i].y = (pSamples[i].y >= 1.0f) ? (pSamples[i].y - 1.0f) : pSamples[i].y;
+            }
+        } break;
+
+        case SEQUENCE_CMJ: {
+            GenerateCMJ(numSamples, trial, pSamples);
+        } break;
+
+        case SEQUENCE_SOBOL: {
+            GenerateSobolOwen2D(0, numSamples, trial, pSamples);
+        } break;
+
+        case SEQUENCE_RANK1: {
+            float shift[2] = {dist(rng), dist(rng)};
+            lattice.Generate(0, numSamples, shift, reinterpret_cast<float*>(pSamples));
+        } break;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t numTrials  = 64;
+    uint32_t maxSamples = 4096;
+
+    std::string badOption = "";
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if ((arg == "-trials") || (arg == "-max-spp")) {
+            ++i;
+            if (i >= argc) {
+                badOption = arg;
+                break;
+            }
+        }
+
+        if (arg == "-trials") {
+            numTrials = static_cast<uint32_t>(std::max(atoi(argv[i]), 2));
+        }
+        else if (arg == "-max-spp") {
+            maxSamples = static_cast<uint32_t>(std::clamp(atoi(argv[i]), 16, 1 << 16));
+        }
+        else {
+            std::cout << "error: unrecognized arg " << arg << std::endl;
+            std::cout << "   "
+                      << "sample_sequence_bench [-trials <n>] [-max-spp <n>]" << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+    if (!badOption.empty()) {
+        std::cout << "error: missing arg for option " << badOption << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::vector<uint32_t> sampleCounts;
+    for (uint32_t spp = 1; spp <= maxSamples; spp *= 2) {
+        sampleCounts.push_back(spp);
+    }
+
+    // Lattices are fixed size, one per sample count
+    auto                      latticeStart = Clock::now();
+    std::vector<Rank1Lattice> lattices(sampleCounts.size());
+    for (size_t i = 0; i < sampleCounts.size(); ++i) {
+        Rank1Lattice::Create(sampleCounts[i], 2, &lattices[i]);
+    }
+    std::cout << "Rank-1 lattice search for " << sampleCounts.size() << " sample counts: "
+              << (SecondsSince(latticeStart) * 1000.0) << " ms" << std::endl;
+
+    // rmse[integrand][sequence][spp index]
+    std::vector<double> rmse(sampleCounts.size() * INTEGRAND_COUNT * SEQUENCE_COUNT, 0.0);
+    auto                GetRmse = [&](uint32_t integrand, uint32_t sequence, size_t sppIndex) -> double& {
+        return rmse[(integrand * SEQUENCE_COUNT + sequence) * sampleCounts.size() + sppIndex];
+    };
+
+    std::vector<vec2> samples(maxSamples);
+    for (uint32_t s = 0; s < SEQUENCE_COUNT; ++s) {
+        std::mt19937 rng(1234 + s);
+        for (size_t sppIndex = 0; sppIndex < sampleCounts.size(); ++sppIndex) {
+            const uint32_t spp = sampleCounts[sppIndex];
+            for (uint32_t trial = 0; trial < numTrials; ++trial) {
+                GenerateSamples(static_cast<Sequence>(s), spp, trial, lattices[sppIndex], rng, DataPtr(samples));
+
+                double sums[INTEGRAND_COUNT] = {};
+                for (uint32_t i = 0; i < spp; ++i) {
+                    vec3 w = UniformHemisphere(samples[i]);
+                    for (uint32_t f = 0; f < INTEGRAND_COUNT; ++f) {
+                        sums[f] += Evaluate(static_cast<Integrand>(f), w);
+                    }
+                }
+
+                for (uint32_t f = 0; f < INTEGRAND_COUNT; ++f) {
+                    double exact    = GetExactValue(static_cast<Integrand>(f));
+                    double estimate = 2.0 * kPi * sums[f] / spp;
+                    GetRmse(f, s, sppIndex) += (estimate - exact) * (estimate - exact);
+                }
+            }
+        }
+    }
+
+    for (uint32_t f = 0; f < INTEGRAND_COUNT; ++f) {
+        const double exact = GetExactValue(static_cast<Integrand>(f));
+
+        std::cout << std::endl;
+        std::cout << kIntegrandNames[f] << ", exact " << exact << ", relative RMSE over " << numTrials << " runs" << std::endl;
+        std::cout << "   spp";
+        for (uint32_t s = 0; s < SEQUENCE_COUNT; ++s) {
+            std::cout << std::setw(12) << kSequenceNames[s];
+        }
+        std::cout << std::endl;
+
+        for (size_t sppIndex = 0; sppIndex < sampleCounts.size(); ++sppIndex) {
+            std::cout << std::setw(6) << sampleCounts[sppIndex];
+            for (uint32_t s = 0; s < SEQUENCE_COUNT; ++s) {
+                double& value = GetRmse(f, s, sppIndex);
+                value         = sqrt(value / numTrials) / exact;
+                std::cout << std::setw(12) << std::setprecision(4) << value;
+            }
+            std::cout << std::endl;
+        }
+
+        // Least squares slope of log(RMSE) against log(spp), from 16 spp up
+        std::cout << "  rate";
+        for (uint32_t s = 0; s < SEQUENCE_COUNT; ++s) {
+            double sumX = 0, sumY = 0, sumXX = 0, sumXY = 0, n = 0;
+            for (size_t sppIndex = 4; sppIndex < sampleCounts.size(); ++sppIndex) {
+                double x = log(static_cast<double>(sampleCounts[sppIndex]));
+                double y = log(std::max(GetRmse(f, s, sppIndex), 1e-12));
+                sumX += x;
+                sumY += y;
+                sumXX += x * x;
+                sumXY += x * y;
+                n += 1;
+            }
+            double slope = (n * sumXY - sumX * sumY) / std::max(n * sumXX - sumX * sumX, 1e-12);
+            std::cout << std::setw(12) << std::setprecision(3) << slope;
+        }
+        std::cout << std::endl;
+    }
+
+    // Throughput, batches of 4096 2D samples into the same buffer
+    {
+        const uint32_t kBatchSize  = 4096;
+        const uint32_t kNumBatches = 256;
+
+        std::vector<vec2> batch(kBatchSize);
+        Rank1Lattice      lattice;
+        Rank1Lattice::Create(kBatchSize, 2, &lattice);
+
+        std::cout << std::endl;
+        std::cout << "Msamples/s";
+        for (uint32_t s = 0; s < SEQUENCE_COUNT; ++s) {
+            std::mt19937 rng(1);
+
+            auto  start    = Clock::now();
+            float checksum = 0;
+            for (uint32_t i = 0; i < kNumBatches; ++i) {
+                GenerateSamples(static_cast<Sequence>(s), kBatchSize, i, lattice, rng, DataPtr(batch));
+                checksum += batch[i].x;
+            }
+            double seconds = SecondsSince(start);
+
+            std::cout << "  " << kSequenceNames[s] << " " << std::setprecision(3)
+                      << (kBatchSize * static_cast<double>(kNumBatches) / seconds / 1e6);
+            if (checksum < 0) {
+                std::cout << "!";
+            }
+        }
+        std::cout << std::endl;
+    }
+
+    // Blue noise
+    {
+        std::cout << std::endl;
+        for (uint32_t size : {32u, 64u, 128u}) {
+            auto          start = Clock::now();
+            BlueNoiseTile tile;
+            if (!BlueNoiseTile::Generate(size, 1, &tile)) {
+                std::cout << "error: failed to generate " << size << "x" << size << " blue noise" << std::endl;
+                return EXIT_FAILURE;
+            }
+            double seconds = SecondsSince(start);
+
+            // Mean absolute difference to the 4 neighbors, 1/3 for white noise, blue noise pushes neighbors apart
+            double sumDiff = 0;
+            for (uint32_t y = 0; y < size; ++y) {
+                for (uint32_t x = 0; x < size; ++x) {
+                    float value = tile.GetValue(x, y);
+                    sumDiff += fabsf(value - tile.GetValue(x + 1, y)) + fabsf(value - tile.GetValue(x, y + 1));
+                    sumDiff += fabsf(value - tile.GetValue(x + size - 1, y)) + fabsf(value - tile.GetValue(x, y + size - 1));
+                }
+            }
+
+            std::cout << "Blue noise " << size << "x" << size << ": " << std::setprecision(4) << (seconds * 1000.0)
+                      << " ms, mean neighbor difference " << (sumDiff / (4.0 * size * size)) << " (white noise 0.333)"
+                      << std::endl;
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
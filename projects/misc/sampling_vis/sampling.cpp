@@ -19,27 +19,38 @@ std::vector<float2> GenerateSamples2DUniform(uint32_t numSamples, uint32_t seed)
 
 std::vector<float2> GenerateSamples2DHammersley(uint32_t numSamples, uint32_t seed)
 {
-    std::vector<float2> samples;
-    for (uint32_t i = 0; i < numSamples; ++i) {
-        float2 sample = Hammersley(i, numSamples);
-        samples.push_back(sample);
-    }
+    std::vector<float2> samples(numSamples);
+    GenerateHammersley(numSamples, DataPtr(samples));
 
     return samples;
 }
 
 //
-// Correlated multi-jitter - Total samples = floor(sqrt(numSamples) + 0.5))^2
+// Correlated multi-jitter - the most square grid with exactly numSamples cells
 //
 std::vector<float2> GenerateSamples2DCMJ(uint32_t numSamples, uint32_t seed)
 {
-    const uint32_t numSamplesX = static_cast<uint32_t>(sqrtf(static_cast<float>(numSamples)) + 0.5f);
-    const uint32_t numSamplesY = numSamplesX;
+    std::vector<float2> samples(numSamples);
+    GenerateCMJ(numSamples, seed, DataPtr(samples));
 
-    std::vector<float2> samples;
-    for (uint32_t i = 0; i < numSamples; ++i) {
-        float2 sample = SampleCMJ2D(i, numSamplesX, numSamplesY, seed);
-        samples.push_back(sample);
+    return samples;
+}
+
+std::vector<float2> GenerateSamples2DSobol(uint32_t numSamples, uint32_t seed)
+{
+    std::vector<float2> samples(numSamples);
+    GenerateSobolOwen2D(0, numSamples, seed, DataPtr(samples));
+
+    return samples;
+}
+
+std::vector<float2> GenerateSamples2DRank1Lattice(uint32_t numSamples, uint32_t seed)
+{
+    std::vector<float2> samples(numSamples);
+
+    Rank1Lattice lattice;
+    if (Rank1Lattice::Create(numSamples, 2, &lattice)) {
+        lattice.Generate(0, numSamples, nullptr, reinterpret_cast<float*>(DataPtr(samples)));
     }
 
     return samples;
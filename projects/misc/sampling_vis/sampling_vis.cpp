@@ -99,12 +99,16 @@ enum SequenceName
     SEQUENCE_NAME_UNIFORM    = 0,
     SEQUENCE_NAME_HAMMERSLEY = 1,
     SEQUENCE_NAME_CMJ        = 2,
+    SEQUENCE_NAME_SOBOL      = 3,
+    SEQUENCE_NAME_RANK1      = 4,
 };
 
 static std::vector<std::string> gSequenceNames = {
     "Uniform",
     "Hammersley",
     "CMJ",
+    "Sobol (Owen)",
+    "Rank-1 Lattice",
 };
 
 enum HemisphereName
@@ -315,6 +319,14 @@ int main(int argc, char** argv)
                     gGenSamples2DFn    = std::bind(GenerateSamples2DCMJ, std::placeholders::_1, std::placeholders::_2);
                     generateHemisphere = true;
                 } break;
+                case SEQUENCE_NAME_SOBOL: {
+                    gGenSamples2DFn    = std::bind(GenerateSamples2DSobol, std::placeholders::_1, std::placeholders::_2);
+                    generateHemisphere = true;
+                } break;
+                case SEQUENCE_NAME_RANK1: {
+                    gGenSamples2DFn    = std::bind(GenerateSamples2DRank1Lattice, std::placeholders::_1, std::placeholders::_2);
+                    generateHemisphere = true;
+                } break;
             }
         }
 
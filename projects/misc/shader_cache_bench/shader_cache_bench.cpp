@@ -0,0 +1,167 @@
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+
+#include "vk_renderer.h"
+#include "shader_cache.h"
+#include "job_system.h"
+#include "window.h"
+
+//
+// Compiles the shaders the Vulkan samples compile at startup and reports
+// the time and cache statistics of each run:
+//
+//   cold     - one at a time with an empty shader cache
+//   parallel - CompileShaders() on the whole job system, empty cache
+//   warm     - one at a time with the cache filled by the earlier runs
+//
+// usage: shader_cache_bench [cache dir]
+//
+// The cache directory is cleared before the cold run, the default is
+// <temp>/grex_shader_cache_bench.
+//
+
+struct ShaderDesc
+{
+    const char* pPath;
+    const char* pEntryPoint;
+    const char* pProfile;
+};
+
+// clang-format off
+static const ShaderDesc kShaders[] = {
+    {"projects/021_raytracing_triangles/shaders.hlsl",            ""      , "lib_6_3"},
+    {"projects/022_raytracing_multi_geo/shaders.hlsl",            ""      , "lib_6_3"},
+    {"projects/023_raytracing_multi_instance/shaders.hlsl",       ""      , "lib_6_3"},
+    {"projects/024_raytracing_pbr_spheres/shaders.hlsl",          ""      , "lib_6_5"},
+    {"projects/025_raytracing_refract/shaders.hlsl",              ""      , "lib_6_5"},
+    {"projects/030_raytracing_path_trace/shaders.hlsl",           ""      , "lib_6_5"},
+    {"projects/031_raytracing_path_trace_pbr/shaders.hlsl",       ""      , "lib_6_5"},
+    {"projects/112_mesh_shader_amplification/shaders.hlsl",       "asmain", "as_6_5" },
+    {"projects/112_mesh_shader_amplification/shaders.hlsl",       "msmain", "ms_6_5" },
+    {"projects/112_mesh_shader_amplification/shaders.hlsl",       "psmain", "ps_6_5" },
+    {"projects/117_mesh_shader_cull_lod/shaders.hlsl",            "asmain", "as_6_5" },
+    {"projects/117_mesh_shader_cull_lod/shaders.hlsl",            "msmain", "ms_6_5" },
+    {"projects/117_mesh_shader_cull_lod/shaders.hlsl",            "psmain", "ps_6_5" },
+    {"projects/201_pbr_spheres/shaders.hlsl",                     "vsmain", "vs_6_0" },
+    {"projects/201_pbr_spheres/shaders.hlsl",                     "psmain", "ps_6_0" },
+    {"projects/307_parallax_occlusion_map_explorer/shaders.hlsl", "vsmain", "vs_6_0" },
+    {"projects/307_parallax_occlusion_map_explorer/shaders.hlsl", "psmain", "ps_6_0" },
+};
+// clang-format on
+
+static bool CompileAll(const std::vector<std::string>& sources, double* pMilliseconds)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+
+    for (size_t i = 0; i < sources.size(); ++i) {
+        const auto& desc = kShaders[i];
+
+        std::vector<uint32_t> spirv;
+        std::string           errorMsg;
+        HRESULT               hr = CompileHLSL(sources[i], desc.pEntryPoint, desc.pProfile, &spirv, &errorMsg);
+        if (FAILED(hr)) {
+            std::cout << "error: shader compiler error\n   path=" << desc.pPath << " entry=" << desc.pEntryPoint << "\n"
+                      << errorMsg << std::endl;
+            return false;
+        }
+    }
+
+    auto end       = std::chrono::high_resolution_clock::now();
+    *pMilliseconds = std::chrono::duration<double, std::milli>(end - start).count();
+
+    return true;
+}
+
+static bool CompileAllParallel(const std::vector<std::string>& sources, double* pMilliseconds)
+{
+    std::vector<VulkanShaderCompileJob> jobs;
+    for (size_t i = 0; i < sources.size(); ++i) {
+        VulkanShaderCompileJob job = {};
+        job.Language               = SHADER_LANGUAGE_HLSL;
+        job.Source                 = sources[i];
+        job.EntryPoint             = kShaders[i].pEntryPoint;
+        job.Profile                = kShaders[i].pProfile;
+        jobs.push_back(job);
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    std::vector<VulkanShaderCompileResult> results;
+    bool                                   res = CompileShaders(jobs, &results);
+
+    auto end       = std::chrono::high_resolution_clock::now();
+    *pMilliseconds = std::chrono::duration<double, std::milli>(end - start).count();
+
+    for (size_t i = 0; i < results.size(); ++i) {
+        if (!results[i].Success) {
+            std::cout << "error: shader compiler error\n   path=" << kShaders[i].pPath << " entry=" << kShaders[i].pEntryPoint << "\n"
+                      << results[i].ErrorMsg << std::endl;
+        }
+    }
+
+    return res;
+}
+
+static void PrintRun(const char* pName, double ms)
+{
+    ShaderCacheStats stats = GetShaderCacheStats();
+    std::cout << "  " << std::left << std::setw(8) << pName << std::right << std::fixed << std::setprecision(2)
+              << std::setw(10) << ms << " ms"
+              << "  hits " << stats.Hits
+              << ", misses " << stats.Misses
+              << ", writes " << stats.Writes
+              << ", read " << stats.BytesRead << " bytes"
+              << ", written " << stats.BytesWritten << " bytes" << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+    std::filesystem::path cacheDir = std::filesystem::temp_directory_path() / "grex_shader_cache_bench";
+    if (argc > 1) {
+        cacheDir = argv[1];
+    }
+
+    std::vector<std::string> sources;
+    for (const auto& desc : kShaders) {
+        sources.push_back(LoadString(desc.pPath));
+        if (sources.back().empty()) {
+            std::cout << "error: failed to load shader\n   path=" << desc.pPath << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::remove_all(cacheDir, ec);
+    SetShaderCacheDirectory(cacheDir);
+
+    std::cout << sources.size() << " shaders, cache " << cacheDir << std::endl;
+
+    double coldMs = 0;
+    ResetShaderCacheStats();
+    if (!CompileAll(sources, &coldMs)) {
+        return EXIT_FAILURE;
+    }
+    PrintRun("cold", coldMs);
+
+    double parallelMs = 0;
+    std::filesystem::remove_all(cacheDir, ec);
+    ResetShaderCacheStats();
+    if (!CompileAllParallel(sources, &parallelMs)) {
+        return EXIT_FAILURE;
+    }
+    PrintRun("parallel", parallelMs);
+
+    double warmMs = 0;
+    ResetShaderCacheStats();
+    if (!CompileAll(sources, &warmMs)) {
+        return EXIT_FAILURE;
+    }
+    PrintRun("warm", warmMs);
+
+    std::cout << "  parallel speedup " << std::fixed << std::setprecision(1) << (coldMs / std::max(parallelMs, 0.001)) << "x"
+              << " on " << JobSystem::Get().GetNumThreads() << " threads" << std::endl;
+    std::cout << "  cache speedup    " << std::fixed << std::setprecision(1) << (coldMs / std::max(warmMs, 0.001)) << "x" << std::endl;
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,216 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "host_faux_render.h"
+
+//
+// Measures CPU skinning and morph target throughput in skinned vertices
+// per millisecond. A synthetic cylinder bent by a joint chain covers the
+// deformation itself. glTF scenes passed on the command line run their
+// first animation end to end: sampling, world and joint matrices, and the
+// writes into the mesh buffers.
+//
+// usage: skinning_bench [scene.gltf ...]
+//
+
+const uint32_t kNumIterations = 20;
+const uint32_t kNumRings      = 256;
+const uint32_t kNumSegments   = 256;
+const uint32_t kNumJoints     = 16;
+const uint32_t kNumTargets    = 2;
+
+// Returns the fastest of kNumIterations runs in milliseconds
+template <typename Fn>
+static double TimeBest(Fn fn)
+{
+    double best = std::numeric_limits<double>::max();
+    for (uint32_t i = 0; i < kNumIterations; ++i)
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        fn(i);
+        auto end = std::chrono::high_resolution_clock::now();
+
+        best = std::min(best, std::chrono::duration<double, std::milli>(end - start).count());
+    }
+    return best;
+}
+
+static void PrintThroughput(const std::string& name, uint64_t numVertices, double ms)
+{
+    std::cout << "  " << std::left << std::setw(32) << name << std::right << std::fixed << std::setprecision(3)
+              << std::setw(10) << ms << " ms"
+              << std::setw(14) << std::setprecision(0) << (numVertices / std::max(ms, 0.001)) << " vertices/ms" << std::endl;
+}
+
+// Unit radius cylinder along +Y, each vertex weighted to the two joints
+// closest to its ring
+static FauxRender::DeformableBatch CreateCylinder()
+{
+    FauxRender::DeformableBatch batch = {};
+    for (uint32_t ring = 0; ring < kNumRings; ++ring)
+    {
+        const float y = static_cast<float>(ring) / (kNumRings - 1);
+        const float t = y * (kNumJoints - 1);
+        const float j = std::min(std::floor(t), static_cast<float>(kNumJoints - 2));
+        const float w = t - j;
+
+        for (uint32_t segment = 0; segment < kNumSegments; ++segment)
+        {
+            const float angle = 2.0f * 3.14159265f * segment / kNumSegments;
+            const float x     = std::cos(angle);
+            const float z     = std::sin(angle);
+
+            batch.Positions.push_back(glm::vec3(x, y * kNumJoints, z));
+            batch.Normals.push_back(glm::vec3(x, 0, z));
+            batch.Tangents.push_back(glm::vec4(-z, 0, x, 1));
+            batch.Joints.push_back(glm::u16vec4(static_cast<uint16_t>(j), static_cast<uint16_t>(j + 1), 0, 0));
+            batch.Weights.push_back(glm::vec4(1 - w, w, 0, 0));
+        }
+    }
+
+    // Bulge and twist
+    batch.Targets.resize(kNumTargets);
+    for (const auto& position : batch.Positions)
+    {
+        batch.Targets[0].PositionDeltas.push_back(0.25f * glm::vec3(position.x, 0, position.z));
+        batch.Targets[1].PositionDeltas.push_back(glm::vec3(-position.z, 0, position.x) * 0.1f);
+    }
+
+    return batch;
+}
+
+// Each joint bends a little further around Z than its parent
+static std::vector<glm::mat4> CreateJointMatrices(float time)
+{
+    std::vector<glm::mat4> jointMatrices(kNumJoints);
+
+    glm::mat4 world = glm::mat4(1);
+    for (uint32_t i = 0; i < kNumJoints; ++i)
+    {
+        const glm::mat4 bind = glm::translate(glm::vec3(0, static_cast<float>(i), 0));
+
+        world = world * glm::translate(glm::vec3(0, (i > 0) ? 1.0f : 0.0f, 0)) * glm::rotate(0.1f * std::sin(time + i), glm::vec3(0, 0, 1));
+
+        jointMatrices[i] = world * glm::inverse(bind);
+    }
+
+    return jointMatrices;
+}
+
+static void BenchmarkSynthetic()
+{
+    const FauxRender::DeformableBatch batch       = CreateCylinder();
+    const uint64_t                    numVertices = batch.Positions.size();
+
+    const float weights[kNumTargets] = {0.5f, 0.25f};
+
+    std::vector<std::vector<glm::mat4>> poses;
+    for (uint32_t i = 0; i < kNumIterations; ++i)
+    {
+        poses.push_back(CreateJointMatrices(0.1f * i));
+    }
+
+    std::cout << "synthetic cylinder: " << numVertices << " vertices, " << kNumJoints << " joints, " << kNumTargets << " morph targets" << std::endl;
+
+    FauxRender::DeformedVertices vertices = {};
+
+    double skinOnly = TimeBest([&](uint32_t i) {
+        FauxRender::DeformBatch(batch, nullptr, 0, poses[i].data(), kNumJoints, &vertices);
+    });
+    PrintThroughput("skinning", numVertices, skinOnly);
+
+    double morphOnly = TimeBest([&](uint32_t i) {
+        FauxRender::DeformBatch(batch, weights, kNumTargets, nullptr, 0, &vertices);
+    });
+    PrintThroughput("morph targets", numVertices, morphOnly);
+
+    double skinAndMorph = TimeBest([&](uint32_t i) {
+        FauxRender::DeformBatch(batch, weights, kNumTargets, poses[i].data(), kNumJoints, &vertices);
+    });
+    PrintThroughput("morph targets + skinning", numVertices, skinAndMorph);
+}
+
+static bool BenchmarkGLTF(const std::filesystem::path& path)
+{
+    HostFauxRender::SceneGraph graph(false);
+    if (!FauxRender::LoadGLTF(path, {}, &graph))
+    {
+        std::cout << "error: failed to load scene\n   path=" << path << std::endl;
+        return false;
+    }
+
+    std::vector<const FauxRender::SceneNode*> deformedNodes;
+    uint64_t                                  numVertices = 0;
+    for (const auto& node : graph.Nodes)
+    {
+        if (IsNull(node.pMesh) || node.pMesh->DeformableBatches.empty())
+        {
+            continue;
+        }
+
+        deformedNodes.push_back(&node);
+        for (const auto& batch : node.pMesh->DeformableBatches)
+        {
+            numVertices += batch.Positions.size();
+        }
+    }
+
+    std::cout << path.filename().string() << ": " << graph.Animations.size() << " animations, " << graph.Skins.size() << " skins, "
+              << deformedNodes.size() << " deformed nodes, " << numVertices << " vertices" << std::endl;
+
+    if (graph.Animations.empty() || deformedNodes.empty())
+    {
+        return true;
+    }
+
+    const auto& animation = *graph.Animations[0];
+
+    std::vector<glm::mat4>       worldMatrices;
+    FauxRender::DeformedVertices scratch = {};
+
+    bool   res      = true;
+    double timeBest = TimeBest([&](uint32_t i) {
+        const float time = animation.Duration * i / kNumIterations;
+        FauxRender::ApplyAnimation(animation, time, &graph);
+        FauxRender::ComputeWorldMatrices(&graph, &worldMatrices);
+        for (auto pNode : deformedNodes)
+        {
+            res = res && FauxRender::UpdateDeformedMesh(&graph, worldMatrices, pNode, &scratch);
+        }
+    });
+    if (!res)
+    {
+        std::cout << "error: failed to update deformed meshes\n   path=" << path << std::endl;
+        return false;
+    }
+
+    PrintThroughput("animation " + animation.Name, numVertices, timeBest);
+
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    std::cout << "best of " << kNumIterations << " runs, single thread" << std::endl;
+    std::cout << std::endl;
+
+    BenchmarkSynthetic();
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::cout << std::endl;
+        if (!BenchmarkGLTF(argv[i]))
+        {
+            return EXIT_FAILURE;
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,270 @@
+//
+// Renders the scenes of a few of the GPU samples with the software
+// rasterizer and writes them as PNGs, then reports how fast each frame
+// went. No GPU or window is needed, so this gives reference frames on any
+// machine and a number to compare when changing the rasterizer.
+//
+//   color_cube   101_color_cube at -time seconds
+//   cornell_box  102_cornell_box, same shading as its fragment shader
+//   spheres      201_pbr_spheres' 10x10 grid of 131k triangle spheres
+//                with simple diffuse and specular shading instead of the
+//                IBL, to measure geometry throughput (13M triangles)
+//
+// Cameras and transforms are the samples', with the same window size the
+// color cube and cornell box PNGs match the GPU frames.
+//
+
+#include "soft_rasterizer.h"
+#include "window.h"
+
+#include <chrono>
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtx/transform.hpp>
+
+using glm::mat4;
+using glm::vec3;
+using glm::vec4;
+
+// Same clear color as the samples
+const vec4 kClearColor = vec4(0.0f, 0.0f, 0.2f, 1.0f);
+
+struct Scene
+{
+    std::string                          name;
+    std::vector<TriMesh>                 meshes;
+    std::function<void(SoftRasterizer*)> draw;
+    mat4                                 viewProjectionMatrix = mat4(1);
+};
+
+mat4 GetProjectionMatrix(uint32_t width, uint32_t height)
+{
+    return glm::perspective(glm::radians(60.0f), width / static_cast<float>(height), 0.1f, 10000.0f);
+}
+
+// 101_color_cube
+void BuildColorCube(uint32_t width, uint32_t height, float time, Scene* pScene)
+{
+    pScene->name = "color_cube";
+    pScene->meshes.push_back(TriMesh::Cube(vec3(1), false, {.enableVertexColors = true}));
+
+    const mat4 modelMat = glm::rotate(time, vec3(0, 1, 0)) * glm::rotate(time, vec3(1, 0, 0));
+    const mat4 viewMat  = glm::lookAt(vec3(0, 0, 2), vec3(0, 0, 0), vec3(0, 1, 0));
+
+    pScene->viewProjectionMatrix = GetProjectionMatrix(width, height) * viewMat;
+    pScene->draw                 = [pScene, modelMat](SoftRasterizer* pRasterizer) {
+        pRasterizer->Draw(&pScene->meshes[0], modelMat);
+    };
+}
+
+// 102_cornell_box
+void BuildCornellBox(uint32_t width, uint32_t height, Scene* pScene)
+{
+    pScene->name = "cornell_box";
+    pScene->meshes.push_back(TriMesh::CornellBox({.enableVertexColors = true, .enableNormals = true}));
+
+    const TriMesh& mesh = pScene->meshes[0];
+
+    const uint32_t lightGroupIndex = mesh.GetGroupIndex("light");
+    assert((lightGroupIndex != UINT32_MAX) && "group index for 'light' failed");
+
+    const vec3 lightPosition = mesh.GetGroup(lightGroupIndex).GetBounds().Center();
+
+    // The sample draws per material, look the material up per triangle instead
+    auto triangleMaterials = std::make_shared<std::vector<int32_t>>(mesh.GetNumTriangles(), -1);
+    for (auto& group : mesh.GetGroups()) {
+        for (size_t i = 0; i < group.GetTriangleIndices().size(); ++i) {
+            (*triangleMaterials)[group.GetTriangleIndices()[i]] = group.GetMaterialIndices()[i];
+        }
+    }
+
+    const mat4 viewMat = glm::lookAt(vec3(0, 3, 5), vec3(0, 2.8f, 0), vec3(0, 1, 0));
+
+    pScene->viewProjectionMatrix = GetProjectionMatrix(width, height) * viewMat;
+    pScene->draw                 = [pScene, lightPosition, triangleMaterials](SoftRasterizer* pRasterizer) {
+        const TriMesh& mesh = pScene->meshes[0];
+
+        auto shader = [&mesh, lightPosition, triangleMaterials](const SoftRasterizer::Fragment& fragment) {
+            const int32_t materialIndex = (*triangleMaterials)[fragment.TriangleIndex];
+            if (materialIndex < 0) {
+                return vec4(fragment.Color, 1);
+            }
+
+            const TriMesh::Material& material = mesh.GetMaterial(materialIndex);
+
+            const vec3  lightDir = glm::normalize(lightPosition - fragment.Position);
+            const float diffuse  = 0.7f * glm::clamp(glm::dot(lightDir, fragment.Normal), 0.0f, 1.0f);
+
+            vec3 color = material.baseColor;
+            if (material.name != "white light") {
+                color = (0.3f + diffuse) * material.baseColor;
+            }
+            return vec4(color, 1);
+        };
+
+        pRasterizer->Draw(&mesh, mat4(1), shader);
+    };
+}
+
+// 201_pbr_spheres
+void BuildSpheres(uint32_t width, uint32_t height, Scene* pScene)
+{
+    pScene->name = "spheres";
+    pScene->meshes.push_back(TriMesh::Sphere(0.42f, 256, 256, {.enableNormals = true}));
+
+    const vec3 eyePosition = vec3(0, 0, 9);
+    const mat4 viewMat     = glm::lookAt(eyePosition, vec3(0, 0, 0), vec3(0, 1, 0));
+
+    pScene->viewProjectionMatrix = GetProjectionMatrix(width, height) * viewMat;
+    pScene->draw                 = [pScene, eyePosition](SoftRasterizer* pRasterizer) {
+        const uint32_t numSlotsX = 10;
+        const uint32_t numSlotsY = 10;
+        const float    slotSize  = 0.9f;
+        const float    halfSpanX = numSlotsX * slotSize / 2.0f;
+        const float    halfSpanY = numSlotsY * slotSize / 2.0f;
+
+        for (uint32_t i = 0; i < numSlotsY; ++i) {
+            for (uint32_t j = 0; j < numSlotsX; ++j) {
+                const float x = -halfSpanX + j * slotSize + slotSize / 2.0f;
+                const float y = -halfSpanY + i * slotSize + slotSize / 2.0f;
+
+                // Roughness goes up the rows, metallic across, like the sample
+                const float roughness = i / static_cast<float>(numSlotsY - 1);
+                const float metallic  = j / static_cast<float>(numSlotsX - 1);
+                const vec3  baseColor = glm::mix(vec3(0.8f), vec3(1.0f, 0.78f, 0.34f), metallic);
+                const float power     = 2.0f + 254.0f * (1.0f - roughness) * (1.0f - roughness);
+
+                auto shader = [eyePosition, baseColor, metallic, power](const SoftRasterizer::Fragment& fragment) {
+                    const vec3 lightDir = glm::normalize(vec3(1, 1, 1));
+                    const vec3 viewDir  = glm::normalize(eyePosition - fragment.Position);
+                    const vec3 halfDir  = glm::normalize(lightDir + viewDir);
+
+                    const float diffuse  = std::max(glm::dot(fragment.Normal, lightDir), 0.0f);
+                    const float specular = std::pow(std::max(glm::dot(fragment.Normal, halfDir), 0.0f), power);
+
+                    const vec3 color = (0.1f + (1.0f - metallic) * diffuse) * baseColor + specular * glm::mix(vec3(0.04f), baseColor, metallic);
+                    return vec4(color, 1);
+                };
+
+                pRasterizer->Draw(&pScene->meshes[0], glm::translate(vec3(x, y, 0)), shader);
+            }
+        }
+    };
+}
+
+int main(int argc, char** argv)
+{
+    std::string           sceneName  = "all";
+    std::filesystem::path outputBase = "soft_raster";
+    uint32_t              width      = 1280;
+    uint32_t              height     = 720;
+    uint32_t              numFrames  = 10;
+    float                 time       = 1.0f;
+
+    SoftRasterizer::Options options = {};
+
+    std::string badOption = "";
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if ((arg == "-scene") || (arg == "-w") || (arg == "-h") || (arg == "-frames") || (arg == "-threads") ||
+            (arg == "-time") || (arg == "-o")) {
+            ++i;
+            if (i >= argc) {
+                badOption = arg;
+                break;
+            }
+        }
+
+        if (arg == "-scene") {
+            sceneName = argv[i];
+        }
+        else if (arg == "-w") {
+            width = static_cast<uint32_t>(std::max(atoi(argv[i]), 1));
+        }
+        else if (arg == "-h") {
+            height = static_cast<uint32_t>(std::max(atoi(argv[i]), 1));
+        }
+        else if (arg == "-frames") {
+            numFrames = static_cast<uint32_t>(std::max(atoi(argv[i]), 1));
+        }
+        else if (arg == "-threads") {
+            options.NumThreads = static_cast<uint32_t>(std::max(atoi(argv[i]), 0));
+        }
+        else if (arg == "-time") {
+            time = static_cast<float>(atof(argv[i]));
+        }
+        else if (arg == "-o") {
+            outputBase = argv[i];
+        }
+        else {
+            std::cout << "error: unrecognized arg " << arg << std::endl;
+            std::cout << "   "
+                      << "soft_raster [-scene <all|color_cube|cornell_box|spheres>] [-w <width>] [-h <height>]" << std::endl;
+            std::cout << "   "
+                      << "            [-frames <n>] [-threads <n>] [-time <seconds>] [-o <output path without extension>]" << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+    if (!badOption.empty()) {
+        std::cout << "error: missing arg for option " << badOption << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // Scenes point into themselves, don't let them move
+    std::vector<std::unique_ptr<Scene>> scenes;
+    if ((sceneName == "all") || (sceneName == "color_cube")) {
+        scenes.push_back(std::make_unique<Scene>());
+        BuildColorCube(width, height, time, scenes.back().get());
+    }
+    if ((sceneName == "all") || (sceneName == "cornell_box")) {
+        scenes.push_back(std::make_unique<Scene>());
+        BuildCornellBox(width, height, scenes.back().get());
+    }
+    if ((sceneName == "all") || (sceneName == "spheres")) {
+        scenes.push_back(std::make_unique<Scene>());
+        BuildSpheres(width, height, scenes.back().get());
+    }
+    if (scenes.empty()) {
+        std::cout << "error: unknown scene " << sceneName << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    SoftRasterizer              rasterizer;
+    SoftRasterizer::Framebuffer framebuffer;
+    framebuffer.Resize(width, height);
+
+    for (auto& scene : scenes) {
+        // Frame times include the clear, same as a GPU frame would
+        double                totalMs = 0;
+        SoftRasterizer::Stats stats   = {};
+        for (uint32_t frame = 0; frame < numFrames; ++frame) {
+            auto clearStart = std::chrono::high_resolution_clock::now();
+            framebuffer.Clear(kClearColor);
+            auto clearEnd = std::chrono::high_resolution_clock::now();
+
+            scene->draw(&rasterizer);
+            stats = rasterizer.Render(scene->viewProjectionMatrix, options, &framebuffer);
+
+            totalMs += std::chrono::duration<double, std::milli>(clearEnd - clearStart).count() + stats.ElapsedMs;
+        }
+
+        const double frameMs = totalMs / numFrames;
+        std::cout << scene->name << ": " << stats.NumTriangles << " triangles, " << stats.NumSetupTriangles << " after culling"
+                  << ", " << stats.NumFragments << " fragments shaded" << std::endl;
+        std::cout << "   " << frameMs << " ms/frame over " << numFrames << " frames"
+                  << ", " << (stats.NumTriangles / (frameMs / 1000.0) / 1e6) << " Mtris/s"
+                  << ", " << stats.NumThreads << " threads" << std::endl;
+
+        BitmapRGBA8u bitmap = framebuffer.ToBitmap();
+
+        auto pngPath = std::filesystem::path(outputBase);
+        pngPath.replace_filename(pngPath.stem().string() + "_" + scene->name + ".png");
+        if (!BitmapRGBA8u::Save(pngPath, &bitmap)) {
+            std::cout << "error: failed to write " << pngPath << std::endl;
+            return EXIT_FAILURE;
+        }
+        std::cout << "   Wrote " << pngPath << std::endl;
+    }
+
+    return EXIT_SUCCESS;
+}
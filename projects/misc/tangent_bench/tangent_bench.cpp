@@ -0,0 +1,146 @@
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "tri_mesh.h"
+#include "host_faux_render.h"
+#include "window.h"
+
+//
+// Times MikkTSpace tangent generation on a single thread against all
+// hardware threads, for TriMesh::GenerateTangents() and for the tangents
+// LoadGLTF() synthesizes for primitives without a TANGENT attribute.
+//
+// usage: tangent_bench [mesh.obj] [scene.gltf ...]
+//
+
+const uint32_t kNumIterations = 5;
+
+// Returns the fastest of kNumIterations runs in milliseconds
+template <typename Fn>
+static double TimeBest(Fn fn)
+{
+    double best = std::numeric_limits<double>::max();
+    for (uint32_t i = 0; i < kNumIterations; ++i)
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        if (!fn())
+        {
+            return -1.0;
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+
+        best = std::min(best, std::chrono::duration<double, std::milli>(end - start).count());
+    }
+    return best;
+}
+
+static void PrintTimes(const std::string& name, double singleThreaded, double multiThreaded)
+{
+    std::cout << "  " << std::left << std::setw(40) << name << std::right << std::fixed << std::setprecision(2)
+              << std::setw(10) << singleThreaded << " ms"
+              << std::setw(10) << multiThreaded << " ms"
+              << std::setw(8) << (singleThreaded / std::max(multiThreaded, 0.001)) << "x" << std::endl;
+}
+
+static bool BenchmarkOBJ(const std::filesystem::path& path)
+{
+    TriMesh::Options options = {};
+    options.enableTexCoords  = true;
+    options.enableNormals    = true;
+    options.enableTangents   = true;
+
+    TriMesh mesh = {};
+    if (!TriMesh::LoadOBJ(path.string(), "", options, &mesh))
+    {
+        std::cout << "error: failed to load mesh\n   path=" << path << std::endl;
+        return false;
+    }
+
+    std::cout << path.filename().string() << ": " << mesh.GetNumTriangles() << " triangles, " << mesh.GetNumGroups() << " groups" << std::endl;
+
+    double singleThreaded = TimeBest([&]() { mesh.GenerateTangents(1); return true; });
+    double multiThreaded  = TimeBest([&]() { mesh.GenerateTangents(0); return true; });
+    PrintTimes("TriMesh::GenerateTangents", singleThreaded, multiThreaded);
+
+    return true;
+}
+
+static bool BenchmarkGLTF(const std::filesystem::path& path)
+{
+    auto load = [&](bool generateTangents, uint32_t numThreads) {
+        FauxRender::LoadOptions loadOptions = {};
+        loadOptions.GenerateMissingTangents = generateTangents;
+        loadOptions.NumTangentThreads       = numThreads;
+
+        HostFauxRender::SceneGraph graph(false);
+        return FauxRender::LoadGLTF(path, loadOptions, &graph);
+    };
+
+    // Image decoding dominates load times, the difference to a load
+    // without generation is what the tangents cost.
+    double baseline       = TimeBest([&]() { return load(false, 0); });
+    double singleThreaded = TimeBest([&]() { return load(true, 1); });
+    double multiThreaded  = TimeBest([&]() { return load(true, 0); });
+    if ((baseline < 0) || (singleThreaded < 0) || (multiThreaded < 0))
+    {
+        std::cout << "error: failed to load scene\n   path=" << path << std::endl;
+        return false;
+    }
+
+    std::cout << path.filename().string() << ": load without generation " << std::fixed << std::setprecision(2) << baseline << " ms" << std::endl;
+    PrintTimes("LoadGLTF tangent generation", std::max(singleThreaded - baseline, 0.0), std::max(multiThreaded - baseline, 0.0));
+
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    std::filesystem::path              objPath   = GetAssetPath("models/material_knob.obj");
+    std::vector<std::filesystem::path> gltfPaths = {
+        GetAssetPath("scenes/basic_geo.gltf"),
+        GetAssetPath("scenes/basic_texture.gltf"),
+        GetAssetPath("scenes/cornell_box.gltf"),
+        GetAssetPath("scenes/material_test_001_png/material_test_001.gltf"),
+        GetAssetPath("scenes/treasure_box_png/treasure_box.gltf"),
+    };
+
+    if (argc > 1)
+    {
+        objPath = argv[1];
+    }
+    if (argc > 2)
+    {
+        gltfPaths.clear();
+        for (int i = 2; i < argc; ++i)
+        {
+            gltfPaths.push_back(argv[i]);
+        }
+    }
+
+    std::cout << "hardware threads: " << std::thread::hardware_concurrency() << std::endl;
+    std::cout << "best of " << kNumIterations << " runs, 1 thread vs all threads" << std::endl;
+    std::cout << std::endl;
+
+    if (!BenchmarkOBJ(objPath))
+    {
+        return EXIT_FAILURE;
+    }
+    std::cout << std::endl;
+
+    for (auto& gltfPath : gltfPaths)
+    {
+        if (!BenchmarkGLTF(gltfPath))
+        {
+            return EXIT_FAILURE;
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,334 @@
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <thread>
+
+#include "vk_renderer.h"
+
+//
+// Uploads the same set of buffers and textures two ways and checks the
+// results by reading everything back:
+//
+//   per-resource - CreateBuffer()/CreateTexture() one at a time, each
+//                  with its own staging buffer, submit and wait
+//   batched      - one VulkanUploadBatch, submitted once and polled with
+//                  IsUploadBatchComplete() before waiting on it
+//
+// usage: upload_batch_bench [num buffers] [num textures]
+//
+// Needs no window or display, so it runs on Mesa's lavapipe:
+//   VK_ICD_FILENAMES=/usr/share/vulkan/icd.d/lvp_icd.x86_64.json upload_batch_bench
+//
+
+struct UploadSet
+{
+    std::vector<std::vector<uint8_t>> BufferData;
+    std::vector<std::vector<uint8_t>> TextureData;
+    std::vector<uint32_t>             TextureSizes;
+};
+
+struct UploadResources
+{
+    std::vector<VulkanBuffer> Buffers;
+    std::vector<VulkanImage>  Textures;
+};
+
+static const VkBufferUsageFlags kBufferUsage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+
+static UploadSet GenerateUploads(uint32_t numBuffers, uint32_t numTextures)
+{
+    std::mt19937                            rng(0x5EED);
+    std::uniform_int_distribution<uint32_t> bufferSizeDist(1, 256);
+    std::uniform_int_distribution<uint32_t> byteDist(0, 255);
+
+    UploadSet set = {};
+
+    // 4KB to 1MB, about what a glTF scene's vertex and index buffers are
+    for (uint32_t i = 0; i < numBuffers; ++i) {
+        std::vector<uint8_t> data(bufferSizeDist(rng) * 4096);
+        for (auto& value : data) {
+            value = static_cast<uint8_t>(byteDist(rng));
+        }
+        set.BufferData.push_back(std::move(data));
+    }
+
+    for (uint32_t i = 0; i < numTextures; ++i) {
+        const uint32_t size = 64u << (i % 4); // 64 to 512
+
+        std::vector<uint8_t> data(size * size * 4);
+        for (auto& value : data) {
+            value = static_cast<uint8_t>(byteDist(rng));
+        }
+        set.TextureData.push_back(std::move(data));
+        set.TextureSizes.push_back(size);
+    }
+
+    return set;
+}
+
+static bool UploadPerResource(VulkanRenderer* pRenderer, const UploadSet& set, UploadResources* pResources, double* pMilliseconds)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+
+    for (const auto& data : set.BufferData) {
+        VulkanBuffer buffer = {};
+        VkResult     vkres  = CreateBuffer(pRenderer, data.size(), data.data(), kBufferUsage, VMA_MEMORY_USAGE_GPU_ONLY, 0, &buffer);
+        if (vkres != VK_SUCCESS) {
+            std::cout << "error: CreateBuffer failed" << std::endl;
+            return false;
+        }
+        pResources->Buffers.push_back(buffer);
+    }
+
+    for (size_t i = 0; i < set.TextureData.size(); ++i) {
+        const uint32_t size    = set.TextureSizes[i];
+        VulkanImage    texture = {};
+        VkResult       vkres   = CreateTexture(pRenderer, size, size, VK_FORMAT_R8G8B8A8_UNORM, set.TextureData[i].size(), set.TextureData[i].data(), &texture);
+        if (vkres != VK_SUCCESS) {
+            std::cout << "error: CreateTexture failed" << std::endl;
+            return false;
+        }
+        pResources->Textures.push_back(texture);
+    }
+
+    auto end       = std::chrono::high_resolution_clock::now();
+    *pMilliseconds = std::chrono::duration<double, std::milli>(end - start).count();
+
+    return true;
+}
+
+static bool UploadBatched(VulkanRenderer* pRenderer, const UploadSet& set, UploadResources* pResources, double* pMilliseconds, uint32_t* pNumPolls)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+
+    VulkanUploadBatch batch = {};
+    VkResult          vkres = CreateUploadBatch(pRenderer, GREX_DEFAULT_UPLOAD_CHUNK_SIZE, &batch);
+    if (vkres != VK_SUCCESS) {
+        std::cout << "error: CreateUploadBatch failed" << std::endl;
+        return false;
+    }
+
+    for (const auto& data : set.BufferData) {
+        VulkanBuffer buffer = {};
+        vkres               = CreateBuffer(&batch, data.size(), data.data(), kBufferUsage, VMA_MEMORY_USAGE_GPU_ONLY, 0, &buffer);
+        if (vkres != VK_SUCCESS) {
+            std::cout << "error: CreateBuffer failed" << std::endl;
+            DestroyUploadBatch(&batch);
+            return false;
+        }
+        pResources->Buffers.push_back(buffer);
+    }
+
+    for (size_t i = 0; i < set.TextureData.size(); ++i) {
+        const uint32_t size = set.TextureSizes[i];
+
+        MipOffset mipOffset = {};
+        mipOffset.Offset    = 0;
+        mipOffset.RowStride = size * 4;
+
+        VulkanImage texture = {};
+        vkres               = CreateTexture(&batch, size, size, VK_FORMAT_R8G8B8A8_UNORM, {mipOffset}, set.TextureData[i].size(), set.TextureData[i].data(), &texture);
+        if (vkres != VK_SUCCESS) {
+            std::cout << "error: CreateTexture failed" << std::endl;
+            DestroyUploadBatch(&batch);
+            return false;
+        }
+        pResources->Textures.push_back(texture);
+    }
+
+    vkres = SubmitUploadBatch(&batch);
+    if (vkres != VK_SUCCESS) {
+        std::cout << "error: SubmitUploadBatch failed" << std::endl;
+        DestroyUploadBatch(&batch);
+        return false;
+    }
+
+    // A loader would do other work here
+    *pNumPolls = 0;
+    while (!IsUploadBatchComplete(&batch)) {
+        *pNumPolls += 1;
+        std::this_thread::yield();
+    }
+
+    vkres = WaitUploadBatch(&batch);
+    DestroyUploadBatch(&batch);
+    if (vkres != VK_SUCCESS) {
+        std::cout << "error: WaitUploadBatch failed" << std::endl;
+        return false;
+    }
+
+    auto end       = std::chrono::high_resolution_clock::now();
+    *pMilliseconds = std::chrono::duration<double, std::milli>(end - start).count();
+
+    return true;
+}
+
+// Copies every resource into one readback buffer and compares it with the source data
+static bool Verify(VulkanRenderer* pRenderer, const UploadSet& set, const UploadResources& resources)
+{
+    VkDeviceSize totalSize = 0;
+    for (const auto& data : set.BufferData) {
+        totalSize += data.size();
+    }
+    for (const auto& data : set.TextureData) {
+        totalSize += data.size();
+    }
+
+    VulkanBuffer readbackBuffer = {};
+    VkResult     vkres          = CreateBuffer(pRenderer, static_cast<size_t>(totalSize), VK_BUFFER_USAGE_TRANSFER_DST_BIT, VMA_MEMORY_USAGE_GPU_TO_CPU, 0, &readbackBuffer);
+    if (vkres != VK_SUCCESS) {
+        std::cout << "error: create readback buffer failed" << std::endl;
+        return false;
+    }
+
+    // The batch's command buffer is used to record the readback copies
+    VulkanUploadBatch batch = {};
+    vkres                   = CreateUploadBatch(pRenderer, 0, &batch);
+    if (vkres != VK_SUCCESS) {
+        DestroyBuffer(pRenderer, &readbackBuffer);
+        return false;
+    }
+
+    VkDeviceSize offset = 0;
+    for (size_t i = 0; i < resources.Buffers.size(); ++i) {
+        VkBufferCopy region = {};
+        region.srcOffset    = 0;
+        region.dstOffset    = offset;
+        region.size         = set.BufferData[i].size();
+
+        vkCmdCopyBuffer(batch.CmdBuf.CommandBuffer, resources.Buffers[i].Buffer, readbackBuffer.Buffer, 1, &region);
+        offset += region.size;
+    }
+
+    for (size_t i = 0; i < resources.Textures.size(); ++i) {
+        const uint32_t size = set.TextureSizes[i];
+
+        CmdTransitionImageLayout(
+            batch.CmdBuf.CommandBuffer,
+            resources.Textures[i].Image,
+            GREX_ALL_SUBRESOURCES,
+            VK_IMAGE_ASPECT_COLOR_BIT,
+            RESOURCE_STATE_COMPUTE_SHADER_RESOURCE,
+            RESOURCE_STATE_TRANSFER_SRC);
+
+        VkBufferImageCopy region           = {};
+        region.bufferOffset                = offset;
+        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.imageSubresource.layerCount = 1;
+        region.imageExtent.width           = size;
+        region.imageExtent.height          = size;
+        region.imageExtent.depth           = 1;
+
+        vkCmdCopyImageToBuffer(batch.CmdBuf.CommandBuffer, resources.Textures[i].Image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, readbackBuffer.Buffer, 1, &region);
+        offset += set.TextureData[i].size();
+    }
+
+    vkres = SubmitUploadBatch(&batch);
+    if (vkres == VK_SUCCESS) {
+        vkres = WaitUploadBatch(&batch);
+    }
+    DestroyUploadBatch(&batch);
+
+    bool match = (vkres == VK_SUCCESS);
+    if (match) {
+        uint8_t* pData = nullptr;
+        vkres          = vmaMapMemory(pRenderer->Allocator, readbackBuffer.Allocation, reinterpret_cast<void**>(&pData));
+        if (vkres != VK_SUCCESS) {
+            std::cout << "error: map readback buffer failed" << std::endl;
+            match = false;
+        }
+        else {
+            vmaInvalidateAllocation(pRenderer->Allocator, readbackBuffer.Allocation, 0, VK_WHOLE_SIZE);
+
+            offset = 0;
+            for (size_t i = 0; match && (i < set.BufferData.size()); ++i) {
+                if (memcmp(pData + offset, set.BufferData[i].data(), set.BufferData[i].size()) != 0) {
+                    std::cout << "error: buffer " << i << " mismatch" << std::endl;
+                    match = false;
+                }
+                offset += set.BufferData[i].size();
+            }
+            for (size_t i = 0; match && (i < set.TextureData.size()); ++i) {
+                if (memcmp(pData + offset, set.TextureData[i].data(), set.TextureData[i].size()) != 0) {
+                    std::cout << "error: texture " << i << " mismatch" << std::endl;
+                    match = false;
+                }
+                offset += set.TextureData[i].size();
+            }
+
+            vmaUnmapMemory(pRenderer->Allocator, readbackBuffer.Allocation);
+        }
+    }
+
+    DestroyBuffer(pRenderer, &readbackBuffer);
+
+    return match;
+}
+
+static void DestroyResources(VulkanRenderer* pRenderer, UploadResources* pResources)
+{
+    for (auto& buffer : pResources->Buffers) {
+        DestroyBuffer(pRenderer, &buffer);
+    }
+    for (auto& texture : pResources->Textures) {
+        vmaDestroyImage(pRenderer->Allocator, texture.Image, texture.Allocation);
+    }
+    *pResources = {};
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t numBuffers  = 512;
+    uint32_t numTextures = 64;
+    if (argc > 1) {
+        numBuffers = static_cast<uint32_t>(std::max(atoi(argv[1]), 0));
+    }
+    if (argc > 2) {
+        numTextures = static_cast<uint32_t>(std::max(atoi(argv[2]), 0));
+    }
+
+    std::unique_ptr<VulkanRenderer> renderer = std::make_unique<VulkanRenderer>();
+    if (!InitVulkan(renderer.get(), false, {})) {
+        std::cout << "error: InitVulkan failed" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    UploadSet set = GenerateUploads(numBuffers, numTextures);
+
+    uint64_t totalBytes = 0;
+    for (const auto& data : set.BufferData) {
+        totalBytes += data.size();
+    }
+    for (const auto& data : set.TextureData) {
+        totalBytes += data.size();
+    }
+
+    std::cout << numBuffers << " buffers, " << numTextures << " textures, " << (totalBytes / (1024 * 1024)) << " MB" << std::endl;
+
+    UploadResources resources       = {};
+    double          perResourceMs   = 0;
+    bool            perResourceGood = UploadPerResource(renderer.get(), set, &resources, &perResourceMs) &&
+                                      Verify(renderer.get(), set, resources);
+    DestroyResources(renderer.get(), &resources);
+    if (!perResourceGood) {
+        return EXIT_FAILURE;
+    }
+
+    double   batchedMs   = 0;
+    uint32_t numPolls    = 0;
+    bool     batchedGood = UploadBatched(renderer.get(), set, &resources, &batchedMs, &numPolls) &&
+                           Verify(renderer.get(), set, resources);
+    DestroyResources(renderer.get(), &resources);
+    if (!batchedGood) {
+        return EXIT_FAILURE;
+    }
+
+    std::cout << "  per-resource " << std::fixed << std::setprecision(2) << std::setw(10) << perResourceMs << " ms" << std::endl;
+    std::cout << "  batched      " << std::fixed << std::setprecision(2) << std::setw(10) << batchedMs << " ms"
+              << " (" << numPolls << " polls before completion)" << std::endl;
+    std::cout << "  speedup      " << std::fixed << std::setprecision(1) << (perResourceMs / std::max(batchedMs, 0.001)) << "x" << std::endl;
+    std::cout << "  readback matched source data" << std::endl;
+
+    return EXIT_SUCCESS;
+}
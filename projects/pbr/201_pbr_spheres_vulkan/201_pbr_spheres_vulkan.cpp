@@ -107,7 +107,6 @@ void WritePBRDescriptors(
    VulkanRenderer*         pRenderer,
    VkDescriptorSetLayout   descriptorSetLayout,
    VulkanBuffer*           pDescriptorBuffer,
-   const VulkanBuffer*     pSceneParamsBuffer,
    const VulkanImage*      pBRDFLUT,
    const VulkanImage*      pIrradianceTexture,
    const VulkanImage*      pEnvTexture);
@@ -291,19 +290,6 @@ int main(int argc, char** argv)
         "vsmain",
         "psmain"));
 
-    // *************************************************************************
-    // Scene Params Buffer
-    // *************************************************************************
-    VulkanBuffer pbrSceneParamsBuffer;
-    CHECK_CALL(CreateBuffer(
-       renderer.get(),
-       Align<size_t>(sizeof(PBRSceneParameters), 256),
-       nullptr,
-       VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
-       VMA_MEMORY_USAGE_CPU_TO_GPU,
-       0,
-       &pbrSceneParamsBuffer));
-
     // *************************************************************************
     // Material sphere vertex buffers
     // *************************************************************************
@@ -351,11 +337,21 @@ int main(int argc, char** argv)
        renderer.get(),
        pbrPipelineLayout.DescriptorSetLayout,
        &pbrDescriptorBuffer,
-       &pbrSceneParamsBuffer,
        &brdfLUT,
        &irrTexture,
        &envTexture);
 
+    // The scene params (b0) change every frame and live in the frame
+    // context's constant ring. Each frame copies these descriptors into the
+    // descriptor ring and points b0 at its own scene params.
+    std::vector<char> pbrDescriptorTemplate(static_cast<size_t>(pbrDescriptorBuffer.Size));
+    {
+       void* pData = nullptr;
+       CHECK_CALL(vmaMapMemory(renderer->Allocator, pbrDescriptorBuffer.Allocation, &pData));
+       memcpy(pbrDescriptorTemplate.data(), pData, pbrDescriptorTemplate.size());
+       vmaUnmapMemory(renderer->Allocator, pbrDescriptorBuffer.Allocation);
+    }
+
     VulkanBuffer envDescriptorBuffer = {};
     CreateDescriptorBuffer(renderer.get(), envPipelineLayout.DescriptorSetLayout, &envDescriptorBuffer);
 
@@ -457,18 +453,15 @@ int main(int argc, char** argv)
     }
 
     // *************************************************************************
-    // Command buffer
+    // Frame context
     // *************************************************************************
-    CommandObjects cmdBuf = {};
-    {
-       CHECK_CALL(CreateCommandBuffer(renderer.get(), 0, &cmdBuf));
-    }
-
-    // *************************************************************************
-    // Persistent map scene parameters
-    // *************************************************************************
-    PBRSceneParameters* pPBRSceneParams = nullptr;
-    vmaMapMemory(renderer->Allocator, pbrSceneParamsBuffer.Allocation, reinterpret_cast<void**>(&pPBRSceneParams));
+    VulkanFrameContext frameCtx = {};
+    CHECK_CALL(CreateFrameContext(
+       renderer.get(),
+       GREX_DEFAULT_FRAMES_IN_FLIGHT,
+       GREX_DEFAULT_FRAMES_IN_FLIGHT * Align<VkDeviceSize>(sizeof(PBRSceneParameters), 256),
+       GREX_DEFAULT_FRAMES_IN_FLIGHT * Align<VkDeviceSize>(pbrDescriptorTemplate.size(), 256),
+       &frameCtx));
 
     // *************************************************************************
     // Main loop
@@ -493,10 +486,11 @@ int main(int argc, char** argv)
           break;
        }
 
-       VkCommandBufferBeginInfo vkbi = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
-       vkbi.flags                    = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+       // Waits for the GPU to finish the frame that last used this slot
+       VulkanFrame* pFrame = nullptr;
+       CHECK_CALL(BeginFrame(&frameCtx, &pFrame));
 
-       CHECK_CALL(vkBeginCommandBuffer(cmdBuf.CommandBuffer, &vkbi));
+       CommandObjects& cmdBuf = pFrame->CmdBuf;
 
        {
           CmdTransitionImageLayout(
@@ -547,6 +541,13 @@ int main(int argc, char** argv)
           mat4 rotMat      = glm::rotate(glm::radians(gAngle), vec3(0, 1, 0));
 
           // Set constant buffer values
+          VulkanRingAllocation sceneParamsAlloc = {};
+          if (!AllocateFrameConstants(&frameCtx, sizeof(PBRSceneParameters), &sceneParamsAlloc)) {
+             assert(false && "AllocateFrameConstants failed");
+             break;
+          }
+
+          PBRSceneParameters* pPBRSceneParams = static_cast<PBRSceneParameters*>(sceneParamsAlloc.pData);
           pPBRSceneParams->viewProjectionMatrix    = projMat * viewMat;
           pPBRSceneParams->eyePosition             = eyePosition;
           pPBRSceneParams->numLights               = gNumLights;
@@ -564,6 +565,25 @@ int main(int argc, char** argv)
           pPBRSceneParams->lights[3].intensity     = 0.5f;
           pPBRSceneParams->iblEnvironmentNumLevels = envNumLevels;
 
+          VulkanRingAllocation pbrDescriptorAlloc = {};
+          if (!AllocateFrameDescriptors(&frameCtx, pbrDescriptorTemplate.size(), &pbrDescriptorAlloc)) {
+             assert(false && "AllocateFrameDescriptors failed");
+             break;
+          }
+
+          memcpy(pbrDescriptorAlloc.pData, pbrDescriptorTemplate.data(), pbrDescriptorTemplate.size());
+
+          // ConstantBuffer<SceneParameters>    SceneParams           : register(b0);
+          WriteDescriptor(
+             renderer.get(),
+             pbrDescriptorAlloc.pData,
+             pbrPipelineLayout.DescriptorSetLayout,
+             0, // binding
+             0, // arrayElement
+             VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+             sceneParamsAlloc.Address,
+             sceneParamsAlloc.Size);
+
           // Draw environment
           {
              VkDescriptorBufferBindingInfoEXT descriptorBufferBindingInfo = { VK_STRUCTURE_TYPE_DESCRIPTOR_BUFFER_BINDING_INFO_EXT };
@@ -607,12 +627,12 @@ int main(int argc, char** argv)
           {
              VkDescriptorBufferBindingInfoEXT descriptorBufferBindingInfo = { VK_STRUCTURE_TYPE_DESCRIPTOR_BUFFER_BINDING_INFO_EXT };
              descriptorBufferBindingInfo.pNext                            = nullptr;
-             descriptorBufferBindingInfo.address                          = GetDeviceAddress(renderer.get(), &pbrDescriptorBuffer);
+             descriptorBufferBindingInfo.address                          = frameCtx.DescriptorRing.BaseAddress;
              descriptorBufferBindingInfo.usage                            = VK_BUFFER_USAGE_RESOURCE_DESCRIPTOR_BUFFER_BIT_EXT;
              fn_vkCmdBindDescriptorBuffersEXT(cmdBuf.CommandBuffer, 1, &descriptorBufferBindingInfo);
 
              uint32_t     bufferIndices           = 0;
-             VkDeviceSize descriptorBufferOffsets = 0;
+             VkDeviceSize descriptorBufferOffsets = pbrDescriptorAlloc.Offset;
              fn_vkCmdSetDescriptorBufferOffsetsEXT(
                 cmdBuf.CommandBuffer,
                 VK_PIPELINE_BIND_POINT_GRAPHICS,
@@ -704,24 +724,19 @@ int main(int argc, char** argv)
              RESOURCE_STATE_PRESENT);
        }
 
-      CHECK_CALL(vkEndCommandBuffer(cmdBuf.CommandBuffer));
-
-      // Execute command buffer
-      CHECK_CALL(ExecuteCommandBuffer(renderer.get(), &cmdBuf));
-
-      // Wait for the GPU to finish the work
-      if (!WaitForGpu(renderer.get())) {
-         assert(false && "WaitForGpu failed");
-         break;
-      }
+      // Submit without waiting, the next frame records while the GPU works on this one
+      CHECK_CALL(EndFrame(&frameCtx, bufferIndex));
 
       // Present
-      if (!SwapchainPresent(renderer.get(), bufferIndex)) {
+      if (!SwapchainPresent(renderer.get(), bufferIndex, pFrame->RenderCompleteSemaphore)) {
          assert(false && "SwapchainPresent failed");
          break;
       }
     }
 
+    WaitFrameContext(&frameCtx);
+    DestroyFrameContext(&frameCtx);
+
     return 0;
 }
 
@@ -1051,7 +1066,6 @@ void WritePBRDescriptors(
    VulkanRenderer*         pRenderer,
    VkDescriptorSetLayout   descriptorSetLayout,
    VulkanBuffer*           pDescriptorBuffer,
-   const VulkanBuffer*     pSceneParamsBuffer,
    const VulkanImage*      pBRDFLUT,
    const VulkanImage*      pIrradianceTexture,
    const VulkanImage*      pEnvTexture)
@@ -1063,14 +1077,7 @@ void WritePBRDescriptors(
       reinterpret_cast<void**>(&pDescriptorBufferStartAddress)));
 
    // ConstantBuffer<SceneParameters>    SceneParams           : register(b0);
-   WriteDescriptor(
-      pRenderer,
-      pDescriptorBufferStartAddress,
-      descriptorSetLayout,
-      0, // binding
-      0, // arrayElement
-      VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
-      pSceneParamsBuffer);
+   // Written per frame
 
    // Set via push constants
    // ConstantBuffer<DrawParameters>     DrawParams            : register(b1);
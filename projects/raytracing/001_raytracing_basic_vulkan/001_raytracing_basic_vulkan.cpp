@@ -164,36 +164,32 @@ int main(int argc, char** argv)
     std::vector<uint32_t> spirvMISS;
     std::vector<uint32_t> spirvCHIT;
     {
-        std::string   errorMsg;
-        CompileResult res = CompileGLSL(gShaderRGEN, VK_SHADER_STAGE_RAYGEN_BIT_KHR, {}, &spirvRGEN, &errorMsg);
-        if (res != COMPILE_SUCCESS)
-        {
-            std::stringstream ss;
-            ss << "\n"
-               << "Shader compiler error (RGEN): " << errorMsg << "\n";
-            GREX_LOG_ERROR(ss.str().c_str());
-            return EXIT_FAILURE;
-        }
+        const char* kStageNames[] = {"RGEN", "MISS", "CHIT"};
 
-        res = CompileGLSL(gShaderMISS, VK_SHADER_STAGE_MISS_BIT_KHR, {}, &spirvMISS, &errorMsg);
-        if (res != COMPILE_SUCCESS)
-        {
-            std::stringstream ss;
-            ss << "\n"
-               << "Shader compiler error (MISS): " << errorMsg << "\n";
-            GREX_LOG_ERROR(ss.str().c_str());
-            return EXIT_FAILURE;
-        }
+        std::vector<VulkanShaderCompileJob> jobs = {
+            {SHADER_LANGUAGE_GLSL, gShaderRGEN, VK_SHADER_STAGE_RAYGEN_BIT_KHR},
+            {SHADER_LANGUAGE_GLSL, gShaderMISS, VK_SHADER_STAGE_MISS_BIT_KHR},
+            {SHADER_LANGUAGE_GLSL, gShaderCHIT, VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR},
+        };
 
-        res = CompileGLSL(gShaderCHIT, VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR, {}, &spirvCHIT, &errorMsg);
-        if (res != COMPILE_SUCCESS)
+        std::vector<VulkanShaderCompileResult> results;
+        CompileShaders(jobs, &results);
+        for (size_t i = 0; i < results.size(); ++i)
         {
-            std::stringstream ss;
-            ss << "\n"
-               << "Shader compiler error (CHIT): " << errorMsg << "\n";
-            GREX_LOG_ERROR(ss.str().c_str());
-            return EXIT_FAILURE;
+            if (!results[i].Success)
+            {
+                std::stringstream ss;
+                ss << "\n"
+                   << "Shader compiler error (" << kStageNames[i] << "): " << results[i].ErrorMsg << "\n";
+                GREX_LOG_ERROR(ss.str().c_str());
+                return EXIT_FAILURE;
+            }
+            GREX_LOG_INFO("Compiled " << kStageNames[i] << " in " << results[i].CompileTime << "ms");
         }
+
+        spirvRGEN = std::move(results[0].SPIRV);
+        spirvMISS = std::move(results[1].SPIRV);
+        spirvCHIT = std::move(results[2].SPIRV);
     }
 
     // *************************************************************************
@@ -164,10 +164,13 @@ vec2 gems_intersections(vec3 orig, vec3 dir, vec3 center, float radius)
 
 void main()
 {   
-	vec3 orig = gl_WorldRayOriginEXT;
-	vec3 dir = gl_WorldRayDirectionEXT;
+    // Object space, so the cluster instances intersect their own copy.
+    // t is the same in both spaces since the direction isn't renormalized.
+	vec3 orig = gl_ObjectRayOriginEXT;
+	vec3 dir = gl_ObjectRayDirectionEXT;
 
-    Sphere sphere = sphereBuffer.spheres[gl_PrimitiveID];
+    // Each BLAS's spheres start at its instance's custom index
+    Sphere sphere = sphereBuffer.spheres[gl_InstanceCustomIndexEXT + gl_PrimitiveID];
 
 	vec3 aabb_min = vec3(sphere.minX, sphere.minY, sphere.minZ);
 	vec3 aabb_max = vec3(sphere.maxX, sphere.maxY, sphere.maxZ);
@@ -178,13 +181,16 @@ void main()
     // Might be some wonky behavior if inside sphere
 	vec2 t = gems_intersections(orig, dir, center, radius);
 
+    // Instances are rotated and uniformly scaled, so normals transform like positions
+    mat3 objectToWorld = mat3(gl_ObjectToWorldEXT);
+
     if (t.x > 0) {
-	    hitNormal = normalize((orig + t.x * dir) - center);
+	    hitNormal = normalize(objectToWorld * ((orig + t.x * dir) - center));
 	    reportIntersectionEXT(t.x, 0);
     }
     
     if (t.y > 0) {
-	    hitNormal = normalize((orig + t.y * dir) - center);
+	    hitNormal = normalize(objectToWorld * ((orig + t.y * dir) - center));
 	    reportIntersectionEXT(t.y, 0);
     }
 }
@@ -198,7 +204,17 @@ static uint32_t gWindowHeight       = 720;
 static bool     gEnableDebug        = true;
 static uint32_t gUniformmBufferSize = 256;
 
-void CreateSphereBuffer(VulkanRenderer* pRenderer, uint32_t* pNumSpheres, VulkanBuffer* pBuffer);
+// 7 levels is 5.4M spheres, instanced as 90 spheres plus 729 copies of a
+// 7381 sphere cluster
+static int gSphereFlakeLevels  = 7;
+static int gSphereFlakeCluster = 4;
+
+void CreateSphereBuffer(
+    VulkanRenderer*           pRenderer,
+    uint32_t*                 pNumSpheres,
+    uint32_t*                 pNumClusterSpheres,
+    std::vector<glm::mat3x4>* pClusterTransforms,
+    VulkanBuffer*             pBuffer);
 void CreateDescriptorSetLayout(VulkanRenderer* pRenderer, VkDescriptorSetLayout* pLayout);
 void CreatePipelineLayout(VulkanRenderer* pRenderer, VkDescriptorSetLayout descriptorSetLayout, VkPipelineLayout* pLayout);
 void CreateShaderModules(
@@ -229,11 +245,19 @@ void CreateShaderBindingTables(
     VulkanBuffer*                                    pHitGroupSBT);
 void CreateBLAS(
     VulkanRenderer*             pRenderer,
+    uint32_t                    firstSphere,
     uint32_t                    numSpheres,
     const VulkanBuffer*         pSphereBuffer,
     VulkanBuffer*               pBLASBuffer,
     VkAccelerationStructureKHR* pBLAS);
-void CreateTLAS(VulkanRenderer* pRenderer, VkAccelerationStructureKHR blas, VulkanBuffer* pTLASBuffer, VkAccelerationStructureKHR* pTLAS);
+void CreateTLAS(
+    VulkanRenderer*                 pRenderer,
+    VkAccelerationStructureKHR      blas,
+    VkAccelerationStructureKHR      clusterBLAS,
+    uint32_t                        firstClusterSphere,
+    const std::vector<glm::mat3x4>& clusterTransforms,
+    VulkanBuffer*                   pTLASBuffer,
+    VkAccelerationStructureKHR*     pTLAS);
 void CreateUniformBuffer(VulkanRenderer* pRenderer, VulkanBuffer* pBuffer);
 void CreateDescriptorBuffer(
     VulkanRenderer*       pRenderer,
@@ -309,10 +333,16 @@ int main(int argc, char** argv)
 
     // *************************************************************************
     // Sphere buffer
+    //
+    // The top levels of the sphereflake followed by the cluster that
+    // instances the rest.
+    //
     // *************************************************************************
-    uint32_t     numSpheres   = 0;
-    VulkanBuffer sphereBuffer = {};
-    CreateSphereBuffer(renderer.get(), &numSpheres, &sphereBuffer);
+    uint32_t                 numSpheres        = 0;
+    uint32_t                 numClusterSpheres = 0;
+    std::vector<glm::mat3x4> clusterTransforms = {};
+    VulkanBuffer             sphereBuffer      = {};
+    CreateSphereBuffer(renderer.get(), &numSpheres, &numClusterSpheres, &clusterTransforms, &sphereBuffer);
 
     // *************************************************************************
     // Descriptor Set Layout
@@ -398,18 +428,22 @@ int main(int argc, char** argv)
         &hitgSBT);
 
     // *************************************************************************
-    // Bottom level acceleration structure
+    // Bottom level acceleration structures
     // *************************************************************************
     VulkanBuffer               blasBuffer = {};
     VkAccelerationStructureKHR blas       = VK_NULL_HANDLE;
-    CreateBLAS(renderer.get(), numSpheres, &sphereBuffer, &blasBuffer, &blas);
+    CreateBLAS(renderer.get(), 0, numSpheres, &sphereBuffer, &blasBuffer, &blas);
+
+    VulkanBuffer               clusterBLASBuffer = {};
+    VkAccelerationStructureKHR clusterBLAS       = VK_NULL_HANDLE;
+    CreateBLAS(renderer.get(), numSpheres, numClusterSpheres, &sphereBuffer, &clusterBLASBuffer, &clusterBLAS);
 
     // *************************************************************************
     // Top level acceleration structure
     // *************************************************************************
     VulkanBuffer               tlasBuffer = {};
     VkAccelerationStructureKHR tlas       = VK_NULL_HANDLE;
-    CreateTLAS(renderer.get(), blas, &tlasBuffer, &tlas);
+    CreateTLAS(renderer.get(), blas, clusterBLAS, numSpheres, clusterTransforms, &tlasBuffer, &tlas);
 
     // *************************************************************************
     // Uniform buffer
@@ -666,7 +700,12 @@ int main(int argc, char** argv)
     return 0;
 }
 
-void CreateSphereBuffer(VulkanRenderer* pRenderer, uint32_t* pNumSpheres, VulkanBuffer* pBuffer)
+void CreateSphereBuffer(
+    VulkanRenderer*           pRenderer,
+    uint32_t*                 pNumSpheres,
+    uint32_t*                 pNumClusterSpheres,
+    std::vector<glm::mat3x4>* pClusterTransforms,
+    VulkanBuffer*             pBuffer)
 {
     std::vector<SphereFlake> spheres;
 
@@ -684,10 +723,28 @@ void CreateSphereBuffer(VulkanRenderer* pRenderer, uint32_t* pNumSpheres, Vulkan
     sphere.aabbMax = (radius * vec3(1, 1, 1)) + vec3(0, radius, 0);
     spheres.push_back(sphere);
 
-    GenerateSphereFlake(0, 4, radius / 3.0f, radius, vec3(0, radius, 0), vec3(0, 1, 0), spheres);
-
+    SphereFlakeInstances instances = {};
+    GenerateSphereFlakeInstanced(
+        gSphereFlakeLevels,
+        gSphereFlakeCluster,
+        radius / 3.0f,
+        radius,
+        vec3(0, radius, 0),
+        vec3(0, 1, 0),
+        &instances);
+
+    spheres.insert(spheres.end(), instances.spheres.begin(), instances.spheres.end());
     *pNumSpheres = CountU32(spheres);
 
+    spheres.insert(spheres.end(), instances.cluster.begin(), instances.cluster.end());
+    *pNumClusterSpheres = CountU32(instances.cluster);
+    *pClusterTransforms = std::move(instances.transforms);
+
+    std::stringstream ss;
+    ss << "Sphereflake: " << GetSphereFlakeCount(gSphereFlakeLevels) << " spheres as " << *pNumSpheres
+       << " spheres and " << pClusterTransforms->size() << " instances of a " << *pNumClusterSpheres << " sphere cluster";
+    GREX_LOG_INFO(ss.str().c_str());
+
     VkBufferUsageFlags usageFlags =
         VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
         VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT |
@@ -1027,11 +1084,14 @@ void CreateShaderBindingTables(
 
 void CreateBLAS(
     VulkanRenderer*             pRenderer,
+    uint32_t                    firstSphere,
     uint32_t                    numSpheres,
     const VulkanBuffer*         pSphereBuffer,
     VulkanBuffer*               pBLASBuffer,
     VkAccelerationStructureKHR* pBLAS)
 {
+    const VkDeviceAddress spheresAddress = GetDeviceAddress(pRenderer, pSphereBuffer) + firstSphere * sizeof(SphereFlake);
+
     // Get acceleration structure build size
     VkAccelerationStructureBuildSizesInfoKHR buildSizesInfo = {VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_BUILD_SIZES_INFO_KHR};
     {
@@ -1040,7 +1100,7 @@ void CreateBLAS(
         geometry.flags                              = VK_GEOMETRY_OPAQUE_BIT_KHR;
         geometry.geometryType                       = VK_GEOMETRY_TYPE_AABBS_KHR;
         geometry.geometry.aabbs.sType               = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_AABBS_DATA_KHR;
-        geometry.geometry.aabbs.data.deviceAddress  = GetDeviceAddress(pRenderer, pSphereBuffer);
+        geometry.geometry.aabbs.data.deviceAddress  = spheresAddress;
         geometry.geometry.aabbs.stride              = sizeof(SphereFlake);
 
         // Build geometry info
@@ -1121,7 +1181,7 @@ void CreateBLAS(
         geometry.flags                              = VK_GEOMETRY_OPAQUE_BIT_KHR;
         geometry.geometryType                       = VK_GEOMETRY_TYPE_AABBS_KHR;
         geometry.geometry.aabbs.sType               = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_AABBS_DATA_KHR;
-        geometry.geometry.aabbs.data.deviceAddress  = GetDeviceAddress(pRenderer, pSphereBuffer);
+        geometry.geometry.aabbs.data.deviceAddress  = spheresAddress;
         geometry.geometry.aabbs.stride              = sizeof(SphereFlake);
 
         // Build geometry info
@@ -1163,7 +1223,14 @@ void CreateBLAS(
     DestroyBuffer(pRenderer, &scratchBuffer);
 }
 
-void CreateTLAS(VulkanRenderer* pRenderer, VkAccelerationStructureKHR blas, VulkanBuffer* pTLASBuffer, VkAccelerationStructureKHR* pTLAS)
+void CreateTLAS(
+    VulkanRenderer*                 pRenderer,
+    VkAccelerationStructureKHR      blas,
+    VkAccelerationStructureKHR      clusterBLAS,
+    uint32_t                        firstClusterSphere,
+    const std::vector<glm::mat3x4>& clusterTransforms,
+    VulkanBuffer*                   pTLASBuffer,
+    VkAccelerationStructureKHR*     pTLAS)
 {
     // clang-format off
 	VkTransformMatrixKHR transformMatrix = {
@@ -1173,13 +1240,38 @@ void CreateTLAS(VulkanRenderer* pRenderer, VkAccelerationStructureKHR blas, Vulk
     };
     // clang-format on
 
-    VkAccelerationStructureInstanceKHR instance     = {};
-    instance.transform                              = transformMatrix;
-    instance.instanceCustomIndex                    = 0;
-    instance.mask                                   = 0xFF;
-    instance.instanceShaderBindingTableRecordOffset = 0;
-    instance.flags                                  = VK_GEOMETRY_INSTANCE_TRIANGLE_FACING_CULL_DISABLE_BIT_KHR;
-    instance.accelerationStructureReference         = GetDeviceAddress(pRenderer, blas);
+    //
+    // The custom index is where the BLAS's spheres start in the sphere
+    // buffer, the intersection shader adds it to the primitive index.
+    //
+    std::vector<VkAccelerationStructureInstanceKHR> instances;
+    {
+        VkAccelerationStructureInstanceKHR instance     = {};
+        instance.transform                              = transformMatrix;
+        instance.instanceCustomIndex                    = 0;
+        instance.mask                                   = 0xFF;
+        instance.instanceShaderBindingTableRecordOffset = 0;
+        instance.flags                                  = VK_GEOMETRY_INSTANCE_TRIANGLE_FACING_CULL_DISABLE_BIT_KHR;
+        instance.accelerationStructureReference         = GetDeviceAddress(pRenderer, blas);
+
+        instances.push_back(instance);
+    }
+
+    const VkDeviceAddress clusterReference = GetDeviceAddress(pRenderer, clusterBLAS);
+    for (const glm::mat3x4& clusterTransform : clusterTransforms)
+    {
+        VkAccelerationStructureInstanceKHR instance     = {};
+        instance.instanceCustomIndex                    = firstClusterSphere;
+        instance.mask                                   = 0xFF;
+        instance.instanceShaderBindingTableRecordOffset = 0;
+        instance.flags                                  = VK_GEOMETRY_INSTANCE_TRIANGLE_FACING_CULL_DISABLE_BIT_KHR;
+        instance.accelerationStructureReference         = clusterReference;
+
+        // mat3x4 holds the rows, same layout as VkTransformMatrixKHR
+        memcpy(&instance.transform, &clusterTransform, sizeof(instance.transform));
+
+        instances.push_back(instance);
+    }
 
     // Instance buffer
     //
@@ -1190,12 +1282,12 @@ void CreateTLAS(VulkanRenderer* pRenderer, VkAccelerationStructureKHR blas, Vulk
         VkBufferUsageFlags usageFlags = VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT | VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR;
 
         CHECK_CALL(CreateBuffer(
-            pRenderer,         // pRenderer
-            sizeof(instance),  // srcSize
-            &instance,         // pSrcData
-            usageFlags,        // usageFlags
-            16,                // minAlignment
-            &instanceBuffer)); // pBuffer
+            pRenderer,              // pRenderer
+            SizeInBytes(instances), // srcSize
+            DataPtr(instances),     // pSrcData
+            usageFlags,             // usageFlags
+            16,                     // minAlignment
+            &instanceBuffer));      // pBuffer
     }
 
     // Get acceleration structure build size
@@ -1218,7 +1310,7 @@ void CreateTLAS(VulkanRenderer* pRenderer, VkAccelerationStructureKHR blas, Vulk
         buildGeometryInfo.geometryCount = 1;
         buildGeometryInfo.pGeometries   = &geometry;
 
-        const uint32_t maxPrimitiveCount = 1;
+        const uint32_t maxPrimitiveCount = CountU32(instances);
         fn_vkGetAccelerationStructureBuildSizesKHR(
             pRenderer->Device,
             VK_ACCELERATION_STRUCTURE_BUILD_TYPE_DEVICE_KHR,
@@ -1298,7 +1390,7 @@ void CreateTLAS(VulkanRenderer* pRenderer, VkAccelerationStructureKHR blas, Vulk
 
         // Build range info
         VkAccelerationStructureBuildRangeInfoKHR buildRangeInfo = {};
-        buildRangeInfo.primitiveCount                           = 1;
+        buildRangeInfo.primitiveCount                           = CountU32(instances);
 
         CommandObjects cmdBuf = {};
         CHECK_CALL(CreateCommandBuffer(pRenderer, VK_COMMAND_POOL_CREATE_TRANSIENT_BIT, &cmdBuf));
@@ -432,6 +432,9 @@ int main(int argc, char** argv)
 
     // *************************************************************************
     // Scene params constant buffer
+    //
+    // Only fills b5 in the descriptor template, every frame points b5 at
+    // its own copy in the frame context's constant ring.
     // *************************************************************************
     VulkanBuffer sceneParamsBuffer = {};
     CHECK_CALL(CreateBuffer(
@@ -620,25 +623,30 @@ int main(int argc, char** argv)
     }
 
     // *************************************************************************
-    // Command buffer
-    // *************************************************************************
-    CommandObjects cmdBuf = {};
-    CHECK_CALL(CreateCommandBuffer(renderer.get(), 0, &cmdBuf));
-
-    // *************************************************************************
-    // Persistent map scene parameters
+    // Ray trace descriptor template
+    //
+    // The output texture (u1) and the scene params (b5) change every frame.
+    // Each frame copies these descriptors into the frame context's
+    // descriptor ring and rewrites those two.
     // *************************************************************************
-    SceneParameters* pSceneParams = nullptr;
-    CHECK_CALL(vmaMapMemory(renderer->Allocator, sceneParamsBuffer.Allocation, reinterpret_cast<void**>(&pSceneParams)));
+    std::vector<char> rayTraceDescriptorTemplate(static_cast<size_t>(rayTraceDescriptorBuffer.Size));
+    {
+        void* pData = nullptr;
+        CHECK_CALL(vmaMapMemory(renderer->Allocator, rayTraceDescriptorBuffer.Allocation, &pData));
+        memcpy(rayTraceDescriptorTemplate.data(), pData, rayTraceDescriptorTemplate.size());
+        vmaUnmapMemory(renderer->Allocator, rayTraceDescriptorBuffer.Allocation);
+    }
 
     // *************************************************************************
-    // Persistent map ray trace descriptor buffer
+    // Frame context
     // *************************************************************************
-    char* pRayTraceDescriptorBuffeStartAddress = nullptr;
-    CHECK_CALL(vmaMapMemory(
-        renderer->Allocator,
-        rayTraceDescriptorBuffer.Allocation,
-        reinterpret_cast<void**>(&pRayTraceDescriptorBuffeStartAddress)));
+    VulkanFrameContext frameCtx = {};
+    CHECK_CALL(CreateFrameContext(
+        renderer.get(),
+        GREX_DEFAULT_FRAMES_IN_FLIGHT,
+        GREX_DEFAULT_FRAMES_IN_FLIGHT * Align<VkDeviceSize>(sizeof(SceneParameters), 256),
+        GREX_DEFAULT_FRAMES_IN_FLIGHT * Align<VkDeviceSize>(rayTraceDescriptorTemplate.size(), 256),
+        &frameCtx));
 
     // *************************************************************************
     // Misc vars
@@ -700,12 +708,6 @@ int main(int argc, char** argv)
         mat4 viewMat             = glm::lookAt(eyePosition, vec3(0, 3, 0), vec3(0, 1, 0));
         mat4 projMat             = glm::perspective(glm::radians(60.0f), gWindowWidth / static_cast<float>(gWindowHeight), 0.1f, 10000.0f);
 
-        // Set constant buffer values
-        pSceneParams->ViewInverseMatrix       = glm::inverse(viewMat);
-        pSceneParams->ProjectionInverseMatrix = glm::inverse(projMat);
-        pSceneParams->EyePosition             = eyePosition;
-        pSceneParams->MaxSamples              = gCurrentMaxSamples;
-
         // ---------------------------------------------------------------------
         // Acquire swapchain image index
         // ---------------------------------------------------------------------
@@ -716,6 +718,35 @@ int main(int argc, char** argv)
             break;
         }
 
+        // Waits for the GPU to finish the frame that last used this slot
+        VulkanFrame* pFrame = nullptr;
+        CHECK_CALL(BeginFrame(&frameCtx, &pFrame));
+
+        CommandObjects& cmdBuf = pFrame->CmdBuf;
+
+        // Set constant buffer values
+        VulkanRingAllocation sceneParamsAlloc = {};
+        if (!AllocateFrameConstants(&frameCtx, sizeof(SceneParameters), &sceneParamsAlloc))
+        {
+            assert(false && "AllocateFrameConstants failed");
+            break;
+        }
+
+        SceneParameters* pSceneParams         = static_cast<SceneParameters*>(sceneParamsAlloc.pData);
+        pSceneParams->ViewInverseMatrix       = glm::inverse(viewMat);
+        pSceneParams->ProjectionInverseMatrix = glm::inverse(projMat);
+        pSceneParams->EyePosition             = eyePosition;
+        pSceneParams->MaxSamples              = gCurrentMaxSamples;
+
+        VulkanRingAllocation rayTraceDescriptorAlloc = {};
+        if (!AllocateFrameDescriptors(&frameCtx, rayTraceDescriptorTemplate.size(), &rayTraceDescriptorAlloc))
+        {
+            assert(false && "AllocateFrameDescriptors failed");
+            break;
+        }
+
+        memcpy(rayTraceDescriptorAlloc.pData, rayTraceDescriptorTemplate.data(), rayTraceDescriptorTemplate.size());
+
         // Update output texture (u1)
         //
         // Most Vulkan implementations support STORAGE_IMAGE so we can
@@ -723,7 +754,7 @@ int main(int argc, char** argv)
         //
         WriteDescriptor(
             renderer.get(),
-            pRayTraceDescriptorBuffeStartAddress,
+            rayTraceDescriptorAlloc.pData,
             rayTracePipelineLayout.DescriptorSetLayout,
             1, // binding
             0, // arrayElement
@@ -731,12 +762,16 @@ int main(int argc, char** argv)
             swapchainImageViews[swapchainImageIndex],
             VK_IMAGE_LAYOUT_GENERAL);
 
-        // ---------------------------------------------------------------------
-        // Build command buffer to trace rays
-        // ---------------------------------------------------------------------
-        VkCommandBufferBeginInfo vkbi = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO};
-        vkbi.flags                    = VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;
-        CHECK_CALL(vkBeginCommandBuffer(cmdBuf.CommandBuffer, &vkbi));
+        // Scene params (b5)
+        WriteDescriptor(
+            renderer.get(),
+            rayTraceDescriptorAlloc.pData,
+            rayTracePipelineLayout.DescriptorSetLayout,
+            5, // binding
+            0, // arrayElement
+            VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+            sceneParamsAlloc.Address,
+            sceneParamsAlloc.Size);
 
         // Reset ray gen samples
         if (gResetRayGenSamples)
@@ -770,6 +805,20 @@ int main(int argc, char** argv)
 
         // Trace rays
         {
+            // Frames aren't separated by a queue idle anymore, make the
+            // clear and the previous frame's accumulation visible
+            VkMemoryBarrier2 accumBarrier = {VK_STRUCTURE_TYPE_MEMORY_BARRIER_2};
+            accumBarrier.srcStageMask     = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_2_RAY_TRACING_SHADER_BIT_KHR;
+            accumBarrier.srcAccessMask    = VK_ACCESS_2_SHADER_WRITE_BIT;
+            accumBarrier.dstStageMask     = VK_PIPELINE_STAGE_2_RAY_TRACING_SHADER_BIT_KHR;
+            accumBarrier.dstAccessMask    = VK_ACCESS_2_SHADER_READ_BIT | VK_ACCESS_2_SHADER_WRITE_BIT;
+
+            VkDependencyInfo dependencyInfo   = {VK_STRUCTURE_TYPE_DEPENDENCY_INFO};
+            dependencyInfo.memoryBarrierCount = 1;
+            dependencyInfo.pMemoryBarriers    = &accumBarrier;
+
+            vkCmdPipelineBarrier2(cmdBuf.CommandBuffer, &dependencyInfo);
+
             CmdTransitionImageLayout(
                 cmdBuf.CommandBuffer,
                 swapchainImages[swapchainImageIndex],
@@ -782,13 +831,13 @@ int main(int argc, char** argv)
 
             VkDescriptorBufferBindingInfoEXT descriptorBufferBindingInfo = {VK_STRUCTURE_TYPE_DESCRIPTOR_BUFFER_BINDING_INFO_EXT};
             descriptorBufferBindingInfo.pNext                            = nullptr;
-            descriptorBufferBindingInfo.address                          = GetDeviceAddress(renderer.get(), &rayTraceDescriptorBuffer);
+            descriptorBufferBindingInfo.address                          = frameCtx.DescriptorRing.BaseAddress;
             descriptorBufferBindingInfo.usage                            = VK_BUFFER_USAGE_RESOURCE_DESCRIPTOR_BUFFER_BIT_EXT;
 
             fn_vkCmdBindDescriptorBuffersEXT(cmdBuf.CommandBuffer, 1, &descriptorBufferBindingInfo);
 
             uint32_t     bufferIndices           = 0;
-            VkDeviceSize descriptorBufferOffsets = 0;
+            VkDeviceSize descriptorBufferOffsets = rayTraceDescriptorAlloc.Offset;
             fn_vkCmdSetDescriptorBufferOffsetsEXT(
                 cmdBuf.CommandBuffer,
                 VK_PIPELINE_BIND_POINT_RAY_TRACING_KHR,
@@ -828,22 +877,8 @@ int main(int argc, char** argv)
                 gWindowWidth,
                 gWindowHeight,
                 1);
-
-            CHECK_CALL(vkEndCommandBuffer(cmdBuf.CommandBuffer));
-
-            // Execute command buffer
-            CHECK_CALL(ExecuteCommandBuffer(renderer.get(), &cmdBuf));
-
-            // Wait for the GPU to finish the work
-            if (!WaitForGpu(renderer.get()))
-            {
-                assert(false && "WaitForGpu failed");
-            }
         }
 
-        // Reset command buffer to render ImGui
-        CHECK_CALL(vkBeginCommandBuffer(cmdBuf.CommandBuffer, &vkbi));
-
         // ImGui
         {
             CmdTransitionImageLayout(
@@ -889,32 +924,28 @@ int main(int argc, char** argv)
                 VK_IMAGE_ASPECT_COLOR_BIT,
                 RESOURCE_STATE_RENDER_TARGET,
                 RESOURCE_STATE_PRESENT);
-
-            CHECK_CALL(vkEndCommandBuffer(cmdBuf.CommandBuffer));
-
-            // Execute command buffer
-            CHECK_CALL(ExecuteCommandBuffer(renderer.get(), &cmdBuf));
-
-            // Wait for the GPU to finish the work
-            if (!WaitForGpu(renderer.get()))
-            {
-                assert(false && "WaitForGpu failed");
-            }
         }
 
+        // Trace and ImGui go in one submission, the next frame records
+        // while the GPU works on this one
+        CHECK_CALL(EndFrame(&frameCtx, swapchainImageIndex));
+
         // Update sample count
         if (sampleCount < gMaxSamples)
         {
             ++sampleCount;
         }
 
-        if (!SwapchainPresent(renderer.get(), swapchainImageIndex))
+        if (!SwapchainPresent(renderer.get(), swapchainImageIndex, pFrame->RenderCompleteSemaphore))
         {
             assert(false && "SwapchainPresent failed");
             break;
         }
     }
 
+    WaitFrameContext(&frameCtx);
+    DestroyFrameContext(&frameCtx);
+
     return 0;
 }
 